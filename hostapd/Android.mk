@@ -85,6 +85,7 @@ OBJS += src/ap/utils.c
 OBJS += src/ap/authsrv.c
 OBJS += src/ap/ieee802_1x.c
 OBJS += src/ap/ap_config.c
+OBJS += src/ap/psk_derive.c
 OBJS += src/ap/eap_user_db.c
 OBJS += src/ap/ieee802_11_auth.c
 OBJS += src/ap/sta_info.c
@@ -189,6 +190,7 @@ L_CFLAGS += -DCONFIG_NO_CTRL_IFACE
 else
 OBJS += ctrl_iface.c
 OBJS += src/ap/ctrl_iface_ap.c
+OBJS += src/common/ctrl_cmd.c
 endif
 
 L_CFLAGS += -DCONFIG_CTRL_IFACE -DCONFIG_CTRL_IFACE_UNIX
@@ -245,6 +247,7 @@ endif
 ifdef CONFIG_SAE
 L_CFLAGS += -DCONFIG_SAE
 OBJS += src/common/sae.c
+OBJS += src/ap/sae_async.c
 NEED_ECC=y
 NEED_DH_GROUPS=y
 endif
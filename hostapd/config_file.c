@@ -746,6 +746,25 @@ static int hostapd_config_parse_cipher(int line, const char *value)
 }
 
 
+static int hostapd_config_parse_uint(int line, const char *name,
+				     const char *value, unsigned int max,
+				     unsigned int *val)
+{
+	char *end;
+	long int res;
+
+	res = strtol(value, &end, 10);
+	if (!*value || *end || res < 0 || res > (long int) max) {
+		wpa_printf(MSG_ERROR,
+			   "Line %d: invalid %s '%s' (expected 0..%u)",
+			   line, name, value, max);
+		return -1;
+	}
+	*val = res;
+	return 0;
+}
+
+
 static int hostapd_config_read_wep(struct hostapd_wep_keys *wep, int keyidx,
 				   char *val)
 {
@@ -2013,6 +2032,35 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 			wpa_printf(MSG_ERROR, "Line %d: unknown macaddr_acl %d",
 				   line, bss->macaddr_acl);
 		}
+	} else if (os_strcmp(buf, "radius_acl_timeout") == 0) {
+		int val = atoi(pos);
+		if (val <= 0) {
+			wpa_printf(MSG_ERROR, "Line %d: invalid radius_acl_timeout %d",
+				   line, val);
+			return 1;
+		}
+		bss->radius_acl_timeout = val;
+	} else if (os_strcmp(buf, "radius_acl_negative_timeout") == 0) {
+		int val = atoi(pos);
+		if (val <= 0) {
+			wpa_printf(MSG_ERROR, "Line %d: invalid radius_acl_negative_timeout %d",
+				   line, val);
+			return 1;
+		}
+		bss->radius_acl_negative_timeout = val;
+	} else if (os_strcmp(buf, "radius_acl_cache_size") == 0) {
+		char *endp;
+		long int val;
+
+		val = strtol(pos, &endp, 10);
+		if (!*pos || *endp || val < 0 ||
+		    val > RADIUS_ACL_CACHE_MAX_SIZE) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid radius_acl_cache_size '%s' (expected 0..%u)",
+				   line, pos, RADIUS_ACL_CACHE_MAX_SIZE);
+			return 1;
+		}
+		bss->radius_acl_cache_size = val;
 	} else if (os_strcmp(buf, "accept_mac_file") == 0) {
 		if (hostapd_config_read_maclist(pos, &bss->accept_mac,
 						&bss->num_accept_mac)) {
@@ -2305,8 +2353,32 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->radius->acct_server->shared_secret_len = len;
 	} else if (os_strcmp(buf, "radius_retry_primary_interval") == 0) {
 		bss->radius->retry_primary_interval = atoi(pos);
+	} else if (os_strcmp(buf, "radius_client_ports") == 0) {
+		int val = atoi(pos);
+		if (val <= 0 || val > 16) {
+			wpa_printf(MSG_ERROR, "Line %d: invalid radius_client_ports %d (expected 1..16)",
+				   line, val);
+			return 1;
+		}
+		bss->radius->client_ports = val;
+	} else if (os_strcmp(buf, "radius_max_pending") == 0) {
+		int val = atoi(pos);
+		if (val <= 0) {
+			wpa_printf(MSG_ERROR, "Line %d: invalid radius_max_pending %d",
+				   line, val);
+			return 1;
+		}
+		bss->radius->max_pending = val;
 	} else if (os_strcmp(buf, "radius_acct_interim_interval") == 0) {
 		bss->acct_interim_interval = atoi(pos);
+	} else if (os_strcmp(buf, "radius_acct_queue_limit") == 0) {
+		int val = atoi(pos);
+		if (val < 0) {
+			wpa_printf(MSG_ERROR, "Line %d: invalid radius_acct_queue_limit %d",
+				   line, val);
+			return 1;
+		}
+		bss->radius_acct_queue_limit = val;
 	} else if (os_strcmp(buf, "radius_request_cui") == 0) {
 		bss->radius_request_cui = atoi(pos);
 	} else if (os_strcmp(buf, "radius_auth_req_attr") == 0) {
@@ -2389,11 +2461,11 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		os_free(bss->ssid.wpa_passphrase);
 		bss->ssid.wpa_passphrase = os_strdup(pos);
 		if (bss->ssid.wpa_passphrase) {
-			hostapd_config_clear_wpa_psk(&bss->ssid.wpa_psk);
+			hostapd_config_clear_wpa_psk(&bss->ssid);
 			bss->ssid.wpa_passphrase_set = 1;
 		}
 	} else if (os_strcmp(buf, "wpa_psk") == 0) {
-		hostapd_config_clear_wpa_psk(&bss->ssid.wpa_psk);
+		hostapd_config_clear_wpa_psk(&bss->ssid);
 		bss->ssid.wpa_psk = os_zalloc(sizeof(struct hostapd_wpa_psk));
 		if (bss->ssid.wpa_psk == NULL)
 			return 1;
@@ -2401,7 +2473,7 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		    pos[PMK_LEN * 2] != '\0') {
 			wpa_printf(MSG_ERROR, "Line %d: Invalid PSK '%s'.",
 				   line, pos);
-			hostapd_config_clear_wpa_psk(&bss->ssid.wpa_psk);
+			hostapd_config_clear_wpa_psk(&bss->ssid);
 			return 1;
 		}
 		bss->ssid.wpa_psk->group = 1;
@@ -2505,6 +2577,16 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		os_free(bss->net_steeering_mode);
 		/* can be "off", "suggest", or "force" */
 		bss->net_steeering_mode = os_strdup(pos);
+	} else if (os_strcmp(buf, "net_steering_batch") == 0) {
+		bss->net_steering_batch = atoi(pos);
+	} else if (os_strcmp(buf, "net_steering_group_addr") == 0) {
+		if (hwaddr_aton(pos, bss->net_steering_group_addr) ||
+		    !(bss->net_steering_group_addr[0] & 0x01)) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid net_steering_group_addr '%s'",
+				   line, pos);
+			return 1;
+		}
 #endif /* CONFIG_NET_STEERING */
 #ifndef CONFIG_NO_CTRL_IFACE
 	} else if (os_strcmp(buf, "ctrl_interface") == 0) {
@@ -3415,6 +3497,26 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 	} else if (os_strcmp(buf, "no_auth_if_seen_on") == 0) {
 		os_free(bss->no_auth_if_seen_on);
 		bss->no_auth_if_seen_on = os_strdup(pos);
+	} else if (os_strcmp(buf, "probe_resp_rate") == 0) {
+		if (hostapd_config_parse_uint(line, buf, pos,
+					      PROBE_RESP_RATE_MAX,
+					      &bss->probe_resp_rate))
+			return 1;
+	} else if (os_strcmp(buf, "probe_resp_burst") == 0) {
+		if (hostapd_config_parse_uint(line, buf, pos,
+					      PROBE_RESP_RATE_MAX,
+					      &bss->probe_resp_burst))
+			return 1;
+	} else if (os_strcmp(buf, "probe_resp_dedup_window") == 0) {
+		if (hostapd_config_parse_uint(line, buf, pos,
+					      PROBE_RESP_DEDUP_WINDOW_MAX,
+					      &bss->probe_resp_dedup_window))
+			return 1;
+	} else if (os_strcmp(buf, "probe_resp_max_rate") == 0) {
+		if (hostapd_config_parse_uint(line, buf, pos,
+					      PROBE_RESP_RATE_MAX,
+					      &conf->probe_resp_max_rate))
+			return 1;
 	} else if (os_strcmp(buf, "disable_40mhz_scan") == 0) {
 		conf->disable_40mhz_scan = atoi(pos);
 	} else {
@@ -18,11 +18,18 @@
 #include <sys/un.h>
 #include <sys/stat.h>
 #include <stddef.h>
+#include <fcntl.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#endif /* __linux__ */
 
 #include "utils/common.h"
 #include "utils/eloop.h"
 #include "common/version.h"
 #include "common/ieee802_11_defs.h"
+#include "common/wpa_ctrl.h"
+#include "common/ctrl_cmd.h"
 #include "crypto/tls.h"
 #include "drivers/driver.h"
 #include "eapol_auth/eapol_auth_sm.h"
@@ -34,6 +41,8 @@
 #include "ap/ieee802_1x.h"
 #include "ap/wpa_auth.h"
 #include "ap/ieee802_11.h"
+#include "ap/ieee802_11_auth.h"
+#include "ap/accounting.h"
 #include "ap/sta_info.h"
 #include "ap/wps_hostapd.h"
 #include "ap/ctrl_iface_ap.h"
@@ -42,6 +51,8 @@
 #include "ap/wnm_ap.h"
 #include "ap/wpa_auth.h"
 #include "ap/beacon.h"
+#include "ap/net_steering.h"
+#include "ap/bin_event.h"
 #include "wps/wps_defs.h"
 #include "wps/wps.h"
 #include "fst/fst_ctrl_iface.h"
@@ -51,18 +62,350 @@
 
 #define HOSTAPD_CLI_DUP_VALUE_MAX_LEN 256
 
+/* Maximum number of events queued for a monitor; the oldest event is dropped
+ * when a monitor does not keep up. Must be a power of two. */
+#define CTRL_IFACE_MONITOR_QUEUE_LEN 256
+
+/* Retry interval (usec) for monitors whose socket receive queue is full */
+#define CTRL_IFACE_MONITOR_RETRY_USEC 10000
+
+/* Time (sec) an event may wait in the queue of a monitor before the monitor
+ * is detached */
+#define CTRL_IFACE_MONITOR_STALL_SEC 10
+
+/* Number of consecutive failed sends after which a monitor is detached */
+#define CTRL_IFACE_MONITOR_MAX_ERRORS 10
+
+/* Maximum number of EVENT_FILTER prefixes per monitor */
+#define CTRL_IFACE_MAX_EVENT_FILTERS 16
+
+/* Formatted event shared by the queues of all monitors it is sent to */
+struct ctrl_iface_event {
+	unsigned int refcount;
+	struct os_reltime queued;
+	size_t len;
+	/* followed by len octets of event data */
+};
+
 struct wpa_ctrl_dst {
 	struct wpa_ctrl_dst *next;
 	struct sockaddr_un addr;
 	socklen_t addrlen;
 	int debug_level;
 	int errors;
+	int binary_events;
+
+	/* Events waiting to be sent (ring buffer) */
+	struct ctrl_iface_event *queue[CTRL_IFACE_MONITOR_QUEUE_LEN];
+	unsigned int queue_head;
+	unsigned int queue_len;
+	int blocked; /* events were held back on the last attempt */
+
+	/* Event name prefixes from EVENT_FILTER; '-' prefix excludes */
+	char *event_filter[CTRL_IFACE_MAX_EVENT_FILTERS];
+	unsigned int num_event_filters;
+	int include_filters;
+
+	unsigned int sent;
+	unsigned int dropped;
+	unsigned int filtered;
 };
 
 
 static void hostapd_ctrl_iface_send(struct hostapd_data *hapd, int level,
 				    enum wpa_msg_type type,
 				    const char *buf, size_t len);
+static void hostapd_ctrl_iface_flush_events(void *eloop_ctx,
+					    void *timeout_ctx);
+static void hostapd_ctrl_iface_retry_events(void *eloop_ctx,
+					    void *timeout_ctx);
+static void hostapd_global_ctrl_iface_flush_events(void *eloop_ctx,
+						   void *timeout_ctx);
+static void hostapd_global_ctrl_iface_retry_events(void *eloop_ctx,
+						   void *timeout_ctx);
+
+
+static struct ctrl_iface_event * ctrl_iface_event_alloc(const char *prefix,
+							const void *buf,
+							size_t len)
+{
+	struct ctrl_iface_event *ev;
+	size_t plen = prefix ? os_strlen(prefix) : 0;
+
+	ev = os_malloc(sizeof(*ev) + plen + len);
+	if (ev == NULL)
+		return NULL;
+	ev->refcount = 0;
+	os_get_reltime(&ev->queued);
+	ev->len = plen + len;
+	if (plen)
+		os_memcpy(ev + 1, prefix, plen);
+	os_memcpy((u8 *) (ev + 1) + plen, buf, len);
+	return ev;
+}
+
+
+static void ctrl_iface_event_unref(struct ctrl_iface_event *ev)
+{
+	if (--ev->refcount == 0)
+		os_free(ev);
+}
+
+
+static void ctrl_dst_queue_pop(struct wpa_ctrl_dst *dst)
+{
+	ctrl_iface_event_unref(dst->queue[dst->queue_head]);
+	dst->queue_head = (dst->queue_head + 1) &
+		(CTRL_IFACE_MONITOR_QUEUE_LEN - 1);
+	dst->queue_len--;
+}
+
+
+static void ctrl_dst_queue_push(struct wpa_ctrl_dst *dst,
+				struct ctrl_iface_event *ev)
+{
+	if (dst->queue_len == CTRL_IFACE_MONITOR_QUEUE_LEN) {
+		ctrl_dst_queue_pop(dst);
+		dst->dropped++;
+	}
+	ev->refcount++;
+	dst->queue[(dst->queue_head + dst->queue_len) &
+		   (CTRL_IFACE_MONITOR_QUEUE_LEN - 1)] = ev;
+	dst->queue_len++;
+}
+
+
+static void ctrl_dst_clear_filter(struct wpa_ctrl_dst *dst)
+{
+	unsigned int i;
+
+	for (i = 0; i < dst->num_event_filters; i++)
+		os_free(dst->event_filter[i]);
+	dst->num_event_filters = 0;
+	dst->include_filters = 0;
+}
+
+
+static void ctrl_dst_free(struct wpa_ctrl_dst *dst)
+{
+	while (dst->queue_len)
+		ctrl_dst_queue_pop(dst);
+	ctrl_dst_clear_filter(dst);
+	os_free(dst);
+}
+
+
+/* Whether a text event passes the EVENT_FILTER of a monitor */
+static int ctrl_dst_event_allowed(struct wpa_ctrl_dst *dst, const char *buf,
+				  size_t len)
+{
+	unsigned int i;
+	const char *f;
+	size_t flen;
+	int include = !dst->include_filters;
+
+	for (i = 0; i < dst->num_event_filters; i++) {
+		f = dst->event_filter[i];
+		if (*f == '-') {
+			f++;
+			flen = os_strlen(f);
+			if (flen <= len && os_memcmp(buf, f, flen) == 0)
+				return 0;
+		} else if (!include) {
+			flen = os_strlen(f);
+			if (flen <= len && os_memcmp(buf, f, flen) == 0)
+				include = 1;
+		}
+	}
+
+	return include;
+}
+
+
+/*
+ * Events sitting unread in a monitor socket are charged to the send buffer of
+ * the control interface socket, so a monitor that does not read would
+ * eventually make command replies fail. Events are held back once half of the
+ * send buffer is in use, so that the rest remains available for replies.
+ */
+static int ctrl_iface_sock_congested(int sock)
+{
+#ifdef __linux__
+	socklen_t optlen;
+	int sndbuf, outq;
+
+	optlen = sizeof(sndbuf);
+	if (getsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, &optlen) < 0 ||
+	    ioctl(sock, SIOCOUTQ, &outq) < 0)
+		return 0;
+	return outq > sndbuf / 2;
+#else /* __linux__ */
+	return 0;
+#endif /* __linux__ */
+}
+
+
+/*
+ * Whether a monitor has fallen too far behind: its queue filled up while
+ * events were held back or its oldest event has waited for
+ * CTRL_IFACE_MONITOR_STALL_SEC. Only the queue of the monitor itself is
+ * looked at, so this costs nothing per event.
+ */
+static int ctrl_dst_stalled(struct wpa_ctrl_dst *dst)
+{
+	struct os_reltime now;
+
+	if (dst->queue_len == 0)
+		return 0;
+	if (dst->blocked && dst->queue_len == CTRL_IFACE_MONITOR_QUEUE_LEN)
+		return 1;
+	os_get_reltime(&now);
+	return os_reltime_expired(&now, &dst->queue[dst->queue_head]->queued,
+				  CTRL_IFACE_MONITOR_STALL_SEC);
+}
+
+
+/*
+ * Send queued events to a monitor without blocking. Returns 0 when the queue
+ * was emptied, 1 if the monitor cannot take more events for now and -1 if the
+ * monitor is to be detached due to send errors or not keeping up.
+ */
+static int ctrl_dst_drain(int sock, struct wpa_ctrl_dst *dst)
+{
+	struct ctrl_iface_event *ev;
+
+	if (ctrl_dst_stalled(dst)) {
+		wpa_printf(MSG_INFO,
+			   "CTRL_IFACE monitor %.*s is not keeping up with events (queued=%u)",
+			   (int) (dst->addrlen -
+				  offsetof(struct sockaddr_un, sun_path)),
+			   dst->addr.sun_path, dst->queue_len);
+		return -1;
+	}
+
+	dst->blocked = 0;
+	while (dst->queue_len) {
+		if (ctrl_iface_sock_congested(sock)) {
+			dst->blocked = 1;
+			return 1;
+		}
+		ev = dst->queue[dst->queue_head];
+		if (sendto(sock, ev + 1, ev->len, MSG_DONTWAIT,
+			   (struct sockaddr *) &dst->addr, dst->addrlen) < 0) {
+			int _errno = errno;
+
+			if (_errno == EAGAIN || _errno == EWOULDBLOCK ||
+			    _errno == ENOBUFS) {
+				dst->blocked = 1;
+				return 1;
+			}
+			wpa_printf(MSG_INFO, "CTRL_IFACE monitor: %d - %s",
+				   _errno, strerror(_errno));
+			ctrl_dst_queue_pop(dst);
+			dst->dropped++;
+			dst->errors++;
+			if (dst->errors >= CTRL_IFACE_MONITOR_MAX_ERRORS ||
+			    _errno == ENOENT || _errno == ECONNREFUSED)
+				return -1;
+			continue;
+		}
+		ctrl_dst_queue_pop(dst);
+		dst->sent++;
+		dst->errors = 0;
+	}
+
+	return 0;
+}
+
+
+static struct wpa_ctrl_dst * ctrl_dst_get(struct wpa_ctrl_dst *dst,
+					  struct sockaddr_un *from,
+					  socklen_t fromlen)
+{
+	while (dst) {
+		if (fromlen == dst->addrlen &&
+		    os_memcmp(from->sun_path, dst->addr.sun_path,
+			      fromlen - offsetof(struct sockaddr_un, sun_path))
+		    == 0)
+			return dst;
+		dst = dst->next;
+	}
+	return NULL;
+}
+
+
+static int ctrl_dst_event_filter(struct wpa_ctrl_dst *dst, char *cmd)
+{
+	char *token, *context = NULL;
+
+	ctrl_dst_clear_filter(dst);
+	while ((token = str_token(cmd, " ", &context))) {
+		if (dst->num_event_filters == CTRL_IFACE_MAX_EVENT_FILTERS ||
+		    token[0] == '\0' || (token[0] == '-' && token[1] == '\0')) {
+			ctrl_dst_clear_filter(dst);
+			return -1;
+		}
+		dst->event_filter[dst->num_event_filters] = os_strdup(token);
+		if (dst->event_filter[dst->num_event_filters] == NULL) {
+			ctrl_dst_clear_filter(dst);
+			return -1;
+		}
+		dst->num_event_filters++;
+		if (token[0] != '-')
+			dst->include_filters = 1;
+	}
+
+	return 0;
+}
+
+
+static int ctrl_dst_list(struct wpa_ctrl_dst *dst, char *buf, size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	unsigned int i;
+	int ret;
+
+	for (; dst; dst = dst->next) {
+		ret = os_snprintf(pos, end - pos,
+				  "%.*s level=%d binary=%d queued=%u sent=%u dropped=%u filtered=%u errors=%d blocked=%d filter=",
+				  (int) (dst->addrlen -
+					 offsetof(struct sockaddr_un, sun_path)),
+				  dst->addr.sun_path, dst->debug_level, dst->binary_events,
+				  dst->queue_len, dst->sent, dst->dropped,
+				  dst->filtered, dst->errors, dst->blocked);
+		if (os_snprintf_error(end - pos, ret))
+			return pos - buf;
+		pos += ret;
+		for (i = 0; i < dst->num_event_filters; i++) {
+			ret = os_snprintf(pos, end - pos, "%s%s",
+					  i ? "," : "", dst->event_filter[i]);
+			if (os_snprintf_error(end - pos, ret))
+				return pos - buf;
+			pos += ret;
+		}
+		ret = os_snprintf(pos, end - pos, "\n");
+		if (os_snprintf_error(end - pos, ret))
+			return pos - buf;
+		pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
+static void hostapd_ctrl_iface_count_monitors(struct hostapd_data *hapd)
+{
+	struct wpa_ctrl_dst *dst;
+
+	hapd->ctrl_bin_monitors = 0;
+	hapd->ctrl_text_monitors = 0;
+	for (dst = hapd->ctrl_dst; dst; dst = dst->next) {
+		if (dst->binary_events)
+			hapd->ctrl_bin_monitors++;
+		else
+			hapd->ctrl_text_monitors++;
+	}
+}
 
 
 static int hostapd_ctrl_iface_attach(struct hostapd_data *hapd,
@@ -96,6 +439,7 @@ static int hostapd_ctrl_iface_attach(struct hostapd_data *hapd,
 	dst->debug_level = MSG_INFO;
 	dst->next = hapd->ctrl_dst;
 	hapd->ctrl_dst = dst;
+	hostapd_ctrl_iface_count_monitors(hapd);
 	wpa_hexdump(MSG_DEBUG, "CTRL_IFACE monitor attached",
 		    (u8 *) from->sun_path,
 		    fromlen - offsetof(struct sockaddr_un, sun_path));
@@ -123,7 +467,8 @@ static int hostapd_ctrl_iface_detach(struct hostapd_data *hapd,
 				hapd->ctrl_dst = dst->next;
 			else
 				prev->next = dst->next;
-			os_free(dst);
+			ctrl_dst_free(dst);
+			hostapd_ctrl_iface_count_monitors(hapd);
 			return 0;
 		}
 		prev = dst;
@@ -161,6 +506,32 @@ static int hostapd_ctrl_iface_level(struct hostapd_data *hapd,
 }
 
 
+static int hostapd_ctrl_iface_binary_events(struct hostapd_data *hapd,
+					    struct sockaddr_un *from,
+					    socklen_t fromlen,
+					    char *val)
+{
+	struct wpa_ctrl_dst *dst;
+
+	wpa_printf(MSG_DEBUG, "CTRL_IFACE BINARY_EVENTS %s", val);
+
+	dst = hapd->ctrl_dst;
+	while (dst) {
+		if (fromlen == dst->addrlen &&
+		    os_memcmp(from->sun_path, dst->addr.sun_path,
+			      fromlen - offsetof(struct sockaddr_un, sun_path))
+		    == 0) {
+			dst->binary_events = atoi(val) != 0;
+			hostapd_ctrl_iface_count_monitors(hapd);
+			return 0;
+		}
+		dst = dst->next;
+	}
+
+	return -1;
+}
+
+
 static int hostapd_ctrl_iface_new_sta(struct hostapd_data *hapd,
 				      const char *txtaddr)
 {
@@ -1403,6 +1774,9 @@ static int hostapd_ctrl_iface_set(struct hostapd_data *hapd, char *cmd)
 		ret = hostapd_set_iface(hapd->iconf, hapd->conf, cmd, value);
 		if (ret)
 			return ret;
+#ifdef NEED_AP_MLME
+		hostapd_probe_resp_tmpl_flush(hapd);
+#endif /* NEED_AP_MLME */
 
 		if (os_strcasecmp(cmd, "deny_mac_file") == 0) {
 			for (sta = hapd->sta_list; sta; sta = sta->next) {
@@ -2083,6 +2457,67 @@ static int hostapd_ctrl_iface_log_level(struct hostapd_data *hapd, char *cmd,
 }
 
 
+static int hostapd_ctrl_iface_eloop_stats(char *buf, size_t buflen)
+{
+	static const char *types[] = { "read", "write", "exception" };
+	struct eloop_stats stats;
+	struct eloop_sock_stats socks[32];
+	char *pos, *end;
+	int ret, i, j, num;
+
+	pos = buf;
+	end = buf + buflen;
+
+	eloop_get_stats(&stats);
+	ret = os_snprintf(pos, end - pos,
+			  "timeouts=%u\n"
+			  "timeout_pool=%u\n"
+			  "timeout_pool_free=%u\n"
+			  "timeout_allocs=%lu\n"
+			  "timeout_pool_grows=%lu\n"
+			  "socks=%u\n"
+			  "sock_slots=%u\n"
+			  "sock_table_grows=%lu\n"
+			  "wakeups=%lu\n"
+			  "timer_wakeups=%lu\n",
+			  stats.timeouts, stats.timeout_pool,
+			  stats.timeout_pool_free, stats.timeout_allocs,
+			  stats.timeout_pool_grows, stats.socks,
+			  stats.sock_slots, stats.sock_table_grows,
+			  stats.wakeups, stats.timer_wakeups);
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	num = eloop_get_sock_stats(socks, ARRAY_SIZE(socks));
+	for (i = 0; i < num; i++) {
+		ret = os_snprintf(pos, end - pos,
+				  "sock[%d]=%s budget=%u dispatched=%lu "
+				  "max_latency_us=%u latency=",
+				  socks[i].sock,
+				  types[socks[i].type % ARRAY_SIZE(types)],
+				  socks[i].budget, socks[i].dispatched,
+				  socks[i].max_latency_us);
+		if (os_snprintf_error(end - pos, ret))
+			return pos - buf;
+		pos += ret;
+		for (j = 0; j < ELOOP_LATENCY_BUCKETS; j++) {
+			ret = os_snprintf(pos, end - pos, "%s%lu",
+					  j ? "," : "", socks[i].latency[j]);
+			if (os_snprintf_error(end - pos, ret))
+				return pos - buf;
+			pos += ret;
+		}
+		ret = os_snprintf(pos, end - pos, "\n");
+		if (os_snprintf_error(end - pos, ret))
+			return pos - buf;
+		pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
 #ifdef NEED_AP_MLME
 static int hostapd_ctrl_iface_track_sta_list(struct hostapd_data *hapd,
 					     char *buf, size_t buflen)
@@ -2116,264 +2551,1025 @@ static int hostapd_ctrl_iface_track_sta_list(struct hostapd_data *hapd,
 #endif /* NEED_AP_MLME */
 
 
-static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
-					      char *buf, char *reply,
-					      int reply_size,
-					      struct sockaddr_un *from,
-					      socklen_t fromlen)
+static int hostapd_ctrl_cmd_ping(struct hostapd_data *hapd, char *params,
+				 char *reply, int reply_size,
+				 struct sockaddr_un *from, socklen_t fromlen)
+{
+	os_memcpy(reply, "PONG\n", 5);
+	return 5;
+}
+
+
+static int hostapd_ctrl_cmd_relog(struct hostapd_data *hapd, char *params,
+				  char *reply, int reply_size,
+				  struct sockaddr_un *from, socklen_t fromlen)
+{
+	return wpa_debug_reopen_file();
+}
+
+
+static int hostapd_ctrl_cmd_status(struct hostapd_data *hapd, char *params,
+				   char *reply, int reply_size,
+				   struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_status(hapd, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_status_driver(struct hostapd_data *hapd,
+					  char *params, char *reply,
+					  int reply_size,
+					  struct sockaddr_un *from,
+					  socklen_t fromlen)
+{
+	return hostapd_drv_status(hapd, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_eloop_stats(struct hostapd_data *hapd,
+					char *params, char *reply,
+					int reply_size,
+					struct sockaddr_un *from,
+					socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_eloop_stats(reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_mib(struct hostapd_data *hapd, char *params,
+				char *reply, int reply_size,
+				struct sockaddr_un *from, socklen_t fromlen)
 {
 	int reply_len, res;
 
-	os_memcpy(reply, "OK\n", 3);
-	reply_len = 3;
+	if (params)
+		return hostapd_ctrl_iface_mib(hapd, reply, reply_size, params);
 
-	if (os_strcmp(buf, "PING") == 0) {
-		os_memcpy(reply, "PONG\n", 5);
-		reply_len = 5;
-	} else if (os_strncmp(buf, "RELOG", 5) == 0) {
-		if (wpa_debug_reopen_file() < 0)
-			reply_len = -1;
-	} else if (os_strcmp(buf, "STATUS") == 0) {
-		reply_len = hostapd_ctrl_iface_status(hapd, reply,
-						      reply_size);
-	} else if (os_strcmp(buf, "STATUS-DRIVER") == 0) {
-		reply_len = hostapd_drv_status(hapd, reply, reply_size);
-	} else if (os_strcmp(buf, "MIB") == 0) {
-		reply_len = ieee802_11_get_mib(hapd, reply, reply_size);
-		if (reply_len >= 0) {
-			res = wpa_get_mib(hapd->wpa_auth, reply + reply_len,
-					  reply_size - reply_len);
-			if (res < 0)
-				reply_len = -1;
-			else
-				reply_len += res;
-		}
-		if (reply_len >= 0) {
-			res = ieee802_1x_get_mib(hapd, reply + reply_len,
-						 reply_size - reply_len);
-			if (res < 0)
-				reply_len = -1;
-			else
-				reply_len += res;
-		}
-#ifndef CONFIG_NO_RADIUS
-		if (reply_len >= 0) {
-			res = radius_client_get_mib(hapd->radius,
-						    reply + reply_len,
-						    reply_size - reply_len);
-			if (res < 0)
-				reply_len = -1;
-			else
-				reply_len += res;
-		}
-#endif /* CONFIG_NO_RADIUS */
-	} else if (os_strncmp(buf, "MIB ", 4) == 0) {
-		reply_len = hostapd_ctrl_iface_mib(hapd, reply, reply_size,
-						   buf + 4);
-	} else if (os_strcmp(buf, "STA-FIRST") == 0) {
-		reply_len = hostapd_ctrl_iface_sta_first(hapd, reply,
-							 reply_size);
-	} else if (os_strncmp(buf, "STA ", 4) == 0) {
-		reply_len = hostapd_ctrl_iface_sta(hapd, buf + 4, reply,
-						   reply_size);
-	} else if (os_strncmp(buf, "STA-NEXT ", 9) == 0) {
-		reply_len = hostapd_ctrl_iface_sta_next(hapd, buf + 9, reply,
-							reply_size);
-	} else if (os_strcmp(buf, "ATTACH") == 0) {
-		if (hostapd_ctrl_iface_attach(hapd, from, fromlen))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "DETACH") == 0) {
-		if (hostapd_ctrl_iface_detach(hapd, from, fromlen))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "LEVEL ", 6) == 0) {
-		if (hostapd_ctrl_iface_level(hapd, from, fromlen,
-						    buf + 6))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "NEW_STA ", 8) == 0) {
-		if (hostapd_ctrl_iface_new_sta(hapd, buf + 8))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "DEAUTHENTICATE ", 15) == 0) {
-		if (hostapd_ctrl_iface_deauthenticate(hapd, buf + 15))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "DISASSOCIATE ", 13) == 0) {
-		if (hostapd_ctrl_iface_disassociate(hapd, buf + 13))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "STOP_AP") == 0) {
-		if (hostapd_ctrl_iface_stop_ap(hapd))
-			reply_len = -1;
-#ifdef CONFIG_IEEE80211W
-#ifdef NEED_AP_MLME
-	} else if (os_strncmp(buf, "SA_QUERY ", 9) == 0) {
-		if (hostapd_ctrl_iface_sa_query(hapd, buf + 9))
-			reply_len = -1;
-#endif /* NEED_AP_MLME */
-#endif /* CONFIG_IEEE80211W */
-#ifdef CONFIG_WPS
-	} else if (os_strncmp(buf, "WPS_PIN ", 8) == 0) {
-		if (hostapd_ctrl_iface_wps_pin(hapd, buf + 8))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "WPS_CHECK_PIN ", 14) == 0) {
-		reply_len = hostapd_ctrl_iface_wps_check_pin(
-			hapd, buf + 14, reply, reply_size);
-	} else if (os_strcmp(buf, "WPS_PBC") == 0) {
-		if (hostapd_wps_button_pushed(hapd, NULL))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "WPS_CANCEL") == 0) {
-		if (hostapd_wps_cancel(hapd))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "WPS_AP_PIN ", 11) == 0) {
-		reply_len = hostapd_ctrl_iface_wps_ap_pin(hapd, buf + 11,
-							  reply, reply_size);
-	} else if (os_strncmp(buf, "WPS_CONFIG ", 11) == 0) {
-		if (hostapd_ctrl_iface_wps_config(hapd, buf + 11) < 0)
+	reply_len = ieee802_11_get_mib(hapd, reply, reply_size);
+	if (reply_len >= 0) {
+		res = wpa_get_mib(hapd->wpa_auth, reply + reply_len,
+				  reply_size - reply_len);
+		if (res < 0)
 			reply_len = -1;
-	} else if (os_strncmp(buf, "WPS_GET_STATUS", 13) == 0) {
-		reply_len = hostapd_ctrl_iface_wps_get_status(hapd, reply,
-							      reply_size);
-#ifdef CONFIG_WPS_NFC
-	} else if (os_strncmp(buf, "WPS_NFC_TAG_READ ", 17) == 0) {
-		if (hostapd_ctrl_iface_wps_nfc_tag_read(hapd, buf + 17))
+		else
+			reply_len += res;
+	}
+	if (reply_len >= 0) {
+		res = ieee802_1x_get_mib(hapd, reply + reply_len,
+					 reply_size - reply_len);
+		if (res < 0)
 			reply_len = -1;
-	} else if (os_strncmp(buf, "WPS_NFC_CONFIG_TOKEN ", 21) == 0) {
-		reply_len = hostapd_ctrl_iface_wps_nfc_config_token(
-			hapd, buf + 21, reply, reply_size);
-	} else if (os_strncmp(buf, "WPS_NFC_TOKEN ", 14) == 0) {
-		reply_len = hostapd_ctrl_iface_wps_nfc_token(
-			hapd, buf + 14, reply, reply_size);
-	} else if (os_strncmp(buf, "NFC_GET_HANDOVER_SEL ", 21) == 0) {
-		reply_len = hostapd_ctrl_iface_nfc_get_handover_sel(
-			hapd, buf + 21, reply, reply_size);
-	} else if (os_strncmp(buf, "NFC_REPORT_HANDOVER ", 20) == 0) {
-		if (hostapd_ctrl_iface_nfc_report_handover(hapd, buf + 20))
+		else
+			reply_len += res;
+	}
+#ifndef CONFIG_NO_RADIUS
+	if (reply_len >= 0) {
+		res = radius_client_get_mib(hapd->radius,
+					    reply + reply_len,
+					    reply_size - reply_len);
+		if (res < 0)
 			reply_len = -1;
-#endif /* CONFIG_WPS_NFC */
-#endif /* CONFIG_WPS */
-#ifdef CONFIG_INTERWORKING
-	} else if (os_strncmp(buf, "SET_QOS_MAP_SET ", 16) == 0) {
-		if (hostapd_ctrl_iface_set_qos_map_set(hapd, buf + 16))
+		else
+			reply_len += res;
+	}
+	if (reply_len >= 0) {
+		res = hostapd_acl_get_mib(hapd, reply + reply_len,
+					  reply_size - reply_len);
+		if (res < 0)
 			reply_len = -1;
-	} else if (os_strncmp(buf, "SEND_QOS_MAP_CONF ", 18) == 0) {
-		if (hostapd_ctrl_iface_send_qos_map_conf(hapd, buf + 18))
+		else
+			reply_len += res;
+	}
+	if (reply_len >= 0) {
+		res = accounting_get_mib(hapd, reply + reply_len,
+					 reply_size - reply_len);
+		if (res < 0)
 			reply_len = -1;
-#endif /* CONFIG_INTERWORKING */
+		else
+			reply_len += res;
+	}
+#endif /* CONFIG_NO_RADIUS */
+
+	return reply_len;
+}
+
+
+static int hostapd_ctrl_cmd_sta_first(struct hostapd_data *hapd, char *params,
+				      char *reply, int reply_size,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_sta_first(hapd, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_sta(struct hostapd_data *hapd, char *params,
+				char *reply, int reply_size,
+				struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_sta(hapd, params, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_sta_next(struct hostapd_data *hapd, char *params,
+				     char *reply, int reply_size,
+				     struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_sta_next(hapd, params, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_sta_dump(struct hostapd_data *hapd, char *params,
+				     char *reply, int reply_size,
+				     struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_sta_dump(hapd, params, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_attach(struct hostapd_data *hapd, char *params,
+				   char *reply, int reply_size,
+				   struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_attach(hapd, from, fromlen);
+}
+
+
+static int hostapd_ctrl_cmd_detach(struct hostapd_data *hapd, char *params,
+				   char *reply, int reply_size,
+				   struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_detach(hapd, from, fromlen);
+}
+
+
+static int hostapd_ctrl_cmd_level(struct hostapd_data *hapd, char *params,
+				  char *reply, int reply_size,
+				  struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_level(hapd, from, fromlen, params);
+}
+
+
+static int hostapd_ctrl_cmd_binary_events(struct hostapd_data *hapd,
+					  char *params, char *reply,
+					  int reply_size,
+					  struct sockaddr_un *from,
+					  socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_binary_events(hapd, from, fromlen, params);
+}
+
+
+static int hostapd_ctrl_cmd_event_filter(struct hostapd_data *hapd,
+					 char *params, char *reply,
+					 int reply_size,
+					 struct sockaddr_un *from,
+					 socklen_t fromlen)
+{
+	struct wpa_ctrl_dst *dst;
+
+	dst = ctrl_dst_get(hapd->ctrl_dst, from, fromlen);
+	if (dst == NULL)
+		return -1;
+	return ctrl_dst_event_filter(dst, params ? params : "");
+}
+
+
+static int hostapd_ctrl_cmd_monitors(struct hostapd_data *hapd, char *params,
+				     char *reply, int reply_size,
+				     struct sockaddr_un *from, socklen_t fromlen)
+{
+	return ctrl_dst_list(hapd->ctrl_dst, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_new_sta(struct hostapd_data *hapd, char *params,
+				    char *reply, int reply_size,
+				    struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_new_sta(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_deauthenticate(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_deauthenticate(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_disassociate(struct hostapd_data *hapd,
+					 char *params, char *reply,
+					 int reply_size,
+					 struct sockaddr_un *from,
+					 socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_disassociate(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_stop_ap(struct hostapd_data *hapd, char *params,
+				    char *reply, int reply_size,
+				    struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_stop_ap(hapd);
+}
+
+
+#ifdef CONFIG_IEEE80211W
+#ifdef NEED_AP_MLME
+static int hostapd_ctrl_cmd_sa_query(struct hostapd_data *hapd, char *params,
+				     char *reply, int reply_size,
+				     struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_sa_query(hapd, params);
+}
+#endif /* NEED_AP_MLME */
+#endif /* CONFIG_IEEE80211W */
+
+
+#ifdef CONFIG_WPS
+static int hostapd_ctrl_cmd_wps_pin(struct hostapd_data *hapd, char *params,
+				    char *reply, int reply_size,
+				    struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_wps_pin(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_wps_check_pin(struct hostapd_data *hapd,
+					  char *params, char *reply,
+					  int reply_size,
+					  struct sockaddr_un *from,
+					  socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_wps_check_pin(hapd, params, reply,
+						reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_wps_pbc(struct hostapd_data *hapd, char *params,
+				    char *reply, int reply_size,
+				    struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_wps_button_pushed(hapd, NULL);
+}
+
+
+static int hostapd_ctrl_cmd_wps_cancel(struct hostapd_data *hapd,
+				       char *params, char *reply,
+				       int reply_size,
+				       struct sockaddr_un *from,
+				       socklen_t fromlen)
+{
+	return hostapd_wps_cancel(hapd);
+}
+
+
+static int hostapd_ctrl_cmd_wps_ap_pin(struct hostapd_data *hapd,
+				       char *params, char *reply,
+				       int reply_size,
+				       struct sockaddr_un *from,
+				       socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_wps_ap_pin(hapd, params, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_wps_config(struct hostapd_data *hapd,
+				       char *params, char *reply,
+				       int reply_size,
+				       struct sockaddr_un *from,
+				       socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_wps_config(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_wps_get_status(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_wps_get_status(hapd, reply, reply_size);
+}
+
+
+#ifdef CONFIG_WPS_NFC
+static int hostapd_ctrl_cmd_wps_nfc_tag_read(struct hostapd_data *hapd,
+					     char *params, char *reply,
+					     int reply_size,
+					     struct sockaddr_un *from,
+					     socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_wps_nfc_tag_read(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_wps_nfc_config_token(struct hostapd_data *hapd,
+						 char *params, char *reply,
+						 int reply_size,
+						 struct sockaddr_un *from,
+						 socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_wps_nfc_config_token(hapd, params, reply,
+						       reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_wps_nfc_token(struct hostapd_data *hapd,
+					  char *params, char *reply,
+					  int reply_size,
+					  struct sockaddr_un *from,
+					  socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_wps_nfc_token(hapd, params, reply,
+						reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_nfc_get_handover_sel(struct hostapd_data *hapd,
+						 char *params, char *reply,
+						 int reply_size,
+						 struct sockaddr_un *from,
+						 socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_nfc_get_handover_sel(hapd, params, reply,
+						       reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_nfc_report_handover(struct hostapd_data *hapd,
+						char *params, char *reply,
+						int reply_size,
+						struct sockaddr_un *from,
+						socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_nfc_report_handover(hapd, params);
+}
+#endif /* CONFIG_WPS_NFC */
+#endif /* CONFIG_WPS */
+
+
+#ifdef CONFIG_INTERWORKING
+static int hostapd_ctrl_cmd_set_qos_map_set(struct hostapd_data *hapd,
+					    char *params, char *reply,
+					    int reply_size,
+					    struct sockaddr_un *from,
+					    socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_set_qos_map_set(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_send_qos_map_conf(struct hostapd_data *hapd,
+					      char *params, char *reply,
+					      int reply_size,
+					      struct sockaddr_un *from,
+					      socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_send_qos_map_conf(hapd, params);
+}
+#endif /* CONFIG_INTERWORKING */
+
+
 #ifdef CONFIG_HS20
-	} else if (os_strncmp(buf, "HS20_WNM_NOTIF ", 15) == 0) {
-		if (hostapd_ctrl_iface_hs20_wnm_notif(hapd, buf + 15))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "HS20_DEAUTH_REQ ", 16) == 0) {
-		if (hostapd_ctrl_iface_hs20_deauth_req(hapd, buf + 16))
-			reply_len = -1;
+static int hostapd_ctrl_cmd_hs20_wnm_notif(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_hs20_wnm_notif(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_hs20_deauth_req(struct hostapd_data *hapd,
+					    char *params, char *reply,
+					    int reply_size,
+					    struct sockaddr_un *from,
+					    socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_hs20_deauth_req(hapd, params);
+}
 #endif /* CONFIG_HS20 */
+
+
 #ifdef CONFIG_WNM
-	} else if (os_strncmp(buf, "DISASSOC_IMMINENT ", 18) == 0) {
-		if (hostapd_ctrl_iface_disassoc_imminent(hapd, buf + 18))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "ESS_DISASSOC ", 13) == 0) {
-		if (hostapd_ctrl_iface_ess_disassoc(hapd, buf + 13))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "BSS_TM_REQ ", 11) == 0) {
-		if (hostapd_ctrl_iface_bss_tm_req(hapd, buf + 11))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "BSS_TRANSITION ", 15) == 0) {
-		if (hostapd_ctrl_iface_bss_transition(hapd, buf + 15))
-			reply_len = -1;
+static int hostapd_ctrl_cmd_disassoc_imminent(struct hostapd_data *hapd,
+					      char *params, char *reply,
+					      int reply_size,
+					      struct sockaddr_un *from,
+					      socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_disassoc_imminent(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_ess_disassoc(struct hostapd_data *hapd,
+					 char *params, char *reply,
+					 int reply_size,
+					 struct sockaddr_un *from,
+					 socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_ess_disassoc(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_bss_tm_req(struct hostapd_data *hapd,
+				       char *params, char *reply,
+				       int reply_size,
+				       struct sockaddr_un *from,
+				       socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_bss_tm_req(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_bss_transition(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_bss_transition(hapd, params);
+}
 #endif /* CONFIG_WNM */
-	} else if (os_strcmp(buf, "GET_CONFIG") == 0) {
-		reply_len = hostapd_ctrl_iface_get_config(hapd, reply,
-							  reply_size);
-	} else if (os_strncmp(buf, "SET ", 4) == 0) {
-		if (hostapd_ctrl_iface_set(hapd, buf + 4))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "GET ", 4) == 0) {
-		reply_len = hostapd_ctrl_iface_get(hapd, buf + 4, reply,
-						   reply_size);
-	} else if (os_strncmp(buf, "ENABLE", 6) == 0) {
-		if (hostapd_ctrl_iface_enable(hapd->iface))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "RELOAD", 6) == 0) {
-		if (hostapd_ctrl_iface_reload(hapd->iface))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "DISABLE", 7) == 0) {
-		if (hostapd_ctrl_iface_disable(hapd->iface))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "UPDATE_BEACON") == 0) {
-		if (ieee802_11_set_beacon(hapd))
-			reply_len = -1;
+
+
+static int hostapd_ctrl_cmd_get_config(struct hostapd_data *hapd,
+				       char *params, char *reply,
+				       int reply_size,
+				       struct sockaddr_un *from,
+				       socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_get_config(hapd, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_set(struct hostapd_data *hapd, char *params,
+				char *reply, int reply_size,
+				struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_set(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_get(struct hostapd_data *hapd, char *params,
+				char *reply, int reply_size,
+				struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_get(hapd, params, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_enable(struct hostapd_data *hapd, char *params,
+				   char *reply, int reply_size,
+				   struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_enable(hapd->iface);
+}
+
+
+static int hostapd_ctrl_cmd_reload(struct hostapd_data *hapd, char *params,
+				   char *reply, int reply_size,
+				   struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_reload(hapd->iface);
+}
+
+
+static int hostapd_ctrl_cmd_disable(struct hostapd_data *hapd, char *params,
+				    char *reply, int reply_size,
+				    struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_disable(hapd->iface);
+}
+
+
+static int hostapd_ctrl_cmd_update_beacon(struct hostapd_data *hapd,
+					  char *params, char *reply,
+					  int reply_size,
+					  struct sockaddr_un *from,
+					  socklen_t fromlen)
+{
+	return ieee802_11_set_beacon(hapd);
+}
+
+
 #ifdef CONFIG_TESTING_OPTIONS
-	} else if (os_strncmp(buf, "RADAR ", 6) == 0) {
-		if (hostapd_ctrl_iface_radar(hapd, buf + 6))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "MGMT_TX ", 8) == 0) {
-		if (hostapd_ctrl_iface_mgmt_tx(hapd, buf + 8))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "EAPOL_RX ", 9) == 0) {
-		if (hostapd_ctrl_iface_eapol_rx(hapd, buf + 9) < 0)
-			reply_len = -1;
-	} else if (os_strncmp(buf, "DATA_TEST_CONFIG ", 17) == 0) {
-		if (hostapd_ctrl_iface_data_test_config(hapd, buf + 17) < 0)
-			reply_len = -1;
-	} else if (os_strncmp(buf, "DATA_TEST_TX ", 13) == 0) {
-		if (hostapd_ctrl_iface_data_test_tx(hapd, buf + 13) < 0)
-			reply_len = -1;
-	} else if (os_strncmp(buf, "DATA_TEST_FRAME ", 16) == 0) {
-		if (hostapd_ctrl_iface_data_test_frame(hapd, buf + 16) < 0)
-			reply_len = -1;
-	} else if (os_strncmp(buf, "TEST_ALLOC_FAIL ", 16) == 0) {
-		if (hostapd_ctrl_test_alloc_fail(hapd, buf + 16) < 0)
-			reply_len = -1;
-	} else if (os_strcmp(buf, "GET_ALLOC_FAIL") == 0) {
-		reply_len = hostapd_ctrl_get_alloc_fail(hapd, reply,
-							reply_size);
-	} else if (os_strncmp(buf, "TEST_FAIL ", 10) == 0) {
-		if (hostapd_ctrl_test_fail(hapd, buf + 10) < 0)
-			reply_len = -1;
-	} else if (os_strcmp(buf, "GET_FAIL") == 0) {
-		reply_len = hostapd_ctrl_get_fail(hapd, reply, reply_size);
+static int hostapd_ctrl_cmd_radar(struct hostapd_data *hapd, char *params,
+				  char *reply, int reply_size,
+				  struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_radar(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_mgmt_tx(struct hostapd_data *hapd, char *params,
+				    char *reply, int reply_size,
+				    struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_mgmt_tx(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_eapol_rx(struct hostapd_data *hapd, char *params,
+				     char *reply, int reply_size,
+				     struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_eapol_rx(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_data_test_config(struct hostapd_data *hapd,
+					     char *params, char *reply,
+					     int reply_size,
+					     struct sockaddr_un *from,
+					     socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_data_test_config(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_data_test_tx(struct hostapd_data *hapd,
+					 char *params, char *reply,
+					 int reply_size,
+					 struct sockaddr_un *from,
+					 socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_data_test_tx(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_data_test_frame(struct hostapd_data *hapd,
+					    char *params, char *reply,
+					    int reply_size,
+					    struct sockaddr_un *from,
+					    socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_data_test_frame(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_test_alloc_fail(struct hostapd_data *hapd,
+					    char *params, char *reply,
+					    int reply_size,
+					    struct sockaddr_un *from,
+					    socklen_t fromlen)
+{
+	return hostapd_ctrl_test_alloc_fail(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_get_alloc_fail(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	return hostapd_ctrl_get_alloc_fail(hapd, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_test_fail(struct hostapd_data *hapd, char *params,
+				      char *reply, int reply_size,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen)
+{
+	return hostapd_ctrl_test_fail(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_get_fail(struct hostapd_data *hapd, char *params,
+				     char *reply, int reply_size,
+				     struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_get_fail(hapd, reply, reply_size);
+}
 #endif /* CONFIG_TESTING_OPTIONS */
-	} else if (os_strncmp(buf, "CHAN_SWITCH ", 12) == 0) {
-		if (hostapd_ctrl_iface_chan_switch(hapd->iface, buf + 12))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "VENDOR ", 7) == 0) {
-		reply_len = hostapd_ctrl_iface_vendor(hapd, buf + 7, reply,
-						      reply_size);
-	} else if (os_strcmp(buf, "ERP_FLUSH") == 0) {
-		ieee802_1x_erp_flush(hapd);
+
+
+static int hostapd_ctrl_cmd_chan_switch(struct hostapd_data *hapd,
+					char *params, char *reply,
+					int reply_size,
+					struct sockaddr_un *from,
+					socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_chan_switch(hapd->iface, params);
+}
+
+
+static int hostapd_ctrl_cmd_vendor(struct hostapd_data *hapd, char *params,
+				   char *reply, int reply_size,
+				   struct sockaddr_un *from, socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_vendor(hapd, params, reply, reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_erp_flush(struct hostapd_data *hapd, char *params,
+				      char *reply, int reply_size,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen)
+{
+	ieee802_1x_erp_flush(hapd);
 #ifdef RADIUS_SERVER
-		radius_server_erp_flush(hapd->radius_srv);
+	radius_server_erp_flush(hapd->radius_srv);
 #endif /* RADIUS_SERVER */
-	// BEGIN HOSTAPD BLACKLIST SUPPORT
-	} else if (os_strncmp(buf, "BLACKLIST_ADD ", 14) == 0) {
-			if (hostapd_ctrl_iface_blacklist_add(hapd, buf + 14))
-				reply_len = -1;
-	} else if (os_strncmp(buf, "BLACKLIST_RM ", 13) == 0) {
-			if (hostapd_ctrl_iface_blacklist_rm(hapd, buf + 13))
-				reply_len = -1;
-	} else if (os_strcmp(buf, "BLACKLIST_SHOW") == 0) {
-		reply_len = hostapd_ctrl_iface_blacklist_show(hapd, reply,
-						reply_size);
-		if(reply_len == 0) {
-			os_memcpy(reply, "EMPTY\n", 6);
-			reply_len = 6;
-		}
-	} else if (os_strcmp(buf, "BLACKLIST_CLR") == 0) {
-		if(hostapd_ctrl_iface_blacklist_clr(hapd))
-			reply_len = -1;
-	// END HOSTAPD BLACKLIST SUPPORT
-	} else if (os_strncmp(buf, "EAPOL_REAUTH ", 13) == 0) {
-		if (hostapd_ctrl_iface_eapol_reauth(hapd, buf + 13))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "EAPOL_SET ", 10) == 0) {
-		if (hostapd_ctrl_iface_eapol_set(hapd, buf + 10))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "LOG_LEVEL", 9) == 0) {
-		reply_len = hostapd_ctrl_iface_log_level(
-			hapd, buf + 9, reply, reply_size);
+	return 0;
+}
+
+
+static int hostapd_ctrl_cmd_blacklist_add(struct hostapd_data *hapd,
+					  char *params, char *reply,
+					  int reply_size,
+					  struct sockaddr_un *from,
+					  socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_blacklist_add(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_blacklist_rm(struct hostapd_data *hapd,
+					 char *params, char *reply,
+					 int reply_size,
+					 struct sockaddr_un *from,
+					 socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_blacklist_rm(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_blacklist_load(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_blacklist_load(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_blacklist_dump(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_blacklist_dump(hapd, params, reply,
+						 reply_size);
+}
+
+
+static int hostapd_ctrl_cmd_blacklist_show(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	int reply_len;
+
+	reply_len = hostapd_ctrl_iface_blacklist_show(hapd, reply, reply_size);
+	if (reply_len == 0) {
+		os_memcpy(reply, "EMPTY\n", 6);
+		reply_len = 6;
+	}
+	return reply_len;
+}
+
+
+static int hostapd_ctrl_cmd_blacklist_clr(struct hostapd_data *hapd,
+					  char *params, char *reply,
+					  int reply_size,
+					  struct sockaddr_un *from,
+					  socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_blacklist_clr(hapd);
+}
+
+
+#ifdef CONFIG_NET_STEERING
+static int hostapd_ctrl_cmd_net_steering_stats(struct hostapd_data *hapd,
+					       char *params, char *reply,
+					       int reply_size,
+					       struct sockaddr_un *from,
+					       socklen_t fromlen)
+{
+	return net_steering_stats(hapd, reply, reply_size);
+}
+#endif /* CONFIG_NET_STEERING */
+
+
+static int hostapd_ctrl_cmd_eapol_reauth(struct hostapd_data *hapd,
+					 char *params, char *reply,
+					 int reply_size,
+					 struct sockaddr_un *from,
+					 socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_eapol_reauth(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_eapol_set(struct hostapd_data *hapd, char *params,
+				      char *reply, int reply_size,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_eapol_set(hapd, params);
+}
+
+
+static int hostapd_ctrl_cmd_log_level(struct hostapd_data *hapd, char *params,
+				      char *reply, int reply_size,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_log_level(hapd, params ? params : "", reply,
+					    reply_size);
+}
+
+
+#ifdef NEED_AP_MLME
+static int hostapd_ctrl_cmd_track_sta_list(struct hostapd_data *hapd,
+					   char *params, char *reply,
+					   int reply_size,
+					   struct sockaddr_un *from,
+					   socklen_t fromlen)
+{
+	return hostapd_ctrl_iface_track_sta_list(hapd, reply, reply_size);
+}
+#endif /* NEED_AP_MLME */
+
+
+static int hostapd_ctrl_cmd_cmd_stats(struct hostapd_data *hapd, char *params,
+				      char *reply, int reply_size,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen);
+
+
+/*
+ * Per-BSS control interface commands. ctrl_cmd_find() does a binary search,
+ * so the entries must be kept sorted by name (strcmp() order); test-ctrl-cmd
+ * checks this.
+ */
+static const struct hostapd_ctrl_cmd {
+	const char *name;
+	unsigned int flags;
+	int (*handler)(struct hostapd_data *hapd, char *params, char *reply,
+		       int reply_size, struct sockaddr_un *from,
+		       socklen_t fromlen);
+} hostapd_ctrl_cmds[] = {
+	{ "ATTACH", CTRL_CMD_BARE | CTRL_CMD_STATUS, hostapd_ctrl_cmd_attach },
+	{ "BINARY_EVENTS", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_binary_events },
+	{ "BLACKLIST_ADD", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_blacklist_add },
+	{ "BLACKLIST_CLR", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_blacklist_clr },
+	{ "BLACKLIST_DUMP", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  hostapd_ctrl_cmd_blacklist_dump },
+	{ "BLACKLIST_LOAD", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_blacklist_load },
+	{ "BLACKLIST_RM", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_blacklist_rm },
+	{ "BLACKLIST_SHOW", CTRL_CMD_BARE, hostapd_ctrl_cmd_blacklist_show },
+#ifdef CONFIG_WNM
+	{ "BSS_TM_REQ", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_bss_tm_req },
+	{ "BSS_TRANSITION", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_bss_transition },
+#endif /* CONFIG_WNM */
+	{ "CHAN_SWITCH", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_chan_switch },
+	{ "CMD_STATS", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  hostapd_ctrl_cmd_cmd_stats },
+#ifdef CONFIG_TESTING_OPTIONS
+	{ "DATA_TEST_CONFIG", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_data_test_config },
+	{ "DATA_TEST_FRAME", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_data_test_frame },
+	{ "DATA_TEST_TX", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_data_test_tx },
+#endif /* CONFIG_TESTING_OPTIONS */
+	{ "DEAUTHENTICATE", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_deauthenticate },
+	{ "DETACH", CTRL_CMD_BARE | CTRL_CMD_STATUS, hostapd_ctrl_cmd_detach },
+	{ "DISABLE", CTRL_CMD_BARE | CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_disable },
+	{ "DISASSOCIATE", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_disassociate },
+#ifdef CONFIG_WNM
+	{ "DISASSOC_IMMINENT", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_disassoc_imminent },
+#endif /* CONFIG_WNM */
+	{ "EAPOL_REAUTH", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_eapol_reauth },
+#ifdef CONFIG_TESTING_OPTIONS
+	{ "EAPOL_RX", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_eapol_rx },
+#endif /* CONFIG_TESTING_OPTIONS */
+	{ "EAPOL_SET", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_eapol_set },
+	{ "ELOOP_STATS", CTRL_CMD_BARE, hostapd_ctrl_cmd_eloop_stats },
+	{ "ENABLE", CTRL_CMD_BARE | CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_enable },
+	{ "ERP_FLUSH", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_erp_flush },
+#ifdef CONFIG_WNM
+	{ "ESS_DISASSOC", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_ess_disassoc },
+#endif /* CONFIG_WNM */
+	{ "EVENT_FILTER", CTRL_CMD_BARE | CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_event_filter },
+	{ "GET", CTRL_CMD_PARAMS, hostapd_ctrl_cmd_get },
+#ifdef CONFIG_TESTING_OPTIONS
+	{ "GET_ALLOC_FAIL", CTRL_CMD_BARE, hostapd_ctrl_cmd_get_alloc_fail },
+#endif /* CONFIG_TESTING_OPTIONS */
+	{ "GET_CONFIG", CTRL_CMD_BARE, hostapd_ctrl_cmd_get_config },
+#ifdef CONFIG_TESTING_OPTIONS
+	{ "GET_FAIL", CTRL_CMD_BARE, hostapd_ctrl_cmd_get_fail },
+#endif /* CONFIG_TESTING_OPTIONS */
+#ifdef CONFIG_HS20
+	{ "HS20_DEAUTH_REQ", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_hs20_deauth_req },
+	{ "HS20_WNM_NOTIF", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_hs20_wnm_notif },
+#endif /* CONFIG_HS20 */
+	{ "LEVEL", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, hostapd_ctrl_cmd_level },
+	{ "LOG_LEVEL", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  hostapd_ctrl_cmd_log_level },
+#ifdef CONFIG_TESTING_OPTIONS
+	{ "MGMT_TX", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_mgmt_tx },
+#endif /* CONFIG_TESTING_OPTIONS */
+	{ "MIB", CTRL_CMD_BARE | CTRL_CMD_PARAMS, hostapd_ctrl_cmd_mib },
+	{ "MONITORS", CTRL_CMD_BARE, hostapd_ctrl_cmd_monitors },
+#ifdef CONFIG_NET_STEERING
+	{ "NET_STEERING_STATS", CTRL_CMD_BARE,
+	  hostapd_ctrl_cmd_net_steering_stats },
+#endif /* CONFIG_NET_STEERING */
+	{ "NEW_STA", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_new_sta },
+#ifdef CONFIG_WPS
+#ifdef CONFIG_WPS_NFC
+	{ "NFC_GET_HANDOVER_SEL", CTRL_CMD_PARAMS,
+	  hostapd_ctrl_cmd_nfc_get_handover_sel },
+	{ "NFC_REPORT_HANDOVER", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_nfc_report_handover },
+#endif /* CONFIG_WPS_NFC */
+#endif /* CONFIG_WPS */
+	{ "PING", CTRL_CMD_BARE, hostapd_ctrl_cmd_ping },
+#ifdef CONFIG_TESTING_OPTIONS
+	{ "RADAR", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, hostapd_ctrl_cmd_radar },
+#endif /* CONFIG_TESTING_OPTIONS */
+	{ "RELOAD", CTRL_CMD_BARE | CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_reload },
+	{ "RELOG", CTRL_CMD_BARE | CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_relog },
+#ifdef CONFIG_IEEE80211W
 #ifdef NEED_AP_MLME
-	} else if (os_strcmp(buf, "TRACK_STA_LIST") == 0) {
-		reply_len = hostapd_ctrl_iface_track_sta_list(
-			hapd, reply, reply_size);
+	{ "SA_QUERY", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_sa_query },
 #endif /* NEED_AP_MLME */
+#endif /* CONFIG_IEEE80211W */
+#ifdef CONFIG_INTERWORKING
+	{ "SEND_QOS_MAP_CONF", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_send_qos_map_conf },
+#endif /* CONFIG_INTERWORKING */
+	{ "SET", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, hostapd_ctrl_cmd_set },
+#ifdef CONFIG_INTERWORKING
+	{ "SET_QOS_MAP_SET", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_set_qos_map_set },
+#endif /* CONFIG_INTERWORKING */
+	{ "STA", CTRL_CMD_PARAMS, hostapd_ctrl_cmd_sta },
+	{ "STA-DUMP", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  hostapd_ctrl_cmd_sta_dump },
+	{ "STA-FIRST", CTRL_CMD_BARE, hostapd_ctrl_cmd_sta_first },
+	{ "STA-NEXT", CTRL_CMD_PARAMS, hostapd_ctrl_cmd_sta_next },
+	{ "STATUS", CTRL_CMD_BARE, hostapd_ctrl_cmd_status },
+	{ "STATUS-DRIVER", CTRL_CMD_BARE, hostapd_ctrl_cmd_status_driver },
+	{ "STOP_AP", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_stop_ap },
+#ifdef CONFIG_TESTING_OPTIONS
+	{ "TEST_ALLOC_FAIL", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_test_alloc_fail },
+	{ "TEST_FAIL", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_test_fail },
+#endif /* CONFIG_TESTING_OPTIONS */
+#ifdef NEED_AP_MLME
+	{ "TRACK_STA_LIST", CTRL_CMD_BARE, hostapd_ctrl_cmd_track_sta_list },
+#endif /* NEED_AP_MLME */
+	{ "UPDATE_BEACON", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_update_beacon },
+	{ "VENDOR", CTRL_CMD_PARAMS, hostapd_ctrl_cmd_vendor },
+#ifdef CONFIG_WPS
+	{ "WPS_AP_PIN", CTRL_CMD_PARAMS, hostapd_ctrl_cmd_wps_ap_pin },
+	{ "WPS_CANCEL", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_wps_cancel },
+	{ "WPS_CHECK_PIN", CTRL_CMD_PARAMS, hostapd_ctrl_cmd_wps_check_pin },
+	{ "WPS_CONFIG", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_wps_config },
+	{ "WPS_GET_STATUS", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  hostapd_ctrl_cmd_wps_get_status },
+#ifdef CONFIG_WPS_NFC
+	{ "WPS_NFC_CONFIG_TOKEN", CTRL_CMD_PARAMS,
+	  hostapd_ctrl_cmd_wps_nfc_config_token },
+	{ "WPS_NFC_TAG_READ", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_wps_nfc_tag_read },
+	{ "WPS_NFC_TOKEN", CTRL_CMD_PARAMS, hostapd_ctrl_cmd_wps_nfc_token },
+#endif /* CONFIG_WPS_NFC */
+	{ "WPS_PBC", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_wps_pbc },
+	{ "WPS_PIN", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  hostapd_ctrl_cmd_wps_pin },
+#endif /* CONFIG_WPS */
+};
+
+/* Index of the unknown command counters in hapd->ctrl_cmd_stats */
+#define HOSTAPD_CTRL_UNKNOWN_CMD ARRAY_SIZE(hostapd_ctrl_cmds)
+
+
+static int hostapd_ctrl_cmd_cmd_stats(struct hostapd_data *hapd, char *params,
+				      char *reply, int reply_size,
+				      struct sockaddr_un *from,
+				      socklen_t fromlen)
+{
+	char *pos = reply, *end = reply + reply_size;
+	size_t i;
+	int ret;
+
+	if (hapd->ctrl_cmd_stats == NULL)
+		return -1;
+
+	if (params) {
+		if (os_strcmp(params, "RESET") != 0)
+			return -1;
+		os_memset(hapd->ctrl_cmd_stats, 0,
+			  (HOSTAPD_CTRL_UNKNOWN_CMD + 1) *
+			  sizeof(hapd->ctrl_cmd_stats[0]));
+		os_memcpy(reply, "OK\n", 3);
+		return 3;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(hostapd_ctrl_cmds); i++) {
+		ret = ctrl_cmd_stats_print(hostapd_ctrl_cmds[i].name,
+					   &hapd->ctrl_cmd_stats[i],
+					   pos, end - pos);
+		if (ret < 0)
+			return pos - reply;
+		pos += ret;
+	}
+	ret = ctrl_cmd_stats_print("UNKNOWN",
+				   &hapd->ctrl_cmd_stats[
+					   HOSTAPD_CTRL_UNKNOWN_CMD],
+				   pos, end - pos);
+	if (ret > 0)
+		pos += ret;
+
+	return pos - reply;
+}
+
+
+static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
+					      char *buf, char *reply,
+					      int reply_size,
+					      struct sockaddr_un *from,
+					      socklen_t fromlen)
+{
+	const struct hostapd_ctrl_cmd *cmd;
+	struct os_reltime start;
+	char *params;
+	int reply_len, failed = 0;
+	size_t idx;
+
+	if (hapd->ctrl_cmd_stats == NULL)
+		hapd->ctrl_cmd_stats = os_calloc(HOSTAPD_CTRL_UNKNOWN_CMD + 1,
+						 sizeof(struct ctrl_cmd_stats));
+
+	os_get_reltime(&start);
+	os_memcpy(reply, "OK\n", 3);
+	reply_len = 3;
+
+	cmd = ctrl_cmd_find(hostapd_ctrl_cmds, ARRAY_SIZE(hostapd_ctrl_cmds),
+			    sizeof(hostapd_ctrl_cmds[0]), buf, &params);
+	if (cmd && ctrl_cmd_accepts(cmd->flags, params)) {
+		int res;
+
+		idx = cmd - hostapd_ctrl_cmds;
+		res = cmd->handler(hapd, params, reply, reply_size, from,
+				   fromlen);
+		if (!(cmd->flags & CTRL_CMD_STATUS))
+			reply_len = res;
+		else if (res < 0)
+			reply_len = -1;
 	} else {
+		idx = HOSTAPD_CTRL_UNKNOWN_CMD;
 		os_memcpy(reply, "UNKNOWN COMMAND\n", 16);
 		reply_len = 16;
 	}
@@ -2381,12 +3577,37 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	if (reply_len < 0) {
 		os_memcpy(reply, "FAIL\n", 5);
 		reply_len = 5;
+		failed = 1;
 	}
 
+	/* The handler may have deinitialized the control interface */
+	if (hapd->ctrl_cmd_stats)
+		ctrl_cmd_stats_update(&hapd->ctrl_cmd_stats[idx], &start,
+				      failed);
+
 	return reply_len;
 }
 
 
+/*
+ * Send a command reply. A reply that does not fit into the non-blocking
+ * socket is dropped; errno is cleared so that the EAGAIN is not taken for an
+ * empty socket by eloop (see eloop_set_read_sock_budget()).
+ */
+static void hostapd_ctrl_iface_reply(int sock, const char *reply,
+				     int reply_len,
+				     const struct sockaddr_un *from,
+				     socklen_t fromlen)
+{
+	if (sendto(sock, reply, reply_len, 0, (const struct sockaddr *) from,
+		   fromlen) < 0) {
+		wpa_printf(MSG_DEBUG, "CTRL: sendto failed: %s",
+			   strerror(errno));
+		errno = 0;
+	}
+}
+
+
 static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 				       void *sock_ctx)
 {
@@ -2396,29 +3617,30 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 	struct sockaddr_un from;
 	socklen_t fromlen = sizeof(from);
 	char *reply;
-	const int reply_size = 4096;
+	int reply_size = 4096;
 	int reply_len;
 	int level = MSG_DEBUG;
 
 	res = recvfrom(sock, buf, sizeof(buf) - 1, 0,
 		       (struct sockaddr *) &from, &fromlen);
 	if (res < 0) {
-		wpa_printf(MSG_ERROR, "recvfrom(ctrl_iface): %s",
-			   strerror(errno));
+		/* EAGAIN ends the calls for this wakeup; no more commands */
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			wpa_printf(MSG_ERROR, "recvfrom(ctrl_iface): %s",
+				   strerror(errno));
 		return;
 	}
 	buf[res] = '\0';
 	if (os_strcmp(buf, "PING") == 0)
 		level = MSG_EXCESSIVE;
+	/* STA-DUMP pages can be larger than other replies; see size=<bytes> */
+	if (os_strncmp(buf, "STA-DUMP", 8) == 0)
+		reply_size = STA_DUMP_MAX_REPLY;
 	wpa_hexdump_ascii(level, "RX ctrl_iface", (u8 *) buf, res);
 
 	reply = os_malloc(reply_size);
 	if (reply == NULL) {
-		if (sendto(sock, "FAIL\n", 5, 0, (struct sockaddr *) &from,
-			   fromlen) < 0) {
-			wpa_printf(MSG_DEBUG, "CTRL: sendto failed: %s",
-				   strerror(errno));
-		}
+		hostapd_ctrl_iface_reply(sock, "FAIL\n", 5, &from, fromlen);
 		return;
 	}
 
@@ -2426,11 +3648,7 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 						       reply, reply_size,
 						       &from, fromlen);
 
-	if (sendto(sock, reply, reply_len, 0, (struct sockaddr *) &from,
-		   fromlen) < 0) {
-		wpa_printf(MSG_DEBUG, "CTRL: sendto failed: %s",
-			   strerror(errno));
-	}
+	hostapd_ctrl_iface_reply(sock, reply, reply_len, &from, fromlen);
 	os_free(reply);
 }
 
@@ -2456,6 +3674,69 @@ static char * hostapd_ctrl_iface_path(struct hostapd_data *hapd)
 }
 
 
+static void hostapd_ctrl_iface_flush_events(void *eloop_ctx,
+					    void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	struct wpa_ctrl_dst *dst, *next;
+	int res, blocked = 0;
+
+	for (dst = hapd->ctrl_dst; dst; dst = next) {
+		next = dst->next;
+		res = ctrl_dst_drain(hapd->ctrl_sock, dst);
+		if (res < 0)
+			hostapd_ctrl_iface_detach(hapd, &dst->addr,
+						  dst->addrlen);
+		else if (res > 0)
+			blocked = 1;
+	}
+
+	/* Writability of the unconnected control interface socket does not
+	 * reflect the receive queue of the monitor, so retry on a timer. */
+	if (blocked &&
+	    !eloop_is_timeout_registered(hostapd_ctrl_iface_retry_events,
+					 hapd, NULL))
+		eloop_register_timeout(0, CTRL_IFACE_MONITOR_RETRY_USEC,
+				       hostapd_ctrl_iface_retry_events,
+				       hapd, NULL);
+}
+
+
+static void hostapd_ctrl_iface_retry_events(void *eloop_ctx,
+					    void *timeout_ctx)
+{
+	hostapd_ctrl_iface_flush_events(eloop_ctx, timeout_ctx);
+}
+
+
+static void hostapd_ctrl_iface_send_bin(const struct hostapd_data *hapd,
+					const u8 *buf, size_t len)
+{
+	struct wpa_ctrl_dst *dst;
+	struct ctrl_iface_event *ev = NULL;
+
+	if (hapd->ctrl_sock < 0)
+		return;
+
+	for (dst = hapd->ctrl_dst; dst; dst = dst->next) {
+		if (!dst->binary_events)
+			continue;
+		if (ev == NULL) {
+			ev = ctrl_iface_event_alloc(NULL, buf, len);
+			if (ev == NULL)
+				return;
+		}
+		ctrl_dst_queue_push(dst, ev);
+	}
+
+	if (ev &&
+	    !eloop_is_timeout_registered(hostapd_ctrl_iface_flush_events,
+					 (void *) hapd, NULL))
+		eloop_register_timeout(0, 0, hostapd_ctrl_iface_flush_events,
+				       (void *) hapd, NULL);
+}
+
+
 static void hostapd_ctrl_iface_msg_cb(void *ctx, int level,
 				      enum wpa_msg_type type,
 				      const char *txt, size_t len)
@@ -2471,6 +3752,7 @@ int hostapd_ctrl_iface_init(struct hostapd_data *hapd)
 {
 	struct sockaddr_un addr;
 	int s = -1;
+	int flags;
 	char *fname = NULL;
 
 	if (hapd->ctrl_sock > -1) {
@@ -2598,13 +3880,30 @@ int hostapd_ctrl_iface_init(struct hostapd_data *hapd)
 	}
 	os_free(fname);
 
+	/*
+	 * Make socket non-blocking so that a reply to a requester that is not
+	 * reading its socket does not stall event processing.
+	 */
+	flags = fcntl(s, F_GETFL);
+	if (flags >= 0) {
+		flags |= O_NONBLOCK;
+		if (fcntl(s, F_SETFL, flags) < 0) {
+			wpa_printf(MSG_INFO, "fcntl(ctrl, O_NONBLOCK): %s",
+				   strerror(errno));
+			/* Not fatal, continue on.*/
+		}
+	}
+
 	hapd->ctrl_sock = s;
 	if (eloop_register_read_sock(s, hostapd_ctrl_iface_receive, hapd,
 				     NULL) < 0) {
 		hostapd_ctrl_iface_deinit(hapd);
 		return -1;
 	}
+	/* Handle bursts of commands (e.g., from monitoring scripts) at once */
+	eloop_set_read_sock_budget(s, 8);
 	hapd->msg_ctx = hapd;
+	hapd->bin_event_cb = hostapd_ctrl_iface_send_bin;
 	wpa_msg_register_cb(hostapd_ctrl_iface_msg_cb);
 
 	return 0;
@@ -2624,8 +3923,15 @@ void hostapd_ctrl_iface_deinit(struct hostapd_data *hapd)
 {
 	struct wpa_ctrl_dst *dst, *prev;
 
+	eloop_cancel_timeout(hostapd_ctrl_iface_flush_events, hapd, NULL);
+	eloop_cancel_timeout(hostapd_ctrl_iface_retry_events, hapd, NULL);
+
 	if (hapd->ctrl_sock > -1) {
 		char *fname;
+
+		/* Best effort delivery of events that are still queued */
+		for (dst = hapd->ctrl_dst; dst; dst = dst->next)
+			ctrl_dst_drain(hapd->ctrl_sock, dst);
 		eloop_unregister_read_sock(hapd->ctrl_sock);
 		close(hapd->ctrl_sock);
 		hapd->ctrl_sock = -1;
@@ -2654,8 +3960,12 @@ void hostapd_ctrl_iface_deinit(struct hostapd_data *hapd)
 	while (dst) {
 		prev = dst;
 		dst = dst->next;
-		os_free(prev);
+		ctrl_dst_free(prev);
 	}
+	hostapd_ctrl_iface_count_monitors(hapd);
+	hapd->bin_event_cb = NULL;
+	os_free(hapd->ctrl_cmd_stats);
+	hapd->ctrl_cmd_stats = NULL;
 
 #ifdef CONFIG_TESTING_OPTIONS
 	l2_packet_deinit(hapd->l2_test);
@@ -2728,7 +4038,7 @@ static int hostapd_global_ctrl_iface_detach(struct hapd_interfaces *interfaces,
 				interfaces->global_ctrl_dst = dst->next;
 			else
 				prev->next = dst->next;
-			os_free(dst);
+			ctrl_dst_free(dst);
 			return 0;
 		}
 		prev = dst;
@@ -2959,7 +4269,7 @@ static int hostapd_global_ctrl_iface_ifname(struct hapd_interfaces *interfaces,
 static void hostapd_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 					      void *sock_ctx)
 {
-	void *interfaces = eloop_ctx;
+	struct hapd_interfaces *interfaces = eloop_ctx;
 	char buf[256];
 	int res;
 	struct sockaddr_un from;
@@ -2971,8 +4281,10 @@ static void hostapd_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 	res = recvfrom(sock, buf, sizeof(buf) - 1, 0,
 		       (struct sockaddr *) &from, &fromlen);
 	if (res < 0) {
-		wpa_printf(MSG_ERROR, "recvfrom(ctrl_iface): %s",
-			   strerror(errno));
+		/* EAGAIN ends the calls for this wakeup; no more commands */
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			wpa_printf(MSG_ERROR, "recvfrom(ctrl_iface): %s",
+				   strerror(errno));
 		return;
 	}
 	buf[res] = '\0';
@@ -2980,11 +4292,7 @@ static void hostapd_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 
 	reply = os_malloc(reply_size);
 	if (reply == NULL) {
-		if (sendto(sock, "FAIL\n", 5, 0, (struct sockaddr *) &from,
-			   fromlen) < 0) {
-			wpa_printf(MSG_DEBUG, "CTRL: sendto failed: %s",
-				   strerror(errno));
-		}
+		hostapd_ctrl_iface_reply(sock, "FAIL\n", 5, &from, fromlen);
 		return;
 	}
 
@@ -3025,6 +4333,17 @@ static void hostapd_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 		if (hostapd_global_ctrl_iface_detach(interfaces, &from,
 			fromlen))
 			reply_len = -1;
+	} else if (os_strncmp(buf, "EVENT_FILTER", 12) == 0 &&
+		   (buf[12] == '\0' || buf[12] == ' ')) {
+		struct wpa_ctrl_dst *dst;
+
+		dst = ctrl_dst_get(interfaces->global_ctrl_dst, &from,
+				   fromlen);
+		if (dst == NULL || ctrl_dst_event_filter(dst, buf + 12))
+			reply_len = -1;
+	} else if (os_strcmp(buf, "MONITORS") == 0) {
+		reply_len = ctrl_dst_list(interfaces->global_ctrl_dst, reply,
+					  reply_size);
 #ifdef CONFIG_MODULE_TESTS
 	} else if (os_strcmp(buf, "MODULE_TESTS") == 0) {
 		int hapd_module_tests(void);
@@ -3063,11 +4382,7 @@ send_reply:
 		reply_len = 5;
 	}
 
-	if (sendto(sock, reply, reply_len, 0, (struct sockaddr *) &from,
-		   fromlen) < 0) {
-		wpa_printf(MSG_DEBUG, "CTRL: sendto failed: %s",
-			   strerror(errno));
-	}
+	hostapd_ctrl_iface_reply(sock, reply, reply_len, &from, fromlen);
 	os_free(reply);
 }
 
@@ -3097,6 +4412,7 @@ int hostapd_global_ctrl_iface_init(struct hapd_interfaces *interface)
 {
 	struct sockaddr_un addr;
 	int s = -1;
+	int flags;
 	char *fname = NULL;
 
 	if (interface->global_iface_path == NULL) {
@@ -3186,9 +4502,24 @@ int hostapd_global_ctrl_iface_init(struct hapd_interfaces *interface)
 	}
 	os_free(fname);
 
+	/*
+	 * Make socket non-blocking so that a reply to a requester that is not
+	 * reading its socket does not stall event processing.
+	 */
+	flags = fcntl(s, F_GETFL);
+	if (flags >= 0) {
+		flags |= O_NONBLOCK;
+		if (fcntl(s, F_SETFL, flags) < 0) {
+			wpa_printf(MSG_INFO, "fcntl(ctrl, O_NONBLOCK): %s",
+				   strerror(errno));
+			/* Not fatal, continue on.*/
+		}
+	}
+
 	interface->global_ctrl_sock = s;
 	eloop_register_read_sock(s, hostapd_global_ctrl_iface_receive,
 				 interface, NULL);
+	eloop_set_read_sock_budget(s, 8);
 
 	return 0;
 
@@ -3208,7 +4539,14 @@ void hostapd_global_ctrl_iface_deinit(struct hapd_interfaces *interfaces)
 	char *fname = NULL;
 	struct wpa_ctrl_dst *dst, *prev;
 
+	eloop_cancel_timeout(hostapd_global_ctrl_iface_flush_events,
+			     interfaces, NULL);
+	eloop_cancel_timeout(hostapd_global_ctrl_iface_retry_events,
+			     interfaces, NULL);
+
 	if (interfaces->global_ctrl_sock > -1) {
+		for (dst = interfaces->global_ctrl_dst; dst; dst = dst->next)
+			ctrl_dst_drain(interfaces->global_ctrl_sock, dst);
 		eloop_unregister_read_sock(interfaces->global_ctrl_sock);
 		close(interfaces->global_ctrl_sock);
 		interfaces->global_ctrl_sock = -1;
@@ -3241,74 +4579,97 @@ void hostapd_global_ctrl_iface_deinit(struct hapd_interfaces *interfaces)
 	while (dst) {
 		prev = dst;
 		dst = dst->next;
-		os_free(prev);
+		ctrl_dst_free(prev);
 	}
 }
 
 
+static void hostapd_global_ctrl_iface_flush_events(void *eloop_ctx,
+						   void *timeout_ctx)
+{
+	struct hapd_interfaces *interfaces = eloop_ctx;
+	struct wpa_ctrl_dst *dst, *next;
+	int res, blocked = 0;
+
+	for (dst = interfaces->global_ctrl_dst; dst; dst = next) {
+		next = dst->next;
+		res = ctrl_dst_drain(interfaces->global_ctrl_sock, dst);
+		if (res < 0)
+			hostapd_global_ctrl_iface_detach(interfaces,
+							 &dst->addr,
+							 dst->addrlen);
+		else if (res > 0)
+			blocked = 1;
+	}
+
+	if (blocked &&
+	    !eloop_is_timeout_registered(
+		    hostapd_global_ctrl_iface_retry_events, interfaces, NULL))
+		eloop_register_timeout(0, CTRL_IFACE_MONITOR_RETRY_USEC,
+				       hostapd_global_ctrl_iface_retry_events,
+				       interfaces, NULL);
+}
+
+
+static void hostapd_global_ctrl_iface_retry_events(void *eloop_ctx,
+						   void *timeout_ctx)
+{
+	hostapd_global_ctrl_iface_flush_events(eloop_ctx, timeout_ctx);
+}
+
+
+/*
+ * Queue an event for all monitors that want it. The event is formatted once
+ * and sent from the event loop so that slow monitors do not add latency to
+ * the code path that generated the event.
+ */
 static void hostapd_ctrl_iface_send(struct hostapd_data *hapd, int level,
 				    enum wpa_msg_type type,
 				    const char *buf, size_t len)
 {
-	struct wpa_ctrl_dst *dst, *next;
-	struct msghdr msg;
-	int idx;
-	struct iovec io[2];
+	struct wpa_ctrl_dst *dst;
+	struct ctrl_iface_event *ev = NULL;
 	char levelstr[10];
+	void (*flush)(void *eloop_ctx, void *timeout_ctx);
+	void *ctx;
 	int s;
 
 	if (type != WPA_MSG_ONLY_GLOBAL) {
 		s = hapd->ctrl_sock;
 		dst = hapd->ctrl_dst;
+		flush = hostapd_ctrl_iface_flush_events;
+		ctx = hapd;
 	} else {
 		s = hapd->iface->interfaces->global_ctrl_sock;
 		dst = hapd->iface->interfaces->global_ctrl_dst;
+		flush = hostapd_global_ctrl_iface_flush_events;
+		ctx = hapd->iface->interfaces;
 	}
 
 	if (s < 0 || dst == NULL)
 		return;
 
-	os_snprintf(levelstr, sizeof(levelstr), "<%d>", level);
-	io[0].iov_base = levelstr;
-	io[0].iov_len = os_strlen(levelstr);
-	io[1].iov_base = (char *) buf;
-	io[1].iov_len = len;
-	os_memset(&msg, 0, sizeof(msg));
-	msg.msg_iov = io;
-	msg.msg_iovlen = 2;
-
-	idx = 0;
-	while (dst) {
-		next = dst->next;
-		if (level >= dst->debug_level) {
-			wpa_hexdump(MSG_DEBUG, "CTRL_IFACE monitor send",
-				    (u8 *) dst->addr.sun_path, dst->addrlen -
-				    offsetof(struct sockaddr_un, sun_path));
-			msg.msg_name = &dst->addr;
-			msg.msg_namelen = dst->addrlen;
-			if (sendmsg(s, &msg, 0) < 0) {
-				int _errno = errno;
-				wpa_printf(MSG_INFO, "CTRL_IFACE monitor[%d]: "
-					   "%d - %s",
-					   idx, errno, strerror(errno));
-				dst->errors++;
-				if (dst->errors > 10 || _errno == ENOENT) {
-					if (type != WPA_MSG_ONLY_GLOBAL)
-						hostapd_ctrl_iface_detach(
-							hapd, &dst->addr,
-							dst->addrlen);
-					else
-						hostapd_global_ctrl_iface_detach(
-							hapd->iface->interfaces,
-							&dst->addr,
-							dst->addrlen);
-				}
-			} else
-				dst->errors = 0;
+	for (; dst; dst = dst->next) {
+		if (level < dst->debug_level ||
+		    (dst->binary_events &&
+		     hostapd_bin_event_text(buf)))
+			continue;
+		if (dst->num_event_filters &&
+		    !ctrl_dst_event_allowed(dst, buf, len)) {
+			dst->filtered++;
+			continue;
+		}
+		if (ev == NULL) {
+			os_snprintf(levelstr, sizeof(levelstr), "<%d>", level);
+			ev = ctrl_iface_event_alloc(levelstr, buf, len);
+			if (ev == NULL)
+				return;
 		}
-		idx++;
-		dst = next;
+		ctrl_dst_queue_push(dst, ev);
 	}
+
+	if (ev && !eloop_is_timeout_registered(flush, ctx, NULL))
+		eloop_register_timeout(0, 0, flush, ctx, NULL);
 }
 
 #endif /* CONFIG_NATIVE_WINDOWS */
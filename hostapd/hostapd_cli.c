@@ -62,10 +62,14 @@ static const char *const commands_help =
 "   mib                  get MIB variables (dot1x, dot11, radius)\n"
 "   sta <addr>           get MIB variables for one station\n"
 "   all_sta              get MIB variables for all stations\n"
+"   sta_dump [fields=<f1,f2,..>] [compact]  dump stations in pages\n"
 "   new_sta <addr>       add a new station\n"
 "   deauthenticate <addr>  deauthenticate a station\n"
 "   disassociate <addr>  disassociate a station\n"
-"   blacklist_add <addr>  blacklist a station from an AP\n"
+"   blacklist_add <addr> [ttl=<secs>]  blacklist a station from an AP\n"
+"   blacklist_load <addr>[/<secs>] ...  blacklist several stations\n"
+"   blacklist_dump [<addr>]  dump blacklist entries (after <addr>)\n"
+"   net_steering_stats    show net steering client table statistics\n"
 "   blacklist_rm <addr>   remove a station from the blacklist\n"
 "   blacklist_clr         clear all stations from the blacklist\n"
 "   blacklist_show        show entire blacklist\n"
@@ -88,6 +92,10 @@ static const char *const commands_help =
 "   wps_get_status       show current WPS status\n"
 #endif /* CONFIG_WPS */
 "   get_config           show current configuration\n"
+"   eloop_stats          show event loop allocation statistics\n"
+"   cmd_stats [RESET]    show/reset control interface command statistics\n"
+"   event_filter [[-]<prefix>..]  select events sent to this monitor\n"
+"   monitors             show attached monitors and event queues\n"
 "   help                 show this usage help\n"
 "   interface [ifname]   show interfaces/select interface\n"
 "   level <debug level>  change debug level\n"
@@ -240,6 +248,22 @@ static int hostapd_cli_cmd_status(struct wpa_ctrl *ctrl, int argc, char *argv[])
 }
 
 
+static int hostapd_cli_cmd_eloop_stats(struct wpa_ctrl *ctrl, int argc,
+				       char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "ELOOP_STATS");
+}
+
+
+static int hostapd_cli_cmd_cmd_stats(struct wpa_ctrl *ctrl, int argc,
+				     char *argv[])
+{
+	if (argc > 0 && os_strcasecmp(argv[0], "reset") == 0)
+		return wpa_ctrl_command(ctrl, "CMD_STATS RESET");
+	return wpa_ctrl_command(ctrl, "CMD_STATS");
+}
+
+
 static int hostapd_cli_cmd_mib(struct wpa_ctrl *ctrl, int argc, char *argv[])
 {
 	if (argc > 0) {
@@ -352,6 +376,64 @@ static int hostapd_cli_cmd_disassociate(struct wpa_ctrl *ctrl, int argc,
 	return wpa_ctrl_command(ctrl, buf);
 }
 
+/*
+ * Send a paged dump command, starting after cursor if given, and request the
+ * next page for as long as the reply ends with CURSOR <addr>
+ */
+static int hostapd_cli_dump_pages(struct wpa_ctrl *ctrl, const char *name,
+				  const char *start, int argc, char *argv[])
+{
+	char buf[4096], cmd[256], cursor[32], *pos;
+	size_t len;
+	int i, res, ret;
+
+	if (ctrl_conn == NULL) {
+		printf("Not connected to hostapd - command dropped.\n");
+		return -1;
+	}
+
+	os_strlcpy(cursor, start ? start : "", sizeof(cursor));
+	for (;;) {
+		len = os_snprintf(cmd, sizeof(cmd), "%s%s%s", name,
+				  cursor[0] ? " " : "", cursor);
+		for (i = 0; i < argc; i++) {
+			res = os_snprintf(cmd + len, sizeof(cmd) - len, " %s",
+					  argv[i]);
+			if (os_snprintf_error(sizeof(cmd) - len, res)) {
+				printf("Too long %s command.\n", name);
+				return -1;
+			}
+			len += res;
+		}
+
+		len = sizeof(buf) - 1;
+		ret = wpa_ctrl_request(ctrl, cmd, os_strlen(cmd), buf, &len,
+				       hostapd_cli_msg_cb);
+		if (ret == -2) {
+			printf("'%s' command timed out.\n", cmd);
+			return -2;
+		} else if (ret < 0) {
+			printf("'%s' command failed.\n", cmd);
+			return -1;
+		}
+		buf[len] = '\0';
+		if (os_strncmp(buf, "FAIL", 4) == 0) {
+			printf("%s", buf);
+			return -1;
+		}
+
+		/* Each page ends with either END or CURSOR <addr> */
+		if (len > 0 && buf[len - 1] == '\n')
+			buf[--len] = '\0';
+		pos = os_strrchr(buf, '\n');
+		pos = pos ? pos + 1 : buf;
+		printf("%.*s", (int) (pos - buf), buf);
+		if (os_strncmp(pos, "CURSOR ", 7) != 0)
+			return 0;
+		os_strlcpy(cursor, pos + 7, sizeof(cursor));
+	}
+}
+
 // BEGIN HOSTAPD BLACKLIST SUPPORT
 
 static int hostapd_cli_cmd_blacklist_add_hostapd(struct wpa_ctrl *ctrl, int argc,
@@ -359,15 +441,54 @@ static int hostapd_cli_cmd_blacklist_add_hostapd(struct wpa_ctrl *ctrl, int argc
 {
 	char buf[64];
 
-	if (argc != 1) {
-		printf("Invalid 'blacklist_add_hostapd' command - exactly one argument, STA address, is required.\n");
+	if (argc < 1 || argc > 2) {
+		printf("Invalid 'blacklist_add_hostapd' command - one argument, STA address, and optional ttl=<secs> are required.\n");
 		return -1;
 	}
 
-	os_snprintf(buf, sizeof(buf), "BLACKLIST_ADD %s", argv[0]);
+	if (argc == 2)
+		os_snprintf(buf, sizeof(buf), "BLACKLIST_ADD %s %s", argv[0],
+			    argv[1]);
+	else
+		os_snprintf(buf, sizeof(buf), "BLACKLIST_ADD %s", argv[0]);
 	return wpa_ctrl_command(ctrl, buf);
 }
 
+static int hostapd_cli_cmd_blacklist_load(struct wpa_ctrl *ctrl, int argc,
+					  char *argv[])
+{
+	char cmd[4096];
+	int i, res, len;
+
+	if (argc < 1) {
+		printf("Invalid 'blacklist_load' command - at least one argument, STA address, is required.\n");
+		return -1;
+	}
+
+	len = os_snprintf(cmd, sizeof(cmd), "BLACKLIST_LOAD");
+	for (i = 0; i < argc; i++) {
+		res = os_snprintf(cmd + len, sizeof(cmd) - len, " %s", argv[i]);
+		if (os_snprintf_error(sizeof(cmd) - len, res)) {
+			printf("Too long BLACKLIST_LOAD command.\n");
+			return -1;
+		}
+		len += res;
+	}
+	return wpa_ctrl_command(ctrl, cmd);
+}
+
+static int hostapd_cli_cmd_blacklist_dump(struct wpa_ctrl *ctrl, int argc,
+					  char *argv[])
+{
+	if (argc > 1) {
+		printf("Invalid 'blacklist_dump' command - at most one argument, STA address, is allowed.\n");
+		return -1;
+	}
+
+	return hostapd_cli_dump_pages(ctrl, "BLACKLIST_DUMP",
+				      argc == 1 ? argv[0] : NULL, 0, NULL);
+}
+
 static int hostapd_cli_cmd_blacklist_rm_hostapd(struct wpa_ctrl *ctrl, int argc,
 					char *argv[])
 {
@@ -412,6 +533,12 @@ static int hostapd_cli_cmd_blacklist_clr_hostapd(struct wpa_ctrl *ctrl, int argc
 
 // END HOSTAPD BLACKLIST SUPPORT
 
+static int hostapd_cli_cmd_net_steering_stats(struct wpa_ctrl *ctrl, int argc,
+					      char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "NET_STEERING_STATS");
+}
+
 #ifdef CONFIG_IEEE80211W
 static int hostapd_cli_cmd_sa_query(struct wpa_ctrl *ctrl, int argc,
 				    char *argv[])
@@ -800,6 +927,13 @@ static int hostapd_cli_cmd_all_sta(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int hostapd_cli_cmd_sta_dump(struct wpa_ctrl *ctrl, int argc,
+				    char *argv[])
+{
+	return hostapd_cli_dump_pages(ctrl, "STA-DUMP", NULL, argc, argv);
+}
+
+
 static int hostapd_cli_cmd_help(struct wpa_ctrl *ctrl, int argc, char *argv[])
 {
 	printf("%s", commands_help);
@@ -1150,6 +1284,37 @@ static int hostapd_cli_cmd_log_level(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int hostapd_cli_cmd_event_filter(struct wpa_ctrl *ctrl, int argc,
+					char *argv[])
+{
+	char cmd[256], *pos, *end;
+	int i, res;
+
+	pos = cmd;
+	end = cmd + sizeof(cmd);
+	res = os_snprintf(pos, end - pos, "EVENT_FILTER");
+	if (os_snprintf_error(end - pos, res))
+		return -1;
+	pos += res;
+	for (i = 0; i < argc; i++) {
+		res = os_snprintf(pos, end - pos, " %s", argv[i]);
+		if (os_snprintf_error(end - pos, res)) {
+			printf("Too long EVENT_FILTER command.\n");
+			return -1;
+		}
+		pos += res;
+	}
+	return wpa_ctrl_command(ctrl, cmd);
+}
+
+
+static int hostapd_cli_cmd_monitors(struct wpa_ctrl *ctrl, int argc,
+				    char *argv[])
+{
+	return wpa_ctrl_command(ctrl, "MONITORS");
+}
+
+
 struct hostapd_cli_cmd {
 	const char *cmd;
 	int (*handler)(struct wpa_ctrl *ctrl, int argc, char *argv[]);
@@ -1162,6 +1327,7 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	{ "status", hostapd_cli_cmd_status },
 	{ "sta", hostapd_cli_cmd_sta },
 	{ "all_sta", hostapd_cli_cmd_all_sta },
+	{ "sta_dump", hostapd_cli_cmd_sta_dump },
 	{ "new_sta", hostapd_cli_cmd_new_sta },
 	{ "deauthenticate", hostapd_cli_cmd_deauthenticate },
 	{ "disassociate", hostapd_cli_cmd_disassociate },
@@ -1170,6 +1336,9 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	{ "blacklist_rm", hostapd_cli_cmd_blacklist_rm_hostapd },
 
 	{ "blacklist_show", hostapd_cli_cmd_blacklist_show },
+	{ "blacklist_load", hostapd_cli_cmd_blacklist_load },
+	{ "blacklist_dump", hostapd_cli_cmd_blacklist_dump },
+	{ "net_steering_stats", hostapd_cli_cmd_net_steering_stats },
 	{ "blacklist_clr", hostapd_cli_cmd_blacklist_clr_hostapd },
 
 #ifdef CONFIG_IEEE80211W
@@ -1216,6 +1385,10 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	{ "disable", hostapd_cli_cmd_disable },
 	{ "erp_flush", hostapd_cli_cmd_erp_flush },
 	{ "log_level", hostapd_cli_cmd_log_level },
+	{ "eloop_stats", hostapd_cli_cmd_eloop_stats },
+	{ "cmd_stats", hostapd_cli_cmd_cmd_stats },
+	{ "event_filter", hostapd_cli_cmd_event_filter },
+	{ "monitors", hostapd_cli_cmd_monitors },
 	{ NULL, NULL }
 };
 
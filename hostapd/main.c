@@ -24,6 +24,9 @@
 #include "ap/hostapd.h"
 #include "ap/ap_config.h"
 #include "ap/ap_drv_ops.h"
+#include "ap/psk_derive.h"
+#include "ap/sae_async.h"
+#include "ap/steering.h"
 #include "fst/fst.h"
 #include "config_file.h"
 #include "eap_register.h"
@@ -40,6 +43,7 @@ static struct hapd_global global;
 char *steering_path = NULL;
 int steering_rsi_threshold = -60;
 char *steering_target_interface = NULL;
+int steering_export_files = 0;
 
 
 #ifndef CONFIG_NO_HOSTAPD_LOGGER
@@ -390,6 +394,13 @@ static void hostapd_global_deinit(const char *pid_file)
 
 	random_deinit();
 
+	bandsteer_deinit();
+
+	psk_derive_deinit();
+#ifdef CONFIG_SAE
+	sae_async_deinit();
+#endif /* CONFIG_SAE */
+
 	eloop_destroy();
 
 #ifndef CONFIG_NATIVE_WINDOWS
@@ -475,6 +486,7 @@ static void usage(void)
 		"   -S   start all the interfaces synchronously\n"
 		"   -t   include timestamps in some debug messages\n"
 		"   -l   log band steering timestamps in this directory\n"
+		"   -L   also export band steering timestamps as files\n"
 		"   -r   steering rsi threshold (dbm), dflt=-60\n"
 		"   -s   steering target interface name\n"
 		"   -v   show hostapd version\n");
@@ -608,7 +620,7 @@ int main(int argc, char *argv[])
 	interfaces.global_ctrl_dst = NULL;
 
 	for (;;) {
-		c = getopt(argc, argv, "b:Bde:f:hKP:Ttu:vg:G:s:l:r:S");
+		c = getopt(argc, argv, "b:Bde:f:hKP:Ttu:vg:G:s:l:Lr:S");
 		if (c < 0)
 			break;
 		switch (c) {
@@ -675,6 +687,9 @@ int main(int argc, char *argv[])
 		case 'l':
 			steering_path = optarg;
 			break;
+		case 'L':
+			steering_export_files = 1;
+			break;
 		case 's':
 			steering_target_interface = optarg;
 			break;
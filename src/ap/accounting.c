@@ -27,8 +27,43 @@
  * input/output octets and updates Acct-{Input,Output}-Gigawords. */
 #define ACCT_DEFAULT_UPDATE_INTERVAL 300
 
-static void accounting_sta_interim(struct hostapd_data *hapd,
-				   struct sta_info *sta);
+/* Number of one second slots in the interim update timing wheel. A station is
+ * kept in the slot of its next update time modulo the wheel size; stations
+ * due on a later revolution of the wheel are skipped when the slot is
+ * processed. */
+#define ACCT_WHEEL_SLOTS 256
+
+/* Minimum number of stations processed in the same tick for reading the
+ * driver counters of all stations with a single request. */
+#define ACCT_BULK_READ_MIN 4
+
+/**
+ * struct hostapd_acct_sched - Interim accounting update scheduler
+ *
+ * Interim updates (and the driver counter polls used to detect wrap arounds
+ * when interim accounting is not used) are driven by a single one second
+ * timer per BSS. Stations that are due are moved in order into the due list
+ * and processed from there as long as the RADIUS client accounting backlog is
+ * below radius_acct_queue_limit.
+ */
+struct hostapd_acct_sched {
+	struct dl_list wheel[ACCT_WHEEL_SLOTS];
+	struct dl_list due; /* stations due for an update, in order */
+	os_time_t next_tick; /* next wheel slot (os_reltime seconds) */
+	unsigned int num_stas;
+	unsigned int num_due;
+	int stalled; /* waiting for the accounting backlog to drain */
+
+	unsigned int interim_updates;
+	unsigned int counter_polls;
+	unsigned int bulk_reads;
+	unsigned int sta_reads;
+	unsigned int stalls;
+};
+
+static void accounting_sta_report(struct hostapd_data *hapd,
+				  struct sta_info *sta, int stop,
+				  struct hostap_sta_driver_data *stats);
 
 
 static struct radius_msg * accounting_msg(struct hostapd_data *hapd,
@@ -157,13 +192,10 @@ static struct radius_msg * accounting_msg(struct hostapd_data *hapd,
 }
 
 
-static int accounting_sta_update_stats(struct hostapd_data *hapd,
+static void accounting_sta_apply_stats(struct hostapd_data *hapd,
 				       struct sta_info *sta,
 				       struct hostap_sta_driver_data *data)
 {
-	if (hostapd_drv_read_sta_data(hapd, data, sta->addr))
-		return -1;
-
 	if (sta->last_rx_bytes > data->rx_bytes)
 		sta->acct_input_gigawords++;
 	if (sta->last_tx_bytes > data->tx_bytes)
@@ -177,28 +209,267 @@ static int accounting_sta_update_stats(struct hostapd_data *hapd,
 		       "Acct-Output-Octets=%lu Acct-Output-Gigawords=%u",
 		       sta->last_rx_bytes, sta->acct_input_gigawords,
 		       sta->last_tx_bytes, sta->acct_output_gigawords);
+}
+
+
+static int accounting_sta_update_stats(struct hostapd_data *hapd,
+				       struct sta_info *sta,
+				       struct hostap_sta_driver_data *data)
+{
+	if (hapd->acct_sched)
+		hapd->acct_sched->sta_reads++;
+
+	if (hostapd_drv_read_sta_data(hapd, data, sta->addr))
+		return -1;
+
+	accounting_sta_apply_stats(hapd, sta, data);
 
 	return 0;
 }
 
 
-static void accounting_interim_update(void *eloop_ctx, void *timeout_ctx)
+static void accounting_tick(void *eloop_ctx, void *timeout_ctx);
+static void accounting_resume(void *eloop_ctx, void *timeout_ctx);
+
+
+static struct hostapd_acct_sched * accounting_sched_get(
+	struct hostapd_data *hapd)
 {
-	struct hostapd_data *hapd = eloop_ctx;
-	struct sta_info *sta = timeout_ctx;
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+	int i;
+
+	if (sched)
+		return sched;
+
+	sched = os_zalloc(sizeof(*sched));
+	if (sched == NULL)
+		return NULL;
+	for (i = 0; i < ACCT_WHEEL_SLOTS; i++)
+		dl_list_init(&sched->wheel[i]);
+	dl_list_init(&sched->due);
+	hapd->acct_sched = sched;
+
+	return sched;
+}
+
+
+static void accounting_sched_deinit(struct hostapd_data *hapd)
+{
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+	struct sta_info *sta, *n;
+	int i;
+
+	if (sched == NULL)
+		return;
+
+	eloop_cancel_timeout(accounting_tick, hapd, NULL);
+	eloop_cancel_timeout(accounting_resume, hapd, NULL);
+	for (i = 0; i < ACCT_WHEEL_SLOTS; i++) {
+		dl_list_for_each_safe(sta, n, &sched->wheel[i],
+				      struct sta_info, acct_list)
+			dl_list_del(&sta->acct_list);
+	}
+	dl_list_for_each_safe(sta, n, &sched->due, struct sta_info, acct_list)
+		dl_list_del(&sta->acct_list);
+	os_free(sched);
+	hapd->acct_sched = NULL;
+}
+
+
+static void accounting_sched_insert(struct hostapd_acct_sched *sched,
+				    struct sta_info *sta, os_time_t when)
+{
+	/* Stations in the wheel are never due before next_tick while the ones
+	 * in the due list have passed their slot. */
+	if (when < sched->next_tick)
+		when = sched->next_tick;
+	sta->acct_next_update = when;
+	dl_list_add_tail(&sched->wheel[when % ACCT_WHEEL_SLOTS],
+			 &sta->acct_list);
+}
+
+
+static void accounting_sched_add(struct hostapd_data *hapd,
+				 struct sta_info *sta, os_time_t when)
+{
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+
+	if (sched->num_stas++ == 0) {
+		struct os_reltime now;
+
+		os_get_reltime(&now);
+		sched->next_tick = now.sec;
+		eloop_register_timeout(1, 0, accounting_tick, hapd, NULL);
+	}
+	accounting_sched_insert(sched, sta, when);
+}
+
+
+static void accounting_sched_remove(struct hostapd_data *hapd,
+				    struct sta_info *sta)
+{
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+
+	if (sched == NULL || sta->acct_list.next == NULL)
+		return;
+
+	if (sta->acct_next_update < sched->next_tick)
+		sched->num_due--;
+	sta->acct_selected = 0;
+	dl_list_del(&sta->acct_list);
+	if (--sched->num_stas == 0)
+		eloop_cancel_timeout(accounting_tick, hapd, NULL);
+}
+
+
+static void accounting_sta_update(struct hostapd_data *hapd,
+				  struct sta_info *sta, os_time_t now,
+				  struct hostap_sta_driver_data *data)
+{
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+	struct hostap_sta_driver_data tmp;
+	os_time_t next;
 	int interval;
 
+	dl_list_del(&sta->acct_list);
+	sched->num_due--;
+	sta->acct_selected = 0;
+
 	if (sta->acct_interim_interval) {
-		accounting_sta_interim(hapd, sta);
+		if (sta->acct_session_started)
+			accounting_sta_report(hapd, sta, 0, data);
+		sched->interim_updates++;
 		interval = sta->acct_interim_interval;
 	} else {
-		struct hostap_sta_driver_data data;
-		accounting_sta_update_stats(hapd, sta, &data);
+		if (data)
+			accounting_sta_apply_stats(hapd, sta, data);
+		else
+			accounting_sta_update_stats(hapd, sta, &tmp);
+		sched->counter_polls++;
 		interval = ACCT_DEFAULT_UPDATE_INTERVAL;
 	}
 
-	eloop_register_timeout(interval, 0, accounting_interim_update,
-			       hapd, sta);
+	/* Keep the phase of the station unless it was delayed by more than a
+	 * full interval. */
+	next = sta->acct_next_update + interval;
+	if (next <= now)
+		next = now + interval;
+	accounting_sched_insert(sched, sta, next);
+}
+
+
+struct accounting_bulk_ctx {
+	struct hostapd_data *hapd;
+	os_time_t now;
+};
+
+
+static void accounting_bulk_cb(void *ctx, const u8 *addr,
+			       struct hostap_sta_driver_data *data)
+{
+	struct accounting_bulk_ctx *bulk = ctx;
+	struct sta_info *sta;
+
+	sta = ap_get_sta(bulk->hapd, addr);
+	/* Only stations selected for this tick are updated */
+	if (sta == NULL || !sta->acct_selected)
+		return;
+
+	accounting_sta_update(bulk->hapd, sta, bulk->now, data);
+}
+
+
+static void accounting_process_due(struct hostapd_data *hapd, os_time_t now)
+{
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+	struct accounting_bulk_ctx bulk;
+	struct sta_info *sta, *n;
+	unsigned int limit = hapd->conf->radius_acct_queue_limit;
+	size_t pending = radius_client_acct_pending(hapd->radius);
+	unsigned int selected = 0;
+
+	sched->stalled = 0;
+
+	/*
+	 * Select stations from the head of the due list while the RADIUS
+	 * client accounting backlog allows more interim updates to be sent.
+	 * The rest keep their place in the list for the following ticks.
+	 */
+	dl_list_for_each(sta, &sched->due, struct sta_info, acct_list) {
+		if (sta->acct_interim_interval && sta->acct_session_started &&
+		    hapd->conf->radius->acct_server) {
+			if (limit && pending >= limit) {
+				sched->stalled = 1;
+				sched->stalls++;
+				break;
+			}
+			pending++;
+		}
+		sta->acct_selected = 1;
+		selected++;
+	}
+	if (selected == 0)
+		return;
+
+	if (selected >= ACCT_BULK_READ_MIN) {
+		bulk.hapd = hapd;
+		bulk.now = now;
+		if (hostapd_drv_read_all_sta_data(hapd, accounting_bulk_cb,
+						  &bulk) == 0)
+			sched->bulk_reads++;
+	}
+
+	/* Stations not reported by the driver in a bulk read */
+	dl_list_for_each_safe(sta, n, &sched->due, struct sta_info,
+			      acct_list) {
+		if (!sta->acct_selected)
+			break;
+		accounting_sta_update(hapd, sta, now, NULL);
+	}
+}
+
+
+static void accounting_resume(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	accounting_process_due(hapd, now.sec);
+}
+
+
+static void accounting_tick(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+	struct sta_info *sta, *n;
+	struct os_reltime now;
+	struct dl_list *slot;
+
+	os_get_reltime(&now);
+
+	/* All slots are covered by one revolution even if the event loop was
+	 * blocked for longer than that. */
+	if (now.sec - sched->next_tick >= ACCT_WHEEL_SLOTS)
+		sched->next_tick = now.sec - ACCT_WHEEL_SLOTS + 1;
+	while (sched->next_tick <= now.sec) {
+		slot = &sched->wheel[sched->next_tick % ACCT_WHEEL_SLOTS];
+		dl_list_for_each_safe(sta, n, slot, struct sta_info,
+				      acct_list) {
+			if (sta->acct_next_update > now.sec)
+				continue;
+			dl_list_del(&sta->acct_list);
+			dl_list_add_tail(&sched->due, &sta->acct_list);
+			sched->num_due++;
+		}
+		sched->next_tick++;
+	}
+
+	accounting_process_due(hapd, now.sec);
+
+	if (sched->num_stas)
+		eloop_register_timeout(1, 0, accounting_tick, hapd, NULL);
 }
 
 
@@ -210,6 +481,7 @@ static void accounting_interim_update(void *eloop_ctx, void *timeout_ctx)
 void accounting_sta_start(struct hostapd_data *hapd, struct sta_info *sta)
 {
 	struct radius_msg *msg;
+	struct os_reltime now;
 	int interval;
 
 	if (sta->acct_session_started)
@@ -232,8 +504,13 @@ void accounting_sta_start(struct hostapd_data *hapd, struct sta_info *sta)
 		interval = sta->acct_interim_interval;
 	else
 		interval = ACCT_DEFAULT_UPDATE_INTERVAL;
-	eloop_register_timeout(interval, 0, accounting_interim_update,
-			       hapd, sta);
+	if (accounting_sched_get(hapd) && sta->acct_list.next == NULL) {
+		/* Spread the updates over the interval instead of aligning
+		 * them to the association time of each station. */
+		os_get_reltime(&now);
+		accounting_sched_add(hapd, sta, now.sec + interval / 2 +
+				     os_random() % interval);
+	}
 
 	msg = accounting_msg(hapd, sta, RADIUS_ACCT_STATUS_TYPE_START);
 	if (msg &&
@@ -245,7 +522,8 @@ void accounting_sta_start(struct hostapd_data *hapd, struct sta_info *sta)
 
 
 static void accounting_sta_report(struct hostapd_data *hapd,
-				  struct sta_info *sta, int stop)
+				  struct sta_info *sta, int stop,
+				  struct hostap_sta_driver_data *stats)
 {
 	struct radius_msg *msg;
 	int cause = sta->acct_terminate_cause;
@@ -274,28 +552,33 @@ static void accounting_sta_report(struct hostapd_data *hapd,
 		goto fail;
 	}
 
-	if (accounting_sta_update_stats(hapd, sta, &data) == 0) {
+	if (stats)
+		accounting_sta_apply_stats(hapd, sta, stats);
+	else if (accounting_sta_update_stats(hapd, sta, &data) == 0)
+		stats = &data;
+
+	if (stats) {
 		if (!radius_msg_add_attr_int32(msg,
 					       RADIUS_ATTR_ACCT_INPUT_PACKETS,
-					       data.rx_packets)) {
+					       stats->rx_packets)) {
 			wpa_printf(MSG_INFO, "Could not add Acct-Input-Packets");
 			goto fail;
 		}
 		if (!radius_msg_add_attr_int32(msg,
 					       RADIUS_ATTR_ACCT_OUTPUT_PACKETS,
-					       data.tx_packets)) {
+					       stats->tx_packets)) {
 			wpa_printf(MSG_INFO, "Could not add Acct-Output-Packets");
 			goto fail;
 		}
 		if (!radius_msg_add_attr_int32(msg,
 					       RADIUS_ATTR_ACCT_INPUT_OCTETS,
-					       data.rx_bytes)) {
+					       stats->rx_bytes)) {
 			wpa_printf(MSG_INFO, "Could not add Acct-Input-Octets");
 			goto fail;
 		}
 		gigawords = sta->acct_input_gigawords;
 #if __WORDSIZE == 64
-		gigawords += data.rx_bytes >> 32;
+		gigawords += stats->rx_bytes >> 32;
 #endif
 		if (gigawords &&
 		    !radius_msg_add_attr_int32(
@@ -306,13 +589,13 @@ static void accounting_sta_report(struct hostapd_data *hapd,
 		}
 		if (!radius_msg_add_attr_int32(msg,
 					       RADIUS_ATTR_ACCT_OUTPUT_OCTETS,
-					       data.tx_bytes)) {
+					       stats->tx_bytes)) {
 			wpa_printf(MSG_INFO, "Could not add Acct-Output-Octets");
 			goto fail;
 		}
 		gigawords = sta->acct_output_gigawords;
 #if __WORDSIZE == 64
-		gigawords += data.tx_bytes >> 32;
+		gigawords += stats->tx_bytes >> 32;
 #endif
 		if (gigawords &&
 		    !radius_msg_add_attr_int32(
@@ -350,19 +633,6 @@ static void accounting_sta_report(struct hostapd_data *hapd,
 }
 
 
-/**
- * accounting_sta_interim - Send a interim STA accounting report
- * @hapd: hostapd BSS data
- * @sta: The station
- */
-static void accounting_sta_interim(struct hostapd_data *hapd,
-				   struct sta_info *sta)
-{
-	if (sta->acct_session_started)
-		accounting_sta_report(hapd, sta, 0);
-}
-
-
 /**
  * accounting_sta_stop - Stop STA accounting
  * @hapd: hostapd BSS data
@@ -371,8 +641,8 @@ static void accounting_sta_interim(struct hostapd_data *hapd,
 void accounting_sta_stop(struct hostapd_data *hapd, struct sta_info *sta)
 {
 	if (sta->acct_session_started) {
-		accounting_sta_report(hapd, sta, 1);
-		eloop_cancel_timeout(accounting_interim_update, hapd, sta);
+		accounting_sta_report(hapd, sta, 1, NULL);
+		accounting_sched_remove(hapd, sta);
 		hostapd_logger(hapd, sta->addr, HOSTAPD_MODULE_RADIUS,
 			       HOSTAPD_LEVEL_INFO,
 			       "stopped accounting session %08X-%08X",
@@ -408,6 +678,9 @@ accounting_receive(struct radius_msg *msg, struct radius_msg *req,
 		   const u8 *shared_secret, size_t shared_secret_len,
 		   void *data)
 {
+	struct hostapd_data *hapd = data;
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+
 	if (radius_msg_get_hdr(msg)->code != RADIUS_CODE_ACCOUNTING_RESPONSE) {
 		wpa_printf(MSG_INFO, "Unknown RADIUS message code");
 		return RADIUS_RX_UNKNOWN;
@@ -418,6 +691,15 @@ accounting_receive(struct radius_msg *msg, struct radius_msg *req,
 		return RADIUS_RX_INVALID_AUTHENTICATOR;
 	}
 
+	/* Continue with the stations that were left waiting once the backlog
+	 * has drained to half of the limit. */
+	if (sched && sched->stalled &&
+	    radius_client_acct_pending(hapd->radius) <=
+	    hapd->conf->radius_acct_queue_limit / 2) {
+		sched->stalled = 0;
+		eloop_register_timeout(0, 0, accounting_resume, hapd, NULL);
+	}
+
 	return RADIUS_RX_PROCESSED;
 }
 
@@ -485,4 +767,40 @@ int accounting_init(struct hostapd_data *hapd)
 void accounting_deinit(struct hostapd_data *hapd)
 {
 	accounting_report_state(hapd, 0);
+	accounting_sched_deinit(hapd);
+}
+
+
+/**
+ * accounting_get_mib - Get interim accounting scheduler statistics
+ * @hapd: hostapd BSS data
+ * @buf: Buffer for returning MIB data in text format
+ * @buflen: Maximum buf length in octets
+ * Returns: Number of octets written into the buffer
+ */
+int accounting_get_mib(struct hostapd_data *hapd, char *buf, size_t buflen)
+{
+	struct hostapd_acct_sched *sched = hapd->acct_sched;
+	int ret;
+
+	if (sched == NULL)
+		return 0;
+
+	ret = os_snprintf(buf, buflen,
+			  "radiusAcctScheduledStations=%u\n"
+			  "radiusAcctDueStations=%u\n"
+			  "radiusAcctInterimUpdates=%u\n"
+			  "radiusAcctCounterPolls=%u\n"
+			  "radiusAcctBulkReads=%u\n"
+			  "radiusAcctStaReads=%u\n"
+			  "radiusAcctBackpressureStalls=%u\n"
+			  "radiusAcctPendingRequests=%u\n",
+			  sched->num_stas, sched->num_due,
+			  sched->interim_updates, sched->counter_polls,
+			  sched->bulk_reads, sched->sta_reads, sched->stalls,
+			  (unsigned int)
+			  radius_client_acct_pending(hapd->radius));
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
 }
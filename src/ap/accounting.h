@@ -33,12 +33,19 @@ static inline int accounting_init(struct hostapd_data *hapd)
 static inline void accounting_deinit(struct hostapd_data *hapd)
 {
 }
+
+static inline int accounting_get_mib(struct hostapd_data *hapd, char *buf,
+				     size_t buflen)
+{
+	return 0;
+}
 #else /* CONFIG_NO_ACCOUNTING */
 void accounting_sta_get_id(struct hostapd_data *hapd, struct sta_info *sta);
 void accounting_sta_start(struct hostapd_data *hapd, struct sta_info *sta);
 void accounting_sta_stop(struct hostapd_data *hapd, struct sta_info *sta);
 int accounting_init(struct hostapd_data *hapd);
 void accounting_deinit(struct hostapd_data *hapd);
+int accounting_get_mib(struct hostapd_data *hapd, char *buf, size_t buflen);
 #endif /* CONFIG_NO_ACCOUNTING */
 
 #endif /* ACCOUNTING_H */
@@ -0,0 +1,13 @@
+# Build options of libap.a. Programs that use the AP data structures from
+# libap.a directly (tests/test-ap-*.c and tests/ap-bench) include this file
+# so that they are compiled with the same structure layouts.
+AP_CFLAGS = -DHOSTAPD
+AP_CFLAGS += -DNEED_AP_MLME
+AP_CFLAGS += -DCONFIG_HS20
+AP_CFLAGS += -DCONFIG_INTERWORKING
+AP_CFLAGS += -DCONFIG_IEEE80211R
+AP_CFLAGS += -DCONFIG_IEEE80211W
+AP_CFLAGS += -DCONFIG_WPS
+AP_CFLAGS += -DCONFIG_PROXYARP
+AP_CFLAGS += -DCONFIG_IAPP
+AP_CFLAGS += -DCONFIG_CLIENT_TAXONOMY
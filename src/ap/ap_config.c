@@ -9,7 +9,6 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
-#include "crypto/sha1.h"
 #include "radius/radius_client.h"
 #include "common/ieee802_11_defs.h"
 #include "common/eapol_common.h"
@@ -18,6 +17,7 @@
 #include "wpa_auth.h"
 #include "sta_info.h"
 #include "ap_config.h"
+#include "psk_derive.h"
 
 
 static void hostapd_config_free_vlan(struct hostapd_bss_config *bss)
@@ -63,6 +63,9 @@ void hostapd_config_defaults_bss(struct hostapd_bss_config *bss)
 	bss->dtim_period = 2;
 
 	bss->radius_server_auth_port = 1812;
+	bss->radius_acl_timeout = 30;
+	bss->radius_acl_negative_timeout = 30;
+	bss->radius_acct_queue_limit = 256;
 	bss->ap_max_inactivity = AP_MAX_INACTIVITY;
 	bss->eapol_version = EAPOL_VERSION;
 
@@ -272,8 +275,9 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 		if (len == 64 && hexstr2bin(pos, psk->psk, PMK_LEN) == 0)
 			ok = 1;
 		else if (len >= 8 && len < 64) {
-			pbkdf2_sha1(pos, ssid->ssid, ssid->ssid_len,
-				    4096, psk->psk, PMK_LEN);
+			/* Completed by psk_derive_flush() below */
+			psk_derive_start(pos, ssid->ssid, ssid->ssid_len,
+					 psk->psk, NULL, ssid);
 			ok = 1;
 		}
 		if (!ok) {
@@ -289,6 +293,7 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 	}
 
 	fclose(f);
+	psk_derive_flush(ssid);
 
 	return ret;
 }
@@ -306,9 +311,8 @@ static int hostapd_derive_psk(struct hostapd_ssid *ssid)
 	wpa_hexdump_ascii_key(MSG_DEBUG, "PSK (ASCII passphrase)",
 			      (u8 *) ssid->wpa_passphrase,
 			      os_strlen(ssid->wpa_passphrase));
-	pbkdf2_sha1(ssid->wpa_passphrase,
-		    ssid->ssid, ssid->ssid_len,
-		    4096, ssid->wpa_psk->psk, PMK_LEN);
+	psk_derive(ssid->wpa_passphrase, ssid->ssid, ssid->ssid_len,
+		   ssid->wpa_psk->psk);
 	wpa_hexdump_key(MSG_DEBUG, "PSK (from passphrase)",
 			ssid->wpa_psk->psk, PMK_LEN);
 	return 0;
@@ -397,16 +401,17 @@ static void hostapd_config_free_wep(struct hostapd_wep_keys *keys)
 }
 
 
-void hostapd_config_clear_wpa_psk(struct hostapd_wpa_psk **l)
+void hostapd_config_clear_wpa_psk(struct hostapd_ssid *ssid)
 {
 	struct hostapd_wpa_psk *psk, *tmp;
 
-	for (psk = *l; psk;) {
+	hostapd_wpa_psk_index_free(ssid);
+	for (psk = ssid->wpa_psk; psk;) {
 		tmp = psk;
 		psk = psk->next;
 		bin_clear_free(tmp, sizeof(*tmp));
 	}
-	*l = NULL;
+	ssid->wpa_psk = NULL;
 }
 
 
@@ -417,7 +422,7 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 	if (conf == NULL)
 		return;
 
-	hostapd_config_clear_wpa_psk(&conf->ssid.wpa_psk);
+	hostapd_config_clear_wpa_psk(&conf->ssid);
 
 	str_clear_free(conf->ssid.wpa_passphrase);
 	os_free(conf->ssid.wpa_psk_file);
@@ -489,6 +494,10 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 	}
 #endif /* CONFIG_IEEE80211R */
 
+#ifdef CONFIG_NET_STEERING
+	os_free(conf->net_steeering_mode);
+#endif /* CONFIG_NET_STEERING */
+
 #ifdef CONFIG_WPS
 	os_free(conf->wps_pin_requests);
 	os_free(conf->device_name);
@@ -674,23 +683,245 @@ const char * hostapd_get_vlan_id_ifname(struct hostapd_vlan *vlan, int vlan_id)
 }
 
 
-const u8 * hostapd_get_psk(const struct hostapd_bss_config *conf,
-			   const u8 *addr, const u8 *p2p_dev_addr,
-			   const u8 *prev_psk)
+/* Number of direct mapped MAC address to PSK affinity cache slots */
+#define WPA_PSK_AFFINITY_SIZE 1024
+
+struct hostapd_wpa_psk_affinity {
+	u8 addr[ETH_ALEN];
+	u8 p2p;
+	struct hostapd_wpa_psk *psk;
+};
+
+/*
+ * Lookup index for ssid->wpa_psk. Station specific PSKs are sorted by address
+ * for binary search and PSKs for any station are kept in list order. The
+ * affinity cache remembers which PSK each station used last time, so that it
+ * can be tried first.
+ */
+struct hostapd_wpa_psk_index {
+	const struct hostapd_wpa_psk *head; /* list the index was built for */
+	struct hostapd_wpa_psk **by_addr;
+	struct hostapd_wpa_psk **by_p2p_dev_addr;
+	size_t num_sta;
+	struct hostapd_wpa_psk **group;
+	size_t num_group;
+	u8 hash_key[16];
+	struct hostapd_wpa_psk_affinity affinity[WPA_PSK_AFFINITY_SIZE];
+
+	/* Previously returned PSK for continuing the search in order */
+	struct {
+		u8 addr[ETH_ALEN];
+		int p2p;
+		struct hostapd_wpa_psk *psk;
+		size_t pos;
+	} last;
+};
+
+/* Candidate PSKs for one station */
+struct hostapd_wpa_psk_search {
+	struct hostapd_wpa_psk *first; /* from the affinity cache */
+	struct hostapd_wpa_psk **sta;
+	size_t num_sta;
+};
+
+
+/* Station specific PSK with its position in ssid->wpa_psk for sorting */
+struct hostapd_wpa_psk_pos {
+	struct hostapd_wpa_psk *psk;
+	size_t pos;
+};
+
+
+static int hostapd_wpa_psk_addr_cmp(const void *a, const void *b)
+{
+	const struct hostapd_wpa_psk_pos *pa = a, *pb = b;
+	int res = os_memcmp(pa->psk->addr, pb->psk->addr, ETH_ALEN);
+
+	/* Keep the list order for the same address */
+	if (res == 0)
+		res = pa->pos < pb->pos ? -1 : (pa->pos > pb->pos);
+	return res;
+}
+
+
+static int hostapd_wpa_psk_p2p_cmp(const void *a, const void *b)
+{
+	const struct hostapd_wpa_psk_pos *pa = a, *pb = b;
+	int res = os_memcmp(pa->psk->p2p_dev_addr, pb->psk->p2p_dev_addr,
+			    ETH_ALEN);
+
+	if (res == 0)
+		res = pa->pos < pb->pos ? -1 : (pa->pos > pb->pos);
+	return res;
+}
+
+
+static void hostapd_wpa_psk_sort(struct hostapd_wpa_psk **sorted,
+				 struct hostapd_wpa_psk_pos *tmp, size_t num,
+				 int (*cmp)(const void *a, const void *b))
+{
+	size_t i;
+
+	for (i = 0; i < num; i++) {
+		tmp[i].psk = sorted[i];
+		tmp[i].pos = i;
+	}
+	qsort(tmp, num, sizeof(*tmp), cmp);
+	for (i = 0; i < num; i++)
+		sorted[i] = tmp[i].psk;
+}
+
+
+void hostapd_wpa_psk_index_free(struct hostapd_ssid *ssid)
 {
+	struct hostapd_wpa_psk_index *idx = ssid->wpa_psk_index;
+
+	if (idx == NULL)
+		return;
+	os_free(idx->by_addr);
+	os_free(idx->by_p2p_dev_addr);
+	os_free(idx->group);
+	os_free(idx);
+	ssid->wpa_psk_index = NULL;
+}
+
+
+static struct hostapd_wpa_psk_index *
+hostapd_wpa_psk_index_get(struct hostapd_ssid *ssid)
+{
+	struct hostapd_wpa_psk_index *idx = ssid->wpa_psk_index;
 	struct hostapd_wpa_psk *psk;
-	int next_ok = prev_psk == NULL;
+	struct hostapd_wpa_psk_pos *tmp = NULL;
+	size_t num = 0;
+
+	/*
+	 * The list is modified in place when PSKs are added at runtime, e.g.,
+	 * by WPS, so an index for another list head is rebuilt.
+	 */
+	if (idx && idx->head == ssid->wpa_psk)
+		return idx;
+	hostapd_wpa_psk_index_free(ssid);
+
+	for (psk = ssid->wpa_psk; psk; psk = psk->next)
+		num++;
+
+	idx = os_zalloc(sizeof(*idx));
+	if (idx == NULL)
+		return NULL;
+	idx->head = ssid->wpa_psk;
+	if (num) {
+		idx->by_addr = os_calloc(num, sizeof(*idx->by_addr));
+		idx->by_p2p_dev_addr = os_calloc(num,
+						 sizeof(*idx->by_p2p_dev_addr));
+		idx->group = os_calloc(num, sizeof(*idx->group));
+		tmp = os_calloc(num, sizeof(*tmp));
+		if (idx->by_addr == NULL || idx->by_p2p_dev_addr == NULL ||
+		    idx->group == NULL || tmp == NULL) {
+			os_free(idx->by_addr);
+			os_free(idx->by_p2p_dev_addr);
+			os_free(idx->group);
+			os_free(idx);
+			os_free(tmp);
+			return NULL;
+		}
+	}
+	os_get_random(idx->hash_key, sizeof(idx->hash_key));
 
-	if (p2p_dev_addr && !is_zero_ether_addr(p2p_dev_addr)) {
-		wpa_printf(MSG_DEBUG, "Searching a PSK for " MACSTR
-			   " p2p_dev_addr=" MACSTR " prev_psk=%p",
-			   MAC2STR(addr), MAC2STR(p2p_dev_addr), prev_psk);
-		addr = NULL; /* Use P2P Device Address for matching */
-	} else {
-		wpa_printf(MSG_DEBUG, "Searching a PSK for " MACSTR
-			   " prev_psk=%p",
-			   MAC2STR(addr), prev_psk);
+	for (psk = ssid->wpa_psk; psk; psk = psk->next) {
+		if (psk->group) {
+			idx->group[idx->num_group++] = psk;
+		} else {
+			idx->by_addr[idx->num_sta] = psk;
+			idx->by_p2p_dev_addr[idx->num_sta] = psk;
+			idx->num_sta++;
+		}
 	}
+	hostapd_wpa_psk_sort(idx->by_addr, tmp, idx->num_sta,
+			     hostapd_wpa_psk_addr_cmp);
+	hostapd_wpa_psk_sort(idx->by_p2p_dev_addr, tmp, idx->num_sta,
+			     hostapd_wpa_psk_p2p_cmp);
+	os_free(tmp);
+
+	ssid->wpa_psk_index = idx;
+	return idx;
+}
+
+
+static struct hostapd_wpa_psk_affinity *
+hostapd_wpa_psk_affinity(struct hostapd_wpa_psk_index *idx, const u8 *addr)
+{
+	return &idx->affinity[hwaddr_hash(idx->hash_key, addr) &
+			      (WPA_PSK_AFFINITY_SIZE - 1)];
+}
+
+
+static void hostapd_wpa_psk_search_init(struct hostapd_wpa_psk_index *idx,
+					const u8 *addr, int p2p,
+					struct hostapd_wpa_psk_search *search)
+{
+	struct hostapd_wpa_psk_affinity *aff;
+	struct hostapd_wpa_psk **sorted;
+	size_t lo = 0, hi = idx->num_sta, mid;
+	size_t offset = p2p ? offsetof(struct hostapd_wpa_psk, p2p_dev_addr) :
+		offsetof(struct hostapd_wpa_psk, addr);
+
+	aff = hostapd_wpa_psk_affinity(idx, addr);
+	search->first = NULL;
+	if (aff->psk && aff->p2p == p2p &&
+	    os_memcmp(aff->addr, addr, ETH_ALEN) == 0)
+		search->first = aff->psk;
+
+	/* First entry for the address */
+	sorted = p2p ? idx->by_p2p_dev_addr : idx->by_addr;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (os_memcmp((u8 *) sorted[mid] + offset, addr, ETH_ALEN) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	search->sta = &sorted[lo];
+	search->num_sta = 0;
+	while (lo + search->num_sta < idx->num_sta &&
+	       os_memcmp((u8 *) sorted[lo + search->num_sta] + offset, addr,
+			 ETH_ALEN) == 0)
+		search->num_sta++;
+}
+
+
+/*
+ * Candidates are returned in the order: PSK from the affinity cache, PSKs for
+ * the station, PSKs for any station. The affinity cache entry is not returned
+ * again from its normal position.
+ */
+static struct hostapd_wpa_psk *
+hostapd_wpa_psk_search_get(struct hostapd_wpa_psk_index *idx,
+			   struct hostapd_wpa_psk_search *search, size_t *pos)
+{
+	struct hostapd_wpa_psk *psk;
+
+	for (;; (*pos)++) {
+		if (*pos == 0) {
+			psk = search->first;
+		} else if (*pos - 1 < search->num_sta) {
+			psk = search->sta[*pos - 1];
+		} else if (*pos - 1 - search->num_sta < idx->num_group) {
+			psk = idx->group[*pos - 1 - search->num_sta];
+		} else {
+			return NULL;
+		}
+		if (psk && (*pos == 0 || psk != search->first))
+			return psk;
+	}
+}
+
+
+static const u8 * hostapd_get_psk_list(const struct hostapd_bss_config *conf,
+				       const u8 *addr, const u8 *p2p_dev_addr,
+				       const u8 *prev_psk)
+{
+	struct hostapd_wpa_psk *psk;
+	int next_ok = prev_psk == NULL;
 
 	for (psk = conf->ssid.wpa_psk; psk != NULL; psk = psk->next) {
 		if (next_ok &&
@@ -709,6 +940,93 @@ const u8 * hostapd_get_psk(const struct hostapd_bss_config *conf,
 }
 
 
+const u8 * hostapd_get_psk(struct hostapd_bss_config *conf,
+			   const u8 *addr, const u8 *p2p_dev_addr,
+			   const u8 *prev_psk)
+{
+	struct hostapd_wpa_psk_index *idx;
+	struct hostapd_wpa_psk_search search;
+	struct hostapd_wpa_psk *psk;
+	const u8 *key = addr;
+	int p2p = 0;
+	size_t pos = 0;
+
+	if (p2p_dev_addr && !is_zero_ether_addr(p2p_dev_addr)) {
+		wpa_printf(MSG_DEBUG, "Searching a PSK for " MACSTR
+			   " p2p_dev_addr=" MACSTR " prev_psk=%p",
+			   MAC2STR(addr), MAC2STR(p2p_dev_addr), prev_psk);
+		addr = NULL; /* Use P2P Device Address for matching */
+		key = p2p_dev_addr;
+		p2p = 1;
+	} else {
+		wpa_printf(MSG_DEBUG, "Searching a PSK for " MACSTR
+			   " prev_psk=%p",
+			   MAC2STR(addr), prev_psk);
+	}
+
+	idx = hostapd_wpa_psk_index_get(&conf->ssid);
+	if (idx == NULL)
+		return hostapd_get_psk_list(conf, addr, p2p_dev_addr, prev_psk);
+
+	hostapd_wpa_psk_search_init(idx, key, p2p, &search);
+
+	if (prev_psk && idx->last.psk && idx->last.psk->psk == prev_psk &&
+	    idx->last.p2p == p2p &&
+	    os_memcmp(idx->last.addr, key, ETH_ALEN) == 0) {
+		/* Continue from the previously returned PSK */
+		pos = idx->last.pos + 1;
+	} else if (prev_psk) {
+		while ((psk = hostapd_wpa_psk_search_get(idx, &search, &pos))) {
+			pos++;
+			if (psk->psk == prev_psk)
+				break;
+		}
+		if (psk == NULL)
+			return NULL;
+	}
+
+	psk = hostapd_wpa_psk_search_get(idx, &search, &pos);
+	idx->last.psk = psk;
+	if (psk == NULL)
+		return NULL;
+	os_memcpy(idx->last.addr, key, ETH_ALEN);
+	idx->last.p2p = p2p;
+	idx->last.pos = pos;
+
+	return psk->psk;
+}
+
+
+void hostapd_wpa_psk_selected(struct hostapd_bss_config *conf,
+			      const u8 *addr, const u8 *p2p_dev_addr,
+			      const u8 *psk)
+{
+	struct hostapd_wpa_psk_index *idx = conf->ssid.wpa_psk_index;
+	struct hostapd_wpa_psk_affinity *aff;
+	const u8 *key = addr;
+	int p2p = 0;
+
+	if (p2p_dev_addr && !is_zero_ether_addr(p2p_dev_addr)) {
+		key = p2p_dev_addr;
+		p2p = 1;
+	}
+
+	/*
+	 * Only a PSK that hostapd_get_psk() just returned from the list is
+	 * remembered; PSKs from other sources (e.g., RADIUS) are not.
+	 */
+	if (idx == NULL || idx->head != conf->ssid.wpa_psk ||
+	    idx->last.psk == NULL || idx->last.psk->psk != psk ||
+	    idx->last.p2p != p2p || os_memcmp(idx->last.addr, key, ETH_ALEN))
+		return;
+
+	aff = hostapd_wpa_psk_affinity(idx, key);
+	os_memcpy(aff->addr, key, ETH_ALEN);
+	aff->p2p = p2p;
+	aff->psk = idx->last.psk;
+}
+
+
 static int hostapd_config_check_bss(struct hostapd_bss_config *bss,
 				    struct hostapd_config *conf,
 				    int full_config)
@@ -69,6 +69,7 @@ struct mac_acl_entry {
 struct hostapd_radius_servers;
 struct ft_remote_r0kh;
 struct ft_remote_r1kh;
+struct hostapd_wpa_psk_index;
 
 #define NUM_WEP_KEYS 4
 struct hostapd_wep_keys {
@@ -100,6 +101,8 @@ struct hostapd_ssid {
 	secpolicy security_policy;
 
 	struct hostapd_wpa_psk *wpa_psk;
+	/* Lookup index for wpa_psk; freed whenever entries are removed */
+	struct hostapd_wpa_psk_index *wpa_psk_index;
 	char *wpa_passphrase;
 	char *wpa_psk_file;
 
@@ -247,6 +250,7 @@ struct hostapd_bss_config {
 	char *nas_identifier;
 	struct hostapd_radius_servers *radius;
 	int acct_interim_interval;
+	unsigned int radius_acct_queue_limit; /* 0 = no limit */
 	int radius_request_cui;
 	struct hostapd_radius_attr *radius_auth_req_attr;
 	struct hostapd_radius_attr *radius_acct_req_attr;
@@ -285,6 +289,10 @@ struct hostapd_bss_config {
 	int num_accept_mac;
 	struct mac_acl_entry *deny_mac;
 	int num_deny_mac;
+	int radius_acl_timeout; /* lifetime of cached Access-Accept (seconds) */
+	int radius_acl_negative_timeout; /* lifetime of cached Access-Reject */
+#define RADIUS_ACL_CACHE_MAX_SIZE 1000000
+	unsigned int radius_acl_cache_size; /* max cached entries; 0 = no limit */
 	int wds_sta;
 	int isolate;
 	int start_disabled;
@@ -333,6 +341,10 @@ struct hostapd_bss_config {
 #ifdef CONFIG_NET_STEERING
 	/* can be "off", "suggest", or "force" */
 	char *net_steeering_mode;
+	/* coalesce flooded records into one frame per peer per flood tick */
+	int net_steering_batch;
+	/* L2 group address for flooding; all zeros = unicast to each R0KH */
+	u8 net_steering_group_addr[ETH_ALEN];
 #endif /* CONFIG_NET_STEERING */
 
 	char *ctrl_interface; /* directory for UNIX domain sockets */
@@ -573,6 +585,13 @@ struct hostapd_bss_config {
 
 	char *no_probe_resp_if_seen_on;
 	char *no_auth_if_seen_on;
+
+	/* Per-source Probe Response limits; 0 = disabled */
+#define PROBE_RESP_RATE_MAX 100000
+#define PROBE_RESP_DEDUP_WINDOW_MAX 60000
+	unsigned int probe_resp_rate; /* responses per second */
+	unsigned int probe_resp_burst;
+	unsigned int probe_resp_dedup_window; /* in milliseconds */
 };
 
 
@@ -608,6 +627,12 @@ struct hostapd_config {
 	unsigned int track_sta_max_num;
 	unsigned int track_sta_max_age;
 
+	/*
+	 * Probe Responses per second for all BSSs on the radio (0 = no limit,
+	 * at most PROBE_RESP_RATE_MAX)
+	 */
+	unsigned int probe_resp_max_rate;
+
 	char country[3]; /* first two octets: country code as described in
 			  * ISO/IEC 3166-1. Third octet:
 			  * ' ' (ascii 32): all environments
@@ -687,15 +712,19 @@ int hostapd_mac_comp_empty(const void *a);
 struct hostapd_config * hostapd_config_defaults(void);
 void hostapd_config_defaults_bss(struct hostapd_bss_config *bss);
 void hostapd_config_free_eap_user(struct hostapd_eap_user *user);
-void hostapd_config_clear_wpa_psk(struct hostapd_wpa_psk **p);
+void hostapd_config_clear_wpa_psk(struct hostapd_ssid *ssid);
 void hostapd_config_free_bss(struct hostapd_bss_config *conf);
 void hostapd_config_free(struct hostapd_config *conf);
 int hostapd_maclist_found(struct mac_acl_entry *list, int num_entries,
 			  const u8 *addr, int *vlan_id);
 int hostapd_rate_found(int *list, int rate);
-const u8 * hostapd_get_psk(const struct hostapd_bss_config *conf,
+const u8 * hostapd_get_psk(struct hostapd_bss_config *conf,
 			   const u8 *addr, const u8 *p2p_dev_addr,
 			   const u8 *prev_psk);
+void hostapd_wpa_psk_selected(struct hostapd_bss_config *conf,
+			      const u8 *addr, const u8 *p2p_dev_addr,
+			      const u8 *psk);
+void hostapd_wpa_psk_index_free(struct hostapd_ssid *ssid);
 int hostapd_setup_wpa_psk(struct hostapd_bss_config *conf);
 int hostapd_vlan_id_valid(struct hostapd_vlan *vlan, int vlan_id);
 const char * hostapd_get_vlan_id_ifname(struct hostapd_vlan *vlan,
@@ -50,11 +50,59 @@ static int ap_list_beacon_olbc(struct hostapd_iface *iface, struct ap_info *ap)
 }
 
 
+static unsigned int ap_ap_hash_idx(struct hostapd_iface *iface, const u8 *addr)
+{
+	return hwaddr_hash(iface->ap_hash_key, addr) & (iface->ap_hash_size - 1);
+}
+
+
+static int ap_ap_hash_resize(struct hostapd_iface *iface, unsigned int size)
+{
+	struct ap_info **old = iface->ap_hash, **hash, *ap, *next;
+	unsigned int i, old_size = iface->ap_hash_size, idx;
+
+	hash = os_calloc(size, sizeof(*hash));
+	if (hash == NULL)
+		return -1;
+	if (old == NULL &&
+	    os_get_random(iface->ap_hash_key, sizeof(iface->ap_hash_key)) < 0)
+		wpa_printf(MSG_DEBUG, "AP: Could not generate AP hash key");
+
+	iface->ap_hash = hash;
+	iface->ap_hash_size = size;
+	for (i = 0; i < old_size; i++) {
+		for (ap = old[i]; ap; ap = next) {
+			next = ap->hnext;
+			idx = ap_ap_hash_idx(iface, ap->addr);
+			ap->hnext = hash[idx];
+			hash[idx] = ap;
+		}
+	}
+	os_free(old);
+
+	return 0;
+}
+
+
+/* Make room for one more AP in the hash table */
+static int ap_ap_hash_reserve(struct hostapd_iface *iface)
+{
+	if (iface->ap_hash == NULL)
+		return ap_ap_hash_resize(iface, STA_HASH_MIN_SIZE);
+	if ((unsigned int) iface->num_ap >= iface->ap_hash_size)
+		ap_ap_hash_resize(iface, iface->ap_hash_size * 2);
+	/* A failed resize only makes the hash chains longer */
+	return 0;
+}
+
+
 static struct ap_info * ap_get_ap(struct hostapd_iface *iface, const u8 *ap)
 {
 	struct ap_info *s;
 
-	s = iface->ap_hash[STA_HASH(ap)];
+	if (iface->ap_hash == NULL)
+		return NULL;
+	s = iface->ap_hash[ap_ap_hash_idx(iface, ap)];
 	while (s != NULL && os_memcmp(s->addr, ap, ETH_ALEN) != 0)
 		s = s->hnext;
 	return s;
@@ -89,19 +137,25 @@ static void ap_ap_list_del(struct hostapd_iface *iface, struct ap_info *ap)
 
 static void ap_ap_hash_add(struct hostapd_iface *iface, struct ap_info *ap)
 {
-	ap->hnext = iface->ap_hash[STA_HASH(ap->addr)];
-	iface->ap_hash[STA_HASH(ap->addr)] = ap;
+	unsigned int idx = ap_ap_hash_idx(iface, ap->addr);
+
+	ap->hnext = iface->ap_hash[idx];
+	iface->ap_hash[idx] = ap;
 }
 
 
 static void ap_ap_hash_del(struct hostapd_iface *iface, struct ap_info *ap)
 {
 	struct ap_info *s;
+	unsigned int idx;
 
-	s = iface->ap_hash[STA_HASH(ap->addr)];
+	if (iface->ap_hash == NULL)
+		return;
+	idx = ap_ap_hash_idx(iface, ap->addr);
+	s = iface->ap_hash[idx];
 	if (s == NULL) return;
 	if (os_memcmp(s->addr, ap->addr, ETH_ALEN) == 0) {
-		iface->ap_hash[STA_HASH(ap->addr)] = s->hnext;
+		iface->ap_hash[idx] = s->hnext;
 		return;
 	}
 
@@ -146,6 +200,9 @@ static struct ap_info * ap_ap_add(struct hostapd_iface *iface, const u8 *addr)
 {
 	struct ap_info *ap;
 
+	if (ap_ap_hash_reserve(iface) < 0)
+		return NULL;
+
 	ap = os_zalloc(sizeof(struct ap_info));
 	if (ap == NULL)
 		return NULL;
@@ -309,4 +366,7 @@ int ap_list_init(struct hostapd_iface *iface)
 void ap_list_deinit(struct hostapd_iface *iface)
 {
 	hostapd_free_aps(iface);
+	os_free(iface->ap_hash);
+	iface->ap_hash = NULL;
+	iface->ap_hash_size = 0;
 }
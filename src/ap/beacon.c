@@ -13,6 +13,7 @@
 #ifndef CONFIG_NATIVE_WINDOWS
 
 #include "utils/common.h"
+#include "utils/eloop.h"
 #include "common/ieee802_11_defs.h"
 #include "common/ieee802_11_common.h"
 #include "common/hw_features_common.h"
@@ -521,6 +522,91 @@ static u8 * hostapd_gen_probe_resp(struct hostapd_data *hapd,
 }
 
 
+/**
+ * hostapd_probe_resp_tmpl_flush - Drop cached Probe Response templates
+ * @hapd: BSS data
+ *
+ * Must be called whenever any of the fields used by hostapd_gen_probe_resp()
+ * change. ieee802_11_set_beacon() does this, so anything that updates the
+ * Beacon frame also refreshes the Probe Response frame.
+ */
+void hostapd_probe_resp_tmpl_flush(struct hostapd_data *hapd)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(hapd->probe_resp_tmpl); i++) {
+		os_free(hapd->probe_resp_tmpl[i].buf);
+		os_memset(&hapd->probe_resp_tmpl[i], 0,
+			  sizeof(hapd->probe_resp_tmpl[i]));
+	}
+}
+
+
+static struct hostapd_probe_resp_tmpl *
+hostapd_probe_resp_tmpl_get(struct hostapd_data *hapd, int is_p2p)
+{
+	struct hostapd_probe_resp_tmpl *tmpl;
+	struct ieee80211_mgmt *resp;
+	const u8 *pos, *end;
+
+#ifdef CONFIG_P2P
+	is_p2p = is_p2p && (hapd->conf->p2p & P2P_ENABLED) &&
+		hapd->p2p_probe_resp_ie;
+#else /* CONFIG_P2P */
+	is_p2p = 0;
+#endif /* CONFIG_P2P */
+
+	tmpl = &hapd->probe_resp_tmpl[is_p2p];
+	if (tmpl->buf)
+		return tmpl;
+
+	tmpl->buf = hostapd_gen_probe_resp(hapd, NULL, is_p2p, &tmpl->len);
+	if (tmpl->buf == NULL)
+		return NULL;
+	tmpl->bss_load_off = 0;
+
+	/*
+	 * The BSS Load element reports the current station count, which
+	 * changes without a Beacon update, so remember where to patch it.
+	 */
+#ifdef CONFIG_TESTING_OPTIONS
+	if (hapd->conf->bss_load_test_set)
+		return tmpl;
+#endif /* CONFIG_TESTING_OPTIONS */
+	if (!hapd->conf->bss_load_update_period)
+		return tmpl;
+
+	resp = (struct ieee80211_mgmt *) tmpl->buf;
+	pos = resp->u.probe_resp.variable;
+	end = tmpl->buf + tmpl->len;
+	while (end - pos >= 2 && end - pos - 2 >= pos[1]) {
+		if (pos[0] == WLAN_EID_BSS_LOAD && pos[1] >= 5) {
+			tmpl->bss_load_off = pos + 2 - tmpl->buf;
+			break;
+		}
+		pos += 2 + pos[1];
+	}
+
+	return tmpl;
+}
+
+
+static void hostapd_probe_resp_tmpl_patch(struct hostapd_data *hapd,
+					  struct hostapd_probe_resp_tmpl *tmpl,
+					  const u8 *da)
+{
+	struct ieee80211_mgmt *resp = (struct ieee80211_mgmt *) tmpl->buf;
+
+	os_memcpy(resp->da, da, ETH_ALEN);
+	if (tmpl->bss_load_off) {
+		u8 *pos = tmpl->buf + tmpl->bss_load_off;
+
+		WPA_PUT_LE16(pos, hapd->num_sta);
+		pos[2] = hapd->iface->channel_utilization;
+	}
+}
+
+
 enum ssid_match_result {
 	NO_SSID_MATCH,
 	EXACT_SSID_MATCH,
@@ -561,6 +647,128 @@ static enum ssid_match_result ssid_match(struct hostapd_data *hapd,
 }
 
 
+static unsigned int sta_track_hash_idx(struct hostapd_iface *iface,
+				       const u8 *addr)
+{
+	return hwaddr_hash(iface->sta_seen_hash_key, addr) &
+		(iface->sta_seen_hash_size - 1);
+}
+
+
+static int sta_track_hash_resize(struct hostapd_iface *iface,
+				 unsigned int size)
+{
+	struct hostapd_sta_info **old = iface->sta_seen_hash, **hash;
+	struct hostapd_sta_info *info, *next;
+	unsigned int i, old_size = iface->sta_seen_hash_size, idx;
+
+	hash = os_calloc(size, sizeof(*hash));
+	if (hash == NULL)
+		return -1;
+	if (old == NULL &&
+	    os_get_random(iface->sta_seen_hash_key,
+			  sizeof(iface->sta_seen_hash_key)) < 0)
+		wpa_printf(MSG_DEBUG,
+			   "AP: Could not generate STA tracking hash key");
+
+	iface->sta_seen_hash = hash;
+	iface->sta_seen_hash_size = size;
+	for (i = 0; i < old_size; i++) {
+		for (info = old[i]; info; info = next) {
+			next = info->hnext;
+			idx = sta_track_hash_idx(iface, info->addr);
+			info->hnext = hash[idx];
+			hash[idx] = info;
+		}
+	}
+	os_free(old);
+
+	return 0;
+}
+
+
+/* Make room for one more STA tracking entry in the hash table */
+static int sta_track_hash_reserve(struct hostapd_iface *iface)
+{
+	if (iface->sta_seen_hash == NULL)
+		return sta_track_hash_resize(iface, STA_HASH_MIN_SIZE);
+	if (iface->num_sta_seen >= iface->sta_seen_hash_size)
+		sta_track_hash_resize(iface, iface->sta_seen_hash_size * 2);
+	/* A failed resize only makes the hash chains longer */
+	return 0;
+}
+
+
+static void sta_track_hash_del(struct hostapd_iface *iface,
+			       struct hostapd_sta_info *info)
+{
+	struct hostapd_sta_info **p;
+
+	if (iface->sta_seen_hash == NULL)
+		return;
+	for (p = &iface->sta_seen_hash[sta_track_hash_idx(iface, info->addr)];
+	     *p; p = &(*p)->hnext) {
+		if (*p == info) {
+			*p = info->hnext;
+			return;
+		}
+	}
+}
+
+
+static void sta_track_free(struct hostapd_iface *iface,
+			   struct hostapd_sta_info *info)
+{
+	sta_track_hash_del(iface, info);
+	dl_list_del(&info->list);
+	iface->num_sta_seen--;
+	os_free(info);
+}
+
+
+static void sta_track_expire_timeout(void *eloop_ctx, void *timeout_ctx);
+
+/*
+ * The sta_seen list is kept in last_seen order, so the entry at its head is
+ * always the next one to expire. A single timeout is armed for that entry
+ * instead of scanning the list; refreshing an entry only moves it to the
+ * tail, so a timeout that fires early simply re-arms for the new head.
+ */
+static void sta_track_schedule(struct hostapd_iface *iface)
+{
+	struct hostapd_sta_info *info;
+	struct os_reltime now, age;
+	unsigned int max_age = iface->conf->track_sta_max_age;
+	unsigned int sec, usec;
+
+	info = dl_list_first(&iface->sta_seen, struct hostapd_sta_info, list);
+	if (!info) {
+		eloop_cancel_timeout(sta_track_expire_timeout, iface, NULL);
+		return;
+	}
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &info->last_seen, &age);
+	if (age.sec >= (os_time_t) max_age) {
+		sec = 0;
+		usec = 0;
+	} else if (age.usec) {
+		sec = max_age - age.sec - 1;
+		usec = 1000000 - age.usec;
+	} else {
+		sec = max_age - age.sec;
+		usec = 0;
+	}
+
+	if (eloop_deplete_timeout(sec, usec, sta_track_expire_timeout, iface,
+				  NULL) < 0) {
+		eloop_cancel_timeout(sta_track_expire_timeout, iface, NULL);
+		eloop_register_timeout(sec, usec, sta_track_expire_timeout,
+				       iface, NULL);
+	}
+}
+
+
 void sta_track_expire(struct hostapd_iface *iface, int force)
 {
 	struct os_reltime now;
@@ -581,10 +789,35 @@ void sta_track_expire(struct hostapd_iface *iface, int force)
 		wpa_printf(MSG_MSGDUMP, "%s: Expire STA tracking entry for "
 			   MACSTR, iface->bss[0]->conf->iface,
 			   MAC2STR(info->addr));
+		sta_track_free(iface, info);
+	}
+}
+
+
+static void sta_track_expire_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_iface *iface = eloop_ctx;
+
+	sta_track_expire(iface, 0);
+	sta_track_schedule(iface);
+}
+
+
+void sta_track_deinit(struct hostapd_iface *iface)
+{
+	struct hostapd_sta_info *info;
+
+	eloop_cancel_timeout(sta_track_expire_timeout, iface, NULL);
+
+	while ((info = dl_list_first(&iface->sta_seen, struct hostapd_sta_info,
+				     list))) {
 		dl_list_del(&info->list);
 		iface->num_sta_seen--;
 		os_free(info);
 	}
+	os_free(iface->sta_seen_hash);
+	iface->sta_seen_hash = NULL;
+	iface->sta_seen_hash_size = 0;
 }
 
 
@@ -593,17 +826,21 @@ static struct hostapd_sta_info * sta_track_get(struct hostapd_iface *iface,
 {
 	struct hostapd_sta_info *info;
 
-	dl_list_for_each(info, &iface->sta_seen, struct hostapd_sta_info, list)
-		if (os_memcmp(addr, info->addr, ETH_ALEN) == 0)
-			return info;
+	if (iface->sta_seen_hash == NULL)
+		return NULL;
+	info = iface->sta_seen_hash[sta_track_hash_idx(iface, addr)];
+	while (info && os_memcmp(info->addr, addr, ETH_ALEN) != 0)
+		info = info->hnext;
 
-	return NULL;
+	return info;
 }
 
 
 void sta_track_add(struct hostapd_iface *iface, const u8 *addr)
 {
 	struct hostapd_sta_info *info;
+	unsigned int idx;
+	int first;
 
 	info = sta_track_get(iface, addr);
 	if (info) {
@@ -616,6 +853,8 @@ void sta_track_add(struct hostapd_iface *iface, const u8 *addr)
 
 	/* Add a new entry */
 	info = os_zalloc(sizeof(*info));
+	if (info == NULL)
+		return;
 	os_memcpy(info->addr, addr, ETH_ALEN);
 	os_get_reltime(&info->last_seen);
 
@@ -623,45 +862,263 @@ void sta_track_add(struct hostapd_iface *iface, const u8 *addr)
 		/* Expire oldest entry to make room for a new one */
 		sta_track_expire(iface, 1);
 	}
+	if (sta_track_hash_reserve(iface) < 0) {
+		os_free(info);
+		return;
+	}
 
 	wpa_printf(MSG_MSGDUMP, "%s: Add STA tracking entry for "
 		   MACSTR, iface->bss[0]->conf->iface, MAC2STR(addr));
+	first = dl_list_empty(&iface->sta_seen);
 	dl_list_add_tail(&iface->sta_seen, &info->list);
+	idx = sta_track_hash_idx(iface, addr);
+	info->hnext = iface->sta_seen_hash[idx];
+	iface->sta_seen_hash[idx] = info;
 	iface->num_sta_seen++;
+	if (first)
+		sta_track_schedule(iface);
 }
 
 
-struct hostapd_data *
-sta_track_seen_on(struct hostapd_iface *iface, const u8 *addr,
-		  const char *ifname)
+int sta_track_seen_on(struct hostapd_data *other, const u8 *addr)
+{
+	return other && sta_track_get(other->iface, addr) != NULL;
+}
+
+
+static struct hostapd_data *
+sta_track_find_bss(struct hapd_interfaces *interfaces, const char *ifname)
 {
-	struct hapd_interfaces *interfaces = iface->interfaces;
 	size_t i, j;
 
+	if (!ifname)
+		return NULL;
+
 	for (i = 0; i < interfaces->count; i++) {
-		struct hostapd_data *hapd = NULL;
+		struct hostapd_iface *iface = interfaces->iface[i];
 
-		iface = interfaces->iface[i];
 		for (j = 0; j < iface->num_bss; j++) {
-			hapd = iface->bss[j];
-			if (os_strcmp(ifname, hapd->conf->iface) == 0)
-				break;
-			hapd = NULL;
+			if (os_strcmp(ifname, iface->bss[j]->conf->iface) == 0)
+				return iface->bss[j];
 		}
-
-		if (hapd && sta_track_get(iface, addr))
-			return hapd;
 	}
 
 	return NULL;
 }
 
 
+/**
+ * sta_track_resolve_seen_on - Resolve no_*_if_seen_on interface names
+ * @interfaces: Interfaces to update
+ *
+ * Looks up the BSS named by no_probe_resp_if_seen_on and no_auth_if_seen_on
+ * for every BSS so that the Probe Request and Authentication paths do not
+ * need to compare interface names per frame. This is called whenever a BSS
+ * is set up or reconfigured since the named BSS may be added after the one
+ * referring to it.
+ */
+void sta_track_resolve_seen_on(struct hapd_interfaces *interfaces)
+{
+	size_t i, j;
+
+	if (!interfaces)
+		return;
+
+	for (i = 0; i < interfaces->count; i++) {
+		struct hostapd_iface *iface = interfaces->iface[i];
+
+		for (j = 0; j < iface->num_bss; j++) {
+			struct hostapd_data *hapd = iface->bss[j];
+
+			hapd->no_probe_resp_seen_on = sta_track_find_bss(
+				interfaces, hapd->conf->no_probe_resp_if_seen_on);
+			hapd->no_auth_seen_on = sta_track_find_bss(
+				interfaces, hapd->conf->no_auth_if_seen_on);
+		}
+	}
+}
+
+
+/**
+ * sta_track_forget_seen_on - Drop references to a BSS that is going away
+ * @hapd: BSS being removed
+ */
+void sta_track_forget_seen_on(struct hostapd_data *hapd)
+{
+	struct hapd_interfaces *interfaces;
+	size_t i, j;
+
+	hapd->no_probe_resp_seen_on = NULL;
+	hapd->no_auth_seen_on = NULL;
+
+	interfaces = hapd->iface ? hapd->iface->interfaces : NULL;
+	if (!interfaces)
+		return;
+
+	for (i = 0; i < interfaces->count; i++) {
+		struct hostapd_iface *iface = interfaces->iface[i];
+
+		if (!iface)
+			continue;
+		for (j = 0; j < iface->num_bss; j++) {
+			struct hostapd_data *bss = iface->bss[j];
+
+			if (!bss)
+				continue;
+			if (bss->no_probe_resp_seen_on == hapd)
+				bss->no_probe_resp_seen_on = NULL;
+			if (bss->no_auth_seen_on == hapd)
+				bss->no_auth_seen_on = NULL;
+		}
+	}
+}
+
+
+static os_time_t probe_reltime_ms(struct os_reltime *now,
+				   struct os_reltime *then)
+{
+	struct os_reltime age;
+
+	os_reltime_sub(now, then, &age);
+	return age.sec * 1000 + age.usec / 1000;
+}
+
+
+/* Returns 0 if a response may be sent or -1 if the bucket is empty */
+static int probe_bucket_take(struct hostapd_probe_bucket *bucket,
+			     struct os_reltime *now, unsigned int rate,
+			     unsigned int burst)
+{
+	unsigned int cap = burst * 1000;
+	os_time_t ms;
+
+	if (!os_reltime_initialized(&bucket->refill)) {
+		bucket->tokens = cap;
+		bucket->refill = *now;
+	} else {
+		/* rate responses/s add rate thousandths of a response per ms */
+		ms = probe_reltime_ms(now, &bucket->refill);
+		if (ms > 0) {
+			if ((unsigned long) ms > (cap - bucket->tokens) / rate)
+				bucket->tokens = cap;
+			else
+				bucket->tokens += ms * rate;
+			bucket->refill = *now;
+		}
+	}
+
+	if (bucket->tokens < 1000)
+		return -1;
+	bucket->tokens -= 1000;
+	return 0;
+}
+
+
+static u32 probe_ssid_hash(const u8 *ssid, size_t ssid_len)
+{
+	u32 hash = 2166136261U;
+	size_t i;
+
+	for (i = 0; i < ssid_len; i++) {
+		hash ^= ssid[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+
+/**
+ * probe_resp_limit - Apply Probe Response rate limits
+ * @hapd: BSS data
+ * @sa: Source address of the Probe Request frame
+ * @ssid: Requested SSID
+ * @ssid_len: Length of @ssid (0 for wildcard SSID)
+ * Returns: 1 if no response should be sent, 0 otherwise
+ *
+ * Sources are kept in a direct-mapped table keyed by SA and requested SSID,
+ * so a colliding source takes over the slot and starts with a full bucket.
+ * The slot is selected with a keyed hash, so senders cannot pick colliding
+ * addresses, but with more active sources than slots the per-source limits
+ * no longer hold and probe_resp_max_rate is what bounds the responses.
+ */
+static int probe_resp_limit(struct hostapd_data *hapd, const u8 *sa,
+			    const u8 *ssid, size_t ssid_len)
+{
+	struct hostapd_bss_config *conf = hapd->conf;
+	struct hostapd_iface *iface = hapd->iface;
+	struct hostapd_probe_source *src = NULL;
+	unsigned int max_rate = iface->conf->probe_resp_max_rate;
+	struct os_reltime now;
+	u32 ssid_hash;
+
+	if (!conf->probe_resp_rate && !conf->probe_resp_dedup_window &&
+	    !max_rate)
+		return 0;
+
+	os_get_reltime(&now);
+
+	if (conf->probe_resp_rate || conf->probe_resp_dedup_window) {
+		if (hapd->probe_sources == NULL) {
+			hapd->probe_sources =
+				os_calloc(PROBE_SOURCE_TABLE_SIZE,
+					  sizeof(struct hostapd_probe_source));
+			if (hapd->probe_sources == NULL)
+				return 0;
+			if (os_get_random(hapd->probe_source_key,
+					  sizeof(hapd->probe_source_key)) < 0)
+				wpa_printf(MSG_DEBUG,
+					   "AP: Could not generate Probe Request source key");
+		}
+
+		ssid_hash = probe_ssid_hash(ssid, ssid_len);
+		src = &hapd->probe_sources[
+			(hwaddr_hash(hapd->probe_source_key, sa) ^ ssid_hash) &
+			(PROBE_SOURCE_TABLE_SIZE - 1)];
+		if (os_memcmp(src->addr, sa, ETH_ALEN) != 0 ||
+		    src->ssid_hash != ssid_hash) {
+			os_memset(src, 0, sizeof(*src));
+			os_memcpy(src->addr, sa, ETH_ALEN);
+			src->ssid_hash = ssid_hash;
+		}
+
+		if (conf->probe_resp_dedup_window &&
+		    os_reltime_initialized(&src->last_resp) &&
+		    probe_reltime_ms(&now, &src->last_resp) <
+		    (os_time_t) conf->probe_resp_dedup_window) {
+			hapd->probe_resp_dedup++;
+			return 1;
+		}
+
+		if (conf->probe_resp_rate &&
+		    probe_bucket_take(&src->bucket, &now, conf->probe_resp_rate,
+				      conf->probe_resp_burst ?
+				      conf->probe_resp_burst :
+				      conf->probe_resp_rate) < 0) {
+			hapd->probe_resp_limited++;
+			return 1;
+		}
+	}
+
+	if (max_rate &&
+	    probe_bucket_take(&iface->probe_resp_bucket, &now, max_rate,
+			      max_rate) < 0) {
+		iface->probe_resp_global_limited++;
+		return 1;
+	}
+
+	if (src)
+		src->last_resp = now;
+	return 0;
+}
+
+
 void handle_probe_req(struct hostapd_data *hapd,
 		      const struct ieee80211_mgmt *mgmt, size_t len,
 		      int ssi_signal)
 {
-	u8 *resp;
+	u8 *resp = NULL, *frame;
+	struct hostapd_probe_resp_tmpl *tmpl;
 	struct ieee802_11_elems elems;
 	const u8 *ie;
 	size_t ie_len;
@@ -766,15 +1223,6 @@ void handle_probe_req(struct hostapd_data *hapd,
 	}
 #endif /* CONFIG_P2P */
 
-#ifdef CONFIG_CLIENT_TAXONOMY
-	{
-		struct sta_info *sta = ap_get_sta(hapd, mgmt->sa);
-		if (sta) {
-			hostapd_taxonomy_probe_req(hapd, sta, ie, ie_len);
-		}
-	}
-#endif /* CONFIG_CLIENT_TAXONOMY */
-
 	res = ssid_match(hapd, elems.ssid, elems.ssid_len,
 			 elems.ssid_list, elems.ssid_list_len);
 	if (res == NO_SSID_MATCH) {
@@ -839,11 +1287,10 @@ void handle_probe_req(struct hostapd_data *hapd,
 	/* TODO: verify that supp_rates contains at least one matching rate
 	 * with AP configuration */
 
-	if (hapd->conf->no_probe_resp_if_seen_on &&
+	if (hapd->no_probe_resp_seen_on &&
 	    is_multicast_ether_addr(mgmt->da) &&
 	    is_multicast_ether_addr(mgmt->bssid) &&
-	    sta_track_seen_on(hapd->iface, mgmt->sa,
-			      hapd->conf->no_probe_resp_if_seen_on)) {
+	    sta_track_seen_on(hapd->no_probe_resp_seen_on, mgmt->sa)) {
 		wpa_printf(MSG_MSGDUMP, "%s: Ignore Probe Request from " MACSTR
 			   " since STA has been seen on %s",
 			   hapd->conf->iface, MAC2STR(mgmt->sa),
@@ -861,10 +1308,48 @@ void handle_probe_req(struct hostapd_data *hapd,
 	}
 #endif /* CONFIG_TESTING_OPTIONS */
 
-	resp = hostapd_gen_probe_resp(hapd, mgmt, elems.p2p != NULL,
-				      &resp_len);
-	if (resp == NULL)
+	if (is_multicast_ether_addr(mgmt->da) &&
+	    probe_resp_limit(hapd, mgmt->sa, elems.ssid, elems.ssid_len)) {
+		wpa_printf(MSG_MSGDUMP, "%s: Probe Request from " MACSTR
+			   " rate limited", hapd->conf->iface,
+			   MAC2STR(mgmt->sa));
 		return;
+	}
+
+#ifdef CONFIG_CLIENT_TAXONOMY
+	/*
+	 * Only Probe Requests that are answered are recorded, so that
+	 * requests for other SSIDs and rate limited floods cost nothing.
+	 */
+	{
+		struct sta_info *sta = ap_get_sta(hapd, mgmt->sa);
+		if (sta) {
+			hostapd_taxonomy_probe_req(hapd, sta, ie, ie_len);
+		} else {
+			hostapd_taxonomy_probe_req_cache(hapd, mgmt->sa, ie,
+							 ie_len);
+		}
+	}
+#endif /* CONFIG_CLIENT_TAXONOMY */
+
+	if (hapd->cs_freq_params.freq) {
+		/*
+		 * Channel switch elements are only present for the duration
+		 * of the switch, so do not cache them in the template.
+		 */
+		resp = hostapd_gen_probe_resp(hapd, mgmt, elems.p2p != NULL,
+					      &resp_len);
+		if (resp == NULL)
+			return;
+		frame = resp;
+	} else {
+		tmpl = hostapd_probe_resp_tmpl_get(hapd, elems.p2p != NULL);
+		if (tmpl == NULL)
+			return;
+		hostapd_probe_resp_tmpl_patch(hapd, tmpl, mgmt->sa);
+		frame = tmpl->buf;
+		resp_len = tmpl->len;
+	}
 
 	/*
 	 * If this is a broadcast probe request, apply no ack policy to avoid
@@ -873,8 +1358,10 @@ void handle_probe_req(struct hostapd_data *hapd,
 	noack = !!(res == WILDCARD_SSID_MATCH &&
 		   is_broadcast_ether_addr(mgmt->da));
 
-	if (hostapd_drv_send_mlme(hapd, resp, resp_len, noack) < 0)
+	if (hostapd_drv_send_mlme(hapd, frame, resp_len, noack) < 0)
 		wpa_printf(MSG_INFO, "handle_probe_req: send failed");
+	else
+		hapd->probe_resp_sent++;
 
 	os_free(resp);
 
@@ -1203,6 +1690,10 @@ int ieee802_11_set_beacon(struct hostapd_data *hapd)
 	struct wpabuf *beacon, *proberesp, *assocresp;
 	int res, ret = -1;
 
+#ifdef NEED_AP_MLME
+	hostapd_probe_resp_tmpl_flush(hapd);
+#endif /* NEED_AP_MLME */
+
 	if (hapd->csa_in_progress) {
 		wpa_printf(MSG_ERROR, "Cannot set beacons during CSA period");
 		return -1;
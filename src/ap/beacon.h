@@ -11,6 +11,7 @@
 #define BEACON_H
 
 struct ieee80211_mgmt;
+struct hapd_interfaces;
 
 void handle_probe_req(struct hostapd_data *hapd,
 		      const struct ieee80211_mgmt *mgmt, size_t len,
@@ -21,10 +22,12 @@ int ieee802_11_update_beacons(struct hostapd_iface *iface);
 int ieee802_11_build_ap_params(struct hostapd_data *hapd,
 			       struct wpa_driver_ap_params *params);
 void ieee802_11_free_ap_params(struct wpa_driver_ap_params *params);
+void hostapd_probe_resp_tmpl_flush(struct hostapd_data *hapd);
 void sta_track_add(struct hostapd_iface *iface, const u8 *addr);
 void sta_track_expire(struct hostapd_iface *iface, int force);
-struct hostapd_data *
-sta_track_seen_on(struct hostapd_iface *iface, const u8 *addr,
-		  const char *ifname);
+void sta_track_deinit(struct hostapd_iface *iface);
+int sta_track_seen_on(struct hostapd_data *other, const u8 *addr);
+void sta_track_resolve_seen_on(struct hapd_interfaces *interfaces);
+void sta_track_forget_seen_on(struct hostapd_data *hapd);
 
 #endif /* BEACON_H */
@@ -0,0 +1,121 @@
+/*
+ * hostapd / Binary control interface events
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "common/wpa_ctrl.h"
+#include "hostapd.h"
+#include "bin_event.h"
+
+
+/**
+ * hostapd_bin_event_start - Start building a binary event
+ * @hapd: BSS data
+ * @type: Event type (enum bin_event_type)
+ * @attr_len: Total length of the attribute values that will be added
+ * @num_attrs: Number of attributes that will be added
+ * Returns: Event buffer or %NULL if no monitor has asked for binary events
+ */
+struct wpabuf * hostapd_bin_event_start(const struct hostapd_data *hapd,
+					u16 type, size_t attr_len,
+					size_t num_attrs)
+{
+	struct wpabuf *ev;
+
+	if (!hapd->ctrl_bin_monitors || !hapd->bin_event_cb)
+		return NULL;
+
+	ev = wpabuf_alloc(BIN_EVENT_HDR_LEN + 4 * num_attrs + attr_len);
+	if (ev == NULL)
+		return NULL;
+
+	wpabuf_put_u8(ev, BIN_EVENT_MAGIC);
+	wpabuf_put_u8(ev, BIN_EVENT_VERSION);
+	wpabuf_put_le16(ev, type);
+	wpabuf_put_le16(ev, 0); /* filled in by hostapd_bin_event_send() */
+	return ev;
+}
+
+
+void hostapd_bin_event_put(struct wpabuf *ev, u16 attr, const void *data,
+			   size_t len)
+{
+	if (len > 0xffff || wpabuf_tailroom(ev) < 4 + len)
+		return;
+	wpabuf_put_le16(ev, attr);
+	wpabuf_put_le16(ev, len);
+	wpabuf_put_data(ev, data, len);
+}
+
+
+void hostapd_bin_event_put_addr(struct wpabuf *ev, const u8 *addr)
+{
+	hostapd_bin_event_put(ev, BIN_ATTR_ADDR, addr, ETH_ALEN);
+}
+
+
+void hostapd_bin_event_put_s32(struct wpabuf *ev, u16 attr, int val)
+{
+	u8 buf[4];
+
+	WPA_PUT_LE32(buf, (u32) val);
+	hostapd_bin_event_put(ev, attr, buf, sizeof(buf));
+}
+
+
+/**
+ * hostapd_bin_event_send - Deliver and free a binary event
+ * @hapd: BSS data
+ * @ev: Event from hostapd_bin_event_start() or %NULL
+ */
+void hostapd_bin_event_send(const struct hostapd_data *hapd,
+			    struct wpabuf *ev)
+{
+	if (ev == NULL)
+		return;
+
+	if (wpabuf_len(ev) - BIN_EVENT_HDR_LEN <= 0xffff) {
+		WPA_PUT_LE16(wpabuf_mhead_u8(ev) + 4,
+			     wpabuf_len(ev) - BIN_EVENT_HDR_LEN);
+		hapd->bin_event_cb(hapd, wpabuf_head(ev), wpabuf_len(ev));
+	}
+	wpabuf_free(ev);
+}
+
+
+/**
+ * hostapd_text_event_wanted - Whether to format the text form of an event
+ * @hapd: BSS data
+ * Returns: 0 if every attached monitor takes binary events and the text
+ * would not be shown in the debug log either, 1 otherwise
+ */
+int hostapd_text_event_wanted(const struct hostapd_data *hapd)
+{
+	return !hapd->ctrl_bin_monitors || hapd->ctrl_text_monitors ||
+		wpa_debug_level <= MSG_INFO;
+}
+
+
+/**
+ * hostapd_bin_event_text - Whether a text event also has a binary form
+ * @txt: Text event
+ * Returns: 1 if the event is delivered as a binary event to the monitors that
+ * have enabled BINARY_EVENTS, so they do not get the text form, 0 otherwise
+ */
+int hostapd_bin_event_text(const char *txt)
+{
+	return os_strncmp(txt, AP_STA_STEERING, os_strlen(AP_STA_STEERING)) ==
+		0 ||
+		os_strncmp(txt, AP_STA_NO_STEERING,
+			   os_strlen(AP_STA_NO_STEERING)) == 0 ||
+#ifdef CONFIG_CLIENT_TAXONOMY
+		os_strncmp(txt, AP_STA_TAXONOMY,
+			   os_strlen(AP_STA_TAXONOMY)) == 0 ||
+#endif /* CONFIG_CLIENT_TAXONOMY */
+		0;
+}
@@ -0,0 +1,23 @@
+/*
+ * hostapd / Binary control interface events
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef BIN_EVENT_H
+#define BIN_EVENT_H
+
+struct wpabuf * hostapd_bin_event_start(const struct hostapd_data *hapd,
+					u16 type, size_t attr_len,
+					size_t num_attrs);
+void hostapd_bin_event_put(struct wpabuf *ev, u16 attr, const void *data,
+			   size_t len);
+void hostapd_bin_event_put_addr(struct wpabuf *ev, const u8 *addr);
+void hostapd_bin_event_put_s32(struct wpabuf *ev, u16 attr, int val);
+void hostapd_bin_event_send(const struct hostapd_data *hapd,
+			    struct wpabuf *ev);
+int hostapd_text_event_wanted(const struct hostapd_data *hapd);
+int hostapd_bin_event_text(const char *txt);
+
+#endif /* BIN_EVENT_H */
@@ -24,20 +24,18 @@
 #include "ap_drv_ops.h"
 #include "sta_blacklist.h"
 
-static int hostapd_get_sta_tx_rx(struct hostapd_data *hapd,
-				 struct sta_info *sta,
+static int hostapd_get_sta_tx_rx(const struct hostap_sta_driver_data *data,
 				 char *buf, size_t buflen)
 {
-	struct hostap_sta_driver_data data;
 	int ret;
 
-	if (hostapd_drv_read_sta_data(hapd, &data, sta->addr) < 0)
+	if (data == NULL)
 		return 0;
 
 	ret = os_snprintf(buf, buflen, "rx_packets=%lu\ntx_packets=%lu\n"
 			  "rx_bytes=%lu\ntx_bytes=%lu\n",
-			  data.rx_packets, data.tx_packets,
-			  data.rx_bytes, data.tx_bytes);
+			  data->rx_packets, data->tx_packets,
+			  data->rx_bytes, data->tx_bytes);
 	if (os_snprintf_error(buflen, ret))
 		return 0;
 	return ret;
@@ -82,71 +80,127 @@ static const char * timeout_next_str(int val)
 }
 
 
-static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
-				      struct sta_info *sta,
-				      char *buf, size_t buflen)
+/* Station record fields for STA-DUMP */
+#define STA_DUMP_FLAGS BIT(0)
+#define STA_DUMP_ASSOC BIT(1)
+#define STA_DUMP_TIMEOUT BIT(2)
+#define STA_DUMP_MIB BIT(3)
+#define STA_DUMP_TRAFFIC BIT(4)
+#define STA_DUMP_CONN_TIME BIT(5)
+#define STA_DUMP_SAE BIT(6)
+#define STA_DUMP_VLAN BIT(7)
+#define STA_DUMP_ALL (BIT(8) - 1)
+
+static const struct {
+	const char *name;
+	unsigned int field;
+} sta_dump_fields[] = {
+	{ "flags", STA_DUMP_FLAGS },
+	{ "assoc", STA_DUMP_ASSOC },
+	{ "timeout", STA_DUMP_TIMEOUT },
+	{ "mib", STA_DUMP_MIB },
+	{ "traffic", STA_DUMP_TRAFFIC },
+	{ "connected_time", STA_DUMP_CONN_TIME },
+	{ "sae", STA_DUMP_SAE },
+	{ "vlan", STA_DUMP_VLAN },
+	{ "all", STA_DUMP_ALL },
+};
+
+
+static int hostapd_ctrl_iface_sta_record(
+	struct hostapd_data *hapd, struct sta_info *sta, unsigned int fields,
+	const struct hostap_sta_driver_data *data, char *buf, size_t buflen)
 {
 	int len, res, ret, i;
 
-	if (!sta)
-		return 0;
-
 	len = 0;
-	ret = os_snprintf(buf + len, buflen - len, MACSTR "\nflags=",
+	ret = os_snprintf(buf + len, buflen - len, MACSTR "\n",
 			  MAC2STR(sta->addr));
 	if (os_snprintf_error(buflen - len, ret))
 		return len;
 	len += ret;
 
-	ret = ap_sta_flags_txt(sta->flags, buf + len, buflen - len);
-	if (ret < 0)
-		return len;
-	len += ret;
+	if (fields & STA_DUMP_FLAGS) {
+		ret = os_snprintf(buf + len, buflen - len, "flags=");
+		if (os_snprintf_error(buflen - len, ret))
+			return len;
+		len += ret;
 
-	ret = os_snprintf(buf + len, buflen - len, "\naid=%d\ncapability=0x%x\n"
-			  "listen_interval=%d\nsupported_rates=",
-			  sta->aid, sta->capability, sta->listen_interval);
-	if (os_snprintf_error(buflen - len, ret))
-		return len;
-	len += ret;
+		ret = ap_sta_flags_txt(sta->flags, buf + len, buflen - len);
+		if (ret < 0)
+			return len;
+		len += ret;
 
-	for (i = 0; i < sta->supported_rates_len; i++) {
-		ret = os_snprintf(buf + len, buflen - len, "%02x%s",
-				  sta->supported_rates[i],
-				  i + 1 < sta->supported_rates_len ? " " : "");
+		ret = os_snprintf(buf + len, buflen - len, "\n");
 		if (os_snprintf_error(buflen - len, ret))
 			return len;
 		len += ret;
 	}
 
-	ret = os_snprintf(buf + len, buflen - len, "\ntimeout_next=%s\n",
-			  timeout_next_str(sta->timeout_next));
-	if (os_snprintf_error(buflen - len, ret))
-		return len;
-	len += ret;
+	if (fields & STA_DUMP_ASSOC) {
+		ret = os_snprintf(buf + len, buflen - len,
+				  "aid=%d\ncapability=0x%x\n"
+				  "listen_interval=%d\nsupported_rates=",
+				  sta->aid, sta->capability,
+				  sta->listen_interval);
+		if (os_snprintf_error(buflen - len, ret))
+			return len;
+		len += ret;
 
-	res = ieee802_11_get_mib_sta(hapd, sta, buf + len, buflen - len);
-	if (res >= 0)
-		len += res;
-	res = wpa_get_mib_sta(sta->wpa_sm, buf + len, buflen - len);
-	if (res >= 0)
-		len += res;
-	res = ieee802_1x_get_mib_sta(hapd, sta, buf + len, buflen - len);
-	if (res >= 0)
-		len += res;
-	res = hostapd_wps_get_mib_sta(hapd, sta->addr, buf + len,
-				      buflen - len);
-	if (res >= 0)
-		len += res;
-	res = hostapd_p2p_get_mib_sta(hapd, sta, buf + len, buflen - len);
-	if (res >= 0)
-		len += res;
-
-	len += hostapd_get_sta_tx_rx(hapd, sta, buf + len, buflen - len);
-	len += hostapd_get_sta_conn_time(sta, buf + len, buflen - len);
+		for (i = 0; i < sta->supported_rates_len; i++) {
+			ret = os_snprintf(buf + len, buflen - len, "%02x%s",
+					  sta->supported_rates[i],
+					  i + 1 < sta->supported_rates_len ?
+					  " " : "");
+			if (os_snprintf_error(buflen - len, ret))
+				return len;
+			len += ret;
+		}
+
+		ret = os_snprintf(buf + len, buflen - len, "\n");
+		if (os_snprintf_error(buflen - len, ret))
+			return len;
+		len += ret;
+	}
+
+	if (fields & STA_DUMP_TIMEOUT) {
+		ret = os_snprintf(buf + len, buflen - len, "timeout_next=%s\n",
+				  timeout_next_str(sta->timeout_next));
+		if (os_snprintf_error(buflen - len, ret))
+			return len;
+		len += ret;
+	}
+
+	if (fields & STA_DUMP_MIB) {
+		res = ieee802_11_get_mib_sta(hapd, sta, buf + len,
+					     buflen - len);
+		if (res >= 0)
+			len += res;
+		res = wpa_get_mib_sta(sta->wpa_sm, buf + len, buflen - len);
+		if (res >= 0)
+			len += res;
+		res = ieee802_1x_get_mib_sta(hapd, sta, buf + len,
+					     buflen - len);
+		if (res >= 0)
+			len += res;
+		res = hostapd_wps_get_mib_sta(hapd, sta->addr, buf + len,
+					      buflen - len);
+		if (res >= 0)
+			len += res;
+		res = hostapd_p2p_get_mib_sta(hapd, sta, buf + len,
+					      buflen - len);
+		if (res >= 0)
+			len += res;
+	}
+
+	if (fields & STA_DUMP_TRAFFIC)
+		len += hostapd_get_sta_tx_rx(data, buf + len, buflen - len);
+	if (fields & STA_DUMP_CONN_TIME)
+		len += hostapd_get_sta_conn_time(sta, buf + len, buflen - len);
 
 #ifdef CONFIG_SAE
-	if (sta->sae && sta->sae->state == SAE_ACCEPTED) {
+	if ((fields & STA_DUMP_SAE) &&
+	    sta->sae && sta->sae->state == SAE_ACCEPTED) {
 		res = os_snprintf(buf + len, buflen - len, "sae_group=%d\n",
 				  sta->sae->group);
 		if (!os_snprintf_error(buflen - len, res))
@@ -154,7 +208,7 @@ static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
 	}
 #endif /* CONFIG_SAE */
 
-	if (sta->vlan_id > 0) {
+	if ((fields & STA_DUMP_VLAN) && sta->vlan_id > 0) {
 		res = os_snprintf(buf + len, buflen - len, "vlan_id=%d\n",
 				  sta->vlan_id);
 		if (!os_snprintf_error(buflen - len, res))
@@ -165,6 +219,22 @@ static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
 }
 
 
+static int hostapd_ctrl_iface_sta_mib(struct hostapd_data *hapd,
+				      struct sta_info *sta,
+				      char *buf, size_t buflen)
+{
+	struct hostap_sta_driver_data data;
+
+	if (!sta)
+		return 0;
+
+	return hostapd_ctrl_iface_sta_record(
+		hapd, sta, STA_DUMP_ALL,
+		hostapd_drv_read_sta_data(hapd, &data, sta->addr) == 0 ?
+		&data : NULL, buf, buflen);
+}
+
+
 int hostapd_ctrl_iface_sta_first(struct hostapd_data *hapd,
 				 char *buf, size_t buflen)
 {
@@ -236,6 +306,269 @@ int hostapd_ctrl_iface_sta_next(struct hostapd_data *hapd, const char *txtaddr,
 }
 
 
+/* Minimum number of stations for fetching counters with a single request */
+#define STA_DUMP_BULK_READ_MIN 4
+/* Space kept for the reply trailer */
+#define STA_DUMP_TRAILER_LEN 32
+/*
+ * Records are formatted into a scratch buffer that has this much more room
+ * than is left in the reply. This is more than any of the MIB functions
+ * writes, so a record that fits in the reply has not been truncated.
+ */
+#define STA_DUMP_RECORD_SLACK 4096
+
+struct sta_dump_counter {
+	u8 addr[ETH_ALEN];
+	struct hostap_sta_driver_data data;
+};
+
+struct sta_dump_counters {
+	struct sta_dump_counter *entries;
+	size_t num;
+	size_t alloc;
+	int failed;
+};
+
+
+static void sta_dump_counters_cb(void *ctx, const u8 *addr,
+				 struct hostap_sta_driver_data *data)
+{
+	struct sta_dump_counters *counters = ctx;
+	struct sta_dump_counter *n;
+
+	if (counters->failed)
+		return;
+
+	if (counters->num == counters->alloc) {
+		size_t alloc = counters->alloc ? counters->alloc * 2 : 64;
+
+		n = os_realloc_array(counters->entries, alloc, sizeof(*n));
+		if (n == NULL) {
+			counters->failed = 1;
+			return;
+		}
+		counters->entries = n;
+		counters->alloc = alloc;
+	}
+
+	n = &counters->entries[counters->num++];
+	os_memcpy(n->addr, addr, ETH_ALEN);
+	n->data = *data;
+}
+
+
+static int sta_dump_counter_cmp(const void *a, const void *b)
+{
+	const struct sta_dump_counter *ca = a, *cb = b;
+
+	return os_memcmp(ca->addr, cb->addr, ETH_ALEN);
+}
+
+
+/*
+ * Stations are dumped in the order of their keyed hash and address. Unlike
+ * sta_list, this order does not depend on which stations are present, so a
+ * page can continue after a cursor station that has disconnected.
+ */
+struct sta_dump_entry {
+	u32 hash;
+	struct sta_info *sta;
+};
+
+
+static int sta_dump_order(u32 hash_a, const u8 *addr_a,
+			  u32 hash_b, const u8 *addr_b)
+{
+	if (hash_a != hash_b)
+		return hash_a < hash_b ? -1 : 1;
+	return os_memcmp(addr_a, addr_b, ETH_ALEN);
+}
+
+
+static int sta_dump_entry_cmp(const void *a, const void *b)
+{
+	const struct sta_dump_entry *ea = a, *eb = b;
+
+	return sta_dump_order(ea->hash, ea->sta->addr, eb->hash, eb->sta->addr);
+}
+
+
+static int sta_dump_parse_fields(char *val, unsigned int *fields)
+{
+	char *name, *context = NULL;
+	size_t i;
+
+	if (val[0] >= '0' && val[0] <= '9') {
+		*fields = strtoul(val, NULL, 0) & STA_DUMP_ALL;
+		return 0;
+	}
+
+	*fields = 0;
+	while ((name = str_token(val, ",", &context))) {
+		for (i = 0; i < ARRAY_SIZE(sta_dump_fields); i++) {
+			if (os_strcmp(name, sta_dump_fields[i].name) == 0)
+				break;
+		}
+		if (i == ARRAY_SIZE(sta_dump_fields))
+			return -1;
+		*fields |= sta_dump_fields[i].field;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Convert a record to a single line: the MAC address followed by the
+ * name=value pairs separated by spaces. Spaces within values are replaced
+ * with underscores.
+ */
+static void sta_dump_compact(char *rec, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i + 1 < len; i++) {
+		if (rec[i] == ' ')
+			rec[i] = '_';
+		else if (rec[i] == '\n')
+			rec[i] = ' ';
+	}
+}
+
+
+int hostapd_ctrl_iface_sta_dump(struct hostapd_data *hapd, char *params,
+				char *buf, size_t buflen)
+{
+	struct sta_dump_counters counters;
+	struct sta_dump_counter key, *entry;
+	struct sta_dump_entry *stas;
+	struct hostap_sta_driver_data data;
+	const struct hostap_sta_driver_data *sta_data;
+	struct sta_info *sta, *last = NULL;
+	unsigned int fields = STA_DUMP_ALL, count = 0, max = 0;
+	size_t size = STA_DUMP_DEFAULT_REPLY, num = 0, i = 0;
+	int compact = 0, bulk = 0, cursor = 0, ret;
+	char *token, *context = NULL, *pos, *end, *rec;
+	u8 addr[ETH_ALEN];
+	u32 hash = 0;
+
+	while (params && (token = str_token(params, " ", &context))) {
+		if (os_strncmp(token, "fields=", 7) == 0) {
+			if (sta_dump_parse_fields(token + 7, &fields) < 0)
+				return -1;
+		} else if (os_strcmp(token, "compact") == 0) {
+			compact = 1;
+		} else if (os_strncmp(token, "max=", 4) == 0) {
+			max = atoi(token + 4);
+		} else if (os_strncmp(token, "size=", 5) == 0) {
+			size = atoi(token + 5);
+		} else if (hwaddr_aton(token, addr) == 0) {
+			/* Continue after the last station of the previous
+			 * reply */
+			hash = hwaddr_hash(hapd->sta_hash_key, addr);
+			cursor = 1;
+		} else {
+			return -1;
+		}
+	}
+
+	if (size < buflen)
+		buflen = size;
+	if (buflen <= STA_DUMP_TRAILER_LEN)
+		return -1;
+
+	stas = os_calloc(hapd->num_sta + 1, sizeof(*stas));
+	rec = os_malloc(buflen + STA_DUMP_RECORD_SLACK);
+	if (stas == NULL || rec == NULL) {
+		os_free(stas);
+		os_free(rec);
+		return -1;
+	}
+	for (sta = hapd->sta_list; sta && num < (size_t) hapd->num_sta;
+	     sta = sta->next) {
+		stas[num].hash = hwaddr_hash(hapd->sta_hash_key, sta->addr);
+		stas[num].sta = sta;
+		num++;
+	}
+	qsort(stas, num, sizeof(*stas), sta_dump_entry_cmp);
+	if (cursor) {
+		while (i < num &&
+		       sta_dump_order(stas[i].hash, stas[i].sta->addr,
+				      hash, addr) <= 0)
+			i++;
+	}
+
+	/*
+	 * Fetch the counters of all stations with one driver request instead
+	 * of a request per station when the page is likely to contain more
+	 * than a few stations.
+	 */
+	os_memset(&counters, 0, sizeof(counters));
+	if ((fields & STA_DUMP_TRAFFIC) &&
+	    hapd->num_sta >= STA_DUMP_BULK_READ_MIN &&
+	    hostapd_drv_read_all_sta_data(hapd, sta_dump_counters_cb,
+					  &counters) == 0 &&
+	    !counters.failed) {
+		qsort(counters.entries, counters.num, sizeof(*counters.entries),
+		      sta_dump_counter_cmp);
+		bulk = 1;
+	}
+
+	pos = buf;
+	end = buf + buflen - STA_DUMP_TRAILER_LEN;
+	for (; i < num; i++) {
+		if (max && count == max)
+			break;
+		sta = stas[i].sta;
+
+		sta_data = NULL;
+		if (bulk) {
+			os_memcpy(key.addr, sta->addr, ETH_ALEN);
+			entry = bsearch(&key, counters.entries, counters.num,
+					sizeof(*counters.entries),
+					sta_dump_counter_cmp);
+			if (entry)
+				sta_data = &entry->data;
+		} else if ((fields & STA_DUMP_TRAFFIC) &&
+			   hostapd_drv_read_sta_data(hapd, &data,
+						     sta->addr) == 0) {
+			sta_data = &data;
+		}
+
+		/* Only complete records are added; the MIB functions return
+		 * partial output or nothing when they run out of room. */
+		ret = hostapd_ctrl_iface_sta_record(
+			hapd, sta, fields, sta_data, rec,
+			end - pos + STA_DUMP_RECORD_SLACK);
+		if (ret > end - pos)
+			break;
+		if (compact)
+			sta_dump_compact(rec, ret);
+		os_memcpy(pos, rec, ret);
+		pos += ret;
+		count++;
+		last = sta;
+	}
+
+	os_free(counters.entries);
+	os_free(rec);
+	os_free(stas);
+
+	if (i == num)
+		ret = os_snprintf(pos, buf + buflen - pos, "END\n");
+	else if (last)
+		ret = os_snprintf(pos, buf + buflen - pos, "CURSOR " MACSTR "\n",
+				  MAC2STR(last->addr));
+	else
+		return -1; /* the first record does not fit in the reply */
+	if (os_snprintf_error(buf + buflen - pos, ret))
+		return -1;
+	pos += ret;
+
+	return pos - buf;
+}
+
+
 #ifdef CONFIG_P2P_MANAGER
 static int p2p_manager_disconnect(struct hostapd_data *hapd, u16 stype,
 				  u8 minor_reason_code, const u8 *addr)
@@ -488,19 +821,32 @@ int hostapd_ctrl_iface_status(struct hostapd_data *hapd, char *buf,
 		return len;
 	len += ret;
 
+	ret = os_snprintf(buf + len, buflen - len,
+			  "probe_resp_global_limited=%lu\n",
+			  iface->probe_resp_global_limited);
+	if (os_snprintf_error(buflen - len, ret))
+		return len;
+	len += ret;
+
 	for (i = 0; i < iface->num_bss; i++) {
 		struct hostapd_data *bss = iface->bss[i];
 		ret = os_snprintf(buf + len, buflen - len,
 				  "bss[%d]=%s\n"
 				  "bssid[%d]=" MACSTR "\n"
 				  "ssid[%d]=%s\n"
-				  "num_sta[%d]=%d\n",
+				  "num_sta[%d]=%d\n"
+				  "probe_resp_sent[%d]=%lu\n"
+				  "probe_resp_dedup[%d]=%lu\n"
+				  "probe_resp_limited[%d]=%lu\n",
 				  (int) i, bss->conf->iface,
 				  (int) i, MAC2STR(bss->own_addr),
 				  (int) i,
 				  wpa_ssid_txt(bss->conf->ssid.ssid,
 					       bss->conf->ssid.ssid_len),
-				  (int) i, bss->num_sta);
+				  (int) i, bss->num_sta,
+				  (int) i, bss->probe_resp_sent,
+				  (int) i, bss->probe_resp_dedup,
+				  (int) i, bss->probe_resp_limited);
 		if (os_snprintf_error(buflen - len, ret))
 			return len;
 		len += ret;
@@ -509,19 +855,50 @@ int hostapd_ctrl_iface_status(struct hostapd_data *hapd, char *buf,
 	return len;
 }
 
+/*
+ * Parses "<addr>[ ttl=<secs>]" or "<addr>[/<secs>]" and returns a pointer to
+ * the character following the entry or %NULL on failure
+ */
+static const char * hostapd_ctrl_iface_blacklist_parse(const char *txt,
+						       u8 *addr,
+						       unsigned int *ttl)
+{
+	const char *pos;
+
+	if (hwaddr_aton(txt, addr))
+		return NULL;
+
+	*ttl = 0;
+	pos = txt + 17;
+	if (*pos == '/')
+		pos++;
+	else if (os_strncmp(pos, " ttl=", 5) == 0)
+		pos += 5;
+	else
+		return *pos == '\0' || *pos == ' ' ? pos : NULL;
+
+	if (*pos < '0' || *pos > '9')
+		return NULL;
+	*ttl = atoi(pos);
+	while (*pos >= '0' && *pos <= '9')
+		pos++;
+	return *pos == '\0' || *pos == ' ' ? pos : NULL;
+}
+
 int hostapd_ctrl_iface_blacklist_add(struct hostapd_data *hapd,
 					const char *txtaddr)
 {
 	u8 addr[ETH_ALEN];
+	unsigned int ttl;
 	int ret = -1;
 
 	wpa_dbg(hapd->msg_ctx, MSG_DEBUG, "CTRL_IFACE BLACKLIST_ADD %s",
 		txtaddr);
 
-	if (hwaddr_aton(txtaddr, addr))
+	if (hostapd_ctrl_iface_blacklist_parse(txtaddr, addr, &ttl) == NULL)
 		return -1;
 
-	ret = sta_blacklist_add(hapd, addr);
+	ret = sta_blacklist_add_ttl(hapd, addr, ttl);
 
 	return ret;
 }
@@ -543,23 +920,159 @@ int hostapd_ctrl_iface_blacklist_rm(struct hostapd_data *hapd,
 	return ret;
 }
 
+int hostapd_ctrl_iface_blacklist_load(struct hostapd_data *hapd,
+				      const char *cmd)
+{
+	u8 addr[ETH_ALEN];
+	unsigned int ttl;
+	const char *pos;
+	int count = 0, apply;
+
+	/*
+	 * The whole list is validated before any entry is added so that a
+	 * malformed entry does not leave the blacklist partially loaded.
+	 */
+	for (apply = 0; apply <= 1; apply++) {
+		pos = cmd;
+		for (;;) {
+			while (*pos == ' ')
+				pos++;
+			if (*pos == '\0')
+				break;
+			pos = hostapd_ctrl_iface_blacklist_parse(pos, addr,
+								 &ttl);
+			if (pos == NULL) {
+				wpa_dbg(hapd->msg_ctx, MSG_DEBUG,
+					"CTRL_IFACE BLACKLIST_LOAD: invalid entry %d",
+					count + 1);
+				return -1;
+			}
+			if (apply && sta_blacklist_add_ttl(hapd, addr, ttl))
+				return -1;
+			count++;
+		}
+		if (!apply)
+			count = 0;
+	}
+
+	wpa_dbg(hapd->msg_ctx, MSG_DEBUG, "CTRL_IFACE BLACKLIST_LOAD: %d entries",
+		count);
+	return 0;
+}
+
 int hostapd_ctrl_iface_blacklist_show(struct hostapd_data *hapd, char *buf,
 		size_t buflen)
 {
 	int len = 0, ret = 0;
-	struct sta_blacklist *e = hapd->blacklist;
+	struct sta_blacklist *e;
 
-	while (e) {
+	dl_list_for_each(e, &hapd->blacklist, struct sta_blacklist, list) {
 		ret = os_snprintf(buf + len, buflen - len,
 				  MACSTR "\n",
 				  MAC2STR(e->sta));
 		if (ret < 0 || (size_t) ret >= buflen - len)
 			return len;
 		len += ret;
-		e = e->next;
 	}
 
-	return ret;
+	return len;
+}
+
+/* Space kept for the BLACKLIST_DUMP reply trailer */
+#define BLACKLIST_DUMP_TRAILER_LEN 32
+
+struct blacklist_dump_entry {
+	u32 hash;
+	struct sta_blacklist *e;
+};
+
+
+static int blacklist_dump_entry_cmp(const void *a, const void *b)
+{
+	const struct blacklist_dump_entry *ea = a, *eb = b;
+
+	return sta_dump_order(ea->hash, ea->e->sta, eb->hash, eb->e->sta);
+}
+
+
+/*
+ * Entries are listed in the order of their keyed hash and address, like with
+ * STA-DUMP, so that a cursor stays valid when entries are added, expire or
+ * are removed between pages.
+ */
+int hostapd_ctrl_iface_blacklist_dump(struct hostapd_data *hapd,
+				      const char *txtaddr, char *buf,
+				      size_t buflen)
+{
+	u8 addr[ETH_ALEN];
+	int len = 0, end, ret;
+	struct blacklist_dump_entry *entries;
+	struct sta_blacklist *e, *last = NULL;
+	struct os_reltime now, ttl;
+	size_t num = 0, i = 0;
+	u32 hash = 0;
+
+	if (buflen <= BLACKLIST_DUMP_TRAILER_LEN)
+		return -1;
+	end = buflen - BLACKLIST_DUMP_TRAILER_LEN;
+
+	/* Continue after the last entry of the previous reply, if given */
+	if (txtaddr) {
+		if (hwaddr_aton(txtaddr, addr))
+			return -1;
+		hash = hwaddr_hash(hapd->blacklist_hash_key, addr);
+	}
+
+	entries = os_calloc(dl_list_len(&hapd->blacklist) + 1,
+			    sizeof(*entries));
+	if (entries == NULL)
+		return -1;
+	dl_list_for_each(e, &hapd->blacklist, struct sta_blacklist, list) {
+		entries[num].hash = hwaddr_hash(hapd->blacklist_hash_key,
+						e->sta);
+		entries[num].e = e;
+		num++;
+	}
+	qsort(entries, num, sizeof(*entries), blacklist_dump_entry_cmp);
+	if (txtaddr) {
+		while (i < num &&
+		       sta_dump_order(entries[i].hash, entries[i].e->sta,
+				      hash, addr) <= 0)
+			i++;
+	}
+
+	os_get_reltime(&now);
+	for (; i < num; i++) {
+		e = entries[i].e;
+		if (os_reltime_initialized(&e->expires)) {
+			os_reltime_sub(&e->expires, &now, &ttl);
+			ret = os_snprintf(buf + len, end - len,
+					  MACSTR "/%ld\n", MAC2STR(e->sta),
+					  ttl.sec > 0 ? (long) ttl.sec : 1);
+		} else {
+			ret = os_snprintf(buf + len, end - len, MACSTR "\n",
+					  MAC2STR(e->sta));
+		}
+		if (os_snprintf_error(end - len, ret))
+			break;
+		len += ret;
+		last = e;
+	}
+	os_free(entries);
+
+	/* Each page ends with either END or CURSOR <last address> */
+	if (i == num)
+		ret = os_snprintf(buf + len, buflen - len, "END\n");
+	else if (last)
+		ret = os_snprintf(buf + len, buflen - len, "CURSOR " MACSTR "\n",
+				  MAC2STR(last->sta));
+	else
+		return -1; /* the first entry does not fit in the reply */
+	if (os_snprintf_error(buflen - len, ret))
+		return -1;
+	len += ret;
+
+	return len;
 }
 
 int hostapd_ctrl_iface_blacklist_clr(struct hostapd_data *hapd)
@@ -9,12 +9,19 @@
 #ifndef CTRL_IFACE_AP_H
 #define CTRL_IFACE_AP_H
 
+/* STA-DUMP reply size unless the requester asks for more with size=<bytes> */
+#define STA_DUMP_DEFAULT_REPLY 4096
+/* Largest STA-DUMP reply */
+#define STA_DUMP_MAX_REPLY 65536
+
 int hostapd_ctrl_iface_sta_first(struct hostapd_data *hapd,
 				 char *buf, size_t buflen);
 int hostapd_ctrl_iface_sta(struct hostapd_data *hapd, const char *txtaddr,
 			   char *buf, size_t buflen);
 int hostapd_ctrl_iface_sta_next(struct hostapd_data *hapd, const char *txtaddr,
 				char *buf, size_t buflen);
+int hostapd_ctrl_iface_sta_dump(struct hostapd_data *hapd, char *params,
+				char *buf, size_t buflen);
 int hostapd_ctrl_iface_deauthenticate(struct hostapd_data *hapd,
 				      const char *txtaddr);
 int hostapd_ctrl_iface_disassociate(struct hostapd_data *hapd,
@@ -28,7 +35,12 @@ int hostapd_ctrl_iface_blacklist_add(struct hostapd_data *hapd,
 					const char *txtaddr);
 int hostapd_ctrl_iface_blacklist_rm(struct hostapd_data *hapd,
 					const char *txtaddr);
+int hostapd_ctrl_iface_blacklist_load(struct hostapd_data *hapd,
+				      const char *cmd);
 int hostapd_ctrl_iface_blacklist_show(struct hostapd_data *hapd, char *buf,
 		size_t buflen);
+int hostapd_ctrl_iface_blacklist_dump(struct hostapd_data *hapd,
+				      const char *txtaddr, char *buf,
+				      size_t buflen);
 int hostapd_ctrl_iface_blacklist_clr(struct hostapd_data *hapd);
 #endif /* CTRL_IFACE_AP_H */
@@ -43,6 +43,8 @@
 #include "dhcp_snoop.h"
 #include "ndisc_snoop.h"
 #include "net_steering.h"
+#include "sta_blacklist.h"
+#include "taxonomy.h"
 
 
 static int hostapd_flush_old_stations(struct hostapd_data *hapd, u16 reason);
@@ -84,7 +86,7 @@ static void hostapd_reload_bss(struct hostapd_data *hapd)
 		 * Force PSK to be derived again since SSID or passphrase may
 		 * have changed.
 		 */
-		hostapd_config_clear_wpa_psk(&hapd->conf->ssid.wpa_psk);
+		hostapd_config_clear_wpa_psk(&hapd->conf->ssid);
 	}
 	if (hostapd_setup_wpa_psk(hapd->conf)) {
 		wpa_printf(MSG_ERROR, "Failed to re-configure WPA PSK "
@@ -125,6 +127,9 @@ static void hostapd_reload_bss(struct hostapd_data *hapd)
 		wpa_printf(MSG_ERROR, "Could not set SSID for kernel driver");
 		/* try to continue */
 	}
+#ifdef NEED_AP_MLME
+	sta_track_resolve_seen_on(hapd->iface->interfaces);
+#endif /* NEED_AP_MLME */
 	wpa_printf(MSG_DEBUG, "Reconfigured interface %s", hapd->conf->iface);
 }
 
@@ -264,6 +269,18 @@ static void hostapd_free_hapd_data(struct hostapd_data *hapd)
 	hapd->probereq_cb = NULL;
 	hapd->num_probereq_cb = 0;
 
+	sta_blacklist_deinit(hapd);
+#ifdef NEED_AP_MLME
+	sta_track_forget_seen_on(hapd);
+	hostapd_probe_resp_tmpl_flush(hapd);
+#endif /* NEED_AP_MLME */
+	os_free(hapd->probe_sources);
+	hapd->probe_sources = NULL;
+	ap_sta_hash_deinit(hapd);
+#ifdef CONFIG_CLIENT_TAXONOMY
+	hostapd_taxonomy_deinit(hapd);
+#endif /* CONFIG_CLIENT_TAXONOMY */
+
 #ifdef CONFIG_P2P
 	wpabuf_free(hapd->p2p_beacon_ie);
 	hapd->p2p_beacon_ie = NULL;
@@ -361,22 +378,6 @@ static void hostapd_cleanup(struct hostapd_data *hapd)
 }
 
 
-static void sta_track_deinit(struct hostapd_iface *iface)
-{
-	struct hostapd_sta_info *info;
-
-	if (!iface->num_sta_seen)
-		return;
-
-	while ((info = dl_list_first(&iface->sta_seen, struct hostapd_sta_info,
-				     list))) {
-		dl_list_del(&info->list);
-		iface->num_sta_seen--;
-		os_free(info);
-	}
-}
-
-
 static void hostapd_cleanup_iface_partial(struct hostapd_iface *iface)
 {
 	wpa_printf(MSG_DEBUG, "%s(%p)", __func__, iface);
@@ -392,7 +393,9 @@ static void hostapd_cleanup_iface_partial(struct hostapd_iface *iface)
 	os_free(iface->basic_rates);
 	iface->basic_rates = NULL;
 	ap_list_deinit(iface);
+#ifdef NEED_AP_MLME
 	sta_track_deinit(iface);
+#endif /* NEED_AP_MLME */
 }
 
 
@@ -1128,6 +1131,10 @@ static int hostapd_setup_bss(struct hostapd_data *hapd, int first)
 	if (hapd->driver && hapd->driver->set_operstate)
 		hapd->driver->set_operstate(hapd->drv_priv, 1);
 
+#ifdef NEED_AP_MLME
+	sta_track_resolve_seen_on(hapd->iface->interfaces);
+#endif /* NEED_AP_MLME */
+
 	return 0;
 }
 
@@ -1851,7 +1858,10 @@ hostapd_alloc_bss_data(struct hostapd_iface *hapd_iface,
 	hapd->iface = hapd_iface;
 	hapd->driver = hapd->iconf->driver;
 	hapd->ctrl_sock = -1;
-	hapd->blacklist = NULL;
+	dl_list_init(&hapd->blacklist);
+	if (os_get_random(hapd->blacklist_hash_key,
+			  sizeof(hapd->blacklist_hash_key)) < 0)
+		wpa_printf(MSG_DEBUG, "AP: Could not generate blacklist hash key");
 
 	return hapd;
 }
@@ -2908,6 +2918,10 @@ void hostapd_cleanup_cs_params(struct hostapd_data *hapd)
 	hapd->cs_c_off_beacon = 0;
 	hapd->cs_c_off_proberesp = 0;
 	hapd->csa_in_progress = 0;
+#ifdef NEED_AP_MLME
+	/* Templates built before the switch describe the old channel */
+	hostapd_probe_resp_tmpl_flush(hapd);
+#endif /* NEED_AP_MLME */
 }
 
 
@@ -101,6 +101,38 @@ struct wps_stat {
 };
 
 
+/**
+ * struct hostapd_probe_bucket - Probe Response token bucket
+ * @tokens: Available responses in units of 1/1000 response
+ * @refill: Time of the last refill
+ */
+struct hostapd_probe_bucket {
+	unsigned int tokens;
+	struct os_reltime refill;
+};
+
+/**
+ * struct hostapd_probe_source - Probe Request source for rate limiting
+ */
+struct hostapd_probe_source {
+	u8 addr[ETH_ALEN];
+	u32 ssid_hash;
+	struct hostapd_probe_bucket bucket;
+	struct os_reltime last_resp;
+};
+
+/**
+ * struct hostapd_probe_resp_tmpl - Cached Probe Response frame
+ * @buf: Frame built by hostapd_gen_probe_resp() without a destination
+ * @len: Length of @buf
+ * @bss_load_off: Offset of the BSS Load element body in @buf or 0
+ */
+struct hostapd_probe_resp_tmpl {
+	u8 *buf;
+	size_t len;
+	size_t bss_load_off;
+};
+
 /**
  * struct hostapd_data - hostapd per-BSS data structure
  */
@@ -117,12 +149,29 @@ struct hostapd_data {
 
 	int num_sta; /* number of entries in sta_list */
 	struct sta_info *sta_list; /* STA info list head */
-#define STA_HASH_SIZE 256
-#define STA_HASH(sta) (sta[5])
-	struct sta_info *sta_hash[STA_HASH_SIZE];
+	/*
+	 * sta_hash is allocated on demand and doubled in size whenever
+	 * num_sta would exceed the number of buckets. Buckets are selected
+	 * with hwaddr_hash() using a random per-BSS key.
+	 */
+#define STA_HASH_MIN_SIZE 64
+	struct sta_info **sta_hash;
+	unsigned int sta_hash_size; /* power of two */
+	u8 sta_hash_key[16];
 
 	// Client station blacklist support
-	struct sta_blacklist *blacklist;
+	struct dl_list blacklist; /* struct sta_blacklist */
+	/* Buckets are selected with hwaddr_hash() using a random key */
+#define STA_BLACKLIST_HASH_SIZE 256 /* power of two */
+	struct sta_blacklist *blacklist_hash[STA_BLACKLIST_HASH_SIZE];
+	u8 blacklist_hash_key[16];
+
+	/*
+	 * BSSs named by no_probe_resp_if_seen_on and no_auth_if_seen_on,
+	 * resolved once the BSSs are set up; see sta_track_resolve_seen_on()
+	 */
+	struct hostapd_data *no_probe_resp_seen_on;
+	struct hostapd_data *no_auth_seen_on;
 	/*
 	 * Bitfield for indicating which AIDs are allocated. Only AID values
 	 * 1-2007 are used and as such, the bit at index 0 corresponds to AID
@@ -146,8 +195,8 @@ struct hostapd_data {
 
 	struct iapp_data *iapp;
 
-	struct hostapd_cached_radius_acl *acl_cache;
-	struct hostapd_acl_query_data *acl_queries;
+	struct hostapd_acl_cache *acl_cache; /* RADIUS MAC ACL cache/queries */
+	struct hostapd_acct_sched *acct_sched; /* interim accounting updates */
 
 	struct wpa_authenticator *wpa_auth;
 	struct eapol_authenticator *eapol_auth;
@@ -159,6 +208,15 @@ struct hostapd_data {
 
 	int ctrl_sock;
 	struct wpa_ctrl_dst *ctrl_dst;
+	/* Binary event delivery to monitors; see bin_event.c */
+	void (*bin_event_cb)(const struct hostapd_data *hapd, const u8 *buf,
+			     size_t len);
+	unsigned int ctrl_bin_monitors; /* monitors with BINARY_EVENTS 1 */
+	unsigned int ctrl_text_monitors;
+	/* Per-command statistics of the control interface, indexed like the
+	 * command table in hostapd/ctrl_iface.c; the last entry counts
+	 * unknown commands */
+	struct ctrl_cmd_stats *ctrl_cmd_stats;
 
 	void *ssl_ctx;
 	void *eap_sim_db_priv;
@@ -235,6 +293,27 @@ struct hostapd_data {
 	/* BSS Load */
 	unsigned int bss_load_update_timeout;
 
+	/* Probe Response templates for non-P2P and P2P requests */
+	struct hostapd_probe_resp_tmpl probe_resp_tmpl[2];
+
+	/*
+	 * Probe Response rate limiting (direct-mapped by source); slots are
+	 * selected with hwaddr_hash() using a random key
+	 */
+#define PROBE_SOURCE_TABLE_SIZE 1024
+	struct hostapd_probe_source *probe_sources;
+	u8 probe_source_key[16];
+	unsigned long probe_resp_sent;
+	unsigned long probe_resp_dedup;
+	unsigned long probe_resp_limited;
+
+#ifdef CONFIG_CLIENT_TAXONOMY
+	/* Probe Request signatures of stations without a sta_info entry */
+	struct hostapd_taxonomy_entry *taxonomy_cache;
+	u8 taxonomy_cache_key[16];
+	unsigned int taxonomy_cache_sweep;
+#endif /* CONFIG_CLIENT_TAXONOMY */
+
 #ifdef CONFIG_P2P
 	struct p2p_data *p2p;
 	struct p2p_group *p2p_group;
@@ -286,6 +365,7 @@ struct hostapd_data {
 
 struct hostapd_sta_info {
 	struct dl_list list;
+	struct hostapd_sta_info *hnext; /* next entry in hash table list */
 	u8 addr[ETH_ALEN];
 	struct os_reltime last_seen;
 };
@@ -341,7 +421,9 @@ struct hostapd_iface {
 
 	int num_ap; /* number of entries in ap_list */
 	struct ap_info *ap_list; /* AP info list head */
-	struct ap_info *ap_hash[STA_HASH_SIZE];
+	struct ap_info **ap_hash; /* see sta_hash in struct hostapd_data */
+	unsigned int ap_hash_size;
+	u8 ap_hash_key[16];
 
 	u64 drv_flags;
 
@@ -428,8 +510,17 @@ struct hostapd_iface {
 	void (*scan_cb)(struct hostapd_iface *iface);
 	int num_ht40_scan_tries;
 
+	/* STA tracking list, least recently seen entry first */
 	struct dl_list sta_seen; /* struct hostapd_sta_info */
 	unsigned int num_sta_seen;
+	/* see sta_hash in struct hostapd_data */
+	struct hostapd_sta_info **sta_seen_hash;
+	unsigned int sta_seen_hash_size;
+	u8 sta_seen_hash_key[16];
+
+	/* Probe Response ceiling for all BSSs (probe_resp_max_rate) */
+	struct hostapd_probe_bucket probe_resp_bucket;
+	unsigned long probe_resp_global_limited;
 };
 
 /* hostapd.c */
@@ -27,6 +27,7 @@
 #include "hostapd.h"
 #include "beacon.h"
 #include "ieee802_11_auth.h"
+#include "sae_async.h"
 #include "sta_info.h"
 #include "sta_blacklist.h"
 #include "ieee802_1x.h"
@@ -422,7 +423,8 @@ static int use_sae_anti_clogging(struct hostapd_data *hapd)
 		if (!sta->sae)
 			continue;
 		if (sta->sae->state != SAE_COMMITTED &&
-		    sta->sae->state != SAE_CONFIRMED)
+		    sta->sae->state != SAE_CONFIRMED &&
+		    !sae_async_pending(sta))
 			continue;
 		open++;
 		if (open >= hapd->conf->sae_anti_clogging_threshold)
@@ -543,8 +545,12 @@ static void sae_set_retransmit_timer(struct hostapd_data *hapd,
 }
 
 
+/*
+ * With crypto_done set, the own commit has already been prepared and the
+ * received Commit message processed by sae_async_commit() for this step.
+ */
 static int sae_sm_step(struct hostapd_data *hapd, struct sta_info *sta,
-		       const u8 *bssid, u8 auth_transaction)
+		       const u8 *bssid, u8 auth_transaction, int crypto_done)
 {
 	int ret;
 
@@ -554,12 +560,13 @@ static int sae_sm_step(struct hostapd_data *hapd, struct sta_info *sta,
 	switch (sta->sae->state) {
 	case SAE_NOTHING:
 		if (auth_transaction == 1) {
-			ret = auth_sae_send_commit(hapd, sta, bssid, 1);
+			ret = auth_sae_send_commit(hapd, sta, bssid,
+						   !crypto_done);
 			if (ret)
 				return ret;
 			sta->sae->state = SAE_COMMITTED;
 
-			if (sae_process_commit(sta->sae) < 0)
+			if (!crypto_done && sae_process_commit(sta->sae) < 0)
 				return WLAN_STATUS_UNSPECIFIED_FAILURE;
 
 			/*
@@ -602,7 +609,7 @@ static int sae_sm_step(struct hostapd_data *hapd, struct sta_info *sta,
 	case SAE_COMMITTED:
 		sae_clear_retransmit_timer(hapd, sta);
 		if (auth_transaction == 1) {
-			if (sae_process_commit(sta->sae) < 0)
+			if (!crypto_done && sae_process_commit(sta->sae) < 0)
 				return WLAN_STATUS_UNSPECIFIED_FAILURE;
 
 			ret = auth_sae_send_confirm(hapd, sta, bssid);
@@ -642,7 +649,8 @@ static int sae_sm_step(struct hostapd_data *hapd, struct sta_info *sta,
 			 * step to get to Accepted without waiting for
 			 * additional events.
 			 */
-			return sae_sm_step(hapd, sta, bssid, auth_transaction);
+			return sae_sm_step(hapd, sta, bssid, auth_transaction,
+					   0);
 		}
 		break;
 	case SAE_CONFIRMED:
@@ -652,11 +660,12 @@ static int sae_sm_step(struct hostapd_data *hapd, struct sta_info *sta,
 				return WLAN_STATUS_SUCCESS;
 			sta->sae->sync++;
 
-			ret = auth_sae_send_commit(hapd, sta, bssid, 1);
+			ret = auth_sae_send_commit(hapd, sta, bssid,
+						   !crypto_done);
 			if (ret)
 				return ret;
 
-			if (sae_process_commit(sta->sae) < 0)
+			if (!crypto_done && sae_process_commit(sta->sae) < 0)
 				return WLAN_STATUS_UNSPECIFIED_FAILURE;
 
 			ret = auth_sae_send_confirm(hapd, sta, bssid);
@@ -700,6 +709,67 @@ static int sae_sm_step(struct hostapd_data *hapd, struct sta_info *sta,
 }
 
 
+static void auth_sae_commit_done(void *eloop_ctx, void *user_ctx, int res)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	struct sta_info *sta = user_ctx;
+	u16 resp;
+
+	if (res < 0)
+		resp = WLAN_STATUS_UNSPECIFIED_FAILURE;
+	else
+		resp = sae_sm_step(hapd, sta, hapd->own_addr, 1, 1);
+	if (resp != WLAN_STATUS_SUCCESS)
+		send_auth_reply(hapd, sta->addr, hapd->own_addr, WLAN_AUTH_SAE,
+				1, resp, (u8 *) "", 0);
+}
+
+
+/*
+ * In infrastructure BSS, the PWE derivation and the shared key computation
+ * for a received Commit message are done by sae_async and the state machine
+ * step is completed from auth_sae_commit_done(). Returns 1 if the Commit
+ * message was queued or dropped and 0 if it is to be processed now.
+ */
+static int auth_sae_queue_commit(struct hostapd_data *hapd,
+				 struct sta_info *sta)
+{
+	const char *password = hapd->conf->ssid.wpa_passphrase;
+	int ret;
+
+	if ((hapd->conf->mesh & MESH_ENABLED) || password == NULL)
+		return 0;
+
+	switch (sta->sae->state) {
+	case SAE_NOTHING:
+		break;
+	case SAE_COMMITTED:
+		/* Own commit was already sent; only process the peer's one */
+		password = NULL;
+		break;
+	case SAE_CONFIRMED:
+		/* Leave the sync limit to sae_sm_step() without crypto */
+		if (sta->sae->sync > dot11RSNASAESync)
+			return 0;
+		break;
+	default:
+		return 0;
+	}
+
+	ret = sae_async_commit(sta->sae, hapd->own_addr, sta->addr,
+			       (const u8 *) password,
+			       password ? os_strlen(password) : 0,
+			       auth_sae_commit_done, hapd, sta);
+	if (ret == 1) {
+		wpa_printf(MSG_DEBUG,
+			   "SAE: Too many pending commit messages - drop commit from "
+			   MACSTR, MAC2STR(sta->addr));
+		return 1;
+	}
+	return ret == 0;
+}
+
+
 static void handle_auth_sae(struct hostapd_data *hapd, struct sta_info *sta,
 			    const struct ieee80211_mgmt *mgmt, size_t len,
 			    u16 auth_transaction, u16 status_code)
@@ -707,6 +777,14 @@ static void handle_auth_sae(struct hostapd_data *hapd, struct sta_info *sta,
 	u16 resp = WLAN_STATUS_SUCCESS;
 	struct wpabuf *data = NULL;
 
+	if (sta->sae && sae_async_pending(sta)) {
+		wpa_printf(MSG_DEBUG,
+			   "SAE: Drop Authentication frame from " MACSTR
+			   " while its previous commit is being processed",
+			   MAC2STR(sta->addr));
+		return;
+	}
+
 	if (!sta->sae) {
 		if (auth_transaction != 1 || status_code != WLAN_STATUS_SUCCESS)
 			return;
@@ -809,7 +887,9 @@ static void handle_auth_sae(struct hostapd_data *hapd, struct sta_info *sta,
 			goto reply;
 		}
 
-		resp = sae_sm_step(hapd, sta, mgmt->bssid, auth_transaction);
+		if (auth_sae_queue_commit(hapd, sta))
+			return;
+		resp = sae_sm_step(hapd, sta, mgmt->bssid, auth_transaction, 0);
 	} else if (auth_transaction == 2) {
 		hostapd_logger(hapd, sta->addr, HOSTAPD_MODULE_IEEE80211,
 			       HOSTAPD_LEVEL_DEBUG,
@@ -826,7 +906,7 @@ static void handle_auth_sae(struct hostapd_data *hapd, struct sta_info *sta,
 				goto reply;
 			}
 		}
-		resp = sae_sm_step(hapd, sta, mgmt->bssid, auth_transaction);
+		resp = sae_sm_step(hapd, sta, mgmt->bssid, auth_transaction, 0);
 	} else {
 		hostapd_logger(hapd, sta->addr, HOSTAPD_MODULE_IEEE80211,
 			       HOSTAPD_LEVEL_DEBUG,
@@ -993,12 +1073,10 @@ static void handle_auth(struct hostapd_data *hapd,
 		goto fail;
 	}
 
-	if (hapd->conf->no_auth_if_seen_on) {
-		struct hostapd_data *other;
+	if (hapd->no_auth_seen_on) {
+		struct hostapd_data *other = hapd->no_auth_seen_on;
 
-		other = sta_track_seen_on(hapd->iface, mgmt->sa,
-					  hapd->conf->no_auth_if_seen_on);
-		if (other) {
+		if (sta_track_seen_on(other, mgmt->sa)) {
 			u8 *pos;
 			u32 info;
 			u8 op_class, channel, phytype;
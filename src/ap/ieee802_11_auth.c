@@ -15,7 +15,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
-#include "crypto/sha1.h"
+#include "utils/list.h"
 #include "radius/radius.h"
 #include "radius/radius_client.h"
 #include "hostapd.h"
@@ -24,15 +24,18 @@
 #include "ieee802_11.h"
 #include "ieee802_1x.h"
 #include "ieee802_11_auth.h"
+#include "psk_derive.h"
 
-#define RADIUS_ACL_TIMEOUT 30
+#define RADIUS_ACL_QUERY_TIMEOUT 30
+#define RADIUS_ACL_HASH_MIN_SIZE 64
 
 
 struct hostapd_cached_radius_acl {
 	struct os_reltime timestamp;
 	macaddr addr;
 	int accepted; /* HOSTAPD_ACL_* */
-	struct hostapd_cached_radius_acl *next;
+	struct hostapd_cached_radius_acl *hnext; /* next entry in hash bucket */
+	struct dl_list list; /* entry in accepted/rejected expiration list */
 	u32 session_timeout;
 	u32 acct_interim_interval;
 	int vlan_id;
@@ -43,12 +46,42 @@ struct hostapd_cached_radius_acl {
 
 
 struct hostapd_acl_query_data {
+	struct hostapd_data *hapd;
 	struct os_reltime timestamp;
 	u8 radius_id;
+	u8 radius_authenticator[16];
 	macaddr addr;
 	u8 *auth_msg; /* IEEE 802.11 authentication frame from station */
 	size_t auth_msg_len;
-	struct hostapd_acl_query_data *next;
+	struct dl_list list;
+	/* Cache entry from the RADIUS response while PSKs are being derived */
+	struct hostapd_cached_radius_acl *entry;
+	unsigned int psk_pending;
+};
+
+
+/*
+ * RADIUS ACL cache. Entries are found through a keyed hash of the STA address
+ * and are also kept in insertion order on one list per lifetime (Accept and
+ * Reject), so both lists are in expiration order and expiring entries only
+ * touches the entries that have actually expired.
+ */
+struct hostapd_acl_cache {
+	struct hostapd_cached_radius_acl **hash;
+	unsigned int hash_size; /* power of two */
+	u8 hash_key[16];
+	unsigned int num_entries;
+	struct dl_list accepted;
+	struct dl_list rejected;
+
+	struct dl_list queries; /* pending RADIUS queries, oldest first */
+	unsigned int num_queries;
+
+	u32 hits;
+	u32 negative_hits;
+	u32 misses;
+	u32 expirations;
+	u32 evictions;
 };
 
 
@@ -62,15 +95,206 @@ static void hostapd_acl_cache_free_entry(struct hostapd_cached_radius_acl *e)
 }
 
 
-static void hostapd_acl_cache_free(struct hostapd_cached_radius_acl *acl_cache)
+static void hostapd_acl_query_free(struct hostapd_acl_query_data *query)
+{
+	if (query == NULL)
+		return;
+	if (query->psk_pending)
+		psk_derive_cancel(query);
+	if (query->entry)
+		hostapd_acl_cache_free_entry(query->entry);
+	os_free(query->auth_msg);
+	os_free(query);
+}
+
+
+static struct hostapd_acl_cache * hostapd_acl_cache_init(void)
+{
+	struct hostapd_acl_cache *cache;
+
+	cache = os_zalloc(sizeof(*cache));
+	if (cache == NULL)
+		return NULL;
+	dl_list_init(&cache->accepted);
+	dl_list_init(&cache->rejected);
+	dl_list_init(&cache->queries);
+	if (os_get_random(cache->hash_key, sizeof(cache->hash_key)) < 0)
+		wpa_printf(MSG_INFO, "ACL: Failed to get random hash key");
+
+	return cache;
+}
+
+
+static void hostapd_acl_cache_deinit(struct hostapd_acl_cache *cache)
+{
+	struct hostapd_cached_radius_acl *entry, *tmp;
+	struct hostapd_acl_query_data *query, *qtmp;
+
+	if (cache == NULL)
+		return;
+
+	dl_list_for_each_safe(entry, tmp, &cache->accepted,
+			      struct hostapd_cached_radius_acl, list)
+		hostapd_acl_cache_free_entry(entry);
+	dl_list_for_each_safe(entry, tmp, &cache->rejected,
+			      struct hostapd_cached_radius_acl, list)
+		hostapd_acl_cache_free_entry(entry);
+	dl_list_for_each_safe(query, qtmp, &cache->queries,
+			      struct hostapd_acl_query_data, list)
+		hostapd_acl_query_free(query);
+	os_free(cache->hash);
+	os_free(cache);
+}
+
+
+static int hostapd_acl_cache_ttl(struct hostapd_data *hapd,
+				 struct hostapd_cached_radius_acl *entry)
+{
+	if (entry->accepted == HOSTAPD_ACL_REJECT)
+		return hapd->conf->radius_acl_negative_timeout;
+	return hapd->conf->radius_acl_timeout;
+}
+
+
+static int hostapd_acl_hash_resize(struct hostapd_acl_cache *cache,
+				   unsigned int size)
+{
+	struct hostapd_cached_radius_acl **hash, *entry, *next;
+	unsigned int i, idx;
+
+	hash = os_calloc(size, sizeof(*hash));
+	if (hash == NULL)
+		return -1;
+
+	for (i = 0; i < cache->hash_size; i++) {
+		for (entry = cache->hash[i]; entry; entry = next) {
+			next = entry->hnext;
+			idx = hwaddr_hash(cache->hash_key, entry->addr) &
+				(size - 1);
+			entry->hnext = hash[idx];
+			hash[idx] = entry;
+		}
+	}
+
+	os_free(cache->hash);
+	cache->hash = hash;
+	cache->hash_size = size;
+
+	return 0;
+}
+
+
+static struct hostapd_cached_radius_acl *
+hostapd_acl_cache_find(struct hostapd_acl_cache *cache, const u8 *addr)
 {
-	struct hostapd_cached_radius_acl *prev;
+	struct hostapd_cached_radius_acl *entry;
+
+	if (cache->hash == NULL)
+		return NULL;
+
+	entry = cache->hash[hwaddr_hash(cache->hash_key, addr) &
+			    (cache->hash_size - 1)];
+	while (entry && os_memcmp(entry->addr, addr, ETH_ALEN) != 0)
+		entry = entry->hnext;
+	return entry;
+}
+
+
+static void hostapd_acl_cache_unlink(struct hostapd_acl_cache *cache,
+				     struct hostapd_cached_radius_acl *entry)
+{
+	struct hostapd_cached_radius_acl **pos;
+
+	pos = &cache->hash[hwaddr_hash(cache->hash_key, entry->addr) &
+			   (cache->hash_size - 1)];
+	while (*pos && *pos != entry)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = entry->hnext;
+	dl_list_del(&entry->list);
+	cache->num_entries--;
+}
+
+
+static void hostapd_acl_cache_expire_entry(
+	struct hostapd_data *hapd, struct hostapd_cached_radius_acl *entry)
+{
+	wpa_printf(MSG_DEBUG, "Cached ACL entry for " MACSTR " has expired.",
+		   MAC2STR(entry->addr));
+	hostapd_acl_cache_unlink(hapd->acl_cache, entry);
+	hapd->acl_cache->expirations++;
+	hostapd_drv_set_radius_acl_expire(hapd, entry->addr);
+	hostapd_acl_cache_free_entry(entry);
+}
+
+
+/* Remove the entry that would expire first to make room for a new one */
+static void hostapd_acl_cache_evict(struct hostapd_data *hapd)
+{
+	struct hostapd_acl_cache *cache = hapd->acl_cache;
+	struct hostapd_cached_radius_acl *acc, *rej, *entry;
+	struct os_reltime acc_exp, rej_exp;
+
+	acc = dl_list_first(&cache->accepted, struct hostapd_cached_radius_acl,
+			    list);
+	rej = dl_list_first(&cache->rejected, struct hostapd_cached_radius_acl,
+			    list);
+	if (acc == NULL || rej == NULL) {
+		entry = acc ? acc : rej;
+		if (entry == NULL)
+			return;
+	} else {
+		acc_exp = acc->timestamp;
+		acc_exp.sec += hostapd_acl_cache_ttl(hapd, acc);
+		rej_exp = rej->timestamp;
+		rej_exp.sec += hostapd_acl_cache_ttl(hapd, rej);
+		entry = os_reltime_before(&rej_exp, &acc_exp) ? rej : acc;
+	}
+
+	wpa_printf(MSG_DEBUG, "Removing cached ACL entry for " MACSTR
+		   " due to cache size limit", MAC2STR(entry->addr));
+	hostapd_acl_cache_unlink(cache, entry);
+	cache->evictions++;
+	hostapd_drv_set_radius_acl_expire(hapd, entry->addr);
+	hostapd_acl_cache_free_entry(entry);
+}
+
 
-	while (acl_cache) {
-		prev = acl_cache;
-		acl_cache = acl_cache->next;
-		hostapd_acl_cache_free_entry(prev);
+static int hostapd_acl_cache_add(struct hostapd_data *hapd,
+				 struct hostapd_cached_radius_acl *entry)
+{
+	struct hostapd_acl_cache *cache = hapd->acl_cache;
+	struct hostapd_cached_radius_acl *old;
+	unsigned int idx;
+
+	old = hostapd_acl_cache_find(cache, entry->addr);
+	if (old) {
+		hostapd_acl_cache_unlink(cache, old);
+		hostapd_acl_cache_free_entry(old);
 	}
+
+	if (hapd->conf->radius_acl_cache_size &&
+	    cache->num_entries >= hapd->conf->radius_acl_cache_size)
+		hostapd_acl_cache_evict(hapd);
+
+	if (cache->num_entries >= cache->hash_size &&
+	    hostapd_acl_hash_resize(cache, cache->hash_size ?
+				    cache->hash_size * 2 :
+				    RADIUS_ACL_HASH_MIN_SIZE) < 0 &&
+	    cache->hash == NULL)
+		return -1;
+
+	idx = hwaddr_hash(cache->hash_key, entry->addr) &
+		(cache->hash_size - 1);
+	entry->hnext = cache->hash[idx];
+	cache->hash[idx] = entry;
+	if (entry->accepted == HOSTAPD_ACL_REJECT)
+		dl_list_add_tail(&cache->rejected, &entry->list);
+	else
+		dl_list_add_tail(&cache->accepted, &entry->list);
+	cache->num_entries++;
+
+	return 0;
 }
 
 
@@ -103,56 +327,53 @@ static int hostapd_acl_cache_get(struct hostapd_data *hapd, const u8 *addr,
 				 struct hostapd_sta_wpa_psk_short **psk,
 				 char **identity, char **radius_cui)
 {
+	struct hostapd_acl_cache *cache = hapd->acl_cache;
 	struct hostapd_cached_radius_acl *entry;
 	struct os_reltime now;
 
-	os_get_reltime(&now);
+	entry = hostapd_acl_cache_find(cache, addr);
+	if (entry == NULL) {
+		cache->misses++;
+		return -1;
+	}
 
-	for (entry = hapd->acl_cache; entry; entry = entry->next) {
-		if (os_memcmp(entry->addr, addr, ETH_ALEN) != 0)
-			continue;
-
-		if (os_reltime_expired(&now, &entry->timestamp,
-				       RADIUS_ACL_TIMEOUT))
-			return -1; /* entry has expired */
-		if (entry->accepted == HOSTAPD_ACL_ACCEPT_TIMEOUT)
-			if (session_timeout)
-				*session_timeout = entry->session_timeout;
-		if (acct_interim_interval)
-			*acct_interim_interval =
-				entry->acct_interim_interval;
-		if (vlan_id)
-			*vlan_id = entry->vlan_id;
-		copy_psk_list(psk, entry->psk);
-		if (identity) {
-			if (entry->identity)
-				*identity = os_strdup(entry->identity);
-			else
-				*identity = NULL;
-		}
-		if (radius_cui) {
-			if (entry->radius_cui)
-				*radius_cui = os_strdup(entry->radius_cui);
-			else
-				*radius_cui = NULL;
-		}
-		return entry->accepted;
+	os_get_reltime(&now);
+	if (os_reltime_expired(&now, &entry->timestamp,
+			       hostapd_acl_cache_ttl(hapd, entry))) {
+		hostapd_acl_cache_expire_entry(hapd, entry);
+		cache->misses++;
+		return -1; /* entry has expired */
 	}
 
-	return -1;
+	if (entry->accepted == HOSTAPD_ACL_REJECT)
+		cache->negative_hits++;
+	else
+		cache->hits++;
+	if (entry->accepted == HOSTAPD_ACL_ACCEPT_TIMEOUT)
+		if (session_timeout)
+			*session_timeout = entry->session_timeout;
+	if (acct_interim_interval)
+		*acct_interim_interval = entry->acct_interim_interval;
+	if (vlan_id)
+		*vlan_id = entry->vlan_id;
+	copy_psk_list(psk, entry->psk);
+	if (identity) {
+		if (entry->identity)
+			*identity = os_strdup(entry->identity);
+		else
+			*identity = NULL;
+	}
+	if (radius_cui) {
+		if (entry->radius_cui)
+			*radius_cui = os_strdup(entry->radius_cui);
+		else
+			*radius_cui = NULL;
+	}
+	return entry->accepted;
 }
 #endif /* CONFIG_NO_RADIUS */
 
 
-static void hostapd_acl_query_free(struct hostapd_acl_query_data *query)
-{
-	if (query == NULL)
-		return;
-	os_free(query->auth_msg);
-	os_free(query);
-}
-
-
 #ifndef CONFIG_NO_RADIUS
 static int hostapd_radius_acl_query(struct hostapd_data *hapd, const u8 *addr,
 				    struct hostapd_acl_query_data *query)
@@ -166,6 +387,9 @@ static int hostapd_radius_acl_query(struct hostapd_data *hapd, const u8 *addr,
 		return -1;
 
 	radius_msg_make_authenticator(msg, addr, ETH_ALEN);
+	os_memcpy(query->radius_authenticator,
+		  radius_msg_get_hdr(msg)->authenticator,
+		  sizeof(query->radius_authenticator));
 
 	os_snprintf(buf, sizeof(buf), RADIUS_ADDR_FORMAT, MAC2STR(addr));
 	if (!radius_msg_add_attr(msg, RADIUS_ATTR_USER_NAME, (u8 *) buf,
@@ -266,20 +490,26 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 		return HOSTAPD_ACL_REJECT;
 #else /* CONFIG_NO_RADIUS */
 		struct hostapd_acl_query_data *query;
+		int res;
+
+		if (hapd->acl_cache == NULL) {
+			hapd->acl_cache = hostapd_acl_cache_init();
+			if (hapd->acl_cache == NULL)
+				return HOSTAPD_ACL_REJECT;
+		}
 
 		/* Check whether ACL cache has an entry for this station */
-		int res = hostapd_acl_cache_get(hapd, addr, session_timeout,
-						acct_interim_interval,
-						vlan_id, psk,
-						identity, radius_cui);
+		res = hostapd_acl_cache_get(hapd, addr, session_timeout,
+					    acct_interim_interval, vlan_id, psk,
+					    identity, radius_cui);
 		if (res == HOSTAPD_ACL_ACCEPT ||
 		    res == HOSTAPD_ACL_ACCEPT_TIMEOUT)
 			return res;
 		if (res == HOSTAPD_ACL_REJECT)
 			return HOSTAPD_ACL_REJECT;
 
-		query = hapd->acl_queries;
-		while (query) {
+		dl_list_for_each(query, &hapd->acl_cache->queries,
+				 struct hostapd_acl_query_data, list) {
 			if (os_memcmp(query->addr, addr, ETH_ALEN) == 0) {
 				/* pending query in RADIUS retransmit queue;
 				 * do not generate a new one */
@@ -293,7 +523,6 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 				}
 				return HOSTAPD_ACL_PENDING;
 			}
-			query = query->next;
 		}
 
 		if (!hapd->conf->radius->auth_server)
@@ -305,6 +534,7 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 			wpa_printf(MSG_ERROR, "malloc for query data failed");
 			return HOSTAPD_ACL_REJECT;
 		}
+		query->hapd = hapd;
 		os_get_reltime(&query->timestamp);
 		os_memcpy(query->addr, addr, ETH_ALEN);
 		if (hostapd_radius_acl_query(hapd, addr, query)) {
@@ -323,8 +553,8 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 		}
 		os_memcpy(query->auth_msg, msg, len);
 		query->auth_msg_len = len;
-		query->next = hapd->acl_queries;
-		hapd->acl_queries = query;
+		dl_list_add_tail(&hapd->acl_cache->queries, &query->list);
+		hapd->acl_cache->num_queries++;
 
 		/* Queued data will be processed in hostapd_acl_recv_radius()
 		 * when RADIUS server replies to the sent Access-Request. */
@@ -338,61 +568,35 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 
 #ifndef CONFIG_NO_RADIUS
 static void hostapd_acl_expire_cache(struct hostapd_data *hapd,
+				     struct dl_list *list, int ttl,
 				     struct os_reltime *now)
 {
-	struct hostapd_cached_radius_acl *prev, *entry, *tmp;
-
-	prev = NULL;
-	entry = hapd->acl_cache;
-
-	while (entry) {
-		if (os_reltime_expired(now, &entry->timestamp,
-				       RADIUS_ACL_TIMEOUT)) {
-			wpa_printf(MSG_DEBUG, "Cached ACL entry for " MACSTR
-				   " has expired.", MAC2STR(entry->addr));
-			if (prev)
-				prev->next = entry->next;
-			else
-				hapd->acl_cache = entry->next;
-			hostapd_drv_set_radius_acl_expire(hapd, entry->addr);
-			tmp = entry;
-			entry = entry->next;
-			hostapd_acl_cache_free_entry(tmp);
-			continue;
-		}
+	struct hostapd_cached_radius_acl *entry;
 
-		prev = entry;
-		entry = entry->next;
-	}
+	/* The list is in insertion order and all entries share the same
+	 * lifetime, so stop at the first entry that has not yet expired */
+	while ((entry = dl_list_first(list, struct hostapd_cached_radius_acl,
+				      list)) &&
+	       os_reltime_expired(now, &entry->timestamp, ttl))
+		hostapd_acl_cache_expire_entry(hapd, entry);
 }
 
 
 static void hostapd_acl_expire_queries(struct hostapd_data *hapd,
 				       struct os_reltime *now)
 {
-	struct hostapd_acl_query_data *prev, *entry, *tmp;
-
-	prev = NULL;
-	entry = hapd->acl_queries;
-
-	while (entry) {
-		if (os_reltime_expired(now, &entry->timestamp,
-				       RADIUS_ACL_TIMEOUT)) {
-			wpa_printf(MSG_DEBUG, "ACL query for " MACSTR
-				   " has expired.", MAC2STR(entry->addr));
-			if (prev)
-				prev->next = entry->next;
-			else
-				hapd->acl_queries = entry->next;
-
-			tmp = entry;
-			entry = entry->next;
-			hostapd_acl_query_free(tmp);
-			continue;
-		}
-
-		prev = entry;
-		entry = entry->next;
+	struct hostapd_acl_cache *cache = hapd->acl_cache;
+	struct hostapd_acl_query_data *entry;
+
+	while ((entry = dl_list_first(&cache->queries,
+				      struct hostapd_acl_query_data, list)) &&
+	       os_reltime_expired(now, &entry->timestamp,
+				  RADIUS_ACL_QUERY_TIMEOUT)) {
+		wpa_printf(MSG_DEBUG, "ACL query for " MACSTR
+			   " has expired.", MAC2STR(entry->addr));
+		dl_list_del(&entry->list);
+		cache->num_queries--;
+		hostapd_acl_query_free(entry);
 	}
 }
 
@@ -405,19 +609,66 @@ void hostapd_acl_expire(struct hostapd_data *hapd)
 {
 	struct os_reltime now;
 
+	if (hapd->acl_cache == NULL)
+		return;
+
 	os_get_reltime(&now);
-	hostapd_acl_expire_cache(hapd, &now);
+	hostapd_acl_expire_cache(hapd, &hapd->acl_cache->accepted,
+				 hapd->conf->radius_acl_timeout, &now);
+	hostapd_acl_expire_cache(hapd, &hapd->acl_cache->rejected,
+				 hapd->conf->radius_acl_negative_timeout, &now);
 	hostapd_acl_expire_queries(hapd, &now);
 }
 
 
+static void hostapd_acl_query_finish(struct hostapd_data *hapd,
+				     struct hostapd_acl_query_data *query)
+{
+	struct hostapd_cached_radius_acl *cache = query->entry;
+
+	query->entry = NULL;
+	if (hostapd_acl_cache_add(hapd, cache) < 0) {
+		wpa_printf(MSG_DEBUG, "Failed to add ACL cache entry");
+		hostapd_acl_cache_free_entry(cache);
+		goto done;
+	}
+
+#ifdef CONFIG_DRIVER_RADIUS_ACL
+	hostapd_drv_set_radius_acl_auth(hapd, query->addr, cache->accepted,
+					cache->session_timeout);
+#else /* CONFIG_DRIVER_RADIUS_ACL */
+#ifdef NEED_AP_MLME
+	/* Re-send original authentication frame for 802.11 processing */
+	wpa_printf(MSG_DEBUG, "Re-sending authentication frame after "
+		   "successful RADIUS ACL query");
+	ieee802_11_mgmt(hapd, query->auth_msg, query->auth_msg_len, NULL);
+#endif /* NEED_AP_MLME */
+#endif /* CONFIG_DRIVER_RADIUS_ACL */
+
+ done:
+	dl_list_del(&query->list);
+	hapd->acl_cache->num_queries--;
+	hostapd_acl_query_free(query);
+}
+
+
+static void hostapd_acl_psk_derived(void *ctx)
+{
+	struct hostapd_acl_query_data *query = ctx;
+
+	if (--query->psk_pending == 0)
+		hostapd_acl_query_finish(query->hapd, query);
+}
+
+
 static void decode_tunnel_passwords(struct hostapd_data *hapd,
 				    const u8 *shared_secret,
 				    size_t shared_secret_len,
 				    struct radius_msg *msg,
 				    struct radius_msg *req,
-				    struct hostapd_cached_radius_acl *cache)
+				    struct hostapd_acl_query_data *query)
 {
+	struct hostapd_cached_radius_acl *cache = query->entry;
 	int passphraselen;
 	char *passphrase, *strpassphrase;
 	size_t i;
@@ -425,6 +676,9 @@ static void decode_tunnel_passwords(struct hostapd_data *hapd,
 
 	/*
 	 * Decode all tunnel passwords as PSK and save them into a linked list.
+	 * PSKs that are not found from the derivation cache are filled in
+	 * asynchronously and the query is completed once all of them are
+	 * available.
 	 */
 	for (i = 0; ; i++) {
 		passphrase = radius_msg_get_tunnel_password(
@@ -438,16 +692,18 @@ static void decode_tunnel_passwords(struct hostapd_data *hapd,
 			break;
 		/*
 		 * passphrase does not contain the NULL termination.
-		 * Add it here as pbkdf2_sha1() requires it.
+		 * Add it here as psk_derive_start() requires it.
 		 */
 		strpassphrase = os_zalloc(passphraselen + 1);
 		psk = os_zalloc(sizeof(struct hostapd_sta_wpa_psk_short));
 		if (strpassphrase && psk) {
 			os_memcpy(strpassphrase, passphrase, passphraselen);
-			pbkdf2_sha1(strpassphrase,
-				    hapd->conf->ssid.ssid,
-				    hapd->conf->ssid.ssid_len, 4096,
-				    psk->psk, PMK_LEN);
+			if (psk_derive_start(strpassphrase,
+					     hapd->conf->ssid.ssid,
+					     hapd->conf->ssid.ssid_len,
+					     psk->psk, hostapd_acl_psk_derived,
+					     query) == 0)
+				query->psk_pending++;
 			psk->next = cache->psk;
 			cache->psk = psk;
 			psk = NULL;
@@ -475,19 +731,25 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 			void *data)
 {
 	struct hostapd_data *hapd = data;
-	struct hostapd_acl_query_data *query, *prev;
+	struct hostapd_acl_query_data *query;
 	struct hostapd_cached_radius_acl *cache;
 	struct radius_hdr *hdr = radius_msg_get_hdr(msg);
+	int found = 0;
 
-	query = hapd->acl_queries;
-	prev = NULL;
-	while (query) {
-		if (query->radius_id == hdr->identifier)
+	if (hapd->acl_cache == NULL)
+		return RADIUS_RX_UNKNOWN;
+
+	dl_list_for_each(query, &hapd->acl_cache->queries,
+			 struct hostapd_acl_query_data, list) {
+		if (query->radius_id == hdr->identifier &&
+		    os_memcmp(query->radius_authenticator,
+			      radius_msg_get_hdr(req)->authenticator,
+			      sizeof(query->radius_authenticator)) == 0) {
+			found = 1;
 			break;
-		prev = query;
-		query = query->next;
+		}
 	}
-	if (query == NULL)
+	if (!found)
 		return RADIUS_RX_UNKNOWN;
 
 	wpa_printf(MSG_DEBUG, "Found matching Access-Request for RADIUS "
@@ -499,6 +761,12 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 		return RADIUS_RX_INVALID_AUTHENTICATOR;
 	}
 
+	if (query->entry) {
+		wpa_printf(MSG_DEBUG, "Ignored duplicate response to ACL query "
+			   "for " MACSTR, MAC2STR(query->addr));
+		return RADIUS_RX_PROCESSED;
+	}
+
 	if (hdr->code != RADIUS_CODE_ACCESS_ACCEPT &&
 	    hdr->code != RADIUS_CODE_ACCESS_REJECT) {
 		wpa_printf(MSG_DEBUG, "Unknown RADIUS message code %d to ACL "
@@ -510,8 +778,12 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 	cache = os_zalloc(sizeof(*cache));
 	if (cache == NULL) {
 		wpa_printf(MSG_DEBUG, "Failed to add ACL cache entry");
-		goto done;
+		dl_list_del(&query->list);
+		hapd->acl_cache->num_queries--;
+		hostapd_acl_query_free(query);
+		return RADIUS_RX_PROCESSED;
 	}
+	query->entry = cache;
 	os_get_reltime(&cache->timestamp);
 	os_memcpy(cache->addr, query->addr, sizeof(cache->addr));
 	if (hdr->code == RADIUS_CODE_ACCESS_ACCEPT) {
@@ -538,7 +810,7 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 		cache->vlan_id = radius_msg_get_vlanid(msg);
 
 		decode_tunnel_passwords(hapd, shared_secret, shared_secret_len,
-					msg, req, cache);
+					msg, req, query);
 
 		if (radius_msg_get_attr_ptr(msg, RADIUS_ATTR_USER_NAME,
 					    &buf, &len, NULL) == 0) {
@@ -572,28 +844,14 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 			cache->accepted = HOSTAPD_ACL_REJECT;
 	} else
 		cache->accepted = HOSTAPD_ACL_REJECT;
-	cache->next = hapd->acl_cache;
-	hapd->acl_cache = cache;
-
-#ifdef CONFIG_DRIVER_RADIUS_ACL
-	hostapd_drv_set_radius_acl_auth(hapd, query->addr, cache->accepted,
-					cache->session_timeout);
-#else /* CONFIG_DRIVER_RADIUS_ACL */
-#ifdef NEED_AP_MLME
-	/* Re-send original authentication frame for 802.11 processing */
-	wpa_printf(MSG_DEBUG, "Re-sending authentication frame after "
-		   "successful RADIUS ACL query");
-	ieee802_11_mgmt(hapd, query->auth_msg, query->auth_msg_len, NULL);
-#endif /* NEED_AP_MLME */
-#endif /* CONFIG_DRIVER_RADIUS_ACL */
 
- done:
-	if (prev == NULL)
-		hapd->acl_queries = query->next;
-	else
-		prev->next = query->next;
-
-	hostapd_acl_query_free(query);
+	if (query->psk_pending) {
+		wpa_printf(MSG_DEBUG, "Deriving %u PSK(s) for " MACSTR
+			   " before completing ACL query",
+			   query->psk_pending, MAC2STR(query->addr));
+		return RADIUS_RX_PROCESSED;
+	}
+	hostapd_acl_query_finish(hapd, query);
 
 	return RADIUS_RX_PROCESSED;
 }
@@ -623,18 +881,47 @@ int hostapd_acl_init(struct hostapd_data *hapd)
  */
 void hostapd_acl_deinit(struct hostapd_data *hapd)
 {
-	struct hostapd_acl_query_data *query, *prev;
-
 #ifndef CONFIG_NO_RADIUS
-	hostapd_acl_cache_free(hapd->acl_cache);
+	hostapd_acl_cache_deinit(hapd->acl_cache);
+	hapd->acl_cache = NULL;
 #endif /* CONFIG_NO_RADIUS */
+}
 
-	query = hapd->acl_queries;
-	while (query) {
-		prev = query;
-		query = query->next;
-		hostapd_acl_query_free(prev);
-	}
+
+/**
+ * hostapd_acl_get_mib - Get RADIUS ACL cache statistics
+ * @hapd: hostapd BSS data
+ * @buf: Buffer for returning MIB data in text format
+ * @buflen: Maximum buf length in octets
+ * Returns: Number of octets written into the buffer
+ */
+int hostapd_acl_get_mib(struct hostapd_data *hapd, char *buf, size_t buflen)
+{
+#ifndef CONFIG_NO_RADIUS
+	struct hostapd_acl_cache *cache = hapd->acl_cache;
+	int ret;
+
+	if (cache == NULL)
+		return 0;
+
+	ret = os_snprintf(buf, buflen,
+			  "radiusAclCacheEntries=%u\n"
+			  "radiusAclCacheHits=%u\n"
+			  "radiusAclCacheNegativeHits=%u\n"
+			  "radiusAclCacheMisses=%u\n"
+			  "radiusAclCacheExpirations=%u\n"
+			  "radiusAclCacheEvictions=%u\n"
+			  "radiusAclPendingQueries=%u\n",
+			  cache->num_entries, cache->hits,
+			  cache->negative_hits, cache->misses,
+			  cache->expirations, cache->evictions,
+			  cache->num_queries);
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
+#else /* CONFIG_NO_RADIUS */
+	return 0;
+#endif /* CONFIG_NO_RADIUS */
 }
 
 
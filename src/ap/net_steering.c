@@ -1,5 +1,5 @@
-#include "net_steering.h"
 #include "utils/includes.h"
+#include "net_steering.h"
 #include "utils/state_machine.h"
 #include "utils/common.h"
 #include "utils/wpa_debug.h"
@@ -24,6 +24,8 @@
 
 #define MAX_FRAME_SIZE 1024
 #define MACSTRLEN 18 /* 6 * 2 + 5 seps + NULL */
+/* tlv_len is a u8, so a TLV_UNCHANGED_SCORES holds a bssid and 41 addrs */
+#define MAX_UNCHANGED_SCORES ((255 - ETH_ALEN) / ETH_ALEN)
 
 static const u16 proto = 0x8267; /* chosen at random from unassigned */
 static const u8 tlv_magic = 48;
@@ -33,6 +35,8 @@ static const u16 max_score = -1;
 static const u32 flood_timeout_secs = 1;
 static const u32 client_timeout_secs = 10;
 static const u32 probe_timeout_secs = 34;
+/* in batch mode, unchanged scores are sent in full every this many ticks */
+static const u32 score_refresh_ticks = 10;
 
 static const char* mode_off = "off";
 static const char* mode_suggest = "suggest";
@@ -45,6 +49,8 @@ enum {
 	TLV_CLOSED_CLIENT = 2,
 	TLV_MAP = 3,
 	TLV_CLIENT_FLAGS = 4,
+	/* bssid followed by the addrs of clients whose score did not change */
+	TLV_UNCHANGED_SCORES = 5,
 };
 
 /* Pre decls */
@@ -52,6 +58,8 @@ struct net_steering_client;
 struct net_steering_bss;
 static void do_flood_score(struct net_steering_client *client);
 static void flood_score(void *eloop_data, void *user_ctx);
+static void flood_tick(void *eloop_data, void *user_ctx);
+static void flood_flush(void *eloop_data, void *user_ctx);
 static void client_timeout(void *eloop_data, void *user_ctx);
 static void probe_timeout(void *eloop_data, void *user_ctx);
 
@@ -65,6 +73,8 @@ static void probe_timeout(void *eloop_data, void *user_ctx);
 struct net_steering_client
 {
 	struct dl_list list;
+	/* next client in the same net_steering_bss::client_hash bucket */
+	struct net_steering_client *hnext;
 	/*
 	 * This will point to a sta in the hapd list pointed to by the nsb.
 	 * May be NULL if client is not associated
@@ -72,6 +82,12 @@ struct net_steering_client
 	struct sta_info* sta;
 	struct net_steering_bss* nsb;
 	u16 score;
+	/* batch mode: the score is included in every flood tick */
+	Boolean flooding;
+	/* batch mode: score sent in the last TLV_SCORE */
+	u16 flooded_score;
+	/* last score received from remote_bssid */
+	u16 remote_score;
 
 	enum {
         /*
@@ -178,12 +194,33 @@ struct net_steering_bss {
 	struct dl_list list;
 	/* contains the list of clients */
 	struct dl_list clients;
+	/*
+	 * clients indexed by mac addr, see client_find(); allocated on demand,
+	 * doubled whenever num_clients would exceed the number of buckets and
+	 * indexed with hwaddr_hash() using a random key
+	 */
+#define CLIENT_HASH_MIN_SIZE 64
+	struct net_steering_client **client_hash;
+	unsigned int client_hash_size; /* power of two */
+	u8 client_hash_key[16];
+	/* number of entries in clients */
+	unsigned int num_clients;
+	/* client_find() statistics */
+	unsigned long client_lookups;
+	unsigned long client_hits;
 	/* bss data structure */
 	struct hostapd_data *hapd;
 	/* frame serial number TODO can we get rid of this, else use it and manage wraparound? */
 	u16 frame_sn;
 	/* the steering control channel */
 	struct l2_packet_data *control;
+	/* batch mode: frame collecting records until the next flood_flush() */
+	struct wpabuf *batch;
+	/* batch mode: number of flood ticks so far */
+	unsigned int flood_ticks;
+	/* flood statistics */
+	unsigned long frames_sent;
+	unsigned long records_sent;
 
 	enum {
 		MODE_OFF = 0,
@@ -261,6 +298,47 @@ static const u8* client_get_mac(struct net_steering_client* client)
 	return client->addr;
 }
 
+static unsigned int client_hash_idx(struct net_steering_bss* nsb, const u8* addr)
+{
+	return hwaddr_hash(nsb->client_hash_key, addr) & (nsb->client_hash_size - 1);
+}
+
+static int client_hash_resize(struct net_steering_bss* nsb, unsigned int size)
+{
+	struct net_steering_client **old = nsb->client_hash, **hash, *client, *next;
+	unsigned int i, old_size = nsb->client_hash_size, idx;
+
+	hash = os_calloc(size, sizeof(*hash));
+	if (!hash) return -1;
+	if (!old && os_get_random(nsb->client_hash_key, sizeof(nsb->client_hash_key)) < 0)
+		wpa_printf(MSG_DEBUG, "net_steering: could not generate client hash key");
+
+	nsb->client_hash = hash;
+	nsb->client_hash_size = size;
+	for (i = 0; i < old_size; i++) {
+		for (client = old[i]; client; client = next) {
+			next = client->hnext;
+			idx = client_hash_idx(nsb, client->addr);
+			client->hnext = hash[idx];
+			hash[idx] = client;
+		}
+	}
+	os_free(old);
+
+	return 0;
+}
+
+/* make room for one more client in the hash table */
+static int client_hash_reserve(struct net_steering_bss* nsb)
+{
+	if (!nsb->client_hash)
+		return client_hash_resize(nsb, CLIENT_HASH_MIN_SIZE);
+	if (nsb->num_clients >= nsb->client_hash_size)
+		client_hash_resize(nsb, nsb->client_hash_size * 2);
+	/* a failed resize only makes the hash chains longer */
+	return 0;
+}
+
 static struct net_steering_client* client_create(struct net_steering_bss* nsb, const u8* addr)
 {
 	assert(nsb->hapd->conf->bssid);
@@ -270,7 +348,11 @@ static struct net_steering_client* client_create(struct net_steering_bss* nsb, c
 				nsb->hapd);
 	}
 
-	struct net_steering_client* client = (struct net_steering_client*) os_zalloc(sizeof(*client));
+	struct net_steering_client* client = NULL;
+	unsigned int idx;
+
+	if (client_hash_reserve(nsb) == 0)
+		client = (struct net_steering_client*) os_zalloc(sizeof(*client));
 	if (!client)
 	{
 		hostapd_logger(nsb->hapd, NULL, HOSTAPD_MODULE_NET_STEERING,
@@ -287,12 +369,21 @@ static struct net_steering_client* client_create(struct net_steering_bss* nsb, c
 	os_memcpy(client->addr, addr, ETH_ALEN);
 
 	dl_list_add(&nsb->clients, &client->list);
+	idx = client_hash_idx(nsb, addr);
+	client->hnext = nsb->client_hash[idx];
+	nsb->client_hash[idx] = client;
+	nsb->num_clients++;
 
 	return client;
 }
 
 static void start_flood_timer(struct net_steering_client *client)
 {
+	if (client->nsb->hapd->conf->net_steering_batch) {
+		/* flood_tick() floods all clients at once */
+		client->flooding = TRUE;
+		return;
+	}
 	if (eloop_register_timeout(flood_timeout_secs, 0, flood_score, client, NULL)) {
 		hostapd_logger(client->nsb->hapd, NULL, HOSTAPD_MODULE_NET_STEERING,
 				HOSTAPD_LEVEL_WARNING, "client "MACSTR" failed to schedule flood\n",
@@ -303,6 +394,7 @@ static void start_flood_timer(struct net_steering_client *client)
 static void stop_flood_timer(struct net_steering_client *client)
 {
 	client->score = max_score;
+	client->flooding = FALSE;
 	// It is safe if a timer is already canceled
 	eloop_cancel_timeout(flood_score, client, NULL);
 }
@@ -359,10 +451,19 @@ static Boolean client_is_associated(struct net_steering_client* client)
 
 static void client_delete(struct net_steering_client* client)
 {
+	struct net_steering_client **pos;
+
 	stop_flood_timer(client);
 	client_stop_timer(client);
 	client_stop_probe_timer(client);
 
+	pos = &client->nsb->client_hash[client_hash_idx(client->nsb, client->addr)];
+	while (*pos && *pos != client)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = client->hnext;
+	client->nsb->num_clients--;
+
 	dl_list_del(&client->list);
 	os_memset(client, 0, sizeof(*client));
 	os_free(client);
@@ -375,12 +476,17 @@ static u16 compute_score(int rssi)
 
 static struct net_steering_client* client_find(struct net_steering_bss* nsb, const u8* sta)
 {
-	struct net_steering_client *client = NULL;
+	struct net_steering_client *client;
 
-	dl_list_for_each(client, &nsb->clients, struct net_steering_client, list) {
+	nsb->client_lookups++;
+	if (!nsb->client_hash) return NULL;
+	client = nsb->client_hash[client_hash_idx(nsb, sta)];
+	while (client) {
 		if (os_memcmp(sta, client->addr, ETH_ALEN) == 0) {
+			nsb->client_hits++;
 			return client;
 		}
+		client = client->hnext;
 	}
 	return NULL;
 }
@@ -464,6 +570,13 @@ static void put_closed_client(struct wpabuf* buf, const u8* sta, const u8* bssid
 	wpabuf_put_data(buf, bssid, ETH_ALEN);
 }
 
+static void put_unchanged_scores(struct wpabuf* buf, const u8* bssid, const u8* stas, size_t num_stas)
+{
+	put_tlv_header(buf, TLV_UNCHANGED_SCORES, ETH_ALEN + num_stas * ETH_ALEN);
+	wpabuf_put_data(buf, bssid, ETH_ALEN);
+	wpabuf_put_data(buf, stas, num_stas * ETH_ALEN);
+}
+
 static size_t parse_score(const u8* buf, size_t len, u8* sta, u8* bssid, u16* score, u32* association_msecs)
 {
 	static u8 score_len = ETH_ALEN + ETH_ALEN + sizeof(*score) + sizeof(*association_msecs);
@@ -591,7 +704,19 @@ static void flood_message(struct net_steering_bss* nsb, const struct wpabuf* buf
 	assert(nsb->hapd->own_addr);
 	assert(buf);
 
-	// TODO use broadcast, but figure out how to handle multiple ess
+	nsb->frames_sent++;
+	if (!is_zero_ether_addr(nsb->hapd->conf->net_steering_group_addr)) {
+		/* receivers drop frames from APs not in their r0kh list, see receive() */
+		const u8* dst = nsb->hapd->conf->net_steering_group_addr;
+		ret = l2_packet_send(nsb->control, dst, proto, wpabuf_head(buf), wpabuf_len(buf));
+		if (ret < 0) {
+			hostapd_logger(nsb->hapd, nsb->hapd->conf->bssid, HOSTAPD_MODULE_NET_STEERING,
+			HOSTAPD_LEVEL_WARNING, "Failed send to "MACSTR" : error %d\n",
+			MAC2STR(dst), ret);
+		}
+		return;
+	}
+
 	while (r0kh) {
 		u8* dst = r0kh->addr;
 		// don't send to ourself
@@ -614,22 +739,72 @@ static void flood_message(struct net_steering_bss* nsb, const struct wpabuf* buf
 	}
 }
 
+/*
+ * Returns a frame with room for a tlv of tlv_len bytes. In batch mode this is
+ * the pending batch frame, which is sent (at the latest) once the current
+ * event loop pass is done; a full batch frame is sent first.
+ */
+static struct wpabuf* frame_begin(struct net_steering_bss* nsb, size_t tlv_len)
+{
+	struct wpabuf* buf;
+
+	nsb->records_sent++;
+	if (!nsb->hapd->conf->net_steering_batch) {
+		buf = wpabuf_alloc(MAX_FRAME_SIZE);
+		if (buf) header_put(buf, nsb->frame_sn++);
+		return buf;
+	}
+
+	if (nsb->batch && wpabuf_tailroom(nsb->batch) < 2 + tlv_len)
+		flood_flush(nsb, NULL);
+	if (!nsb->batch) {
+		nsb->batch = wpabuf_alloc(MAX_FRAME_SIZE);
+		if (!nsb->batch) return NULL;
+		header_put(nsb->batch, nsb->frame_sn++);
+		eloop_register_timeout(0, 0, flood_flush, nsb, NULL);
+	}
+	return nsb->batch;
+}
+
+/* Sends a frame from frame_begin(), unless it is the pending batch frame */
+static void frame_end(struct net_steering_bss* nsb, struct wpabuf* buf)
+{
+	if (buf == nsb->batch) return;
+
+	header_finalize(buf);
+	flood_message(nsb, buf);
+	wpabuf_free(buf);
+}
+
+static void flood_flush(void *eloop_data, void *user_ctx)
+{
+	(void) user_ctx;
+	struct net_steering_bss* nsb = (struct net_steering_bss*) eloop_data;
+	struct wpabuf* buf = nsb->batch;
+
+	if (!buf) return;
+
+	eloop_cancel_timeout(flood_flush, nsb, NULL);
+	nsb->batch = NULL;
+	header_finalize(buf);
+	flood_message(nsb, buf);
+	wpabuf_free(buf);
+}
+
 static void flood_closed_client(struct net_steering_client *client)
 {
 	struct net_steering_bss* nsb = client->nsb;
 	struct wpabuf* buf;
 
-	buf = wpabuf_alloc(MAX_FRAME_SIZE);
-	header_put(buf, nsb->frame_sn++);
+	buf = frame_begin(nsb, ETH_ALEN + ETH_ALEN);
+	if (!buf) return;
 	put_closed_client(buf, client_get_mac(client), client_get_local_bssid(client));
-	header_finalize(buf);
 
 	hostapd_logger(nsb->hapd, client_get_local_bssid(client), HOSTAPD_MODULE_NET_STEERING,
 			HOSTAPD_LEVEL_DEBUG, "sending closed client "MACSTR" to "MACSTR"\n",
 			MAC2STR(client_get_mac(client)), MAC2STR(client_get_close_bssid(client)));
 
-	flood_message(nsb, buf);
-	wpabuf_free(buf);
+	frame_end(nsb, buf);
 
 	client_clear_close_bssid(client);
 }
@@ -639,19 +814,17 @@ static void flood_close_client(struct net_steering_client *client)
 	struct net_steering_bss* nsb = client->nsb;
 	struct wpabuf* buf;
 
-	buf = wpabuf_alloc(MAX_FRAME_SIZE);
-	header_put(buf, nsb->frame_sn++);
+	buf = frame_begin(nsb, ETH_ALEN + ETH_ALEN + ETH_ALEN + 1);
+	if (!buf) return;
 	put_close_client(buf, client_get_mac(client), client_get_local_bssid(client),
 			client_get_remote_bssid(client), client->nsb->hapd->iconf->channel);
-	header_finalize(buf);
 
 	hostapd_logger(nsb->hapd, client_get_local_bssid(client), HOSTAPD_MODULE_NET_STEERING,
 			HOSTAPD_LEVEL_DEBUG, "sending close client "MACSTR" for "MACSTR"\n",
 			MAC2STR(client_get_mac(client)),
 			MAC2STR(client_get_remote_bssid(client)));
 
-	flood_message(nsb, buf);
-	wpabuf_free(buf);
+	frame_end(nsb, buf);
 }
 
 static void do_flood_score(struct net_steering_client *client)
@@ -677,14 +850,51 @@ static void do_flood_score(struct net_steering_client *client)
 			HOSTAPD_LEVEL_DEBUG, "sending "MACSTR" score %d associated %lu\n",
 			MAC2STR(client_get_mac(client)), (int)client->score, (unsigned long)associated_msecs);
 
-		buf = wpabuf_alloc(MAX_FRAME_SIZE);
-		header_put(buf, nsb->frame_sn++);
+		buf = frame_begin(nsb, ETH_ALEN + ETH_ALEN + sizeof(client->score) + sizeof(associated_msecs));
+		if (!buf) return;
 		put_score(buf, client_get_mac(client), client_get_local_bssid(client), client->score, associated_msecs);
-		header_finalize(buf);
+		client->flooded_score = client->score;
+		frame_end(nsb, buf);
+	}
+}
+
+/*
+ * Batch mode replacement for the per client flood_score() timers: floods the
+ * scores of all associated clients, sending only the addresses of clients
+ * whose score did not change since it was last sent.
+ */
+static void flood_tick(void *eloop_data, void *user_ctx)
+{
+	(void) user_ctx;
+	struct net_steering_bss* nsb = (struct net_steering_bss*) eloop_data;
+	struct net_steering_client* client;
+	struct wpabuf* buf;
+	u8 unchanged[MAX_UNCHANGED_SCORES * ETH_ALEN];
+	size_t num_unchanged = 0;
+	Boolean refresh = (++nsb->flood_ticks % score_refresh_ticks) == 0;
+
+	dl_list_for_each(client, &nsb->clients, struct net_steering_client, list) {
+		if (!client->flooding || client->score == max_score) continue;
+
+		if (refresh || client->score != client->flooded_score) {
+			do_flood_score(client);
+			continue;
+		}
 
-		flood_message(nsb, buf);
-		wpabuf_free(buf);
+		os_memcpy(&unchanged[num_unchanged * ETH_ALEN], client_get_mac(client), ETH_ALEN);
+		if (++num_unchanged < MAX_UNCHANGED_SCORES) continue;
+
+		buf = frame_begin(nsb, ETH_ALEN + num_unchanged * ETH_ALEN);
+		if (buf) put_unchanged_scores(buf, nsb->hapd->conf->bssid, unchanged, num_unchanged);
+		num_unchanged = 0;
+	}
+	if (num_unchanged) {
+		buf = frame_begin(nsb, ETH_ALEN + num_unchanged * ETH_ALEN);
+		if (buf) put_unchanged_scores(buf, nsb->hapd->conf->bssid, unchanged, num_unchanged);
 	}
+
+	flood_flush(nsb, NULL);
+	eloop_register_timeout(flood_timeout_secs, 0, flood_tick, nsb, NULL);
 }
 
 static void flood_score(void *eloop_data, void *user_ctx)
@@ -1200,6 +1410,38 @@ static void receive_score(struct net_steering_bss* nsb, const u8* sta, const u8*
 		/* if this score is from the same AP, then check it */
 		compare_scores(client, score);
 	}
+
+	if (os_memcmp(bssid, client_get_remote_bssid(client), ETH_ALEN) == 0)
+		client->remote_score = score;
+}
+
+static void receive_unchanged_scores(struct net_steering_bss* nsb, const u8* bssid,
+		const u8* stas, size_t num_stas)
+{
+	struct net_steering_client *client = NULL;
+	size_t i;
+
+	for (i = 0; i < num_stas; i++) {
+		client = client_find(nsb, &stas[i * ETH_ALEN]);
+		/*
+		 * Without a full score from this AP there is nothing to repeat;
+		 * the AP periodically sends full scores.
+		 */
+		if (!client || os_memcmp(bssid, client_get_remote_bssid(client), ETH_ALEN) != 0)
+			continue;
+
+		compare_scores(client, client->remote_score);
+	}
+}
+
+static Boolean is_peer(struct net_steering_bss* nsb, const u8* addr)
+{
+	struct ft_remote_r0kh *r0kh;
+
+	for (r0kh = nsb->hapd->conf->r0kh_list; r0kh; r0kh = r0kh->next) {
+		if (os_memcmp(r0kh->addr, addr, ETH_ALEN) == 0) return TRUE;
+	}
+	return FALSE;
 }
 
 static void receive_close_client(struct net_steering_bss* nsb, const u8* sta,
@@ -1255,6 +1497,12 @@ static void receive(void *ctx, const u8 *src_addr, const u8 *buf, size_t len)
 	size_t num_read = 0;
 	const u8* buf_pos = buf;
 
+	/* flooding to a group address reaches other ESSs (and ourselves) too */
+	if (!is_zero_ether_addr(nsb->hapd->conf->net_steering_group_addr) &&
+	    (os_memcmp(src_addr, nsb->hapd->own_addr, ETH_ALEN) == 0 || !is_peer(nsb, src_addr))) {
+		return;
+	}
+
 	num_read = parse_header(buf_pos, len, &magic, &version, &packet_len, &sn);
 	if (!num_read) {
 		hostapd_logger(nsb->hapd, NULL, HOSTAPD_MODULE_NET_STEERING,
@@ -1341,6 +1589,19 @@ static void receive(void *ctx, const u8 *src_addr, const u8 *buf, size_t len)
 
 			receive_closed_client(nsb, sta, target_bssid);
 			break;
+		case TLV_UNCHANGED_SCORES:
+			if (tlv_len < ETH_ALEN || tlv_len % ETH_ALEN ||
+			    tlv_len > packet_len - (buf_pos - buf)) {
+				hostapd_logger(nsb->hapd, NULL, HOSTAPD_MODULE_NET_STEERING,
+						HOSTAPD_LEVEL_DEBUG, "Could not parse unchanged scores from "MACSTR"\n",
+						MAC2STR(src_addr));
+				return;
+			}
+			os_memcpy(bssid, buf_pos, ETH_ALEN);
+			receive_unchanged_scores(nsb, bssid, buf_pos + ETH_ALEN,
+					tlv_len / ETH_ALEN - 1);
+			buf_pos += tlv_len;
+			break;
 		default:
 			// skip unknown tlvs
 			buf_pos += tlv_len;
@@ -1357,18 +1618,25 @@ static void receive(void *ctx, const u8 *src_addr, const u8 *buf, size_t len)
 }
 
 
+static struct net_steering_bss* nsb_find(struct hostapd_data *hapd)
+{
+	struct net_steering_bss* nsb = NULL;
+
+	dl_list_for_each(nsb, &nsb_list, struct net_steering_bss, list) {
+		if (nsb->hapd == hapd) return nsb;
+	}
+	return NULL;
+}
+
 void net_steering_disassociation(struct hostapd_data *hapd, struct sta_info *sta)
 {
 	struct net_steering_bss* nsb = NULL;
-	struct net_steering_client *client, *ctmp;
+	struct net_steering_client *client;
 
 	if (dl_list_empty(&nsb_list)) return;
 
 	// find the context
-	dl_list_for_each(nsb, &nsb_list, struct net_steering_bss, list) {
-		if (nsb->hapd == hapd) break;
-	}
-
+	nsb = nsb_find(hapd);
 	if (!nsb) {
 		hostapd_logger(hapd, hapd->conf->bssid, HOSTAPD_MODULE_NET_STEERING,
 			HOSTAPD_LEVEL_WARNING, "Association to unknown bss "MACSTR"\n",
@@ -1377,17 +1645,14 @@ void net_steering_disassociation(struct hostapd_data *hapd, struct sta_info *sta
 	}
 
 	// find the client and clean it up
-	dl_list_for_each_safe(client, ctmp, &nsb->clients, struct net_steering_client, list) {
-		if (os_memcmp(client_get_mac(client), sta->addr, ETH_ALEN) == 0) {
-
-			hostapd_logger(nsb->hapd, nsb->hapd->conf->bssid, HOSTAPD_MODULE_NET_STEERING,
-						HOSTAPD_LEVEL_INFO, MACSTR" disassociated from "MACSTR" remote is "MACSTR"\n",
-						MAC2STR(sta->addr), MAC2STR(nsb->hapd->conf->bssid),
-						MAC2STR(client_get_close_bssid(client)));
+	client = client_find(nsb, sta->addr);
+	if (client) {
+		hostapd_logger(nsb->hapd, nsb->hapd->conf->bssid, HOSTAPD_MODULE_NET_STEERING,
+					HOSTAPD_LEVEL_INFO, MACSTR" disassociated from "MACSTR" remote is "MACSTR"\n",
+					MAC2STR(sta->addr), MAC2STR(nsb->hapd->conf->bssid),
+					MAC2STR(client_get_close_bssid(client)));
 
-			client_disassociate(client);
-			break;
-		}
+		client_disassociate(client);
 	}
 }
 
@@ -1398,10 +1663,7 @@ void net_steering_association(struct hostapd_data *hapd, struct sta_info *sta, i
 
 	if (dl_list_empty(&nsb_list)) return;
 
-	dl_list_for_each(nsb, &nsb_list, struct net_steering_bss, list) {
-		if (nsb->hapd == hapd) break;
-	}
-
+	nsb = nsb_find(hapd);
 	if (!nsb) {
 		hostapd_logger(hapd, hapd->conf->bssid, HOSTAPD_MODULE_NET_STEERING,
 			HOSTAPD_LEVEL_WARNING, "Association to unknown bss "MACSTR"\n",
@@ -1442,6 +1704,40 @@ void net_steering_association(struct hostapd_data *hapd, struct sta_info *sta, i
 	SM_STEP_EVENT_RUN(STEERING, E_ASSOCIATED, client);
 }
 
+int net_steering_stats(struct hostapd_data *hapd, char *buf, size_t buflen)
+{
+	struct net_steering_bss* nsb;
+	struct net_steering_client *client;
+	unsigned int i, len, max_chain = 0, used = 0;
+	int ret;
+
+	nsb = nsb_find(hapd);
+	if (!nsb) return -1;
+
+	for (i = 0; i < nsb->client_hash_size; i++) {
+		len = 0;
+		for (client = nsb->client_hash[i]; client; client = client->hnext)
+			len++;
+		if (len) used++;
+		if (len > max_chain) max_chain = len;
+	}
+
+	ret = os_snprintf(buf, buflen,
+			"clients=%u\n"
+			"client_lookups=%lu\n"
+			"client_hits=%lu\n"
+			"hash_buckets=%u\n"
+			"hash_buckets_used=%u\n"
+			"hash_max_chain=%u\n"
+			"frames_sent=%lu\n"
+			"records_sent=%lu\n",
+			nsb->num_clients, nsb->client_lookups, nsb->client_hits,
+			nsb->client_hash_size, used, max_chain,
+			nsb->frames_sent, nsb->records_sent);
+	if (os_snprintf_error(buflen, ret)) return -1;
+	return ret;
+}
+
 void net_steering_deinit(struct hostapd_data *hapd)
 {
 	struct net_steering_bss *nsb, *tmp;
@@ -1456,10 +1752,15 @@ void net_steering_deinit(struct hostapd_data *hapd)
 				wpa_printf(MSG_DEBUG, "net_steering_deinit - l2_packet_deinit");
 			}
 
+			eloop_cancel_timeout(flood_tick, nsb, NULL);
+			eloop_cancel_timeout(flood_flush, nsb, NULL);
+			wpabuf_free(nsb->batch);
+
 			// free all clients
 			dl_list_for_each_safe(client, ctmp, &nsb->clients, struct net_steering_client, list) {
 				client_delete(client);
 			}
+			os_free(nsb->client_hash);
 
 			dl_list_del(&nsb->list);
 			os_memset(nsb, 0, sizeof(*nsb));
@@ -1532,6 +1833,9 @@ int net_steering_init(struct hostapd_data *hapd)
 	else if (os_strcmp(hapd->conf->net_steeering_mode, mode_force) == 0) nsb->mode = MODE_FORCE;
 	else nsb->mode = MODE_FORCE;
 
+	if (hapd->conf->net_steering_batch)
+		eloop_register_timeout(flood_timeout_secs, 0, flood_tick, nsb, NULL);
+
 	return 0;
 }
 
@@ -8,6 +8,7 @@ int net_steering_init(struct hostapd_data *hapd);
 void net_steering_deinit(struct hostapd_data *hapd);
 void net_steering_association(struct hostapd_data *hapd, struct sta_info *sta, int rssi);
 void net_steering_disassociation(struct hostapd_data *hapd, struct sta_info *sta);
+int net_steering_stats(struct hostapd_data *hapd, char *buf, size_t buflen);
 
 
 #endif
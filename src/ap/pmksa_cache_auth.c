@@ -22,9 +22,15 @@ static const int pmksa_cache_max_entries = 1024;
 static const int dot11RSNAConfigPMKLifetime = 43200;
 
 struct rsn_pmksa_cache {
-#define PMKID_HASH_SIZE 128
-#define PMKID_HASH(pmkid) (unsigned int) ((pmkid)[0] & 0x7f)
+#define PMKID_HASH_SIZE 256
+#define PMKID_HASH(pmkid) \
+	(unsigned int) ((pmkid)[0] ^ (pmkid)[7] ^ (pmkid)[15])
 	struct rsn_pmksa_cache_entry *pmkid[PMKID_HASH_SIZE];
+#define PMKSA_SPA_HASH_SIZE 256
+#define PMKSA_SPA_HASH(pmksa, spa) \
+	(hwaddr_hash((pmksa)->spa_hash_key, (spa)) & (PMKSA_SPA_HASH_SIZE - 1))
+	struct rsn_pmksa_cache_entry *spa[PMKSA_SPA_HASH_SIZE];
+	u8 spa_hash_key[16];
 	struct rsn_pmksa_cache_entry *pmksa;
 	int pmksa_count;
 
@@ -72,6 +78,22 @@ void pmksa_cache_free_entry(struct rsn_pmksa_cache *pmksa,
 		pos = pos->hnext;
 	}
 
+	/* unlink from SPA hash list */
+	hash = PMKSA_SPA_HASH(pmksa, entry->spa);
+	pos = pmksa->spa[hash];
+	prev = NULL;
+	while (pos) {
+		if (pos == entry) {
+			if (prev != NULL)
+				prev->shnext = entry->shnext;
+			else
+				pmksa->spa[hash] = entry->shnext;
+			break;
+		}
+		prev = pos;
+		pos = pos->shnext;
+	}
+
 	/* unlink from entry list */
 	pos = pmksa->pmksa;
 	prev = NULL;
@@ -197,7 +219,7 @@ static void pmksa_cache_link_entry(struct rsn_pmksa_cache *pmksa,
 				   struct rsn_pmksa_cache_entry *entry)
 {
 	struct rsn_pmksa_cache_entry *pos, *prev;
-	int hash;
+	unsigned int hash;
 
 	/* Add the new entry; order by expiration time */
 	pos = pmksa->pmksa;
@@ -220,8 +242,30 @@ static void pmksa_cache_link_entry(struct rsn_pmksa_cache *pmksa,
 	entry->hnext = pmksa->pmkid[hash];
 	pmksa->pmkid[hash] = entry;
 
+	/*
+	 * Keep the SPA chain in reverse expiration order so that a lookup by
+	 * SPA returns the newest entry of the STA; among entries that expire
+	 * at the same time, the one added last.
+	 */
+	hash = PMKSA_SPA_HASH(pmksa, entry->spa);
+	pos = pmksa->spa[hash];
+	prev = NULL;
+	while (pos) {
+		if (pos->expiration <= entry->expiration)
+			break;
+		prev = pos;
+		pos = pos->shnext;
+	}
+	if (prev == NULL) {
+		entry->shnext = pmksa->spa[hash];
+		pmksa->spa[hash] = entry;
+	} else {
+		entry->shnext = prev->shnext;
+		prev->shnext = entry;
+	}
+
 	pmksa->pmksa_count++;
-	if (prev == NULL)
+	if (pmksa->pmksa == entry)
 		pmksa_cache_set_expiration(pmksa);
 	wpa_printf(MSG_DEBUG, "RSN: added PMKSA cache entry for " MACSTR,
 		   MAC2STR(entry->spa));
@@ -369,6 +413,8 @@ void pmksa_cache_auth_deinit(struct rsn_pmksa_cache *pmksa)
 	pmksa->pmksa = NULL;
 	for (i = 0; i < PMKID_HASH_SIZE; i++)
 		pmksa->pmkid[i] = NULL;
+	for (i = 0; i < PMKSA_SPA_HASH_SIZE; i++)
+		pmksa->spa[i] = NULL;
 	os_free(pmksa);
 }
 
@@ -379,6 +425,9 @@ void pmksa_cache_auth_deinit(struct rsn_pmksa_cache *pmksa)
  * @spa: Supplicant address or %NULL to match any
  * @pmkid: PMKID or %NULL to match any
  * Returns: Pointer to PMKSA cache entry or %NULL if no match was found
+ *
+ * If only @spa is given, the entry of that Supplicant that expires last is
+ * returned. If neither is given, the entry that expires first is returned.
  */
 struct rsn_pmksa_cache_entry *
 pmksa_cache_auth_get(struct rsn_pmksa_cache *pmksa,
@@ -394,12 +443,14 @@ pmksa_cache_auth_get(struct rsn_pmksa_cache *pmksa,
 			    os_memcmp(entry->pmkid, pmkid, PMKID_LEN) == 0)
 				return entry;
 		}
-	} else {
-		for (entry = pmksa->pmksa; entry; entry = entry->next) {
-			if (spa == NULL ||
-			    os_memcmp(entry->spa, spa, ETH_ALEN) == 0)
+	} else if (spa) {
+		for (entry = pmksa->spa[PMKSA_SPA_HASH(pmksa, spa)]; entry;
+		     entry = entry->shnext) {
+			if (os_memcmp(entry->spa, spa, ETH_ALEN) == 0)
 				return entry;
 		}
+	} else {
+		return pmksa->pmksa;
 	}
 
 	return NULL;
@@ -414,21 +465,30 @@ pmksa_cache_auth_get(struct rsn_pmksa_cache *pmksa,
  * @pmkid: PMKID
  * Returns: Pointer to PMKSA cache entry or %NULL if no match was found
  *
- * Use opportunistic key caching (OKC) to find a PMK for a supplicant.
+ * Use opportunistic key caching (OKC) to find a PMK for a supplicant. The
+ * PMKID derived for the most recent AA is remembered in each entry so that a
+ * STA roaming back and forth between the same APs does not need a new PMKID
+ * derivation on every lookup.
  */
 struct rsn_pmksa_cache_entry * pmksa_cache_get_okc(
 	struct rsn_pmksa_cache *pmksa, const u8 *aa, const u8 *spa,
 	const u8 *pmkid)
 {
 	struct rsn_pmksa_cache_entry *entry;
-	u8 new_pmkid[PMKID_LEN];
 
-	for (entry = pmksa->pmksa; entry; entry = entry->next) {
+	for (entry = pmksa->spa[PMKSA_SPA_HASH(pmksa, spa)]; entry;
+	     entry = entry->shnext) {
 		if (os_memcmp(entry->spa, spa, ETH_ALEN) != 0)
 			continue;
-		rsn_pmkid(entry->pmk, entry->pmk_len, aa, spa, new_pmkid,
-			  wpa_key_mgmt_sha256(entry->akmp));
-		if (os_memcmp(new_pmkid, pmkid, PMKID_LEN) == 0)
+		if (!entry->okc_pmkid_set ||
+		    os_memcmp(entry->okc_aa, aa, ETH_ALEN) != 0) {
+			rsn_pmkid(entry->pmk, entry->pmk_len, aa, spa,
+				  entry->okc_pmkid,
+				  wpa_key_mgmt_sha256(entry->akmp));
+			os_memcpy(entry->okc_aa, aa, ETH_ALEN);
+			entry->okc_pmkid_set = 1;
+		}
+		if (os_memcmp(entry->okc_pmkid, pmkid, PMKID_LEN) == 0)
 			return entry;
 	}
 	return NULL;
@@ -451,6 +511,10 @@ pmksa_cache_auth_init(void (*free_cb)(struct rsn_pmksa_cache_entry *entry,
 	if (pmksa) {
 		pmksa->free_cb = free_cb;
 		pmksa->ctx = ctx;
+		if (os_get_random(pmksa->spa_hash_key,
+				  sizeof(pmksa->spa_hash_key)) < 0)
+			wpa_printf(MSG_INFO,
+				   "RSN: Failed to get random PMKSA hash key");
 	}
 
 	return pmksa;
@@ -15,7 +15,7 @@
  * struct rsn_pmksa_cache_entry - PMKSA cache entry
  */
 struct rsn_pmksa_cache_entry {
-	struct rsn_pmksa_cache_entry *next, *hnext;
+	struct rsn_pmksa_cache_entry *next, *hnext, *shnext;
 	u8 pmkid[PMKID_LEN];
 	u8 pmk[PMK_LEN];
 	size_t pmk_len;
@@ -31,6 +31,11 @@ struct rsn_pmksa_cache_entry {
 	int vlan_id;
 	int opportunistic;
 
+	/* Last PMKID derived for OKC lookups (for okc_aa) */
+	u8 okc_aa[ETH_ALEN];
+	u8 okc_pmkid[PMKID_LEN];
+	int okc_pmkid_set;
+
 	u32 acct_multi_session_id_hi;
 	u32 acct_multi_session_id_lo;
 };
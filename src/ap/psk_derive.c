@@ -0,0 +1,625 @@
+/*
+ * hostapd / WPA passphrase to PSK derivation
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * PBKDF2-SHA1 with 4096 iterations takes milliseconds of CPU time for each
+ * passphrase. Derived PSKs are cached by (passphrase, SSID), so a passphrase
+ * that is used again (e.g., the same RADIUS Tunnel-Password for many stations
+ * or wpa_psk_file entries on configuration reload) is derived only once. The
+ * cache is indexed with a keyed hash of the passphrase and the SSID and the
+ * passphrases themselves are not stored in it.
+ *
+ * Derivations that are requested while processing events are queued. With
+ * CONFIG_PSK_DERIVE_THREADS, they are run by worker threads that notify the
+ * event loop through a pipe. Otherwise, one queued derivation is run per
+ * event loop iteration.
+ */
+
+#include "utils/includes.h"
+#ifdef CONFIG_PSK_DERIVE_THREADS
+#include <fcntl.h>
+#include <pthread.h>
+#endif /* CONFIG_PSK_DERIVE_THREADS */
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "utils/list.h"
+#include "crypto/sha1.h"
+#include "common/ieee802_11_defs.h"
+#include "common/wpa_common.h"
+#include "psk_derive.h"
+
+#define PSK_CACHE_SIZE 1024
+#define PSK_CACHE_HASH_SIZE 256 /* power of two */
+#define PSK_DERIVE_MAX_THREADS 4
+
+
+struct psk_cache_entry {
+	struct psk_cache_entry *hnext; /* next entry in hash bucket */
+	struct dl_list list; /* entry in LRU list, most recently used first */
+	u8 tag[SHA1_MAC_LEN];
+	u8 psk[PMK_LEN];
+};
+
+struct psk_derive_req {
+	struct dl_list list;
+	u8 *psk;
+	void (*cb)(void *ctx);
+	void *ctx;
+};
+
+struct psk_derive_job {
+	struct dl_list jobs; /* entry in the list of all pending jobs */
+	struct dl_list list; /* entry in the queue or the done list */
+	struct dl_list reqs; /* requests waiting for this PSK */
+	u8 tag[SHA1_MAC_LEN];
+	char *passphrase;
+	u8 ssid[SSID_MAX_LEN];
+	size_t ssid_len;
+	u8 psk[PMK_LEN];
+	/* With threads, these are protected by the lock */
+	int started; /* taken from the queue */
+	int ready; /* psk has been derived */
+};
+
+struct psk_derive_data {
+	u8 key[16]; /* key for the cache tags */
+	struct psk_cache_entry *hash[PSK_CACHE_HASH_SIZE];
+	struct dl_list lru;
+	unsigned int num_entries;
+
+	/* Only the queue and the done list are accessed by worker threads */
+	struct dl_list jobs;
+	struct dl_list queue;
+	struct dl_list done;
+#ifdef CONFIG_PSK_DERIVE_THREADS
+	unsigned int running; /* jobs in the queue or being run */
+	int stop;
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	pthread_t threads[PSK_DERIVE_MAX_THREADS];
+	unsigned int num_threads;
+	int pipe[2];
+#endif /* CONFIG_PSK_DERIVE_THREADS */
+};
+
+static struct psk_derive_data *pd;
+
+
+static int psk_derive_init(void)
+{
+	if (pd)
+		return 0;
+
+	pd = os_zalloc(sizeof(*pd));
+	if (pd == NULL)
+		return -1;
+	if (os_get_random(pd->key, sizeof(pd->key)) < 0)
+		wpa_printf(MSG_INFO, "PSK: Failed to get random cache key");
+	dl_list_init(&pd->lru);
+	dl_list_init(&pd->jobs);
+	dl_list_init(&pd->queue);
+	dl_list_init(&pd->done);
+#ifdef CONFIG_PSK_DERIVE_THREADS
+	pthread_mutex_init(&pd->lock, NULL);
+	pthread_cond_init(&pd->work_cond, NULL);
+	pthread_cond_init(&pd->done_cond, NULL);
+	pd->pipe[0] = pd->pipe[1] = -1;
+#endif /* CONFIG_PSK_DERIVE_THREADS */
+
+	return 0;
+}
+
+
+static void psk_derive_tag(const char *passphrase, const u8 *ssid,
+			   size_t ssid_len, u8 *tag)
+{
+	u8 len = ssid_len;
+	const u8 *addr[3];
+	size_t vlen[3];
+
+	addr[0] = &len;
+	vlen[0] = 1;
+	addr[1] = ssid;
+	vlen[1] = ssid_len;
+	addr[2] = (const u8 *) passphrase;
+	vlen[2] = os_strlen(passphrase);
+	hmac_sha1_vector(pd->key, sizeof(pd->key), 3, addr, vlen, tag);
+}
+
+
+static struct psk_cache_entry ** psk_cache_bucket(const u8 *tag)
+{
+	/* The tag is a keyed hash, so any of its bits will do as an index */
+	return &pd->hash[WPA_GET_LE16(tag) & (PSK_CACHE_HASH_SIZE - 1)];
+}
+
+
+static struct psk_cache_entry * psk_cache_find(const u8 *tag)
+{
+	struct psk_cache_entry *entry;
+
+	entry = *psk_cache_bucket(tag);
+	while (entry && os_memcmp(entry->tag, tag, SHA1_MAC_LEN) != 0)
+		entry = entry->hnext;
+	return entry;
+}
+
+
+static int psk_cache_get(const u8 *tag, u8 *psk)
+{
+	struct psk_cache_entry *entry;
+
+	entry = psk_cache_find(tag);
+	if (entry == NULL)
+		return 0;
+
+	dl_list_del(&entry->list);
+	dl_list_add(&pd->lru, &entry->list);
+	os_memcpy(psk, entry->psk, PMK_LEN);
+	return 1;
+}
+
+
+static void psk_cache_remove(struct psk_cache_entry *entry)
+{
+	struct psk_cache_entry **pos;
+
+	pos = psk_cache_bucket(entry->tag);
+	while (*pos && *pos != entry)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = entry->hnext;
+	dl_list_del(&entry->list);
+	pd->num_entries--;
+	bin_clear_free(entry, sizeof(*entry));
+}
+
+
+static void psk_cache_add(const u8 *tag, const u8 *psk)
+{
+	struct psk_cache_entry *entry, **bucket;
+
+	if (psk_cache_find(tag))
+		return;
+
+	if (pd->num_entries >= PSK_CACHE_SIZE)
+		psk_cache_remove(dl_list_last(&pd->lru, struct psk_cache_entry,
+					      list));
+
+	entry = os_zalloc(sizeof(*entry));
+	if (entry == NULL)
+		return;
+	os_memcpy(entry->tag, tag, SHA1_MAC_LEN);
+	os_memcpy(entry->psk, psk, PMK_LEN);
+	bucket = psk_cache_bucket(tag);
+	entry->hnext = *bucket;
+	*bucket = entry;
+	dl_list_add(&pd->lru, &entry->list);
+	pd->num_entries++;
+}
+
+
+static void psk_derive_job_free(struct psk_derive_job *job)
+{
+	struct psk_derive_req *req, *tmp;
+
+	dl_list_for_each_safe(req, tmp, &job->reqs, struct psk_derive_req,
+			      list)
+		os_free(req);
+	if (job->passphrase)
+		bin_clear_free(job->passphrase, os_strlen(job->passphrase));
+	bin_clear_free(job, sizeof(*job));
+}
+
+
+static void psk_derive_run(struct psk_derive_job *job)
+{
+	pbkdf2_sha1(job->passphrase, job->ssid, job->ssid_len, 4096,
+		    job->psk, PMK_LEN);
+}
+
+
+static void psk_derive_job_done(struct psk_derive_job *job)
+{
+	struct psk_derive_req *req;
+
+	dl_list_del(&job->jobs);
+	psk_cache_add(job->tag, job->psk);
+	while ((req = dl_list_first(&job->reqs, struct psk_derive_req,
+				    list))) {
+		dl_list_del(&req->list);
+		os_memcpy(req->psk, job->psk, PMK_LEN);
+		if (req->cb)
+			req->cb(req->ctx);
+		os_free(req);
+	}
+	psk_derive_job_free(job);
+}
+
+
+#ifdef CONFIG_PSK_DERIVE_THREADS
+
+static void * psk_derive_thread(void *arg)
+{
+	struct psk_derive_job *job;
+	char c = 0;
+
+	pthread_mutex_lock(&pd->lock);
+	for (;;) {
+		while (!pd->stop && dl_list_empty(&pd->queue))
+			pthread_cond_wait(&pd->work_cond, &pd->lock);
+		if (pd->stop)
+			break;
+
+		job = dl_list_first(&pd->queue, struct psk_derive_job, list);
+		dl_list_del(&job->list);
+		job->started = 1;
+		pthread_mutex_unlock(&pd->lock);
+		psk_derive_run(job);
+		pthread_mutex_lock(&pd->lock);
+		dl_list_add_tail(&pd->done, &job->list);
+		job->ready = 1;
+		pd->running--;
+		pthread_cond_broadcast(&pd->done_cond);
+
+		if (write(pd->pipe[1], &c, 1) < 0) {
+			/* The write end is non-blocking. A full pipe means
+			 * that the event loop has not yet read the earlier
+			 * notifications and it will find this job as well. */
+		}
+	}
+	pthread_mutex_unlock(&pd->lock);
+
+	return NULL;
+}
+
+
+static void psk_derive_report(void)
+{
+	struct dl_list done;
+	struct psk_derive_job *job;
+
+	dl_list_init(&done);
+	pthread_mutex_lock(&pd->lock);
+	while ((job = dl_list_first(&pd->done, struct psk_derive_job, list))) {
+		dl_list_del(&job->list);
+		dl_list_add_tail(&done, &job->list);
+	}
+	pthread_mutex_unlock(&pd->lock);
+
+	while ((job = dl_list_first(&done, struct psk_derive_job, list))) {
+		dl_list_del(&job->list);
+		psk_derive_job_done(job);
+	}
+}
+
+
+static void psk_derive_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	char buf[64];
+
+	if (read(sock, buf, sizeof(buf)) < 0) {
+		wpa_printf(MSG_INFO, "PSK: read: %s", strerror(errno));
+		return;
+	}
+	psk_derive_report();
+}
+
+
+static int psk_derive_threads_start(void)
+{
+	long num;
+
+	if (pd->num_threads)
+		return 0;
+
+	if (pipe(pd->pipe) < 0) {
+		wpa_printf(MSG_ERROR, "PSK: pipe: %s", strerror(errno));
+		return -1;
+	}
+	if (fcntl(pd->pipe[1], F_SETFL, O_NONBLOCK) < 0 ||
+	    eloop_register_read_sock(pd->pipe[0], psk_derive_receive, NULL,
+				     NULL) < 0)
+		goto fail;
+
+	num = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num < 1)
+		num = 1;
+	if (num > PSK_DERIVE_MAX_THREADS)
+		num = PSK_DERIVE_MAX_THREADS;
+	while (pd->num_threads < num &&
+	       pthread_create(&pd->threads[pd->num_threads], NULL,
+			      psk_derive_thread, NULL) == 0)
+		pd->num_threads++;
+	if (pd->num_threads == 0) {
+		wpa_printf(MSG_ERROR, "PSK: Could not start derivation threads");
+		eloop_unregister_read_sock(pd->pipe[0]);
+		goto fail;
+	}
+	wpa_printf(MSG_DEBUG, "PSK: Started %u derivation thread(s)",
+		   pd->num_threads);
+	return 0;
+
+fail:
+	close(pd->pipe[0]);
+	close(pd->pipe[1]);
+	pd->pipe[0] = pd->pipe[1] = -1;
+	return -1;
+}
+
+
+static int psk_derive_queue(struct psk_derive_job *job)
+{
+	if (psk_derive_threads_start() < 0)
+		return -1;
+
+	pthread_mutex_lock(&pd->lock);
+	dl_list_add_tail(&pd->queue, &job->list);
+	pd->running++;
+	pthread_cond_signal(&pd->work_cond);
+	pthread_mutex_unlock(&pd->lock);
+	return 0;
+}
+
+#else /* CONFIG_PSK_DERIVE_THREADS */
+
+static void psk_derive_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct psk_derive_job *job;
+
+	/* Jobs that psk_derive_flush() has already run */
+	while ((job = dl_list_first(&pd->done, struct psk_derive_job, list))) {
+		dl_list_del(&job->list);
+		psk_derive_job_done(job);
+	}
+
+	job = dl_list_first(&pd->queue, struct psk_derive_job, list);
+	if (job == NULL)
+		return;
+	dl_list_del(&job->list);
+	psk_derive_run(job);
+
+	/* Timeouts that became due during the derivation are run before the
+	 * next one since they are earlier in the timeout list */
+	if (!dl_list_empty(&pd->queue) &&
+	    !eloop_is_timeout_registered(psk_derive_timeout, NULL, NULL))
+		eloop_register_timeout(0, 0, psk_derive_timeout, NULL, NULL);
+	psk_derive_job_done(job);
+}
+
+
+static int psk_derive_queue(struct psk_derive_job *job)
+{
+	if (!eloop_is_timeout_registered(psk_derive_timeout, NULL, NULL) &&
+	    eloop_register_timeout(0, 0, psk_derive_timeout, NULL, NULL) < 0)
+		return -1;
+	dl_list_add_tail(&pd->queue, &job->list);
+	return 0;
+}
+
+#endif /* CONFIG_PSK_DERIVE_THREADS */
+
+
+void psk_derive(const char *passphrase, const u8 *ssid, size_t ssid_len,
+		u8 *psk)
+{
+	u8 tag[SHA1_MAC_LEN];
+
+	if (psk_derive_init() < 0) {
+		pbkdf2_sha1(passphrase, ssid, ssid_len, 4096, psk, PMK_LEN);
+		return;
+	}
+
+	psk_derive_tag(passphrase, ssid, ssid_len, tag);
+	if (psk_cache_get(tag, psk))
+		return;
+	pbkdf2_sha1(passphrase, ssid, ssid_len, 4096, psk, PMK_LEN);
+	psk_cache_add(tag, psk);
+}
+
+
+int psk_derive_start(const char *passphrase, const u8 *ssid, size_t ssid_len,
+		     u8 *psk, void (*cb)(void *ctx), void *ctx)
+{
+	struct psk_derive_job *job;
+	struct psk_derive_req *req;
+	u8 tag[SHA1_MAC_LEN];
+
+#ifndef CONFIG_PSK_DERIVE_THREADS
+	/* Without worker threads, there is nothing to gain from deferring a
+	 * derivation that has nothing to do until psk_derive_flush(). */
+	if (cb == NULL)
+		goto sync;
+#endif /* CONFIG_PSK_DERIVE_THREADS */
+	if (ssid_len > SSID_MAX_LEN || psk_derive_init() < 0)
+		goto sync;
+
+	psk_derive_tag(passphrase, ssid, ssid_len, tag);
+	if (psk_cache_get(tag, psk))
+		return 1;
+
+	req = os_zalloc(sizeof(*req));
+	if (req == NULL)
+		goto sync;
+	req->psk = psk;
+	req->cb = cb;
+	req->ctx = ctx;
+
+	/* Share a pending derivation of the same PSK */
+	dl_list_for_each(job, &pd->jobs, struct psk_derive_job, jobs) {
+		if (os_memcmp(job->tag, tag, SHA1_MAC_LEN) == 0) {
+			dl_list_add_tail(&job->reqs, &req->list);
+			return 0;
+		}
+	}
+
+	job = os_zalloc(sizeof(*job));
+	if (job == NULL) {
+		os_free(req);
+		goto sync;
+	}
+	dl_list_init(&job->reqs);
+	os_memcpy(job->tag, tag, SHA1_MAC_LEN);
+	os_memcpy(job->ssid, ssid, ssid_len);
+	job->ssid_len = ssid_len;
+	job->passphrase = os_strdup(passphrase);
+	if (job->passphrase == NULL || psk_derive_queue(job) < 0) {
+		psk_derive_job_free(job);
+		os_free(req);
+		goto sync;
+	}
+	dl_list_add_tail(&pd->jobs, &job->jobs);
+	dl_list_add_tail(&job->reqs, &req->list);
+	return 0;
+
+sync:
+	psk_derive(passphrase, ssid, ssid_len, psk);
+	return 1;
+}
+
+
+void psk_derive_cancel(void *ctx)
+{
+	struct psk_derive_job *job;
+	struct psk_derive_req *req, *tmp;
+
+	if (pd == NULL)
+		return;
+
+	/* The jobs are left running and their results are cached */
+	dl_list_for_each(job, &pd->jobs, struct psk_derive_job, jobs) {
+		dl_list_for_each_safe(req, tmp, &job->reqs,
+				      struct psk_derive_req, list) {
+			if (req->ctx == ctx) {
+				dl_list_del(&req->list);
+				os_free(req);
+			}
+		}
+	}
+}
+
+
+static int psk_derive_job_has_ctx(struct psk_derive_job *job, void *ctx)
+{
+	struct psk_derive_req *req;
+
+	dl_list_for_each(req, &job->reqs, struct psk_derive_req, list) {
+		if (req->ctx == ctx)
+			return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * Run a job that has not yet been taken by a worker thread or wait for the
+ * one that has. The job is left on the done list, so it is completed and its
+ * other requests are reported from the event loop as usual.
+ */
+static void psk_derive_job_wait(struct psk_derive_job *job)
+{
+#ifdef CONFIG_PSK_DERIVE_THREADS
+	char c = 0;
+
+	pthread_mutex_lock(&pd->lock);
+	if (!job->started) {
+		dl_list_del(&job->list);
+		job->started = 1;
+		pthread_mutex_unlock(&pd->lock);
+		psk_derive_run(job);
+		pthread_mutex_lock(&pd->lock);
+		dl_list_add_tail(&pd->done, &job->list);
+		job->ready = 1;
+		pd->running--;
+		if (write(pd->pipe[1], &c, 1) < 0) {
+			/* Earlier notifications are still pending */
+		}
+	}
+	while (!job->ready)
+		pthread_cond_wait(&pd->done_cond, &pd->lock);
+	pthread_mutex_unlock(&pd->lock);
+#else /* CONFIG_PSK_DERIVE_THREADS */
+	if (job->ready)
+		return;
+	dl_list_del(&job->list);
+	psk_derive_run(job);
+	job->ready = 1;
+	dl_list_add_tail(&pd->done, &job->list);
+	if (!eloop_is_timeout_registered(psk_derive_timeout, NULL, NULL))
+		eloop_register_timeout(0, 0, psk_derive_timeout, NULL, NULL);
+#endif /* CONFIG_PSK_DERIVE_THREADS */
+}
+
+
+void psk_derive_flush(void *ctx)
+{
+	struct psk_derive_job *job;
+	struct psk_derive_req *req, *tmp;
+
+	if (pd == NULL)
+		return;
+
+	dl_list_for_each(job, &pd->jobs, struct psk_derive_job, jobs) {
+		if (!psk_derive_job_has_ctx(job, ctx))
+			continue;
+		psk_derive_job_wait(job);
+		psk_cache_add(job->tag, job->psk);
+		dl_list_for_each_safe(req, tmp, &job->reqs,
+				      struct psk_derive_req, list) {
+			if (req->ctx != ctx)
+				continue;
+			dl_list_del(&req->list);
+			os_memcpy(req->psk, job->psk, PMK_LEN);
+			os_free(req);
+		}
+	}
+}
+
+
+void psk_derive_deinit(void)
+{
+	struct psk_derive_job *job;
+	struct psk_cache_entry *entry;
+#ifdef CONFIG_PSK_DERIVE_THREADS
+	unsigned int i;
+#endif /* CONFIG_PSK_DERIVE_THREADS */
+
+	if (pd == NULL)
+		return;
+
+#ifdef CONFIG_PSK_DERIVE_THREADS
+	if (pd->num_threads) {
+		pthread_mutex_lock(&pd->lock);
+		pd->stop = 1;
+		pthread_cond_broadcast(&pd->work_cond);
+		pthread_mutex_unlock(&pd->lock);
+		for (i = 0; i < pd->num_threads; i++)
+			pthread_join(pd->threads[i], NULL);
+		eloop_unregister_read_sock(pd->pipe[0]);
+		close(pd->pipe[0]);
+		close(pd->pipe[1]);
+	}
+	pthread_cond_destroy(&pd->done_cond);
+	pthread_cond_destroy(&pd->work_cond);
+	pthread_mutex_destroy(&pd->lock);
+#else /* CONFIG_PSK_DERIVE_THREADS */
+	eloop_cancel_timeout(psk_derive_timeout, NULL, NULL);
+#endif /* CONFIG_PSK_DERIVE_THREADS */
+
+	/* All jobs are on the list of pending jobs regardless of their state
+	 * and no worker thread is running anymore */
+	while ((job = dl_list_first(&pd->jobs, struct psk_derive_job, jobs))) {
+		dl_list_del(&job->jobs);
+		psk_derive_job_free(job);
+	}
+	while ((entry = dl_list_first(&pd->lru, struct psk_cache_entry,
+				      list)))
+		psk_cache_remove(entry);
+
+	bin_clear_free(pd, sizeof(*pd));
+	pd = NULL;
+}
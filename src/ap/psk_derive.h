@@ -0,0 +1,74 @@
+/*
+ * hostapd / WPA passphrase to PSK derivation
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef PSK_DERIVE_H
+#define PSK_DERIVE_H
+
+/**
+ * psk_derive - Derive a PSK from a passphrase
+ * @passphrase: ASCII passphrase (nul terminated)
+ * @ssid: SSID
+ * @ssid_len: Length of the SSID in octets
+ * @psk: Buffer for the PSK (PMK_LEN octets)
+ *
+ * The PSK is taken from the derivation cache if the same passphrase has
+ * already been used with the same SSID. Otherwise, it is derived with
+ * PBKDF2-SHA1 before returning and added to the cache.
+ */
+void psk_derive(const char *passphrase, const u8 *ssid, size_t ssid_len,
+		u8 *psk);
+
+/**
+ * psk_derive_start - Start deriving a PSK from a passphrase
+ * @passphrase: ASCII passphrase (nul terminated)
+ * @ssid: SSID
+ * @ssid_len: Length of the SSID in octets
+ * @psk: Buffer for the PSK (PMK_LEN octets)
+ * @cb: Function to call once @psk has been filled in or %NULL
+ * @ctx: Context data for @cb and psk_derive_cancel()
+ * Returns: 1 if @psk was filled in before returning, 0 if the derivation
+ *	is pending
+ *
+ * Pending derivations are completed from the event loop without blocking it
+ * for the duration of the PBKDF2 computation when hostapd is built with
+ * CONFIG_PSK_DERIVE_THREADS. Otherwise, one pending derivation is run per
+ * event loop iteration so that other events are processed in between. @psk
+ * has to remain valid until @cb is called or the request is cancelled.
+ *
+ * With @cb set to %NULL, the PSK becomes available only after a following
+ * psk_derive_flush() call with the same @ctx. This allows a batch of
+ * passphrases to be derived in parallel.
+ */
+int psk_derive_start(const char *passphrase, const u8 *ssid, size_t ssid_len,
+		     u8 *psk, void (*cb)(void *ctx), void *ctx);
+
+/**
+ * psk_derive_cancel - Cancel pending PSK derivations
+ * @ctx: Context data used with psk_derive_start()
+ *
+ * The callback functions of the cancelled requests are not called and their
+ * PSK buffers are not accessed after this.
+ */
+void psk_derive_cancel(void *ctx);
+
+/**
+ * psk_derive_flush - Wait for the pending PSK derivations of a batch
+ * @ctx: Context data used with psk_derive_start()
+ *
+ * The PSK buffers of the pending requests with @ctx are filled in before
+ * returning and the requests are removed without calling their callback
+ * functions. Requests with other context data, e.g., ones from RADIUS ACL
+ * queries, are left to be completed from the event loop.
+ */
+void psk_derive_flush(void *ctx);
+
+/**
+ * psk_derive_deinit - Stop the PSK derivation workers and clear the cache
+ */
+void psk_derive_deinit(void);
+
+#endif /* PSK_DERIVE_H */
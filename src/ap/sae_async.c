@@ -0,0 +1,408 @@
+/*
+ * hostapd / SAE Commit message processing outside the event loop
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * Deriving the PWE with hunting-and-pecking and the scalar operations for a
+ * received Commit message take tens of milliseconds of CPU time. The work is
+ * queued here instead of being done while processing the Authentication
+ * frame. With CONFIG_SAE_THREADS, worker threads process the queue and notify
+ * the event loop through a pipe. Otherwise, one queued Commit message is
+ * processed per event loop iteration.
+ *
+ * The queue is processed in arrival order, each peer can have only a single
+ * Commit message in it, and the number of queued messages is limited, so
+ * a peer flooding Commit messages cannot delay the others by more than one
+ * message each.
+ */
+
+#include "utils/includes.h"
+#ifdef CONFIG_SAE_THREADS
+#include <fcntl.h>
+#include <pthread.h>
+#endif /* CONFIG_SAE_THREADS */
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "utils/list.h"
+#include "common/sae.h"
+#include "sae_async.h"
+
+#define SAE_ASYNC_MAX_JOBS 32
+#define SAE_ASYNC_MAX_THREADS 4
+
+
+struct sae_async_job {
+	struct dl_list jobs; /* entry in the list of all pending jobs */
+	struct dl_list list; /* entry in the queue or the done list */
+	struct sae_data *sae;
+	u8 addr1[ETH_ALEN];
+	u8 addr2[ETH_ALEN];
+	u8 *password;
+	size_t password_len;
+	void (*cb)(void *eloop_ctx, void *user_ctx, int res);
+	void *eloop_ctx;
+	void *user_ctx;
+	int res;
+#ifdef CONFIG_SAE_THREADS
+	int busy; /* being processed by a worker thread */
+#endif /* CONFIG_SAE_THREADS */
+};
+
+struct sae_async_data {
+	/* Only the queue and the done list are accessed by worker threads */
+	struct dl_list jobs;
+	struct dl_list queue;
+	struct dl_list done;
+	unsigned int num_jobs;
+#ifdef CONFIG_SAE_THREADS
+	int stop;
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	pthread_t threads[SAE_ASYNC_MAX_THREADS];
+	unsigned int num_threads;
+	int pipe[2];
+#endif /* CONFIG_SAE_THREADS */
+};
+
+static struct sae_async_data *sd;
+
+
+static int sae_async_init(void)
+{
+	if (sd)
+		return 0;
+
+	sd = os_zalloc(sizeof(*sd));
+	if (sd == NULL)
+		return -1;
+	dl_list_init(&sd->jobs);
+	dl_list_init(&sd->queue);
+	dl_list_init(&sd->done);
+#ifdef CONFIG_SAE_THREADS
+	pthread_mutex_init(&sd->lock, NULL);
+	pthread_cond_init(&sd->work_cond, NULL);
+	pthread_cond_init(&sd->done_cond, NULL);
+	sd->pipe[0] = sd->pipe[1] = -1;
+#endif /* CONFIG_SAE_THREADS */
+
+	return 0;
+}
+
+
+static struct sae_async_job * sae_async_find(void *user_ctx)
+{
+	struct sae_async_job *job;
+
+	dl_list_for_each(job, &sd->jobs, struct sae_async_job, jobs) {
+		if (job->user_ctx == user_ctx)
+			return job;
+	}
+	return NULL;
+}
+
+
+static void sae_async_job_free(struct sae_async_job *job)
+{
+	dl_list_del(&job->jobs);
+	sd->num_jobs--;
+	bin_clear_free(job->password, job->password_len);
+	os_free(job);
+}
+
+
+static void sae_async_run(struct sae_async_job *job)
+{
+	if (job->password &&
+	    sae_prepare_commit(job->addr1, job->addr2, job->password,
+			       job->password_len, job->sae) < 0) {
+		wpa_printf(MSG_DEBUG, "SAE: Could not pick PWE");
+		job->res = -1;
+		return;
+	}
+	job->res = sae_process_commit(job->sae);
+}
+
+
+static void sae_async_job_done(struct sae_async_job *job)
+{
+	void (*cb)(void *eloop_ctx, void *user_ctx, int res) = job->cb;
+	void *eloop_ctx = job->eloop_ctx;
+	void *user_ctx = job->user_ctx;
+	int res = job->res;
+
+	/* The callback may start processing the next Commit message from the
+	 * same peer */
+	sae_async_job_free(job);
+	cb(eloop_ctx, user_ctx, res);
+}
+
+
+#ifdef CONFIG_SAE_THREADS
+
+static void * sae_async_thread(void *arg)
+{
+	struct sae_async_job *job;
+	char c = 0;
+
+	pthread_mutex_lock(&sd->lock);
+	for (;;) {
+		while (!sd->stop && dl_list_empty(&sd->queue))
+			pthread_cond_wait(&sd->work_cond, &sd->lock);
+		if (sd->stop)
+			break;
+
+		job = dl_list_first(&sd->queue, struct sae_async_job, list);
+		dl_list_del(&job->list);
+		job->busy = 1;
+		pthread_mutex_unlock(&sd->lock);
+		sae_async_run(job);
+		pthread_mutex_lock(&sd->lock);
+		job->busy = 0;
+		dl_list_add_tail(&sd->done, &job->list);
+		pthread_cond_broadcast(&sd->done_cond);
+
+		if (write(sd->pipe[1], &c, 1) < 0) {
+			/* The write end is non-blocking. A full pipe means
+			 * that the event loop has not yet read the earlier
+			 * notifications and it will find this job as well. */
+		}
+	}
+	pthread_mutex_unlock(&sd->lock);
+
+	return NULL;
+}
+
+
+static void sae_async_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct dl_list done;
+	struct sae_async_job *job;
+	char buf[64];
+
+	if (read(sock, buf, sizeof(buf)) < 0) {
+		wpa_printf(MSG_INFO, "SAE: read: %s", strerror(errno));
+		return;
+	}
+
+	dl_list_init(&done);
+	pthread_mutex_lock(&sd->lock);
+	while ((job = dl_list_first(&sd->done, struct sae_async_job, list))) {
+		dl_list_del(&job->list);
+		dl_list_add_tail(&done, &job->list);
+	}
+	pthread_mutex_unlock(&sd->lock);
+
+	/* A callback may cancel other jobs on the local list */
+	while ((job = dl_list_first(&done, struct sae_async_job, list))) {
+		dl_list_del(&job->list);
+		sae_async_job_done(job);
+	}
+}
+
+
+static int sae_async_threads_start(void)
+{
+	long num;
+
+	if (sd->num_threads)
+		return 0;
+
+	if (pipe(sd->pipe) < 0) {
+		wpa_printf(MSG_ERROR, "SAE: pipe: %s", strerror(errno));
+		return -1;
+	}
+	if (fcntl(sd->pipe[1], F_SETFL, O_NONBLOCK) < 0 ||
+	    eloop_register_read_sock(sd->pipe[0], sae_async_receive, NULL,
+				     NULL) < 0)
+		goto fail;
+
+	num = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num < 1)
+		num = 1;
+	if (num > SAE_ASYNC_MAX_THREADS)
+		num = SAE_ASYNC_MAX_THREADS;
+	while (sd->num_threads < num &&
+	       pthread_create(&sd->threads[sd->num_threads], NULL,
+			      sae_async_thread, NULL) == 0)
+		sd->num_threads++;
+	if (sd->num_threads == 0) {
+		wpa_printf(MSG_ERROR, "SAE: Could not start worker threads");
+		eloop_unregister_read_sock(sd->pipe[0]);
+		goto fail;
+	}
+	wpa_printf(MSG_DEBUG, "SAE: Started %u worker thread(s)",
+		   sd->num_threads);
+	return 0;
+
+fail:
+	close(sd->pipe[0]);
+	close(sd->pipe[1]);
+	sd->pipe[0] = sd->pipe[1] = -1;
+	return -1;
+}
+
+
+static int sae_async_queue(struct sae_async_job *job)
+{
+	if (sae_async_threads_start() < 0)
+		return -1;
+
+	pthread_mutex_lock(&sd->lock);
+	dl_list_add_tail(&sd->queue, &job->list);
+	pthread_cond_signal(&sd->work_cond);
+	pthread_mutex_unlock(&sd->lock);
+	return 0;
+}
+
+
+static void sae_async_dequeue(struct sae_async_job *job)
+{
+	pthread_mutex_lock(&sd->lock);
+	while (job->busy)
+		pthread_cond_wait(&sd->done_cond, &sd->lock);
+	/* Removed from the queue, the done list, or the local list of
+	 * sae_async_receive() */
+	dl_list_del(&job->list);
+	pthread_mutex_unlock(&sd->lock);
+}
+
+#else /* CONFIG_SAE_THREADS */
+
+static void sae_async_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct sae_async_job *job;
+
+	job = dl_list_first(&sd->queue, struct sae_async_job, list);
+	if (job == NULL)
+		return;
+	dl_list_del(&job->list);
+	sae_async_run(job);
+
+	/* Events that arrived during the processing are handled before the
+	 * next queued Commit message */
+	if (!dl_list_empty(&sd->queue))
+		eloop_register_timeout(0, 0, sae_async_timeout, NULL, NULL);
+	sae_async_job_done(job);
+}
+
+
+static int sae_async_queue(struct sae_async_job *job)
+{
+	if (!eloop_is_timeout_registered(sae_async_timeout, NULL, NULL) &&
+	    eloop_register_timeout(0, 0, sae_async_timeout, NULL, NULL) < 0)
+		return -1;
+	dl_list_add_tail(&sd->queue, &job->list);
+	return 0;
+}
+
+
+static void sae_async_dequeue(struct sae_async_job *job)
+{
+	dl_list_del(&job->list);
+}
+
+#endif /* CONFIG_SAE_THREADS */
+
+
+int sae_async_commit(struct sae_data *sae, const u8 *addr1, const u8 *addr2,
+		     const u8 *password, size_t password_len,
+		     void (*cb)(void *eloop_ctx, void *user_ctx, int res),
+		     void *eloop_ctx, void *user_ctx)
+{
+	struct sae_async_job *job;
+
+	if (sae_async_init() < 0 || sae_async_find(user_ctx))
+		return -1;
+	if (sd->num_jobs >= SAE_ASYNC_MAX_JOBS)
+		return 1;
+
+	job = os_zalloc(sizeof(*job));
+	if (job == NULL)
+		return -1;
+	job->sae = sae;
+	os_memcpy(job->addr1, addr1, ETH_ALEN);
+	os_memcpy(job->addr2, addr2, ETH_ALEN);
+	if (password) {
+		job->password = os_malloc(password_len);
+		if (job->password == NULL) {
+			os_free(job);
+			return -1;
+		}
+		os_memcpy(job->password, password, password_len);
+		job->password_len = password_len;
+	}
+	job->cb = cb;
+	job->eloop_ctx = eloop_ctx;
+	job->user_ctx = user_ctx;
+	dl_list_add_tail(&sd->jobs, &job->jobs);
+	sd->num_jobs++;
+
+	if (sae_async_queue(job) < 0) {
+		sae_async_job_free(job);
+		return -1;
+	}
+	return 0;
+}
+
+
+int sae_async_pending(void *user_ctx)
+{
+	return sd && sae_async_find(user_ctx) != NULL;
+}
+
+
+void sae_async_cancel(void *user_ctx)
+{
+	struct sae_async_job *job;
+
+	if (sd == NULL)
+		return;
+
+	job = sae_async_find(user_ctx);
+	if (job == NULL)
+		return;
+	sae_async_dequeue(job);
+	sae_async_job_free(job);
+}
+
+
+void sae_async_deinit(void)
+{
+	struct sae_async_job *job;
+#ifdef CONFIG_SAE_THREADS
+	unsigned int i;
+#endif /* CONFIG_SAE_THREADS */
+
+	if (sd == NULL)
+		return;
+
+#ifdef CONFIG_SAE_THREADS
+	if (sd->num_threads) {
+		pthread_mutex_lock(&sd->lock);
+		sd->stop = 1;
+		pthread_cond_broadcast(&sd->work_cond);
+		pthread_mutex_unlock(&sd->lock);
+		for (i = 0; i < sd->num_threads; i++)
+			pthread_join(sd->threads[i], NULL);
+		eloop_unregister_read_sock(sd->pipe[0]);
+		close(sd->pipe[0]);
+		close(sd->pipe[1]);
+	}
+	pthread_cond_destroy(&sd->done_cond);
+	pthread_cond_destroy(&sd->work_cond);
+	pthread_mutex_destroy(&sd->lock);
+#else /* CONFIG_SAE_THREADS */
+	eloop_cancel_timeout(sae_async_timeout, NULL, NULL);
+#endif /* CONFIG_SAE_THREADS */
+
+	/* All jobs are on the list of pending jobs regardless of their state
+	 * and no worker thread is running anymore */
+	while ((job = dl_list_first(&sd->jobs, struct sae_async_job, jobs)))
+		sae_async_job_free(job);
+
+	os_free(sd);
+	sd = NULL;
+}
@@ -0,0 +1,63 @@
+/*
+ * hostapd / SAE Commit message processing outside the event loop
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef SAE_ASYNC_H
+#define SAE_ASYNC_H
+
+struct sae_data;
+
+/**
+ * sae_async_commit - Start processing a received SAE Commit message
+ * @sae: SAE data with the parsed peer commit
+ * @addr1: Own MAC address for sae_prepare_commit()
+ * @addr2: Peer MAC address for sae_prepare_commit()
+ * @password: Password for sae_prepare_commit() or %NULL to use the
+ *	previously prepared own commit
+ * @password_len: Length of the password in octets
+ * @cb: Function to call from the event loop once the processing has been
+ *	completed; res is 0 on success or -1 on failure
+ * @eloop_ctx: Context data for @cb
+ * @user_ctx: Context data for @cb, sae_async_pending(), and sae_async_cancel()
+ * Returns: 0 if the processing is pending, 1 if the queue is full, or -1 if
+ *	the processing could not be started
+ *
+ * The own commit is prepared with sae_prepare_commit() if @password is set
+ * and the shared key is derived with sae_process_commit(). With
+ * CONFIG_SAE_THREADS, this is done by worker threads. Otherwise, one pending
+ * Commit message is processed per event loop iteration. @sae must not be
+ * accessed or freed before @cb is called or the processing is cancelled.
+ *
+ * Only a single Commit message can be pending for each @user_ctx.
+ */
+int sae_async_commit(struct sae_data *sae, const u8 *addr1, const u8 *addr2,
+		     const u8 *password, size_t password_len,
+		     void (*cb)(void *eloop_ctx, void *user_ctx, int res),
+		     void *eloop_ctx, void *user_ctx);
+
+/**
+ * sae_async_pending - Check whether a Commit message is being processed
+ * @user_ctx: Context data used with sae_async_commit()
+ * Returns: 1 if processing for @user_ctx is pending, 0 if not
+ */
+int sae_async_pending(void *user_ctx);
+
+/**
+ * sae_async_cancel - Cancel pending Commit message processing
+ * @user_ctx: Context data used with sae_async_commit()
+ *
+ * A worker thread that is already processing the Commit message is waited
+ * for. The callback function is not called and the SAE data is not accessed
+ * after this.
+ */
+void sae_async_cancel(void *user_ctx);
+
+/**
+ * sae_async_deinit - Stop the SAE worker threads
+ */
+void sae_async_deinit(void);
+
+#endif /* SAE_ASYNC_H */
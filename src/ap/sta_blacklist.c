@@ -1,6 +1,7 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "utils/eloop.h"
 #include "common/ieee802_11_defs.h"
 #include "eapol_auth/eapol_auth_sm.h"
 #include "hostapd.h"
@@ -10,11 +11,22 @@
 #include "sta_info.h"
 #include "sta_blacklist.h"
 
+static void sta_blacklist_expire(void *eloop_ctx, void *timeout_ctx);
+
+
+static unsigned int sta_blacklist_hash_idx(struct hostapd_data *hapd,
+					   const u8 *sta)
+{
+	return hwaddr_hash(hapd->blacklist_hash_key, sta) &
+		(STA_BLACKLIST_HASH_SIZE - 1);
+}
+
+
 /**
- * sta_blacklist_get - Get the blacklist entry for a BSSID
- * @wpa_s: Pointer to wpa_supplicant data
- * @bssid: BSSID
- * Returns: Matching blacklist entry for the BSSID or %NULL if not found
+ * sta_blacklist_get - Get the blacklist entry for a STA
+ * @hapd: Pointer to BSS data
+ * @sta: STA address
+ * Returns: Matching blacklist entry for the STA or %NULL if not found
  */
 struct sta_blacklist * sta_blacklist_get(struct hostapd_data *hapd, const u8 *sta) {
 	struct sta_blacklist *e;
@@ -22,11 +34,11 @@ struct sta_blacklist * sta_blacklist_get(struct hostapd_data *hapd, const u8 *st
 	if (hapd == NULL || sta == NULL)
 		return NULL;
 
-	e = hapd->blacklist;
+	e = hapd->blacklist_hash[sta_blacklist_hash_idx(hapd, sta)];
 	while (e) {
 		if (os_memcmp(e->sta, sta, ETH_ALEN) == 0)
 			return e;
-		e = e->next;
+		e = e->hnext;
 	}
 
 	return NULL;
@@ -41,100 +53,187 @@ int sta_blacklist_present(struct hostapd_data *hapd, const u8 *sta)
 }
 
 
+static void sta_blacklist_hash_add(struct hostapd_data *hapd,
+				   struct sta_blacklist *e)
+{
+	unsigned int idx = sta_blacklist_hash_idx(hapd, e->sta);
+
+	e->hnext = hapd->blacklist_hash[idx];
+	hapd->blacklist_hash[idx] = e;
+}
+
+
+static void sta_blacklist_hash_del(struct hostapd_data *hapd,
+				   struct sta_blacklist *e)
+{
+	struct sta_blacklist **pos =
+		&hapd->blacklist_hash[sta_blacklist_hash_idx(hapd, e->sta)];
+
+	while (*pos) {
+		if (*pos == e) {
+			*pos = e->hnext;
+			return;
+		}
+		pos = &(*pos)->hnext;
+	}
+}
+
+
+static void sta_blacklist_free(struct hostapd_data *hapd,
+			       struct sta_blacklist *e)
+{
+	sta_blacklist_hash_del(hapd, e);
+	dl_list_del(&e->list);
+	os_free(e);
+}
+
 
 /**
- * wpa_blacklist_add - Add an BSSID to the blacklist
- * @wpa_s: Pointer to wpa_supplicant data
- * @bssid: BSSID to be added to the blacklist
- * Returns: Current blacklist count on success, -1 on failure
- *
- * This function adds the specified BSSID to the blacklist or increases the
- * blacklist count if the BSSID was already listed. It should be called when
- * an association attempt fails either due to the selected BSS rejecting
- * association or due to timeout.
+ * sta_blacklist_add_ttl - Add a STA to the blacklist for a limited time
+ * @hapd: Pointer to BSS data
+ * @sta: STA address to be added to the blacklist
+ * @ttl: Number of seconds the entry is kept or 0 to keep it until removed
+ * Returns: 0 on success, -1 on failure
  *
- * This blacklist is used to force %wpa_supplicant to go through all available
- * BSSes before retrying to associate with an BSS that rejected or timed out
- * association. It does not prevent the listed BSS from being used; it only
- * changes the order in which they are tried.
+ * If the STA is already blacklisted, its expiration time is replaced with the
+ * new one. All entries share a single timeout that is scheduled for the
+ * earliest expiration.
  */
-int sta_blacklist_add(struct hostapd_data *hapd, const u8 *sta) {
+int sta_blacklist_add_ttl(struct hostapd_data *hapd, const u8 *sta,
+			  unsigned int ttl)
+{
 	struct sta_blacklist *e;
 
 	if (hapd == NULL || sta == NULL)
 		return -1;
 
 	e = sta_blacklist_get(hapd, sta);
-	if (e) {
+	if (e == NULL) {
+		e = os_zalloc(sizeof(*e));
+		if (e == NULL)
+			return -1;
+		os_memcpy(e->sta, sta, ETH_ALEN);
+
+		dl_list_add(&hapd->blacklist, &e->list);
+		sta_blacklist_hash_add(hapd, e);
+
+		hostapd_logger(hapd, NULL, HOSTAPD_MODULE_IEEE80211,
+			       HOSTAPD_LEVEL_INFO, "Added BSSID " MACSTR " into blacklist", MAC2STR(sta));
+	}
+
+	if (ttl == 0) {
+		e->expires.sec = 0;
+		e->expires.usec = 0;
 		return 0;
 	}
 
-	e = os_zalloc(sizeof(*e));
-	if (e == NULL)
-		return -1;
-	os_memcpy(e->sta, sta, ETH_ALEN);
+	os_get_reltime(&e->expires);
+	e->expires.sec += ttl;
+	if (eloop_deplete_timeout(ttl, 0, sta_blacklist_expire, hapd,
+				  NULL) < 0)
+		eloop_register_timeout(ttl, 0, sta_blacklist_expire, hapd,
+				       NULL);
+
+	return 0;
+}
 
 
-	e->next = hapd->blacklist;
-	hapd->blacklist = e;
+/**
+ * sta_blacklist_add - Add a STA to the blacklist
+ * @hapd: Pointer to BSS data
+ * @sta: STA address to be added to the blacklist
+ * Returns: 0 on success, -1 on failure
+ *
+ * The entry is kept until it is removed with sta_blacklist_rm() or
+ * sta_blacklist_clear().
+ */
+int sta_blacklist_add(struct hostapd_data *hapd, const u8 *sta) {
+	return sta_blacklist_add_ttl(hapd, sta, 0);
+}
 
-	hostapd_logger(hapd, NULL, HOSTAPD_MODULE_IEEE80211,
-		       HOSTAPD_LEVEL_INFO, "Added BSSID " MACSTR " into blacklist", MAC2STR(sta));
 
-	return 0;
+static void sta_blacklist_expire(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	struct sta_blacklist *e, *tmp;
+	struct os_reltime now, next, age;
+
+	os_get_reltime(&now);
+	next.sec = 0;
+	next.usec = 0;
+
+	dl_list_for_each_safe(e, tmp, &hapd->blacklist, struct sta_blacklist,
+			      list) {
+		if (!os_reltime_initialized(&e->expires))
+			continue;
+		if (!os_reltime_before(&now, &e->expires)) {
+			hostapd_logger(hapd, NULL, HOSTAPD_MODULE_IEEE80211,
+				       HOSTAPD_LEVEL_INFO, "Blacklist entry for " MACSTR " expired", MAC2STR(e->sta));
+			sta_blacklist_free(hapd, e);
+			continue;
+		}
+		if (!os_reltime_initialized(&next) ||
+		    os_reltime_before(&e->expires, &next))
+			next = e->expires;
+	}
+
+	if (os_reltime_initialized(&next)) {
+		os_reltime_sub(&next, &now, &age);
+		eloop_register_timeout(age.sec, age.usec, sta_blacklist_expire,
+				       hapd, NULL);
+	}
 }
 
+
 /**
- * wpa_blacklist_del - Remove an BSSID from the blacklist
- * @wpa_s: Pointer to wpa_supplicant data
- * @bssid: BSSID to be removed from the blacklist
+ * sta_blacklist_rm - Remove a STA from the blacklist
+ * @hapd: Pointer to BSS data
+ * @sta: STA address to be removed from the blacklist
  * Returns: 0 on success, -1 on failure
  */
 int sta_blacklist_rm(struct hostapd_data *hapd, const u8 *sta) {
-	struct sta_blacklist *e, *prev = NULL;
+	struct sta_blacklist *e;
 
-	if (hapd == NULL || sta == NULL)
+	e = sta_blacklist_get(hapd, sta);
+	if (e == NULL)
 		return -1;
 
-	e = hapd->blacklist;
-	while (e) {
-		if (os_memcmp(e->sta, sta, ETH_ALEN) == 0) {
-			if (prev == NULL) {
-				hapd->blacklist = e->next;
-			} else {
-				prev->next = e->next;
-			}
-
-			hostapd_logger(hapd, NULL, HOSTAPD_MODULE_IEEE80211,
-				       HOSTAPD_LEVEL_INFO, "Removed BSSID " MACSTR " from blacklist", MAC2STR(sta));
+	hostapd_logger(hapd, NULL, HOSTAPD_MODULE_IEEE80211,
+		       HOSTAPD_LEVEL_INFO, "Removed BSSID " MACSTR " from blacklist", MAC2STR(sta));
 
-			os_free(e);
+	sta_blacklist_free(hapd, e);
 
-			return 0;
-		}
-		prev = e;
-		e = e->next;
-	}
-	return -1;
+	return 0;
 }
 
 /**
- * wpa_blacklist_clear - Clear the blacklist of all entries
- * @wpa_s: Pointer to wpa_supplicant data
+ * sta_blacklist_clear - Clear the blacklist of all entries
+ * @hapd: Pointer to BSS data
  */
 int sta_blacklist_clear(struct hostapd_data *hapd) {
-	struct sta_blacklist *e, *prev;
+	struct sta_blacklist *e, *tmp;
 
-	e = hapd->blacklist;
-	hapd->blacklist = NULL;
-	while (e) {
-		prev = e;
-		e = e->next;
+	eloop_cancel_timeout(sta_blacklist_expire, hapd, NULL);
+	dl_list_for_each_safe(e, tmp, &hapd->blacklist, struct sta_blacklist,
+			      list) {
 		hostapd_logger(hapd, NULL, HOSTAPD_MODULE_IEEE80211,
-			       HOSTAPD_LEVEL_INFO, "Removed BSSID " MACSTR " from blacklist", MAC2STR(prev->sta));
-		//wpa_printf(MSG_ERROR, "Removed BSSID " MACSTR " from blacklist (clear)", MAC2STR(prev->sta));
-		os_free(prev);
+			       HOSTAPD_LEVEL_INFO, "Removed BSSID " MACSTR " from blacklist", MAC2STR(e->sta));
+		sta_blacklist_free(hapd, e);
 	}
 
 	return 0;
 }
+
+/**
+ * sta_blacklist_deinit - Free all blacklist entries on BSS deinit
+ * @hapd: Pointer to BSS data
+ */
+void sta_blacklist_deinit(struct hostapd_data *hapd)
+{
+	struct sta_blacklist *e, *tmp;
+
+	eloop_cancel_timeout(sta_blacklist_expire, hapd, NULL);
+	dl_list_for_each_safe(e, tmp, &hapd->blacklist, struct sta_blacklist,
+			      list)
+		sta_blacklist_free(hapd, e);
+}
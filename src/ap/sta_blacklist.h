@@ -1,14 +1,21 @@
 #ifndef STA_BLACKLIST_H
 #define STA_BLACKLIST_H
 
+#include "list.h"
+
 struct sta_blacklist {
-	struct sta_blacklist *next;
+	struct dl_list list; /* hapd->blacklist */
+	struct sta_blacklist *hnext; /* next entry in hapd->blacklist_hash */
 	u8 sta[ETH_ALEN];
+	struct os_reltime expires; /* 0 = never expires */
 };
 
 struct sta_blacklist * sta_blacklist_get(struct hostapd_data *hapd, const u8 *sta);
 int sta_blacklist_present(struct hostapd_data *hapd, const u8 *sta);
 int sta_blacklist_add(struct hostapd_data *hapd, const u8 *sta);
+int sta_blacklist_add_ttl(struct hostapd_data *hapd, const u8 *sta,
+			  unsigned int ttl);
 int sta_blacklist_rm(struct hostapd_data *hapd, const u8 *sta);
 int sta_blacklist_clear(struct hostapd_data *hapd);
+void sta_blacklist_deinit(struct hostapd_data *hapd);
 #endif /* STA_BLACKLIST_H */
@@ -34,6 +34,7 @@
 #include "wnm_ap.h"
 #include "ndisc_snoop.h"
 #include "sta_info.h"
+#include "sae_async.h"
 #include "net_steering.h"
 
 #ifdef HOSTAPD
@@ -67,11 +68,70 @@ int ap_for_each_sta(struct hostapd_data *hapd,
 }
 
 
+static unsigned int ap_sta_hash_idx(struct hostapd_data *hapd, const u8 *addr)
+{
+	return hwaddr_hash(hapd->sta_hash_key, addr) &
+		(hapd->sta_hash_size - 1);
+}
+
+
+static int ap_sta_hash_resize(struct hostapd_data *hapd, unsigned int size)
+{
+	struct sta_info **old = hapd->sta_hash, **hash, *sta, *next;
+	unsigned int i, old_size = hapd->sta_hash_size, idx;
+
+	hash = os_calloc(size, sizeof(*hash));
+	if (hash == NULL)
+		return -1;
+	if (old == NULL &&
+	    os_get_random(hapd->sta_hash_key, sizeof(hapd->sta_hash_key)) < 0)
+		wpa_printf(MSG_DEBUG, "AP: Could not generate STA hash key");
+
+	hapd->sta_hash = hash;
+	hapd->sta_hash_size = size;
+	for (i = 0; i < old_size; i++) {
+		for (sta = old[i]; sta; sta = next) {
+			next = sta->hnext;
+			idx = ap_sta_hash_idx(hapd, sta->addr);
+			sta->hnext = hash[idx];
+			hash[idx] = sta;
+		}
+	}
+	os_free(old);
+
+	return 0;
+}
+
+
+/* Make room for one more STA in the hash table */
+static int ap_sta_hash_reserve(struct hostapd_data *hapd)
+{
+	if (hapd->sta_hash == NULL)
+		return ap_sta_hash_resize(hapd, STA_HASH_MIN_SIZE);
+	if ((unsigned int) hapd->num_sta >= hapd->sta_hash_size)
+		ap_sta_hash_resize(hapd, hapd->sta_hash_size * 2);
+	/* A failed resize only makes the hash chains longer */
+	return 0;
+}
+
+
+void ap_sta_hash_deinit(struct hostapd_data *hapd)
+{
+	if (hapd->sta_list)
+		return; /* still in use */
+	os_free(hapd->sta_hash);
+	hapd->sta_hash = NULL;
+	hapd->sta_hash_size = 0;
+}
+
+
 struct sta_info * ap_get_sta(struct hostapd_data *hapd, const u8 *sta)
 {
 	struct sta_info *s;
 
-	s = hapd->sta_hash[STA_HASH(sta)];
+	if (hapd->sta_hash == NULL)
+		return NULL;
+	s = hapd->sta_hash[ap_sta_hash_idx(hapd, sta)];
 	while (s != NULL && os_memcmp(s->addr, sta, 6) != 0)
 		s = s->hnext;
 	return s;
@@ -124,19 +184,30 @@ static void ap_sta_list_del(struct hostapd_data *hapd, struct sta_info *sta)
 
 void ap_sta_hash_add(struct hostapd_data *hapd, struct sta_info *sta)
 {
-	sta->hnext = hapd->sta_hash[STA_HASH(sta->addr)];
-	hapd->sta_hash[STA_HASH(sta->addr)] = sta;
+	unsigned int idx;
+
+	if (hapd->sta_hash == NULL && ap_sta_hash_reserve(hapd) < 0) {
+		wpa_printf(MSG_ERROR, "AP: Could not allocate STA hash table");
+		return;
+	}
+	idx = ap_sta_hash_idx(hapd, sta->addr);
+	sta->hnext = hapd->sta_hash[idx];
+	hapd->sta_hash[idx] = sta;
 }
 
 
 static void ap_sta_hash_del(struct hostapd_data *hapd, struct sta_info *sta)
 {
 	struct sta_info *s;
+	unsigned int idx;
 
-	s = hapd->sta_hash[STA_HASH(sta->addr)];
+	if (hapd->sta_hash == NULL)
+		return;
+	idx = ap_sta_hash_idx(hapd, sta->addr);
+	s = hapd->sta_hash[idx];
 	if (s == NULL) return;
 	if (os_memcmp(s->addr, sta->addr, 6) == 0) {
-		hapd->sta_hash[STA_HASH(sta->addr)] = s->hnext;
+		hapd->sta_hash[idx] = s->hnext;
 		return;
 	}
 
@@ -319,6 +390,7 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 	os_free(sta->hs20_session_info_url);
 
 #ifdef CONFIG_SAE
+	sae_async_cancel(sta);
 	sae_clear_data(sta->sae);
 	os_free(sta->sae);
 #endif /* CONFIG_SAE */
@@ -622,6 +694,11 @@ struct sta_info * ap_sta_add(struct hostapd_data *hapd, const u8 *addr)
 		return NULL;
 	}
 
+	if (ap_sta_hash_reserve(hapd) < 0) {
+		wpa_printf(MSG_ERROR, "malloc failed");
+		return NULL;
+	}
+
 	sta = os_zalloc(sizeof(struct sta_info));
 	if (sta == NULL) {
 		wpa_printf(MSG_ERROR, "malloc failed");
@@ -87,6 +87,7 @@ struct sta_info {
 	unsigned int session_timeout_set:1;
 	unsigned int radius_das_match:1;
 	unsigned int dot11MgmtOptionBSSTransitionActivated:1;
+	unsigned int acct_selected:1; /* interim update in progress */
 	u16 auth_alg;
 
 	enum {
@@ -106,6 +107,8 @@ struct sta_info {
 	int acct_session_started;
 	int acct_terminate_cause; /* Acct-Terminate-Cause */
 	int acct_interim_interval; /* Acct-Interim-Interval */
+	struct dl_list acct_list; /* entry in struct hostapd_acct_sched */
+	os_time_t acct_next_update; /* next interim update/counter poll */
 
 	unsigned long last_rx_bytes;
 	unsigned long last_tx_bytes;
@@ -176,6 +179,9 @@ struct sta_info {
 #define TAXONOMY_STRING_LEN 1536
 	char probe_ie_taxonomy[TAXONOMY_STRING_LEN];
 	char assoc_ie_taxonomy[TAXONOMY_STRING_LEN];
+	/* Hashes of the IE contents the signatures above were built from */
+	u32 probe_ie_hash;
+	u32 assoc_ie_hash;
 #endif /* CONFIG_CLIENT_TAXONOMY */
 };
 
@@ -205,6 +211,7 @@ int ap_for_each_sta(struct hostapd_data *hapd,
 struct sta_info * ap_get_sta(struct hostapd_data *hapd, const u8 *sta);
 struct sta_info * ap_get_sta_p2p(struct hostapd_data *hapd, const u8 *addr);
 void ap_sta_hash_add(struct hostapd_data *hapd, struct sta_info *sta);
+void ap_sta_hash_deinit(struct hostapd_data *hapd);
 void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta);
 void ap_sta_ip6addr_del(struct hostapd_data *hapd, struct sta_info *sta);
 void hostapd_free_stas(struct hostapd_data *hapd);
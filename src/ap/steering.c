@@ -8,7 +8,10 @@
 
 #include "includes.h"
 
+#include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
 #include "common.h"
@@ -17,6 +20,7 @@
 #include "common/wpa_ctrl.h"
 #include "hostapd.h"
 #include "steering.h"
+#include "bin_event.h"
 
 #define BANDSTEER_DIR_MODE S_IRWXU
 
@@ -107,50 +111,70 @@ static char *steering_ssid_name(const struct hostapd_data *hapd,
 }
 
 /**
- * Gets the appropriate timestamp directory path and puts it into buf.
+ * Gets the name of the timestamp scope for an event and puts it into buf.
  * It returns the number of characters written.
  *
+ * The scope identifies the set of timestamps an event belongs to. It is used
+ * both as the scope key in the shared timestamp store and as the name of the
+ * timestamp subdirectory when exporting timestamps as files.
+ *
  * hapd: struct representing this particular BSS.
  * steer_event: actual type of the event (e.g. STEER_EVENT_PROBE,
  *    STEER_EVENT_ATTEMPT, STEER_EVENT_CONNECT).
- *    If steer_event is STEER_EVENT_CONNECT, then the timestamp directory is
- *    chosen based upon the SSID for this interface (the interface type
- *    does not matter in this case).
+ *    If steer_event is STEER_EVENT_CONNECT, then the scope is chosen based
+ *    upon the SSID for this interface (the interface type does not matter in
+ *    this case).
  * interface_type: whether to use the CURRENT_INTERFACE (i.e. hapd) or the
  *    steering TARGET_INTERFACE for interface-based timestamps (all but
  *    LOG_CONNECT).
  */
-static int get_timestamp_dir(const struct hostapd_data *hapd,
-                             steer_event_type steer_event,
-                             steering_interface_type interface_type,
-                             char *buf,
-                             size_t buf_size) {
-	if (steering_path == NULL) {
-		return 0;
-	}
-
+static int get_timestamp_scope(const struct hostapd_data *hapd,
+                               steer_event_type steer_event,
+                               steering_interface_type interface_type,
+                               char *buf,
+                               size_t buf_size) {
 	int pos;
-	pos = os_strlcpy(buf, steering_path, buf_size);
-	pos += os_strlcpy(&buf[pos], "/", buf_size - pos);
 
-	char *subdir;
 	if (steer_event == STEER_EVENT_CONNECT) {
-		pos += os_strlcpy(&buf[pos], "s_", buf_size - pos);
+		pos = os_strlcpy(buf, "s_", buf_size);
 		pos += ssid_to_str(&buf[pos], buf_size - pos,
 		                   hapd->conf->ssid.ssid,
 		                   hapd->conf->ssid.ssid_len);
 	} else if (interface_type == TARGET_INTERFACE) {
-		pos += os_strlcpy(&buf[pos], "i_", buf_size - pos);
+		pos = os_strlcpy(buf, "i_", buf_size);
 		pos += os_strlcpy(&buf[pos], steering_target_interface,
 		                  buf_size - pos);
 	} else {
-		pos += os_strlcpy(&buf[pos], "i_", buf_size - pos);
+		pos = os_strlcpy(buf, "i_", buf_size);
 		pos += os_strlcpy(&buf[pos], steering_interface_name(hapd),
 		                  buf_size - pos);
 	}
 	return pos;
 }
 
+/**
+ * Gets the appropriate timestamp directory path and puts it into buf.
+ * It returns the number of characters written.
+ *
+ * See get_timestamp_scope() for the meaning of the arguments.
+ */
+static int get_timestamp_dir(const struct hostapd_data *hapd,
+                             steer_event_type steer_event,
+                             steering_interface_type interface_type,
+                             char *buf,
+                             size_t buf_size) {
+	if (steering_path == NULL) {
+		return 0;
+	}
+
+	int pos;
+	pos = os_strlcpy(buf, steering_path, buf_size);
+	pos += os_strlcpy(&buf[pos], "/", buf_size - pos);
+	pos += get_timestamp_scope(hapd, steer_event, interface_type,
+	                           &buf[pos], buf_size - pos);
+	return pos;
+}
+
 static int get_timestamp_filename(const u8 *mac,
                                   const struct hostapd_data *hapd,
                                   steer_event_type steer_event,
@@ -174,27 +198,292 @@ static int get_timestamp_filename(const u8 *mac,
 }
 
 
-int bandsteer_init() {
-	char mkpath[256];
-	char *p;
-	int rc = 0;
+/*
+ * Shared timestamp store
+ *
+ * All hostapd processes on this box that use the same steering_path share a
+ * single fixed-size timestamp table that is mmap'd from
+ * STEERING_STORE_FILENAME in that directory. The table is open-addressed and
+ * set-associative: a (MAC, event, scope) key hashes to one set of
+ * STEERING_STORE_WAYS entries and, when the set is full, the least recently
+ * written entry in it is evicted. Access is serialized between processes with
+ * flock(), so a timestamp read or update costs two syscalls instead of the
+ * stat/open/read/scandir/rename sequence needed for per-event files.
+ */
 
-	if (!steering_path) {
-		hostapd_logger(NULL, NULL, HOSTAPD_MODULE_IEEE80211,
-		                 HOSTAPD_LEVEL_INFO, "Steering disabled");
-		return 0;
+#define STEERING_STORE_FILENAME "timestamps.db"
+#define STEERING_STORE_MAGIC 0x54534231 /* "TSB1" */
+#define STEERING_STORE_VERSION 1
+#define STEERING_STORE_SETS 512
+#define STEERING_STORE_WAYS 8
+#define STEERING_STORE_MAX_SCOPES 32
+#define STEERING_STORE_SCOPE_LEN 112
+
+struct steering_store_entry {
+	u8 mac[ETH_ALEN];
+	u8 event; /* steer_event_type + 1, 0 if the entry is unused */
+	u8 scope;
+	u32 last_write; /* value of steering_store::clock at the last write */
+	s64 sec;
+	s64 usec;
+};
+
+struct steering_store {
+	u32 magic;
+	u32 version;
+	u32 num_sets;
+	u32 num_ways;
+	u32 clock;
+	u32 num_scopes;
+	char scopes[STEERING_STORE_MAX_SCOPES][STEERING_STORE_SCOPE_LEN];
+	struct steering_store_entry entries[STEERING_STORE_SETS *
+	                                    STEERING_STORE_WAYS];
+};
+
+static int steering_store_fd = -1;
+static struct steering_store *steering_store = NULL;
+
+static int steering_store_lock(int operation) {
+	while (flock(steering_store_fd, operation) == -1) {
+		if (errno != EINTR) {
+			wpa_printf(MSG_ERROR, "flock(%s): %s",
+			           STEERING_STORE_FILENAME, strerror(errno));
+			return -1;
+		}
 	}
+	return 0;
+}
 
-	hostapd_logger(NULL, NULL, HOSTAPD_MODULE_IEEE80211, HOSTAPD_LEVEL_INFO,
-	               "Steering enabled: target=%s, dir=%s",
-	               steering_target_interface, steering_path);
+static void steering_store_unlock(void) {
+	flock(steering_store_fd, LOCK_UN);
+}
 
-	if (steering_path[0] != '/') {
-		wpa_printf(MSG_ERROR,
-		           "Band steering path (%s) is not absolute.",
-		           steering_path);
+static int steering_store_valid(const struct steering_store *store) {
+	return store->magic == STEERING_STORE_MAGIC &&
+	       store->version == STEERING_STORE_VERSION &&
+	       store->num_sets == STEERING_STORE_SETS &&
+	       store->num_ways == STEERING_STORE_WAYS &&
+	       store->num_scopes <= STEERING_STORE_MAX_SCOPES;
+}
+
+/**
+ * Opens (creating or resetting it if necessary) and maps the shared timestamp
+ * store in steering_path. Returns 0 on success.
+ */
+static int steering_store_open(void) {
+	char filename[256];
+	struct stat st;
+	void *map;
+	int fd;
+
+	os_snprintf(filename, sizeof(filename), "%s/%s", steering_path,
+	            STEERING_STORE_FILENAME);
+	fd = open(filename, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		wpa_printf(MSG_ERROR, "open(%s): %s", filename, strerror(errno));
+		return -1;
+	}
+	steering_store_fd = fd;
+
+	/* Hold the lock while checking the layout so that another hostapd
+	 * starting at the same time does not see a half-initialized store. */
+	if (steering_store_lock(LOCK_EX)) {
+		goto fail;
+	}
+	if (fstat(fd, &st) == -1) {
+		wpa_printf(MSG_ERROR, "fstat(%s): %s", filename, strerror(errno));
+		goto fail_unlock;
+	}
+	if (st.st_size != sizeof(struct steering_store) &&
+	    ftruncate(fd, sizeof(struct steering_store)) == -1) {
+		wpa_printf(MSG_ERROR, "ftruncate(%s): %s", filename,
+		           strerror(errno));
+		goto fail_unlock;
+	}
+
+	map = mmap(NULL, sizeof(struct steering_store), PROT_READ | PROT_WRITE,
+	           MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		wpa_printf(MSG_ERROR, "mmap(%s): %s", filename, strerror(errno));
+		goto fail_unlock;
+	}
+	steering_store = map;
+
+	if (!steering_store_valid(steering_store)) {
+		wpa_printf(MSG_INFO, "Initializing steering timestamp store %s",
+		           filename);
+		os_memset(steering_store, 0, sizeof(*steering_store));
+		steering_store->version = STEERING_STORE_VERSION;
+		steering_store->num_sets = STEERING_STORE_SETS;
+		steering_store->num_ways = STEERING_STORE_WAYS;
+		steering_store->magic = STEERING_STORE_MAGIC;
+	}
+	steering_store_unlock();
+	return 0;
+
+fail_unlock:
+	steering_store_unlock();
+fail:
+	close(fd);
+	steering_store_fd = -1;
+	return -1;
+}
+
+/**
+ * Finds the index of the named scope. If it is not yet known and add is set,
+ * the scope is added; the caller must hold the exclusive lock in that case.
+ * Returns -1 if the scope is not found (or cannot be added).
+ */
+static int steering_store_scope(const char *name, int add) {
+	struct steering_store *store = steering_store;
+	u32 i;
+
+	for (i = 0; i < store->num_scopes; i++) {
+		if (os_strncmp(store->scopes[i], name,
+		               STEERING_STORE_SCOPE_LEN) == 0) {
+			return i;
+		}
+	}
+	if (!add) {
+		return -1;
+	}
+	if (store->num_scopes == STEERING_STORE_MAX_SCOPES) {
+		wpa_printf(MSG_ERROR, "Steering timestamp store: too many scopes "
+		           "(cannot add %s)", name);
+		return -1;
+	}
+	os_strlcpy(store->scopes[i], name, STEERING_STORE_SCOPE_LEN);
+	store->num_scopes++;
+	return i;
+}
+
+static struct steering_store_entry *
+steering_store_set(const u8 *mac, steer_event_type steer_event, int scope) {
+	u32 hash = 2166136261U;
+	int i;
+
+	/* FNV-1a over the key */
+	for (i = 0; i < ETH_ALEN; i++) {
+		hash = (hash ^ mac[i]) * 16777619U;
+	}
+	hash = (hash ^ steer_event) * 16777619U;
+	hash = (hash ^ scope) * 16777619U;
+
+	return &steering_store->entries[(hash % STEERING_STORE_SETS) *
+	                                STEERING_STORE_WAYS];
+}
+
+static struct steering_store_entry *
+steering_store_find(struct steering_store_entry *set, const u8 *mac,
+                    steer_event_type steer_event, int scope) {
+	int i;
+
+	for (i = 0; i < STEERING_STORE_WAYS; i++) {
+		if (set[i].event == steer_event + 1 && set[i].scope == scope &&
+		    os_memcmp(set[i].mac, mac, ETH_ALEN) == 0) {
+			return &set[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Reads the timestamp stored for mac/steer_event in the given scope into
+ * timestamp (which may be NULL). Returns 1 if a timestamp was found.
+ */
+static int steering_store_read(const char *scope_name, const u8 *mac,
+                               steer_event_type steer_event,
+                               struct os_reltime *timestamp) {
+	struct steering_store_entry *entry;
+	int scope, found = 0;
+
+	if (steering_store_lock(LOCK_SH)) {
+		return 0;
+	}
+	scope = steering_store_scope(scope_name, 0);
+	if (scope >= 0) {
+		entry = steering_store_find(
+			steering_store_set(mac, steer_event, scope),
+			mac, steer_event, scope);
+		if (entry) {
+			if (timestamp) {
+				timestamp->sec = entry->sec;
+				timestamp->usec = entry->usec;
+			}
+			found = 1;
+		}
+	}
+	steering_store_unlock();
+	return found;
+}
+
+/**
+ * Stores timestamp for mac/steer_event in the given scope, evicting the least
+ * recently written entry of the set if needed. If fresh_secs is non-zero, an
+ * existing timestamp that is younger than fresh_secs is left untouched.
+ * Returns 1 if the timestamp was written, 0 if it was fresh, -1 on error.
+ */
+static int steering_store_write(const char *scope_name, const u8 *mac,
+                                steer_event_type steer_event,
+                                const struct os_reltime *timestamp,
+                                os_time_t fresh_secs) {
+	struct steering_store_entry *set, *entry;
+	struct os_reltime now, prev;
+	int scope, i, ret = 1;
+
+	if (steering_store_lock(LOCK_EX)) {
 		return -1;
 	}
+	scope = steering_store_scope(scope_name, 1);
+	if (scope < 0) {
+		ret = -1;
+		goto out;
+	}
+
+	set = steering_store_set(mac, steer_event, scope);
+	entry = steering_store_find(set, mac, steer_event, scope);
+	if (entry && fresh_secs) {
+		now = *timestamp;
+		prev.sec = entry->sec;
+		prev.usec = entry->usec;
+		if (!os_reltime_expired(&now, &prev, fresh_secs)) {
+			ret = 0;
+			goto out;
+		}
+	}
+	if (!entry) {
+		entry = &set[0];
+		for (i = 0; i < STEERING_STORE_WAYS; i++) {
+			if (!set[i].event) {
+				entry = &set[i];
+				break;
+			}
+			if (steering_store->clock - set[i].last_write >
+			    steering_store->clock - entry->last_write) {
+				entry = &set[i];
+			}
+		}
+		os_memcpy(entry->mac, mac, ETH_ALEN);
+		entry->event = steer_event + 1;
+		entry->scope = scope;
+	}
+	entry->sec = timestamp->sec;
+	entry->usec = timestamp->usec;
+	entry->last_write = ++steering_store->clock;
+
+out:
+	steering_store_unlock();
+	return ret;
+}
+
+/**
+ * Creates steering_path, including any missing parent directories.
+ * Returns 0 on success.
+ */
+static int ensure_steering_path_exists(void) {
+	char mkpath[256];
+	char *p;
+	int rc = 0;
 
 	os_strlcpy(mkpath, steering_path, sizeof(mkpath));
 	mkpath[sizeof(mkpath) - 1] = '\0';
@@ -220,13 +509,52 @@ int bandsteer_init() {
 	return rc;
 }
 
+int bandsteer_init() {
+	if (!steering_path) {
+		hostapd_logger(NULL, NULL, HOSTAPD_MODULE_IEEE80211,
+		                 HOSTAPD_LEVEL_INFO, "Steering disabled");
+		return 0;
+	}
+
+	hostapd_logger(NULL, NULL, HOSTAPD_MODULE_IEEE80211, HOSTAPD_LEVEL_INFO,
+	               "Steering enabled: target=%s, dir=%s, export=%d",
+	               steering_target_interface, steering_path,
+	               steering_export_files);
+
+	if (steering_path[0] != '/') {
+		wpa_printf(MSG_ERROR,
+		           "Band steering path (%s) is not absolute.",
+		           steering_path);
+		return -1;
+	}
+
+	if (ensure_steering_path_exists()) {
+		wpa_printf(MSG_ERROR, "Could not create band steering path %s: %s",
+		           steering_path, strerror(errno));
+		return -1;
+	}
+
+	return steering_store_open();
+}
+
+void bandsteer_deinit() {
+	if (steering_store) {
+		munmap(steering_store, sizeof(*steering_store));
+		steering_store = NULL;
+	}
+	if (steering_store_fd >= 0) {
+		close(steering_store_fd);
+		steering_store_fd = -1;
+	}
+}
+
 /**
  * Initializes steering data structures needed for a particular ssid.
  * Returns 0 on success.
  */
 static int bandsteer_ssid_init(struct hostapd_data *hapd) {
 	char mkpath[256];
-	if (!steering_path) {
+	if (!steering_path || !steering_export_files) {
 		return 0;
 	}
 	get_timestamp_dir(hapd, STEER_EVENT_CONNECT, CURRENT_INTERFACE,
@@ -239,7 +567,7 @@ int bandsteer_interface_init(struct hostapd_iface *iface) {
 	char mkpath[256];
 	int k;
 	int rc;
-	if (!steering_path) {
+	if (!steering_path || !steering_export_files) {
 		return 0;
 	}
 	get_timestamp_dir(iface->bss[0], STEER_EVENT_PROBE, CURRENT_INTERFACE,
@@ -380,60 +708,35 @@ static int garbage_collect_timestamp_files(
 }
 
 /**
- * Reads a timestamp from either request_logging_path or steering_timestamp_path
- * (based on path) for the source address in mgmt, putting the result in
- * timestamp.  Returns 1 if the read succeeded, 0 otherwise.
+ * Reads the timestamp for mac and steer_event from the shared timestamp store,
+ * putting the result in timestamp (which may be NULL to just check for its
+ * presence).  Returns 1 if the read succeeded, 0 otherwise.
  */
 static int read_timestamp(const struct hostapd_data *hapd,
                           const u8 *mac,
                           steer_event_type steer_event,
                           steering_interface_type interface_type,
                           struct os_reltime *timestamp) {
-	FILE *f;
-	char filename[1024];
-	int success = 1;
-	struct stat st;
-	os_time_t sec = 0, usec = 0;
-
-	if (!get_timestamp_filename(mac, hapd, steer_event, interface_type,
-	                            filename, sizeof(filename))) {
-		return 0;
-	}
-
-	if (stat(filename, &st) == -1) {
-		return 0;
-	}
-
-	f = fopen(filename, "r");
-	if (f == NULL) {
-		wpa_printf(MSG_ERROR, "open(%s) for read: %s", filename, strerror(errno));
-		return 0;
-	}
+	char scope[STEERING_STORE_SCOPE_LEN];
 
-	if (timestamp) {
-		if (fscanf(f, "%d %d", &timestamp->sec, &timestamp->usec) != 2) {
-			wpa_printf(MSG_ERROR, "fscanf from %s: %s", filename, strerror(errno));
-			success = 0;
-		}
-	}
-
-	if (fclose(f) == EOF) {
-		wpa_printf(MSG_ERROR, "fclose(%s): %s", filename, strerror(errno));
+	if (!steering_store) {
 		return 0;
 	}
 
-	return success;
+	get_timestamp_scope(hapd, steer_event, interface_type, scope,
+	                    sizeof(scope));
+	return steering_store_read(scope, mac, steer_event, timestamp);
 }
 
 /**
- * Writes timestamp for the source address in mgmt to request_logging_path.
- * Also garbage collects timestamps.
+ * Exports timestamp for mac to a file in the steering_path timestamp
+ * directories.  Also garbage collects timestamp files.
  * Returns 1 if the write succeeded, 0 otherwise.
  */
-static int write_timestamp(const struct hostapd_data *hapd,
-                           const u8 *mac,
-                           steer_event_type steer_event,
-                           const struct os_reltime *timestamp) {
+static int export_timestamp_file(const struct hostapd_data *hapd,
+                                 const u8 *mac,
+                                 steer_event_type steer_event,
+                                 const struct os_reltime *timestamp) {
 	FILE *f;
 	char filename[1024], tmp_filename[1024];
 	int success = 0;
@@ -467,7 +770,8 @@ static int write_timestamp(const struct hostapd_data *hapd,
 	}
 
 	if (timestamp) {
-		if (fprintf(f, "%d %d", timestamp->sec, timestamp->usec) < 0) {
+		if (fprintf(f, "%ld %ld", (long) timestamp->sec,
+		            (long) timestamp->usec) < 0) {
 			wpa_printf(MSG_ERROR, "fprintf to %s: %s", tmp_filename, strerror(errno));
 		} else {
 			success = 1;
@@ -485,33 +789,75 @@ static int write_timestamp(const struct hostapd_data *hapd,
 		return 0;
 	}
 
+	return success;
+}
+
+/**
+ * Writes timestamp for mac to the shared timestamp store (and, in export
+ * mode, to a timestamp file) unless there is an existing timestamp younger
+ * than fresh_secs.  A fresh_secs of 0 always writes the timestamp.
+ * Returns 0 on write failure, 1 otherwise.
+ */
+static int store_timestamp(const struct hostapd_data *hapd,
+                           const u8 *mac,
+                           steer_event_type steer_event,
+                           const struct os_reltime *timestamp,
+                           os_time_t fresh_secs) {
+	char scope[STEERING_STORE_SCOPE_LEN];
+	int rc;
+
+	if (!steering_store) {
+		return 0;
+	}
+
+	get_timestamp_scope(hapd, steer_event, CURRENT_INTERFACE, scope,
+	                    sizeof(scope));
+	rc = steering_store_write(scope, mac, steer_event, timestamp,
+	                          fresh_secs);
+	if (rc < 0) {
+		return 0;
+	}
+	if (rc == 0) {
+		/* Existing timestamp is still fresh */
+		return 1;
+	}
+
+	if (steering_export_files &&
+	    !export_timestamp_file(hapd, mac, steer_event, timestamp)) {
+		wpa_printf(MSG_ERROR, "Failed to export timestamp file.");
+	}
+
 	wpa_printf(MSG_INFO, "Set timestamp for " MACSTR
 	           " (iface=%s/%s, event=%d)",
 	           MAC2STR(mac), steering_interface_name(hapd),
 	           hapd->conf->iface, steer_event);
-	return success;
+	return 1;
+}
+
+/**
+ * Writes timestamp for mac to the shared timestamp store.
+ * Returns 1 if the write succeeded, 0 otherwise.
+ */
+static int write_timestamp(const struct hostapd_data *hapd,
+                           const u8 *mac,
+                           steer_event_type steer_event,
+                           const struct os_reltime *timestamp) {
+	return store_timestamp(hapd, mac, steer_event, timestamp, 0);
 }
 
 /**
- * Calls write_timestamp_file unless there is an existing timestamp younger than
- * BANDSTEERING_EXPIRATION_SECONDS.
- * Returns 0 on write or garbage collection failure, 1 otherwise.
+ * Calls write_timestamp unless there is an existing timestamp younger than
+ * BANDSTEERING_FRESH_SECONDS.
+ * Returns 0 on write failure, 1 otherwise.
  */
 static int maybe_write_timestamp(const struct hostapd_data *hapd,
                                  const u8 *mac,
                                  steer_event_type steer_event,
                                  const struct os_reltime *timestamp) {
-	struct os_reltime now, prev_timestamp;
-
-	os_get_reltime(&now);
-	if (!read_timestamp(hapd, mac, steer_event, CURRENT_INTERFACE,
-	                    &prev_timestamp) ||
-	    os_reltime_expired(&now, &prev_timestamp,
-	                       BANDSTEERING_FRESH_SECONDS)) {
-		if (!write_timestamp(hapd, mac, steer_event, timestamp)) {
-			wpa_printf(MSG_ERROR, "Failed to write timestamp file.");
-			return 0;
-		}
+	if (!store_timestamp(hapd, mac, steer_event, timestamp,
+	                     BANDSTEERING_FRESH_SECONDS)) {
+		wpa_printf(MSG_ERROR, "Failed to write timestamp.");
+		return 0;
 	}
 	return 1;
 }
@@ -550,6 +896,48 @@ int write_disconnect_timestamp(const struct hostapd_data *hapd,
 	return 0;
 }
 
+static const char * const no_steer_reason_txt[] = {
+	[BIN_NO_STEER_TARGET_INTERFACE] = "target-interface",
+	[BIN_NO_STEER_REASSOC] = "reassoc",
+	[BIN_NO_STEER_NEW_STATION] = "new-station",
+	[BIN_NO_STEER_DEFERRED] = "deferred",
+	[BIN_NO_STEER_NON_CANDIDATE] = "non-candidate",
+	[BIN_NO_STEER_WEAK_SIGNAL] = "weak-signal",
+};
+
+/*
+ * Report a steering decision to control interface monitors. |reason| is 0
+ * when the station is being steered, otherwise one of
+ * enum bin_event_no_steer_reason.
+ */
+static void report_steering(const struct hostapd_data *hapd,
+                            const u8 *sta_mac, int ssi_signal, u8 reason) {
+	struct wpabuf *ev;
+
+	ev = hostapd_bin_event_start(hapd, reason ? BIN_EVENT_STA_NO_STEERING :
+	                             BIN_EVENT_STA_STEERING,
+	                             ETH_ALEN + 4 + (reason ? 1 : 0),
+	                             reason ? 3 : 2);
+	if (ev) {
+		hostapd_bin_event_put_addr(ev, sta_mac);
+		hostapd_bin_event_put_s32(ev, BIN_ATTR_SIGNAL, ssi_signal);
+		if (reason)
+			hostapd_bin_event_put(ev, BIN_ATTR_REASON, &reason, 1);
+		hostapd_bin_event_send(hapd, ev);
+	}
+
+	if (!hostapd_text_event_wanted(hapd))
+		return;
+	if (reason)
+		wpa_msg(hapd->msg_ctx, MSG_INFO,
+		        AP_STA_NO_STEERING MACSTR " %s %d",
+		        MAC2STR(sta_mac), no_steer_reason_txt[reason],
+		        ssi_signal);
+	else
+		wpa_msg(hapd->msg_ctx, MSG_INFO, AP_STA_STEERING MACSTR " %d",
+		        MAC2STR(sta_mac), ssi_signal);
+}
+
 /*
  * To be called upon receiving an ASSOC request. Returns 1 if the sta with
  * |mac| should be steered, 0 otherwise.
@@ -570,9 +958,8 @@ int should_steer_on_assoc(const struct hostapd_data *hapd,
 		               HOSTAPD_MODULE_IEEE80211, HOSTAPD_LEVEL_INFO,
 		               "Assoc on steering target (%s); rssi=%d",
 		               steering_name, ssi_signal);
-		wpa_msg(hapd->msg_ctx, MSG_INFO,
-		               AP_STA_NO_STEERING MACSTR " target-interface %d",
-		               MAC2STR(sta_mac), ssi_signal);
+		report_steering(hapd, sta_mac, ssi_signal,
+		                BIN_NO_STEER_TARGET_INTERFACE);
 		return FALSE;
 	}
 	/* Steering is enabled and this is not the target interface. */
@@ -582,9 +969,8 @@ int should_steer_on_assoc(const struct hostapd_data *hapd,
 		               HOSTAPD_MODULE_IEEE80211, HOSTAPD_LEVEL_INFO,
 		               "Assoc no steer - reassoc; rssi=%d",
 		               ssi_signal);
-		wpa_msg(hapd->msg_ctx, MSG_INFO,
-		               AP_STA_NO_STEERING MACSTR " reassoc %d",
-		               MAC2STR(sta_mac), ssi_signal);
+		report_steering(hapd, sta_mac, ssi_signal,
+		                BIN_NO_STEER_REASSOC);
 		return FALSE;
 	}
 
@@ -597,9 +983,8 @@ int should_steer_on_assoc(const struct hostapd_data *hapd,
 		               "ssid=%s",
 		               steering_name, ssi_signal,
 		               steering_ssid_name(hapd, buf, sizeof(buf)));
-		wpa_msg(hapd->msg_ctx, MSG_INFO,
-		               AP_STA_NO_STEERING MACSTR " new-station %d",
-		               MAC2STR(sta_mac), ssi_signal);
+		report_steering(hapd, sta_mac, ssi_signal,
+		                BIN_NO_STEER_NEW_STATION);
 		return FALSE;
         }
 
@@ -619,9 +1004,8 @@ int should_steer_on_assoc(const struct hostapd_data *hapd,
 		               HOSTAPD_MODULE_IEEE80211, HOSTAPD_LEVEL_INFO,
 		               "Assoc no steer - deferred; rssi=%d",
 		               ssi_signal);
-		wpa_msg(hapd->msg_ctx, MSG_INFO,
-		               AP_STA_NO_STEERING MACSTR " deferred %d",
-		               MAC2STR(sta_mac), ssi_signal);
+		report_steering(hapd, sta_mac, ssi_signal,
+		                BIN_NO_STEER_DEFERRED);
 		return FALSE;
 	}
 
@@ -631,9 +1015,8 @@ int should_steer_on_assoc(const struct hostapd_data *hapd,
 		               HOSTAPD_MODULE_IEEE80211, HOSTAPD_LEVEL_INFO,
 		               "Assoc no steer - non-candidate; rssi=%d",
                                ssi_signal);
-		wpa_msg(hapd->msg_ctx, MSG_INFO,
-		               AP_STA_NO_STEERING MACSTR " non-candidate %d",
-		               MAC2STR(sta_mac), ssi_signal);
+		report_steering(hapd, sta_mac, ssi_signal,
+		                BIN_NO_STEER_NON_CANDIDATE);
 		return FALSE;
 	}
 
@@ -657,9 +1040,8 @@ int should_steer_on_assoc(const struct hostapd_data *hapd,
 		               "rssi=%d probe_delta_t=%d.%02d",
 		               ssi_signal, probe_delta_time.sec,
 		               probe_delta_time.usec / 10000);
-		wpa_msg(hapd->msg_ctx, MSG_INFO,
-		               AP_STA_NO_STEERING MACSTR " weak-signal %d",
-		               MAC2STR(sta_mac), ssi_signal);
+		report_steering(hapd, sta_mac, ssi_signal,
+		                BIN_NO_STEER_WEAK_SIGNAL);
 		return FALSE;
 	}
 
@@ -685,9 +1067,7 @@ int should_steer_on_assoc(const struct hostapd_data *hapd,
 		               steer_delta_time.usec / 10000,
 		               probe_delta_time.sec,
 		               probe_delta_time.usec / 10000);
-		wpa_msg(hapd->msg_ctx, MSG_INFO,
-		               AP_STA_STEERING MACSTR " %d",
-		               MAC2STR(sta_mac), ssi_signal);
+		report_steering(hapd, sta_mac, ssi_signal, 0);
 		return TRUE;
 	}
 
@@ -9,6 +9,8 @@
 #ifndef STEERING_H
 #define STEERING_H
 
+/* MAX_STEERING_TIMESTAMP_FILES is the number of timestamp files of each type
+ * kept per directory when exporting timestamps as files. */
 #define MAX_STEERING_TIMESTAMP_FILES 100
 /* BANDSTEERING_FRESH_SECONDS is how long we consider a probe timestamp to be
  * fresh (and we do not need to overwrite it). */
@@ -35,6 +37,10 @@ extern char *steering_path;
  *     We will never steer if the assoc request is weaker than this. */
 extern int steering_rsi_threshold;
 extern char *steering_target_interface;
+/* steering_export_files enables writing every timestamp also as a file in the
+ * steering_path directory tree (the format used before the shared timestamp
+ * store), for external tools that consume those files. */
+extern int steering_export_files;
 
 struct hostapd_data;
 enum hostapd_hw_mode;
@@ -60,6 +66,12 @@ typedef enum {
  */
 int bandsteer_init();
 
+/**
+ * Releases the band steering infrastructure set up by bandsteer_init(). This
+ * should be called at shutdown.
+ */
+void bandsteer_deinit();
+
 /**
  * Initializes bandsteering infrastructure related to one particular interface.
  * This should be called after bandsteer_init() but prior to bringing up an
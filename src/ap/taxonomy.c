@@ -27,6 +27,8 @@
 #include "utils/common.h"
 #include "hostapd.h"
 #include "sta_info.h"
+#include "taxonomy.h"
+#include "bin_event.h"
 
 /* Copy a string with no funny schtuff allowed; only alphanumerics. */
 static void no_mischief_strncpy(char *dst, const char *src, size_t n)
@@ -253,21 +255,125 @@ static void ie_to_string(char *fstr, size_t fstr_len,
 static void write_sta_taxonomy(const struct hostapd_data *hapd,
 	struct sta_info *sta)
 {
-	if ((os_strlen(sta->probe_ie_taxonomy) == 0) ||
-	    (os_strlen(sta->assoc_ie_taxonomy) == 0)) {
+	size_t probe_len = os_strlen(sta->probe_ie_taxonomy);
+	size_t assoc_len = os_strlen(sta->assoc_ie_taxonomy);
+	struct wpabuf *ev;
+
+	if ((probe_len == 0) || (assoc_len == 0)) {
 		return;
 	}
 
+	ev = hostapd_bin_event_start(hapd, BIN_EVENT_STA_TAXONOMY,
+				     ETH_ALEN + probe_len + assoc_len, 3);
+	if (ev) {
+		hostapd_bin_event_put_addr(ev, sta->addr);
+		hostapd_bin_event_put(ev, BIN_ATTR_TAXONOMY_PROBE,
+				      sta->probe_ie_taxonomy, probe_len);
+		hostapd_bin_event_put(ev, BIN_ATTR_TAXONOMY_ASSOC,
+				      sta->assoc_ie_taxonomy, assoc_len);
+		hostapd_bin_event_send(hapd, ev);
+	}
+
+	if (!hostapd_text_event_wanted(hapd))
+		return;
 	wpa_msg(hapd->msg_ctx, MSG_INFO,
 			AP_STA_TAXONOMY MACSTR " wifi4|probe:%s|assoc:%s",
 			MAC2STR(sta->addr), sta->probe_ie_taxonomy,
 			sta->assoc_ie_taxonomy);
 }
 
+static u32 fnv1a(u32 hash, const u8 *data, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= data[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/*
+ * Hash exactly the IE bytes ie_to_string() looks at, so that an unchanged
+ * hash means an unchanged signature. Elements like SSID or DS Parameter Set,
+ * which differ between channels but only contribute their tag number, do
+ * not cause the string to be rebuilt.
+ */
+static u32 ie_signature_hash(const u8 *ie, size_t ie_len)
+{
+	u32 hash = 2166136261U;
+
+	while (ie_len >= 2) {
+		u8 id, elen, hdr[2];
+		size_t used = 0;
+
+		id = *ie++;
+		elen = *ie++;
+		ie_len -= 2;
+
+		if (elen > ie_len) {
+			break;
+		}
+
+		if ((id == 221) && (elen >= 4)) {
+			int is_MSFT = (ie[0] == 0x00 && ie[1] == 0x50 && ie[2] == 0xf2);
+			used = (is_MSFT && ie[3] == 0x04) ? elen : 4;
+		} else if (id == 45) {
+			used = (elen < 7) ? elen : 7;
+		} else if (id == 191) {
+			used = (elen < 12) ? elen : 12;
+		} else if (id == 127) {
+			used = elen;
+		} else if ((id == 33) && (elen == 2)) {
+			used = 2;
+		}
+
+		hdr[0] = id;
+		hdr[1] = used;
+		hash = fnv1a(hash, hdr, sizeof(hdr));
+		hash = fnv1a(hash, ie, used);
+
+		ie += elen;
+		ie_len -= elen;
+	}
+
+	return hash;
+}
+
+static struct hostapd_taxonomy_entry *
+taxonomy_cache_slot(const struct hostapd_data *hapd, const u8 *addr)
+{
+	if (hapd->taxonomy_cache == NULL)
+		return NULL;
+	return &hapd->taxonomy_cache[hwaddr_hash(hapd->taxonomy_cache_key,
+						 addr) &
+				     (TAXONOMY_CACHE_SIZE - 1)];
+}
+
+static void taxonomy_cache_release(struct hostapd_taxonomy_entry *entry)
+{
+	os_free(entry->ie);
+	entry->ie = NULL;
+	entry->ie_len = 0;
+}
+
+static int taxonomy_cache_expired(struct hostapd_taxonomy_entry *entry,
+				  struct os_reltime *now)
+{
+	return os_reltime_expired(now, &entry->seen, TAXONOMY_CACHE_MAX_AGE);
+}
+
 void hostapd_taxonomy_probe_req(const struct hostapd_data *hapd,
 	struct sta_info *sta, const u8 *ie, size_t ie_len)
 {
 	char taxonomy[TAXONOMY_STRING_LEN];
+	u32 hash;
+
+	hash = ie_signature_hash(ie, ie_len);
+	if (sta->probe_ie_taxonomy[0] && hash == sta->probe_ie_hash)
+		return;
+	sta->probe_ie_hash = hash;
+
 	ie_to_string(taxonomy, sizeof(taxonomy), ie, ie_len);
 	if (os_strcmp(taxonomy, sta->probe_ie_taxonomy) != 0) {
 		os_memcpy(sta->probe_ie_taxonomy, taxonomy, os_strlen(taxonomy) + 1);
@@ -275,10 +381,86 @@ void hostapd_taxonomy_probe_req(const struct hostapd_data *hapd,
 	}
 }
 
+/*
+ * Remember the Probe Request IEs of a station that has no sta_info entry
+ * yet, so that its signature can be built once the station associates. The
+ * cache is direct-mapped by a keyed hash of the address; a colliding station
+ * replaces the older entry. Entries older than TAXONOMY_CACHE_MAX_AGE are
+ * not used and each call releases at most one of them, so that entries of
+ * stations that moved on to another (randomized) address do not linger.
+ */
+void hostapd_taxonomy_probe_req_cache(struct hostapd_data *hapd,
+	const u8 *addr, const u8 *ie, size_t ie_len)
+{
+	struct hostapd_taxonomy_entry *entry;
+	struct os_reltime now;
+	u32 hash;
+
+	if (ie_len == 0)
+		return;
+	if (hapd->taxonomy_cache == NULL) {
+		hapd->taxonomy_cache = os_calloc(TAXONOMY_CACHE_SIZE,
+						 sizeof(*hapd->taxonomy_cache));
+		if (hapd->taxonomy_cache == NULL)
+			return;
+		os_get_random(hapd->taxonomy_cache_key,
+			      sizeof(hapd->taxonomy_cache_key));
+	}
+
+	os_get_reltime(&now);
+	entry = &hapd->taxonomy_cache[hapd->taxonomy_cache_sweep++ &
+				      (TAXONOMY_CACHE_SIZE - 1)];
+	if (entry->ie && taxonomy_cache_expired(entry, &now))
+		taxonomy_cache_release(entry);
+
+	if (ie_len > TAXONOMY_CACHE_IE_LEN)
+		ie_len = TAXONOMY_CACHE_IE_LEN;
+	hash = ie_signature_hash(ie, ie_len);
+	entry = taxonomy_cache_slot(hapd, addr);
+	if (entry->ie && hash == entry->hash &&
+	    os_memcmp(entry->addr, addr, ETH_ALEN) == 0) {
+		entry->seen = now;
+		return;
+	}
+
+	taxonomy_cache_release(entry);
+	entry->ie = os_malloc(ie_len);
+	if (entry->ie == NULL)
+		return;
+	os_memcpy(entry->ie, ie, ie_len);
+	entry->ie_len = ie_len;
+	os_memcpy(entry->addr, addr, ETH_ALEN);
+	entry->hash = hash;
+	entry->seen = now;
+}
+
 void hostapd_taxonomy_assoc_req(const struct hostapd_data *hapd,
 	struct sta_info *sta, const u8 *ie, size_t ie_len)
 {
+	struct hostapd_taxonomy_entry *entry;
 	char taxonomy[TAXONOMY_STRING_LEN];
+	struct os_reltime now;
+	u32 hash;
+
+	entry = taxonomy_cache_slot(hapd, sta->addr);
+	if (entry && entry->ie &&
+	    os_memcmp(entry->addr, sta->addr, ETH_ALEN) == 0) {
+		os_get_reltime(&now);
+		if (sta->probe_ie_taxonomy[0] == '\0' &&
+		    !taxonomy_cache_expired(entry, &now)) {
+			ie_to_string(sta->probe_ie_taxonomy,
+				     sizeof(sta->probe_ie_taxonomy),
+				     entry->ie, entry->ie_len);
+			sta->probe_ie_hash = entry->hash;
+		}
+		taxonomy_cache_release(entry);
+	}
+
+	hash = ie_signature_hash(ie, ie_len);
+	if (sta->assoc_ie_taxonomy[0] && hash == sta->assoc_ie_hash)
+		return;
+	sta->assoc_ie_hash = hash;
+
 	ie_to_string(taxonomy, sizeof(taxonomy), ie, ie_len);
 	if (os_strcmp(taxonomy, sta->assoc_ie_taxonomy) != 0) {
 		os_memcpy(sta->assoc_ie_taxonomy, taxonomy, os_strlen(taxonomy) + 1);
@@ -286,4 +468,17 @@ void hostapd_taxonomy_assoc_req(const struct hostapd_data *hapd,
 	}
 }
 
+void hostapd_taxonomy_deinit(struct hostapd_data *hapd)
+{
+	size_t i;
+
+	if (hapd->taxonomy_cache == NULL)
+		return;
+
+	for (i = 0; i < TAXONOMY_CACHE_SIZE; i++)
+		taxonomy_cache_release(&hapd->taxonomy_cache[i]);
+	os_free(hapd->taxonomy_cache);
+	hapd->taxonomy_cache = NULL;
+}
+
 /* vim: set tabstop=4 softtabstop=4 shiftwidth=4 noexpandtab : */
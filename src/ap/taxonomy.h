@@ -9,8 +9,36 @@
 #ifndef TAXONOMY_H
 #define TAXONOMY_H
 
+/* Number of Probe Request signatures remembered for unknown stations */
+#define TAXONOMY_CACHE_SIZE 256
+/* Maximum number of Probe Request IE bytes kept per cache entry */
+#define TAXONOMY_CACHE_IE_LEN 512
+/* Seconds after which a cached Probe Request is no longer used */
+#define TAXONOMY_CACHE_MAX_AGE 60
+
+/**
+ * struct hostapd_taxonomy_entry - Cached Probe Request of an unknown station
+ * @addr: Station address
+ * @hash: Hash of the signature relevant contents of @ie
+ * @seen: Time the Probe Request was last received
+ * @ie: Copy of the first @ie_len IE bytes or %NULL if the slot is unused
+ * @ie_len: Length of @ie, at most %TAXONOMY_CACHE_IE_LEN
+ *
+ * The signature string is only built from @ie when the station associates.
+ */
+struct hostapd_taxonomy_entry {
+	u8 addr[ETH_ALEN];
+	u32 hash;
+	struct os_reltime seen;
+	u8 *ie;
+	size_t ie_len;
+};
+
 void hostapd_taxonomy_probe_req(const struct hostapd_data *hapd,
 	struct sta_info *sta, const u8 *ie, size_t ie_len);
+void hostapd_taxonomy_probe_req_cache(struct hostapd_data *hapd,
+	const u8 *addr, const u8 *ie, size_t ie_len);
+void hostapd_taxonomy_deinit(struct hostapd_data *hapd);
 void hostapd_taxonomy_assoc_req(const struct hostapd_data *hapd,
 	struct sta_info *sta, const u8 *ie, size_t ie_len);
 
@@ -36,6 +36,7 @@ static int wpa_sm_step(struct wpa_state_machine *sm);
 static int wpa_verify_key_mic(int akmp, struct wpa_ptk *PTK, u8 *data,
 			      size_t data_len);
 static void wpa_sm_call_step(void *eloop_ctx, void *timeout_ctx);
+static void wpa_psk_trial_continue(void *eloop_ctx, void *timeout_ctx);
 static void wpa_group_sm_step(struct wpa_authenticator *wpa_auth,
 			      struct wpa_group *group);
 static void wpa_request_new_ptk(struct wpa_state_machine *sm);
@@ -45,6 +46,10 @@ static int wpa_group_config_group_keys(struct wpa_authenticator *wpa_auth,
 				       struct wpa_group *group);
 static int wpa_derive_ptk(struct wpa_state_machine *sm, const u8 *snonce,
 			  const u8 *pmk, struct wpa_ptk *ptk);
+static int wpa_derive_ptk_verify(struct wpa_state_machine *sm,
+				 const u8 *snonce, const u8 *pmk,
+				 u8 *data, size_t data_len,
+				 struct wpa_ptk *ptk);
 static void wpa_group_free(struct wpa_authenticator *wpa_auth,
 			   struct wpa_group *group);
 static void wpa_group_get(struct wpa_authenticator *wpa_auth,
@@ -54,6 +59,8 @@ static void wpa_group_put(struct wpa_authenticator *wpa_auth,
 
 static const u32 dot11RSNAConfigGroupUpdateCount = 4;
 static const u32 dot11RSNAConfigPairwiseUpdateCount = 4;
+/* PSK candidates tried against msg 2/4 per event loop iteration */
+static const unsigned int wpa_psk_trial_batch = 64;
 static const u32 eapol_key_timeout_first = 100; /* ms */
 static const u32 eapol_key_timeout_subseq = 1000; /* ms */
 static const u32 eapol_key_timeout_first_group = 500; /* ms */
@@ -111,6 +118,17 @@ static inline const u8 * wpa_auth_get_psk(struct wpa_authenticator *wpa_auth,
 }
 
 
+static inline void wpa_auth_psk_selected(struct wpa_authenticator *wpa_auth,
+					 const u8 *addr,
+					 const u8 *p2p_dev_addr,
+					 const u8 *psk)
+{
+	if (wpa_auth->cb.psk_selected)
+		wpa_auth->cb.psk_selected(wpa_auth->cb.ctx, addr, p2p_dev_addr,
+					  psk);
+}
+
+
 static inline int wpa_auth_get_msk(struct wpa_authenticator *wpa_auth,
 				   const u8 *addr, u8 *msk, size_t *len)
 {
@@ -688,6 +706,7 @@ void wpa_auth_sta_deinit(struct wpa_state_machine *sm)
 	sm->pending_1_of_4_timeout = 0;
 	eloop_cancel_timeout(wpa_sm_call_step, sm, NULL);
 	eloop_cancel_timeout(wpa_rekey_ptk, sm->wpa_auth, sm);
+	eloop_cancel_timeout(wpa_psk_trial_continue, sm->wpa_auth, sm);
 	if (sm->in_step_loop) {
 		/* Must not free state machine while wpa_sm_step() is running.
 		 * Freeing will be completed in the end of wpa_sm_step(). */
@@ -837,10 +856,8 @@ static int wpa_try_alt_snonce(struct wpa_state_machine *sm, u8 *data,
 		} else
 			pmk = sm->PMK;
 
-		wpa_derive_ptk(sm, sm->alt_SNonce, pmk, &PTK);
-
-		if (wpa_verify_key_mic(sm->wpa_key_mgmt, &PTK, data, data_len)
-		    == 0) {
+		if (wpa_derive_ptk_verify(sm, sm->alt_SNonce, pmk, data,
+					  data_len, &PTK) == 0) {
 			ok = 1;
 			break;
 		}
@@ -857,6 +874,9 @@ static int wpa_try_alt_snonce(struct wpa_state_machine *sm, u8 *data,
 
 	wpa_printf(MSG_DEBUG,
 		   "WPA: Earlier SNonce resulted in matching MIC");
+	if (wpa_key_mgmt_wpa_psk(sm->wpa_key_mgmt))
+		wpa_auth_psk_selected(sm->wpa_auth, sm->addr,
+				      sm->p2p_dev_addr, pmk);
 	sm->alt_snonce_valid = 0;
 	os_memcpy(sm->SNonce, sm->alt_SNonce, WPA_NONCE_LEN);
 	os_memcpy(&sm->PTK, &PTK, sizeof(PTK));
@@ -2019,50 +2039,45 @@ static int wpa_derive_ptk(struct wpa_state_machine *sm, const u8 *snonce,
 }
 
 
-SM_STATE(WPA_PTK, PTKCALCNEGOTIATING)
-{
-	struct wpa_ptk PTK;
-	int ok = 0, psk_found = 0;
-	const u8 *pmk = NULL;
-
-	SM_ENTRY_MA(WPA_PTK, PTKCALCNEGOTIATING, wpa_ptk);
-	sm->EAPOLKeyReceived = FALSE;
-	sm->update_snonce = FALSE;
-
-	/* WPA with IEEE 802.1X: use the derived PMK from EAP
-	 * WPA-PSK: iterate through possible PSKs and select the one matching
-	 * the packet */
-	for (;;) {
-		if (wpa_key_mgmt_wpa_psk(sm->wpa_key_mgmt)) {
-			pmk = wpa_auth_get_psk(sm->wpa_auth, sm->addr,
-					       sm->p2p_dev_addr, pmk);
-			if (pmk == NULL)
-				break;
-			psk_found = 1;
-		} else
-			pmk = sm->PMK;
+/*
+ * Derive the PTK with a PMK candidate and verify the MIC of a received
+ * EAPOL-Key frame with it. With WPA-PSK, wrong candidates are rejected based
+ * on the KCK alone when possible, so that the rest of the PTK is derived only
+ * for the matching PMK.
+ */
+static int wpa_derive_ptk_verify(struct wpa_state_machine *sm,
+				 const u8 *snonce, const u8 *pmk,
+				 u8 *data, size_t data_len,
+				 struct wpa_ptk *ptk)
+{
+	if (wpa_key_mgmt_wpa_psk(sm->wpa_key_mgmt) &&
+	    !wpa_key_mgmt_ft(sm->wpa_key_mgmt) &&
+	    wpa_pmk_to_kck(pmk, PMK_LEN, "Pairwise key expansion",
+			   sm->wpa_auth->addr, sm->addr, sm->ANonce, snonce,
+			   ptk, sm->wpa_key_mgmt) == 0) {
+		if (wpa_verify_key_mic(sm->wpa_key_mgmt, ptk, data,
+				       data_len) < 0)
+			return -1;
+		return wpa_derive_ptk(sm, snonce, pmk, ptk);
+	}
 
-		wpa_derive_ptk(sm, sm->SNonce, pmk, &PTK);
+	wpa_derive_ptk(sm, snonce, pmk, ptk);
+	return wpa_verify_key_mic(sm->wpa_key_mgmt, ptk, data, data_len);
+}
 
-		if (wpa_verify_key_mic(sm->wpa_key_mgmt, &PTK,
-				       sm->last_rx_eapol_key,
-				       sm->last_rx_eapol_key_len) == 0) {
-			ok = 1;
-			break;
-		}
 
-		if (!wpa_key_mgmt_wpa_psk(sm->wpa_key_mgmt))
-			break;
-	}
+static void wpa_ptk_calc_failed(struct wpa_state_machine *sm, int psk_found)
+{
+	wpa_auth_logger(sm->wpa_auth, sm->addr, LOGGER_DEBUG,
+			"invalid MIC in msg 2/4 of 4-Way Handshake");
+	if (psk_found)
+		wpa_auth_psk_failure_report(sm->wpa_auth, sm->addr);
+}
 
-	if (!ok) {
-		wpa_auth_logger(sm->wpa_auth, sm->addr, LOGGER_DEBUG,
-				"invalid MIC in msg 2/4 of 4-Way Handshake");
-		if (psk_found)
-			wpa_auth_psk_failure_report(sm->wpa_auth, sm->addr);
-		return;
-	}
 
+static void wpa_ptk_calc_done(struct wpa_state_machine *sm, const u8 *pmk,
+			      struct wpa_ptk *ptk)
+{
 #ifdef CONFIG_IEEE80211R
 	if (sm->wpa == WPA_VERSION_WPA2 && wpa_key_mgmt_ft(sm->wpa_key_mgmt)) {
 		/*
@@ -2092,15 +2107,100 @@ SM_STATE(WPA_PTK, PTKCALCNEGOTIATING)
 		 * state machine data based on whatever PSK was selected here.
 		 */
 		os_memcpy(sm->PMK, pmk, PMK_LEN);
+		wpa_auth_psk_selected(sm->wpa_auth, sm->addr,
+				      sm->p2p_dev_addr, pmk);
 	}
 
 	sm->MICVerified = TRUE;
 
-	os_memcpy(&sm->PTK, &PTK, sizeof(PTK));
+	os_memcpy(&sm->PTK, ptk, sizeof(*ptk));
 	sm->PTK_valid = TRUE;
 }
 
 
+/*
+ * Try the PSKs following sm->psk_trial_prev against the received msg 2/4.
+ * With many PSKs for any station, checking all of them at once would block
+ * the event loop for tens of milliseconds, so at most wpa_psk_trial_batch
+ * candidates are tried per call and the rest from a zero timeout. The state
+ * machine stays in PTKCALCNEGOTIATING until a PSK matches. The previous
+ * candidate is only compared against the PSK list, so a list that changed in
+ * between ends the search instead of following a freed entry. Returns 0 if a
+ * PSK matched, 1 if the trials continue later, or -1 if none matched.
+ */
+static int wpa_psk_trial(struct wpa_state_machine *sm)
+{
+	struct wpa_ptk PTK;
+	const u8 *pmk = sm->psk_trial_prev;
+	unsigned int i;
+
+	for (i = 0; i < wpa_psk_trial_batch; i++) {
+		pmk = wpa_auth_get_psk(sm->wpa_auth, sm->addr,
+				       sm->p2p_dev_addr, pmk);
+		if (pmk == NULL) {
+			wpa_ptk_calc_failed(sm, i > 0 || sm->psk_trial_prev);
+			sm->psk_trial_prev = NULL;
+			return -1;
+		}
+
+		if (wpa_derive_ptk_verify(sm, sm->SNonce, pmk,
+					  sm->last_rx_eapol_key,
+					  sm->last_rx_eapol_key_len,
+					  &PTK) == 0) {
+			sm->psk_trial_prev = NULL;
+			wpa_ptk_calc_done(sm, pmk, &PTK);
+			return 0;
+		}
+	}
+
+	sm->psk_trial_prev = pmk;
+	eloop_register_timeout(0, 0, wpa_psk_trial_continue, sm->wpa_auth, sm);
+	return 1;
+}
+
+
+static void wpa_psk_trial_continue(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_state_machine *sm = timeout_ctx;
+
+	if (sm->wpa_ptk_state != WPA_PTK_PTKCALCNEGOTIATING) {
+		sm->psk_trial_prev = NULL;
+		return;
+	}
+	if (wpa_psk_trial(sm) == 0)
+		wpa_sm_step(sm);
+}
+
+
+SM_STATE(WPA_PTK, PTKCALCNEGOTIATING)
+{
+	struct wpa_ptk PTK;
+
+	SM_ENTRY_MA(WPA_PTK, PTKCALCNEGOTIATING, wpa_ptk);
+	sm->EAPOLKeyReceived = FALSE;
+	sm->update_snonce = FALSE;
+
+	/* WPA with IEEE 802.1X: use the derived PMK from EAP
+	 * WPA-PSK: iterate through possible PSKs and select the one matching
+	 * the packet */
+	if (wpa_key_mgmt_wpa_psk(sm->wpa_key_mgmt)) {
+		/* A new msg 2/4 restarts the trials */
+		eloop_cancel_timeout(wpa_psk_trial_continue, sm->wpa_auth, sm);
+		sm->psk_trial_prev = NULL;
+		wpa_psk_trial(sm);
+		return;
+	}
+
+	if (wpa_derive_ptk_verify(sm, sm->SNonce, sm->PMK,
+				  sm->last_rx_eapol_key,
+				  sm->last_rx_eapol_key_len, &PTK) < 0) {
+		wpa_ptk_calc_failed(sm, 0);
+		return;
+	}
+	wpa_ptk_calc_done(sm, sm->PMK, &PTK);
+}
+
+
 SM_STATE(WPA_PTK, PTKCALCNEGOTIATING2)
 {
 	SM_ENTRY_MA(WPA_PTK, PTKCALCNEGOTIATING2, wpa_ptk);
@@ -256,6 +256,16 @@ static const u8 * hostapd_wpa_auth_get_psk(void *ctx, const u8 *addr,
 }
 
 
+static void hostapd_wpa_auth_psk_selected(void *ctx, const u8 *addr,
+					  const u8 *p2p_dev_addr,
+					  const u8 *psk)
+{
+	struct hostapd_data *hapd = ctx;
+
+	hostapd_wpa_psk_selected(hapd->conf, addr, p2p_dev_addr, psk);
+}
+
+
 static int hostapd_wpa_auth_get_msk(void *ctx, const u8 *addr, u8 *msk,
 				    size_t *len)
 {
@@ -599,6 +609,7 @@ int hostapd_setup_wpa(struct hostapd_data *hapd)
 	cb.set_eapol = hostapd_wpa_auth_set_eapol;
 	cb.get_eapol = hostapd_wpa_auth_get_eapol;
 	cb.get_psk = hostapd_wpa_auth_get_psk;
+	cb.psk_selected = hostapd_wpa_auth_psk_selected;
 	cb.get_msk = hostapd_wpa_auth_get_msk;
 	cb.set_key = hostapd_wpa_auth_set_key;
 	cb.get_seqnum = hostapd_wpa_auth_get_seqnum;
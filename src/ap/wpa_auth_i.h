@@ -78,6 +78,9 @@ struct wpa_state_machine {
 
 	u8 *last_rx_eapol_key; /* starting from IEEE 802.1X header */
 	size_t last_rx_eapol_key_len;
+	/* last PSK tried against msg 2/4 before the trials were continued
+	 * from the event loop */
+	const u8 *psk_trial_prev;
 
 	unsigned int changed:1;
 	unsigned int in_step_loop:1;
@@ -366,9 +366,9 @@ static int hapd_wps_reconfig_in_memory(struct hostapd_data *hapd,
 			if (bss->ssid.wpa_passphrase)
 				os_memcpy(bss->ssid.wpa_passphrase, cred->key,
 					  cred->key_len);
-			hostapd_config_clear_wpa_psk(&bss->ssid.wpa_psk);
+			hostapd_config_clear_wpa_psk(&bss->ssid);
 		} else if (cred->key_len == 64) {
-			hostapd_config_clear_wpa_psk(&bss->ssid.wpa_psk);
+			hostapd_config_clear_wpa_psk(&bss->ssid);
 			bss->ssid.wpa_psk =
 				os_zalloc(sizeof(struct hostapd_wpa_psk));
 			if (bss->ssid.wpa_psk &&
@@ -0,0 +1,158 @@
+/*
+ * Control interface command dispatch tables and statistics
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+
+#include "common.h"
+#include "ctrl_cmd.h"
+
+
+static const char * ctrl_cmd_name(const void *table, size_t size, size_t idx)
+{
+	return *(const char *const *) ((const u8 *) table + idx * size);
+}
+
+
+static size_t ctrl_cmd_name_len(const char *cmd)
+{
+	const char *pos = os_strchr(cmd, ' ');
+
+	return pos ? (size_t) (pos - cmd) : os_strlen(cmd);
+}
+
+
+const void * ctrl_cmd_find(const void *table, size_t num, size_t size,
+			   char *cmd, char **params)
+{
+	size_t len, lo = 0, hi = num, mid;
+	const char *name;
+	int cmp;
+
+	len = ctrl_cmd_name_len(cmd);
+	*params = cmd[len] == ' ' ? &cmd[len + 1] : NULL;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		name = ctrl_cmd_name(table, size, mid);
+		cmp = os_strncmp(name, cmd, len);
+		if (cmp == 0 && name[len] != '\0')
+			cmp = 1;
+		if (cmp == 0)
+			return (const u8 *) table + mid * size;
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+
+int ctrl_cmd_table_check(const void *table, size_t num, size_t size)
+{
+	size_t i;
+	int ret = 0;
+
+	for (i = 1; i < num; i++) {
+		if (os_strcmp(ctrl_cmd_name(table, size, i - 1),
+			      ctrl_cmd_name(table, size, i)) < 0)
+			continue;
+		wpa_printf(MSG_ERROR, "CTRL: Command %s is not sorted after %s",
+			   ctrl_cmd_name(table, size, i),
+			   ctrl_cmd_name(table, size, i - 1));
+		ret = -1;
+	}
+
+	return ret;
+}
+
+
+void ctrl_cmd_stats_update(struct ctrl_cmd_stats *stats,
+			   struct os_reltime *start, int failed)
+{
+	struct os_reltime now, diff;
+	unsigned int usec, limit = 10;
+	int i;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	usec = diff.sec * 1000000 + diff.usec;
+
+	/* Buckets: <10 us, <100 us, <1 ms, <10 ms, <100 ms, longer */
+	for (i = 0; i < CTRL_CMD_LATENCY_BUCKETS - 1; i++) {
+		if (usec < limit)
+			break;
+		limit *= 10;
+	}
+	stats->latency[i]++;
+	stats->count++;
+	if (failed)
+		stats->failures++;
+	stats->total_latency_us += usec;
+	if (usec > stats->max_latency_us)
+		stats->max_latency_us = usec;
+}
+
+
+struct ctrl_cmd_stats * ctrl_cmd_named_stats_get(
+	struct ctrl_cmd_named_stats *entries, size_t num, const char *cmd)
+{
+	size_t i, len;
+
+	len = ctrl_cmd_name_len(cmd);
+	if (len == 0 || len >= CTRL_CMD_NAME_LEN)
+		return NULL;
+
+	/* Entries are taken into use in order, so stop at the first free one */
+	for (i = 0; i < num && entries[i].name[0]; i++) {
+		if (os_strncmp(entries[i].name, cmd, len) == 0 &&
+		    entries[i].name[len] == '\0')
+			return &entries[i].stats;
+	}
+	if (i == num)
+		return NULL;
+
+	os_memcpy(entries[i].name, cmd, len);
+	entries[i].name[len] = '\0';
+	return &entries[i].stats;
+}
+
+
+int ctrl_cmd_stats_print(const char *name, const struct ctrl_cmd_stats *stats,
+			 char *buf, size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	int ret, i;
+
+	if (stats->count == 0)
+		return 0;
+
+	ret = os_snprintf(pos, end - pos,
+			  "%s count=%lu failures=%lu avg_latency_us=%u "
+			  "max_latency_us=%u latency=",
+			  name, stats->count, stats->failures,
+			  (unsigned int) (stats->total_latency_us /
+					  stats->count),
+			  stats->max_latency_us);
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+	for (i = 0; i < CTRL_CMD_LATENCY_BUCKETS; i++) {
+		ret = os_snprintf(pos, end - pos, "%s%lu", i ? "," : "",
+				  stats->latency[i]);
+		if (os_snprintf_error(end - pos, ret))
+			return -1;
+		pos += ret;
+	}
+	ret = os_snprintf(pos, end - pos, "\n");
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	return pos - buf;
+}
@@ -0,0 +1,121 @@
+/*
+ * Control interface command dispatch tables and statistics
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef CTRL_CMD_H
+#define CTRL_CMD_H
+
+/* Command is accepted without parameters */
+#define CTRL_CMD_BARE BIT(0)
+/* Command is accepted with parameters after a space */
+#define CTRL_CMD_PARAMS BIT(1)
+/* Handler returns 0 or -1 and the reply is "OK" or "FAIL" */
+#define CTRL_CMD_STATUS BIT(2)
+
+#define CTRL_CMD_LATENCY_BUCKETS 6
+#define CTRL_CMD_NAME_LEN 32
+
+/**
+ * struct ctrl_cmd_stats - Per-command control interface statistics
+ * @count: Number of times the command was processed
+ * @failures: Number of times the command was replied to with FAIL
+ * @total_latency_us: Sum of processing times in microseconds
+ * @max_latency_us: Longest processing time in microseconds
+ * @latency: Processing time histogram; <10 us, <100 us, <1 ms, <10 ms,
+ *	<100 ms, longer
+ */
+struct ctrl_cmd_stats {
+	unsigned long count;
+	unsigned long failures;
+	u64 total_latency_us;
+	unsigned int max_latency_us;
+	unsigned long latency[CTRL_CMD_LATENCY_BUCKETS];
+};
+
+/**
+ * struct ctrl_cmd_named_stats - Statistics for a command outside a table
+ * @name: Command name, empty for an unused entry
+ * @stats: Statistics for the command
+ */
+struct ctrl_cmd_named_stats {
+	char name[CTRL_CMD_NAME_LEN];
+	struct ctrl_cmd_stats stats;
+};
+
+/**
+ * ctrl_cmd_table_check - Check that a command table is sorted
+ * @table: Array of command entries; the first member of each entry must be
+ *	the command name (const char *)
+ * @num: Number of entries in the table
+ * @size: Size of one entry
+ * Returns: 0 if the names are in strictly ascending strcmp() order, -1 if not
+ *
+ * Tables are kept sorted by name in the source so that ctrl_cmd_find() can
+ * use them as is. Entries that are out of order or duplicated are reported
+ * as errors.
+ */
+int ctrl_cmd_table_check(const void *table, size_t num, size_t size);
+
+/**
+ * ctrl_cmd_find - Find a command from a sorted command table
+ * @table: Array of command entries sorted by name
+ * @num: Number of entries in the table
+ * @size: Size of one entry
+ * @cmd: Received command
+ * @params: Buffer for returning a pointer to the parameters following the
+ *	command name and a space or %NULL if there are no parameters
+ * Returns: Pointer to the matching entry or %NULL if not found
+ *
+ * The command name is the part of @cmd before the first space and it has to
+ * match the name in the table exactly.
+ */
+const void * ctrl_cmd_find(const void *table, size_t num, size_t size,
+			   char *cmd, char **params);
+
+/**
+ * ctrl_cmd_accepts - Check command parameters against table entry flags
+ * @flags: CTRL_CMD_* flags from the table entry
+ * @params: Parameters returned by ctrl_cmd_find()
+ * Returns: 1 if the entry accepts the command, 0 if not
+ */
+static inline int ctrl_cmd_accepts(unsigned int flags, const char *params)
+{
+	return (flags & (params ? CTRL_CMD_PARAMS : CTRL_CMD_BARE)) != 0;
+}
+
+/**
+ * ctrl_cmd_stats_update - Account a processed command
+ * @stats: Statistics for the command
+ * @start: Time when processing of the command started
+ * @failed: Whether the reply was FAIL
+ */
+void ctrl_cmd_stats_update(struct ctrl_cmd_stats *stats,
+			   struct os_reltime *start, int failed);
+
+/**
+ * ctrl_cmd_named_stats_get - Get statistics entry for a command by name
+ * @entries: Array of named statistics entries
+ * @num: Number of entries in the array
+ * @cmd: Received command; the name is the part before the first space
+ * Returns: Statistics entry for the command or %NULL if the name is too long
+ *	or all entries are in use by other commands
+ */
+struct ctrl_cmd_stats * ctrl_cmd_named_stats_get(
+	struct ctrl_cmd_named_stats *entries, size_t num, const char *cmd);
+
+/**
+ * ctrl_cmd_stats_print - Write command statistics as a text line
+ * @name: Command name
+ * @stats: Statistics for the command
+ * @buf: Buffer for the text
+ * @buflen: Size of the buffer
+ * Returns: Number of characters written, 0 if the command has not been
+ *	used, or -1 if the buffer is too small
+ */
+int ctrl_cmd_stats_print(const char *name, const struct ctrl_cmd_stats *stats,
+			 char *buf, size_t buflen);
+
+#endif /* CTRL_CMD_H */
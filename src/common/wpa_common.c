@@ -115,6 +115,29 @@ int wpa_eapol_key_mic(const u8 *key, size_t key_len, int akmp, int ver,
 }
 
 
+static void wpa_ptk_data(u8 *data, const u8 *addr1, const u8 *addr2,
+			 const u8 *nonce1, const u8 *nonce2)
+{
+	if (os_memcmp(addr1, addr2, ETH_ALEN) < 0) {
+		os_memcpy(data, addr1, ETH_ALEN);
+		os_memcpy(data + ETH_ALEN, addr2, ETH_ALEN);
+	} else {
+		os_memcpy(data, addr2, ETH_ALEN);
+		os_memcpy(data + ETH_ALEN, addr1, ETH_ALEN);
+	}
+
+	if (os_memcmp(nonce1, nonce2, WPA_NONCE_LEN) < 0) {
+		os_memcpy(data + 2 * ETH_ALEN, nonce1, WPA_NONCE_LEN);
+		os_memcpy(data + 2 * ETH_ALEN + WPA_NONCE_LEN, nonce2,
+			  WPA_NONCE_LEN);
+	} else {
+		os_memcpy(data + 2 * ETH_ALEN, nonce2, WPA_NONCE_LEN);
+		os_memcpy(data + 2 * ETH_ALEN + WPA_NONCE_LEN, nonce1,
+			  WPA_NONCE_LEN);
+	}
+}
+
+
 /**
  * wpa_pmk_to_ptk - Calculate PTK from PMK, addresses, and nonces
  * @pmk: Pairwise master key
@@ -147,23 +170,7 @@ int wpa_pmk_to_ptk(const u8 *pmk, size_t pmk_len, const char *label,
 	u8 tmp[WPA_KCK_MAX_LEN + WPA_KEK_MAX_LEN + WPA_TK_MAX_LEN];
 	size_t ptk_len;
 
-	if (os_memcmp(addr1, addr2, ETH_ALEN) < 0) {
-		os_memcpy(data, addr1, ETH_ALEN);
-		os_memcpy(data + ETH_ALEN, addr2, ETH_ALEN);
-	} else {
-		os_memcpy(data, addr2, ETH_ALEN);
-		os_memcpy(data + ETH_ALEN, addr1, ETH_ALEN);
-	}
-
-	if (os_memcmp(nonce1, nonce2, WPA_NONCE_LEN) < 0) {
-		os_memcpy(data + 2 * ETH_ALEN, nonce1, WPA_NONCE_LEN);
-		os_memcpy(data + 2 * ETH_ALEN + WPA_NONCE_LEN, nonce2,
-			  WPA_NONCE_LEN);
-	} else {
-		os_memcpy(data + 2 * ETH_ALEN, nonce2, WPA_NONCE_LEN);
-		os_memcpy(data + 2 * ETH_ALEN + WPA_NONCE_LEN, nonce1,
-			  WPA_NONCE_LEN);
-	}
+	wpa_ptk_data(data, addr1, addr2, nonce1, nonce2);
 
 	ptk->kck_len = wpa_kck_len(akmp);
 	ptk->kek_len = wpa_kek_len(akmp);
@@ -205,6 +212,47 @@ int wpa_pmk_to_ptk(const u8 *pmk, size_t pmk_len, const char *label,
 }
 
 
+/**
+ * wpa_pmk_to_kck - Calculate only the KCK part of the PTK
+ * @pmk: Pairwise master key
+ * @pmk_len: Length of PMK
+ * @label: Label to use in derivation
+ * @addr1: AA or SA
+ * @addr2: SA or AA
+ * @nonce1: ANonce or SNonce
+ * @nonce2: SNonce or ANonce
+ * @ptk: Buffer for pairwise transient key; only the KCK is set
+ * @akmp: Negotiated AKM
+ * Returns: 0 on success, -1 if the KCK cannot be derived separately for the
+ *	AKM
+ *
+ * The SHA-1 based PRF produces the PTK as a key stream, so the KCK can be
+ * derived alone to check the MIC of an EAPOL-Key frame with several PMK
+ * candidates before the full PTK is derived with the matching one.
+ */
+int wpa_pmk_to_kck(const u8 *pmk, size_t pmk_len, const char *label,
+		   const u8 *addr1, const u8 *addr2,
+		   const u8 *nonce1, const u8 *nonce2,
+		   struct wpa_ptk *ptk, int akmp)
+{
+	u8 data[2 * ETH_ALEN + 2 * WPA_NONCE_LEN];
+
+	/*
+	 * The SHA-256 and SHA-384 based KDFs take the full PTK length as an
+	 * input, so the KCK cannot be derived separately with them.
+	 */
+	if (wpa_key_mgmt_sha256(akmp) || wpa_key_mgmt_sha384(akmp))
+		return -1;
+
+	wpa_ptk_data(data, addr1, addr2, nonce1, nonce2);
+	os_memset(ptk, 0, sizeof(*ptk));
+	ptk->kck_len = wpa_kck_len(akmp);
+	sha1_prf(pmk, pmk_len, label, data, sizeof(data), ptk->kck,
+		 ptk->kck_len);
+	return 0;
+}
+
+
 #ifdef CONFIG_IEEE80211R
 int wpa_ft_mic(const u8 *kck, size_t kck_len, const u8 *sta_addr,
 	       const u8 *ap_addr, u8 transaction_seqnum,
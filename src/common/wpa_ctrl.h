@@ -244,6 +244,49 @@ extern "C" {
 #define AP_STA_TAXONOMY "AP-STA-TAXONOMY "
 #endif /* CONFIG_CLIENT_TAXONOMY */
 
+/*
+ * hostapd control interface - binary events
+ *
+ * A monitor that has sent "BINARY_EVENTS 1" after ATTACH receives the events
+ * below as binary datagrams instead of their AP-STA-TAXONOMY,
+ * AP-STA-STEERING and AP-STA-NO-STEERING text form. All multi-octet fields
+ * are little endian:
+ *
+ * u8 magic (BIN_EVENT_MAGIC; text events always start with '<')
+ * u8 version (BIN_EVENT_VERSION)
+ * u16 event type (enum bin_event_type)
+ * u16 length of the attributes that follow
+ * attributes: u16 type (enum bin_event_attr), u16 length, value
+ *
+ * Consumers must skip unknown event types and attributes.
+ */
+#define BIN_EVENT_MAGIC 0x00
+#define BIN_EVENT_VERSION 1
+#define BIN_EVENT_HDR_LEN 6
+
+enum bin_event_type {
+	BIN_EVENT_STA_TAXONOMY = 1,
+	BIN_EVENT_STA_STEERING = 2,
+	BIN_EVENT_STA_NO_STEERING = 3,
+};
+
+enum bin_event_attr {
+	BIN_ATTR_ADDR = 1, /* 6 octets */
+	BIN_ATTR_SIGNAL = 2, /* s32, dBm */
+	BIN_ATTR_REASON = 3, /* u8, enum bin_event_no_steer_reason */
+	BIN_ATTR_TAXONOMY_PROBE = 4, /* string, not nul terminated */
+	BIN_ATTR_TAXONOMY_ASSOC = 5, /* string, not nul terminated */
+};
+
+enum bin_event_no_steer_reason {
+	BIN_NO_STEER_TARGET_INTERFACE = 1,
+	BIN_NO_STEER_REASSOC = 2,
+	BIN_NO_STEER_NEW_STATION = 3,
+	BIN_NO_STEER_DEFERRED = 4,
+	BIN_NO_STEER_NON_CANDIDATE = 5,
+	BIN_NO_STEER_WEAK_SIGNAL = 6,
+};
+
 #define AP_REJECTED_MAX_STA "AP-REJECTED-MAX-STA "
 #define AP_REJECTED_BLOCKED_STA "AP-REJECTED-BLOCKED-STA "
 
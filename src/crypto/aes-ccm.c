@@ -89,28 +89,37 @@ static void aes_ccm_encr_start(size_t L, const u8 *nonce, u8 *a)
 }
 
 
+#define AES_CCM_BLOCKS 8
+
 static void aes_ccm_encr(void *aes, size_t L, const u8 *in, size_t len, u8 *out,
 			 u8 *a)
 {
-	size_t last = len % AES_BLOCK_SIZE;
-	size_t i;
+	u8 ctr[AES_CCM_BLOCKS * AES_BLOCK_SIZE];
+	u8 tmp[AES_CCM_BLOCKS * AES_BLOCK_SIZE];
+	size_t i, n, blen;
+	u16 counter = 1;
 
 	/* crypt = msg XOR (S_1 | S_2 | ... | S_n) */
-	for (i = 1; i <= len / AES_BLOCK_SIZE; i++) {
-		WPA_PUT_BE16(&a[AES_BLOCK_SIZE - 2], i);
-		/* S_i = E(K, A_i) */
-		aes_encrypt(aes, a, out);
-		xor_aes_block(out, in);
-		out += AES_BLOCK_SIZE;
-		in += AES_BLOCK_SIZE;
-	}
-	if (last) {
-		WPA_PUT_BE16(&a[AES_BLOCK_SIZE - 2], i);
-		aes_encrypt(aes, a, out);
+	while (len > 0) {
+		n = (len + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+		if (n > AES_CCM_BLOCKS)
+			n = AES_CCM_BLOCKS;
+		for (i = 0; i < n; i++) {
+			WPA_PUT_BE16(&a[AES_BLOCK_SIZE - 2], counter++);
+			os_memcpy(&ctr[i * AES_BLOCK_SIZE], a, AES_BLOCK_SIZE);
+		}
+		/* S_i = E(K, A_i) for a batch of counter blocks */
+		aes_encrypt_blocks(aes, ctr, tmp, n);
+
 		/* XOR zero-padded last block */
-		for (i = 0; i < last; i++)
-			*out++ ^= *in++;
+		blen = len < n * AES_BLOCK_SIZE ? len : n * AES_BLOCK_SIZE;
+		for (i = 0; i < blen; i++)
+			out[i] = in[i] ^ tmp[i];
+		in += blen;
+		out += blen;
+		len -= blen;
 	}
+	os_memset(tmp, 0, sizeof(tmp));
 }
 
 
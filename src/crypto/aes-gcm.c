@@ -12,6 +12,7 @@
 #include "common.h"
 #include "aes.h"
 #include "aes_wrap.h"
+#include "crypto_cpu.h"
 
 static void inc32(u8 *block)
 {
@@ -100,12 +101,120 @@ static void ghash_start(u8 *y)
 }
 
 
+#ifdef CRYPTO_CPU_X86
+
+#define GHASH_CLMUL_TARGET CRYPTO_CPU_TARGET("pclmul,sse4.1,ssse3")
+
+/* Multiplication in GF(2^128) of bit-reflected operands with the carry-less
+ * multiplication instruction */
+static GHASH_CLMUL_TARGET __m128i gf_mult_clmul(__m128i a, __m128i b)
+{
+	__m128i lo, mid, hi, t1, t2, t3;
+
+	/* 256-bit product hi:lo */
+	lo = _mm_clmulepi64_si128(a, b, 0x00);
+	mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+			    _mm_clmulepi64_si128(a, b, 0x01));
+	hi = _mm_clmulepi64_si128(a, b, 0x11);
+	lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+	hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+	/* Shift the product left by one bit to account for the reflection */
+	t1 = _mm_srli_epi32(lo, 31);
+	t2 = _mm_srli_epi32(hi, 31);
+	lo = _mm_slli_epi32(lo, 1);
+	hi = _mm_slli_epi32(hi, 1);
+	t3 = _mm_srli_si128(t1, 12);
+	t2 = _mm_slli_si128(t2, 4);
+	t1 = _mm_slli_si128(t1, 4);
+	lo = _mm_or_si128(lo, t1);
+	hi = _mm_or_si128(hi, t2);
+	hi = _mm_or_si128(hi, t3);
+
+	/* Reduce modulo x^128 + x^7 + x^2 + x + 1 */
+	t1 = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31),
+					 _mm_slli_epi32(lo, 30)),
+			   _mm_slli_epi32(lo, 25));
+	t2 = _mm_srli_si128(t1, 4);
+	t1 = _mm_slli_si128(t1, 12);
+	lo = _mm_xor_si128(lo, t1);
+	t3 = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1),
+					 _mm_srli_epi32(lo, 2)),
+			   _mm_srli_epi32(lo, 7));
+	t3 = _mm_xor_si128(t3, t2);
+	lo = _mm_xor_si128(lo, t3);
+	return _mm_xor_si128(hi, lo);
+}
+
+
+static GHASH_CLMUL_TARGET void ghash_clmul(const u8 *h, const u8 *x,
+					   size_t xlen, u8 *y)
+{
+	const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+					  11, 12, 13, 14, 15);
+	__m128i hv, yv;
+	u8 tmp[16];
+
+	hv = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) h), mask);
+	yv = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) y), mask);
+
+	for (; xlen >= 16; x += 16, xlen -= 16) {
+		yv = _mm_xor_si128(yv, _mm_shuffle_epi8(
+					   _mm_loadu_si128((const __m128i *) x),
+					   mask));
+		yv = gf_mult_clmul(yv, hv);
+	}
+
+	if (xlen) {
+		/* Add zero padded last block */
+		os_memcpy(tmp, x, xlen);
+		os_memset(tmp + xlen, 0, sizeof(tmp) - xlen);
+		yv = _mm_xor_si128(yv, _mm_shuffle_epi8(
+					   _mm_loadu_si128((const __m128i *) tmp),
+					   mask));
+		yv = gf_mult_clmul(yv, hv);
+	}
+
+	_mm_storeu_si128((__m128i *) y, _mm_shuffle_epi8(yv, mask));
+}
+
+
+static int ghash_cpu = -1;
+
+static int ghash_use_clmul(void)
+{
+	if (ghash_cpu < 0)
+		ghash_cpu = !!(crypto_cpu_features() & CRYPTO_CPU_CLMUL);
+	return ghash_cpu;
+}
+
+#endif /* CRYPTO_CPU_X86 */
+
+
+int aes_gcm_use_cpu(int enabled)
+{
+#ifdef CRYPTO_CPU_X86
+	ghash_cpu = enabled ? -1 : 0;
+	return ghash_use_clmul();
+#else /* CRYPTO_CPU_X86 */
+	return 0;
+#endif /* CRYPTO_CPU_X86 */
+}
+
+
 static void ghash(const u8 *h, const u8 *x, size_t xlen, u8 *y)
 {
 	size_t m, i;
 	const u8 *xpos = x;
 	u8 tmp[16];
 
+#ifdef CRYPTO_CPU_X86
+	if (ghash_use_clmul()) {
+		ghash_clmul(h, x, xlen, y);
+		return;
+	}
+#endif /* CRYPTO_CPU_X86 */
+
 	m = xlen / 16;
 
 	for (i = 0; i < m; i++) {
@@ -140,35 +249,39 @@ static void ghash(const u8 *h, const u8 *x, size_t xlen, u8 *y)
 }
 
 
+#define AES_GCTR_BLOCKS 8
+
 static void aes_gctr(void *aes, const u8 *icb, const u8 *x, size_t xlen, u8 *y)
 {
-	size_t i, n, last;
-	u8 cb[AES_BLOCK_SIZE], tmp[AES_BLOCK_SIZE];
-	const u8 *xpos = x;
-	u8 *ypos = y;
+	size_t i, n, len;
+	u8 cb[AES_BLOCK_SIZE];
+	u8 ctr[AES_GCTR_BLOCKS * AES_BLOCK_SIZE];
+	u8 tmp[AES_GCTR_BLOCKS * AES_BLOCK_SIZE];
 
 	if (xlen == 0)
 		return;
 
-	n = xlen / 16;
-
 	os_memcpy(cb, icb, AES_BLOCK_SIZE);
-	/* Full blocks */
-	for (i = 0; i < n; i++) {
-		aes_encrypt(aes, cb, ypos);
-		xor_block(ypos, xpos);
-		xpos += AES_BLOCK_SIZE;
-		ypos += AES_BLOCK_SIZE;
-		inc32(cb);
-	}
-
-	last = x + xlen - xpos;
-	if (last) {
-		/* Last, partial block */
-		aes_encrypt(aes, cb, tmp);
-		for (i = 0; i < last; i++)
-			*ypos++ = *xpos++ ^ tmp[i];
+	while (xlen > 0) {
+		/* Encrypt a batch of counter blocks with one call */
+		n = (xlen + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+		if (n > AES_GCTR_BLOCKS)
+			n = AES_GCTR_BLOCKS;
+		for (i = 0; i < n; i++) {
+			os_memcpy(&ctr[i * AES_BLOCK_SIZE], cb, AES_BLOCK_SIZE);
+			inc32(cb);
+		}
+		aes_encrypt_blocks(aes, ctr, tmp, n);
+
+		/* The last block may be partial */
+		len = xlen < n * AES_BLOCK_SIZE ? xlen : n * AES_BLOCK_SIZE;
+		for (i = 0; i < len; i++)
+			y[i] = x[i] ^ tmp[i];
+		x += len;
+		y += len;
+		xlen -= len;
 	}
+	os_memset(tmp, 0, sizeof(tmp));
 }
 
 
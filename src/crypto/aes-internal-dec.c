@@ -63,6 +63,15 @@ void * aes_decrypt_init(const u8 *key, size_t len)
 	rk = os_malloc(AES_PRIV_SIZE);
 	if (rk == NULL)
 		return NULL;
+	rk[AES_PRIV_NI_POS] = 0;
+#ifdef CRYPTO_CPU_X86
+	if (aes_ni_available()) {
+		res = aes_ni_key_setup_enc(rk, key, len * 8);
+		if (res > 0)
+			aes_ni_key_setup_dec(rk, res);
+		rk[AES_PRIV_NI_POS] = 1;
+	} else
+#endif /* CRYPTO_CPU_X86 */
 	res = rijndaelKeySetupDec(rk, key, len * 8);
 	if (res < 0) {
 		os_free(rk);
@@ -147,9 +156,35 @@ d##3 = TD0(s##3) ^ TD1(s##2) ^ TD2(s##1) ^ TD3(s##0) ^ rk[4 * i + 3]
 	PUTU32(pt + 12, s3);
 }
 
+#ifdef CRYPTO_CPU_X86
+
+static AES_NI_TARGET void aes_ni_decrypt(const u32 rk[], int Nr,
+					 const u8 *in, u8 *out)
+{
+	const __m128i *k = (const __m128i *) rk;
+	__m128i b;
+	int r;
+
+	b = _mm_xor_si128(_mm_loadu_si128((const __m128i *) in),
+			  _mm_loadu_si128(k));
+	for (r = 1; r < Nr; r++)
+		b = _mm_aesdec_si128(b, _mm_loadu_si128(k + r));
+	b = _mm_aesdeclast_si128(b, _mm_loadu_si128(k + Nr));
+	_mm_storeu_si128((__m128i *) out, b);
+}
+
+#endif /* CRYPTO_CPU_X86 */
+
+
 void aes_decrypt(void *ctx, const u8 *crypt, u8 *plain)
 {
 	u32 *rk = ctx;
+#ifdef CRYPTO_CPU_X86
+	if (rk[AES_PRIV_NI_POS]) {
+		aes_ni_decrypt(rk, rk[AES_PRIV_NR_POS], crypt, plain);
+		return;
+	}
+#endif /* CRYPTO_CPU_X86 */
 	rijndaelDecrypt(ctx, rk[AES_PRIV_NR_POS], crypt, plain);
 }
 
@@ -95,6 +95,45 @@ d##3 = TE0(s##3) ^ TE1(s##0) ^ TE2(s##1) ^ TE3(s##2) ^ rk[4 * i + 3]
 }
 
 
+#ifdef CRYPTO_CPU_X86
+
+#define AES_NI_BLOCKS 8
+
+static AES_NI_TARGET void aes_ni_encrypt(const u32 rk[], int Nr,
+					 const u8 *in, u8 *out, size_t num)
+{
+	const __m128i *k = (const __m128i *) rk;
+	__m128i b[AES_NI_BLOCKS], key;
+	size_t i, n;
+	int r;
+
+	/* Independent blocks are interleaved to hide the latency of the
+	 * round instruction */
+	while (num > 0) {
+		n = num > AES_NI_BLOCKS ? AES_NI_BLOCKS : num;
+		key = _mm_loadu_si128(k);
+		for (i = 0; i < n; i++)
+			b[i] = _mm_xor_si128(_mm_loadu_si128(
+						     (const __m128i *) in + i),
+					     key);
+		for (r = 1; r < Nr; r++) {
+			key = _mm_loadu_si128(k + r);
+			for (i = 0; i < n; i++)
+				b[i] = _mm_aesenc_si128(b[i], key);
+		}
+		key = _mm_loadu_si128(k + Nr);
+		for (i = 0; i < n; i++)
+			_mm_storeu_si128((__m128i *) out + i,
+					 _mm_aesenclast_si128(b[i], key));
+		in += n * AES_BLOCK_SIZE;
+		out += n * AES_BLOCK_SIZE;
+		num -= n;
+	}
+}
+
+#endif /* CRYPTO_CPU_X86 */
+
+
 void * aes_encrypt_init(const u8 *key, size_t len)
 {
 	u32 *rk;
@@ -102,6 +141,13 @@ void * aes_encrypt_init(const u8 *key, size_t len)
 	rk = os_malloc(AES_PRIV_SIZE);
 	if (rk == NULL)
 		return NULL;
+	rk[AES_PRIV_NI_POS] = 0;
+#ifdef CRYPTO_CPU_X86
+	if (aes_ni_available()) {
+		res = aes_ni_key_setup_enc(rk, key, len * 8);
+		rk[AES_PRIV_NI_POS] = 1;
+	} else
+#endif /* CRYPTO_CPU_X86 */
 	res = rijndaelKeySetupEnc(rk, key, len * 8);
 	if (res < 0) {
 		os_free(rk);
@@ -115,10 +161,33 @@ void * aes_encrypt_init(const u8 *key, size_t len)
 void aes_encrypt(void *ctx, const u8 *plain, u8 *crypt)
 {
 	u32 *rk = ctx;
+#ifdef CRYPTO_CPU_X86
+	if (rk[AES_PRIV_NI_POS]) {
+		aes_ni_encrypt(rk, rk[AES_PRIV_NR_POS], plain, crypt, 1);
+		return;
+	}
+#endif /* CRYPTO_CPU_X86 */
 	rijndaelEncrypt(ctx, rk[AES_PRIV_NR_POS], plain, crypt);
 }
 
 
+void aes_encrypt_blocks(void *ctx, const u8 *plain, u8 *crypt, size_t num)
+{
+	u32 *rk = ctx;
+#ifdef CRYPTO_CPU_X86
+	if (rk[AES_PRIV_NI_POS]) {
+		aes_ni_encrypt(rk, rk[AES_PRIV_NR_POS], plain, crypt, num);
+		return;
+	}
+#endif /* CRYPTO_CPU_X86 */
+	while (num--) {
+		rijndaelEncrypt(ctx, rk[AES_PRIV_NR_POS], plain, crypt);
+		plain += AES_BLOCK_SIZE;
+		crypt += AES_BLOCK_SIZE;
+	}
+}
+
+
 void aes_encrypt_deinit(void *ctx)
 {
 	os_memset(ctx, 0, AES_PRIV_SIZE);
@@ -843,3 +843,134 @@ int rijndaelKeySetupEnc(u32 rk[], const u8 cipherKey[], int keyBits)
 
 	return -1;
 }
+
+
+#ifdef CRYPTO_CPU_X86
+
+static int aes_ni = -1;
+
+int aes_ni_available(void)
+{
+	if (aes_ni < 0)
+		aes_ni = !!(crypto_cpu_features() & CRYPTO_CPU_AES);
+	return aes_ni;
+}
+
+
+static AES_NI_TARGET __m128i aes_ni_expand(__m128i key, __m128i assist)
+{
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, assist);
+}
+
+#define AES_NI_KEY_128(i, rcon)						\
+	k[i] = aes_ni_expand(k[i - 1], _mm_shuffle_epi32(		\
+		_mm_aeskeygenassist_si128(k[i - 1], rcon), 0xff))
+
+#define AES_NI_KEY_256(i, rcon)						\
+do {									\
+	k[i] = aes_ni_expand(k[i - 2], _mm_shuffle_epi32(		\
+		_mm_aeskeygenassist_si128(k[i - 1], rcon), 0xff));	\
+	if (i < 14)							\
+		k[i + 1] = aes_ni_expand(k[i - 1], _mm_shuffle_epi32(	\
+			_mm_aeskeygenassist_si128(k[i], 0), 0xaa));	\
+} while (0)
+
+/**
+ * Expand the cipher key into the encryption key schedule for the AES
+ * instructions. The round keys are stored as octet strings in rk[].
+ *
+ * @return	the number of rounds for the given cipher key size.
+ */
+AES_NI_TARGET int aes_ni_key_setup_enc(u32 rk[], const u8 cipherKey[],
+				       int keyBits)
+{
+	__m128i k[15];
+	int i, Nr;
+
+	switch (keyBits) {
+	case 128:
+		k[0] = _mm_loadu_si128((const __m128i *) cipherKey);
+		AES_NI_KEY_128(1, 0x01);
+		AES_NI_KEY_128(2, 0x02);
+		AES_NI_KEY_128(3, 0x04);
+		AES_NI_KEY_128(4, 0x08);
+		AES_NI_KEY_128(5, 0x10);
+		AES_NI_KEY_128(6, 0x20);
+		AES_NI_KEY_128(7, 0x40);
+		AES_NI_KEY_128(8, 0x80);
+		AES_NI_KEY_128(9, 0x1b);
+		AES_NI_KEY_128(10, 0x36);
+		Nr = 10;
+		break;
+	case 256:
+		k[0] = _mm_loadu_si128((const __m128i *) cipherKey);
+		k[1] = _mm_loadu_si128((const __m128i *) (cipherKey + 16));
+		AES_NI_KEY_256(2, 0x01);
+		AES_NI_KEY_256(4, 0x02);
+		AES_NI_KEY_256(6, 0x04);
+		AES_NI_KEY_256(8, 0x08);
+		AES_NI_KEY_256(10, 0x10);
+		AES_NI_KEY_256(12, 0x20);
+		AES_NI_KEY_256(14, 0x40);
+		Nr = 14;
+		break;
+	default:
+		/* The 192-bit schedule does not map to whole round keys per
+		 * step; convert the result of the portable key expansion */
+		Nr = rijndaelKeySetupEnc(rk, cipherKey, keyBits);
+		if (Nr < 0)
+			return Nr;
+		for (i = 0; i < 4 * (Nr + 1); i++) {
+			u32 val = rk[i];
+
+			PUTU32((u8 *) &rk[i], val);
+		}
+		return Nr;
+	}
+
+	for (i = 0; i <= Nr; i++)
+		_mm_storeu_si128((__m128i *) &rk[4 * i], k[i]);
+	os_memset(k, 0, sizeof(k));
+	return Nr;
+}
+
+
+/* Convert an encryption key schedule into the equivalent inverse cipher
+ * schedule used with the AESDEC instruction */
+AES_NI_TARGET void aes_ni_key_setup_dec(u32 rk[], int Nr)
+{
+	__m128i *k = (__m128i *) rk;
+	__m128i a, b;
+	int i, j;
+
+	/* invert the order of the round keys and apply the inverse MixColumn
+	 * transform to all round keys but the first and the last: */
+	for (i = 0, j = Nr; i < j; i++, j--) {
+		a = _mm_loadu_si128(k + i);
+		b = _mm_loadu_si128(k + j);
+		if (i > 0) {
+			a = _mm_aesimc_si128(a);
+			b = _mm_aesimc_si128(b);
+		}
+		_mm_storeu_si128(k + i, b);
+		_mm_storeu_si128(k + j, a);
+	}
+	if (i == j)
+		_mm_storeu_si128(k + i, _mm_aesimc_si128(_mm_loadu_si128(k + i)));
+}
+
+#endif /* CRYPTO_CPU_X86 */
+
+
+int aes_use_cpu(int enabled)
+{
+#ifdef CRYPTO_CPU_X86
+	aes_ni = enabled ? -1 : 0;
+	return aes_ni_available();
+#else /* CRYPTO_CPU_X86 */
+	return 0;
+#endif /* CRYPTO_CPU_X86 */
+}
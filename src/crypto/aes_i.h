@@ -10,6 +10,7 @@
 #define AES_I_H
 
 #include "aes.h"
+#include "crypto_cpu.h"
 
 /* #define FULL_UNROLL */
 #define AES_SMALL_TABLES
@@ -117,9 +118,23 @@ static inline u32 rotr(u32 val, int bits)
 (ct)[2] = (u8)((st) >>  8); (ct)[3] = (u8)(st); }
 #endif
 
-#define AES_PRIV_SIZE (4 * 4 * 15 + 4)
+#define AES_PRIV_SIZE (4 * 4 * 15 + 4 * 2)
 #define AES_PRIV_NR_POS (4 * 15)
+/* Nonzero if the round keys are in the byte order of the AES instructions */
+#define AES_PRIV_NI_POS (4 * 15 + 1)
 
 int rijndaelKeySetupEnc(u32 rk[], const u8 cipherKey[], int keyBits);
 
+#ifdef CRYPTO_CPU_X86
+#define AES_NI_TARGET CRYPTO_CPU_TARGET("aes,sse4.1,ssse3")
+
+int aes_ni_available(void);
+int aes_ni_key_setup_enc(u32 rk[], const u8 cipherKey[], int keyBits);
+void aes_ni_key_setup_dec(u32 rk[], int Nr);
+#endif /* CRYPTO_CPU_X86 */
+
+/* Allow or prevent the use of CPU AES instructions for new keys (for
+ * testing); returns whether they are used */
+int aes_use_cpu(int enabled);
+
 #endif /* AES_I_H */
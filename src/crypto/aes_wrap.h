@@ -3,7 +3,7 @@
  *
  * - AES Key Wrap Algorithm (RFC3394)
  * - One-Key CBC MAC (OMAC1) hash with AES-128 and AES-256
- * - AES-128 CTR mode encryption
+ * - AES CTR mode encryption
  * - AES-128 EAX mode encryption/decryption
  * - AES-128 CBC
  * - AES-GCM
@@ -33,6 +33,8 @@ int __must_check omac1_aes_128(const u8 *key, const u8 *data, size_t data_len,
 int __must_check omac1_aes_256(const u8 *key, const u8 *data, size_t data_len,
 			       u8 *mac);
 int __must_check aes_128_encrypt_block(const u8 *key, const u8 *in, u8 *out);
+int __must_check aes_ctr_encrypt(const u8 *key, size_t key_len,
+				 const u8 *nonce, u8 *data, size_t data_len);
 int __must_check aes_128_ctr_encrypt(const u8 *key, const u8 *nonce,
 				     u8 *data, size_t data_len);
 int __must_check aes_128_eax_encrypt(const u8 *key,
@@ -60,6 +62,9 @@ int __must_check aes_gcm_ad(const u8 *key, size_t key_len,
 int __must_check aes_gmac(const u8 *key, size_t key_len,
 			  const u8 *iv, size_t iv_len,
 			  const u8 *aad, size_t aad_len, u8 *tag);
+/* Allow or prevent the use of CPU instructions for GHASH (for testing);
+ * returns whether they are used */
+int aes_gcm_use_cpu(int enabled);
 int __must_check aes_ccm_ae(const u8 *key, size_t key_len, const u8 *nonce,
 			    size_t M, const u8 *plain, size_t plain_len,
 			    const u8 *aad, size_t aad_len, u8 *crypt, u8 *auth);
@@ -0,0 +1,59 @@
+/*
+ * Runtime detection of CPU instructions for the internal crypto functions
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef CRYPTO_CPU_H
+#define CRYPTO_CPU_H
+
+/*
+ * CRYPTO_CPU_X86 is defined when the compiler can generate the x86 SHA and
+ * AES instructions for functions marked with CRYPTO_CPU_TARGET() without
+ * them being enabled for the whole build. Whether the CPU supports them is
+ * checked at run time. Define CONFIG_NO_CRYPTO_CPU to use only the portable
+ * C implementations.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+	(defined(__clang__) || __GNUC__ >= 5) && \
+	!defined(CONFIG_NO_CRYPTO_CPU)
+
+#define CRYPTO_CPU_X86
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define CRYPTO_CPU_TARGET(isa) __attribute__((target(isa)))
+
+#define CRYPTO_CPU_SHA BIT(0)
+#define CRYPTO_CPU_AES BIT(1)
+#define CRYPTO_CPU_CLMUL BIT(2)
+
+static inline unsigned int crypto_cpu_features(void)
+{
+	unsigned int eax, ebx, ecx, edx, features = 0;
+
+	/* SSSE3 byte shuffles and SSE4.1 lane operations are used together
+	 * with the SHA, AES, and carry-less multiplication instructions */
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+	    !(ecx & BIT(9)) || !(ecx & BIT(19)))
+		return 0;
+
+	if (ecx & BIT(25))
+		features |= CRYPTO_CPU_AES;
+	if (ecx & BIT(1))
+		features |= CRYPTO_CPU_CLMUL;
+
+	if (__get_cpuid_max(0, NULL) >= 7) {
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		if (ebx & BIT(29))
+			features |= CRYPTO_CPU_SHA;
+	}
+
+	return features;
+}
+
+#endif /* x86 */
+
+#endif /* CRYPTO_CPU_H */
@@ -114,6 +114,13 @@ void aes_encrypt(void *ctx, const u8 *plain, u8 *crypt)
 }
 
 
+void aes_encrypt_blocks(void *ctx, const u8 *plain, u8 *crypt, size_t num)
+{
+	gcry_cipher_hd_t hd = ctx;
+	gcry_cipher_encrypt(hd, crypt, num * 16, plain, num * 16);
+}
+
+
 void aes_encrypt_deinit(void *ctx)
 {
 	gcry_cipher_hd_t hd = ctx;
@@ -103,6 +103,17 @@ void aes_encrypt(void *ctx, const u8 *plain, u8 *crypt)
 }
 
 
+void aes_encrypt_blocks(void *ctx, const u8 *plain, u8 *crypt, size_t num)
+{
+	symmetric_key *skey = ctx;
+	while (num--) {
+		aes_ecb_encrypt(plain, crypt, skey);
+		plain += 16;
+		crypt += 16;
+	}
+}
+
+
 void aes_encrypt_deinit(void *ctx)
 {
 	symmetric_key *skey = ctx;
@@ -234,6 +234,17 @@ void aes_encrypt(void *ctx, const u8 *plain, u8 *crypt)
 }
 
 
+void aes_encrypt_blocks(void *ctx, const u8 *plain, u8 *crypt, size_t num)
+{
+	EVP_CIPHER_CTX *c = ctx;
+	int clen = num * 16;
+	if (EVP_EncryptUpdate(c, crypt, &clen, plain, num * 16) != 1) {
+		wpa_printf(MSG_ERROR, "OpenSSL: EVP_EncryptUpdate failed: %s",
+			   ERR_error_string(ERR_get_error(), NULL));
+	}
+}
+
+
 void aes_encrypt_deinit(void *ctx)
 {
 	EVP_CIPHER_CTX *c = ctx;
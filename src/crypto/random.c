@@ -26,6 +26,9 @@
 #ifdef __linux__
 #include <fcntl.h>
 #endif /* __linux__ */
+#ifdef CONFIG_SAE_THREADS
+#include <pthread.h>
+#endif /* CONFIG_SAE_THREADS */
 
 #include "utils/common.h"
 #include "utils/eloop.h"
@@ -60,6 +63,11 @@ static int random_entropy_file_read = 0;
 static unsigned int entropy = 0;
 static unsigned int total_collected = 0;
 
+#ifdef CONFIG_SAE_THREADS
+/* SAE worker threads get random numbers concurrently with the event loop */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* CONFIG_SAE_THREADS */
+
 
 static void random_write_entropy(void);
 
@@ -123,7 +131,7 @@ static void random_extract(u8 *out)
 }
 
 
-void random_add_randomness(const void *buf, size_t len)
+static void random_add_randomness_locked(const void *buf, size_t len)
 {
 	struct os_time t;
 	static unsigned int count = 0;
@@ -151,7 +159,7 @@ void random_add_randomness(const void *buf, size_t len)
 }
 
 
-int random_get_bytes(void *buf, size_t len)
+static int random_get_bytes_locked(void *buf, size_t len)
 {
 	int ret;
 	u8 *bytes = buf;
@@ -211,6 +219,33 @@ int random_get_bytes(void *buf, size_t len)
 }
 
 
+void random_add_randomness(const void *buf, size_t len)
+{
+#ifdef CONFIG_SAE_THREADS
+	pthread_mutex_lock(&pool_lock);
+#endif /* CONFIG_SAE_THREADS */
+	random_add_randomness_locked(buf, len);
+#ifdef CONFIG_SAE_THREADS
+	pthread_mutex_unlock(&pool_lock);
+#endif /* CONFIG_SAE_THREADS */
+}
+
+
+int random_get_bytes(void *buf, size_t len)
+{
+	int ret;
+
+#ifdef CONFIG_SAE_THREADS
+	pthread_mutex_lock(&pool_lock);
+#endif /* CONFIG_SAE_THREADS */
+	ret = random_get_bytes_locked(buf, len);
+#ifdef CONFIG_SAE_THREADS
+	pthread_mutex_unlock(&pool_lock);
+#endif /* CONFIG_SAE_THREADS */
+	return ret;
+}
+
+
 int random_pool_ready(void)
 {
 #ifdef __linux__
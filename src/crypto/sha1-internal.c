@@ -13,10 +13,13 @@
 #include "sha1_i.h"
 #include "md5.h"
 #include "crypto.h"
+#include "crypto_cpu.h"
 
 typedef struct SHA1Context SHA1_CTX;
 
-void SHA1Transform(u32 state[5], const unsigned char buffer[64]);
+static void SHA1TransformC(u32 state[5], const unsigned char buffer[64]);
+static void sha1_blocks(u32 state[5], const unsigned char *data,
+			size_t blocks);
 
 
 #ifdef CONFIG_CRYPTO_INTERNAL
@@ -170,7 +173,7 @@ void SHAPrintContext(SHA1_CTX *context, char *msg)
 
 /* Hash a single 512-bit block. This is the core of the algorithm. */
 
-void SHA1Transform(u32 state[5], const unsigned char buffer[64])
+static void SHA1TransformC(u32 state[5], const unsigned char buffer[64])
 {
 	u32 a, b, c, d, e;
 	typedef union {
@@ -257,8 +260,9 @@ void SHA1Update(SHA1_CTX* context, const void *_data, u32 len)
 	if ((j + len) > 63) {
 		os_memcpy(&context->buffer[j], data, (i = 64-j));
 		SHA1Transform(context->state, context->buffer);
-		for ( ; i + 63 < len; i += 64) {
-			SHA1Transform(context->state, &data[i]);
+		if (i + 63 < len) {
+			sha1_blocks(context->state, &data[i], (len - i) / 64);
+			i += (len - i) & ~63;
 		}
 		j = 0;
 	}
@@ -302,3 +306,204 @@ void SHA1Final(unsigned char digest[20], SHA1_CTX* context)
 }
 
 /* ===== end - public domain SHA1 implementation ===== */
+
+
+#ifdef CRYPTO_CPU_X86
+
+#define SHA1_NI_TARGET CRYPTO_CPU_TARGET("sha,sse4.1,ssse3")
+
+/*
+ * Four rounds of lane l with the SHA instructions. h is the index of the
+ * four-round group (0..19); m_h is the message schedule register holding
+ * words 4h..4h+3 and m_h1..m_h3 are the next ones in rotating order. The
+ * schedule for the following groups is computed while the rounds run.
+ */
+#define SHA1_NI_ROUNDS(h, l, e_cur, e_oth, m_h, m_h1, m_h2, m_h3)	\
+do {									\
+	if ((h) == 0)							\
+		e_cur[l] = _mm_add_epi32(e_cur[l], m_h[l]);		\
+	else								\
+		e_cur[l] = _mm_sha1nexte_epu32(e_cur[l], m_h[l]);	\
+	e_oth[l] = abcd[l];						\
+	if ((h) >= 3 && (h) <= 18)					\
+		m_h1[l] = _mm_sha1msg2_epu32(m_h1[l], m_h[l]);		\
+	abcd[l] = _mm_sha1rnds4_epu32(abcd[l], e_cur[l], (h) / 5);	\
+	if ((h) >= 1 && (h) <= 16)					\
+		m_h3[l] = _mm_sha1msg1_epu32(m_h3[l], m_h[l]);		\
+	if ((h) >= 2 && (h) <= 17)					\
+		m_h2[l] = _mm_xor_si128(m_h2[l], m_h[l]);		\
+} while (0)
+
+/* Interleave the lanes so that the round instructions of one lane execute
+ * while the other lane waits for the results of its previous rounds */
+#define SHA1_NI_GROUP(h, e_cur, e_oth, m_h, m_h1, m_h2, m_h3)		\
+do {									\
+	SHA1_NI_ROUNDS(h, 0, e_cur, e_oth, m_h, m_h1, m_h2, m_h3);	\
+	if (lanes > 1)							\
+		SHA1_NI_ROUNDS(h, 1, e_cur, e_oth, m_h, m_h1, m_h2, m_h3); \
+} while (0)
+
+static inline __attribute__((always_inline)) SHA1_NI_TARGET
+void sha1_ni_lane_load(const u32 *state, __m128i *abcd, __m128i *e)
+{
+	*abcd = _mm_loadu_si128((const __m128i *) state);
+	*abcd = _mm_shuffle_epi32(*abcd, 0x1B);
+	*e = _mm_set_epi32(state[4], 0, 0, 0);
+}
+
+
+static inline __attribute__((always_inline)) SHA1_NI_TARGET
+void sha1_ni_lane_store(u32 *state, __m128i abcd, __m128i e)
+{
+	abcd = _mm_shuffle_epi32(abcd, 0x1B);
+	_mm_storeu_si128((__m128i *) state, abcd);
+	state[4] = _mm_extract_epi32(e, 3);
+}
+
+
+static inline __attribute__((always_inline)) SHA1_NI_TARGET
+void sha1_ni_lane_msg(const unsigned char *data, __m128i mask, __m128i *m0,
+		      __m128i *m1, __m128i *m2, __m128i *m3)
+{
+	const __m128i *in = (const __m128i *) data;
+
+	*m0 = _mm_shuffle_epi8(_mm_loadu_si128(in), mask);
+	*m1 = _mm_shuffle_epi8(_mm_loadu_si128(in + 1), mask);
+	*m2 = _mm_shuffle_epi8(_mm_loadu_si128(in + 2), mask);
+	*m3 = _mm_shuffle_epi8(_mm_loadu_si128(in + 3), mask);
+}
+
+
+/* Process the same number of blocks for one or two independent states */
+static inline __attribute__((always_inline)) SHA1_NI_TARGET
+void sha1_ni_transform(u32 *state[], const unsigned char *data[],
+		       size_t blocks, const int lanes)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+					    0x08090a0b0c0d0e0fULL);
+	__m128i abcd[2], e0[2], e1[2], m0[2], m1[2], m2[2], m3[2];
+	__m128i abcd_save[2], e_save[2];
+	const unsigned char *pos[2];
+	int l;
+
+	for (l = 0; l < lanes; l++) {
+		sha1_ni_lane_load(state[l], &abcd[l], &e0[l]);
+		pos[l] = data[l];
+	}
+
+	while (blocks--) {
+		for (l = 0; l < lanes; l++) {
+			abcd_save[l] = abcd[l];
+			e_save[l] = e0[l];
+			sha1_ni_lane_msg(pos[l], mask, &m0[l], &m1[l], &m2[l],
+					 &m3[l]);
+			pos[l] += 64;
+		}
+
+		SHA1_NI_GROUP(0, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_GROUP(1, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_GROUP(2, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_GROUP(3, e1, e0, m3, m0, m1, m2);
+		SHA1_NI_GROUP(4, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_GROUP(5, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_GROUP(6, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_GROUP(7, e1, e0, m3, m0, m1, m2);
+		SHA1_NI_GROUP(8, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_GROUP(9, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_GROUP(10, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_GROUP(11, e1, e0, m3, m0, m1, m2);
+		SHA1_NI_GROUP(12, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_GROUP(13, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_GROUP(14, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_GROUP(15, e1, e0, m3, m0, m1, m2);
+		SHA1_NI_GROUP(16, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_GROUP(17, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_GROUP(18, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_GROUP(19, e1, e0, m3, m0, m1, m2);
+
+		for (l = 0; l < lanes; l++) {
+			e0[l] = _mm_sha1nexte_epu32(e0[l], e_save[l]);
+			abcd[l] = _mm_add_epi32(abcd[l], abcd_save[l]);
+		}
+	}
+
+	for (l = 0; l < lanes; l++)
+		sha1_ni_lane_store(state[l], abcd[l], e0[l]);
+}
+
+
+static SHA1_NI_TARGET void sha1_ni_x1(u32 state[5], const unsigned char *data,
+				      size_t blocks)
+{
+	sha1_ni_transform(&state, &data, blocks, 1);
+}
+
+
+static SHA1_NI_TARGET void sha1_ni_x2(u32 *state[2],
+				      const unsigned char *data[2])
+{
+	sha1_ni_transform(state, data, 1, 2);
+}
+
+
+static int sha1_ni = -1;
+
+static int sha1_use_ni(void)
+{
+	if (sha1_ni < 0)
+		sha1_ni = !!(crypto_cpu_features() & CRYPTO_CPU_SHA);
+	return sha1_ni;
+}
+
+#endif /* CRYPTO_CPU_X86 */
+
+
+static void sha1_blocks(u32 state[5], const unsigned char *data,
+			size_t blocks)
+{
+#ifdef CRYPTO_CPU_X86
+	if (sha1_use_ni()) {
+		sha1_ni_x1(state, data, blocks);
+		return;
+	}
+#endif /* CRYPTO_CPU_X86 */
+
+	while (blocks--) {
+		SHA1TransformC(state, data);
+		data += 64;
+	}
+}
+
+
+void SHA1Transform(u32 state[5], const unsigned char buffer[64])
+{
+	sha1_blocks(state, buffer, 1);
+}
+
+
+void SHA1TransformMulti(u32 *state[], const unsigned char *buffer[],
+			size_t num)
+{
+	size_t i = 0;
+
+#ifdef CRYPTO_CPU_X86
+	if (sha1_use_ni()) {
+		for (; i + 1 < num; i += 2)
+			sha1_ni_x2(&state[i], &buffer[i]);
+	}
+#endif /* CRYPTO_CPU_X86 */
+
+	for (; i < num; i++)
+		sha1_blocks(state[i], buffer[i], 1);
+}
+
+
+int SHA1UseCPU(int enabled)
+{
+#ifdef CRYPTO_CPU_X86
+	sha1_ni = enabled ? -1 : 0;
+	return sha1_use_ni();
+#else /* CRYPTO_CPU_X86 */
+	return 0;
+#endif /* CRYPTO_CPU_X86 */
+}
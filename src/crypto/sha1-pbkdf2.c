@@ -10,6 +10,176 @@
 
 #include "common.h"
 #include "sha1.h"
+#include "sha1_i.h"
+#include "crypto.h"
+
+#ifdef CONFIG_CRYPTO_INTERNAL
+
+/*
+ * With the internal SHA-1 implementation, the HMAC key is hashed into inner
+ * and outer states once and each following iteration takes only two calls
+ * to the compression function. The output blocks are independent of each
+ * other, so they are computed in lockstep with the multi-buffer transform.
+ */
+
+#define PBKDF2_SHA1_LANES 2
+
+struct pbkdf2_sha1_lane {
+	u32 state[5];
+	u32 digest[5];
+	u8 block[64];
+};
+
+
+static void pbkdf2_sha1_pad(const u8 *key, size_t key_len, u8 val,
+			    u32 *state)
+{
+	struct SHA1Context ctx;
+	u8 pad[64];
+	size_t i;
+
+	os_memset(pad, val, sizeof(pad));
+	for (i = 0; i < key_len; i++)
+		pad[i] ^= key[i];
+	SHA1Init(&ctx);
+	SHA1Transform(ctx.state, pad);
+	os_memcpy(state, ctx.state, 20);
+	os_memset(pad, 0, sizeof(pad));
+	os_memset(&ctx, 0, sizeof(ctx));
+}
+
+
+/* Continue a hash from a precomputed state after one block of HMAC pad */
+static void pbkdf2_sha1_hash(const u32 *state, size_t num_elem,
+			     const u8 *addr[], const size_t *len, u8 *mac)
+{
+	struct SHA1Context ctx;
+	size_t i;
+
+	os_memcpy(ctx.state, state, 20);
+	ctx.count[0] = 64 * 8;
+	ctx.count[1] = 0;
+	for (i = 0; i < num_elem; i++)
+		SHA1Update(&ctx, addr[i], len[i]);
+	SHA1Final(mac, &ctx);
+}
+
+
+static void pbkdf2_sha1_put(u8 *block, const u32 *state)
+{
+	int i;
+
+	for (i = 0; i < 5; i++)
+		WPA_PUT_BE32(block + 4 * i, state[i]);
+}
+
+
+static void pbkdf2_sha1_lanes(const u32 *istate, const u32 *ostate,
+			      const u8 *ssid, size_t ssid_len, int iterations,
+			      unsigned int count, struct pbkdf2_sha1_lane *lane,
+			      size_t num)
+{
+	u32 *states[PBKDF2_SHA1_LANES];
+	const unsigned char *blocks[PBKDF2_SHA1_LANES];
+	u8 count_buf[4], u[SHA1_MAC_LEN];
+	const u8 *addr[2];
+	size_t len[2];
+	size_t l;
+	int i, j;
+
+	for (l = 0; l < num; l++) {
+		/* U1 = PRF(P, S || i) */
+		WPA_PUT_BE32(count_buf, count + l);
+		addr[0] = ssid;
+		len[0] = ssid_len;
+		addr[1] = count_buf;
+		len[1] = 4;
+		pbkdf2_sha1_hash(istate, 2, addr, len, u);
+		addr[0] = u;
+		len[0] = SHA1_MAC_LEN;
+		pbkdf2_sha1_hash(ostate, 1, addr, len, u);
+
+		/* Single block padding for a 20 octet message after the
+		 * HMAC pad block */
+		os_memcpy(lane[l].block, u, SHA1_MAC_LEN);
+		lane[l].block[SHA1_MAC_LEN] = 0x80;
+		os_memset(lane[l].block + SHA1_MAC_LEN + 1, 0,
+			  64 - SHA1_MAC_LEN - 1 - 8);
+		WPA_PUT_BE64(lane[l].block + 56, (64 + SHA1_MAC_LEN) * 8);
+		for (j = 0; j < 5; j++)
+			lane[l].digest[j] = WPA_GET_BE32(u + 4 * j);
+
+		states[l] = lane[l].state;
+		blocks[l] = lane[l].block;
+	}
+
+	for (i = 1; i < iterations; i++) {
+		for (l = 0; l < num; l++)
+			os_memcpy(lane[l].state, istate, 20);
+		SHA1TransformMulti(states, blocks, num);
+		for (l = 0; l < num; l++) {
+			pbkdf2_sha1_put(lane[l].block, lane[l].state);
+			os_memcpy(lane[l].state, ostate, 20);
+		}
+		SHA1TransformMulti(states, blocks, num);
+		for (l = 0; l < num; l++) {
+			pbkdf2_sha1_put(lane[l].block, lane[l].state);
+			for (j = 0; j < 5; j++)
+				lane[l].digest[j] ^= lane[l].state[j];
+		}
+	}
+
+	os_memset(u, 0, sizeof(u));
+}
+
+
+static int pbkdf2_sha1_internal(const char *passphrase, const u8 *ssid,
+				size_t ssid_len, int iterations, u8 *buf,
+				size_t buflen)
+{
+	struct pbkdf2_sha1_lane lane[PBKDF2_SHA1_LANES];
+	u8 key[SHA1_MAC_LEN], digest[SHA1_MAC_LEN];
+	const u8 *pw = (const u8 *) passphrase;
+	size_t pw_len = os_strlen(passphrase);
+	u32 istate[5], ostate[5];
+	unsigned int count = 1;
+	size_t num, l, plen;
+
+	/* HMAC keys longer than the block size are hashed first */
+	if (pw_len > 64) {
+		if (sha1_vector(1, &pw, &pw_len, key))
+			return -1;
+		pw = key;
+		pw_len = SHA1_MAC_LEN;
+	}
+	pbkdf2_sha1_pad(pw, pw_len, 0x36, istate);
+	pbkdf2_sha1_pad(pw, pw_len, 0x5c, ostate);
+
+	while (buflen > 0) {
+		num = (buflen + SHA1_MAC_LEN - 1) / SHA1_MAC_LEN;
+		if (num > PBKDF2_SHA1_LANES)
+			num = PBKDF2_SHA1_LANES;
+		pbkdf2_sha1_lanes(istate, ostate, ssid, ssid_len, iterations,
+				  count, lane, num);
+		count += num;
+		for (l = 0; l < num; l++) {
+			pbkdf2_sha1_put(digest, lane[l].digest);
+			plen = buflen > SHA1_MAC_LEN ? SHA1_MAC_LEN : buflen;
+			os_memcpy(buf, digest, plen);
+			buf += plen;
+			buflen -= plen;
+		}
+	}
+
+	os_memset(key, 0, sizeof(key));
+	os_memset(digest, 0, sizeof(digest));
+	os_memset(istate, 0, sizeof(istate));
+	os_memset(ostate, 0, sizeof(ostate));
+	os_memset(lane, 0, sizeof(lane));
+	return 0;
+}
+
+#else /* CONFIG_CRYPTO_INTERNAL */
 
 static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 			 size_t ssid_len, int iterations, unsigned int count,
@@ -54,6 +224,8 @@ static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 	return 0;
 }
 
+#endif /* CONFIG_CRYPTO_INTERNAL */
+
 
 /**
  * pbkdf2_sha1 - SHA1-based key derivation function (PBKDF2) for IEEE 802.11i
@@ -72,6 +244,10 @@ static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 int pbkdf2_sha1(const char *passphrase, const u8 *ssid, size_t ssid_len,
 		int iterations, u8 *buf, size_t buflen)
 {
+#ifdef CONFIG_CRYPTO_INTERNAL
+	return pbkdf2_sha1_internal(passphrase, ssid, ssid_len, iterations,
+				    buf, buflen);
+#else /* CONFIG_CRYPTO_INTERNAL */
 	unsigned int count = 0;
 	unsigned char *pos = buf;
 	size_t left = buflen, plen;
@@ -89,4 +265,5 @@ int pbkdf2_sha1(const char *passphrase, const u8 *ssid, size_t ssid_len,
 	}
 
 	return 0;
+#endif /* CONFIG_CRYPTO_INTERNAL */
 }
@@ -19,5 +19,11 @@ void SHA1Init(struct SHA1Context *context);
 void SHA1Update(struct SHA1Context *context, const void *data, u32 len);
 void SHA1Final(unsigned char digest[20], struct SHA1Context *context);
 void SHA1Transform(u32 state[5], const unsigned char buffer[64]);
+/* Process one block for each of num independent states in lockstep */
+void SHA1TransformMulti(u32 *state[], const unsigned char *buffer[],
+			size_t num);
+/* Allow or prevent the use of CPU SHA instructions (for testing); returns
+ * whether they are used */
+int SHA1UseCPU(int enabled);
 
 #endif /* SHA1_I_H */
@@ -12,7 +12,9 @@
 #include "sha256.h"
 #include "sha256_i.h"
 #include "crypto.h"
+#include "crypto_cpu.h"
 
+static int sha256_compress(struct sha256_state *md, unsigned char *buf);
 
 /**
  * sha256_vector - SHA256 hash for data vector
@@ -44,7 +46,7 @@ int sha256_vector(size_t num_elem, const u8 *addr[], const size_t *len,
  * public domain by Tom St Denis. */
 
 /* the K array */
-static const unsigned long K[64] = {
+static const u32 K[64] = {
 	0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL,
 	0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL, 0xd807aa98UL, 0x12835b01UL,
 	0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL,
@@ -78,7 +80,7 @@ static const unsigned long K[64] = {
 #endif
 
 /* compress 512-bits */
-static int sha256_compress(struct sha256_state *md, unsigned char *buf)
+static int sha256_compress_c(struct sha256_state *md, unsigned char *buf)
 {
 	u32 S[8], W[64], t0, t1;
 	u32 t;
@@ -224,3 +226,117 @@ int sha256_done(struct sha256_state *md, unsigned char *out)
 }
 
 /* ===== end - public domain SHA256 implementation ===== */
+
+
+#ifdef CRYPTO_CPU_X86
+
+#define SHA256_NI_TARGET CRYPTO_CPU_TARGET("sha,sse4.1,ssse3")
+
+/*
+ * Eight rounds with the SHA instructions. h is the index of the eight-round
+ * group (0..15); m_h is the message schedule register holding words
+ * 4h..4h+3, m_h1 the next one and m_hp the previous one. The schedule for the
+ * following groups is computed while the rounds run.
+ */
+#define SHA256_NI_ROUNDS(h, m_h, m_h1, m_hp)				\
+do {									\
+	msg = _mm_add_epi32(m_h,					\
+			    _mm_loadu_si128((const __m128i *) &K[4 * (h)])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg);		\
+	if ((h) >= 3 && (h) <= 14) {					\
+		tmp = _mm_alignr_epi8(m_h, m_hp, 4);			\
+		m_h1 = _mm_add_epi32(m_h1, tmp);			\
+		m_h1 = _mm_sha256msg2_epu32(m_h1, m_h);			\
+	}								\
+	msg = _mm_shuffle_epi32(msg, 0x0E);				\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg);		\
+	if ((h) >= 1 && (h) <= 12)					\
+		m_hp = _mm_sha256msg1_epu32(m_hp, m_h);			\
+} while (0)
+
+static SHA256_NI_TARGET void sha256_ni_compress(u32 state[8],
+						const unsigned char *buf)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					    0x0405060700010203ULL);
+	const __m128i *in = (const __m128i *) buf;
+	__m128i state0, state1, save0, save1, msg, tmp, m0, m1, m2, m3;
+
+	/* The rounds instruction operates on ABEF and CDGH */
+	tmp = _mm_loadu_si128((const __m128i *) &state[0]);
+	state1 = _mm_loadu_si128((const __m128i *) &state[4]);
+	tmp = _mm_shuffle_epi32(tmp, 0xB1);
+	state1 = _mm_shuffle_epi32(state1, 0x1B);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+	save0 = state0;
+	save1 = state1;
+
+	m0 = _mm_shuffle_epi8(_mm_loadu_si128(in), mask);
+	m1 = _mm_shuffle_epi8(_mm_loadu_si128(in + 1), mask);
+	m2 = _mm_shuffle_epi8(_mm_loadu_si128(in + 2), mask);
+	m3 = _mm_shuffle_epi8(_mm_loadu_si128(in + 3), mask);
+
+	SHA256_NI_ROUNDS(0, m0, m1, m3);
+	SHA256_NI_ROUNDS(1, m1, m2, m0);
+	SHA256_NI_ROUNDS(2, m2, m3, m1);
+	SHA256_NI_ROUNDS(3, m3, m0, m2);
+	SHA256_NI_ROUNDS(4, m0, m1, m3);
+	SHA256_NI_ROUNDS(5, m1, m2, m0);
+	SHA256_NI_ROUNDS(6, m2, m3, m1);
+	SHA256_NI_ROUNDS(7, m3, m0, m2);
+	SHA256_NI_ROUNDS(8, m0, m1, m3);
+	SHA256_NI_ROUNDS(9, m1, m2, m0);
+	SHA256_NI_ROUNDS(10, m2, m3, m1);
+	SHA256_NI_ROUNDS(11, m3, m0, m2);
+	SHA256_NI_ROUNDS(12, m0, m1, m3);
+	SHA256_NI_ROUNDS(13, m1, m2, m0);
+	SHA256_NI_ROUNDS(14, m2, m3, m1);
+	SHA256_NI_ROUNDS(15, m3, m0, m2);
+
+	state0 = _mm_add_epi32(state0, save0);
+	state1 = _mm_add_epi32(state1, save1);
+
+	tmp = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	_mm_storeu_si128((__m128i *) &state[0], state0);
+	_mm_storeu_si128((__m128i *) &state[4], state1);
+}
+
+
+static int sha256_ni = -1;
+
+static int sha256_use_ni(void)
+{
+	if (sha256_ni < 0)
+		sha256_ni = !!(crypto_cpu_features() & CRYPTO_CPU_SHA);
+	return sha256_ni;
+}
+
+#endif /* CRYPTO_CPU_X86 */
+
+
+static int sha256_compress(struct sha256_state *md, unsigned char *buf)
+{
+#ifdef CRYPTO_CPU_X86
+	if (sha256_use_ni()) {
+		sha256_ni_compress(md->state, buf);
+		return 0;
+	}
+#endif /* CRYPTO_CPU_X86 */
+
+	return sha256_compress_c(md, buf);
+}
+
+
+int sha256_use_cpu(int enabled)
+{
+#ifdef CRYPTO_CPU_X86
+	sha256_ni = enabled ? -1 : 0;
+	return sha256_use_ni();
+#else /* CRYPTO_CPU_X86 */
+	return 0;
+#endif /* CRYPTO_CPU_X86 */
+}
@@ -21,5 +21,8 @@ void sha256_init(struct sha256_state *md);
 int sha256_process(struct sha256_state *md, const unsigned char *in,
 		   unsigned long inlen);
 int sha256_done(struct sha256_state *md, unsigned char *out);
+/* Allow or prevent the use of CPU SHA instructions (for testing); returns
+ * whether they are used */
+int sha256_use_cpu(int enabled);
 
 #endif /* SHA256_I_H */
@@ -2232,6 +2232,23 @@ struct wpa_driver_ops {
 	int (*read_sta_data)(void *priv, struct hostap_sta_driver_data *data,
 			     const u8 *addr);
 
+	/**
+	 * read_all_sta_data - Fetch data for all stations
+	 * @priv: Private driver interface data
+	 * @cb: Callback function to call for each station
+	 * @ctx: Context data for cb
+	 * Returns: 0 on success, -1 on failure
+	 *
+	 * This optional function returns the same information as
+	 * read_sta_data() for every station of the interface with a single
+	 * request to the driver. The data pointer is only valid during the
+	 * callback.
+	 */
+	int (*read_all_sta_data)(void *priv,
+				 void (*cb)(void *ctx, const u8 *addr,
+					    struct hostap_sta_driver_data *data),
+				 void *ctx);
+
 	/**
 	 * hapd_send_eapol - Send an EAPOL packet (AP only)
 	 * @priv: private driver interface data
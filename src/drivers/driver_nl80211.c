@@ -150,6 +150,8 @@ static void nl80211_register_eloop_read(struct nl_handle **handle,
 	nl_socket_set_nonblocking(*handle);
 	eloop_register_read_sock(nl_socket_get_fd(*handle), handler,
 				 eloop_data, *handle);
+	/* Process bursts of events without going back to epoll_wait() */
+	eloop_set_read_sock_budget(nl_socket_get_fd(*handle), 16);
 	*handle = (void *) (((intptr_t) *handle) ^ ELOOP_SOCKET_INVALID);
 }
 
@@ -5237,11 +5239,9 @@ static int i802_flush(void *priv)
 }
 
 
-static int get_sta_handler(struct nl_msg *msg, void *arg)
+static int nl80211_parse_sta_info(struct nlattr **tb,
+				  struct hostap_sta_driver_data *data)
 {
-	struct nlattr *tb[NL80211_ATTR_MAX + 1];
-	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
-	struct hostap_sta_driver_data *data = arg;
 	struct nlattr *stats[NL80211_STA_INFO_MAX + 1];
 	static struct nla_policy stats_policy[NL80211_STA_INFO_MAX + 1] = {
 		[NL80211_STA_INFO_INACTIVE_TIME] = { .type = NLA_U32 },
@@ -5252,24 +5252,15 @@ static int get_sta_handler(struct nl_msg *msg, void *arg)
 		[NL80211_STA_INFO_TX_FAILED] = { .type = NLA_U32 },
 	};
 
-	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
-		  genlmsg_attrlen(gnlh, 0), NULL);
-
-	/*
-	 * TODO: validate the interface and mac address!
-	 * Otherwise, there's a race condition as soon as
-	 * the kernel starts sending station notifications.
-	 */
-
 	if (!tb[NL80211_ATTR_STA_INFO]) {
 		wpa_printf(MSG_DEBUG, "sta stats missing!");
-		return NL_SKIP;
+		return -1;
 	}
 	if (nla_parse_nested(stats, NL80211_STA_INFO_MAX,
 			     tb[NL80211_ATTR_STA_INFO],
 			     stats_policy)) {
 		wpa_printf(MSG_DEBUG, "failed to parse nested attributes!");
-		return NL_SKIP;
+		return -1;
 	}
 
 	if (stats[NL80211_STA_INFO_INACTIVE_TIME])
@@ -5289,6 +5280,27 @@ static int get_sta_handler(struct nl_msg *msg, void *arg)
 		data->tx_retry_failed =
 			nla_get_u32(stats[NL80211_STA_INFO_TX_FAILED]);
 
+	return 0;
+}
+
+
+static int get_sta_handler(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct hostap_sta_driver_data *data = arg;
+
+	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
+		  genlmsg_attrlen(gnlh, 0), NULL);
+
+	/*
+	 * TODO: validate the interface and mac address!
+	 * Otherwise, there's a race condition as soon as
+	 * the kernel starts sending station notifications.
+	 */
+
+	nl80211_parse_sta_info(tb, data);
+
 	return NL_SKIP;
 }
 
@@ -5310,6 +5322,53 @@ static int i802_read_sta_data(struct i802_bss *bss,
 }
 
 
+struct nl80211_sta_dump_arg {
+	void (*cb)(void *ctx, const u8 *addr,
+		   struct hostap_sta_driver_data *data);
+	void *ctx;
+};
+
+
+static int get_all_sta_handler(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct nl80211_sta_dump_arg *dump = arg;
+	struct hostap_sta_driver_data data;
+
+	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
+		  genlmsg_attrlen(gnlh, 0), NULL);
+
+	if (!tb[NL80211_ATTR_MAC] ||
+	    nla_len(tb[NL80211_ATTR_MAC]) != ETH_ALEN)
+		return NL_SKIP;
+
+	os_memset(&data, 0, sizeof(data));
+	if (nl80211_parse_sta_info(tb, &data) == 0)
+		dump->cb(dump->ctx, nla_data(tb[NL80211_ATTR_MAC]), &data);
+
+	return NL_SKIP;
+}
+
+
+static int i802_read_all_sta_data(struct i802_bss *bss,
+				  void (*cb)(void *ctx, const u8 *addr,
+					     struct hostap_sta_driver_data *data),
+				  void *ctx)
+{
+	struct nl80211_sta_dump_arg dump;
+	struct nl_msg *msg;
+
+	msg = nl80211_bss_msg(bss, NLM_F_DUMP, NL80211_CMD_GET_STATION);
+	if (!msg)
+		return -ENOBUFS;
+
+	dump.cb = cb;
+	dump.ctx = ctx;
+	return send_and_recv_msgs(bss->drv, msg, get_all_sta_handler, &dump);
+}
+
+
 static int i802_set_tx_queue_params(void *priv, int queue, int aifs,
 				    int cw_min, int cw_max, int burst_time)
 {
@@ -7387,6 +7446,17 @@ static int driver_nl80211_read_sta_data(void *priv,
 }
 
 
+static int driver_nl80211_read_all_sta_data(
+	void *priv,
+	void (*cb)(void *ctx, const u8 *addr,
+		   struct hostap_sta_driver_data *data),
+	void *ctx)
+{
+	struct i802_bss *bss = priv;
+	return i802_read_all_sta_data(bss, cb, ctx);
+}
+
+
 static int driver_nl80211_send_action(void *priv, unsigned int freq,
 				      unsigned int wait_time,
 				      const u8 *dst, const u8 *src,
@@ -8955,6 +9025,7 @@ const struct wpa_driver_ops wpa_driver_nl80211_ops = {
 	.sta_deauth = i802_sta_deauth,
 	.sta_disassoc = i802_sta_disassoc,
 	.read_sta_data = driver_nl80211_read_sta_data,
+	.read_all_sta_data = driver_nl80211_read_all_sta_data,
 	.set_freq = i802_set_freq,
 	.send_action = driver_nl80211_send_action,
 	.send_action_cancel_wait = wpa_driver_nl80211_send_action_cancel_wait,
@@ -12,6 +12,7 @@
 #include "radius.h"
 #include "radius_client.h"
 #include "eloop.h"
+#include "list.h"
 
 /* Defaults for RADIUS retransmit values (exponential backoff) */
 
@@ -34,13 +35,32 @@
 #define RADIUS_CLIENT_MAX_RETRIES 10
 
 /**
- * RADIUS_CLIENT_MAX_ENTRIES - RADIUS client maximum pending messages
+ * RADIUS_CLIENT_MAX_ENTRIES - RADIUS client default maximum pending messages
  *
- * Maximum number of entries in retransmit list (oldest entries will be
- * removed, if this limit is exceeded).
+ * Default maximum number of requests that are waiting for a response from the
+ * server at the same time. Requests exceeding this limit (or the identifier
+ * space of the source ports) are queued until an earlier request completes.
+ * The limit can be changed with struct hostapd_radius_servers::max_pending.
  */
 #define RADIUS_CLIENT_MAX_ENTRIES 30
 
+/**
+ * RADIUS_CLIENT_MAX_QUEUED - RADIUS client maximum queued messages
+ *
+ * Maximum number of requests waiting for a free slot in the pending list
+ * (oldest queued entries will be removed, if this limit is exceeded).
+ */
+#define RADIUS_CLIENT_MAX_QUEUED 4096
+
+/**
+ * RADIUS_CLIENT_MAX_PORTS - RADIUS client maximum number of source ports
+ *
+ * Each source port has its own 8-bit RADIUS Identifier space, so this limits
+ * the number of pending requests to RADIUS_CLIENT_MAX_PORTS * 256 per server
+ * type.
+ */
+#define RADIUS_CLIENT_MAX_PORTS 16
+
 /**
  * RADIUS_CLIENT_NUM_FAILOVER - RADIUS client failover point
  *
@@ -134,12 +154,63 @@ struct radius_msg_list {
 	 */
 	size_t shared_secret_len;
 
+	/**
+	 * sock - Source port used for the message or %NULL while queued
+	 */
+	struct radius_client_sock *sock;
+
 	/* TODO: server config with failover to backup server(s) */
 
 	/**
-	 * next - Next message in the list
+	 * list - Entry in struct radius_client_data::msgs
+	 */
+	struct dl_list list;
+
+	/**
+	 * qlist - Entry in struct radius_client_data::queue while queued
+	 */
+	struct dl_list qlist;
+};
+
+
+/**
+ * struct radius_client_sock - RADIUS client source port
+ *
+ * This data structure is used internally inside the RADIUS client module to
+ * store a pair of IPv4/IPv6 sockets toward the current server. Each source
+ * port has its own 8-bit RADIUS Identifier space and pending requests are
+ * indexed by their Identifier so that responses can be matched directly.
+ */
+struct radius_client_sock {
+	/**
+	 * serv_sock - IPv4 socket
+	 */
+	int serv_sock;
+
+	/**
+	 * serv_sock6 - IPv6 socket
 	 */
-	struct radius_msg_list *next;
+	int serv_sock6;
+
+	/**
+	 * sock - Currently used socket (connected to the current server)
+	 */
+	int sock;
+
+	/**
+	 * msg_type - RADIUS_AUTH or RADIUS_ACCT
+	 */
+	RadiusType msg_type;
+
+	/**
+	 * pending - Number of pending requests sent from this port
+	 */
+	unsigned int pending;
+
+	/**
+	 * ids - Pending requests indexed by RADIUS Identifier
+	 */
+	struct radius_msg_list *ids[256];
 };
 
 
@@ -163,34 +234,19 @@ struct radius_client_data {
 	struct hostapd_radius_servers *conf;
 
 	/**
-	 * auth_serv_sock - IPv4 socket for RADIUS authentication messages
+	 * auth_socks - Source ports for RADIUS authentication messages
 	 */
-	int auth_serv_sock;
+	struct radius_client_sock *auth_socks;
 
 	/**
-	 * acct_serv_sock - IPv4 socket for RADIUS accounting messages
+	 * acct_socks - Source ports for RADIUS accounting messages
 	 */
-	int acct_serv_sock;
+	struct radius_client_sock *acct_socks;
 
 	/**
-	 * auth_serv_sock6 - IPv6 socket for RADIUS authentication messages
+	 * num_socks - Number of entries in auth_socks and acct_socks
 	 */
-	int auth_serv_sock6;
-
-	/**
-	 * acct_serv_sock6 - IPv6 socket for RADIUS accounting messages
-	 */
-	int acct_serv_sock6;
-
-	/**
-	 * auth_sock - Currently used socket for RADIUS authentication server
-	 */
-	int auth_sock;
-
-	/**
-	 * acct_sock - Currently used socket for RADIUS accounting server
-	 */
-	int acct_sock;
+	size_t num_socks;
 
 	/**
 	 * auth_handlers - Authentication message handlers
@@ -213,15 +269,35 @@ struct radius_client_data {
 	size_t num_acct_handlers;
 
 	/**
-	 * msgs - Pending outgoing RADIUS messages
+	 * msgs - Pending outgoing RADIUS messages (both sent and queued)
 	 */
-	struct radius_msg_list *msgs;
+	struct dl_list msgs;
 
 	/**
-	 * num_msgs - Number of pending messages in the msgs list
+	 * num_msgs - Number of sent messages in the msgs list
 	 */
 	size_t num_msgs;
 
+	/**
+	 * max_pending - Maximum number of entries in the msgs list
+	 */
+	size_t max_pending;
+
+	/**
+	 * queue - Messages in the msgs list waiting for a free pending slot
+	 */
+	struct dl_list queue;
+
+	/**
+	 * num_queued - Number of messages in the queue list
+	 */
+	size_t num_queued;
+
+	/**
+	 * num_acct_msgs - Number of accounting messages in the msgs list
+	 */
+	size_t num_acct_msgs;
+
 	/**
 	 * next_radius_identifier - Next RADIUS message identifier to use
 	 */
@@ -232,12 +308,12 @@ struct radius_client_data {
 static int
 radius_change_server(struct radius_client_data *radius,
 		     struct hostapd_radius_server *nserv,
-		     struct hostapd_radius_server *oserv,
-		     int sock, int sock6, int auth);
+		     struct hostapd_radius_server *oserv, int auth);
 static int radius_client_init_acct(struct radius_client_data *radius);
 static int radius_client_init_auth(struct radius_client_data *radius);
 static void radius_client_auth_failover(struct radius_client_data *radius);
 static void radius_client_acct_failover(struct radius_client_data *radius);
+static void radius_client_send_queued(struct radius_client_data *radius);
 
 
 static void radius_client_msg_free(struct radius_msg_list *req)
@@ -247,6 +323,58 @@ static void radius_client_msg_free(struct radius_msg_list *req)
 }
 
 
+static void radius_client_msg_unlink(struct radius_client_data *radius,
+				     struct radius_msg_list *req)
+{
+	dl_list_del(&req->list);
+	if (req->msg_type == RADIUS_ACCT ||
+	    req->msg_type == RADIUS_ACCT_INTERIM)
+		radius->num_acct_msgs--;
+	if (req->sock) {
+		req->sock->ids[radius_msg_get_hdr(req->msg)->identifier] =
+			NULL;
+		req->sock->pending--;
+		req->sock = NULL;
+		radius->num_msgs--;
+	} else {
+		dl_list_del(&req->qlist);
+		radius->num_queued--;
+	}
+}
+
+
+static void radius_client_msg_remove(struct radius_client_data *radius,
+				     struct radius_msg_list *req)
+{
+	radius_client_msg_unlink(radius, req);
+	radius_client_msg_free(req);
+}
+
+
+static struct radius_client_sock *
+radius_client_socks(struct radius_client_data *radius, RadiusType msg_type)
+{
+	if (msg_type == RADIUS_ACCT || msg_type == RADIUS_ACCT_INTERIM)
+		return radius->acct_socks;
+	return radius->auth_socks;
+}
+
+
+static int radius_client_has_sock(struct radius_client_data *radius,
+				  RadiusType msg_type)
+{
+	struct radius_client_sock *socks = radius_client_socks(radius,
+							       msg_type);
+	size_t i;
+
+	for (i = 0; i < radius->num_socks; i++) {
+		if (socks[i].sock >= 0)
+			return 1;
+	}
+	return 0;
+}
+
+
 /**
  * radius_client_register - Register a RADIUS client RX handler
  * @radius: RADIUS client context from radius_client_init()
@@ -339,15 +467,15 @@ static int radius_client_retransmit(struct radius_client_data *radius,
 
 	if (entry->msg_type == RADIUS_ACCT ||
 	    entry->msg_type == RADIUS_ACCT_INTERIM) {
-		if (radius->acct_sock < 0)
+		if (!radius_client_has_sock(radius, RADIUS_ACCT))
 			radius_client_init_acct(radius);
-		if (radius->acct_sock < 0 && conf->num_acct_servers > 1) {
+		if (!radius_client_has_sock(radius, RADIUS_ACCT) &&
+		    conf->num_acct_servers > 1) {
 			prev_num_msgs = radius->num_msgs;
 			radius_client_acct_failover(radius);
 			if (prev_num_msgs != radius->num_msgs)
 				return 0;
 		}
-		s = radius->acct_sock;
 		if (entry->attempts == 0)
 			conf->acct_server->requests++;
 		else {
@@ -355,15 +483,15 @@ static int radius_client_retransmit(struct radius_client_data *radius,
 			conf->acct_server->retransmissions++;
 		}
 	} else {
-		if (radius->auth_sock < 0)
+		if (!radius_client_has_sock(radius, RADIUS_AUTH))
 			radius_client_init_auth(radius);
-		if (radius->auth_sock < 0 && conf->num_auth_servers > 1) {
+		if (!radius_client_has_sock(radius, RADIUS_AUTH) &&
+		    conf->num_auth_servers > 1) {
 			prev_num_msgs = radius->num_msgs;
 			radius_client_auth_failover(radius);
 			if (prev_num_msgs != radius->num_msgs)
 				return 0;
 		}
-		s = radius->auth_sock;
 		if (entry->attempts == 0)
 			conf->auth_server->requests++;
 		else {
@@ -371,6 +499,7 @@ static int radius_client_retransmit(struct radius_client_data *radius,
 			conf->auth_server->retransmissions++;
 		}
 	}
+	s = entry->sock->sock;
 	if (s < 0) {
 		wpa_printf(MSG_INFO,
 			   "RADIUS: No valid socket for retransmission");
@@ -410,47 +539,37 @@ static void radius_client_timer(void *eloop_ctx, void *timeout_ctx)
 	struct hostapd_radius_servers *conf = radius->conf;
 	struct os_reltime now;
 	os_time_t first;
-	struct radius_msg_list *entry, *prev, *tmp;
+	struct radius_msg_list *entry, *tmp;
 	int auth_failover = 0, acct_failover = 0;
 	size_t prev_num_msgs;
-	int s;
 
-	entry = radius->msgs;
-	if (!entry)
+	if (!radius->num_msgs)
 		return;
 
 	os_get_reltime(&now);
 	first = 0;
 
-	prev = NULL;
-	while (entry) {
+restart:
+	dl_list_for_each_safe(entry, tmp, &radius->msgs,
+			      struct radius_msg_list, list) {
+		if (!entry->sock)
+			continue;
+
 		prev_num_msgs = radius->num_msgs;
 		if (now.sec >= entry->next_try &&
 		    radius_client_retransmit(radius, entry, now.sec)) {
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
-
-			tmp = entry;
-			entry = entry->next;
-			radius_client_msg_free(tmp);
-			radius->num_msgs--;
+			radius_client_msg_remove(radius, entry);
 			continue;
 		}
 
 		if (prev_num_msgs != radius->num_msgs) {
 			wpa_printf(MSG_DEBUG,
 				   "RADIUS: Message removed from queue - restart from beginning");
-			entry = radius->msgs;
-			prev = NULL;
-			continue;
+			goto restart;
 		}
 
-		s = entry->msg_type == RADIUS_AUTH ? radius->auth_sock :
-			radius->acct_sock;
 		if (entry->attempts > RADIUS_CLIENT_NUM_FAILOVER ||
-		    (s < 0 && entry->attempts > 0)) {
+		    (entry->sock->sock < 0 && entry->attempts > 0)) {
 			if (entry->msg_type == RADIUS_ACCT ||
 			    entry->msg_type == RADIUS_ACCT_INTERIM)
 				acct_failover++;
@@ -460,12 +579,9 @@ static void radius_client_timer(void *eloop_ctx, void *timeout_ctx)
 
 		if (first == 0 || entry->next_try < first)
 			first = entry->next_try;
-
-		prev = entry;
-		entry = entry->next;
 	}
 
-	if (radius->msgs) {
+	if (radius->num_msgs) {
 		if (first < now.sec)
 			first = now.sec;
 		eloop_register_timeout(first - now.sec, 0,
@@ -481,6 +597,8 @@ static void radius_client_timer(void *eloop_ctx, void *timeout_ctx)
 
 	if (acct_failover && conf->num_acct_servers > 1)
 		radius_client_acct_failover(radius);
+
+	radius_client_send_queued(radius);
 }
 
 
@@ -498,8 +616,8 @@ static void radius_client_auth_failover(struct radius_client_data *radius)
 		       hostapd_ip_txt(&old->addr, abuf, sizeof(abuf)),
 		       old->port);
 
-	for (entry = radius->msgs; entry; entry = entry->next) {
-		if (entry->msg_type == RADIUS_AUTH)
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
+		if (entry->sock && entry->msg_type == RADIUS_AUTH)
 			old->timeouts++;
 	}
 
@@ -507,9 +625,7 @@ static void radius_client_auth_failover(struct radius_client_data *radius)
 	if (next > &(conf->auth_servers[conf->num_auth_servers - 1]))
 		next = conf->auth_servers;
 	conf->auth_server = next;
-	radius_change_server(radius, next, old,
-			     radius->auth_serv_sock,
-			     radius->auth_serv_sock6, 1);
+	radius_change_server(radius, next, old, 1);
 }
 
 
@@ -527,9 +643,10 @@ static void radius_client_acct_failover(struct radius_client_data *radius)
 		       hostapd_ip_txt(&old->addr, abuf, sizeof(abuf)),
 		       old->port);
 
-	for (entry = radius->msgs; entry; entry = entry->next) {
-		if (entry->msg_type == RADIUS_ACCT ||
-		    entry->msg_type == RADIUS_ACCT_INTERIM)
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
+		if (entry->sock &&
+		    (entry->msg_type == RADIUS_ACCT ||
+		     entry->msg_type == RADIUS_ACCT_INTERIM))
 			old->timeouts++;
 	}
 
@@ -537,9 +654,7 @@ static void radius_client_acct_failover(struct radius_client_data *radius)
 	if (next > &conf->acct_servers[conf->num_acct_servers - 1])
 		next = conf->acct_servers;
 	conf->acct_server = next;
-	radius_change_server(radius, next, old,
-			     radius->acct_serv_sock,
-			     radius->acct_serv_sock6, 0);
+	radius_change_server(radius, next, old, 0);
 }
 
 
@@ -551,13 +666,13 @@ static void radius_client_update_timeout(struct radius_client_data *radius)
 
 	eloop_cancel_timeout(radius_client_timer, radius, NULL);
 
-	if (radius->msgs == NULL) {
+	if (!radius->num_msgs) {
 		return;
 	}
 
 	first = 0;
-	for (entry = radius->msgs; entry; entry = entry->next) {
-		if (first == 0 || entry->next_try < first)
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
+		if (entry->sock && (first == 0 || entry->next_try < first))
 			first = entry->next_try;
 	}
 
@@ -572,13 +687,97 @@ static void radius_client_update_timeout(struct radius_client_data *radius)
 }
 
 
+static struct radius_client_sock *
+radius_client_select_sock(struct radius_client_data *radius,
+			  struct radius_msg_list *entry)
+{
+	struct radius_client_sock *socks;
+	u8 id = radius_msg_get_hdr(entry->msg)->identifier;
+	size_t i;
+
+	if (radius->num_msgs >= radius->max_pending)
+		return NULL;
+
+	socks = radius_client_socks(radius, entry->msg_type);
+	for (i = 0; i < radius->num_socks; i++) {
+		if (socks[i].sock >= 0 && socks[i].ids[id] == NULL)
+			return &socks[i];
+	}
+
+	return NULL;
+}
+
+
+static void radius_client_transmit(struct radius_client_data *radius,
+				   struct radius_msg_list *entry,
+				   struct radius_client_sock *rsock)
+{
+	struct hostapd_radius_servers *conf = radius->conf;
+	struct wpabuf *buf;
+	int s = rsock->sock;
+
+	entry->sock = rsock;
+	rsock->ids[radius_msg_get_hdr(entry->msg)->identifier] = entry;
+	rsock->pending++;
+	radius->num_msgs++;
+
+	if (entry->msg_type == RADIUS_ACCT ||
+	    entry->msg_type == RADIUS_ACCT_INTERIM)
+		conf->acct_server->requests++;
+	else
+		conf->auth_server->requests++;
+
+	hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
+		       HOSTAPD_LEVEL_DEBUG, "Sending RADIUS message to %s "
+		       "server", entry->msg_type == RADIUS_AUTH ?
+		       "authentication" : "accounting");
+	if (conf->msg_dumps)
+		radius_msg_dump(entry->msg);
+
+	os_get_reltime(&entry->last_attempt);
+	entry->first_try = entry->last_attempt.sec;
+	entry->next_try = entry->first_try + RADIUS_CLIENT_FIRST_WAIT;
+	entry->attempts = 1;
+	entry->next_wait = RADIUS_CLIENT_FIRST_WAIT * 2;
+
+	/* A new entry is due no earlier than any already pending one, so the
+	 * retransmit timer only needs to be pulled in, never recomputed. */
+	if (eloop_deplete_timeout(RADIUS_CLIENT_FIRST_WAIT, 0,
+				  radius_client_timer, radius, NULL) < 0)
+		radius_client_update_timeout(radius);
+
+	buf = radius_msg_get_buf(entry->msg);
+	if (send(s, wpabuf_head(buf), wpabuf_len(buf), 0) < 0)
+		radius_client_handle_send_error(radius, s, entry->msg_type);
+}
+
+
+static void radius_client_send_queued(struct radius_client_data *radius)
+{
+	struct radius_msg_list *entry, *tmp;
+	struct radius_client_sock *rsock;
+
+	dl_list_for_each_safe(entry, tmp, &radius->queue,
+			      struct radius_msg_list, qlist) {
+		if (radius->num_msgs >= radius->max_pending)
+			break;
+		rsock = radius_client_select_sock(radius, entry);
+		if (rsock == NULL)
+			continue;
+		dl_list_del(&entry->qlist);
+		radius->num_queued--;
+		radius_client_transmit(radius, entry, rsock);
+	}
+}
+
+
 static void radius_client_list_add(struct radius_client_data *radius,
 				   struct radius_msg *msg,
 				   RadiusType msg_type,
 				   const u8 *shared_secret,
 				   size_t shared_secret_len, const u8 *addr)
 {
-	struct radius_msg_list *entry, *prev;
+	struct radius_msg_list *entry;
 
 	if (eloop_terminated()) {
 		/* No point in adding entries to retransmit queue since event
@@ -600,60 +799,51 @@ static void radius_client_list_add(struct radius_client_data *radius,
 	entry->msg_type = msg_type;
 	entry->shared_secret = shared_secret;
 	entry->shared_secret_len = shared_secret_len;
-	os_get_reltime(&entry->last_attempt);
-	entry->first_try = entry->last_attempt.sec;
-	entry->next_try = entry->first_try + RADIUS_CLIENT_FIRST_WAIT;
-	entry->attempts = 1;
-	entry->next_wait = RADIUS_CLIENT_FIRST_WAIT * 2;
-	entry->next = radius->msgs;
-	radius->msgs = entry;
-	radius_client_update_timeout(radius);
-
-	if (radius->num_msgs >= RADIUS_CLIENT_MAX_ENTRIES) {
-		wpa_printf(MSG_INFO, "RADIUS: Removing the oldest un-ACKed packet due to retransmit list limits");
-		prev = NULL;
-		while (entry->next) {
-			prev = entry;
-			entry = entry->next;
-		}
-		if (prev) {
-			prev->next = NULL;
-			radius_client_msg_free(entry);
-		}
-	} else
-		radius->num_msgs++;
+
+	if (radius->num_queued >= RADIUS_CLIENT_MAX_QUEUED) {
+		wpa_printf(MSG_INFO, "RADIUS: Removing the oldest queued packet due to queue limits");
+		radius_client_msg_remove(
+			radius, dl_list_first(&radius->queue,
+					      struct radius_msg_list, qlist));
+	}
+
+	/* Go through the queue so that earlier requests waiting for a free
+	 * Identifier are sent first. */
+	dl_list_add_tail(&radius->msgs, &entry->list);
+	dl_list_add_tail(&radius->queue, &entry->qlist);
+	radius->num_queued++;
+	if (msg_type == RADIUS_ACCT || msg_type == RADIUS_ACCT_INTERIM)
+		radius->num_acct_msgs++;
+	radius_client_send_queued(radius);
+
+	if (entry->sock == NULL)
+		hostapd_logger(radius->ctx, entry->addr, HOSTAPD_MODULE_RADIUS,
+			       HOSTAPD_LEVEL_DEBUG,
+			       "RADIUS message queued (id=%d, %u pending, %u queued)",
+			       radius_msg_get_hdr(msg)->identifier,
+			       (unsigned int) radius->num_msgs,
+			       (unsigned int) radius->num_queued);
 }
 
 
 static void radius_client_list_del(struct radius_client_data *radius,
 				   RadiusType msg_type, const u8 *addr)
 {
-	struct radius_msg_list *entry, *prev, *tmp;
+	struct radius_msg_list *entry, *tmp;
 
 	if (addr == NULL)
 		return;
 
-	entry = radius->msgs;
-	prev = NULL;
-	while (entry) {
+	dl_list_for_each_safe(entry, tmp, &radius->msgs,
+			      struct radius_msg_list, list) {
 		if (entry->msg_type == msg_type &&
 		    os_memcmp(entry->addr, addr, ETH_ALEN) == 0) {
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
-			tmp = entry;
-			entry = entry->next;
 			hostapd_logger(radius->ctx, addr,
 				       HOSTAPD_MODULE_RADIUS,
 				       HOSTAPD_LEVEL_DEBUG,
 				       "Removing matching RADIUS message");
-			radius_client_msg_free(tmp);
-			radius->num_msgs--;
-			continue;
+			radius_client_msg_remove(radius, entry);
 		}
-		prev = entry;
-		entry = entry->next;
 	}
 }
 
@@ -674,7 +864,9 @@ static void radius_client_list_del(struct radius_client_data *radius,
  *
  * The message is added on the retransmission queue and will be retransmitted
  * automatically until a response is received or maximum number of retries
- * (RADIUS_CLIENT_MAX_RETRIES) is reached.
+ * (RADIUS_CLIENT_MAX_RETRIES) is reached. If the maximum number of pending
+ * requests has been reached or the message Identifier is in use on all source
+ * ports, the message is queued and sent once an earlier request completes.
  *
  * The related device MAC address can be used to identify pending messages that
  * can be removed with radius_client_flush_auth() or with interim accounting
@@ -687,9 +879,6 @@ int radius_client_send(struct radius_client_data *radius,
 	struct hostapd_radius_servers *conf = radius->conf;
 	const u8 *shared_secret;
 	size_t shared_secret_len;
-	char *name;
-	int s, res;
-	struct wpabuf *buf;
 
 	if (msg_type == RADIUS_ACCT_INTERIM) {
 		/* Remove any pending interim acct update for the same STA. */
@@ -697,10 +886,12 @@ int radius_client_send(struct radius_client_data *radius,
 	}
 
 	if (msg_type == RADIUS_ACCT || msg_type == RADIUS_ACCT_INTERIM) {
-		if (conf->acct_server && radius->acct_sock < 0)
+		if (conf->acct_server &&
+		    !radius_client_has_sock(radius, RADIUS_ACCT))
 			radius_client_init_acct(radius);
 
-		if (conf->acct_server == NULL || radius->acct_sock < 0 ||
+		if (conf->acct_server == NULL ||
+		    !radius_client_has_sock(radius, RADIUS_ACCT) ||
 		    conf->acct_server->shared_secret == NULL) {
 			hostapd_logger(radius->ctx, NULL,
 				       HOSTAPD_MODULE_RADIUS,
@@ -711,14 +902,13 @@ int radius_client_send(struct radius_client_data *radius,
 		shared_secret = conf->acct_server->shared_secret;
 		shared_secret_len = conf->acct_server->shared_secret_len;
 		radius_msg_finish_acct(msg, shared_secret, shared_secret_len);
-		name = "accounting";
-		s = radius->acct_sock;
-		conf->acct_server->requests++;
 	} else {
-		if (conf->auth_server && radius->auth_sock < 0)
+		if (conf->auth_server &&
+		    !radius_client_has_sock(radius, RADIUS_AUTH))
 			radius_client_init_auth(radius);
 
-		if (conf->auth_server == NULL || radius->auth_sock < 0 ||
+		if (conf->auth_server == NULL ||
+		    !radius_client_has_sock(radius, RADIUS_AUTH) ||
 		    conf->auth_server->shared_secret == NULL) {
 			hostapd_logger(radius->ctx, NULL,
 				       HOSTAPD_MODULE_RADIUS,
@@ -729,22 +919,8 @@ int radius_client_send(struct radius_client_data *radius,
 		shared_secret = conf->auth_server->shared_secret;
 		shared_secret_len = conf->auth_server->shared_secret_len;
 		radius_msg_finish(msg, shared_secret, shared_secret_len);
-		name = "authentication";
-		s = radius->auth_sock;
-		conf->auth_server->requests++;
 	}
 
-	hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
-		       HOSTAPD_LEVEL_DEBUG, "Sending RADIUS message to %s "
-		       "server", name);
-	if (conf->msg_dumps)
-		radius_msg_dump(msg);
-
-	buf = radius_msg_get_buf(msg);
-	res = send(s, wpabuf_head(buf), wpabuf_len(buf), 0);
-	if (res < 0)
-		radius_client_handle_send_error(radius, s, msg_type);
-
 	radius_client_list_add(radius, msg, msg_type, shared_secret,
 			       shared_secret_len, addr);
 
@@ -756,14 +932,15 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 {
 	struct radius_client_data *radius = eloop_ctx;
 	struct hostapd_radius_servers *conf = radius->conf;
-	RadiusType msg_type = (RadiusType) sock_ctx;
+	struct radius_client_sock *rsock = sock_ctx;
+	RadiusType msg_type = rsock->msg_type;
 	int len, roundtrip;
 	unsigned char buf[3000];
 	struct radius_msg *msg;
 	struct radius_hdr *hdr;
 	struct radius_rx_handler *handlers;
 	size_t num_handlers, i;
-	struct radius_msg_list *req, *prev_req;
+	struct radius_msg_list *req;
 	struct os_reltime now;
 	struct hostapd_radius_server *rconf;
 	int invalid_authenticator = 0;
@@ -819,22 +996,9 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 		break;
 	}
 
-	prev_req = NULL;
-	req = radius->msgs;
-	while (req) {
-		/* TODO: also match by src addr:port of the packet when using
-		 * alternative RADIUS servers (?) */
-		if ((req->msg_type == msg_type ||
-		     (req->msg_type == RADIUS_ACCT_INTERIM &&
-		      msg_type == RADIUS_ACCT)) &&
-		    radius_msg_get_hdr(req->msg)->identifier ==
-		    hdr->identifier)
-			break;
-
-		prev_req = req;
-		req = req->next;
-	}
-
+	/* TODO: also match by src addr:port of the packet when using
+	 * alternative RADIUS servers (?) */
+	req = rsock->ids[hdr->identifier];
 	if (req == NULL) {
 		hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
 			       HOSTAPD_LEVEL_DEBUG,
@@ -844,6 +1008,22 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 		goto fail;
 	}
 
+	/*
+	 * The Identifier of a completed request may already be in use again
+	 * on this port, so a delayed duplicate of the earlier response must
+	 * not complete the new request.
+	 */
+	if (radius_msg_verify(msg, req->shared_secret, req->shared_secret_len,
+			      req->msg, 0)) {
+		hostapd_logger(radius->ctx, req->addr, HOSTAPD_MODULE_RADIUS,
+			       HOSTAPD_LEVEL_DEBUG,
+			       "RADIUS response does not match the pending "
+			       "request (type=%d id=%d) - dropping packet",
+			       msg_type, hdr->identifier);
+		rconf->bad_authenticators++;
+		goto fail;
+	}
+
 	os_get_reltime(&now);
 	roundtrip = (now.sec - req->last_attempt.sec) * 100 +
 		(now.usec - req->last_attempt.usec) / 10000;
@@ -855,11 +1035,8 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 	rconf->round_trip_time = roundtrip;
 
 	/* Remove ACKed RADIUS packet from retransmit list */
-	if (prev_req)
-		prev_req->next = req->next;
-	else
-		radius->msgs = req->next;
-	radius->num_msgs--;
+	radius_client_msg_unlink(radius, req);
+	radius_client_send_queued(radius);
 
 	for (i = 0; i < num_handlers; i++) {
 		RadiusRxResult res;
@@ -904,41 +1081,31 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
  * @radius: RADIUS client context from radius_client_init()
  * Returns: Allocated identifier
  *
- * This function is used to fetch a unique (among pending requests) identifier
- * for a new RADIUS message.
+ * This function is used to fetch an identifier for a new RADIUS message. The
+ * identifier is unique among pending requests sent from the same source port;
+ * radius_client_send() selects a source port on which it is not in use or
+ * queues the message until one is available. Since the same identifier may be
+ * pending on multiple source ports, RX handlers need to match responses using
+ * the Request Authenticator of the request in addition to the identifier.
  */
 u8 radius_client_get_id(struct radius_client_data *radius)
 {
-	struct radius_msg_list *entry, *prev, *_remove;
-	u8 id = radius->next_radius_identifier++;
-
-	/* remove entries with matching id from retransmit list to avoid
-	 * using new reply from the RADIUS server with an old request */
-	entry = radius->msgs;
-	prev = NULL;
-	while (entry) {
-		if (radius_msg_get_hdr(entry->msg)->identifier == id) {
-			hostapd_logger(radius->ctx, entry->addr,
-				       HOSTAPD_MODULE_RADIUS,
-				       HOSTAPD_LEVEL_DEBUG,
-				       "Removing pending RADIUS message, "
-				       "since its id (%d) is reused", id);
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
-			_remove = entry;
-		} else {
-			_remove = NULL;
-			prev = entry;
-		}
-		entry = entry->next;
+	return radius->next_radius_identifier++;
+}
 
-		if (_remove)
-			radius_client_msg_free(_remove);
-	}
 
-	return id;
+/**
+ * radius_client_acct_pending - Get the number of pending accounting messages
+ * @radius: RADIUS client context from radius_client_init()
+ * Returns: Number of accounting messages waiting for a response or queued
+ *
+ * This can be used by the accounting module to postpone messages that can be
+ * delayed (e.g., interim updates) while the accounting server is not keeping
+ * up with the request rate.
+ */
+size_t radius_client_acct_pending(struct radius_client_data *radius)
+{
+	return radius ? radius->num_acct_msgs : 0;
 }
 
 
@@ -949,32 +1116,18 @@ u8 radius_client_get_id(struct radius_client_data *radius)
  */
 void radius_client_flush(struct radius_client_data *radius, int only_auth)
 {
-	struct radius_msg_list *entry, *prev, *tmp;
+	struct radius_msg_list *entry, *tmp;
 
 	if (!radius)
 		return;
 
-	prev = NULL;
-	entry = radius->msgs;
-
-	while (entry) {
-		if (!only_auth || entry->msg_type == RADIUS_AUTH) {
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
-
-			tmp = entry;
-			entry = entry->next;
-			radius_client_msg_free(tmp);
-			radius->num_msgs--;
-		} else {
-			prev = entry;
-			entry = entry->next;
-		}
+	dl_list_for_each_safe(entry, tmp, &radius->msgs,
+			      struct radius_msg_list, list) {
+		if (!only_auth || entry->msg_type == RADIUS_AUTH)
+			radius_client_msg_remove(radius, entry);
 	}
 
-	if (radius->msgs == NULL)
+	if (!radius->num_msgs)
 		eloop_cancel_timeout(radius_client_timer, radius, NULL);
 }
 
@@ -988,7 +1141,7 @@ static void radius_client_update_acct_msgs(struct radius_client_data *radius,
 	if (!radius)
 		return;
 
-	for (entry = radius->msgs; entry; entry = entry->next) {
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
 		if (entry->msg_type == RADIUS_ACCT) {
 			entry->shared_secret = shared_secret;
 			entry->shared_secret_len = shared_secret_len;
@@ -999,22 +1152,106 @@ static void radius_client_update_acct_msgs(struct radius_client_data *radius,
 }
 
 
+static int radius_client_connect(struct radius_client_data *radius,
+				 struct radius_client_sock *rsock,
+				 int sel_sock, struct sockaddr *addr,
+				 socklen_t addrlen)
+{
+	struct hostapd_radius_servers *conf = radius->conf;
+	struct sockaddr_in claddr;
+#ifdef CONFIG_IPV6
+	struct sockaddr_in6 claddr6;
+	char abuf[50];
+#endif /* CONFIG_IPV6 */
+	struct sockaddr *cl_addr;
+	socklen_t claddrlen;
+
+	if (conf->force_client_addr) {
+		switch (conf->client_addr.af) {
+		case AF_INET:
+			os_memset(&claddr, 0, sizeof(claddr));
+			claddr.sin_family = AF_INET;
+			claddr.sin_addr.s_addr = conf->client_addr.u.v4.s_addr;
+			claddr.sin_port = htons(0);
+			cl_addr = (struct sockaddr *) &claddr;
+			claddrlen = sizeof(claddr);
+			break;
+#ifdef CONFIG_IPV6
+		case AF_INET6:
+			os_memset(&claddr6, 0, sizeof(claddr6));
+			claddr6.sin6_family = AF_INET6;
+			os_memcpy(&claddr6.sin6_addr, &conf->client_addr.u.v6,
+				  sizeof(struct in6_addr));
+			claddr6.sin6_port = htons(0);
+			cl_addr = (struct sockaddr *) &claddr6;
+			claddrlen = sizeof(claddr6);
+			break;
+#endif /* CONFIG_IPV6 */
+		default:
+			return -1;
+		}
+
+		if (bind(sel_sock, cl_addr, claddrlen) < 0) {
+			wpa_printf(MSG_INFO, "bind[radius]: %s",
+				   strerror(errno));
+			return -1;
+		}
+	}
+
+	if (connect(sel_sock, addr, addrlen) < 0) {
+		wpa_printf(MSG_INFO, "connect[radius]: %s", strerror(errno));
+		return -1;
+	}
+
+#ifndef CONFIG_NATIVE_WINDOWS
+	switch (addr->sa_family) {
+	case AF_INET:
+		claddrlen = sizeof(claddr);
+		if (getsockname(sel_sock, (struct sockaddr *) &claddr,
+				&claddrlen) == 0) {
+			wpa_printf(MSG_DEBUG, "RADIUS local address: %s:%u",
+				   inet_ntoa(claddr.sin_addr),
+				   ntohs(claddr.sin_port));
+		}
+		break;
+#ifdef CONFIG_IPV6
+	case AF_INET6: {
+		claddrlen = sizeof(claddr6);
+		if (getsockname(sel_sock, (struct sockaddr *) &claddr6,
+				&claddrlen) == 0) {
+			wpa_printf(MSG_DEBUG, "RADIUS local address: %s:%u",
+				   inet_ntop(AF_INET6, &claddr6.sin6_addr,
+					     abuf, sizeof(abuf)),
+				   ntohs(claddr6.sin6_port));
+		}
+		break;
+	}
+#endif /* CONFIG_IPV6 */
+	}
+#endif /* CONFIG_NATIVE_WINDOWS */
+
+	rsock->sock = sel_sock;
+
+	return 0;
+}
+
+
 static int
 radius_change_server(struct radius_client_data *radius,
 		     struct hostapd_radius_server *nserv,
-		     struct hostapd_radius_server *oserv,
-		     int sock, int sock6, int auth)
+		     struct hostapd_radius_server *oserv, int auth)
 {
-	struct sockaddr_in serv, claddr;
+	struct sockaddr_in serv;
 #ifdef CONFIG_IPV6
-	struct sockaddr_in6 serv6, claddr6;
+	struct sockaddr_in6 serv6;
 #endif /* CONFIG_IPV6 */
-	struct sockaddr *addr, *cl_addr;
-	socklen_t addrlen, claddrlen;
+	struct sockaddr *addr;
+	socklen_t addrlen;
 	char abuf[50];
 	int sel_sock;
 	struct radius_msg_list *entry;
-	struct hostapd_radius_servers *conf = radius->conf;
+	struct radius_client_sock *rsock;
+	size_t i;
 
 	hostapd_logger(radius->ctx, NULL, HOSTAPD_MODULE_RADIUS,
 		       HOSTAPD_LEVEL_INFO,
@@ -1044,9 +1281,11 @@ radius_change_server(struct radius_client_data *radius,
 	}
 
 	/* Reset retry counters for the new server */
-	for (entry = radius->msgs; oserv && oserv != nserv && entry;
-	     entry = entry->next) {
-		if ((auth && entry->msg_type != RADIUS_AUTH) ||
+	dl_list_for_each(entry, &radius->msgs, struct radius_msg_list, list) {
+		if (!oserv || oserv == nserv)
+			break;
+		if (!entry->sock ||
+		    (auth && entry->msg_type != RADIUS_AUTH) ||
 		    (!auth && entry->msg_type != RADIUS_ACCT))
 			continue;
 		entry->next_try = entry->first_try + RADIUS_CLIENT_FIRST_WAIT;
@@ -1054,7 +1293,7 @@ radius_change_server(struct radius_client_data *radius,
 		entry->next_wait = RADIUS_CLIENT_FIRST_WAIT * 2;
 	}
 
-	if (radius->msgs) {
+	if (radius->num_msgs) {
 		eloop_cancel_timeout(radius_client_timer, radius, NULL);
 		eloop_register_timeout(RADIUS_CLIENT_FIRST_WAIT, 0,
 				       radius_client_timer, radius, NULL);
@@ -1068,7 +1307,6 @@ radius_change_server(struct radius_client_data *radius,
 		serv.sin_port = htons(nserv->port);
 		addr = (struct sockaddr *) &serv;
 		addrlen = sizeof(serv);
-		sel_sock = sock;
 		break;
 #ifdef CONFIG_IPV6
 	case AF_INET6:
@@ -1079,89 +1317,29 @@ radius_change_server(struct radius_client_data *radius,
 		serv6.sin6_port = htons(nserv->port);
 		addr = (struct sockaddr *) &serv6;
 		addrlen = sizeof(serv6);
-		sel_sock = sock6;
 		break;
 #endif /* CONFIG_IPV6 */
 	default:
 		return -1;
 	}
 
-	if (sel_sock < 0) {
-		wpa_printf(MSG_INFO,
-			   "RADIUS: No server socket available (af=%d sock=%d sock6=%d auth=%d",
-			   nserv->addr.af, sock, sock6, auth);
-		return -1;
-	}
-
-	if (conf->force_client_addr) {
-		switch (conf->client_addr.af) {
-		case AF_INET:
-			os_memset(&claddr, 0, sizeof(claddr));
-			claddr.sin_family = AF_INET;
-			claddr.sin_addr.s_addr = conf->client_addr.u.v4.s_addr;
-			claddr.sin_port = htons(0);
-			cl_addr = (struct sockaddr *) &claddr;
-			claddrlen = sizeof(claddr);
-			break;
-#ifdef CONFIG_IPV6
-		case AF_INET6:
-			os_memset(&claddr6, 0, sizeof(claddr6));
-			claddr6.sin6_family = AF_INET6;
-			os_memcpy(&claddr6.sin6_addr, &conf->client_addr.u.v6,
-				  sizeof(struct in6_addr));
-			claddr6.sin6_port = htons(0);
-			cl_addr = (struct sockaddr *) &claddr6;
-			claddrlen = sizeof(claddr6);
-			break;
-#endif /* CONFIG_IPV6 */
-		default:
+	rsock = radius_client_socks(radius, auth ? RADIUS_AUTH : RADIUS_ACCT);
+	for (i = 0; i < radius->num_socks; i++, rsock++) {
+		sel_sock = nserv->addr.af == AF_INET ? rsock->serv_sock :
+			rsock->serv_sock6;
+		if (sel_sock < 0) {
+			wpa_printf(MSG_INFO,
+				   "RADIUS: No server socket available (af=%d sock=%d sock6=%d auth=%d",
+				   nserv->addr.af, rsock->serv_sock,
+				   rsock->serv_sock6, auth);
 			return -1;
 		}
 
-		if (bind(sel_sock, cl_addr, claddrlen) < 0) {
-			wpa_printf(MSG_INFO, "bind[radius]: %s",
-				   strerror(errno));
+		if (radius_client_connect(radius, rsock, sel_sock, addr,
+					  addrlen) < 0)
 			return -1;
-		}
-	}
-
-	if (connect(sel_sock, addr, addrlen) < 0) {
-		wpa_printf(MSG_INFO, "connect[radius]: %s", strerror(errno));
-		return -1;
 	}
 
-#ifndef CONFIG_NATIVE_WINDOWS
-	switch (nserv->addr.af) {
-	case AF_INET:
-		claddrlen = sizeof(claddr);
-		if (getsockname(sel_sock, (struct sockaddr *) &claddr,
-				&claddrlen) == 0) {
-			wpa_printf(MSG_DEBUG, "RADIUS local address: %s:%u",
-				   inet_ntoa(claddr.sin_addr),
-				   ntohs(claddr.sin_port));
-		}
-		break;
-#ifdef CONFIG_IPV6
-	case AF_INET6: {
-		claddrlen = sizeof(claddr6);
-		if (getsockname(sel_sock, (struct sockaddr *) &claddr6,
-				&claddrlen) == 0) {
-			wpa_printf(MSG_DEBUG, "RADIUS local address: %s:%u",
-				   inet_ntop(AF_INET6, &claddr6.sin6_addr,
-					     abuf, sizeof(abuf)),
-				   ntohs(claddr6.sin6_port));
-		}
-		break;
-	}
-#endif /* CONFIG_IPV6 */
-	}
-#endif /* CONFIG_NATIVE_WINDOWS */
-
-	if (auth)
-		radius->auth_sock = sel_sock;
-	else
-		radius->acct_sock = sel_sock;
-
 	return 0;
 }
 
@@ -1172,34 +1350,32 @@ static void radius_retry_primary_timer(void *eloop_ctx, void *timeout_ctx)
 	struct hostapd_radius_servers *conf = radius->conf;
 	struct hostapd_radius_server *oserv;
 
-	if (radius->auth_sock >= 0 && conf->auth_servers &&
+	if (radius_client_has_sock(radius, RADIUS_AUTH) && conf->auth_servers &&
 	    conf->auth_server != conf->auth_servers) {
 		oserv = conf->auth_server;
 		conf->auth_server = conf->auth_servers;
 		if (radius_change_server(radius, conf->auth_server, oserv,
-					 radius->auth_serv_sock,
-					 radius->auth_serv_sock6, 1) < 0) {
+					 1) < 0) {
 			conf->auth_server = oserv;
 			radius_change_server(radius, oserv, conf->auth_server,
-					     radius->auth_serv_sock,
-					     radius->auth_serv_sock6, 1);
+					     1);
 		}
 	}
 
-	if (radius->acct_sock >= 0 && conf->acct_servers &&
+	if (radius_client_has_sock(radius, RADIUS_ACCT) && conf->acct_servers &&
 	    conf->acct_server != conf->acct_servers) {
 		oserv = conf->acct_server;
 		conf->acct_server = conf->acct_servers;
 		if (radius_change_server(radius, conf->acct_server, oserv,
-					 radius->acct_serv_sock,
-					 radius->acct_serv_sock6, 0) < 0) {
+					 0) < 0) {
 			conf->acct_server = oserv;
 			radius_change_server(radius, oserv, conf->acct_server,
-					     radius->acct_serv_sock,
-					     radius->acct_serv_sock6, 0);
+					     0);
 		}
 	}
 
+	radius_client_send_queued(radius);
+
 	if (conf->retry_primary_interval)
 		eloop_register_timeout(conf->retry_primary_interval, 0,
 				       radius_retry_primary_timer, radius,
@@ -1223,156 +1399,162 @@ static int radius_client_disable_pmtu_discovery(int s)
 }
 
 
-static void radius_close_auth_sockets(struct radius_client_data *radius)
+static void radius_close_sock(struct radius_client_sock *rsock)
 {
-	radius->auth_sock = -1;
+	rsock->sock = -1;
 
-	if (radius->auth_serv_sock >= 0) {
-		eloop_unregister_read_sock(radius->auth_serv_sock);
-		close(radius->auth_serv_sock);
-		radius->auth_serv_sock = -1;
+	if (rsock->serv_sock >= 0) {
+		eloop_unregister_read_sock(rsock->serv_sock);
+		close(rsock->serv_sock);
+		rsock->serv_sock = -1;
 	}
 #ifdef CONFIG_IPV6
-	if (radius->auth_serv_sock6 >= 0) {
-		eloop_unregister_read_sock(radius->auth_serv_sock6);
-		close(radius->auth_serv_sock6);
-		radius->auth_serv_sock6 = -1;
+	if (rsock->serv_sock6 >= 0) {
+		eloop_unregister_read_sock(rsock->serv_sock6);
+		close(rsock->serv_sock6);
+		rsock->serv_sock6 = -1;
 	}
 #endif /* CONFIG_IPV6 */
 }
 
 
+static void radius_close_auth_sockets(struct radius_client_data *radius)
+{
+	size_t i;
+
+	for (i = 0; i < radius->num_socks; i++)
+		radius_close_sock(&radius->auth_socks[i]);
+}
+
+
 static void radius_close_acct_sockets(struct radius_client_data *radius)
 {
-	radius->acct_sock = -1;
+	size_t i;
 
-	if (radius->acct_serv_sock >= 0) {
-		eloop_unregister_read_sock(radius->acct_serv_sock);
-		close(radius->acct_serv_sock);
-		radius->acct_serv_sock = -1;
-	}
-#ifdef CONFIG_IPV6
-	if (radius->acct_serv_sock6 >= 0) {
-		eloop_unregister_read_sock(radius->acct_serv_sock6);
-		close(radius->acct_serv_sock6);
-		radius->acct_serv_sock6 = -1;
-	}
-#endif /* CONFIG_IPV6 */
+	for (i = 0; i < radius->num_socks; i++)
+		radius_close_sock(&radius->acct_socks[i]);
 }
 
 
-static int radius_client_init_auth(struct radius_client_data *radius)
+static int radius_open_sock(struct radius_client_sock *rsock)
 {
-	struct hostapd_radius_servers *conf = radius->conf;
 	int ok = 0;
 
-	radius_close_auth_sockets(radius);
-
-	radius->auth_serv_sock = socket(PF_INET, SOCK_DGRAM, 0);
-	if (radius->auth_serv_sock < 0)
+	rsock->serv_sock = socket(PF_INET, SOCK_DGRAM, 0);
+	if (rsock->serv_sock < 0)
 		wpa_printf(MSG_INFO, "RADIUS: socket[PF_INET,SOCK_DGRAM]: %s",
 			   strerror(errno));
 	else {
-		radius_client_disable_pmtu_discovery(radius->auth_serv_sock);
+		radius_client_disable_pmtu_discovery(rsock->serv_sock);
 		ok++;
 	}
 
 #ifdef CONFIG_IPV6
-	radius->auth_serv_sock6 = socket(PF_INET6, SOCK_DGRAM, 0);
-	if (radius->auth_serv_sock6 < 0)
+	rsock->serv_sock6 = socket(PF_INET6, SOCK_DGRAM, 0);
+	if (rsock->serv_sock6 < 0)
 		wpa_printf(MSG_INFO, "RADIUS: socket[PF_INET6,SOCK_DGRAM]: %s",
 			   strerror(errno));
 	else
 		ok++;
 #endif /* CONFIG_IPV6 */
 
-	if (ok == 0)
-		return -1;
+	return ok ? 0 : -1;
+}
 
-	radius_change_server(radius, conf->auth_server, NULL,
-			     radius->auth_serv_sock, radius->auth_serv_sock6,
-			     1);
 
-	if (radius->auth_serv_sock >= 0 &&
-	    eloop_register_read_sock(radius->auth_serv_sock,
-				     radius_client_receive, radius,
-				     (void *) RADIUS_AUTH)) {
-		wpa_printf(MSG_INFO, "RADIUS: Could not register read socket for authentication server");
-		radius_close_auth_sockets(radius);
+static int radius_register_sock(struct radius_client_data *radius,
+				struct radius_client_sock *rsock)
+{
+	if (rsock->serv_sock >= 0 &&
+	    eloop_register_read_sock(rsock->serv_sock, radius_client_receive,
+				     radius, rsock))
 		return -1;
-	}
 
 #ifdef CONFIG_IPV6
-	if (radius->auth_serv_sock6 >= 0 &&
-	    eloop_register_read_sock(radius->auth_serv_sock6,
-				     radius_client_receive, radius,
-				     (void *) RADIUS_AUTH)) {
-		wpa_printf(MSG_INFO, "RADIUS: Could not register read socket for authentication server");
-		radius_close_auth_sockets(radius);
+	if (rsock->serv_sock6 >= 0 &&
+	    eloop_register_read_sock(rsock->serv_sock6, radius_client_receive,
+				     radius, rsock))
 		return -1;
-	}
 #endif /* CONFIG_IPV6 */
 
 	return 0;
 }
 
 
-static int radius_client_init_acct(struct radius_client_data *radius)
+static int radius_client_init_auth(struct radius_client_data *radius)
 {
 	struct hostapd_radius_servers *conf = radius->conf;
-	int ok = 0;
+	size_t i;
 
-	radius_close_acct_sockets(radius);
+	radius_close_auth_sockets(radius);
 
-	radius->acct_serv_sock = socket(PF_INET, SOCK_DGRAM, 0);
-	if (radius->acct_serv_sock < 0)
-		wpa_printf(MSG_INFO, "RADIUS: socket[PF_INET,SOCK_DGRAM]: %s",
-			   strerror(errno));
-	else {
-		radius_client_disable_pmtu_discovery(radius->acct_serv_sock);
-		ok++;
+	for (i = 0; i < radius->num_socks; i++) {
+		if (radius_open_sock(&radius->auth_socks[i]) < 0) {
+			radius_close_auth_sockets(radius);
+			return -1;
+		}
 	}
 
-#ifdef CONFIG_IPV6
-	radius->acct_serv_sock6 = socket(PF_INET6, SOCK_DGRAM, 0);
-	if (radius->acct_serv_sock6 < 0)
-		wpa_printf(MSG_INFO, "RADIUS: socket[PF_INET6,SOCK_DGRAM]: %s",
-			   strerror(errno));
-	else
-		ok++;
-#endif /* CONFIG_IPV6 */
+	radius_change_server(radius, conf->auth_server, NULL, 1);
 
-	if (ok == 0)
-		return -1;
+	for (i = 0; i < radius->num_socks; i++) {
+		if (radius_register_sock(radius, &radius->auth_socks[i])) {
+			wpa_printf(MSG_INFO, "RADIUS: Could not register read socket for authentication server");
+			radius_close_auth_sockets(radius);
+			return -1;
+		}
+	}
 
-	radius_change_server(radius, conf->acct_server, NULL,
-			     radius->acct_serv_sock, radius->acct_serv_sock6,
-			     0);
+	return 0;
+}
 
-	if (radius->acct_serv_sock >= 0 &&
-	    eloop_register_read_sock(radius->acct_serv_sock,
-				     radius_client_receive, radius,
-				     (void *) RADIUS_ACCT)) {
-		wpa_printf(MSG_INFO, "RADIUS: Could not register read socket for accounting server");
-		radius_close_acct_sockets(radius);
-		return -1;
+
+static int radius_client_init_acct(struct radius_client_data *radius)
+{
+	struct hostapd_radius_servers *conf = radius->conf;
+	size_t i;
+
+	radius_close_acct_sockets(radius);
+
+	for (i = 0; i < radius->num_socks; i++) {
+		if (radius_open_sock(&radius->acct_socks[i]) < 0) {
+			radius_close_acct_sockets(radius);
+			return -1;
+		}
 	}
 
-#ifdef CONFIG_IPV6
-	if (radius->acct_serv_sock6 >= 0 &&
-	    eloop_register_read_sock(radius->acct_serv_sock6,
-				     radius_client_receive, radius,
-				     (void *) RADIUS_ACCT)) {
-		wpa_printf(MSG_INFO, "RADIUS: Could not register read socket for accounting server");
-		radius_close_acct_sockets(radius);
-		return -1;
+	radius_change_server(radius, conf->acct_server, NULL, 0);
+
+	for (i = 0; i < radius->num_socks; i++) {
+		if (radius_register_sock(radius, &radius->acct_socks[i])) {
+			wpa_printf(MSG_INFO, "RADIUS: Could not register read socket for accounting server");
+			radius_close_acct_sockets(radius);
+			return -1;
+		}
 	}
-#endif /* CONFIG_IPV6 */
 
 	return 0;
 }
 
 
+static struct radius_client_sock *
+radius_client_alloc_socks(size_t num, RadiusType msg_type)
+{
+	struct radius_client_sock *socks;
+	size_t i;
+
+	socks = os_calloc(num, sizeof(*socks));
+	if (socks == NULL)
+		return NULL;
+	for (i = 0; i < num; i++) {
+		socks[i].serv_sock = socks[i].serv_sock6 = socks[i].sock = -1;
+		socks[i].msg_type = msg_type;
+	}
+
+	return socks;
+}
+
+
 /**
  * radius_client_init - Initialize RADIUS client
  * @ctx: Callback context to be used in hostapd_logger() calls
@@ -1394,9 +1576,25 @@ radius_client_init(void *ctx, struct hostapd_radius_servers *conf)
 
 	radius->ctx = ctx;
 	radius->conf = conf;
-	radius->auth_serv_sock = radius->acct_serv_sock =
-		radius->auth_serv_sock6 = radius->acct_serv_sock6 =
-		radius->auth_sock = radius->acct_sock = -1;
+	dl_list_init(&radius->msgs);
+	dl_list_init(&radius->queue);
+
+	radius->num_socks = conf->client_ports > 0 ? conf->client_ports : 1;
+	if (radius->num_socks > RADIUS_CLIENT_MAX_PORTS)
+		radius->num_socks = RADIUS_CLIENT_MAX_PORTS;
+	radius->max_pending = conf->max_pending > 0 ? conf->max_pending :
+		RADIUS_CLIENT_MAX_ENTRIES;
+	if (radius->max_pending > radius->num_socks * 256)
+		radius->max_pending = radius->num_socks * 256;
+
+	radius->auth_socks = radius_client_alloc_socks(radius->num_socks,
+						       RADIUS_AUTH);
+	radius->acct_socks = radius_client_alloc_socks(radius->num_socks,
+						       RADIUS_ACCT);
+	if (radius->auth_socks == NULL || radius->acct_socks == NULL) {
+		radius_client_deinit(radius);
+		return NULL;
+	}
 
 	if (conf->auth_server && radius_client_init_auth(radius)) {
 		radius_client_deinit(radius);
@@ -1426,12 +1624,16 @@ void radius_client_deinit(struct radius_client_data *radius)
 	if (!radius)
 		return;
 
-	radius_close_auth_sockets(radius);
-	radius_close_acct_sockets(radius);
+	if (radius->auth_socks)
+		radius_close_auth_sockets(radius);
+	if (radius->acct_socks)
+		radius_close_acct_sockets(radius);
 
 	eloop_cancel_timeout(radius_retry_primary_timer, radius, NULL);
 
 	radius_client_flush(radius, 0);
+	os_free(radius->auth_socks);
+	os_free(radius->acct_socks);
 	os_free(radius->auth_handlers);
 	os_free(radius->acct_handlers);
 	os_free(radius);
@@ -1451,11 +1653,10 @@ void radius_client_deinit(struct radius_client_data *radius)
 void radius_client_flush_auth(struct radius_client_data *radius,
 			      const u8 *addr)
 {
-	struct radius_msg_list *entry, *prev, *tmp;
+	struct radius_msg_list *entry, *tmp;
 
-	prev = NULL;
-	entry = radius->msgs;
-	while (entry) {
+	dl_list_for_each_safe(entry, tmp, &radius->msgs,
+			      struct radius_msg_list, list) {
 		if (entry->msg_type == RADIUS_AUTH &&
 		    os_memcmp(entry->addr, addr, ETH_ALEN) == 0) {
 			hostapd_logger(radius->ctx, addr,
@@ -1463,22 +1664,11 @@ void radius_client_flush_auth(struct radius_client_data *radius,
 				       HOSTAPD_LEVEL_DEBUG,
 				       "Removing pending RADIUS authentication"
 				       " message for removed client");
-
-			if (prev)
-				prev->next = entry->next;
-			else
-				radius->msgs = entry->next;
-
-			tmp = entry;
-			entry = entry->next;
-			radius_client_msg_free(tmp);
-			radius->num_msgs--;
-			continue;
+			radius_client_msg_remove(radius, entry);
 		}
-
-		prev = entry;
-		entry = entry->next;
 	}
+
+	radius_client_send_queued(radius);
 }
 
 
@@ -1491,7 +1681,8 @@ static int radius_client_dump_auth_server(char *buf, size_t buflen,
 	char abuf[50];
 
 	if (cli) {
-		for (msg = cli->msgs; msg; msg = msg->next) {
+		dl_list_for_each(msg, &cli->msgs, struct radius_msg_list,
+				 list) {
 			if (msg->msg_type == RADIUS_AUTH)
 				pending++;
 		}
@@ -1540,7 +1731,8 @@ static int radius_client_dump_acct_server(char *buf, size_t buflen,
 	char abuf[50];
 
 	if (cli) {
-		for (msg = cli->msgs; msg; msg = msg->next) {
+		dl_list_for_each(msg, &cli->msgs, struct radius_msg_list,
+				 list) {
 			if (msg->msg_type == RADIUS_ACCT ||
 			    msg->msg_type == RADIUS_ACCT_INTERIM)
 				pending++;
@@ -174,6 +174,23 @@ struct hostapd_radius_servers {
 	 * force_client_addr - Whether to force client (local) address
 	 */
 	int force_client_addr;
+
+	/**
+	 * client_ports - Number of source ports per server type
+	 *
+	 * Each source port has its own 8-bit RADIUS Identifier space, so more
+	 * than one port is needed to have over 256 requests pending at the
+	 * same time. 0 means one port.
+	 */
+	int client_ports;
+
+	/**
+	 * max_pending - Maximum number of requests waiting for a response
+	 *
+	 * Requests exceeding this limit are queued and sent once a response to
+	 * an earlier request is received. 0 means the default limit.
+	 */
+	int max_pending;
 };
 
 
@@ -245,6 +262,7 @@ int radius_client_send(struct radius_client_data *radius,
 		       struct radius_msg *msg,
 		       RadiusType msg_type, const u8 *addr);
 u8 radius_client_get_id(struct radius_client_data *radius);
+size_t radius_client_acct_pending(struct radius_client_data *radius);
 void radius_client_flush(struct radius_client_data *radius, int only_auth);
 struct radius_client_data *
 radius_client_init(void *ctx, struct hostapd_radius_servers *conf);
@@ -159,6 +159,52 @@ int hwaddr_aton2(const char *txt, u8 *addr)
 }
 
 
+#define SIPROUND(v0, v1, v2, v3)			\
+	do {						\
+		v0 += v1; v1 = (v1 << 13) | (v1 >> 51);	\
+		v1 ^= v0; v0 = (v0 << 32) | (v0 >> 32);	\
+		v2 += v3; v3 = (v3 << 16) | (v3 >> 48);	\
+		v3 ^= v2;				\
+		v0 += v3; v3 = (v3 << 21) | (v3 >> 43);	\
+		v3 ^= v0;				\
+		v2 += v1; v1 = (v1 << 17) | (v1 >> 47);	\
+		v1 ^= v2; v2 = (v2 << 32) | (v2 >> 32);	\
+	} while (0)
+
+/**
+ * hwaddr_hash - Keyed hash of a MAC address
+ * @key: 16-octet secret key
+ * @addr: MAC address (ETH_ALEN = 6 bytes)
+ * Returns: Hash value
+ *
+ * This is SipHash-1-3 over the six address octets. Using a random per-table
+ * key keeps sequential or attacker-chosen addresses from ending up in the
+ * same hash bucket.
+ */
+u32 hwaddr_hash(const u8 *key, const u8 *addr)
+{
+	u64 k0 = WPA_GET_LE64(key), k1 = WPA_GET_LE64(key + 8);
+	u64 v0 = k0 ^ 0x736f6d6570736575ULL;
+	u64 v1 = k1 ^ 0x646f72616e646f6dULL;
+	u64 v2 = k0 ^ 0x6c7967656e657261ULL;
+	u64 v3 = k1 ^ 0x7465646279746573ULL;
+	u64 b;
+
+	b = ((u64) ETH_ALEN << 56) | ((u64) addr[5] << 40) |
+		((u64) addr[4] << 32) | ((u64) WPA_GET_LE32(addr));
+	v3 ^= b;
+	SIPROUND(v0, v1, v2, v3);
+	v0 ^= b;
+	v2 ^= 0xff;
+	SIPROUND(v0, v1, v2, v3);
+	SIPROUND(v0, v1, v2, v3);
+	SIPROUND(v0, v1, v2, v3);
+	b = v0 ^ v1 ^ v2 ^ v3;
+
+	return (u32) (b ^ (b >> 32));
+}
+
+
 /**
  * hexstr2bin - Convert ASCII hex string into binary data
  * @hex: ASCII hex string (e.g., "01ab")
@@ -28,6 +28,7 @@
 
 #ifdef CONFIG_ELOOP_EPOLL
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
 #endif /* CONFIG_ELOOP_EPOLL */
 
 struct eloop_sock {
@@ -35,14 +36,21 @@ struct eloop_sock {
 	void *eloop_data;
 	void *user_data;
 	eloop_sock_handler handler;
+	unsigned int budget; /* max handler calls per wakeup (edge-triggered) */
+	unsigned long dispatched;
+	unsigned long latency[ELOOP_LATENCY_BUCKETS];
+	unsigned int max_latency_us;
 	WPA_TRACE_REF(eloop);
 	WPA_TRACE_REF(user);
 	WPA_TRACE_INFO
 };
 
 struct eloop_timeout {
-	struct dl_list list;
+	struct dl_list list; /* entry in the (handler, eloop_data, user_data)
+			      * hash bucket */
 	struct os_reltime time;
+	unsigned int seq; /* registration order for timeouts with equal time */
+	int heap_idx;
 	void *eloop_data;
 	void *user_data;
 	eloop_timeout_handler handler;
@@ -51,6 +59,18 @@ struct eloop_timeout {
 	WPA_TRACE_INFO
 };
 
+/*
+ * Timeout records are carved out of chunks that are kept for the lifetime of
+ * the event loop so that registering and expiring timeouts in steady state
+ * does not hit the heap allocator.
+ */
+#define ELOOP_TIMEOUT_CHUNK_SIZE 64
+
+struct eloop_timeout_chunk {
+	struct eloop_timeout_chunk *next;
+	struct eloop_timeout timeouts[ELOOP_TIMEOUT_CHUNK_SIZE];
+};
+
 struct eloop_signal {
 	int sig;
 	void *user_data;
@@ -60,6 +80,7 @@ struct eloop_signal {
 
 struct eloop_sock_table {
 	int count;
+	int max; /* number of entries allocated in table */
 	struct eloop_sock *table;
 	eloop_event_type type;
 	int changed;
@@ -81,12 +102,36 @@ struct eloop_data {
 	int epoll_max_fd;
 	struct eloop_sock *epoll_table;
 	struct epoll_event *epoll_events;
+	int timerfd; /* timeout wakeups or -1 to use the epoll_wait timeout */
+	int timerfd_armed;
+	struct os_reltime timerfd_time;
 #endif /* CONFIG_ELOOP_EPOLL */
 	struct eloop_sock_table readers;
 	struct eloop_sock_table writers;
 	struct eloop_sock_table exceptions;
 
-	struct dl_list timeout;
+	/*
+	 * Pending timeouts are kept in a binary min-heap ordered by expiration
+	 * time and indexed by a hash on (handler, eloop_data, user_data) so
+	 * that registration, cancellation and lookups do not need to walk all
+	 * pending timeouts.
+	 */
+	struct eloop_timeout **timeout_heap;
+	int timeout_count;
+	int timeout_heap_size;
+	struct dl_list *timeout_hash;
+	unsigned int timeout_hash_size; /* power of two */
+	unsigned int timeout_seq;
+
+	struct eloop_timeout_chunk *timeout_chunks;
+	struct dl_list timeout_free;
+	unsigned int timeout_pool_size;
+	unsigned int timeout_pool_free;
+	unsigned long timeout_allocs;
+	unsigned long timeout_pool_grows;
+	unsigned long sock_table_grows;
+	unsigned long wakeups;
+	unsigned long timer_wakeups;
 
 	int signal_count;
 	struct eloop_signal *signals;
@@ -142,10 +187,42 @@ static void eloop_trace_sock_remove_ref(struct eloop_sock_table *table)
 #endif /* WPA_TRACE */
 
 
+#ifdef CONFIG_ELOOP_EPOLL
+
+static void eloop_timerfd_init(void)
+{
+	struct epoll_event ev;
+
+	eloop.epoll_events = os_calloc(8, sizeof(struct epoll_event));
+	if (eloop.epoll_events)
+		eloop.epoll_max_event_num = 8;
+
+	eloop.timerfd = timerfd_create(CLOCK_MONOTONIC,
+				       TFD_NONBLOCK | TFD_CLOEXEC);
+	if (eloop.timerfd < 0) {
+		wpa_printf(MSG_DEBUG, "eloop: timerfd_create failed: %s",
+			   strerror(errno));
+		return;
+	}
+
+	os_memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = eloop.timerfd;
+	if (eloop.epoll_events == NULL ||
+	    epoll_ctl(eloop.epollfd, EPOLL_CTL_ADD, eloop.timerfd, &ev) < 0) {
+		wpa_printf(MSG_DEBUG, "eloop: Could not add timerfd to epoll");
+		close(eloop.timerfd);
+		eloop.timerfd = -1;
+	}
+}
+
+#endif /* CONFIG_ELOOP_EPOLL */
+
+
 int eloop_init(void)
 {
 	os_memset(&eloop, 0, sizeof(eloop));
-	dl_list_init(&eloop.timeout);
+	dl_list_init(&eloop.timeout_free);
 #ifdef CONFIG_ELOOP_EPOLL
 	eloop.epollfd = epoll_create1(0);
 	if (eloop.epollfd < 0) {
@@ -156,6 +233,7 @@ int eloop_init(void)
 	eloop.readers.type = EVENT_TYPE_READ;
 	eloop.writers.type = EVENT_TYPE_WRITE;
 	eloop.exceptions.type = EVENT_TYPE_EXCEPTION;
+	eloop_timerfd_init();
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef WPA_TRACE
 	signal(SIGSEGV, eloop_sigsegv_handler);
@@ -220,7 +298,8 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 		eloop.epoll_table = temp_table;
 	}
 
-	if (eloop.count + 1 > eloop.epoll_max_event_num) {
+	/* Leave room for the timerfd event */
+	if (eloop.count + 2 > eloop.epoll_max_event_num) {
 		next = eloop.epoll_max_event_num == 0 ? 8 :
 			eloop.epoll_max_event_num * 2;
 		temp_events = os_realloc_array(eloop.epoll_events, next,
@@ -237,13 +316,21 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 #endif /* CONFIG_ELOOP_EPOLL */
 
 	eloop_trace_sock_remove_ref(table);
-	tmp = os_realloc_array(table->table, table->count + 1,
-			       sizeof(struct eloop_sock));
-	if (tmp == NULL) {
-		eloop_trace_sock_add_ref(table);
-		return -1;
+	tmp = table->table;
+	if (table->count == table->max) {
+		int next = table->max ? table->max * 2 : 4;
+
+		tmp = os_realloc_array(table->table, next,
+				       sizeof(struct eloop_sock));
+		if (tmp == NULL) {
+			eloop_trace_sock_add_ref(table);
+			return -1;
+		}
+		table->max = next;
+		eloop.sock_table_grows++;
 	}
 
+	os_memset(&tmp[table->count], 0, sizeof(struct eloop_sock));
 	tmp[table->count].sock = sock;
 	tmp[table->count].eloop_data = eloop_data;
 	tmp[table->count].user_data = user_data;
@@ -322,6 +409,37 @@ static void eloop_sock_table_remove_sock(struct eloop_sock_table *table,
 }
 
 
+static unsigned int eloop_call_sock_handler(struct eloop_sock *sock)
+{
+	struct os_reltime start, end;
+
+	os_get_reltime(&start);
+	sock->handler(sock->sock, sock->eloop_data, sock->user_data);
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &end);
+
+	return end.sec * 1000000 + end.usec;
+}
+
+
+static void eloop_sock_account(struct eloop_sock *sock, unsigned int usec)
+{
+	unsigned int limit = 10;
+	int i;
+
+	/* Buckets: <10 us, <100 us, <1 ms, <10 ms, <100 ms, longer */
+	for (i = 0; i < ELOOP_LATENCY_BUCKETS - 1; i++) {
+		if (usec < limit)
+			break;
+		limit *= 10;
+	}
+	sock->latency[i]++;
+	sock->dispatched++;
+	if (usec > sock->max_latency_us)
+		sock->max_latency_us = usec;
+}
+
+
 #ifdef CONFIG_ELOOP_POLL
 
 static struct pollfd * find_pollfd(struct pollfd **pollfds_map, int fd, int mx)
@@ -416,6 +534,7 @@ static int eloop_sock_table_dispatch_table(struct eloop_sock_table *table,
 {
 	int i;
 	struct pollfd *pfd;
+	unsigned int usec;
 
 	if (!table || !table->table)
 		return 0;
@@ -430,11 +549,10 @@ static int eloop_sock_table_dispatch_table(struct eloop_sock_table *table,
 		if (!(pfd->revents & revents))
 			continue;
 
-		table->table[i].handler(table->table[i].sock,
-					table->table[i].eloop_data,
-					table->table[i].user_data);
+		usec = eloop_call_sock_handler(&table->table[i]);
 		if (table->changed)
 			return 1;
+		eloop_sock_account(&table->table[i], usec);
 	}
 
 	return 0;
@@ -492,11 +610,12 @@ static void eloop_sock_table_dispatch(struct eloop_sock_table *table,
 	table->changed = 0;
 	for (i = 0; i < table->count; i++) {
 		if (FD_ISSET(table->table[i].sock, fds)) {
-			table->table[i].handler(table->table[i].sock,
-						table->table[i].eloop_data,
-						table->table[i].user_data);
+			unsigned int usec;
+
+			usec = eloop_call_sock_handler(&table->table[i]);
 			if (table->changed)
 				break;
+			eloop_sock_account(&table->table[i], usec);
 		}
 	}
 }
@@ -505,23 +624,98 @@ static void eloop_sock_table_dispatch(struct eloop_sock_table *table,
 
 
 #ifdef CONFIG_ELOOP_EPOLL
+
+static int eloop_sock_table_changed(void)
+{
+	return eloop.readers.changed || eloop.writers.changed ||
+		eloop.exceptions.changed;
+}
+
+
+static void eloop_sock_rearm(int fd)
+{
+	struct epoll_event ev;
+
+	os_memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.fd = fd;
+	epoll_ctl(eloop.epollfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+
+/*
+ * Events that are skipped because a handler changed the socket tables would
+ * be lost for edge-triggered sockets. Re-arming them makes epoll report them
+ * again on the next wakeup if they are still readable.
+ */
+static void eloop_sock_rearm_skipped(struct epoll_event *events, int nfds)
+{
+	int i;
+
+	for (i = 0; i < nfds; i++) {
+		int fd = events[i].data.fd;
+
+		if (fd < eloop.epoll_max_fd &&
+		    eloop.epoll_table[fd].handler &&
+		    eloop.epoll_table[fd].budget)
+			eloop_sock_rearm(fd);
+	}
+}
+
+
 static void eloop_sock_table_dispatch(struct epoll_event *events, int nfds)
 {
 	struct eloop_sock *table;
 	int i;
 
 	for (i = 0; i < nfds; i++) {
-		table = &eloop.epoll_table[events[i].data.fd];
+		int fd = events[i].data.fd;
+		eloop_sock_handler handler;
+		unsigned int calls = 0, usec;
+		int err;
+
+		table = &eloop.epoll_table[fd];
 		if (table->handler == NULL)
 			continue;
-		table->handler(table->sock, table->eloop_data,
-			       table->user_data);
-		if (eloop.readers.changed ||
-		    eloop.writers.changed ||
-		    eloop.exceptions.changed)
-			break;
+		handler = table->handler;
+
+		/*
+		 * Edge-triggered sockets (budget > 0) are drained here since
+		 * epoll will not report them again until new data arrives.
+		 * The handler's read failing with EAGAIN tells that the
+		 * socket is empty, so readiness is not polled between calls.
+		 */
+		for (;;) {
+			errno = 0;
+			usec = eloop_call_sock_handler(table);
+			err = errno;
+			calls++;
+			if (eloop_sock_table_changed()) {
+				/* epoll_table may have been reallocated */
+				table = &eloop.epoll_table[fd];
+				if (fd < eloop.epoll_max_fd &&
+				    table->handler == handler)
+					eloop_sock_account(table, usec);
+				eloop_sock_rearm_skipped(&events[i], nfds - i);
+				return;
+			}
+			eloop_sock_account(table, usec);
+			if (table->budget == 0 || err == EAGAIN ||
+			    err == EWOULDBLOCK)
+				break;
+			if (calls >= table->budget) {
+				/*
+				 * Out of budget; re-arming the edge-triggered
+				 * socket makes epoll report it again on the
+				 * next wakeup.
+				 */
+				eloop_sock_rearm(fd);
+				break;
+			}
+		}
 	}
 }
+
 #endif /* CONFIG_ELOOP_EPOLL */
 
 
@@ -543,6 +737,9 @@ static void eloop_sock_table_destroy(struct eloop_sock_table *table)
 			wpa_trace_dump("eloop sock", &table->table[i]);
 		}
 		os_free(table->table);
+		table->table = NULL;
+		table->count = 0;
+		table->max = 0;
 	}
 }
 
@@ -598,52 +795,282 @@ void eloop_unregister_sock(int sock, eloop_event_type type)
 }
 
 
+static struct eloop_timeout * eloop_alloc_timeout(void)
+{
+	struct eloop_timeout *timeout;
+
+	if (dl_list_empty(&eloop.timeout_free)) {
+		struct eloop_timeout_chunk *chunk;
+		int i;
+
+		chunk = os_zalloc(sizeof(*chunk));
+		if (chunk == NULL)
+			return NULL;
+		chunk->next = eloop.timeout_chunks;
+		eloop.timeout_chunks = chunk;
+		for (i = 0; i < ELOOP_TIMEOUT_CHUNK_SIZE; i++)
+			dl_list_add_tail(&eloop.timeout_free,
+					 &chunk->timeouts[i].list);
+		eloop.timeout_pool_size += ELOOP_TIMEOUT_CHUNK_SIZE;
+		eloop.timeout_pool_free += ELOOP_TIMEOUT_CHUNK_SIZE;
+		eloop.timeout_pool_grows++;
+	}
+
+	timeout = dl_list_first(&eloop.timeout_free, struct eloop_timeout,
+				list);
+	dl_list_del(&timeout->list);
+	eloop.timeout_pool_free--;
+	eloop.timeout_allocs++;
+	os_memset(timeout, 0, sizeof(*timeout));
+
+	return timeout;
+}
+
+
+static void eloop_free_timeout(struct eloop_timeout *timeout)
+{
+	dl_list_add(&eloop.timeout_free, &timeout->list);
+	eloop.timeout_pool_free++;
+}
+
+
+static void eloop_free_timeout_pool(void)
+{
+	struct eloop_timeout_chunk *chunk, *next;
+
+	for (chunk = eloop.timeout_chunks; chunk; chunk = next) {
+		next = chunk->next;
+		os_free(chunk);
+	}
+	eloop.timeout_chunks = NULL;
+	dl_list_init(&eloop.timeout_free);
+	eloop.timeout_pool_size = 0;
+	eloop.timeout_pool_free = 0;
+}
+
+
+#define ELOOP_TIMEOUT_HASH_MIN 64
+
+static unsigned int eloop_timeout_hash(eloop_timeout_handler handler,
+				       void *eloop_data, void *user_data)
+{
+	unsigned long h;
+
+	h = (unsigned long) handler;
+	h = h * 31 + (unsigned long) eloop_data;
+	h = h * 31 + (unsigned long) user_data;
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	h ^= h >> 16;
+
+	return h & (eloop.timeout_hash_size - 1);
+}
+
+
+static struct dl_list * eloop_timeout_bucket(eloop_timeout_handler handler,
+					     void *eloop_data, void *user_data)
+{
+	return &eloop.timeout_hash[eloop_timeout_hash(handler, eloop_data,
+						      user_data)];
+}
+
+
+static int eloop_timeout_before(struct eloop_timeout *a,
+				struct eloop_timeout *b)
+{
+	if (a->time.sec != b->time.sec || a->time.usec != b->time.usec)
+		return os_reltime_before(&a->time, &b->time);
+	/* Keep FIFO order for timeouts that expire at the same time */
+	return (int) (a->seq - b->seq) < 0;
+}
+
+
+static void eloop_timeout_heap_set(int idx, struct eloop_timeout *timeout)
+{
+	eloop.timeout_heap[idx] = timeout;
+	timeout->heap_idx = idx;
+}
+
+
+static void eloop_timeout_sift_up(int idx)
+{
+	struct eloop_timeout *timeout = eloop.timeout_heap[idx];
+
+	while (idx > 0) {
+		int parent = (idx - 1) / 2;
+
+		if (!eloop_timeout_before(timeout, eloop.timeout_heap[parent]))
+			break;
+		eloop_timeout_heap_set(idx, eloop.timeout_heap[parent]);
+		idx = parent;
+	}
+	eloop_timeout_heap_set(idx, timeout);
+}
+
+
+static void eloop_timeout_sift_down(int idx)
+{
+	struct eloop_timeout *timeout = eloop.timeout_heap[idx];
+
+	for (;;) {
+		int child = 2 * idx + 1;
+
+		if (child >= eloop.timeout_count)
+			break;
+		if (child + 1 < eloop.timeout_count &&
+		    eloop_timeout_before(eloop.timeout_heap[child + 1],
+					 eloop.timeout_heap[child]))
+			child++;
+		if (!eloop_timeout_before(eloop.timeout_heap[child], timeout))
+			break;
+		eloop_timeout_heap_set(idx, eloop.timeout_heap[child]);
+		idx = child;
+	}
+	eloop_timeout_heap_set(idx, timeout);
+}
+
+
+static struct eloop_timeout * eloop_first_timeout(void)
+{
+	if (eloop.timeout_count == 0)
+		return NULL;
+	return eloop.timeout_heap[0];
+}
+
+
+static int eloop_timeout_hash_resize(unsigned int size)
+{
+	struct dl_list *hash;
+	unsigned int i;
+	int j;
+
+	hash = os_calloc(size, sizeof(struct dl_list));
+	if (hash == NULL)
+		return -1;
+	for (i = 0; i < size; i++)
+		dl_list_init(&hash[i]);
+
+	os_free(eloop.timeout_hash);
+	eloop.timeout_hash = hash;
+	eloop.timeout_hash_size = size;
+
+	for (j = 0; j < eloop.timeout_count; j++) {
+		struct eloop_timeout *timeout = eloop.timeout_heap[j];
+
+		dl_list_add(eloop_timeout_bucket(timeout->handler,
+						 timeout->eloop_data,
+						 timeout->user_data),
+			    &timeout->list);
+	}
+
+	return 0;
+}
+
+
+static int eloop_timeout_reserve(void)
+{
+	if (eloop.timeout_count == eloop.timeout_heap_size) {
+		struct eloop_timeout **heap;
+		int size = eloop.timeout_heap_size ?
+			eloop.timeout_heap_size * 2 : 16;
+
+		heap = os_realloc_array(eloop.timeout_heap, size,
+					sizeof(struct eloop_timeout *));
+		if (heap == NULL)
+			return -1;
+		eloop.timeout_heap = heap;
+		eloop.timeout_heap_size = size;
+	}
+
+	if (eloop.timeout_hash == NULL)
+		return eloop_timeout_hash_resize(ELOOP_TIMEOUT_HASH_MIN);
+	if ((unsigned int) eloop.timeout_count >= 2 * eloop.timeout_hash_size)
+		eloop_timeout_hash_resize(2 * eloop.timeout_hash_size);
+	/* A failed resize only makes the hash chains longer */
+
+	return 0;
+}
+
+
+static void eloop_insert_timeout(struct eloop_timeout *timeout)
+{
+	timeout->seq = eloop.timeout_seq++;
+	eloop.timeout_heap[eloop.timeout_count] = timeout;
+	eloop.timeout_count++;
+	eloop_timeout_sift_up(eloop.timeout_count - 1);
+	dl_list_add_tail(eloop_timeout_bucket(timeout->handler,
+					      timeout->eloop_data,
+					      timeout->user_data),
+			 &timeout->list);
+}
+
+
+/* Find the first pending timeout to expire with an exactly matching key */
+static struct eloop_timeout *
+eloop_find_timeout(eloop_timeout_handler handler, void *eloop_data,
+		   void *user_data)
+{
+	struct eloop_timeout *tmp, *found = NULL;
+
+	if (eloop.timeout_count == 0)
+		return NULL;
+
+	dl_list_for_each(tmp, eloop_timeout_bucket(handler, eloop_data,
+						   user_data),
+			 struct eloop_timeout, list) {
+		if (tmp->handler == handler &&
+		    tmp->eloop_data == eloop_data &&
+		    tmp->user_data == user_data &&
+		    (found == NULL || eloop_timeout_before(tmp, found)))
+			found = tmp;
+	}
+
+	return found;
+}
+
+
 int eloop_register_timeout(unsigned int secs, unsigned int usecs,
 			   eloop_timeout_handler handler,
 			   void *eloop_data, void *user_data)
 {
-	struct eloop_timeout *timeout, *tmp;
+	struct eloop_timeout *timeout;
+	struct os_reltime time;
 	os_time_t now_sec;
 
-	timeout = os_zalloc(sizeof(*timeout));
-	if (timeout == NULL)
-		return -1;
-	if (os_get_reltime(&timeout->time) < 0) {
-		os_free(timeout);
+	if (os_get_reltime(&time) < 0)
 		return -1;
-	}
-	now_sec = timeout->time.sec;
-	timeout->time.sec += secs;
-	if (timeout->time.sec < now_sec) {
+	now_sec = time.sec;
+	time.sec += secs;
+	if (time.sec < now_sec) {
 		/*
 		 * Integer overflow - assume long enough timeout to be assumed
 		 * to be infinite, i.e., the timeout would never happen.
 		 */
 		wpa_printf(MSG_DEBUG, "ELOOP: Too long timeout (secs=%u) to "
 			   "ever happen - ignore it", secs);
-		os_free(timeout);
 		return 0;
 	}
-	timeout->time.usec += usecs;
-	while (timeout->time.usec >= 1000000) {
-		timeout->time.sec++;
-		timeout->time.usec -= 1000000;
+	time.usec += usecs;
+	while (time.usec >= 1000000) {
+		time.sec++;
+		time.usec -= 1000000;
 	}
+
+	if (eloop_timeout_reserve() < 0)
+		return -1;
+	timeout = eloop_alloc_timeout();
+	if (timeout == NULL)
+		return -1;
+	timeout->time = time;
 	timeout->eloop_data = eloop_data;
 	timeout->user_data = user_data;
 	timeout->handler = handler;
+
 	wpa_trace_add_ref(timeout, eloop, eloop_data);
 	wpa_trace_add_ref(timeout, user, user_data);
 	wpa_trace_record(timeout);
 
-	/* Maintain timeouts in order of increasing time */
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (os_reltime_before(&timeout->time, &tmp->time)) {
-			dl_list_add(tmp->list.prev, &timeout->list);
-			return 0;
-		}
-	}
-	dl_list_add_tail(&eloop.timeout, &timeout->list);
+	eloop_insert_timeout(timeout);
 
 	return 0;
 }
@@ -651,21 +1078,31 @@ int eloop_register_timeout(unsigned int secs, unsigned int usecs,
 
 static void eloop_remove_timeout(struct eloop_timeout *timeout)
 {
+	int idx = timeout->heap_idx;
+
 	dl_list_del(&timeout->list);
+	eloop.timeout_count--;
+	if (idx != eloop.timeout_count) {
+		eloop_timeout_heap_set(idx,
+				       eloop.timeout_heap[eloop.timeout_count]);
+		eloop_timeout_sift_down(idx);
+		eloop_timeout_sift_up(idx);
+	}
 	wpa_trace_remove_ref(timeout, eloop, timeout->eloop_data);
 	wpa_trace_remove_ref(timeout, user, timeout->user_data);
-	os_free(timeout);
+	eloop_free_timeout(timeout);
 }
 
 
-int eloop_cancel_timeout(eloop_timeout_handler handler,
-			 void *eloop_data, void *user_data)
+static int eloop_cancel_timeout_bucket(struct dl_list *bucket,
+				       eloop_timeout_handler handler,
+				       void *eloop_data, void *user_data)
 {
 	struct eloop_timeout *timeout, *prev;
 	int removed = 0;
 
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
+	dl_list_for_each_safe(timeout, prev, bucket, struct eloop_timeout,
+			      list) {
 		if (timeout->handler == handler &&
 		    (timeout->eloop_data == eloop_data ||
 		     eloop_data == ELOOP_ALL_CTX) &&
@@ -680,46 +1117,87 @@ int eloop_cancel_timeout(eloop_timeout_handler handler,
 }
 
 
+int eloop_cancel_timeout(eloop_timeout_handler handler,
+			 void *eloop_data, void *user_data)
+{
+	unsigned int i;
+	int removed = 0;
+
+	if (eloop.timeout_count == 0)
+		return 0;
+
+	if (eloop_data != ELOOP_ALL_CTX && user_data != ELOOP_ALL_CTX)
+		return eloop_cancel_timeout_bucket(
+			eloop_timeout_bucket(handler, eloop_data, user_data),
+			handler, eloop_data, user_data);
+
+	/* Wildcard match - the hash cannot help, so check every bucket */
+	for (i = 0; i < eloop.timeout_hash_size; i++)
+		removed += eloop_cancel_timeout_bucket(&eloop.timeout_hash[i],
+						       handler, eloop_data,
+						       user_data);
+
+	return removed;
+}
+
+
+/*
+ * Move a pending timeout to expire after @requested from @now. This has the
+ * same result as cancelling all matching timeouts and registering a new one,
+ * but reuses the existing record.
+ */
+static void eloop_reschedule_timeout(struct eloop_timeout *timeout,
+				     struct os_reltime *now,
+				     struct os_reltime *requested)
+{
+	struct eloop_timeout *tmp, *prev;
+	struct dl_list *bucket;
+
+	bucket = eloop_timeout_bucket(timeout->handler, timeout->eloop_data,
+				      timeout->user_data);
+	dl_list_for_each_safe(tmp, prev, bucket, struct eloop_timeout, list) {
+		if (tmp != timeout && tmp->handler == timeout->handler &&
+		    tmp->eloop_data == timeout->eloop_data &&
+		    tmp->user_data == timeout->user_data)
+			eloop_remove_timeout(tmp);
+	}
+
+	timeout->time.sec = now->sec + requested->sec;
+	timeout->time.usec = now->usec + requested->usec;
+	while (timeout->time.usec >= 1000000) {
+		timeout->time.sec++;
+		timeout->time.usec -= 1000000;
+	}
+	timeout->seq = eloop.timeout_seq++;
+	eloop_timeout_sift_down(timeout->heap_idx);
+	eloop_timeout_sift_up(timeout->heap_idx);
+}
+
+
 int eloop_cancel_timeout_one(eloop_timeout_handler handler,
 			     void *eloop_data, void *user_data,
 			     struct os_reltime *remaining)
 {
-	struct eloop_timeout *timeout, *prev;
-	int removed = 0;
+	struct eloop_timeout *timeout;
 	struct os_reltime now;
 
 	os_get_reltime(&now);
 	remaining->sec = remaining->usec = 0;
 
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
-		if (timeout->handler == handler &&
-		    (timeout->eloop_data == eloop_data) &&
-		    (timeout->user_data == user_data)) {
-			removed = 1;
-			if (os_reltime_before(&now, &timeout->time))
-				os_reltime_sub(&timeout->time, &now, remaining);
-			eloop_remove_timeout(timeout);
-			break;
-		}
-	}
-	return removed;
+	timeout = eloop_find_timeout(handler, eloop_data, user_data);
+	if (timeout == NULL)
+		return 0;
+	if (os_reltime_before(&now, &timeout->time))
+		os_reltime_sub(&timeout->time, &now, remaining);
+	eloop_remove_timeout(timeout);
+	return 1;
 }
 
 
 int eloop_is_timeout_registered(eloop_timeout_handler handler,
 				void *eloop_data, void *user_data)
 {
-	struct eloop_timeout *tmp;
-
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data)
-			return 1;
-	}
-
-	return 0;
+	return eloop_find_timeout(handler, eloop_data, user_data) != NULL;
 }
 
 
@@ -730,28 +1208,19 @@ int eloop_deplete_timeout(unsigned int req_secs, unsigned int req_usecs,
 	struct os_reltime now, requested, remaining;
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data) {
-			requested.sec = req_secs;
-			requested.usec = req_usecs;
-			os_get_reltime(&now);
-			os_reltime_sub(&tmp->time, &now, &remaining);
-			if (os_reltime_before(&requested, &remaining)) {
-				eloop_cancel_timeout(handler, eloop_data,
-						     user_data);
-				eloop_register_timeout(requested.sec,
-						       requested.usec,
-						       handler, eloop_data,
-						       user_data);
-				return 1;
-			}
-			return 0;
-		}
-	}
+	tmp = eloop_find_timeout(handler, eloop_data, user_data);
+	if (tmp == NULL)
+		return -1;
 
-	return -1;
+	requested.sec = req_secs;
+	requested.usec = req_usecs;
+	os_get_reltime(&now);
+	os_reltime_sub(&tmp->time, &now, &remaining);
+	if (os_reltime_before(&requested, &remaining)) {
+		eloop_reschedule_timeout(tmp, &now, &requested);
+		return 1;
+	}
+	return 0;
 }
 
 
@@ -762,28 +1231,19 @@ int eloop_replenish_timeout(unsigned int req_secs, unsigned int req_usecs,
 	struct os_reltime now, requested, remaining;
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data) {
-			requested.sec = req_secs;
-			requested.usec = req_usecs;
-			os_get_reltime(&now);
-			os_reltime_sub(&tmp->time, &now, &remaining);
-			if (os_reltime_before(&remaining, &requested)) {
-				eloop_cancel_timeout(handler, eloop_data,
-						     user_data);
-				eloop_register_timeout(requested.sec,
-						       requested.usec,
-						       handler, eloop_data,
-						       user_data);
-				return 1;
-			}
-			return 0;
-		}
-	}
+	tmp = eloop_find_timeout(handler, eloop_data, user_data);
+	if (tmp == NULL)
+		return -1;
 
-	return -1;
+	requested.sec = req_secs;
+	requested.usec = req_usecs;
+	os_get_reltime(&now);
+	os_reltime_sub(&tmp->time, &now, &remaining);
+	if (os_reltime_before(&remaining, &requested)) {
+		eloop_reschedule_timeout(tmp, &now, &requested);
+		return 1;
+	}
+	return 0;
 }
 
 
@@ -892,6 +1352,106 @@ int eloop_register_signal_reconfig(eloop_signal_handler handler,
 }
 
 
+/*
+ * Call the handlers of timeouts that have expired; either just the first one
+ * (one per event loop iteration) or all that had expired on entry. Timeouts
+ * registered by the handlers are left for the next iteration even if they
+ * have already expired, so that a handler re-registering itself with a zero
+ * timeout cannot keep the sockets from being served.
+ */
+static void eloop_run_expired_timeouts(int only_first)
+{
+	struct eloop_timeout *timeout;
+	struct os_reltime now;
+	unsigned int seq = eloop.timeout_seq;
+
+	if (eloop_first_timeout() == NULL)
+		return;
+	os_get_reltime(&now);
+	while ((timeout = eloop_first_timeout()) != NULL &&
+	       !os_reltime_before(&now, &timeout->time) &&
+	       (int) (timeout->seq - seq) < 0) {
+		void *eloop_data = timeout->eloop_data;
+		void *user_data = timeout->user_data;
+		eloop_timeout_handler handler = timeout->handler;
+
+		eloop_remove_timeout(timeout);
+		handler(eloop_data, user_data);
+		if (only_first || eloop.terminate || eloop.pending_terminate)
+			break;
+	}
+}
+
+
+#ifdef CONFIG_ELOOP_EPOLL
+
+static void eloop_timerfd_arm(void)
+{
+	struct eloop_timeout *timeout = eloop_first_timeout();
+	struct itimerspec its;
+	struct os_reltime now, tv;
+
+	if (timeout && eloop.timerfd_armed &&
+	    timeout->time.sec == eloop.timerfd_time.sec &&
+	    timeout->time.usec == eloop.timerfd_time.usec)
+		return;
+	if (!timeout && !eloop.timerfd_armed)
+		return;
+
+	os_memset(&its, 0, sizeof(its));
+	if (timeout) {
+		os_get_reltime(&now);
+		if (os_reltime_before(&now, &timeout->time))
+			os_reltime_sub(&timeout->time, &now, &tv);
+		else
+			tv.sec = tv.usec = 0;
+		its.it_value.tv_sec = tv.sec;
+		its.it_value.tv_nsec = tv.usec * 1000;
+		if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+			its.it_value.tv_nsec = 1; /* zero would disarm */
+		eloop.timerfd_time = timeout->time;
+	}
+
+	if (timerfd_settime(eloop.timerfd, 0, &its, NULL) < 0) {
+		wpa_printf(MSG_ERROR, "eloop: timerfd_settime failed: %s",
+			   strerror(errno));
+		return;
+	}
+	eloop.timerfd_armed = timeout != NULL;
+}
+
+
+/* Remove the timerfd event from the results; returns the new count */
+static int eloop_timerfd_check(struct epoll_event *events, int nfds,
+			       int *fired)
+{
+	int i;
+
+	*fired = 0;
+	for (i = 0; i < nfds; i++) {
+		if (events[i].data.fd == eloop.timerfd) {
+			u64 expirations;
+
+			if (read(eloop.timerfd, &expirations,
+				 sizeof(expirations)) < 0 &&
+			    errno != EAGAIN)
+				wpa_printf(MSG_DEBUG,
+					   "eloop: timerfd read failed: %s",
+					   strerror(errno));
+			eloop.timerfd_armed = 0;
+			eloop.timer_wakeups++;
+			*fired = 1;
+			events[i] = events[--nfds];
+			break;
+		}
+	}
+
+	return nfds;
+}
+
+#endif /* CONFIG_ELOOP_EPOLL */
+
+
 void eloop_run(void)
 {
 #ifdef CONFIG_ELOOP_POLL
@@ -904,6 +1464,7 @@ void eloop_run(void)
 #endif /* CONFIG_ELOOP_SELECT */
 #ifdef CONFIG_ELOOP_EPOLL
 	int timeout_ms = -1;
+	int timer_fired = 0;
 #endif /* CONFIG_ELOOP_EPOLL */
 	int res;
 	struct os_reltime tv, now;
@@ -917,7 +1478,7 @@ void eloop_run(void)
 #endif /* CONFIG_ELOOP_SELECT */
 
 	while (!eloop.terminate &&
-	       (!dl_list_empty(&eloop.timeout) || eloop.readers.count > 0 ||
+	       (eloop.timeout_count > 0 || eloop.readers.count > 0 ||
 		eloop.writers.count > 0 || eloop.exceptions.count > 0)) {
 		struct eloop_timeout *timeout;
 
@@ -934,8 +1495,14 @@ void eloop_run(void)
 				break;
 		}
 
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
-					list);
+		timeout = eloop_first_timeout();
+#ifdef CONFIG_ELOOP_EPOLL
+		if (eloop.timerfd >= 0) {
+			/* The timerfd wakes up epoll_wait() for timeouts */
+			eloop_timerfd_arm();
+			timeout = NULL;
+		}
+#endif /* CONFIG_ELOOP_EPOLL */
 		if (timeout) {
 			os_get_reltime(&now);
 			if (os_reltime_before(&now, &timeout->time))
@@ -967,7 +1534,13 @@ void eloop_run(void)
 			     timeout ? &_tv : NULL);
 #endif /* CONFIG_ELOOP_SELECT */
 #ifdef CONFIG_ELOOP_EPOLL
-		if (eloop.count == 0) {
+		if (eloop.timerfd >= 0) {
+			res = epoll_wait(eloop.epollfd, eloop.epoll_events,
+					 eloop.count + 1, -1);
+			if (res > 0)
+				res = eloop_timerfd_check(eloop.epoll_events,
+							  res, &timer_fired);
+		} else if (eloop.count == 0) {
 			res = 0;
 		} else {
 			res = epoll_wait(eloop.epollfd, eloop.epoll_events,
@@ -988,6 +1561,7 @@ void eloop_run(void)
 				   , strerror(errno));
 			goto out;
 		}
+		eloop.wakeups++;
 
 		eloop.readers.changed = 0;
 		eloop.writers.changed = 0;
@@ -996,20 +1570,14 @@ void eloop_run(void)
 		eloop_process_pending_signals();
 
 		/* check if some registered timeouts have occurred */
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
-					list);
-		if (timeout) {
-			os_get_reltime(&now);
-			if (!os_reltime_before(&now, &timeout->time)) {
-				void *eloop_data = timeout->eloop_data;
-				void *user_data = timeout->user_data;
-				eloop_timeout_handler handler =
-					timeout->handler;
-				eloop_remove_timeout(timeout);
-				handler(eloop_data, user_data);
-			}
-
-		}
+#ifdef CONFIG_ELOOP_EPOLL
+		if (eloop.timerfd >= 0) {
+			if (timer_fired)
+				eloop_run_expired_timeouts(0);
+			timer_fired = 0;
+		} else
+#endif /* CONFIG_ELOOP_EPOLL */
+		eloop_run_expired_timeouts(1);
 
 		if (res <= 0)
 			continue;
@@ -1024,6 +1592,9 @@ void eloop_run(void)
 			  * whether any of the currently registered sockets have
 			  * events.
 			  */
+#ifdef CONFIG_ELOOP_EPOLL
+			eloop_sock_rearm_skipped(eloop.epoll_events, res);
+#endif /* CONFIG_ELOOP_EPOLL */
 			continue;
 		}
 
@@ -1061,12 +1632,11 @@ void eloop_terminate(void)
 
 void eloop_destroy(void)
 {
-	struct eloop_timeout *timeout, *prev;
+	struct eloop_timeout *timeout;
 	struct os_reltime now;
 
 	os_get_reltime(&now);
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
+	while ((timeout = eloop_first_timeout()) != NULL) {
 		int sec, usec;
 		sec = timeout->time.sec - now.sec;
 		usec = timeout->time.usec - now.usec;
@@ -1083,6 +1653,13 @@ void eloop_destroy(void)
 		wpa_trace_dump("eloop timeout", timeout);
 		eloop_remove_timeout(timeout);
 	}
+	os_free(eloop.timeout_heap);
+	eloop.timeout_heap = NULL;
+	eloop.timeout_heap_size = 0;
+	os_free(eloop.timeout_hash);
+	eloop.timeout_hash = NULL;
+	eloop.timeout_hash_size = 0;
+	eloop_free_timeout_pool();
 	eloop_sock_table_destroy(&eloop.readers);
 	eloop_sock_table_destroy(&eloop.writers);
 	eloop_sock_table_destroy(&eloop.exceptions);
@@ -1095,11 +1672,110 @@ void eloop_destroy(void)
 #ifdef CONFIG_ELOOP_EPOLL
 	os_free(eloop.epoll_table);
 	os_free(eloop.epoll_events);
+	if (eloop.timerfd >= 0)
+		close(eloop.timerfd);
 	close(eloop.epollfd);
 #endif /* CONFIG_ELOOP_EPOLL */
 }
 
 
+void eloop_get_stats(struct eloop_stats *stats)
+{
+	os_memset(stats, 0, sizeof(*stats));
+	stats->timeouts = eloop.timeout_count;
+	stats->timeout_pool = eloop.timeout_pool_size;
+	stats->timeout_pool_free = eloop.timeout_pool_free;
+	stats->timeout_allocs = eloop.timeout_allocs;
+	stats->timeout_pool_grows = eloop.timeout_pool_grows;
+	stats->socks = eloop.readers.count + eloop.writers.count +
+		eloop.exceptions.count;
+	stats->sock_slots = eloop.readers.max + eloop.writers.max +
+		eloop.exceptions.max;
+	stats->sock_table_grows = eloop.sock_table_grows;
+	stats->wakeups = eloop.wakeups;
+	stats->timer_wakeups = eloop.timer_wakeups;
+}
+
+
+static int eloop_sock_table_stats(struct eloop_sock_table *table,
+				  eloop_event_type type,
+				  struct eloop_sock_stats *stats,
+				  int max_stats)
+{
+	int i, count = 0;
+
+	for (i = 0; i < table->count && count < max_stats; i++) {
+		struct eloop_sock *sock = &table->table[i];
+
+#ifdef CONFIG_ELOOP_EPOLL
+		/* Handlers are called through the per-fd epoll table */
+		sock = &eloop.epoll_table[sock->sock];
+#endif /* CONFIG_ELOOP_EPOLL */
+		stats[count].sock = table->table[i].sock;
+		stats[count].type = type;
+		stats[count].budget = sock->budget;
+		stats[count].dispatched = sock->dispatched;
+		os_memcpy(stats[count].latency, sock->latency,
+			  sizeof(sock->latency));
+		stats[count].max_latency_us = sock->max_latency_us;
+		count++;
+	}
+
+	return count;
+}
+
+
+int eloop_get_sock_stats(struct eloop_sock_stats *stats, int max_stats)
+{
+	int count;
+
+	count = eloop_sock_table_stats(&eloop.readers, EVENT_TYPE_READ,
+				       stats, max_stats);
+	count += eloop_sock_table_stats(&eloop.writers, EVENT_TYPE_WRITE,
+					stats + count, max_stats - count);
+	count += eloop_sock_table_stats(&eloop.exceptions,
+					EVENT_TYPE_EXCEPTION,
+					stats + count, max_stats - count);
+
+	return count;
+}
+
+
+int eloop_set_read_sock_budget(int sock, unsigned int budget)
+{
+	struct eloop_sock_table *table = &eloop.readers;
+	int i;
+#ifdef CONFIG_ELOOP_EPOLL
+	struct epoll_event ev;
+#endif /* CONFIG_ELOOP_EPOLL */
+
+	for (i = 0; i < table->count; i++) {
+		if (table->table[i].sock == sock)
+			break;
+	}
+	if (i == table->count)
+		return -1;
+	table->table[i].budget = budget;
+
+#ifdef CONFIG_ELOOP_EPOLL
+	os_memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	if (budget)
+		ev.events |= EPOLLET;
+	ev.data.fd = sock;
+	if (epoll_ctl(eloop.epollfd, EPOLL_CTL_MOD, sock, &ev) < 0) {
+		wpa_printf(MSG_ERROR, "%s: epoll_ctl(MOD) for fd=%d failed: %s",
+			   __func__, sock, strerror(errno));
+		table->table[i].budget = 0;
+		return -1;
+	}
+	eloop.epoll_table[sock].budget = budget;
+#endif /* CONFIG_ELOOP_EPOLL */
+
+	return 0;
+}
+
+
 int eloop_terminated(void)
 {
 	return eloop.terminate || eloop.pending_terminate;
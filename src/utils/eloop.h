@@ -22,6 +22,11 @@
  */
 #define ELOOP_ALL_CTX (void *) -1
 
+/**
+ * ELOOP_LATENCY_BUCKETS - Number of buckets in socket handler latency stats
+ */
+#define ELOOP_LATENCY_BUCKETS 6
+
 /**
  * eloop_event_type - eloop socket event type for eloop_register_sock()
  * @EVENT_TYPE_READ: Socket has data available for reading
@@ -175,6 +180,13 @@ void eloop_unregister_event(void *event, size_t event_size);
  *
  * Register a timeout that will cause the handler function to be called after
  * given time.
+ *
+ * Timeouts with the same expiration time are called in registration order.
+ * The select() and poll() backends call one expired timeout per event loop
+ * iteration. The epoll backend calls all timeouts that have expired when the
+ * timer fires before the sockets are served; a timeout registered from one of
+ * these handlers is called on a later iteration, after the sockets, even when
+ * it has already expired.
  */
 int eloop_register_timeout(unsigned int secs, unsigned int usecs,
 			   eloop_timeout_handler handler,
@@ -337,6 +349,81 @@ void eloop_terminate(void);
  */
 void eloop_destroy(void);
 
+/**
+ * struct eloop_stats - Event loop allocation statistics
+ * @timeouts: Number of pending timeouts
+ * @timeout_pool: Number of timeout records owned by the timeout pool
+ * @timeout_pool_free: Number of unused records in the timeout pool
+ * @timeout_allocs: Number of timeout records handed out from the pool
+ * @timeout_pool_grows: Number of heap allocations done to grow the pool
+ * @socks: Number of registered sockets
+ * @sock_slots: Number of allocated socket table entries
+ * @sock_table_grows: Number of socket table reallocations
+ * @wakeups: Number of times the event loop returned from waiting for events
+ * @timer_wakeups: Number of wakeups caused by the timeout timer (timerfd)
+ */
+struct eloop_stats {
+	unsigned int timeouts;
+	unsigned int timeout_pool;
+	unsigned int timeout_pool_free;
+	unsigned long timeout_allocs;
+	unsigned long timeout_pool_grows;
+	unsigned int socks;
+	unsigned int sock_slots;
+	unsigned long sock_table_grows;
+	unsigned long wakeups;
+	unsigned long timer_wakeups;
+};
+
+/**
+ * eloop_get_stats - Get event loop allocation statistics
+ * @stats: Buffer for returning the statistics
+ */
+void eloop_get_stats(struct eloop_stats *stats);
+
+/**
+ * struct eloop_sock_stats - Per-socket dispatch statistics
+ * @sock: File descriptor number for the socket
+ * @type: Type of event the socket is registered for
+ * @budget: Handler calls per wakeup (0 = level-triggered, one call)
+ * @dispatched: Number of handler calls
+ * @latency: Handler run time histogram; <10 us, <100 us, <1 ms, <10 ms,
+ *	<100 ms, longer
+ * @max_latency_us: Longest handler run time in microseconds
+ */
+struct eloop_sock_stats {
+	int sock;
+	eloop_event_type type;
+	unsigned int budget;
+	unsigned long dispatched;
+	unsigned long latency[ELOOP_LATENCY_BUCKETS];
+	unsigned int max_latency_us;
+};
+
+/**
+ * eloop_get_sock_stats - Get per-socket dispatch statistics
+ * @stats: Buffer for returning the statistics
+ * @max_stats: Maximum number of entries in stats
+ * Returns: Number of entries filled in
+ */
+int eloop_get_sock_stats(struct eloop_sock_stats *stats, int max_stats);
+
+/**
+ * eloop_set_read_sock_budget - Drain a read socket on each wakeup
+ * @sock: File descriptor number for a registered read socket
+ * @budget: Maximum number of handler calls per wakeup, 0 to disable
+ * Returns: 0 on success, -1 on failure
+ *
+ * With a non-zero budget, the epoll backend registers the socket as
+ * edge-triggered and calls the handler repeatedly, up to budget times per
+ * wakeup. The socket must be non-blocking and the handler must read one
+ * message on each call; when the read fails because the socket is empty, the
+ * handler returns with errno still set to EAGAIN to stop the calls for this
+ * wakeup. Other backends record the value, but keep calling the handler once
+ * per wakeup.
+ */
+int eloop_set_read_sock_budget(int sock, unsigned int budget);
+
 /**
  * eloop_terminated - Check whether event loop has been terminated
  * Returns: 1 = event loop terminate, 0 = event loop still running
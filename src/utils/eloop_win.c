@@ -666,6 +666,26 @@ void eloop_destroy(void)
 }
 
 
+void eloop_get_stats(struct eloop_stats *stats)
+{
+	os_memset(stats, 0, sizeof(*stats));
+	stats->timeouts = dl_list_len(&eloop.timeout);
+	stats->socks = eloop.reader_count + eloop.event_count;
+}
+
+
+int eloop_get_sock_stats(struct eloop_sock_stats *stats, int max_stats)
+{
+	return 0;
+}
+
+
+int eloop_set_read_sock_budget(int sock, unsigned int budget)
+{
+	return 0;
+}
+
+
 int eloop_terminated(void)
 {
 	return eloop.terminate;
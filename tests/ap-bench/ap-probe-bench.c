@@ -0,0 +1,121 @@
+/*
+ * hostapd - Probe Request flood benchmark
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/ieee802_11_defs.h"
+#include "ap/hostapd.h"
+#include "ap/ap_config.h"
+#include "ap/beacon.h"
+#include "ap_harness.h"
+
+
+static size_t build_probe_req(u8 *buf, size_t len)
+{
+	struct ieee80211_mgmt *mgmt = (struct ieee80211_mgmt *) buf;
+	u8 *pos;
+
+	if (len < IEEE80211_HDRLEN + 2 + 2 + 8)
+		return 0;
+
+	os_memset(buf, 0, len);
+	mgmt->frame_control = IEEE80211_FC(WLAN_FC_TYPE_MGMT,
+					   WLAN_FC_STYPE_PROBE_REQ);
+	os_memset(mgmt->da, 0xff, ETH_ALEN);
+	os_memcpy(mgmt->sa, "\x02\x00\x00\x00\x00\x00", ETH_ALEN);
+	os_memset(mgmt->bssid, 0xff, ETH_ALEN);
+
+	pos = mgmt->u.probe_req.variable;
+	*pos++ = WLAN_EID_SSID;
+	*pos++ = 0;
+	*pos++ = WLAN_EID_SUPP_RATES;
+	*pos++ = 8;
+	os_memcpy(pos, "\x82\x84\x8b\x96\x0c\x12\x18\x24", 8);
+	pos += 8;
+
+	return pos - buf;
+}
+
+
+static void run(struct ap_harness *ctx, const char *name, unsigned int count,
+		unsigned int sources, int rebuild)
+{
+	u8 buf[IEEE80211_HDRLEN + 64];
+	struct ieee80211_mgmt *mgmt = (struct ieee80211_mgmt *) buf;
+	struct os_reltime start;
+	size_t len;
+	unsigned int i;
+	double secs;
+
+	len = build_probe_req(buf, sizeof(buf));
+	ctx->sent = 0;
+	ctx->sent_bytes = 0;
+	hostapd_probe_resp_tmpl_flush(&ctx->hapd);
+	ctx->hapd.probe_resp_dedup = 0;
+	ctx->hapd.probe_resp_limited = 0;
+
+	os_get_reltime(&start);
+	for (i = 0; i < count; i++) {
+		WPA_PUT_BE32(&mgmt->sa[2], sources ? i % sources : i);
+		if (rebuild)
+			hostapd_probe_resp_tmpl_flush(&ctx->hapd);
+		handle_probe_req(&ctx->hapd, mgmt, len, -40);
+	}
+	secs = ap_harness_elapsed(&start);
+
+	printf("%s: %u probes, %u responses (%lu bytes) in %.3f s: %.0f probes/s, %.0f responses/s (dedup %lu, limited %lu)\n",
+	       name, count, ctx->sent, (unsigned long) ctx->sent_bytes, secs,
+	       secs > 0 ? count / secs : 0.0,
+	       secs > 0 ? ctx->sent / secs : 0.0,
+	       ctx->hapd.probe_resp_dedup, ctx->hapd.probe_resp_limited);
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct ap_harness ctx;
+	unsigned int count = 1000000;
+	int ret = -1;
+
+	if (argc > 1)
+		count = atoi(argv[1]);
+
+	if (os_program_init())
+		return -1;
+
+	wpa_debug_level = MSG_ERROR;
+
+	if (eloop_init()) {
+		wpa_printf(MSG_ERROR, "Failed to initialize event loop");
+		return -1;
+	}
+
+	if (ap_harness_init(&ctx))
+		goto fail;
+	ctx.hapd.conf->interworking = 1;
+	ctx.hapd.conf->bss_load_update_period = 100;
+
+	/* Rebuilding the template for every request matches the old path */
+	run(&ctx, "rebuild", count, 0, 1);
+	run(&ctx, "cached", count, 0, 0);
+
+	/* A small set of stations re-probing with per-source limits */
+	ctx.hapd.conf->probe_resp_dedup_window = 20;
+	ctx.hapd.conf->probe_resp_rate = 5;
+	ctx.hapd.conf->probe_resp_burst = 10;
+	run(&ctx, "limited", count, 64, 0);
+
+	ret = 0;
+fail:
+	ap_harness_deinit(&ctx);
+	eloop_destroy();
+	os_program_deinit();
+
+	return ret;
+}
@@ -0,0 +1,208 @@
+/*
+ * hostapd - EAPOL-Key msg 2/4 processing benchmark with many PSKs
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/defs.h"
+#include "common/wpa_common.h"
+#include "ap/ap_config.h"
+#include "ap_harness.h"
+
+
+static const u8 * legacy_get_psk(struct ap_harness_wpa *w, const u8 *addr,
+				 const u8 *prev_psk)
+{
+	struct hostapd_wpa_psk *psk;
+	int next_ok = prev_psk == NULL;
+
+	for (psk = w->conf->ssid.wpa_psk; psk != NULL; psk = psk->next) {
+		if (next_ok &&
+		    (psk->group || os_memcmp(psk->addr, addr, ETH_ALEN) == 0))
+			return psk->psk;
+
+		if (psk->psk == prev_psk)
+			next_ok = 1;
+	}
+
+	return NULL;
+}
+
+
+static const u8 * bench_get_psk(struct ap_harness_wpa *w, const u8 *addr,
+				const u8 *prev_psk)
+{
+	if (w->get_psk)
+		return w->get_psk(w, addr, prev_psk);
+	return hostapd_get_psk(w->conf, addr, NULL, prev_psk);
+}
+
+
+/* Add num PSKs for any station in front of the current list */
+static int add_group_psks(struct ap_harness_wpa *w, unsigned int num)
+{
+	while (num--) {
+		if (ap_harness_wpa_add_psk(w, NULL, NULL))
+			return -1;
+	}
+	return 0;
+}
+
+
+/* Run handshakes up to msg 3/4 and return the time per msg 2/4 */
+static double run_handshakes(struct ap_harness_wpa *w, unsigned int count)
+{
+	unsigned int i;
+	double total = 0, secs;
+
+	for (i = 0; i < count; i++) {
+		if (ap_harness_wpa_handshake(w, &secs) < 0)
+			return -1;
+		total += secs;
+	}
+
+	return total * 1000 / count;
+}
+
+
+/* Time for iterating over all PSK candidates without key derivation */
+static double run_lookup(struct ap_harness_wpa *w, unsigned int count)
+{
+	struct os_reltime start;
+	const u8 *psk;
+	unsigned int i;
+
+	os_get_reltime(&start);
+	for (i = 0; i < count; i++) {
+		psk = NULL;
+		while ((psk = bench_get_psk(w, w->sta_addr, psk)))
+			;
+	}
+	return ap_harness_elapsed(&start) * 1000 / count;
+}
+
+
+/* Cost of rejecting one wrong PSK candidate */
+static void run_candidate(struct ap_harness_wpa *w, unsigned int count)
+{
+	struct wpa_ptk ptk;
+	u8 pmk[PMK_LEN], anonce[WPA_NONCE_LEN], snonce[WPA_NONCE_LEN];
+	u8 buf[256];
+	struct os_reltime start;
+	unsigned int i;
+	double t_full, t_kck;
+	u8 mic[16];
+
+	os_get_random(pmk, sizeof(pmk));
+	os_get_random(anonce, sizeof(anonce));
+	os_get_random(snonce, sizeof(snonce));
+	os_get_random(buf, sizeof(buf));
+
+	os_get_reltime(&start);
+	for (i = 0; i < count; i++) {
+		wpa_pmk_to_ptk(pmk, PMK_LEN, "Pairwise key expansion",
+			       w->auth_addr, w->sta_addr, anonce,
+			       snonce, &ptk, WPA_KEY_MGMT_PSK,
+			       WPA_CIPHER_CCMP);
+		wpa_eapol_key_mic(ptk.kck, ptk.kck_len, WPA_KEY_MGMT_PSK,
+				  WPA_KEY_INFO_TYPE_HMAC_SHA1_AES, buf, 121,
+				  mic);
+	}
+	t_full = ap_harness_elapsed(&start);
+
+	os_get_reltime(&start);
+	for (i = 0; i < count; i++) {
+		wpa_pmk_to_kck(pmk, PMK_LEN, "Pairwise key expansion",
+			       w->auth_addr, w->sta_addr, anonce,
+			       snonce, &ptk, WPA_KEY_MGMT_PSK);
+		wpa_eapol_key_mic(ptk.kck, ptk.kck_len, WPA_KEY_MGMT_PSK,
+				  WPA_KEY_INFO_TYPE_HMAC_SHA1_AES, buf, 121,
+				  mic);
+	}
+	t_kck = ap_harness_elapsed(&start);
+
+	printf("per candidate: full PTK + MIC %.2f us, KCK + MIC %.2f us\n",
+	       t_full * 1e6 / count, t_kck * 1e6 / count);
+}
+
+
+static int run(struct ap_harness_wpa *w, unsigned int num_psks)
+{
+	unsigned int count = num_psks >= 1000 ? 5 : 50;
+	double t_first, t_again, t_sta, t_legacy, l_index, l_list;
+
+	/* Matching PSK for any station at the end of the search order */
+	hostapd_config_clear_wpa_psk(&w->conf->ssid);
+	if (ap_harness_wpa_add_psk(w, NULL, w->psk) ||
+	    add_group_psks(w, num_psks - 1))
+		return -1;
+
+	w->get_psk = legacy_get_psk;
+	t_legacy = run_handshakes(w, count);
+	l_list = run_lookup(w, count);
+	w->get_psk = NULL;
+	l_index = run_lookup(w, count);
+
+	/* The first handshake is timed without affinity cache */
+	t_first = run_handshakes(w, 1);
+	t_again = run_handshakes(w, count);
+
+	/* Station specific PSK among the PSKs for any station */
+	hostapd_config_clear_wpa_psk(&w->conf->ssid);
+	if (add_group_psks(w, num_psks - 1) ||
+	    ap_harness_wpa_add_psk(w, w->sta_addr, w->psk))
+		return -1;
+	t_sta = run_handshakes(w, count);
+
+	if (t_first < 0 || t_again < 0 || t_sta < 0 || t_legacy < 0)
+		return -1;
+
+	printf("%6u PSKs: msg 2/4 first %.3f ms (list search %.3f ms), reconnect %.3f ms, per-STA PSK %.3f ms; lookup only: indexed %.3f ms, list %.3f ms\n",
+	       num_psks, t_first, t_legacy, t_again, t_sta, l_index, l_list);
+	return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct ap_harness_wpa w;
+	unsigned int max_psks = 4096, num;
+	int ret = -1;
+
+	if (argc > 1)
+		max_psks = atoi(argv[1]);
+
+	if (os_program_init())
+		return -1;
+
+	wpa_debug_level = MSG_ERROR;
+
+	if (eloop_init()) {
+		wpa_printf(MSG_ERROR, "Failed to initialize event loop");
+		return -1;
+	}
+
+	if (ap_harness_wpa_init(&w))
+		goto fail;
+
+	run_candidate(&w, 20000);
+	for (num = 1; num <= max_psks; num *= 4) {
+		if (run(&w, num)) {
+			printf("msg 2/4 processing failed with %u PSKs\n", num);
+			goto fail;
+		}
+	}
+
+	ret = 0;
+fail:
+	ap_harness_wpa_deinit(&w);
+	eloop_destroy();
+	os_program_deinit();
+
+	return ret;
+}
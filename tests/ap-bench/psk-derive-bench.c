@@ -0,0 +1,204 @@
+/*
+ * hostapd - Passphrase to PSK derivation benchmark
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * A burst of RADIUS Access-Accept messages with Tunnel-Password attributes is
+ * modeled as a number of derivation requests from a single event loop
+ * callback. A 1 ms timer measures how long the event loop is unable to
+ * process other events.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "crypto/sha1.h"
+#include "common/wpa_common.h"
+#include "ap/psk_derive.h"
+#include "ap_harness.h"
+
+
+static const u8 ssid[] = "psk-derive-bench";
+
+struct bench_ctx {
+	unsigned int num;
+	unsigned int round; /* selects a different set of passphrases */
+	int sync;
+	u8 (*psk)[PMK_LEN];
+	unsigned int completed;
+	struct os_reltime start;
+	struct os_reltime last_tick;
+	double max_stall;
+	double total;
+};
+
+
+static void passphrase(char *buf, size_t len, unsigned int round,
+		       unsigned int i)
+{
+	os_snprintf(buf, len, "passphrase-%u-%u", round, i);
+}
+
+
+static void bench_tick(void *eloop_ctx, void *timeout_ctx)
+{
+	struct bench_ctx *bench = eloop_ctx;
+	double stall;
+
+	stall = ap_harness_elapsed(&bench->last_tick);
+	if (stall > bench->max_stall)
+		bench->max_stall = stall;
+	os_get_reltime(&bench->last_tick);
+	if (bench->completed == bench->num)
+		eloop_terminate();
+	else
+		eloop_register_timeout(0, 1000, bench_tick, bench, NULL);
+}
+
+
+static void bench_done(void *ctx)
+{
+	struct bench_ctx *bench = ctx;
+
+	if (++bench->completed == bench->num)
+		bench->total = ap_harness_elapsed(&bench->start);
+}
+
+
+static void bench_burst(void *eloop_ctx, void *timeout_ctx)
+{
+	struct bench_ctx *bench = eloop_ctx;
+	char buf[64];
+	unsigned int i;
+
+	os_get_reltime(&bench->start);
+	for (i = 0; i < bench->num; i++) {
+		passphrase(buf, sizeof(buf), bench->round, i);
+		if (bench->sync) {
+			pbkdf2_sha1(buf, ssid, sizeof(ssid) - 1, 4096,
+				    bench->psk[i], PMK_LEN);
+			bench_done(bench);
+		} else if (psk_derive_start(buf, ssid, sizeof(ssid) - 1,
+					    bench->psk[i], bench_done,
+					    bench) == 1) {
+			bench_done(bench);
+		}
+	}
+}
+
+
+static int run_burst(struct bench_ctx *bench, int sync)
+{
+	u8 psk[PMK_LEN];
+	char buf[64];
+	unsigned int i;
+
+	bench->sync = sync;
+	bench->completed = 0;
+	bench->max_stall = 0;
+	os_get_reltime(&bench->last_tick);
+	eloop_register_timeout(0, 1000, bench_tick, bench, NULL);
+	eloop_register_timeout(0, 0, bench_burst, bench, NULL);
+	eloop_run();
+
+	for (i = 0; i < bench->num; i++) {
+		passphrase(buf, sizeof(buf), bench->round, i);
+		pbkdf2_sha1(buf, ssid, sizeof(ssid) - 1, 4096, psk, PMK_LEN);
+		if (os_memcmp(psk, bench->psk[i], PMK_LEN) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+
+/* Derive a set of passphrases like when reading wpa_psk_file */
+static double run_batch(struct bench_ctx *bench, int sync)
+{
+	struct os_reltime start;
+	char buf[64];
+	unsigned int i;
+
+	os_get_reltime(&start);
+	for (i = 0; i < bench->num; i++) {
+		passphrase(buf, sizeof(buf), bench->round, i);
+		if (sync)
+			pbkdf2_sha1(buf, ssid, sizeof(ssid) - 1, 4096,
+				    bench->psk[i], PMK_LEN);
+		else
+			psk_derive_start(buf, ssid, sizeof(ssid) - 1,
+					 bench->psk[i], NULL, bench);
+	}
+	psk_derive_flush(bench);
+	return ap_harness_elapsed(&start);
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct bench_ctx bench;
+	double t_sync, s_sync, t_async, s_async, t_cached, s_cached;
+	double b_sync, b_async, b_cached;
+	int ret = -1;
+
+	os_memset(&bench, 0, sizeof(bench));
+	bench.num = 32;
+	if (argc > 1)
+		bench.num = atoi(argv[1]);
+
+	if (os_program_init())
+		return -1;
+
+	wpa_debug_level = MSG_ERROR;
+
+	if (eloop_init()) {
+		wpa_printf(MSG_ERROR, "Failed to initialize event loop");
+		return -1;
+	}
+
+	bench.psk = os_calloc(bench.num, PMK_LEN);
+	if (bench.psk == NULL)
+		goto fail;
+
+	bench.round = 0;
+	if (run_burst(&bench, 1) < 0)
+		goto fail;
+	t_sync = bench.total;
+	s_sync = bench.max_stall;
+
+	bench.round = 1;
+	if (run_burst(&bench, 0) < 0)
+		goto fail;
+	t_async = bench.total;
+	s_async = bench.max_stall;
+
+	/* The same passphrases again are found from the cache */
+	if (run_burst(&bench, 0) < 0)
+		goto fail;
+	t_cached = bench.total;
+	s_cached = bench.max_stall;
+
+	bench.round = 2;
+	b_sync = run_batch(&bench, 1);
+	bench.round = 3;
+	b_async = run_batch(&bench, 0);
+	b_cached = run_batch(&bench, 0);
+
+	printf("%u passphrases in one callback: synchronous %.1f ms (event loop blocked %.1f ms), queued %.1f ms (blocked %.1f ms), cached %.3f ms (blocked %.3f ms)\n",
+	       bench.num, t_sync * 1000, s_sync * 1000, t_async * 1000,
+	       s_async * 1000, t_cached * 1000, s_cached * 1000);
+	printf("%u passphrases in a batch: synchronous %.1f ms, psk_derive_flush() %.1f ms, cached %.3f ms\n",
+	       bench.num, b_sync * 1000, b_async * 1000, b_cached * 1000);
+
+	ret = 0;
+fail:
+	if (ret)
+		printf("Benchmark failed\n");
+	psk_derive_deinit();
+	os_free(bench.psk);
+	eloop_destroy();
+	os_program_deinit();
+
+	return ret;
+}
@@ -0,0 +1,182 @@
+/*
+ * hostapd - STA hash table lookup benchmark
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "ap/hostapd.h"
+#include "ap/ap_config.h"
+#include "ap/sta_info.h"
+#include "ap_harness.h"
+
+
+struct bench_ctx {
+	struct ap_harness h;
+	u8 *addrs;
+	unsigned int num_addrs;
+	struct legacy_sta *legacy_stas;
+};
+
+/* The previous fixed table indexed by the last address octet */
+#define LEGACY_HASH_SIZE 256
+#define LEGACY_HASH(sta) (sta[5])
+
+struct legacy_sta {
+	struct legacy_sta *hnext;
+	u8 addr[ETH_ALEN];
+};
+
+
+static struct legacy_sta * legacy_get_sta(struct legacy_sta **hash,
+					  const u8 *addr)
+{
+	struct legacy_sta *s;
+
+	s = hash[LEGACY_HASH(addr)];
+	while (s != NULL && os_memcmp(s->addr, addr, ETH_ALEN) != 0)
+		s = s->hnext;
+	return s;
+}
+
+
+enum mac_dist {
+	DIST_RANDOM_LAA, DIST_SEQUENTIAL, DIST_STRIDE_16, DIST_FIXED_LAST
+};
+
+
+static void gen_addrs(struct bench_ctx *ctx, enum mac_dist dist)
+{
+	unsigned int i;
+	u8 *addr;
+
+	for (i = 0; i < ctx->num_addrs; i++) {
+		addr = &ctx->addrs[i * ETH_ALEN];
+		switch (dist) {
+		case DIST_RANDOM_LAA:
+			/* Randomized, locally administered (privacy) */
+			os_get_random(addr, ETH_ALEN);
+			addr[0] = (addr[0] & 0xfc) | 0x02;
+			break;
+		case DIST_SEQUENTIAL:
+			/* One vendor OUI, consecutive NIC specific part */
+			os_memcpy(addr, "\x00\x1b\x63", 3);
+			WPA_PUT_BE24(&addr[3], 0x123400 + i);
+			break;
+		case DIST_STRIDE_16:
+			/* Devices reserving a block of 16 addresses each */
+			os_memcpy(addr, "\x3c\x22\xfb", 3);
+			WPA_PUT_BE24(&addr[3], 0x400000 + i * 16);
+			break;
+		case DIST_FIXED_LAST:
+			/* Same last octet, e.g., virtual interfaces */
+			os_memcpy(addr, "\x52\x54\x00", 3);
+			WPA_PUT_BE16(&addr[3], i);
+			addr[5] = 0x01;
+			break;
+		}
+	}
+}
+
+
+static int run(struct bench_ctx *ctx, const char *name, enum mac_dist dist,
+	       unsigned int lookups)
+{
+	struct hostapd_data *hapd = &ctx->h.hapd;
+	struct legacy_sta *legacy[LEGACY_HASH_SIZE], *l;
+	struct sta_info *sta;
+	struct os_reltime start;
+	unsigned int i, found = 0, legacy_found = 0;
+	double t_keyed, t_legacy;
+
+	gen_addrs(ctx, dist);
+	os_memset(legacy, 0, sizeof(legacy));
+	for (i = 0; i < ctx->num_addrs; i++) {
+		const u8 *addr = &ctx->addrs[i * ETH_ALEN];
+
+		sta = ap_sta_add(hapd, addr);
+		if (sta == NULL)
+			return -1;
+		l = &ctx->legacy_stas[i];
+		os_memcpy(l->addr, addr, ETH_ALEN);
+		l->hnext = legacy[LEGACY_HASH(addr)];
+		legacy[LEGACY_HASH(addr)] = l;
+	}
+
+	os_get_reltime(&start);
+	for (i = 0; i < lookups; i++) {
+		if (ap_get_sta(hapd,
+			       &ctx->addrs[(i % ctx->num_addrs) * ETH_ALEN]))
+			found++;
+	}
+	t_keyed = ap_harness_elapsed(&start);
+
+	os_get_reltime(&start);
+	for (i = 0; i < lookups; i++) {
+		if (legacy_get_sta(legacy,
+				   &ctx->addrs[(i % ctx->num_addrs) *
+					       ETH_ALEN]))
+			legacy_found++;
+	}
+	t_legacy = ap_harness_elapsed(&start);
+
+	printf("%-12s %u STAs, %u buckets: keyed %.1f ns/lookup, legacy (sta[5]) %.1f ns/lookup\n",
+	       name, ctx->num_addrs, hapd->sta_hash_size,
+	       t_keyed * 1e9 / lookups, t_legacy * 1e9 / lookups);
+
+	hostapd_free_stas(hapd);
+
+	return found == lookups && legacy_found == lookups ? 0 : -1;
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct bench_ctx ctx;
+	unsigned int lookups = 4000000;
+	int ret = -1;
+
+	os_memset(&ctx, 0, sizeof(ctx));
+	ctx.num_addrs = 4096;
+	if (argc > 1)
+		ctx.num_addrs = atoi(argv[1]);
+	if (argc > 2)
+		lookups = atoi(argv[2]);
+
+	if (os_program_init())
+		return -1;
+
+	wpa_debug_level = MSG_ERROR;
+
+	if (eloop_init()) {
+		wpa_printf(MSG_ERROR, "Failed to initialize event loop");
+		return -1;
+	}
+
+	ctx.addrs = os_malloc(ctx.num_addrs * ETH_ALEN);
+	ctx.legacy_stas = os_calloc(ctx.num_addrs, sizeof(struct legacy_sta));
+	if (ctx.addrs == NULL || ctx.legacy_stas == NULL ||
+	    ap_harness_init(&ctx.h) < 0)
+		goto fail;
+	ctx.h.hapd.conf->max_num_sta = 100000;
+
+	if (run(&ctx, "random-laa", DIST_RANDOM_LAA, lookups) ||
+	    run(&ctx, "sequential", DIST_SEQUENTIAL, lookups) ||
+	    run(&ctx, "stride-16", DIST_STRIDE_16, lookups) ||
+	    run(&ctx, "fixed-last", DIST_FIXED_LAST, lookups))
+		goto fail;
+
+	ret = 0;
+fail:
+	ap_harness_deinit(&ctx.h);
+	os_free(ctx.addrs);
+	os_free(ctx.legacy_stas);
+	eloop_destroy();
+	os_program_deinit();
+
+	return ret;
+}
@@ -0,0 +1,132 @@
+/*
+ * hostapd - Client taxonomy signature benchmark
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "ap/hostapd.h"
+#include "ap/sta_info.h"
+#include "ap/taxonomy.h"
+#include "ap_harness.h"
+
+
+/* Probe Request IEs (after the header) as sent by a few common clients */
+static const u8 phone_probe[] = {
+	0x00, 0x00, /* SSID: wildcard */
+	0x01, 0x04, 0x02, 0x04, 0x0b, 0x16, /* Supported Rates */
+	0x32, 0x08, 0x0c, 0x12, 0x18, 0x24, 0x30, 0x48, 0x60, 0x6c,
+	0x03, 0x01, 0x06, /* DS Parameter Set */
+	0x2d, 0x1a, 0x2d, 0x11, 0x17, 0xff, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* HT Capab */
+	0x7f, 0x08, 0x04, 0x00, 0x08, 0x84, 0x00, 0x00, 0x00, 0x40,
+	0xdd, 0x09, 0x00, 0x10, 0x18, 0x02, 0x00, 0x00, 0x10, 0x00, 0x00,
+	0xdd, 0x08, 0x00, 0x50, 0xf2, 0x08, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const u8 laptop_probe[] = {
+	0x00, 0x04, 'h', 'o', 'm', 'e', /* SSID */
+	0x01, 0x08, 0x8c, 0x12, 0x98, 0x24, 0xb0, 0x48, 0x60, 0x6c,
+	0x2d, 0x1a, 0xef, 0x09, 0x17, 0xff, 0xff, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* HT Capab */
+	0xbf, 0x0c, 0xb2, 0x79, 0x91, 0x33, 0xfa, 0xff, 0x0c, 0x03,
+	0xfa, 0xff, 0x0c, 0x03, /* VHT Capab */
+	0x7f, 0x0a, 0x04, 0x00, 0x0a, 0x02, 0x01, 0x40, 0x00, 0x40,
+	0x00, 0x01,
+	0xdd, 0x07, 0x00, 0x50, 0xf2, 0x02, 0x00, 0x01, 0x00,
+};
+
+static const u8 wps_probe[] = {
+	0x00, 0x00,
+	0x01, 0x04, 0x02, 0x04, 0x0b, 0x16,
+	0x03, 0x01, 0x0b,
+	0x21, 0x02, 0x00, 0x14, /* Power Capability */
+	0xdd, 0x19, 0x00, 0x50, 0xf2, 0x04, /* WPS */
+	0x10, 0x4a, 0x00, 0x01, 0x10,
+	0x10, 0x3a, 0x00, 0x01, 0x00,
+	0x10, 0x23, 0x00, 0x07, 'N', 'e', 'x', 'u', 's', ' ', '7',
+};
+
+static const struct {
+	const char *name;
+	const u8 *ie;
+	size_t ie_len;
+} ie_sets[] = {
+	{ "phone", phone_probe, sizeof(phone_probe) },
+	{ "laptop", laptop_probe, sizeof(laptop_probe) },
+	{ "wps", wps_probe, sizeof(wps_probe) },
+};
+
+
+static void report(const char *name, unsigned int count, double secs)
+{
+	printf("%-10s %u probes in %.3f s: %.0f probes/s\n",
+	       name, count, secs, secs > 0 ? count / secs : 0.0);
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct ap_harness h;
+	struct hostapd_data *hapd = &h.hapd;
+	struct sta_info *sta;
+	struct os_reltime start;
+	unsigned int count = 1000000, i;
+	size_t s;
+	u8 addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+	if (argc > 1)
+		count = atoi(argv[1]);
+
+	wpa_debug_level = MSG_ERROR;
+	if (ap_harness_init(&h) < 0)
+		return -1;
+	sta = os_zalloc(sizeof(*sta));
+	if (sta == NULL) {
+		ap_harness_deinit(&h);
+		return -1;
+	}
+
+	for (s = 0; s < ARRAY_SIZE(ie_sets); s++) {
+		hostapd_taxonomy_probe_req(hapd, sta, ie_sets[s].ie,
+					   ie_sets[s].ie_len);
+		printf("%s: %s\n", ie_sets[s].name, sta->probe_ie_taxonomy);
+	}
+
+	/* Forcing a rebuild for every probe is what the old code did */
+	os_get_reltime(&start);
+	for (i = 0; i < count; i++) {
+		s = i % ARRAY_SIZE(ie_sets);
+		sta->probe_ie_taxonomy[0] = '\0';
+		hostapd_taxonomy_probe_req(hapd, sta, ie_sets[s].ie,
+					   ie_sets[s].ie_len);
+	}
+	report("rebuild", count, ap_harness_elapsed(&start));
+
+	/* An associated station repeating the same Probe Request */
+	os_get_reltime(&start);
+	for (i = 0; i < count; i++)
+		hostapd_taxonomy_probe_req(hapd, sta, phone_probe,
+					   sizeof(phone_probe));
+	report("unchanged", count, ap_harness_elapsed(&start));
+
+	/* Stations without a sta_info entry re-probing */
+	os_get_reltime(&start);
+	for (i = 0; i < count; i++) {
+		addr[5] = i % 64;
+		s = addr[5] % ARRAY_SIZE(ie_sets);
+		hostapd_taxonomy_probe_req_cache(hapd, addr, ie_sets[s].ie,
+						 ie_sets[s].ie_len);
+	}
+	report("cache", count, ap_harness_elapsed(&start));
+
+	os_free(sta);
+	ap_harness_deinit(&h);
+
+	return 0;
+}
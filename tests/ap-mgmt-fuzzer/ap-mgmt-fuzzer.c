@@ -20,6 +20,12 @@ const struct wpa_driver_ops *const wpa_drivers[] =
 	NULL
 };
 
+/* Band steering settings normally provided by hostapd/main.c */
+char *steering_path = NULL;
+int steering_rsi_threshold = -60;
+char *steering_target_interface = NULL;
+int steering_export_files = 0;
+
 
 struct arg_ctx {
 	const char *fname;
@@ -0,0 +1,351 @@
+/*
+ * Harness for running AP code in tests and benchmarks
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/defs.h"
+#include "common/eapol_common.h"
+#include "common/ieee802_11_defs.h"
+#include "common/wpa_common.h"
+#include "ap/hostapd.h"
+#include "ap/ap_config.h"
+#include "ap/beacon.h"
+#include "ap/sta_info.h"
+#include "ap/taxonomy.h"
+#include "ap/wpa_auth.h"
+#include "ap_harness.h"
+
+
+const struct wpa_driver_ops *const wpa_drivers[] =
+{
+	NULL
+};
+
+/* Band steering settings normally provided by hostapd/main.c */
+char *steering_path = NULL;
+int steering_rsi_threshold = -60;
+char *steering_target_interface = NULL;
+int steering_export_files = 0;
+
+
+static int ap_harness_send_mlme(void *priv, const u8 *data, size_t data_len,
+				int noack, unsigned int freq)
+{
+	struct ap_harness *h = priv;
+
+	h->sent++;
+	h->sent_bytes += data_len;
+	h->frame_len = 0;
+	if (data_len <= sizeof(h->frame)) {
+		os_memcpy(h->frame, data, data_len);
+		h->frame_len = data_len;
+	}
+	return 0;
+}
+
+
+int ap_harness_init(struct ap_harness *h)
+{
+	struct hostapd_data *hapd = &h->hapd;
+
+	os_memset(h, 0, sizeof(*h));
+	h->driver.send_mlme = ap_harness_send_mlme;
+	hapd->driver = &h->driver;
+	hapd->drv_priv = h;
+	os_memcpy(hapd->own_addr, "\x02\x00\x00\x00\x03\x00", ETH_ALEN);
+	hapd->iface = &h->iface;
+	h->bss[0] = hapd;
+	h->iface.bss = h->bss;
+	h->iface.num_bss = 1;
+	dl_list_init(&h->iface.sta_seen);
+	h->iface.conf = hostapd_config_defaults();
+	if (h->iface.conf == NULL)
+		return -1;
+	hapd->iconf = h->iface.conf;
+	hapd->conf = hapd->iconf->bss[0];
+	os_memcpy(hapd->conf->ssid.ssid, "test", 4);
+	hapd->conf->ssid.ssid_len = 4;
+	hapd->conf->ssid.ssid_set = 1;
+
+	return 0;
+}
+
+
+void ap_harness_deinit(struct ap_harness *h)
+{
+	struct hostapd_data *hapd = &h->hapd;
+
+	hostapd_free_stas(hapd);
+	ap_sta_hash_deinit(hapd);
+	sta_track_deinit(&h->iface);
+	hostapd_probe_resp_tmpl_flush(hapd);
+	os_free(hapd->probe_sources);
+	hapd->probe_sources = NULL;
+#ifdef CONFIG_CLIENT_TAXONOMY
+	hostapd_taxonomy_deinit(hapd);
+#endif /* CONFIG_CLIENT_TAXONOMY */
+	hostapd_config_free(hapd->iconf);
+	hapd->iconf = NULL;
+	hapd->conf = NULL;
+}
+
+
+double ap_harness_elapsed(struct os_reltime *start)
+{
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	return diff.sec + diff.usec / 1000000.0;
+}
+
+
+/* RSN IE: CCMP group and pairwise cipher, PSK AKM */
+static const u8 ap_harness_rsn_ie[] = {
+	WLAN_EID_RSN, 20, 0x01, 0x00,
+	0x00, 0x0f, 0xac, 0x04,
+	0x01, 0x00, 0x00, 0x0f, 0xac, 0x04,
+	0x01, 0x00, 0x00, 0x0f, 0xac, 0x02,
+	0x00, 0x00
+};
+
+
+static const u8 * ap_harness_get_psk(void *ctx, const u8 *addr,
+				     const u8 *p2p_dev_addr,
+				     const u8 *prev_psk)
+{
+	struct ap_harness_wpa *w = ctx;
+	const u8 *psk;
+
+	if (w->get_psk)
+		psk = w->get_psk(w, addr, prev_psk);
+	else
+		psk = hostapd_get_psk(w->conf, addr, p2p_dev_addr, prev_psk);
+	if (psk)
+		w->psk_candidates++;
+	return psk;
+}
+
+
+static void ap_harness_psk_selected(void *ctx, const u8 *addr,
+				    const u8 *p2p_dev_addr, const u8 *psk)
+{
+	struct ap_harness_wpa *w = ctx;
+
+	if (w->get_psk == NULL)
+		hostapd_wpa_psk_selected(w->conf, addr, p2p_dev_addr, psk);
+}
+
+
+static int ap_harness_send_eapol(void *ctx, const u8 *addr, const u8 *data,
+				 size_t data_len, int encrypt)
+{
+	struct ap_harness_wpa *w = ctx;
+	const struct wpa_eapol_key *key;
+
+	if (data_len < sizeof(struct ieee802_1x_hdr) + sizeof(*key))
+		return -1;
+	key = (const struct wpa_eapol_key *)
+		(data + sizeof(struct ieee802_1x_hdr));
+	w->key_info = WPA_GET_BE16(key->key_info);
+	os_memcpy(w->anonce, key->key_nonce, WPA_NONCE_LEN);
+	os_memcpy(w->replay_counter, key->replay_counter,
+		  WPA_REPLAY_COUNTER_LEN);
+	if (w->waiting && (w->key_info & WPA_KEY_INFO_INSTALL))
+		eloop_terminate();
+	return 0;
+}
+
+
+static void ap_harness_psk_failure_report(void *ctx, const u8 *addr)
+{
+	struct ap_harness_wpa *w = ctx;
+
+	w->psk_failure = 1;
+	if (w->waiting)
+		eloop_terminate();
+}
+
+
+static void ap_harness_wpa_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	eloop_terminate();
+}
+
+
+static int ap_harness_set_key(void *ctx, int vlan_id, enum wpa_alg alg,
+			      const u8 *addr, int idx, u8 *key,
+			      size_t key_len)
+{
+	return 0;
+}
+
+
+int ap_harness_wpa_init(struct ap_harness_wpa *w)
+{
+	struct wpa_auth_config conf;
+	struct wpa_auth_callbacks cb;
+
+	os_memset(w, 0, sizeof(*w));
+	os_memcpy(w->auth_addr, "\x02\x00\x00\x00\x03\x00", ETH_ALEN);
+	os_memcpy(w->sta_addr, "\x02\x00\x00\x00\x00\x01", ETH_ALEN);
+	os_get_random(w->psk, PMK_LEN);
+	w->iconf = hostapd_config_defaults();
+	if (w->iconf == NULL)
+		return -1;
+	w->conf = w->iconf->bss[0];
+
+	os_memset(&conf, 0, sizeof(conf));
+	conf.wpa = WPA_PROTO_RSN;
+	conf.wpa_key_mgmt = WPA_KEY_MGMT_PSK;
+	conf.wpa_pairwise = WPA_CIPHER_CCMP;
+	conf.rsn_pairwise = WPA_CIPHER_CCMP;
+	conf.wpa_group = WPA_CIPHER_CCMP;
+	conf.eapol_version = 2;
+
+	os_memset(&cb, 0, sizeof(cb));
+	cb.ctx = w;
+	cb.send_eapol = ap_harness_send_eapol;
+	cb.get_psk = ap_harness_get_psk;
+	cb.psk_selected = ap_harness_psk_selected;
+	cb.psk_failure_report = ap_harness_psk_failure_report;
+	cb.set_key = ap_harness_set_key;
+
+	w->auth = wpa_init(w->auth_addr, &conf, &cb);
+	return w->auth ? 0 : -1;
+}
+
+
+void ap_harness_wpa_deinit(struct ap_harness_wpa *w)
+{
+	if (w->auth)
+		wpa_deinit(w->auth);
+	w->auth = NULL;
+	hostapd_config_free(w->iconf);
+	w->iconf = NULL;
+	w->conf = NULL;
+}
+
+
+/**
+ * ap_harness_wpa_add_psk - Add a PSK in front of the PSK list
+ * @w: Authenticator from ap_harness_wpa_init()
+ * @addr: Station address or %NULL for a PSK for any station
+ * @psk: PSK or %NULL for a random one
+ * Returns: 0 on success, -1 on failure
+ */
+int ap_harness_wpa_add_psk(struct ap_harness_wpa *w, const u8 *addr,
+			   const u8 *psk)
+{
+	struct hostapd_wpa_psk *p;
+
+	p = os_zalloc(sizeof(*p));
+	if (p == NULL)
+		return -1;
+	if (addr)
+		os_memcpy(p->addr, addr, ETH_ALEN);
+	else
+		p->group = 1;
+	if (psk)
+		os_memcpy(p->psk, psk, PMK_LEN);
+	else
+		os_get_random(p->psk, PMK_LEN);
+	p->next = w->conf->ssid.wpa_psk;
+	w->conf->ssid.wpa_psk = p;
+	return 0;
+}
+
+
+static size_t ap_harness_build_msg2(struct ap_harness_wpa *w, u8 *buf)
+{
+	struct ieee802_1x_hdr *hdr = (struct ieee802_1x_hdr *) buf;
+	struct wpa_eapol_key *key = (struct wpa_eapol_key *) (hdr + 1);
+	struct wpa_ptk ptk;
+	u8 snonce[WPA_NONCE_LEN];
+	size_t len = sizeof(*hdr) + sizeof(*key) + sizeof(ap_harness_rsn_ie);
+	u16 key_info;
+
+	os_memset(buf, 0, len);
+	hdr->version = EAPOL_VERSION;
+	hdr->type = IEEE802_1X_TYPE_EAPOL_KEY;
+	WPA_PUT_BE16((u8 *) &hdr->length, len - sizeof(*hdr));
+
+	os_get_random(snonce, WPA_NONCE_LEN);
+	key->type = EAPOL_KEY_TYPE_RSN;
+	key_info = WPA_KEY_INFO_TYPE_HMAC_SHA1_AES | WPA_KEY_INFO_KEY_TYPE |
+		WPA_KEY_INFO_MIC;
+	WPA_PUT_BE16(key->key_info, key_info);
+	os_memcpy(key->replay_counter, w->replay_counter,
+		  WPA_REPLAY_COUNTER_LEN);
+	os_memcpy(key->key_nonce, snonce, WPA_NONCE_LEN);
+	WPA_PUT_BE16(key->key_data_length, sizeof(ap_harness_rsn_ie));
+	os_memcpy(key + 1, ap_harness_rsn_ie, sizeof(ap_harness_rsn_ie));
+
+	wpa_pmk_to_ptk(w->psk, PMK_LEN, "Pairwise key expansion",
+		       w->sta_addr, w->auth_addr, snonce, w->anonce, &ptk,
+		       WPA_KEY_MGMT_PSK, WPA_CIPHER_CCMP);
+	wpa_eapol_key_mic(ptk.kck, ptk.kck_len, WPA_KEY_MGMT_PSK,
+			  key_info & WPA_KEY_INFO_TYPE_MASK, buf, len,
+			  key->key_mic);
+	return len;
+}
+
+
+/**
+ * ap_harness_wpa_handshake - Run a 4-way handshake up to msg 3/4
+ * @w: Authenticator from ap_harness_wpa_init()
+ * @secs: Buffer for the time spent processing msg 2/4 or %NULL
+ * Returns: 0 if msg 3/4 was sent, i.e., the station PSK was found, or -1
+ */
+int ap_harness_wpa_handshake(struct ap_harness_wpa *w, double *secs)
+{
+	struct wpa_state_machine *sm;
+	struct os_reltime start;
+	u8 buf[256];
+	size_t len;
+
+	sm = wpa_auth_sta_init(w->auth, w->sta_addr, NULL);
+	if (sm == NULL ||
+	    wpa_validate_wpa_ie(w->auth, sm, ap_harness_rsn_ie,
+				sizeof(ap_harness_rsn_ie), NULL, 0) !=
+	    WPA_IE_OK) {
+		wpa_auth_sta_deinit(sm);
+		return -1;
+	}
+	wpa_auth_sm_event(sm, WPA_ASSOC);
+	w->key_info = 0;
+	wpa_auth_sta_associated(w->auth, sm);
+	if (!(w->key_info & WPA_KEY_INFO_ACK)) {
+		wpa_auth_sta_deinit(sm);
+		return -1;
+	}
+
+	len = ap_harness_build_msg2(w, buf);
+	w->key_info = 0;
+	w->psk_candidates = 0;
+	w->psk_failure = 0;
+	os_get_reltime(&start);
+	wpa_receive(w->auth, sm, buf, len);
+	w->psk_candidates_rx = w->psk_candidates;
+	if (!(w->key_info & WPA_KEY_INFO_INSTALL) && !w->psk_failure &&
+	    !w->no_wait) {
+		/* The remaining PSK trials run from the event loop */
+		w->waiting = 1;
+		eloop_register_timeout(5, 0, ap_harness_wpa_timeout, w, NULL);
+		eloop_run();
+		eloop_cancel_timeout(ap_harness_wpa_timeout, w, NULL);
+		w->waiting = 0;
+	}
+	if (secs)
+		*secs = ap_harness_elapsed(&start);
+	wpa_auth_sta_deinit(sm);
+
+	/* msg 3/4 is sent only if the MIC matched */
+	return (w->key_info & WPA_KEY_INFO_INSTALL) ? 0 : -1;
+}
@@ -0,0 +1,88 @@
+/*
+ * Harness for running AP code in tests and benchmarks
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef AP_HARNESS_H
+#define AP_HARNESS_H
+
+#include "common/wpa_common.h"
+#include "ap/hostapd.h"
+
+/**
+ * struct ap_harness - A single BSS without a kernel driver
+ * @iface: Interface data; iface.bss has just @hapd
+ * @hapd: BSS data; hapd.conf and hapd.iconf have the default configuration
+ *	with SSID "test"
+ * @bss: BSS pointer array for iface.bss
+ * @driver: Driver operations; send_mlme() records the transmitted frames
+ * @sent: Number of frames passed to send_mlme()
+ * @sent_bytes: Total length of the frames passed to send_mlme()
+ * @frame: Copy of the last frame passed to send_mlme()
+ * @frame_len: Length of @frame or 0 if it did not fit in the buffer
+ */
+struct ap_harness {
+	struct hostapd_iface iface;
+	struct hostapd_data hapd;
+	struct hostapd_data *bss[1];
+	struct wpa_driver_ops driver;
+	unsigned int sent;
+	size_t sent_bytes;
+	u8 frame[1500];
+	size_t frame_len;
+};
+
+int ap_harness_init(struct ap_harness *h);
+void ap_harness_deinit(struct ap_harness *h);
+double ap_harness_elapsed(struct os_reltime *start);
+
+/**
+ * struct ap_harness_wpa - WPA2-PSK authenticator for one station
+ * @iconf: Configuration; the PSKs are in conf->ssid.wpa_psk
+ * @conf: BSS configuration
+ * @auth: Authenticator
+ * @auth_addr: Authenticator address
+ * @sta_addr: Station address
+ * @psk: PSK used by the station
+ * @get_psk: Optional replacement for hostapd_get_psk(); the selected PSK is
+ *	not reported to hostapd_wpa_psk_selected() when this is set
+ * @psk_candidates: Number of PSKs returned by get_psk since the last call to
+ *	ap_harness_wpa_handshake()
+ * @psk_candidates_rx: Number of those returned before wpa_receive() of msg
+ *	2/4 returned, i.e., before the event loop continued the trials
+ * @no_wait: Remove the station right after msg 2/4 instead of running the
+ *	event loop for the remaining PSK trials
+ */
+struct ap_harness_wpa {
+	struct hostapd_config *iconf;
+	struct hostapd_bss_config *conf;
+	struct wpa_authenticator *auth;
+	u8 auth_addr[ETH_ALEN];
+	u8 sta_addr[ETH_ALEN];
+	u8 psk[PMK_LEN];
+	const u8 * (*get_psk)(struct ap_harness_wpa *w, const u8 *addr,
+			      const u8 *prev_psk);
+	unsigned int psk_candidates;
+	unsigned int psk_candidates_rx;
+	int no_wait;
+
+	/* Last EAPOL-Key frame from the authenticator */
+	u8 anonce[WPA_NONCE_LEN];
+	u8 replay_counter[WPA_REPLAY_COUNTER_LEN];
+	u16 key_info;
+
+	/* Whether psk_failure_report was called for the last msg 2/4 */
+	int psk_failure;
+	/* Set while the event loop runs the remaining PSK trials */
+	int waiting;
+};
+
+int ap_harness_wpa_init(struct ap_harness_wpa *w);
+void ap_harness_wpa_deinit(struct ap_harness_wpa *w);
+int ap_harness_wpa_add_psk(struct ap_harness_wpa *w, const u8 *addr,
+			   const u8 *psk);
+int ap_harness_wpa_handshake(struct ap_harness_wpa *w, double *secs);
+
+#endif /* AP_HARNESS_H */
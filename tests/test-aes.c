@@ -11,46 +11,10 @@
 #include "common.h"
 #include "crypto/crypto.h"
 #include "crypto/aes_wrap.h"
+#include "crypto/aes_i.h"
 
 #define BLOCK_SIZE 16
 
-static void test_aes_perf(void)
-{
-#if 0 /* this did not seem to work with new compiler?! */
-#ifdef __i386__
-#define rdtscll(val) \
-     __asm__ __volatile__("rdtsc" : "=A" (val))
-	const int num_iters = 10;
-	int i;
-	unsigned int start, end;
-	u8 key[16], pt[16], ct[16];
-	void *ctx;
-
-	printf("keySetupEnc:");
-	for (i = 0; i < num_iters; i++) {
-		rdtscll(start);
-		ctx = aes_encrypt_init(key, 16);
-		rdtscll(end);
-		aes_encrypt_deinit(ctx);
-		printf(" %d", end - start);
-	}
-	printf("\n");
-
-	printf("Encrypt:");
-	ctx = aes_encrypt_init(key, 16);
-	for (i = 0; i < num_iters; i++) {
-		rdtscll(start);
-		aes_encrypt(ctx, pt, ct);
-		rdtscll(end);
-		printf(" %d", end - start);
-	}
-	aes_encrypt_deinit(ctx);
-	printf("\n");
-#endif /* __i386__ */
-#endif
-}
-
-
 /*
  * GCM test vectors from
  * http://csrc.nist.gov/groups/ST/toolkit/BCM/documents/proposedmodes/gcm/gcm-spec.pdf
@@ -604,6 +568,182 @@ static int test_nist_key_wrap_ad(const char *fname)
 }
 
 
+/* Compare the CPU instruction based implementation against the portable one
+ * with keys that are set up separately for each */
+static int test_cpu(void)
+{
+	static const size_t key_lens[] = { 16, 24, 32 };
+	u8 key[32], nonce[16], data[8 * 16 + 5], out[8 * 16 + 5], tag[16];
+	u8 ref[8 * 16 + 5], ref_tag[16];
+	void *enc, *enc_c, *dec;
+	unsigned int i, k;
+	size_t len;
+	int ret = 0;
+
+	if (!aes_use_cpu(1)) {
+		printf("AES CPU instructions not available\n");
+		return 0;
+	}
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i * 13 + 1;
+
+	for (k = 0; k < ARRAY_SIZE(key_lens); k++) {
+		for (i = 0; i < sizeof(key); i++)
+			key[i] = k * 31 + i * 7;
+		aes_use_cpu(0);
+		enc_c = aes_encrypt_init(key, key_lens[k]);
+		aes_use_cpu(1);
+		enc = aes_encrypt_init(key, key_lens[k]);
+		dec = aes_decrypt_init(key, key_lens[k]);
+		if (!enc_c || !enc || !dec) {
+			ret++;
+			goto next;
+		}
+
+		/* Batched encryption of eight blocks against one block at a
+		 * time with the portable implementation */
+		aes_encrypt_blocks(enc, data, out, 8);
+		for (i = 0; i < 8; i++)
+			aes_encrypt(enc_c, &data[i * 16], &ref[i * 16]);
+		if (os_memcmp(out, ref, 8 * 16) != 0) {
+			printf("AES-%u CPU instruction mismatch\n",
+			       (unsigned int) key_lens[k] * 8);
+			ret++;
+		}
+		for (i = 0; i < 8; i++)
+			aes_decrypt(dec, &ref[i * 16], &out[i * 16]);
+		if (os_memcmp(out, data, 8 * 16) != 0) {
+			printf("AES-%u CPU instruction decryption mismatch\n",
+			       (unsigned int) key_lens[k] * 8);
+			ret++;
+		}
+
+	next:
+		if (enc_c)
+			aes_encrypt_deinit(enc_c);
+		if (enc)
+			aes_encrypt_deinit(enc);
+		if (dec)
+			aes_decrypt_deinit(dec);
+	}
+
+	os_memset(nonce, 0x5a, sizeof(nonce));
+	for (len = 0; len <= sizeof(data); len++) {
+		aes_use_cpu(0);
+		aes_gcm_use_cpu(0);
+		if (aes_ccm_ae(key, 16, nonce, 8, data, len, data + 1, 22,
+			       ref, ref_tag) < 0)
+			ret++;
+		aes_use_cpu(1);
+		aes_gcm_use_cpu(1);
+		if (aes_ccm_ae(key, 16, nonce, 8, data, len, data + 1, 22,
+			       out, tag) < 0 ||
+		    os_memcmp(out, ref, len) != 0 ||
+		    os_memcmp(tag, ref_tag, 8) != 0) {
+			printf("AES-CCM CPU instruction mismatch with length %u\n",
+			       (unsigned int) len);
+			ret++;
+			break;
+		}
+
+		aes_use_cpu(0);
+		aes_gcm_use_cpu(0);
+		if (aes_gcm_ae(key, 32, nonce, 12, data, len, data + 1, 22,
+			       ref, ref_tag) < 0)
+			ret++;
+		aes_use_cpu(1);
+		aes_gcm_use_cpu(1);
+		if (aes_gcm_ae(key, 32, nonce, 12, data, len, data + 1, 22,
+			       out, tag) < 0 ||
+		    os_memcmp(out, ref, len) != 0 ||
+		    os_memcmp(tag, ref_tag, 16) != 0) {
+			printf("AES-GCM CPU instruction mismatch with length %u\n",
+			       (unsigned int) len);
+			ret++;
+			break;
+		}
+	}
+
+	if (!ret)
+		printf("AES CPU instructions match the portable implementation\n");
+	return ret;
+}
+
+
+static double elapsed(struct os_reltime *start)
+{
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	return diff.sec + diff.usec / 1000000.0;
+}
+
+
+enum aes_bench_mode {
+	AES_BENCH_BLOCK, AES_BENCH_CTR, AES_BENCH_CCM, AES_BENCH_GCM
+};
+
+/* Throughput in MB/s with 1500 octet frames */
+static double aes_bench(enum aes_bench_mode mode)
+{
+	static u8 frame[1500], out[1500];
+	u8 key[16], nonce[16], aad[22], tag[16];
+	struct os_reltime start;
+	unsigned int count = 0;
+	void *ctx;
+	size_t i;
+	double t;
+	int res = 0;
+
+	os_memset(key, 0x11, sizeof(key));
+	os_memset(nonce, 0x22, sizeof(nonce));
+	os_memset(aad, 0x33, sizeof(aad));
+
+	os_get_reltime(&start);
+	do {
+		switch (mode) {
+		case AES_BENCH_BLOCK:
+			ctx = aes_encrypt_init(key, sizeof(key));
+			if (!ctx)
+				return 0;
+			for (i = 0; i + 16 <= sizeof(frame); i += 16)
+				aes_encrypt(ctx, &frame[i], &out[i]);
+			aes_encrypt_deinit(ctx);
+			break;
+		case AES_BENCH_CTR:
+			res = aes_128_ctr_encrypt(key, nonce, frame,
+						  sizeof(frame));
+			break;
+		case AES_BENCH_CCM:
+			res = aes_ccm_ae(key, sizeof(key), nonce, 8, frame,
+					 sizeof(frame), aad, sizeof(aad), out,
+					 tag);
+			break;
+		case AES_BENCH_GCM:
+			res = aes_gcm_ae(key, sizeof(key), nonce, 12, frame,
+					 sizeof(frame), aad, sizeof(aad), out,
+					 tag);
+			break;
+		}
+		if (res < 0)
+			return 0;
+		count++;
+	} while ((t = elapsed(&start)) < 0.1);
+
+	return count * sizeof(frame) / t / 1000000;
+}
+
+
+static void test_aes_perf(const char *name)
+{
+	printf("AES-128 %s: single block %.1f MB/s, CTR %.1f MB/s, CCM %.1f MB/s, GCM %.1f MB/s\n",
+	       name, aes_bench(AES_BENCH_BLOCK), aes_bench(AES_BENCH_CTR),
+	       aes_bench(AES_BENCH_CCM), aes_bench(AES_BENCH_GCM));
+}
+
+
 int main(int argc, char *argv[])
 {
 	int ret = 0;
@@ -613,9 +753,19 @@ int main(int argc, char *argv[])
 	else if (argc >= 3 && os_strcmp(argv[1], "NIST-KW-AD") == 0)
 		ret += test_nist_key_wrap_ad(argv[2]);
 
-	test_aes_perf();
-
+	aes_use_cpu(0);
+	aes_gcm_use_cpu(0);
+	ret += test_gcm();
+	aes_use_cpu(1);
+	aes_gcm_use_cpu(1);
 	ret += test_gcm();
+	ret += test_cpu();
+
+	aes_use_cpu(0);
+	aes_gcm_use_cpu(0);
+	test_aes_perf("portable");
+	if (aes_use_cpu(1) | aes_gcm_use_cpu(1))
+		test_aes_perf("CPU instructions");
 
 	if (ret)
 		printf("FAILED!\n");
@@ -0,0 +1,291 @@
+/*
+ * Probe Response templates and rate limits - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/ieee802_11_defs.h"
+#include "common/ieee802_11_common.h"
+#include "ap/hostapd.h"
+#include "ap/ap_config.h"
+#include "ap/beacon.h"
+#include "ap/taxonomy.h"
+#include "ap_harness.h"
+#include "test_util.h"
+
+
+static size_t build_probe_req(u8 *buf, const u8 *da, const u8 *sa,
+			      const char *ssid)
+{
+	struct ieee80211_mgmt *mgmt = (struct ieee80211_mgmt *) buf;
+	size_t ssid_len = ssid ? os_strlen(ssid) : 0;
+	u8 *pos;
+
+	os_memset(buf, 0, IEEE80211_HDRLEN);
+	mgmt->frame_control = IEEE80211_FC(WLAN_FC_TYPE_MGMT,
+					   WLAN_FC_STYPE_PROBE_REQ);
+	os_memcpy(mgmt->da, da, ETH_ALEN);
+	os_memcpy(mgmt->sa, sa, ETH_ALEN);
+	os_memset(mgmt->bssid, 0xff, ETH_ALEN);
+
+	pos = mgmt->u.probe_req.variable;
+	*pos++ = WLAN_EID_SSID;
+	*pos++ = ssid_len;
+	os_memcpy(pos, ssid, ssid_len);
+	pos += ssid_len;
+	*pos++ = WLAN_EID_SUPP_RATES;
+	*pos++ = 8;
+	os_memcpy(pos, "\x82\x84\x8b\x96\x0c\x12\x18\x24", 8);
+	pos += 8;
+
+	return pos - buf;
+}
+
+
+static int probe_to(struct ap_harness *h, const u8 *da, const u8 *sa,
+		    const char *ssid)
+{
+	u8 buf[IEEE80211_HDRLEN + 64];
+	unsigned int sent = h->sent;
+	size_t len;
+
+	len = build_probe_req(buf, da, sa, ssid);
+	handle_probe_req(&h->hapd, (struct ieee80211_mgmt *) buf, len, -40);
+	return h->sent != sent;
+}
+
+
+/* Send a broadcast Probe Request and return 1 if a Probe Response was sent */
+static int probe(struct ap_harness *h, const u8 *sa, const char *ssid)
+{
+	return probe_to(h, broadcast_ether_addr, sa, ssid);
+}
+
+
+/* Send count Probe Requests from sa and return the number of responses */
+static int probes(struct ap_harness *h, const u8 *sa, int count)
+{
+	int i, resp = 0;
+
+	for (i = 0; i < count; i++)
+		resp += probe(h, sa, NULL);
+	return resp;
+}
+
+
+static int set_ap(void *priv, struct wpa_driver_ap_params *params)
+{
+	return 0;
+}
+
+
+static const u8 * resp_elem(struct ap_harness *h, u8 eid)
+{
+	const struct ieee80211_mgmt *resp =
+		(const struct ieee80211_mgmt *) h->frame;
+	const u8 *pos = resp->u.probe_resp.variable;
+	const u8 *end = h->frame + h->frame_len;
+
+	while (end - pos >= 2 && end - pos - 2 >= pos[1]) {
+		if (pos[0] == eid)
+			return pos;
+		pos += 2 + pos[1];
+	}
+	return NULL;
+}
+
+
+static void test_probe_resp_tmpl(struct ap_harness *h)
+{
+	const u8 sta1[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	const u8 sta2[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+	struct hostapd_data *hapd = &h->hapd;
+	const struct ieee80211_mgmt *resp;
+	u8 first[sizeof(h->frame)];
+	size_t first_len;
+	const u8 *tmpl, *elem;
+
+	/* The first request builds the template */
+	check(probe(h, sta1, NULL), "response to wildcard SSID");
+	resp = (const struct ieee80211_mgmt *) h->frame;
+	check(h->frame_len > IEEE80211_HDRLEN &&
+	      WLAN_FC_GET_STYPE(le_to_host16(resp->frame_control)) ==
+	      WLAN_FC_STYPE_PROBE_RESP, "Probe Response frame");
+	check(os_memcmp(resp->da, sta1, ETH_ALEN) == 0 &&
+	      os_memcmp(resp->sa, hapd->own_addr, ETH_ALEN) == 0 &&
+	      os_memcmp(resp->bssid, hapd->own_addr, ETH_ALEN) == 0,
+	      "response addresses");
+	elem = resp_elem(h, WLAN_EID_SSID);
+	check(elem && elem[1] == 4 && os_memcmp(elem + 2, "test", 4) == 0,
+	      "response SSID");
+	tmpl = hapd->probe_resp_tmpl[0].buf;
+	check(tmpl != NULL, "template cached");
+	os_memcpy(first, h->frame, h->frame_len);
+	first_len = h->frame_len;
+
+	/* Requests from other stations reuse it with only DA changed */
+	check(probe(h, sta2, "test"), "response to own SSID");
+	resp = (const struct ieee80211_mgmt *) h->frame;
+	check(hapd->probe_resp_tmpl[0].buf == tmpl, "template reused");
+	check(h->frame_len == first_len &&
+	      os_memcmp(resp->da, sta2, ETH_ALEN) == 0 &&
+	      os_memcmp(h->frame + 10, first + 10, first_len - 10) == 0,
+	      "response matches template");
+
+	check(!probe(h, sta1, "other"), "no response to foreign SSID");
+
+	/* Configuration changes take effect with the next Beacon update */
+	hapd->conf->interworking = 1;
+	ieee802_11_set_beacon(hapd);
+	check(hapd->probe_resp_tmpl[0].buf == NULL,
+	      "template dropped on Beacon update");
+	check(probe(h, sta1, NULL) && resp_elem(h, WLAN_EID_INTERWORKING),
+	      "rebuilt template");
+	hapd->conf->interworking = 0;
+
+	/* The BSS Load station count is patched for each response */
+	hapd->conf->bss_load_update_period = 100;
+	hostapd_probe_resp_tmpl_flush(hapd);
+	hapd->num_sta = 3;
+	check(probe(h, sta1, NULL), "response with BSS Load");
+	elem = resp_elem(h, WLAN_EID_BSS_LOAD);
+	check(elem && elem[1] >= 5 && WPA_GET_LE16(elem + 2) == 3,
+	      "BSS Load station count");
+	hapd->num_sta = 7;
+	check(probe(h, sta2, NULL), "second response with BSS Load");
+	elem = resp_elem(h, WLAN_EID_BSS_LOAD);
+	check(elem && elem[1] >= 5 && WPA_GET_LE16(elem + 2) == 7,
+	      "updated BSS Load station count");
+	hapd->num_sta = 0;
+	hapd->conf->bss_load_update_period = 0;
+	hostapd_probe_resp_tmpl_flush(hapd);
+}
+
+
+static void test_probe_resp_limit(struct ap_harness *h)
+{
+	u8 sta[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x01, 0x00 };
+	u8 other[ETH_ALEN];
+	struct hostapd_data *hapd = &h->hapd;
+	struct hostapd_bss_config *conf = hapd->conf;
+	int i, resp;
+
+	/* Repeats within the window are dropped per source and SSID */
+	conf->probe_resp_dedup_window = 100;
+	check(probes(h, sta, 3) == 1 && hapd->probe_resp_dedup == 2,
+	      "dedup window");
+	check(probe(h, sta, "test"), "dedup for another SSID");
+	sta[5]++;
+	check(probe(h, sta, NULL), "dedup for another source");
+	check(probe_to(h, hapd->own_addr, sta, NULL),
+	      "directed request within dedup window");
+	os_sleep(0, 150000);
+	check(probe(h, sta, NULL), "response after dedup window");
+	conf->probe_resp_dedup_window = 0;
+
+	/* The bucket allows burst responses and then refills at rate/s */
+	sta[5]++;
+	conf->probe_resp_rate = 10;
+	conf->probe_resp_burst = 3;
+	check(probes(h, sta, 5) == 3 && hapd->probe_resp_limited == 2,
+	      "per-source burst");
+	os_sleep(0, 150000);
+	check(probes(h, sta, 3) == 1, "per-source refill");
+	sta[5]++;
+	check(probes(h, sta, 3) == 3, "per-source bucket for another source");
+	conf->probe_resp_burst = 0;
+	sta[5]++;
+	check(probes(h, sta, 12) == 10, "burst defaults to rate");
+	conf->probe_resp_rate = 0;
+
+	/*
+	 * Sources that share the last three octets keep their own buckets;
+	 * these took over each other's slot in the unkeyed table.
+	 */
+	sta[5]++;
+	conf->probe_resp_rate = 10;
+	conf->probe_resp_burst = 3;
+	os_memcpy(other, sta, ETH_ALEN);
+	for (i = 1; i < 256; i++) {
+		other[0] = 0x02 | (i << 2);
+		if (((hwaddr_hash(hapd->probe_source_key, sta) ^
+		      hwaddr_hash(hapd->probe_source_key, other)) &
+		     (PROBE_SOURCE_TABLE_SIZE - 1)) != 0)
+			break;
+	}
+	check(probes(h, sta, 3) == 3 && probes(h, other, 3) == 3 &&
+	      probes(h, sta, 1) == 0, "per-source bucket for similar source");
+	conf->probe_resp_rate = 0;
+	conf->probe_resp_burst = 0;
+
+	/* The radio-wide ceiling covers all sources */
+	hapd->iconf->probe_resp_max_rate = 4;
+	for (i = 0, resp = 0; i < 8; i++) {
+		sta[4] = 0x10 + i;
+		resp += probe(h, sta, NULL);
+	}
+	check(resp == 4 && h->iface.probe_resp_global_limited == 4,
+	      "global max rate");
+	check(probe_to(h, hapd->own_addr, sta, NULL),
+	      "directed request over global max rate");
+	hapd->iconf->probe_resp_max_rate = 0;
+}
+
+
+static int taxonomy_cached(struct hostapd_data *hapd, const u8 *addr)
+{
+	size_t i;
+
+	for (i = 0; hapd->taxonomy_cache && i < TAXONOMY_CACHE_SIZE; i++) {
+		if (hapd->taxonomy_cache[i].ie &&
+		    os_memcmp(hapd->taxonomy_cache[i].addr, addr,
+			      ETH_ALEN) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+
+static void test_probe_taxonomy(struct ap_harness *h)
+{
+	u8 sta[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x02, 0x00 };
+
+	/* Only answered Probe Requests are kept for the signature */
+	check(!probe(h, sta, "other") && !taxonomy_cached(&h->hapd, sta),
+	      "foreign SSID not cached");
+	check(probe(h, sta, "test") && taxonomy_cached(&h->hapd, sta),
+	      "answered request cached");
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct ap_harness h;
+
+	test_init("ap-probe");
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+	if (eloop_init() < 0)
+		return -1;
+
+	if (ap_harness_init(&h) < 0) {
+		check(0, "harness init");
+	} else {
+		h.driver.set_ap = set_ap;
+		test_probe_resp_tmpl(&h);
+		test_probe_resp_limit(&h);
+		test_probe_taxonomy(&h);
+	}
+	ap_harness_deinit(&h);
+
+	eloop_destroy();
+	os_program_deinit();
+
+	return test_result();
+}
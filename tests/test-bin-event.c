@@ -0,0 +1,293 @@
+/*
+ * Binary control interface events - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "common/wpa_ctrl.h"
+#include "ap/hostapd.h"
+#include "ap/sta_info.h"
+#include "ap/taxonomy.h"
+#include "ap/steering.h"
+#include "ap/bin_event.h"
+#include "ap_harness.h"
+#include "test_util.h"
+
+#define MAX_ATTRS 8
+
+static const u8 sta_addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x01, 0x00 };
+
+static const u8 probe_ie[] = {
+	0x00, 0x00, /* SSID: wildcard */
+	0x01, 0x04, 0x02, 0x04, 0x0b, 0x16, /* Supported Rates */
+	0x03, 0x01, 0x06, /* DS Parameter Set */
+	0x21, 0x02, 0x00, 0x14, /* Power Capability */
+};
+
+static const u8 assoc_ie[] = {
+	0x00, 0x04, 't', 'e', 's', 't', /* SSID */
+	0x01, 0x04, 0x02, 0x04, 0x0b, 0x16, /* Supported Rates */
+	0x7f, 0x01, 0x04, /* Extended Capabilities */
+};
+
+/* Last binary event passed to bin_event_cb */
+static u8 bin_buf[1000];
+static size_t bin_len;
+static unsigned int bin_count;
+
+/* Last text event passed to the wpa_msg() callback */
+static char text_buf[1000];
+static unsigned int text_count;
+
+struct bin_attr {
+	u16 type;
+	u16 len;
+	const u8 *data;
+};
+
+
+static void bin_event_cb(const struct hostapd_data *hapd, const u8 *buf,
+			 size_t len)
+{
+	bin_count++;
+	bin_len = len <= sizeof(bin_buf) ? len : 0;
+	os_memcpy(bin_buf, buf, bin_len);
+}
+
+
+static void text_event_cb(void *ctx, int level, enum wpa_msg_type type,
+			  const char *txt, size_t len)
+{
+	text_count++;
+	os_strlcpy(text_buf, txt, sizeof(text_buf));
+}
+
+
+/*
+ * Decode the last binary event. Returns the number of attributes or -1 if
+ * the header does not match @type or the lengths are not consistent.
+ */
+static int decode(u16 type, struct bin_attr *attrs)
+{
+	const u8 *pos = bin_buf, *end = bin_buf + bin_len;
+	int num = 0;
+
+	if (bin_len < BIN_EVENT_HDR_LEN || pos[0] != BIN_EVENT_MAGIC ||
+	    pos[1] != BIN_EVENT_VERSION || WPA_GET_LE16(&pos[2]) != type ||
+	    WPA_GET_LE16(&pos[4]) != bin_len - BIN_EVENT_HDR_LEN)
+		return -1;
+	pos += BIN_EVENT_HDR_LEN;
+
+	while (end - pos >= 4 && num < MAX_ATTRS) {
+		attrs[num].type = WPA_GET_LE16(pos);
+		attrs[num].len = WPA_GET_LE16(pos + 2);
+		pos += 4;
+		if (attrs[num].len > end - pos)
+			return -1;
+		attrs[num].data = pos;
+		pos += attrs[num].len;
+		num++;
+	}
+
+	return pos == end ? num : -1;
+}
+
+
+static int attr_is(const struct bin_attr *attr, u16 type, const void *data,
+		   size_t len)
+{
+	return attr->type == type && attr->len == len &&
+		os_memcmp(attr->data, data, len) == 0;
+}
+
+
+static void test_builder(struct hostapd_data *hapd)
+{
+	struct bin_attr attrs[MAX_ATTRS];
+	struct wpabuf *ev;
+	u8 big[100];
+
+	hapd->ctrl_bin_monitors = 0;
+	check(hostapd_bin_event_start(hapd, BIN_EVENT_STA_STEERING, 0, 0) ==
+	      NULL, "no event without binary monitors");
+	hapd->bin_event_cb = NULL;
+	hapd->ctrl_bin_monitors = 1;
+	check(hostapd_bin_event_start(hapd, BIN_EVENT_STA_STEERING, 0, 0) ==
+	      NULL, "no event without a control interface");
+	hapd->bin_event_cb = bin_event_cb;
+
+	ev = hostapd_bin_event_start(hapd, BIN_EVENT_STA_STEERING,
+				     ETH_ALEN + 4, 2);
+	if (ev == NULL) {
+		check(0, "event started");
+		return;
+	}
+	bin_count = 0;
+	hostapd_bin_event_put_addr(ev, sta_addr);
+	hostapd_bin_event_put_s32(ev, BIN_ATTR_SIGNAL, -70);
+	/* An attribute that was not reserved is left out */
+	os_memset(big, 0xaa, sizeof(big));
+	hostapd_bin_event_put(ev, BIN_ATTR_TAXONOMY_PROBE, big, sizeof(big));
+	hostapd_bin_event_send(hapd, ev);
+	check(bin_count == 1 &&
+	      decode(BIN_EVENT_STA_STEERING, attrs) == 2 &&
+	      attr_is(&attrs[0], BIN_ATTR_ADDR, sta_addr, ETH_ALEN) &&
+	      attr_is(&attrs[1], BIN_ATTR_SIGNAL, "\xba\xff\xff\xff", 4),
+	      "header and attributes");
+
+	bin_count = 0;
+	hostapd_bin_event_send(hapd, NULL);
+	check(bin_count == 0, "no event sent for NULL");
+}
+
+
+static void test_text_wanted(struct hostapd_data *hapd)
+{
+	hapd->ctrl_bin_monitors = 0;
+	hapd->ctrl_text_monitors = 0;
+	check(hostapd_text_event_wanted(hapd), "text without monitors");
+	hapd->ctrl_text_monitors = 1;
+	check(hostapd_text_event_wanted(hapd), "text for text monitors");
+	hapd->ctrl_bin_monitors = 1;
+	check(hostapd_text_event_wanted(hapd),
+	      "text for text and binary monitors");
+	hapd->ctrl_text_monitors = 0;
+	check(!hostapd_text_event_wanted(hapd),
+	      "no text for binary monitors only");
+	wpa_debug_level = MSG_INFO;
+	check(hostapd_text_event_wanted(hapd), "text for the debug log");
+	wpa_debug_level = MSG_ERROR;
+
+	/* A monitor with BINARY_EVENTS 1 does not get the text form of the
+	 * events that have a binary form */
+	check(hostapd_bin_event_text(AP_STA_STEERING MACSTR) &&
+	      hostapd_bin_event_text(AP_STA_NO_STEERING MACSTR) &&
+	      hostapd_bin_event_text(AP_STA_TAXONOMY MACSTR),
+	      "text form of binary events");
+	check(!hostapd_bin_event_text(AP_STA_CONNECTED MACSTR) &&
+	      !hostapd_bin_event_text("AP-STA-STEERING-X") &&
+	      !hostapd_bin_event_text(""), "text only events");
+}
+
+
+static void taxonomy_event(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	os_memset(sta, 0, sizeof(*sta));
+	os_memcpy(sta->addr, sta_addr, ETH_ALEN);
+	bin_count = text_count = 0;
+	hostapd_taxonomy_probe_req(hapd, sta, probe_ie, sizeof(probe_ie));
+	hostapd_taxonomy_assoc_req(hapd, sta, assoc_ie, sizeof(assoc_ie));
+}
+
+
+static void test_taxonomy(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	struct bin_attr attrs[MAX_ATTRS];
+	char text[500];
+
+	hapd->bin_event_cb = bin_event_cb;
+	hapd->ctrl_bin_monitors = 1;
+	hapd->ctrl_text_monitors = 0;
+	taxonomy_event(hapd, sta);
+	check(sta->probe_ie_taxonomy[0] && sta->assoc_ie_taxonomy[0] &&
+	      bin_count == 1 &&
+	      decode(BIN_EVENT_STA_TAXONOMY, attrs) == 3 &&
+	      attr_is(&attrs[0], BIN_ATTR_ADDR, sta_addr, ETH_ALEN) &&
+	      attr_is(&attrs[1], BIN_ATTR_TAXONOMY_PROBE,
+		      sta->probe_ie_taxonomy,
+		      os_strlen(sta->probe_ie_taxonomy)) &&
+	      attr_is(&attrs[2], BIN_ATTR_TAXONOMY_ASSOC,
+		      sta->assoc_ie_taxonomy,
+		      os_strlen(sta->assoc_ie_taxonomy)),
+	      "taxonomy event");
+	check(text_count == 0, "no taxonomy text for binary monitors only");
+
+	hapd->ctrl_text_monitors = 1;
+	taxonomy_event(hapd, sta);
+	os_snprintf(text, sizeof(text),
+		    AP_STA_TAXONOMY MACSTR " wifi4|probe:%s|assoc:%s",
+		    MAC2STR(sta_addr), sta->probe_ie_taxonomy,
+		    sta->assoc_ie_taxonomy);
+	check(bin_count == 1 && text_count == 1 &&
+	      os_strcmp(text_buf, text) == 0 &&
+	      hostapd_bin_event_text(text_buf),
+	      "taxonomy text for text monitors");
+
+	hapd->ctrl_bin_monitors = 0;
+	taxonomy_event(hapd, sta);
+	check(bin_count == 0 && text_count == 1,
+	      "no taxonomy event without binary monitors");
+}
+
+
+static void test_steering(struct hostapd_data *hapd)
+{
+	struct bin_attr attrs[MAX_ATTRS];
+	char text[100];
+	u8 reason;
+
+	hapd->bin_event_cb = bin_event_cb;
+	hapd->ctrl_bin_monitors = 1;
+	hapd->ctrl_text_monitors = 0;
+	steering_target_interface = "target0";
+	bin_count = text_count = 0;
+	check(should_steer_on_assoc(hapd, sta_addr, -67, 1) == 0,
+	      "no steering on reassociation");
+	reason = BIN_NO_STEER_REASSOC;
+	check(bin_count == 1 &&
+	      decode(BIN_EVENT_STA_NO_STEERING, attrs) == 3 &&
+	      attr_is(&attrs[0], BIN_ATTR_ADDR, sta_addr, ETH_ALEN) &&
+	      attr_is(&attrs[1], BIN_ATTR_SIGNAL, "\xbd\xff\xff\xff", 4) &&
+	      attr_is(&attrs[2], BIN_ATTR_REASON, &reason, 1),
+	      "no steering event");
+	check(text_count == 0, "no steering text for binary monitors only");
+
+	hapd->ctrl_text_monitors = 1;
+	bin_count = text_count = 0;
+	should_steer_on_assoc(hapd, sta_addr, -67, 1);
+	os_snprintf(text, sizeof(text), AP_STA_NO_STEERING MACSTR " reassoc -67",
+		    MAC2STR(sta_addr));
+	check(bin_count == 1 && text_count == 1 &&
+	      os_strcmp(text_buf, text) == 0 &&
+	      hostapd_bin_event_text(text_buf),
+	      "steering text for text monitors");
+
+	steering_target_interface = NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct ap_harness h;
+	struct sta_info *sta;
+
+	test_init("bin-event");
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+
+	sta = os_zalloc(sizeof(*sta));
+	if (sta == NULL || ap_harness_init(&h) < 0) {
+		printf("bin-event: init failed\n");
+		os_free(sta);
+		return -1;
+	}
+	h.hapd.msg_ctx = &h.hapd;
+	wpa_msg_register_cb(text_event_cb);
+
+	test_builder(&h.hapd);
+	test_text_wanted(&h.hapd);
+	test_taxonomy(&h.hapd, sta);
+	test_steering(&h.hapd);
+
+	wpa_msg_register_cb(NULL);
+	ap_harness_deinit(&h);
+	os_free(sta);
+	os_program_deinit();
+
+	return test_result();
+}
@@ -0,0 +1,207 @@
+/*
+ * Control interface command tables - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "common/ctrl_cmd.h"
+#include "test_util.h"
+
+#define MAX_SOURCE_CMDS 200
+
+struct test_cmd {
+	const char *name;
+	unsigned int flags;
+};
+
+static const struct test_cmd test_cmds[] = {
+	{ "PING", CTRL_CMD_BARE },
+	{ "STA", CTRL_CMD_PARAMS },
+	{ "STA-DUMP", CTRL_CMD_BARE | CTRL_CMD_PARAMS },
+	{ "STA-FIRST", CTRL_CMD_BARE },
+	{ "STA-NEXT", CTRL_CMD_PARAMS },
+	{ "STATUS", CTRL_CMD_BARE },
+	{ "STATUS-DRIVER", CTRL_CMD_BARE },
+};
+
+
+static const struct test_cmd * find(const char *cmd, char **params)
+{
+	static char buf[64];
+
+	os_strlcpy(buf, cmd, sizeof(buf));
+	return ctrl_cmd_find(test_cmds, ARRAY_SIZE(test_cmds),
+			     sizeof(test_cmds[0]), buf, params);
+}
+
+
+static void test_find(void)
+{
+	const struct test_cmd *cmd;
+	char *params;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(test_cmds); i++) {
+		cmd = find(test_cmds[i].name, &params);
+		if (cmd != &test_cmds[i] || params != NULL)
+			break;
+	}
+	check(i == ARRAY_SIZE(test_cmds), "every entry found by its name");
+
+	cmd = find("STA 02:00:00:00:01:00", &params);
+	check(cmd && os_strcmp(cmd->name, "STA") == 0 && params &&
+	      os_strcmp(params, "02:00:00:00:01:00") == 0,
+	      "parameters after the name");
+	cmd = find("STA-DUMP ", &params);
+	check(cmd && os_strcmp(cmd->name, "STA-DUMP") == 0 && params &&
+	      params[0] == '\0', "empty parameters");
+
+	/* The name has to match exactly; prefixes are not accepted */
+	check(find("STATx", &params) == NULL, "longer name not found");
+	check(find("STA-DUMPx", &params) == NULL, "longer dash name not found");
+	check(find("ST", &params) == NULL, "shorter name not found");
+	check(find("", &params) == NULL, "empty command not found");
+	check(find("ZZZ", &params) == NULL && find("AAA", &params) == NULL,
+	      "names outside the table not found");
+
+	check(ctrl_cmd_accepts(CTRL_CMD_BARE, NULL) &&
+	      !ctrl_cmd_accepts(CTRL_CMD_BARE, "x"), "bare command");
+	check(!ctrl_cmd_accepts(CTRL_CMD_PARAMS, NULL) &&
+	      ctrl_cmd_accepts(CTRL_CMD_PARAMS, "x"), "command with params");
+	check(ctrl_cmd_accepts(CTRL_CMD_BARE | CTRL_CMD_PARAMS, NULL) &&
+	      ctrl_cmd_accepts(CTRL_CMD_BARE | CTRL_CMD_PARAMS, ""),
+	      "command with optional params");
+}
+
+
+static void test_table_check(void)
+{
+	static const struct test_cmd unsorted[] = {
+		{ "PING", 0 }, { "STA-FIRST", 0 }, { "STA-DUMP", 0 },
+	};
+	static const struct test_cmd duplicate[] = {
+		{ "PING", 0 }, { "STA", 0 }, { "STA", 0 },
+	};
+
+	check(ctrl_cmd_table_check(test_cmds, ARRAY_SIZE(test_cmds),
+				   sizeof(test_cmds[0])) == 0, "sorted table");
+	check(ctrl_cmd_table_check(test_cmds, 0, sizeof(test_cmds[0])) == 0,
+	      "empty table");
+
+	/* Do not show the errors that are expected below */
+	wpa_debug_level = MSG_ERROR + 1;
+	check(ctrl_cmd_table_check(unsorted, ARRAY_SIZE(unsorted),
+				   sizeof(unsorted[0])) < 0, "unsorted table");
+	check(ctrl_cmd_table_check(duplicate, ARRAY_SIZE(duplicate),
+				   sizeof(duplicate[0])) < 0,
+	      "duplicate command");
+	wpa_debug_level = MSG_ERROR;
+}
+
+
+static void test_named_stats(void)
+{
+	struct ctrl_cmd_named_stats entries[2];
+	struct ctrl_cmd_stats *a, *b;
+	struct os_reltime start;
+
+	os_memset(entries, 0, sizeof(entries));
+	a = ctrl_cmd_named_stats_get(entries, ARRAY_SIZE(entries),
+				     "WPS_PIN any");
+	b = ctrl_cmd_named_stats_get(entries, ARRAY_SIZE(entries), "WPS_PIN");
+	check(a && a == b && os_strcmp(entries[0].name, "WPS_PIN") == 0,
+	      "stats entry named without parameters");
+	b = ctrl_cmd_named_stats_get(entries, ARRAY_SIZE(entries), "WPS_PBC");
+	check(b && b != a, "second stats entry");
+	check(ctrl_cmd_named_stats_get(entries, ARRAY_SIZE(entries),
+				       "P2P_FIND") == NULL,
+	      "stats entries full");
+	check(ctrl_cmd_named_stats_get(entries, ARRAY_SIZE(entries),
+				       "WPS_PBC") == b,
+	      "existing entry when full");
+
+	os_get_reltime(&start);
+	ctrl_cmd_stats_update(a, &start, 0);
+	ctrl_cmd_stats_update(a, &start, 1);
+	check(a->count == 2 && a->failures == 1, "stats counted");
+}
+
+
+/*
+ * Check the command table in a daemon source file; ctrl_cmd_find() depends
+ * on the entries being sorted and the tables are not sorted at run time.
+ */
+static void test_source_table(const char *file, const char *marker)
+{
+	struct test_cmd cmds[MAX_SOURCE_CMDS];
+	char *buf, *tmp, *pos, *end, *name;
+	size_t len, num = 0;
+	char what[100];
+
+	os_snprintf(what, sizeof(what), "%s table", file);
+	buf = os_readfile(file, &len);
+	if (buf == NULL) {
+		check(0, what);
+		return;
+	}
+	tmp = os_realloc(buf, len + 1);
+	if (tmp == NULL) {
+		check(0, what);
+		os_free(buf);
+		return;
+	}
+	buf = tmp;
+	buf[len] = '\0';
+
+	pos = os_strstr(buf, marker);
+	end = pos ? os_strstr(pos, "\n};") : NULL;
+	if (pos == NULL || end == NULL) {
+		check(0, what);
+		os_free(buf);
+		return;
+	}
+	*end = '\0';
+
+	/* Entries start at the beginning of a line with the quoted name */
+	while ((pos = os_strstr(pos, "\n\t{ \"")) != NULL &&
+	       num < MAX_SOURCE_CMDS) {
+		name = pos + 5;
+		pos = os_strchr(name, '"');
+		if (pos == NULL)
+			break;
+		*pos++ = '\0';
+		cmds[num].name = name;
+		cmds[num].flags = 0;
+		num++;
+	}
+
+	check(num > 10 && num < MAX_SOURCE_CMDS, what);
+	os_snprintf(what, sizeof(what), "%s table sorted", file);
+	check(ctrl_cmd_table_check(cmds, num, sizeof(cmds[0])) == 0, what);
+
+	os_free(buf);
+}
+
+
+int main(int argc, char *argv[])
+{
+	test_init("ctrl-cmd");
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+
+	test_find();
+	test_table_check();
+	test_named_stats();
+	test_source_table("../hostapd/ctrl_iface.c", "hostapd_ctrl_cmds[] = {");
+	test_source_table("../wpa_supplicant/ctrl_iface.c",
+			  "wpas_ctrl_cmds[] = {");
+
+	os_program_deinit();
+
+	return test_result();
+}
@@ -0,0 +1,377 @@
+/*
+ * Event loop timeouts - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "test_util.h"
+
+#define NUM_TIMEOUTS 20000
+
+static int order[8];
+static int order_len;
+static int dispatched;
+static int sock_pairs[2][2];
+static int received;
+
+
+static void order_handler(void *eloop_ctx, void *user_ctx)
+{
+	if (order_len < (int) ARRAY_SIZE(order))
+		order[order_len++] = (int) (long) user_ctx;
+	if (order_len == 5)
+		eloop_terminate();
+}
+
+
+static void count_handler(void *eloop_ctx, void *user_ctx)
+{
+	if (++dispatched == NUM_TIMEOUTS)
+		eloop_terminate();
+}
+
+
+static void dummy_handler(void *eloop_ctx, void *user_ctx)
+{
+}
+
+
+static int test_eloop_order(void)
+{
+	static const int expected[] = { 1, 2, 3, 4, 5 };
+
+	/* Equal expiration times must be dispatched in registration order */
+	eloop_register_timeout(0, 2000, order_handler, NULL, (void *) 4);
+	eloop_register_timeout(0, 0, order_handler, NULL, (void *) 1);
+	eloop_register_timeout(0, 0, order_handler, NULL, (void *) 2);
+	eloop_register_timeout(0, 0, order_handler, NULL, (void *) 3);
+	eloop_register_timeout(0, 3000, order_handler, NULL, (void *) 5);
+	eloop_register_timeout(0, 1000, order_handler, NULL, (void *) 6);
+	check(eloop_cancel_timeout(order_handler, NULL, (void *) 6) == 1,
+	      "cancel");
+	eloop_run();
+	check(order_len == 5 &&
+	      os_memcmp(order, expected, sizeof(expected)) == 0, "order");
+
+	return test_errors();
+}
+
+
+static int test_eloop_api(void)
+{
+	struct os_reltime rem;
+	int i;
+
+	for (i = 0; i < 100; i++)
+		eloop_register_timeout(10 + i, 0, dummy_handler,
+				       (void *) (long) (i & 1),
+				       (void *) (long) i);
+	check(eloop_is_timeout_registered(dummy_handler, (void *) 1,
+					  (void *) 51), "is_registered");
+	check(!eloop_is_timeout_registered(dummy_handler, (void *) 0,
+					   (void *) 51), "!is_registered");
+	check(eloop_deplete_timeout(5, 0, dummy_handler, (void *) 0,
+				    (void *) 50) == 1, "deplete");
+	check(eloop_deplete_timeout(50, 0, dummy_handler, (void *) 0,
+				    (void *) 50) == 0, "deplete no-op");
+	check(eloop_replenish_timeout(500, 0, dummy_handler, (void *) 0,
+				      (void *) 50) == 1, "replenish");
+	check(eloop_replenish_timeout(5, 0, dummy_handler, (void *) 0,
+				      (void *) 50) == 0, "replenish no-op");
+	check(eloop_deplete_timeout(5, 0, dummy_handler, (void *) 0,
+				    (void *) 1000) == -1, "deplete missing");
+	check(eloop_cancel_timeout_one(dummy_handler, (void *) 0, (void *) 50,
+				       &rem) == 1 && rem.sec >= 499,
+	      "cancel_one");
+	check(eloop_cancel_timeout(dummy_handler, ELOOP_ALL_CTX,
+				   (void *) 3) == 1, "cancel wildcard eloop");
+	check(eloop_cancel_timeout(dummy_handler, (void *) 1,
+				   ELOOP_ALL_CTX) == 49,
+	      "cancel wildcard user");
+	check(eloop_cancel_timeout(dummy_handler, ELOOP_ALL_CTX,
+				   ELOOP_ALL_CTX) == 49, "cancel all");
+	check(!eloop_is_timeout_registered(dummy_handler, (void *) 0,
+					   (void *) 0), "empty");
+
+	return test_errors();
+}
+
+
+static void sock_dummy_handler(int sock, void *eloop_ctx, void *sock_ctx)
+{
+}
+
+
+static void sock_read_handler(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	char buf[8];
+
+	if (recv(sock, buf, sizeof(buf), MSG_DONTWAIT) <= 0)
+		return;
+	if (++received == 4)
+		eloop_terminate();
+
+	/* Change the socket table while events are pending for the other
+	 * socket */
+	if (received == 1) {
+		eloop_register_read_sock(sock_pairs[1][1], sock_dummy_handler,
+					 NULL, NULL);
+		eloop_unregister_read_sock(sock_pairs[1][1]);
+	}
+}
+
+
+static void sock_timeout(void *eloop_ctx, void *user_ctx)
+{
+	eloop_terminate();
+}
+
+
+static int test_eloop_sock_budget(void)
+{
+	int i;
+
+	/* Queued events of edge-triggered sockets must not be lost when a
+	 * handler modifies the socket tables */
+	for (i = 0; i < 2; i++) {
+		if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sock_pairs[i]) < 0) {
+			check(0, "socketpair");
+			return test_errors();
+		}
+		eloop_register_read_sock(sock_pairs[i][0], sock_read_handler,
+					 NULL, NULL);
+		check(eloop_set_read_sock_budget(sock_pairs[i][0], 1) == 0,
+		      "set budget");
+		check(send(sock_pairs[i][1], "a", 1, 0) == 1 &&
+		      send(sock_pairs[i][1], "b", 1, 0) == 1, "send");
+	}
+	eloop_register_timeout(2, 0, sock_timeout, NULL, NULL);
+	eloop_run();
+	eloop_cancel_timeout(sock_timeout, NULL, NULL);
+	check(received == 4, "sock budget");
+
+	for (i = 0; i < 2; i++) {
+		eloop_unregister_read_sock(sock_pairs[i][0]);
+		close(sock_pairs[i][0]);
+		close(sock_pairs[i][1]);
+	}
+
+	return test_errors();
+}
+
+
+#ifdef CONFIG_ELOOP_EPOLL
+
+static unsigned int drain_calls, drain_reads;
+static int drain_keep_errno;
+static int batch[8];
+static int batch_len;
+
+
+static void drain_handler(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	char buf[8];
+
+	drain_calls++;
+	if (recv(sock, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+		drain_reads++;
+	else if (!drain_keep_errno)
+		errno = 0;
+}
+
+
+static int drain_run(int sock, unsigned int msgs)
+{
+	unsigned int i;
+
+	drain_calls = drain_reads = 0;
+	for (i = 0; i < msgs; i++) {
+		if (send(sock, "a", 1, 0) != 1)
+			return -1;
+	}
+	eloop_register_timeout(0, 50000, sock_timeout, NULL, NULL);
+	eloop_run();
+	eloop_cancel_timeout(sock_timeout, NULL, NULL);
+	return 0;
+}
+
+
+static int test_eloop_sock_drain(void)
+{
+	struct eloop_stats stats, after;
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) < 0) {
+		check(0, "socketpair");
+		return test_errors();
+	}
+	eloop_register_read_sock(sv[0], drain_handler, NULL, NULL);
+	check(eloop_set_read_sock_budget(sv[0], 8) == 0, "set budget");
+
+	/* The handler's EAGAIN stops the calls once the socket is empty */
+	drain_keep_errno = 1;
+	eloop_get_stats(&stats);
+	check(drain_run(sv[1], 3) == 0, "send");
+	eloop_get_stats(&after);
+	check(drain_reads == 3 && drain_calls == 4, "drained until EAGAIN");
+	check(after.wakeups - stats.wakeups == 2, "drained in one wakeup");
+
+	/* Without EAGAIN the calls are bounded by the budget */
+	drain_keep_errno = 0;
+	check(drain_run(sv[1], 2) == 0, "send");
+	check(drain_reads == 2 && drain_calls == 8, "calls bounded by budget");
+
+	/* More messages than the budget are served on the next wakeup */
+	drain_keep_errno = 1;
+	check(drain_run(sv[1], 12) == 0, "send");
+	check(drain_reads == 12 && drain_calls == 13, "budget exceeded");
+
+	eloop_unregister_read_sock(sv[0]);
+	close(sv[0]);
+	close(sv[1]);
+
+	return test_errors();
+}
+
+
+static void batch_timeout(void *eloop_ctx, void *user_ctx)
+{
+	int id = (int) (long) user_ctx;
+
+	if (batch_len < (int) ARRAY_SIZE(batch))
+		batch[batch_len++] = id;
+	/* Re-register with a zero timeout; runs after the socket */
+	if (id == 1)
+		eloop_register_timeout(0, 0, batch_timeout, NULL, (void *) 4);
+	if (id == 4)
+		eloop_terminate();
+}
+
+
+static void batch_sock(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	char buf[8];
+
+	if (recv(sock, buf, sizeof(buf), MSG_DONTWAIT) > 0 &&
+	    batch_len < (int) ARRAY_SIZE(batch))
+		batch[batch_len++] = 3;
+}
+
+
+static int test_eloop_timeout_batch(void)
+{
+	static const int expected[] = { 1, 2, 3, 4 };
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) < 0) {
+		check(0, "socketpair");
+		return test_errors();
+	}
+	eloop_register_read_sock(sv[0], batch_sock, NULL, NULL);
+	check(send(sv[1], "a", 1, 0) == 1, "send");
+
+	/* All expired timeouts are called before the sockets, but not the
+	 * ones registered by these handlers */
+	eloop_register_timeout(0, 0, batch_timeout, NULL, (void *) 1);
+	eloop_register_timeout(0, 0, batch_timeout, NULL, (void *) 2);
+	eloop_run();
+	check(batch_len == 4 &&
+	      os_memcmp(batch, expected, sizeof(expected)) == 0,
+	      "timeout batch");
+
+	eloop_unregister_read_sock(sv[0]);
+	close(sv[0]);
+	close(sv[1]);
+
+	return test_errors();
+}
+
+#endif /* CONFIG_ELOOP_EPOLL */
+
+
+static unsigned int elapsed_usec(struct os_reltime *start)
+{
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	return diff.sec * 1000000 + diff.usec;
+}
+
+
+static void test_eloop_bench(void)
+{
+	struct os_reltime start;
+	unsigned int reg, lookup, cancel, dispatch;
+	struct eloop_stats stats, after;
+	int i;
+
+	os_get_reltime(&start);
+	for (i = 0; i < NUM_TIMEOUTS; i++)
+		eloop_register_timeout(10 + i % 3600, i, dummy_handler, NULL,
+				       (void *) (long) i);
+	reg = elapsed_usec(&start);
+
+	os_get_reltime(&start);
+	for (i = 0; i < NUM_TIMEOUTS; i++)
+		check(eloop_is_timeout_registered(dummy_handler, NULL,
+						  (void *) (long) i),
+		      "bench lookup");
+	lookup = elapsed_usec(&start);
+
+	os_get_reltime(&start);
+	for (i = 0; i < NUM_TIMEOUTS; i++)
+		eloop_cancel_timeout(dummy_handler, NULL, (void *) (long) i);
+	cancel = elapsed_usec(&start);
+
+	for (i = 0; i < NUM_TIMEOUTS; i++)
+		eloop_register_timeout(0, i % 1000, count_handler, NULL,
+				       (void *) (long) i);
+	os_get_reltime(&start);
+	eloop_run();
+	dispatch = elapsed_usec(&start);
+	check(dispatched == NUM_TIMEOUTS, "bench dispatch");
+
+	/* Steady state churn must be served from the timeout pool */
+	eloop_get_stats(&stats);
+	for (i = 0; i < NUM_TIMEOUTS; i++) {
+		eloop_register_timeout(10, 0, dummy_handler, NULL,
+				       (void *) (long) i);
+		eloop_replenish_timeout(20, 0, dummy_handler, NULL,
+					(void *) (long) i);
+	}
+	eloop_cancel_timeout(dummy_handler, NULL, ELOOP_ALL_CTX);
+	eloop_get_stats(&after);
+	check(after.timeout_pool_grows == stats.timeout_pool_grows &&
+	      after.timeouts == 0 &&
+	      after.timeout_pool_free == after.timeout_pool, "pool reuse");
+
+	printf("eloop: %d timeouts: register %u us, lookup %u us, cancel %u us, dispatch %u us\n",
+	       NUM_TIMEOUTS, reg, lookup, cancel, dispatch);
+}
+
+
+int main(int argc, char *argv[])
+{
+	test_init("eloop");
+
+	if (eloop_init() < 0)
+		return -1;
+
+	test_eloop_order();
+	test_eloop_api();
+	test_eloop_sock_budget();
+#ifdef CONFIG_ELOOP_EPOLL
+	test_eloop_sock_drain();
+	test_eloop_timeout_batch();
+#endif /* CONFIG_ELOOP_EPOLL */
+	test_eloop_bench();
+
+	eloop_destroy();
+
+	return test_result();
+}
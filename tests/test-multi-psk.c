@@ -0,0 +1,197 @@
+/*
+ * PSK lookup with many PSKs - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/defs.h"
+#include "common/wpa_common.h"
+#include "ap/ap_config.h"
+#include "ap_harness.h"
+#include "test_util.h"
+
+#define NUM_GROUP_PSKS 100
+
+
+static int add_group_psks(struct ap_harness_wpa *w, unsigned int num)
+{
+	while (num--) {
+		if (ap_harness_wpa_add_psk(w, NULL, NULL))
+			return -1;
+	}
+	return 0;
+}
+
+
+static void stop_loop(void *eloop_ctx, void *timeout_ctx)
+{
+	eloop_terminate();
+}
+
+
+/* Candidates in hostapd_get_psk() order must match the list search order */
+static void test_lookup(struct ap_harness_wpa *w)
+{
+	struct hostapd_wpa_psk *psk;
+	const u8 *addr = w->sta_addr;
+	u8 other[ETH_ALEN];
+	const u8 *found;
+	unsigned int num = 0, num_sta = 0, ok = 1;
+
+	os_memcpy(other, addr, ETH_ALEN);
+	other[5] ^= 0x80;
+	hostapd_config_clear_wpa_psk(&w->conf->ssid);
+	if (add_group_psks(w, 3) ||
+	    ap_harness_wpa_add_psk(w, addr, NULL) ||
+	    ap_harness_wpa_add_psk(w, other, NULL) ||
+	    add_group_psks(w, 2) ||
+	    ap_harness_wpa_add_psk(w, addr, NULL)) {
+		check(0, "PSK allocation");
+		return;
+	}
+
+	/* PSKs for the station in list order come first */
+	found = hostapd_get_psk(w->conf, addr, NULL, NULL);
+	for (psk = w->conf->ssid.wpa_psk; psk; psk = psk->next) {
+		if (psk->group || os_memcmp(psk->addr, addr, ETH_ALEN) != 0)
+			continue;
+		if (found != psk->psk)
+			ok = 0;
+		found = hostapd_get_psk(w->conf, addr, NULL, found);
+		num_sta++;
+	}
+	for (psk = w->conf->ssid.wpa_psk; psk; psk = psk->next) {
+		if (!psk->group)
+			continue;
+		if (found != psk->psk)
+			ok = 0;
+		found = hostapd_get_psk(w->conf, addr, NULL, found);
+		num++;
+	}
+	check(ok && found == NULL && num_sta == 2 && num == 5,
+	      "candidate order");
+
+	/* An unknown previous PSK ends the search */
+	check(hostapd_get_psk(w->conf, addr, NULL, w->psk) == NULL,
+	      "unknown previous PSK");
+
+	/* Another station gets its own PSK and the group PSKs */
+	num = 0;
+	for (found = hostapd_get_psk(w->conf, other, NULL, NULL); found;
+	     found = hostapd_get_psk(w->conf, other, NULL, found))
+		num++;
+	check(num == 6, "candidates for another station");
+}
+
+
+static void test_handshake(struct ap_harness_wpa *w)
+{
+	struct wpa_ptk ptk, kck;
+	u8 anonce[WPA_NONCE_LEN], snonce[WPA_NONCE_LEN];
+
+	/* The KCK alone matches the one from the full PTK derivation */
+	os_get_random(anonce, sizeof(anonce));
+	os_get_random(snonce, sizeof(snonce));
+	os_memset(&kck, 0, sizeof(kck));
+	check(wpa_pmk_to_ptk(w->psk, PMK_LEN, "Pairwise key expansion",
+			     w->auth_addr, w->sta_addr, anonce, snonce, &ptk,
+			     WPA_KEY_MGMT_PSK, WPA_CIPHER_CCMP) == 0 &&
+	      wpa_pmk_to_kck(w->psk, PMK_LEN, "Pairwise key expansion",
+			     w->auth_addr, w->sta_addr, anonce, snonce, &kck,
+			     WPA_KEY_MGMT_PSK) == 0 &&
+	      kck.kck_len == ptk.kck_len &&
+	      os_memcmp(kck.kck, ptk.kck, ptk.kck_len) == 0,
+	      "KCK derivation");
+
+	/* The matching group PSK is the last candidate */
+	hostapd_config_clear_wpa_psk(&w->conf->ssid);
+	if (ap_harness_wpa_add_psk(w, NULL, w->psk) ||
+	    add_group_psks(w, NUM_GROUP_PSKS - 1)) {
+		check(0, "PSK allocation");
+		return;
+	}
+	check(ap_harness_wpa_handshake(w, NULL) == 0 &&
+	      w->psk_candidates == NUM_GROUP_PSKS, "group PSK trials");
+	check(w->psk_candidates_rx > 0 &&
+	      w->psk_candidates_rx < NUM_GROUP_PSKS,
+	      "group PSK trials continued from the event loop");
+
+	/* The next handshake starts with the PSK that matched */
+	check(ap_harness_wpa_handshake(w, NULL) == 0 &&
+	      w->psk_candidates == 1, "affinity cache");
+	check(hostapd_get_psk(w->conf, w->sta_addr, NULL, NULL) != NULL &&
+	      os_memcmp(hostapd_get_psk(w->conf, w->sta_addr, NULL, NULL),
+			w->psk, PMK_LEN) == 0, "cached PSK first");
+
+	/* The cache does not survive changes to the list */
+	hostapd_config_clear_wpa_psk(&w->conf->ssid);
+	if (ap_harness_wpa_add_psk(w, NULL, w->psk) ||
+	    add_group_psks(w, NUM_GROUP_PSKS - 1)) {
+		check(0, "PSK allocation");
+		return;
+	}
+	check(ap_harness_wpa_handshake(w, NULL) == 0 &&
+	      w->psk_candidates == NUM_GROUP_PSKS,
+	      "group PSK trials after reload");
+
+	/* A station specific PSK is tried before the group PSKs */
+	hostapd_config_clear_wpa_psk(&w->conf->ssid);
+	if (add_group_psks(w, NUM_GROUP_PSKS) ||
+	    ap_harness_wpa_add_psk(w, w->sta_addr, w->psk)) {
+		check(0, "PSK allocation");
+		return;
+	}
+	check(ap_harness_wpa_handshake(w, NULL) == 0 &&
+	      w->psk_candidates == 1, "station PSK");
+
+	/* No msg 3/4 without a matching PSK */
+	hostapd_config_clear_wpa_psk(&w->conf->ssid);
+	if (add_group_psks(w, NUM_GROUP_PSKS)) {
+		check(0, "PSK allocation");
+		return;
+	}
+	check(ap_harness_wpa_handshake(w, NULL) < 0 &&
+	      w->psk_candidates == NUM_GROUP_PSKS && w->psk_failure,
+	      "no matching PSK");
+
+	/* Removing the station stops the remaining trials */
+	w->no_wait = 1;
+	check(ap_harness_wpa_handshake(w, NULL) < 0 &&
+	      w->psk_candidates < NUM_GROUP_PSKS, "station removed");
+	w->no_wait = 0;
+	eloop_register_timeout(0, 100000, stop_loop, NULL, NULL);
+	eloop_run();
+	check(w->psk_candidates == w->psk_candidates_rx,
+	      "no PSK trials after station removal");
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct ap_harness_wpa w;
+
+	test_init("multi-psk");
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+	if (eloop_init() < 0)
+		return -1;
+
+	if (ap_harness_wpa_init(&w) < 0) {
+		check(0, "authenticator init");
+	} else {
+		test_lookup(&w);
+		test_handshake(&w);
+	}
+	ap_harness_wpa_deinit(&w);
+
+	eloop_destroy();
+	os_program_deinit();
+
+	return test_result();
+}
@@ -0,0 +1,283 @@
+/*
+ * PMKSA cache (authenticator) - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/defs.h"
+#include "common/wpa_common.h"
+#include "eapol_auth/eapol_auth_sm.h"
+#include "radius/radius_das.h"
+#include "ap/pmksa_cache_auth.h"
+#include "test_util.h"
+
+/* More entries than SPA hash buckets, so some of the chains are shared */
+#define NUM_ENTRIES 600
+
+static const u8 aa1[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0xaa, 0x01 };
+static const u8 aa2[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0xaa, 0x02 };
+static const u8 aa3[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0xaa, 0x03 };
+
+static unsigned int freed;
+
+
+static void free_cb(struct rsn_pmksa_cache_entry *entry, void *ctx)
+{
+	freed++;
+}
+
+
+static void spa_addr(u8 *addr, unsigned int i)
+{
+	os_memcpy(addr, "\x52\x54\x00\x00", 4);
+	WPA_PUT_BE16(&addr[4], i);
+}
+
+
+static struct rsn_pmksa_cache_entry *
+add(struct rsn_pmksa_cache *pmksa, const u8 *spa, int timeout)
+{
+	u8 pmk[PMK_LEN];
+
+	os_memset(pmk, timeout, sizeof(pmk));
+	os_memcpy(pmk, spa, ETH_ALEN);
+	return pmksa_cache_auth_add(pmksa, pmk, sizeof(pmk), NULL, 0, aa1, spa,
+				    timeout, NULL, WPA_KEY_MGMT_IEEE8021X);
+}
+
+
+/* Add an OKC entry for @old that expires @diff seconds after it */
+static struct rsn_pmksa_cache_entry *
+add_okc(struct rsn_pmksa_cache *pmksa, struct rsn_pmksa_cache_entry *old,
+	const u8 *aa, int diff)
+{
+	struct rsn_pmksa_cache_entry tmp;
+	u8 pmkid[PMKID_LEN];
+
+	tmp = *old;
+	tmp.expiration += diff;
+	rsn_pmkid(old->pmk, old->pmk_len, aa, old->spa, pmkid, 0);
+	return pmksa_cache_add_okc(pmksa, &tmp, aa, pmkid);
+}
+
+
+static void test_spa_lookup(struct rsn_pmksa_cache *pmksa)
+{
+	struct rsn_pmksa_cache_entry *a, *older, *newer, *same;
+	u8 spa[ETH_ALEN];
+
+	spa_addr(spa, 0xffff);
+	a = add(pmksa, spa, 1000);
+	if (a == NULL) {
+		check(0, "entry added");
+		return;
+	}
+	check(pmksa_cache_auth_get(pmksa, spa, NULL) == a, "single entry");
+
+	older = add_okc(pmksa, a, aa2, -50);
+	newer = add_okc(pmksa, a, aa3, 50);
+	if (older == NULL || newer == NULL) {
+		check(0, "OKC entries added");
+		return;
+	}
+	check(pmksa_cache_auth_get(pmksa, spa, NULL) == newer,
+	      "newest-expiring entry returned");
+	check(pmksa_cache_auth_get(pmksa, NULL, NULL) == older,
+	      "first-expiring entry at the head of the list");
+	check(pmksa_cache_auth_get(pmksa, spa, older->pmkid) == older &&
+	      pmksa_cache_auth_get(pmksa, spa, a->pmkid) == a,
+	      "older entries found by PMKID");
+
+	pmksa_cache_free_entry(pmksa, newer);
+	check(pmksa_cache_auth_get(pmksa, spa, NULL) == a,
+	      "next entry after the newest one is freed");
+
+	/* Of two entries that expire together, the one added last */
+	same = add_okc(pmksa, a, aa2, 0);
+	check(same && pmksa_cache_auth_get(pmksa, spa, NULL) == same,
+	      "last added entry of the same expiration returned");
+
+	while ((a = pmksa_cache_auth_get(pmksa, spa, NULL)) != NULL)
+		pmksa_cache_free_entry(pmksa, a);
+	check(pmksa_cache_auth_get(pmksa, NULL, NULL) == NULL,
+	      "all entries freed");
+}
+
+
+static void test_okc_memo(struct rsn_pmksa_cache *pmksa)
+{
+	struct rsn_pmksa_cache_entry *a;
+	u8 spa[ETH_ALEN], pmkid2[PMKID_LEN], pmkid3[PMKID_LEN];
+
+	spa_addr(spa, 0xfffe);
+	a = add(pmksa, spa, 1000);
+	if (a == NULL) {
+		check(0, "entry added");
+		return;
+	}
+	rsn_pmkid(a->pmk, a->pmk_len, aa2, spa, pmkid2, 0);
+	rsn_pmkid(a->pmk, a->pmk_len, aa3, spa, pmkid3, 0);
+
+	check(!a->okc_pmkid_set, "no PMKID remembered before OKC lookup");
+	check(pmksa_cache_get_okc(pmksa, aa2, spa, pmkid2) == a &&
+	      a->okc_pmkid_set &&
+	      os_memcmp(a->okc_aa, aa2, ETH_ALEN) == 0 &&
+	      os_memcmp(a->okc_pmkid, pmkid2, PMKID_LEN) == 0,
+	      "OKC PMKID remembered for the AA");
+	check(pmksa_cache_get_okc(pmksa, aa2, spa, pmkid2) == a,
+	      "OKC lookup with the remembered PMKID");
+
+	/* The remembered PMKID is not valid for another AA */
+	check(pmksa_cache_get_okc(pmksa, aa3, spa, pmkid2) == NULL,
+	      "PMKID of another AA rejected");
+	check(os_memcmp(a->okc_aa, aa3, ETH_ALEN) == 0 &&
+	      os_memcmp(a->okc_pmkid, pmkid3, PMKID_LEN) == 0,
+	      "OKC PMKID recomputed for the new AA");
+	check(pmksa_cache_get_okc(pmksa, aa3, spa, pmkid3) == a,
+	      "OKC lookup after the AA changed");
+	check(pmksa_cache_get_okc(pmksa, aa2, spa, pmkid3) == NULL,
+	      "PMKID of the new AA rejected for the old one");
+	check(pmksa_cache_get_okc(pmksa, aa2, spa, pmkid2) == a,
+	      "OKC lookup after changing back to the old AA");
+
+	spa_addr(spa, 0xfffd);
+	check(pmksa_cache_get_okc(pmksa, aa2, spa, pmkid2) == NULL,
+	      "OKC lookup for another SPA");
+
+	pmksa_cache_free_entry(pmksa, a);
+}
+
+
+static int check_chains(struct rsn_pmksa_cache *pmksa,
+			u8 pmkid[][PMKID_LEN], const int *present,
+			unsigned int num)
+{
+	struct rsn_pmksa_cache_entry *entry, *prev = NULL;
+	u8 spa[ETH_ALEN];
+	unsigned int i, count = 0, expected = 0;
+
+	for (i = 0; i < num; i++) {
+		spa_addr(spa, i);
+		entry = pmksa_cache_auth_get(pmksa, spa, NULL);
+		if (!present[i]) {
+			if (entry ||
+			    pmksa_cache_auth_get(pmksa, NULL, pmkid[i]))
+				return 0;
+			continue;
+		}
+		expected++;
+		if (entry == NULL ||
+		    os_memcmp(entry->spa, spa, ETH_ALEN) != 0 ||
+		    os_memcmp(entry->pmkid, pmkid[i], PMKID_LEN) != 0 ||
+		    pmksa_cache_auth_get(pmksa, NULL, pmkid[i]) != entry)
+			return 0;
+	}
+
+	/* The main list stays in expiration order */
+	for (entry = pmksa_cache_auth_get(pmksa, NULL, NULL); entry;
+	     entry = entry->next) {
+		if (prev && prev->expiration > entry->expiration)
+			return 0;
+		prev = entry;
+		count++;
+	}
+	return count == expected;
+}
+
+
+static void test_chains(struct rsn_pmksa_cache *pmksa)
+{
+	static u8 pmkid[NUM_ENTRIES][PMKID_LEN];
+	static int present[NUM_ENTRIES];
+	struct rsn_pmksa_cache_entry *entry;
+	u8 spa[ETH_ALEN];
+	unsigned int i, num_freed = 0;
+
+	freed = 0;
+	for (i = 0; i < NUM_ENTRIES; i++) {
+		spa_addr(spa, i);
+		entry = add(pmksa, spa, 1000 + (i * 37) % 600);
+		if (entry == NULL) {
+			check(0, "entries added");
+			return;
+		}
+		os_memcpy(pmkid[i], entry->pmkid, PMKID_LEN);
+		present[i] = 1;
+	}
+	check(check_chains(pmksa, pmkid, present, NUM_ENTRIES),
+	      "all entries found");
+
+	/* Free from the head, the middle and the end of the chains */
+	for (i = 0; i < NUM_ENTRIES; i += 3) {
+		spa_addr(spa, i);
+		entry = pmksa_cache_auth_get(pmksa, spa, NULL);
+		if (entry == NULL)
+			break;
+		pmksa_cache_free_entry(pmksa, entry);
+		present[i] = 0;
+		num_freed++;
+	}
+	check(freed == num_freed, "free callback for each entry");
+	check(check_chains(pmksa, pmkid, present, NUM_ENTRIES),
+	      "chains consistent after free");
+
+	/* Replacing an entry unlinks the old one from both chains */
+	for (i = 0; i < NUM_ENTRIES; i++) {
+		if (i % 3 == 1)
+			continue;
+		spa_addr(spa, i);
+		entry = add(pmksa, spa, 2000 - i);
+		if (entry == NULL)
+			break;
+		os_memcpy(pmkid[i], entry->pmkid, PMKID_LEN);
+		present[i] = 1;
+	}
+	check(check_chains(pmksa, pmkid, present, NUM_ENTRIES),
+	      "chains consistent after replace");
+
+	for (i = 0; i < NUM_ENTRIES; i++) {
+		spa_addr(spa, i);
+		entry = pmksa_cache_auth_get(pmksa, spa, NULL);
+		if (entry)
+			pmksa_cache_free_entry(pmksa, entry);
+		present[i] = 0;
+	}
+	check(check_chains(pmksa, pmkid, present, NUM_ENTRIES) &&
+	      pmksa_cache_auth_get(pmksa, NULL, NULL) == NULL,
+	      "all entries freed");
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct rsn_pmksa_cache *pmksa;
+
+	test_init("pmksa-cache");
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+	if (eloop_init()) {
+		os_program_deinit();
+		return -1;
+	}
+
+	pmksa = pmksa_cache_auth_init(free_cb, NULL);
+	if (pmksa) {
+		test_spa_lookup(pmksa);
+		test_okc_memo(pmksa);
+		test_chains(pmksa);
+		pmksa_cache_auth_deinit(pmksa);
+	} else {
+		check(0, "PMKSA cache init");
+	}
+
+	eloop_destroy();
+	os_program_deinit();
+
+	return test_result();
+}
@@ -0,0 +1,196 @@
+/*
+ * Passphrase to PSK derivation - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "crypto/sha1.h"
+#include "common/wpa_common.h"
+#include "ap/psk_derive.h"
+#include "test_util.h"
+
+static const u8 ssid[] = "test";
+
+#define NUM_REQ 4
+
+struct req_ctx {
+	u8 psk[PMK_LEN];
+	unsigned int called;
+};
+
+static unsigned int pending;
+
+
+static int psk_ok(const char *passphrase, const u8 *psk)
+{
+	u8 buf[PMK_LEN];
+
+	pbkdf2_sha1(passphrase, ssid, sizeof(ssid) - 1, 4096, buf, PMK_LEN);
+	return os_memcmp(buf, psk, PMK_LEN) == 0;
+}
+
+
+static void req_done(void *ctx)
+{
+	struct req_ctx *req = ctx;
+
+	req->called++;
+	if (pending && --pending == 0)
+		eloop_terminate();
+}
+
+
+static void test_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	eloop_terminate();
+}
+
+
+/* Run the event loop until pending is zero or for at most secs */
+static void run_eloop(unsigned int secs)
+{
+	eloop_register_timeout(secs, 0, test_timeout, NULL, NULL);
+	eloop_run();
+	eloop_cancel_timeout(test_timeout, NULL, NULL);
+}
+
+
+static void test_derive(void)
+{
+	struct req_ctx req[NUM_REQ], again;
+	char passphrase[NUM_REQ][32];
+	unsigned int i, ok = 1;
+	u8 psk[PMK_LEN];
+
+	psk_derive("sync passphrase", ssid, sizeof(ssid) - 1, psk);
+	check(psk_ok("sync passphrase", psk), "synchronous derivation");
+
+	/* The callbacks are called from the event loop */
+	os_memset(req, 0, sizeof(req));
+	pending = 0;
+	for (i = 0; i < NUM_REQ; i++) {
+		os_snprintf(passphrase[i], sizeof(passphrase[i]),
+			    "async passphrase %u", i);
+		if (psk_derive_start(passphrase[i], ssid, sizeof(ssid) - 1,
+				     req[i].psk, req_done, &req[i]) == 0)
+			pending++;
+	}
+	check(pending == NUM_REQ, "pending derivations");
+	for (i = 0; i < NUM_REQ; i++) {
+		if (req[i].called)
+			ok = 0;
+	}
+	check(ok, "no callback before event loop");
+	run_eloop(30);
+	for (i = 0, ok = 1; i < NUM_REQ; i++) {
+		if (req[i].called != 1 || !psk_ok(passphrase[i], req[i].psk))
+			ok = 0;
+	}
+	check(pending == 0 && ok, "asynchronous derivation");
+
+	/* Derived PSKs are cached */
+	os_memset(&again, 0, sizeof(again));
+	check(psk_derive_start(passphrase[0], ssid, sizeof(ssid) - 1,
+			       again.psk, req_done, &again) == 1 &&
+	      !again.called && psk_ok(passphrase[0], again.psk),
+	      "cached derivation");
+}
+
+
+static void test_cancel(void)
+{
+	struct req_ctx cancelled, other;
+	u8 zero[PMK_LEN];
+
+	os_memset(&cancelled, 0, sizeof(cancelled));
+	os_memset(&other, 0, sizeof(other));
+	os_memset(zero, 0, sizeof(zero));
+
+	/* Both requests share a single derivation */
+	pending = 0;
+	if (psk_derive_start("cancel passphrase", ssid, sizeof(ssid) - 1,
+			     cancelled.psk, req_done, &cancelled) == 0)
+		pending++;
+	if (psk_derive_start("cancel passphrase", ssid, sizeof(ssid) - 1,
+			     other.psk, req_done, &other) == 0)
+		pending++;
+	check(pending == 2, "pending derivations to cancel");
+	psk_derive_cancel(&cancelled);
+	pending--;
+	run_eloop(30);
+	check(!cancelled.called &&
+	      os_memcmp(cancelled.psk, zero, PMK_LEN) == 0,
+	      "cancelled request");
+	check(other.called == 1 && psk_ok("cancel passphrase", other.psk),
+	      "request sharing a cancelled derivation");
+}
+
+
+static void test_flush(void)
+{
+	struct req_ctx acl, batch[NUM_REQ];
+	char passphrase[NUM_REQ][32];
+	unsigned int i, ok = 1;
+	int batch_ctx;
+
+	os_memset(&acl, 0, sizeof(acl));
+	os_memset(batch, 0, sizeof(batch));
+
+	/* A request with a callback, e.g., from a RADIUS ACL query */
+	pending = 0;
+	if (psk_derive_start("flush passphrase 0", ssid, sizeof(ssid) - 1,
+			     acl.psk, req_done, &acl) == 0)
+		pending++;
+	check(pending == 1, "pending derivation before flush");
+
+	/* A batch of PSKs, one of them the same as above */
+	for (i = 0; i < NUM_REQ; i++) {
+		os_snprintf(passphrase[i], sizeof(passphrase[i]),
+			    "flush passphrase %u", i);
+		psk_derive_start(passphrase[i], ssid, sizeof(ssid) - 1,
+				 batch[i].psk, NULL, &batch_ctx);
+	}
+	psk_derive_flush(&batch_ctx);
+	for (i = 0; i < NUM_REQ; i++) {
+		if (!psk_ok(passphrase[i], batch[i].psk))
+			ok = 0;
+	}
+	check(ok, "flushed batch");
+	check(!acl.called, "other request left to event loop");
+
+	run_eloop(30);
+	check(acl.called == 1 && psk_ok("flush passphrase 0", acl.psk),
+	      "other request after flush");
+	for (i = 0, ok = 1; i < NUM_REQ; i++) {
+		if (batch[i].called)
+			ok = 0;
+	}
+	check(ok, "no callbacks for flushed batch");
+}
+
+
+int main(int argc, char *argv[])
+{
+	test_init("psk-derive");
+
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+	if (eloop_init() < 0)
+		return -1;
+
+	test_derive();
+	test_cancel();
+	test_flush();
+
+	psk_derive_deinit();
+	eloop_destroy();
+	os_program_deinit();
+
+	return test_result();
+}
@@ -0,0 +1,296 @@
+/*
+ * RADIUS client source ports and Identifiers - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "crypto/md5.h"
+#include "radius/radius.h"
+#include "radius/radius_client.h"
+#include "test_util.h"
+
+#define NUM_PORTS 2
+#define MAX_REQS (NUM_PORTS * 256 + 2)
+
+static const u8 secret[] = "radius";
+
+/* Requests received by the test server */
+struct srv_req {
+	struct radius_msg *msg;
+	u16 port; /* client source port */
+};
+
+static struct srv_req reqs[MAX_REQS];
+static unsigned int num_reqs;
+static int srv_sock = -1;
+
+/* Requests matched with a response by the RADIUS client */
+static unsigned int rx_count, rx_invalid;
+static u8 rx_authenticator[MD5_MAC_LEN];
+
+
+static RadiusRxResult test_rx(struct radius_msg *msg, struct radius_msg *req,
+			      const u8 *shared_secret,
+			      size_t shared_secret_len, void *data)
+{
+	if (radius_msg_verify(msg, shared_secret, shared_secret_len, req, 1)) {
+		rx_invalid++;
+		return RADIUS_RX_INVALID_AUTHENTICATOR;
+	}
+	os_memcpy(rx_authenticator, radius_msg_get_hdr(req)->authenticator,
+		  MD5_MAC_LEN);
+	rx_count++;
+	eloop_terminate();
+	return RADIUS_RX_PROCESSED;
+}
+
+
+static void test_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	eloop_terminate();
+}
+
+
+/* Returns 1 if the response was matched with the request number req */
+static int wait_rx(unsigned int req)
+{
+	unsigned int count = rx_count;
+
+	eloop_register_timeout(0, 200000, test_timeout, NULL, NULL);
+	eloop_run();
+	eloop_cancel_timeout(test_timeout, NULL, NULL);
+	return rx_count == count + 1 && rx_invalid == 0 &&
+		os_memcmp(rx_authenticator,
+			  radius_msg_get_hdr(reqs[req].msg)->authenticator,
+			  MD5_MAC_LEN) == 0;
+}
+
+
+/* Returns 1 if no response was matched with any request */
+static int wait_no_rx(void)
+{
+	unsigned int count = rx_count;
+
+	eloop_register_timeout(0, 200000, test_timeout, NULL, NULL);
+	eloop_run();
+	eloop_cancel_timeout(test_timeout, NULL, NULL);
+	return rx_count == count && rx_invalid == 0;
+}
+
+
+static int srv_init(struct hostapd_radius_server *serv)
+{
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+
+	srv_sock = socket(PF_INET, SOCK_DGRAM, 0);
+	if (srv_sock < 0)
+		return -1;
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(srv_sock, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+	    getsockname(srv_sock, (struct sockaddr *) &addr, &addrlen) < 0)
+		return -1;
+
+	os_memset(serv, 0, sizeof(*serv));
+	serv->addr.af = AF_INET;
+	serv->addr.u.v4.s_addr = addr.sin_addr.s_addr;
+	serv->port = ntohs(addr.sin_port);
+	serv->shared_secret = (u8 *) secret;
+	serv->shared_secret_len = sizeof(secret) - 1;
+	return 0;
+}
+
+
+/* Read the requests sent so far; returns the number of new requests */
+static unsigned int srv_recv(void)
+{
+	struct sockaddr_in from;
+	socklen_t fromlen;
+	u8 buf[3000];
+	int len;
+	unsigned int num = 0;
+	struct radius_msg *msg;
+
+	for (;;) {
+		fromlen = sizeof(from);
+		len = recvfrom(srv_sock, buf, sizeof(buf), MSG_DONTWAIT,
+			       (struct sockaddr *) &from, &fromlen);
+		if (len < 0)
+			break;
+		msg = radius_msg_parse(buf, len);
+		if (msg == NULL || num_reqs == MAX_REQS) {
+			radius_msg_free(msg);
+			continue;
+		}
+		reqs[num_reqs].msg = msg;
+		reqs[num_reqs].port = ntohs(from.sin_port);
+		num_reqs++;
+		num++;
+	}
+
+	return num;
+}
+
+
+/* Send the response to request number req to the client port */
+static void srv_respond(unsigned int req, u16 port)
+{
+	struct radius_hdr *hdr = radius_msg_get_hdr(reqs[req].msg);
+	struct radius_msg *msg;
+	struct wpabuf *buf;
+	struct sockaddr_in to;
+
+	msg = radius_msg_new(RADIUS_CODE_ACCESS_ACCEPT, hdr->identifier);
+	if (msg == NULL)
+		return;
+	if (radius_msg_finish_srv(msg, secret, sizeof(secret) - 1,
+				  hdr->authenticator) == 0) {
+		os_memset(&to, 0, sizeof(to));
+		to.sin_family = AF_INET;
+		to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		to.sin_port = htons(port);
+		buf = radius_msg_get_buf(msg);
+		if (sendto(srv_sock, wpabuf_head(buf), wpabuf_len(buf), 0,
+			   (struct sockaddr *) &to, sizeof(to)) < 0)
+			check(0, "response sent");
+	}
+	radius_msg_free(msg);
+}
+
+
+static int send_request(struct radius_client_data *radius)
+{
+	static unsigned int count;
+	struct radius_msg *msg;
+
+	msg = radius_msg_new(RADIUS_CODE_ACCESS_REQUEST,
+			     radius_client_get_id(radius));
+	if (msg == NULL)
+		return -1;
+	count++;
+	radius_msg_make_authenticator(msg, (u8 *) &count, sizeof(count));
+	if (!radius_msg_add_attr(msg, RADIUS_ATTR_USER_NAME,
+				 (u8 *) "user", 4) ||
+	    radius_client_send(radius, msg, RADIUS_AUTH, NULL) < 0) {
+		radius_msg_free(msg);
+		return -1;
+	}
+	return 0;
+}
+
+
+static u8 req_id(unsigned int req)
+{
+	return radius_msg_get_hdr(reqs[req].msg)->identifier;
+}
+
+
+static void test_ports(struct radius_client_data *radius)
+{
+	unsigned int i, ok = 1;
+	u16 port1, port2;
+
+	/* The Identifiers of the first port are used up before the second
+	 * port is used */
+	for (i = 0; i < NUM_PORTS * 256; i++) {
+		if (send_request(radius) < 0)
+			ok = 0;
+		srv_recv();
+	}
+	check(ok && num_reqs == NUM_PORTS * 256, "requests sent");
+	if (num_reqs != NUM_PORTS * 256)
+		return;
+	port1 = reqs[0].port;
+	port2 = reqs[256].port;
+	for (i = 0; i < num_reqs; i++) {
+		if (reqs[i].port != (i < 256 ? port1 : port2) ||
+		    req_id(i) != (i & 0xff))
+			ok = 0;
+	}
+	check(ok && port1 != port2, "next port after Identifier exhaustion");
+
+	/* Identifiers 0 and 1 are in use on all ports */
+	check(send_request(radius) == 0 && send_request(radius) == 0 &&
+	      srv_recv() == 0, "requests queued");
+
+	/* A response frees Identifier 0 on the second port */
+	srv_respond(256, port2);
+	check(wait_rx(256), "response matched");
+	check(srv_recv() == 1 && reqs[512].port == port2 && req_id(512) == 0,
+	      "queued request sent on the freed Identifier");
+
+	/* A response to a request on the other port is ignored */
+	srv_respond(5, port2);
+	check(wait_no_rx(), "response on wrong port ignored");
+	srv_respond(5, port1);
+	check(wait_rx(5), "response on the right port matched");
+	srv_respond(261, port2);
+	check(wait_rx(261), "request not completed by wrong port response");
+
+	/* Responses to completed requests are ignored, also when the
+	 * Identifier is in use again for a new request */
+	srv_respond(5, port1);
+	check(wait_no_rx(), "response with stale Identifier ignored");
+	srv_respond(256, port2);
+	check(wait_no_rx(), "duplicate response for reused Identifier ignored");
+	srv_respond(512, port2);
+	check(wait_rx(512), "request with reused Identifier matched");
+
+	/* The other queued request waited for Identifier 1 */
+	check(srv_recv() == 0, "queued request still waiting");
+	srv_respond(1, port1);
+	check(wait_rx(1), "response to free Identifier 1");
+	check(srv_recv() == 1 && reqs[513].port == port1 && req_id(513) == 1,
+	      "second queued request sent");
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct hostapd_radius_server serv;
+	struct hostapd_radius_servers conf;
+	struct radius_client_data *radius;
+	unsigned int i;
+
+	test_init("radius-client");
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+	if (eloop_init() < 0)
+		return -1;
+
+	os_memset(&conf, 0, sizeof(conf));
+	conf.auth_servers = conf.auth_server = &serv;
+	conf.num_auth_servers = 1;
+	conf.client_ports = NUM_PORTS;
+	conf.max_pending = NUM_PORTS * 256;
+
+	if (srv_init(&serv) < 0) {
+		check(0, "test server");
+	} else {
+		radius = radius_client_init(NULL, &conf);
+		if (radius &&
+		    radius_client_register(radius, RADIUS_AUTH, test_rx,
+					   NULL) == 0)
+			test_ports(radius);
+		else
+			check(0, "RADIUS client init");
+		radius_client_deinit(radius);
+	}
+
+	if (srv_sock >= 0)
+		close(srv_sock);
+	for (i = 0; i < num_reqs; i++)
+		radius_msg_free(reqs[i].msg);
+	eloop_destroy();
+	os_program_deinit();
+
+	return test_result();
+}
@@ -0,0 +1,435 @@
+/*
+ * SAE Commit message processing outside the event loop - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * The SAE crypto functions are replaced with stubs below, so only the queue
+ * and the worker threads of sae_async.c are tested. The same program is built
+ * with and without CONFIG_SAE_THREADS.
+ */
+
+#include "utils/includes.h"
+#ifdef CONFIG_SAE_THREADS
+#include <pthread.h>
+#endif /* CONFIG_SAE_THREADS */
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "crypto/random.h"
+#include "common/sae.h"
+#include "ap/sae_async.h"
+#include "test_util.h"
+
+/* SAE_ASYNC_MAX_JOBS */
+#define MAX_JOBS 32
+#define RANDOM_ROUNDS 200
+
+static const u8 own_addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static const u8 password[] = "password";
+
+struct test_sta {
+	struct sae_data sae; /* first member, see test_sta_from_sae() */
+	u8 addr[ETH_ALEN];
+	unsigned int prepared;
+	unsigned int processed;
+	unsigned int called;
+	int res;
+	int fail; /* sae_prepare_commit() fails */
+	int block; /* sae_process_commit() waits until released */
+	int random; /* sae_process_commit() uses the random pool */
+	int pending_in_cb;
+	struct test_sta *cancel; /* cancelled from the callback */
+};
+
+static unsigned int processed, called, target;
+#ifdef CONFIG_SAE_THREADS
+static pthread_mutex_t test_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t test_cond = PTHREAD_COND_INITIALIZER;
+static int blocked, released;
+#endif /* CONFIG_SAE_THREADS */
+
+
+static void lock(void)
+{
+#ifdef CONFIG_SAE_THREADS
+	pthread_mutex_lock(&test_lock);
+#endif /* CONFIG_SAE_THREADS */
+}
+
+
+static void unlock(void)
+{
+#ifdef CONFIG_SAE_THREADS
+	pthread_cond_broadcast(&test_cond);
+	pthread_mutex_unlock(&test_lock);
+#endif /* CONFIG_SAE_THREADS */
+}
+
+
+static struct test_sta * test_sta_from_sae(struct sae_data *sae)
+{
+	return (struct test_sta *) sae;
+}
+
+
+int sae_prepare_commit(const u8 *addr1, const u8 *addr2,
+		       const u8 *password, size_t password_len,
+		       struct sae_data *sae)
+{
+	struct test_sta *sta = test_sta_from_sae(sae);
+	int ret;
+
+	lock();
+	sta->prepared++;
+	ret = sta->fail ? -1 : 0;
+	if (os_memcmp(addr1, own_addr, ETH_ALEN) != 0 ||
+	    os_memcmp(addr2, sta->addr, ETH_ALEN) != 0)
+		ret = -1;
+	unlock();
+	return ret;
+}
+
+
+int sae_process_commit(struct sae_data *sae)
+{
+	struct test_sta *sta = test_sta_from_sae(sae);
+	u8 buf[32];
+	int i, ret = 0;
+
+	/* The scalar and the mask are drawn from the random pool */
+	for (i = 0; sta->random && i < RANDOM_ROUNDS; i++) {
+		if (random_get_bytes(buf, sizeof(buf)) < 0)
+			ret = -1;
+		random_add_randomness(buf, sizeof(buf));
+	}
+
+#ifdef CONFIG_SAE_THREADS
+	pthread_mutex_lock(&test_lock);
+	if (sta->block) {
+		blocked = 1;
+		pthread_cond_broadcast(&test_cond);
+		while (!released)
+			pthread_cond_wait(&test_cond, &test_lock);
+	}
+	pthread_mutex_unlock(&test_lock);
+#endif /* CONFIG_SAE_THREADS */
+
+	lock();
+	sta->processed++;
+	processed++;
+	unlock();
+	return ret;
+}
+
+
+static void commit_done(void *eloop_ctx, void *user_ctx, int res)
+{
+	struct test_sta *sta = user_ctx;
+
+	sta->called++;
+	sta->res = res;
+	sta->pending_in_cb = sae_async_pending(sta);
+	called++;
+	if (sta->cancel)
+		sae_async_cancel(sta->cancel);
+	if (called >= target)
+		eloop_terminate();
+}
+
+
+static void test_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	eloop_terminate();
+}
+
+
+/* Run the event loop until num callbacks have been called or for secs */
+static void run_eloop(unsigned int num, unsigned int secs)
+{
+	target = num;
+	eloop_register_timeout(secs, 0, test_timeout, NULL, NULL);
+	if (called < target)
+		eloop_run();
+	eloop_cancel_timeout(test_timeout, NULL, NULL);
+}
+
+
+#ifdef CONFIG_SAE_THREADS
+/* Wait until the crypto for num Commit messages has been done */
+static int wait_processed(unsigned int num)
+{
+	int i, done = 0;
+
+	for (i = 0; i < 5000 && !done; i++) {
+		lock();
+		done = processed >= num;
+		unlock();
+		if (!done)
+			os_sleep(0, 1000);
+	}
+	return done;
+}
+#endif /* CONFIG_SAE_THREADS */
+
+
+static int commit(struct test_sta *sta, const u8 *pw)
+{
+	return sae_async_commit(&sta->sae, own_addr, sta->addr, pw,
+				pw ? sizeof(password) - 1 : 0, commit_done,
+				NULL, sta);
+}
+
+
+static void sta_init(struct test_sta *sta, unsigned int i)
+{
+	os_memset(sta, 0, sizeof(*sta));
+	os_memcpy(sta->addr, "\x02\x00\x00\x01", 4);
+	WPA_PUT_BE16(&sta->addr[4], i);
+}
+
+
+static void reset(void)
+{
+	lock();
+	processed = 0;
+	unlock();
+	called = 0;
+}
+
+
+static void test_queue_limit(void)
+{
+	struct test_sta sta[MAX_JOBS + 1];
+	unsigned int i, queued = 0, ok = 1;
+
+	reset();
+	for (i = 0; i <= MAX_JOBS; i++)
+		sta_init(&sta[i], i);
+	for (i = 0; i < MAX_JOBS; i++) {
+		if (commit(&sta[i], password) == 0)
+			queued++;
+	}
+	check(queued == MAX_JOBS, "queue filled");
+	check(commit(&sta[MAX_JOBS], password) == 1 &&
+	      !sae_async_pending(&sta[MAX_JOBS]), "commit dropped when full");
+	check(commit(&sta[0], password) < 0, "single commit per STA");
+
+#ifdef CONFIG_SAE_THREADS
+	/* Jobs finished by a worker thread still take a queue slot until
+	 * their callback has been called */
+	check(wait_processed(MAX_JOBS) &&
+	      commit(&sta[MAX_JOBS], password) == 1,
+	      "queue full until callbacks");
+#endif /* CONFIG_SAE_THREADS */
+
+	run_eloop(MAX_JOBS, 10);
+	for (i = 0; i < MAX_JOBS; i++) {
+		if (sta[i].called != 1 || sta[i].res != 0 ||
+		    sta[i].prepared != 1 || sta[i].processed != 1 ||
+		    sae_async_pending(&sta[i]))
+			ok = 0;
+	}
+	check(ok && called == MAX_JOBS, "all queued commits processed");
+
+	check(commit(&sta[MAX_JOBS], password) == 0, "queue has room again");
+	run_eloop(MAX_JOBS + 1, 10);
+	check(sta[MAX_JOBS].called == 1, "commit after queue drained");
+}
+
+
+static void test_pending(void)
+{
+	struct test_sta sta, failed, peer_only;
+
+	reset();
+	sta_init(&sta, 1);
+	sta_init(&failed, 2);
+	sta_init(&peer_only, 3);
+	failed.fail = 1;
+
+	check(!sae_async_pending(&sta), "not pending before commit");
+	check(commit(&sta, password) == 0 && sae_async_pending(&sta),
+	      "pending after commit");
+
+	/*
+	 * use_sae_anti_clogging() counts the STA as open while its state is
+	 * still SAE_NOTHING, also after a worker thread has done the crypto.
+	 */
+#ifdef CONFIG_SAE_THREADS
+	check(wait_processed(1), "commit processed by worker thread");
+#endif /* CONFIG_SAE_THREADS */
+	check(sae_async_pending(&sta) && sta.sae.state == SAE_NOTHING &&
+	      !sta.called, "pending until the callback");
+
+	check(commit(&failed, password) == 0 && commit(&peer_only, NULL) == 0,
+	      "more commits queued");
+	run_eloop(3, 10);
+	check(sta.called == 1 && sta.res == 0 && !sta.pending_in_cb &&
+	      !sae_async_pending(&sta), "not pending from the callback");
+	check(failed.called == 1 && failed.res < 0 && failed.processed == 0,
+	      "failed PWE derivation reported");
+	check(peer_only.called == 1 && peer_only.res == 0 &&
+	      peer_only.prepared == 0 && peer_only.processed == 1,
+	      "own commit not prepared without password");
+}
+
+
+static void test_cancel(void)
+{
+	struct test_sta a, b, queued;
+
+	sta_init(&a, 1);
+	sta_init(&b, 2);
+	sta_init(&queued, 3);
+
+	/* Cancelled before processing */
+	check(commit(&queued, password) == 0, "commit to cancel");
+	sae_async_cancel(&queued);
+	check(!sae_async_pending(&queued), "not pending after cancel");
+	reset();
+
+	/* The first callback frees the other STA, e.g., through
+	 * ap_free_sta(), after both commits may have been processed */
+	a.cancel = &b;
+	b.cancel = &a;
+	check(commit(&a, password) == 0 && commit(&b, password) == 0,
+	      "commits to cancel from callback");
+#ifdef CONFIG_SAE_THREADS
+	wait_processed(2);
+#endif /* CONFIG_SAE_THREADS */
+	run_eloop(1, 10);
+	check(a.called + b.called == 1, "cancelled from callback");
+	check(!sae_async_pending(&a) && !sae_async_pending(&b),
+	      "nothing pending after cancel from callback");
+	check(queued.called == 0, "no callback after cancel");
+
+	/* The STA can commit again */
+	check(commit(&queued, password) == 0, "commit after cancel");
+	run_eloop(called + 1, 10);
+	check(queued.called == 1 && a.called + b.called == 1,
+	      "callback after new commit");
+}
+
+
+#ifdef CONFIG_SAE_THREADS
+
+static void * release_thread(void *arg)
+{
+	os_sleep(0, 100000);
+	pthread_mutex_lock(&test_lock);
+	released = 1;
+	pthread_cond_broadcast(&test_cond);
+	pthread_mutex_unlock(&test_lock);
+	return NULL;
+}
+
+
+static void test_cancel_running(void)
+{
+	struct test_sta *sta;
+	pthread_t thread;
+	int running;
+	unsigned int i;
+
+	reset();
+	sta = os_zalloc(sizeof(*sta));
+	if (sta == NULL) {
+		check(0, "STA allocated");
+		return;
+	}
+	sta_init(sta, 1);
+	sta->block = 1;
+	blocked = released = 0;
+
+	check(commit(sta, password) == 0, "commit to cancel while running");
+	pthread_mutex_lock(&test_lock);
+	for (i = 0; !blocked && i < 50; i++) {
+		struct timespec ts;
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec++;
+		pthread_cond_timedwait(&test_cond, &test_lock, &ts);
+	}
+	running = blocked;
+	pthread_mutex_unlock(&test_lock);
+	check(running, "worker thread running the commit");
+	if (!running || pthread_create(&thread, NULL, release_thread, NULL)) {
+		release_thread(NULL);
+		sae_async_cancel(sta);
+		os_free(sta);
+		return;
+	}
+
+	/* As in ap_free_sta(); the worker thread must be done with the SAE
+	 * data once sae_async_cancel() returns */
+	sae_async_cancel(sta);
+	lock();
+	check(sta->processed == 1, "cancel waited for the worker thread");
+	unlock();
+	check(!sae_async_pending(sta), "not pending after cancel");
+	os_free(sta);
+	pthread_join(thread, NULL);
+
+	run_eloop(1, 1);
+	check(called == 0, "no callback after cancel while running");
+}
+
+
+static void test_random_pool(void)
+{
+	struct test_sta sta[4];
+	u8 buf[32];
+	unsigned int i, queued = 0, ok = 1;
+
+	/* Worker threads use the random pool concurrently with the event
+	 * loop; this is mainly for runs with -fsanitize=thread */
+	reset();
+	for (i = 0; i < ARRAY_SIZE(sta); i++) {
+		sta_init(&sta[i], i);
+		sta[i].random = 1;
+		if (commit(&sta[i], password) == 0)
+			queued++;
+	}
+	for (i = 0; i < RANDOM_ROUNDS; i++) {
+		if (random_get_bytes(buf, sizeof(buf)) < 0)
+			ok = 0;
+		random_add_randomness(buf, sizeof(buf));
+	}
+	run_eloop(queued, 10);
+	for (i = 0; i < ARRAY_SIZE(sta); i++) {
+		if (sta[i].called != 1 || sta[i].res != 0)
+			ok = 0;
+	}
+	check(queued == ARRAY_SIZE(sta) && ok, "random pool from threads");
+}
+
+#endif /* CONFIG_SAE_THREADS */
+
+
+int main(int argc, char *argv[])
+{
+	test_init("sae-async");
+
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+	if (eloop_init() < 0)
+		return -1;
+	random_init(NULL);
+
+	test_queue_limit();
+	test_pending();
+	test_cancel();
+#ifdef CONFIG_SAE_THREADS
+	test_cancel_running();
+	test_random_pool();
+#endif /* CONFIG_SAE_THREADS */
+
+	sae_async_deinit();
+	random_deinit();
+	eloop_destroy();
+	os_program_deinit();
+
+	return test_result();
+}
@@ -10,6 +10,8 @@
 
 #include "common.h"
 #include "crypto/crypto.h"
+#include "crypto/sha1.h"
+#include "crypto/sha1_i.h"
 
 
 static int cavp_shavs(const char *fname)
@@ -106,6 +108,165 @@ static int cavp_shavs(const char *fname)
 }
 
 
+static const struct {
+	const char *msg;
+	int repeat;
+	const char *md;
+} sha1_vectors[] = {
+	{ "abc", 1, "a9993e364706816aba3e25717850c26c9cd0d89d" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+	  "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+	{ "a", 1000000, "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+};
+
+static const struct {
+	const char *passphrase;
+	const char *ssid;
+	const char *psk;
+} pbkdf2_vectors[] = {
+	{ "password", "IEEE",
+	  "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e" },
+	{ "ThisIsAPassword", "ThisIsASSID",
+	  "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af" },
+	{ "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ",
+	  "becb93866bb8c3832cb777c2f559807c8c59afcb6eae734885001300a981cc62" },
+};
+
+
+static int test_vectors(void)
+{
+	struct SHA1Context ctx;
+	u8 hash[SHA1_MAC_LEN], md[SHA1_MAC_LEN], psk[32], expected[32];
+	unsigned int i;
+	int j, ret = 0;
+
+	for (i = 0; i < ARRAY_SIZE(sha1_vectors); i++) {
+		SHA1Init(&ctx);
+		for (j = 0; j < sha1_vectors[i].repeat; j++)
+			SHA1Update(&ctx, sha1_vectors[i].msg,
+				   os_strlen(sha1_vectors[i].msg));
+		SHA1Final(hash, &ctx);
+		if (hexstr2bin(sha1_vectors[i].md, md, sizeof(md)) < 0 ||
+		    os_memcmp(hash, md, sizeof(md)) != 0) {
+			printf("SHA1 test vector %u failed\n", i);
+			ret++;
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(pbkdf2_vectors); i++) {
+		pbkdf2_sha1(pbkdf2_vectors[i].passphrase,
+			    (const u8 *) pbkdf2_vectors[i].ssid,
+			    os_strlen(pbkdf2_vectors[i].ssid), 4096,
+			    psk, sizeof(psk));
+		if (hexstr2bin(pbkdf2_vectors[i].psk, expected,
+			       sizeof(expected)) < 0 ||
+		    os_memcmp(psk, expected, sizeof(psk)) != 0) {
+			printf("PBKDF2-SHA1 test vector %u failed\n", i);
+			ret++;
+		}
+	}
+
+	return ret;
+}
+
+
+/* Compare the CPU instruction based implementation against the portable one
+ * with different message lengths and alignments */
+static int test_cpu(void)
+{
+	u8 data[1024 + 1], hash[SHA1_MAC_LEN], hash_c[SHA1_MAC_LEN];
+	u32 state[3][5], state_c[3][5], *states[3];
+	const unsigned char *blocks[3];
+	const u8 *addr[1];
+	size_t len[1], i, l;
+	int ret = 0;
+
+	if (!SHA1UseCPU(1)) {
+		printf("SHA1 CPU instructions not available\n");
+		return 0;
+	}
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i * 7 + (i >> 8);
+
+	for (i = 0; i < sizeof(data) - 1; i++) {
+		addr[0] = &data[i & 1];
+		len[0] = i;
+		SHA1UseCPU(0);
+		sha1_vector(1, addr, len, hash_c);
+		SHA1UseCPU(1);
+		sha1_vector(1, addr, len, hash);
+		if (os_memcmp(hash, hash_c, sizeof(hash)) != 0) {
+			printf("SHA1 CPU instruction mismatch with length %u\n",
+			       (unsigned int) i);
+			ret++;
+			break;
+		}
+	}
+
+	for (l = 0; l < 3; l++) {
+		for (i = 0; i < 5; i++)
+			state[l][i] = state_c[l][i] = l * 0x01010101 + i;
+		states[l] = state[l];
+		blocks[l] = &data[l * 64 + l];
+		SHA1UseCPU(0);
+		SHA1Transform(state_c[l], blocks[l]);
+	}
+	SHA1UseCPU(1);
+	SHA1TransformMulti(states, blocks, 3);
+	if (os_memcmp(state, state_c, sizeof(state)) != 0) {
+		printf("SHA1 multi-buffer transform mismatch\n");
+		ret++;
+	}
+
+	if (!ret)
+		printf("SHA1 CPU instructions match the portable implementation\n");
+	return ret;
+}
+
+
+static double elapsed(struct os_reltime *start)
+{
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	return diff.sec + diff.usec / 1000000.0;
+}
+
+
+static void bench(const char *name)
+{
+	static u8 data[16384];
+	struct os_reltime start;
+	u8 hash[SHA1_MAC_LEN], psk[32];
+	const u8 *addr[1];
+	size_t len[1];
+	unsigned int count;
+	double t;
+
+	addr[0] = data;
+	len[0] = sizeof(data);
+	count = 0;
+	os_get_reltime(&start);
+	do {
+		sha1_vector(1, addr, len, hash);
+		count++;
+	} while ((t = elapsed(&start)) < 0.2);
+	printf("SHA1 %s: %.1f MB/s", name,
+	       count * sizeof(data) / t / 1000000);
+
+	count = 0;
+	os_get_reltime(&start);
+	do {
+		pbkdf2_sha1("passphrase", (const u8 *) "ssid", 4, 4096, psk,
+			    sizeof(psk));
+		count++;
+	} while ((t = elapsed(&start)) < 0.2);
+	printf(", PBKDF2-SHA1 passphrase to PSK %.2f ms\n", t * 1000 / count);
+}
+
+
 int main(int argc, char *argv[])
 {
 	int ret = 0;
@@ -115,5 +276,19 @@ int main(int argc, char *argv[])
 	if (cavp_shavs("CAVP/SHA1LongMsg.rsp"))
 		ret++;
 
+	SHA1UseCPU(0);
+	if (test_vectors())
+		ret++;
+	SHA1UseCPU(1);
+	if (test_vectors())
+		ret++;
+	if (test_cpu())
+		ret++;
+
+	SHA1UseCPU(0);
+	bench("portable");
+	if (SHA1UseCPU(1))
+		bench("CPU instructions");
+
 	return ret;
 }
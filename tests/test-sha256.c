@@ -10,6 +10,8 @@
 
 #include "common.h"
 #include "crypto/crypto.h"
+#include "crypto/sha256.h"
+#include "crypto/sha256_i.h"
 
 
 static int cavp_shavs(const char *fname)
@@ -106,6 +108,112 @@ static int cavp_shavs(const char *fname)
 }
 
 
+static const struct {
+	const char *msg;
+	int repeat;
+	const char *md;
+} sha256_vectors[] = {
+	{ "abc", 1,
+	  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+	  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "a", 1000000,
+	  "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+};
+
+
+static int test_vectors(void)
+{
+	struct sha256_state ctx;
+	u8 hash[SHA256_MAC_LEN], md[SHA256_MAC_LEN];
+	unsigned int i;
+	int j, ret = 0;
+
+	for (i = 0; i < ARRAY_SIZE(sha256_vectors); i++) {
+		sha256_init(&ctx);
+		for (j = 0; j < sha256_vectors[i].repeat; j++)
+			sha256_process(&ctx,
+				       (const u8 *) sha256_vectors[i].msg,
+				       os_strlen(sha256_vectors[i].msg));
+		sha256_done(&ctx, hash);
+		if (hexstr2bin(sha256_vectors[i].md, md, sizeof(md)) < 0 ||
+		    os_memcmp(hash, md, sizeof(md)) != 0) {
+			printf("SHA256 test vector %u failed\n", i);
+			ret++;
+		}
+	}
+
+	return ret;
+}
+
+
+/* Compare the CPU instruction based implementation against the portable one
+ * with different message lengths and alignments */
+static int test_cpu(void)
+{
+	u8 data[1024 + 1], hash[SHA256_MAC_LEN], hash_c[SHA256_MAC_LEN];
+	const u8 *addr[1];
+	size_t len[1], i;
+
+	if (!sha256_use_cpu(1)) {
+		printf("SHA256 CPU instructions not available\n");
+		return 0;
+	}
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i * 7 + (i >> 8);
+
+	for (i = 0; i < sizeof(data) - 1; i++) {
+		addr[0] = &data[i & 1];
+		len[0] = i;
+		sha256_use_cpu(0);
+		sha256_vector(1, addr, len, hash_c);
+		sha256_use_cpu(1);
+		sha256_vector(1, addr, len, hash);
+		if (os_memcmp(hash, hash_c, sizeof(hash)) != 0) {
+			printf("SHA256 CPU instruction mismatch with length %u\n",
+			       (unsigned int) i);
+			return 1;
+		}
+	}
+
+	printf("SHA256 CPU instructions match the portable implementation\n");
+	return 0;
+}
+
+
+static double elapsed(struct os_reltime *start)
+{
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, start, &diff);
+	return diff.sec + diff.usec / 1000000.0;
+}
+
+
+static void bench(const char *name)
+{
+	static u8 data[16384];
+	struct os_reltime start;
+	u8 hash[SHA256_MAC_LEN];
+	const u8 *addr[1];
+	size_t len[1];
+	unsigned int count = 0;
+	double t;
+
+	addr[0] = data;
+	len[0] = sizeof(data);
+	os_get_reltime(&start);
+	do {
+		sha256_vector(1, addr, len, hash);
+		count++;
+	} while ((t = elapsed(&start)) < 0.2);
+	printf("SHA256 %s: %.1f MB/s\n", name,
+	       count * sizeof(data) / t / 1000000);
+}
+
+
 int main(int argc, char *argv[])
 {
 	int errors = 0;
@@ -115,5 +223,19 @@ int main(int argc, char *argv[])
 	if (cavp_shavs("CAVP/SHA256LongMsg.rsp"))
 		errors++;
 
+	sha256_use_cpu(0);
+	if (test_vectors())
+		errors++;
+	sha256_use_cpu(1);
+	if (test_vectors())
+		errors++;
+	if (test_cpu())
+		errors++;
+
+	sha256_use_cpu(0);
+	bench("portable");
+	if (sha256_use_cpu(1))
+		bench("CPU instructions");
+
 	return errors;
 }
@@ -0,0 +1,209 @@
+/*
+ * STA hash table - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "ap/hostapd.h"
+#include "ap/ap_config.h"
+#include "ap/sta_info.h"
+#include "ap/beacon.h"
+#include "ap_harness.h"
+#include "test_util.h"
+
+#define NUM_STA 1000
+
+/* All addresses share the last octet, which the old table was indexed by */
+static void sta_addr(u8 *addr, unsigned int i)
+{
+	os_memcpy(addr, "\x52\x54\x00", 3);
+	WPA_PUT_BE16(&addr[3], i);
+	addr[5] = 0x01;
+}
+
+
+static int all_found(struct hostapd_data *hapd, unsigned int num)
+{
+	u8 addr[ETH_ALEN];
+	unsigned int i;
+	struct sta_info *sta;
+
+	for (i = 0; i < num; i++) {
+		sta_addr(addr, i);
+		sta = ap_get_sta(hapd, addr);
+		if (sta == NULL || os_memcmp(sta->addr, addr, ETH_ALEN) != 0)
+			return 0;
+	}
+	return 1;
+}
+
+
+static unsigned int longest_chain(struct hostapd_data *hapd)
+{
+	unsigned int i, len, max = 0;
+	struct sta_info *sta;
+
+	for (i = 0; i < hapd->sta_hash_size; i++) {
+		len = 0;
+		for (sta = hapd->sta_hash[i]; sta; sta = sta->hnext)
+			len++;
+		if (len > max)
+			max = len;
+	}
+	return max;
+}
+
+
+static void test_sta_hash(struct ap_harness *h)
+{
+	struct hostapd_data *hapd = &h->hapd;
+	u8 addr[ETH_ALEN];
+	unsigned int i, resized = 1, size = 0;
+	struct sta_info *sta;
+
+	hapd->conf->max_num_sta = NUM_STA;
+	check(ap_get_sta(hapd, hapd->own_addr) == NULL,
+	      "lookup without table");
+
+	for (i = 0; i < NUM_STA; i++) {
+		sta_addr(addr, i);
+		if (ap_sta_add(hapd, addr) == NULL) {
+			check(0, "STA add");
+			return;
+		}
+		if (hapd->sta_hash_size != size) {
+			/* Every STA added so far is found after a resize */
+			size = hapd->sta_hash_size;
+			if (!all_found(hapd, i + 1))
+				resized = 0;
+		}
+	}
+	check(resized, "lookup after resize");
+	check(hapd->num_sta == NUM_STA, "number of STAs");
+	check(hapd->sta_hash_size >= NUM_STA &&
+	      (hapd->sta_hash_size & (hapd->sta_hash_size - 1)) == 0,
+	      "table size");
+	check(all_found(hapd, NUM_STA), "lookup of all STAs");
+	check(longest_chain(hapd) <= 16, "hash chain length");
+	check(ap_get_sta(hapd, hapd->own_addr) == NULL, "lookup of unknown");
+	sta_addr(addr, NUM_STA);
+	check(ap_sta_add(hapd, addr) == NULL, "max_num_sta limit");
+
+	/* Remove every other STA */
+	for (i = 0; i < NUM_STA; i += 2) {
+		sta_addr(addr, i);
+		sta = ap_get_sta(hapd, addr);
+		if (sta)
+			ap_free_sta(hapd, sta);
+	}
+	check(hapd->num_sta == NUM_STA / 2, "number of STAs after removal");
+	for (i = 0; i < NUM_STA; i++) {
+		sta_addr(addr, i);
+		sta = ap_get_sta(hapd, addr);
+		if ((sta == NULL) != !(i & 1)) {
+			check(0, "lookup after removal");
+			break;
+		}
+	}
+
+	/* The table is released once the last STA is gone */
+	hostapd_free_stas(hapd);
+	check(hapd->num_sta == 0 && hapd->sta_list == NULL, "free all STAs");
+	ap_sta_hash_deinit(hapd);
+	check(hapd->sta_hash == NULL && hapd->sta_hash_size == 0,
+	      "table released");
+	sta_addr(addr, 1);
+	check(ap_get_sta(hapd, addr) == NULL, "lookup after release");
+	sta = ap_sta_add(hapd, addr);
+	check(sta && ap_get_sta(hapd, addr) == sta &&
+	      hapd->sta_hash_size == STA_HASH_MIN_SIZE, "table reallocated");
+}
+
+
+/* All addresses share the last three octets the old table was indexed by */
+static void track_addr(u8 *addr, unsigned int i)
+{
+	addr[0] = 0x02;
+	WPA_PUT_BE16(&addr[1], i);
+	os_memcpy(&addr[3], "\x00\x00\x01", 3);
+}
+
+
+static void test_sta_track(struct ap_harness *h)
+{
+	struct hostapd_iface *iface = &h->iface;
+	struct hostapd_sta_info *info;
+	u8 addr[ETH_ALEN];
+	unsigned int i, len, max = 0, found = 1;
+
+	iface->conf->track_sta_max_num = NUM_STA;
+	for (i = 0; i < NUM_STA; i++) {
+		track_addr(addr, i);
+		sta_track_add(iface, addr);
+	}
+	check(iface->num_sta_seen == NUM_STA, "number of tracked STAs");
+	check(iface->sta_seen_hash_size >= NUM_STA &&
+	      (iface->sta_seen_hash_size & (iface->sta_seen_hash_size - 1)) ==
+	      0, "tracking table size");
+	for (i = 0; i < NUM_STA; i++) {
+		track_addr(addr, i);
+		if (!sta_track_seen_on(&h->hapd, addr))
+			found = 0;
+	}
+	check(found, "lookup of tracked STAs");
+	for (i = 0; i < iface->sta_seen_hash_size; i++) {
+		len = 0;
+		for (info = iface->sta_seen_hash[i]; info; info = info->hnext)
+			len++;
+		if (len > max)
+			max = len;
+	}
+	check(max <= 16, "tracking hash chain length");
+
+	/* The least recently seen entry makes room for a new one */
+	track_addr(addr, 0);
+	sta_track_add(iface, addr);
+	track_addr(addr, NUM_STA);
+	sta_track_add(iface, addr);
+	check(iface->num_sta_seen == NUM_STA &&
+	      sta_track_seen_on(&h->hapd, addr), "tracking limit");
+	track_addr(addr, 1);
+	check(!sta_track_seen_on(&h->hapd, addr), "oldest entry expired");
+	track_addr(addr, 0);
+	check(sta_track_seen_on(&h->hapd, addr), "refreshed entry kept");
+
+	sta_track_deinit(iface);
+	check(iface->num_sta_seen == 0 && iface->sta_seen_hash == NULL &&
+	      !sta_track_seen_on(&h->hapd, addr), "tracking table released");
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct ap_harness h;
+
+	test_init("sta-hash");
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+	if (eloop_init() < 0)
+		return -1;
+
+	if (ap_harness_init(&h) < 0) {
+		check(0, "harness init");
+	} else {
+		test_sta_hash(&h);
+		test_sta_track(&h);
+	}
+	ap_harness_deinit(&h);
+
+	eloop_destroy();
+	os_program_deinit();
+
+	return test_result();
+}
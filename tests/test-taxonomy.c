@@ -0,0 +1,251 @@
+/*
+ * Client taxonomy signatures - test program
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "ap/hostapd.h"
+#include "ap/sta_info.h"
+#include "ap/taxonomy.h"
+#include "ap_harness.h"
+#include "test_util.h"
+
+static const u8 phone_probe[] = {
+	0x00, 0x00, /* SSID: wildcard */
+	0x01, 0x04, 0x02, 0x04, 0x0b, 0x16, /* Supported Rates */
+	0x32, 0x08, 0x0c, 0x12, 0x18, 0x24, 0x30, 0x48, 0x60, 0x6c,
+	0x03, 0x01, 0x06, /* DS Parameter Set */
+	0x2d, 0x1a, 0x2d, 0x11, 0x17, 0xff, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* HT Capab */
+	0x7f, 0x08, 0x04, 0x00, 0x08, 0x84, 0x00, 0x00, 0x00, 0x40,
+	0xdd, 0x09, 0x00, 0x10, 0x18, 0x02, 0x00, 0x00, 0x10, 0x00, 0x00,
+	0xdd, 0x08, 0x00, 0x50, 0xf2, 0x08, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const char phone_sig[] =
+	"0,1,50,3,45,127,221(001018,2),221(0050f2,8),htcap:112d,htagg:17,"
+	"htmcs:000000ff,extcap:0400088400000040";
+
+static const u8 wps_probe[] = {
+	0x00, 0x00,
+	0x01, 0x04, 0x02, 0x04, 0x0b, 0x16,
+	0x03, 0x01, 0x0b,
+	0x21, 0x02, 0x00, 0x14, /* Power Capability */
+	0xdd, 0x19, 0x00, 0x50, 0xf2, 0x04, /* WPS */
+	0x10, 0x4a, 0x00, 0x01, 0x10,
+	0x10, 0x3a, 0x00, 0x01, 0x00,
+	0x10, 0x23, 0x00, 0x07, 'N', 'e', 'x', 'u', 's', ' ', '7',
+};
+
+static const char wps_sig[] =
+	"0,1,3,33,221(0050f2,4),txpow:1400,wps:Nexus_7";
+
+/* Offsets of the DS Parameter Set and HT Capab data in phone_probe */
+#define PHONE_DS_CHANNEL 20
+#define PHONE_HT_CAPAB 23
+
+
+static struct hostapd_taxonomy_entry *
+cache_entry(struct hostapd_data *hapd, const u8 *addr)
+{
+	size_t i;
+
+	if (hapd->taxonomy_cache == NULL)
+		return NULL;
+	for (i = 0; i < TAXONOMY_CACHE_SIZE; i++) {
+		if (hapd->taxonomy_cache[i].ie &&
+		    os_memcmp(hapd->taxonomy_cache[i].addr, addr,
+			      ETH_ALEN) == 0)
+			return &hapd->taxonomy_cache[i];
+	}
+	return NULL;
+}
+
+
+static void test_signature(struct hostapd_data *hapd, struct sta_info *sta)
+{
+	u8 ie[sizeof(phone_probe) + 4];
+	size_t ie_len;
+
+	hostapd_taxonomy_probe_req(hapd, sta, wps_probe, sizeof(wps_probe));
+	check(os_strcmp(sta->probe_ie_taxonomy, wps_sig) == 0,
+	      "WPS signature");
+	hostapd_taxonomy_probe_req(hapd, sta, phone_probe,
+				   sizeof(phone_probe));
+	check(os_strcmp(sta->probe_ie_taxonomy, phone_sig) == 0,
+	      "HT signature");
+
+	/*
+	 * Elements that only contribute their tag number to the signature
+	 * must not cause a rebuild; mark the string to detect one.
+	 */
+	sta->probe_ie_taxonomy[0] = 'X';
+	ie[0] = WLAN_EID_SSID;
+	ie[1] = 4;
+	os_memcpy(&ie[2], "home", 4);
+	os_memcpy(&ie[6], phone_probe + 2, sizeof(phone_probe) - 2);
+	ie_len = sizeof(phone_probe) + 4;
+	ie[PHONE_DS_CHANNEL + 4] = 11;
+	hostapd_taxonomy_probe_req(hapd, sta, ie, ie_len);
+	check(sta->probe_ie_taxonomy[0] == 'X', "unchanged signature reused");
+
+	ie[PHONE_HT_CAPAB + 4] = 0x6f;
+	hostapd_taxonomy_probe_req(hapd, sta, ie, ie_len);
+	check(os_strncmp(sta->probe_ie_taxonomy, "0,1,50,3,45,127,", 16) ==
+	      0 && os_strstr(sta->probe_ie_taxonomy, "htcap:116f") != NULL,
+	      "changed HT Capabilities");
+
+	/* Same for the Association Request signature */
+	hostapd_taxonomy_assoc_req(hapd, sta, phone_probe,
+				   sizeof(phone_probe));
+	check(os_strcmp(sta->assoc_ie_taxonomy, phone_sig) == 0,
+	      "assoc signature");
+	sta->assoc_ie_taxonomy[0] = 'X';
+	hostapd_taxonomy_assoc_req(hapd, sta, phone_probe,
+				   sizeof(phone_probe));
+	check(sta->assoc_ie_taxonomy[0] == 'X',
+	      "unchanged assoc signature reused");
+}
+
+
+/* Find an address other than addr that uses the same cache slot */
+/* Find an address that does (or does not) share the cache slot of addr */
+static void slot_addr(struct hostapd_data *hapd, const u8 *addr, int same,
+		      u8 *other)
+{
+	u32 slot = hwaddr_hash(hapd->taxonomy_cache_key, addr) &
+		(TAXONOMY_CACHE_SIZE - 1);
+	unsigned int i;
+
+	/* Walk the last two octets so that addr itself is never returned */
+	os_memcpy(other, addr, ETH_ALEN);
+	for (i = 1; i < 0x10000; i++) {
+		WPA_PUT_BE16(&other[4], WPA_GET_BE16(&addr[4]) + i);
+		if (((hwaddr_hash(hapd->taxonomy_cache_key, other) &
+		      (TAXONOMY_CACHE_SIZE - 1)) == slot) == same)
+			break;
+	}
+}
+
+
+static void test_cache(struct hostapd_data *hapd)
+{
+	const u8 a[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x01, 0x00, 0x00 };
+	u8 b[ETH_ALEN], c[ETH_ALEN], big[TAXONOMY_CACHE_IE_LEN + 64];
+	struct hostapd_taxonomy_entry *entry;
+	struct sta_info *sta;
+	unsigned int i;
+	u8 *ie;
+
+	sta = os_zalloc(sizeof(*sta));
+	if (sta == NULL) {
+		check(0, "STA allocation");
+		return;
+	}
+
+	/* Only the IEs are cached; the signature is built on association */
+	hostapd_taxonomy_probe_req_cache(hapd, a, phone_probe,
+					 sizeof(phone_probe));
+	slot_addr(hapd, a, 0, c);
+	hostapd_taxonomy_probe_req_cache(hapd, c, wps_probe,
+					 sizeof(wps_probe));
+	entry = cache_entry(hapd, a);
+	check(entry && entry->ie_len == sizeof(phone_probe) &&
+	      os_memcmp(entry->ie, phone_probe, sizeof(phone_probe)) == 0,
+	      "cached IEs");
+	ie = entry ? entry->ie : NULL;
+	hostapd_taxonomy_probe_req_cache(hapd, a, phone_probe,
+					 sizeof(phone_probe));
+	check(entry && entry->ie == ie, "unchanged cached IEs reused");
+
+	/* The signature moves to the STA on association */
+	os_memcpy(sta->addr, a, ETH_ALEN);
+	hostapd_taxonomy_assoc_req(hapd, sta, wps_probe, sizeof(wps_probe));
+	check(os_strcmp(sta->probe_ie_taxonomy, phone_sig) == 0 &&
+	      os_strcmp(sta->assoc_ie_taxonomy, wps_sig) == 0,
+	      "cached signature on association");
+	check(cache_entry(hapd, a) == NULL, "cache entry released");
+	check(cache_entry(hapd, c) != NULL, "other cache entry kept");
+
+	/* A colliding station replaces the entry */
+	slot_addr(hapd, a, 1, b);
+	hostapd_taxonomy_probe_req_cache(hapd, a, phone_probe,
+					 sizeof(phone_probe));
+	hostapd_taxonomy_probe_req_cache(hapd, b, wps_probe,
+					 sizeof(wps_probe));
+	check(cache_entry(hapd, a) == NULL && cache_entry(hapd, b) != NULL,
+	      "colliding station replaces entry");
+	os_memset(sta, 0, sizeof(*sta));
+	os_memcpy(sta->addr, a, ETH_ALEN);
+	hostapd_taxonomy_assoc_req(hapd, sta, wps_probe, sizeof(wps_probe));
+	check(sta->probe_ie_taxonomy[0] == '\0',
+	      "no signature for replaced station");
+
+	/* A stale entry is not used and is released on association */
+	hostapd_taxonomy_probe_req_cache(hapd, a, phone_probe,
+					 sizeof(phone_probe));
+	entry = cache_entry(hapd, a);
+	if (entry)
+		entry->seen.sec -= TAXONOMY_CACHE_MAX_AGE + 1;
+	os_memset(sta, 0, sizeof(*sta));
+	os_memcpy(sta->addr, a, ETH_ALEN);
+	hostapd_taxonomy_assoc_req(hapd, sta, wps_probe, sizeof(wps_probe));
+	check(entry && sta->probe_ie_taxonomy[0] == '\0' &&
+	      cache_entry(hapd, a) == NULL, "stale entry not used");
+
+	/* Stale entries are released without a colliding station */
+	entry = cache_entry(hapd, c);
+	if (entry)
+		entry->seen.sec -= TAXONOMY_CACHE_MAX_AGE + 1;
+	for (i = 0; i < TAXONOMY_CACHE_SIZE; i++)
+		hostapd_taxonomy_probe_req_cache(hapd, a, phone_probe,
+						 sizeof(phone_probe));
+	check(entry && cache_entry(hapd, c) == NULL &&
+	      cache_entry(hapd, a) != NULL, "stale entry released");
+
+	/* Only a bounded prefix of the IEs is kept */
+	for (i = 0; i + 2 + 255 <= sizeof(big); i += 2 + 255) {
+		big[i] = WLAN_EID_VENDOR_SPECIFIC;
+		big[i + 1] = 255;
+		os_memset(&big[i + 2], i / 257, 255);
+	}
+	hostapd_taxonomy_probe_req_cache(hapd, c, big, i);
+	entry = cache_entry(hapd, c);
+	check(i > TAXONOMY_CACHE_IE_LEN && entry &&
+	      entry->ie_len == TAXONOMY_CACHE_IE_LEN, "bounded IE copy");
+
+	os_free(sta);
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct ap_harness h;
+	struct sta_info *sta;
+
+	test_init("taxonomy");
+	if (os_program_init())
+		return -1;
+	wpa_debug_level = MSG_ERROR;
+
+	sta = os_zalloc(sizeof(*sta));
+	if (sta == NULL || ap_harness_init(&h) < 0) {
+		printf("taxonomy: init failed\n");
+		os_free(sta);
+		return -1;
+	}
+
+	test_signature(&h.hapd, sta);
+	test_cache(&h.hapd);
+
+	os_free(sta);
+	ap_harness_deinit(&h);
+	os_program_deinit();
+
+	return test_result();
+}
@@ -0,0 +1,63 @@
+/*
+ * Common helpers for test programs
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "test_util.h"
+
+static const char *test_name = "test";
+static int errors;
+
+
+/**
+ * test_init - Set the name printed in front of failure messages
+ * @name: Name of the test program
+ */
+void test_init(const char *name)
+{
+	test_name = name;
+	errors = 0;
+}
+
+
+/**
+ * check - Record the result of a single check
+ * @cond: Whether the check passed
+ * @what: Description of the check for the failure message
+ */
+void check(int cond, const char *what)
+{
+	if (!cond) {
+		printf("%s: %s failed\n", test_name, what);
+		errors++;
+	}
+}
+
+
+/**
+ * test_errors - Number of failed checks so far
+ */
+int test_errors(void)
+{
+	return errors;
+}
+
+
+/**
+ * test_result - Report the number of failed checks
+ * Returns: 0 if all checks passed, -1 otherwise; suitable as exit status
+ */
+int test_result(void)
+{
+	if (errors) {
+		printf("%s: %d test(s) failed\n", test_name, errors);
+		return -1;
+	}
+
+	return 0;
+}
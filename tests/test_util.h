@@ -0,0 +1,16 @@
+/*
+ * Common helpers for test programs
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+void test_init(const char *name);
+void check(int cond, const char *what);
+int test_errors(void);
+int test_result(void);
+
+#endif /* TEST_UTIL_H */
@@ -807,6 +807,10 @@ OBJS += src/ap/wpa_auth_glue.c
 OBJS += src/ap/utils.c
 OBJS += src/ap/authsrv.c
 OBJS += src/ap/ap_config.c
+OBJS += src/ap/psk_derive.c
+ifdef CONFIG_SAE
+OBJS += src/ap/sae_async.c
+endif
 OBJS += src/utils/ip_addr.c
 OBJS += src/ap/sta_info.c
 OBJS += src/ap/tkip_countermeasures.c
@@ -1332,6 +1336,7 @@ L_CFLAGS += -DCONFIG_CTRL_IFACE_UDP
 L_CFLAGS += -DCONFIG_CTRL_IFACE_UDP_REMOTE
 endif
 OBJS += ctrl_iface.c ctrl_iface_$(CONFIG_CTRL_IFACE).c
+OBJS += src/common/ctrl_cmd.c
 endif
 
 ifdef CONFIG_CTRL_IFACE_DBUS
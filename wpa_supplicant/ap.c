@@ -1090,6 +1090,21 @@ int ap_ctrl_iface_sta_next(struct wpa_supplicant *wpa_s, const char *txtaddr,
 }
 
 
+int ap_ctrl_iface_sta_dump(struct wpa_supplicant *wpa_s, char *params,
+			   char *buf, size_t buflen)
+{
+	struct hostapd_data *hapd;
+
+	if (wpa_s->ap_iface)
+		hapd = wpa_s->ap_iface->bss[0];
+	else if (wpa_s->ifmsh)
+		hapd = wpa_s->ifmsh->bss[0];
+	else
+		return -1;
+	return hostapd_ctrl_iface_sta_dump(hapd, params, buf, buflen);
+}
+
+
 int ap_ctrl_iface_sta_disassociate(struct wpa_supplicant *wpa_s,
 				   const char *txtaddr)
 {
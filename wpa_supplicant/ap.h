@@ -32,6 +32,8 @@ int ap_ctrl_iface_sta(struct wpa_supplicant *wpa_s, const char *txtaddr,
 		      char *buf, size_t buflen);
 int ap_ctrl_iface_sta_next(struct wpa_supplicant *wpa_s, const char *txtaddr,
 			   char *buf, size_t buflen);
+int ap_ctrl_iface_sta_dump(struct wpa_supplicant *wpa_s, char *params,
+			   char *buf, size_t buflen);
 int ap_ctrl_iface_sta_deauthenticate(struct wpa_supplicant *wpa_s,
 				     const char *txtaddr);
 int ap_ctrl_iface_sta_disassociate(struct wpa_supplicant *wpa_s,
@@ -19,6 +19,7 @@
 #include "common/ieee802_11_defs.h"
 #include "common/ieee802_11_common.h"
 #include "common/wpa_ctrl.h"
+#include "common/ctrl_cmd.h"
 #include "crypto/tls.h"
 #include "ap/hostapd.h"
 #include "eap_peer/eap.h"
@@ -8074,12 +8075,830 @@ static int wpas_ctrl_cmd_debug_level(const char *cmd)
 }
 
 
+static int wpas_ctrl_cmd_ping(struct wpa_supplicant *wpa_s, char *params,
+			      char *reply, int reply_size)
+{
+	os_memcpy(reply, "PONG\n", 5);
+	return 5;
+}
+
+
+static int wpas_ctrl_cmd_ifname(struct wpa_supplicant *wpa_s, char *params,
+				char *reply, int reply_size)
+{
+	int reply_len = os_strlen(wpa_s->ifname);
+
+	os_memcpy(reply, wpa_s->ifname, reply_len);
+	return reply_len;
+}
+
+
+static int wpas_ctrl_cmd_mib(struct wpa_supplicant *wpa_s, char *params,
+			     char *reply, int reply_size)
+{
+	int reply_len;
+
+	reply_len = wpa_sm_get_mib(wpa_s->wpa, reply, reply_size);
+	if (reply_len >= 0) {
+		reply_len += eapol_sm_get_mib(wpa_s->eapol, reply + reply_len,
+					      reply_size - reply_len);
+	}
+	return reply_len;
+}
+
+
+static int wpas_ctrl_cmd_status(struct wpa_supplicant *wpa_s, char *params,
+				char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_status(wpa_s, "", reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_get(struct wpa_supplicant *wpa_s, char *params,
+			     char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_get(wpa_s, params, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_list_networks(struct wpa_supplicant *wpa_s,
+				       char *params, char *reply,
+				       int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_list_networks(wpa_s, params, reply,
+						       reply_size);
+}
+
+
+static int wpas_ctrl_cmd_scan_results(struct wpa_supplicant *wpa_s,
+				      char *params, char *reply,
+				      int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_scan_results(wpa_s, reply,
+						      reply_size);
+}
+
+
+static int wpas_ctrl_cmd_get_network(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_get_network(wpa_s, params, reply,
+						     reply_size);
+}
+
+
+static int wpas_ctrl_cmd_interfaces(struct wpa_supplicant *wpa_s,
+				    char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_global_iface_interfaces(wpa_s->global, reply,
+						      reply_size);
+}
+
+
+static int wpas_ctrl_cmd_bss(struct wpa_supplicant *wpa_s, char *params,
+			     char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_bss(wpa_s, params, reply, reply_size);
+}
+
+
+#ifdef CONFIG_AP
+static int wpas_ctrl_cmd_sta_first(struct wpa_supplicant *wpa_s,
+				   char *params, char *reply, int reply_size)
+{
+	return ap_ctrl_iface_sta_first(wpa_s, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_sta(struct wpa_supplicant *wpa_s, char *params,
+			     char *reply, int reply_size)
+{
+	return ap_ctrl_iface_sta(wpa_s, params, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_sta_next(struct wpa_supplicant *wpa_s, char *params,
+				  char *reply, int reply_size)
+{
+	return ap_ctrl_iface_sta_next(wpa_s, params, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_sta_dump(struct wpa_supplicant *wpa_s, char *params,
+				  char *reply, int reply_size)
+{
+	return ap_ctrl_iface_sta_dump(wpa_s, params, reply, reply_size);
+}
+#endif /* CONFIG_AP */
+
+
+static int wpas_ctrl_cmd_wmm_ac_status(struct wpa_supplicant *wpa_s,
+				       char *params, char *reply,
+				       int reply_size)
+{
+	return wpas_wmm_ac_status(wpa_s, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_signal_poll(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_signal_poll(wpa_s, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_pktcnt_poll(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_pktcnt_poll(wpa_s, reply, reply_size);
+}
+
+static int wpas_ctrl_cmd_relog(struct wpa_supplicant *wpa_s, char *params,
+			       char *reply, int reply_size)
+{
+	return wpa_debug_reopen_file();
+}
+
+
+static int wpas_ctrl_cmd_note(struct wpa_supplicant *wpa_s, char *params,
+			      char *reply, int reply_size)
+{
+	wpa_printf(MSG_INFO, "NOTE: %s", params);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_pmksa(struct wpa_supplicant *wpa_s, char *params,
+			       char *reply, int reply_size)
+{
+	return wpa_sm_pmksa_cache_list(wpa_s->wpa, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_pmksa_flush(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	wpa_sm_pmksa_cache_flush(wpa_s->wpa, NULL);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_set(struct wpa_supplicant *wpa_s, char *params,
+			     char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_set(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_logon(struct wpa_supplicant *wpa_s, char *params,
+			       char *reply, int reply_size)
+{
+	eapol_sm_notify_logoff(wpa_s->eapol, FALSE);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_logoff(struct wpa_supplicant *wpa_s, char *params,
+				char *reply, int reply_size)
+{
+	eapol_sm_notify_logoff(wpa_s->eapol, TRUE);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_reassociate(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	if (wpa_s->wpa_state == WPA_INTERFACE_DISABLED)
+		return -1;
+	wpas_request_connection(wpa_s);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_reattach(struct wpa_supplicant *wpa_s, char *params,
+				  char *reply, int reply_size)
+{
+	if (wpa_s->wpa_state == WPA_INTERFACE_DISABLED ||
+	    !wpa_s->current_ssid)
+		return -1;
+	wpa_s->reattach = 1;
+	wpas_request_connection(wpa_s);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_reconnect(struct wpa_supplicant *wpa_s, char *params,
+				   char *reply, int reply_size)
+{
+	if (wpa_s->wpa_state == WPA_INTERFACE_DISABLED)
+		return -1;
+	if (wpa_s->disconnected)
+		wpas_request_connection(wpa_s);
+	return 0;
+}
+
+
+#ifdef IEEE8021X_EAPOL
+static int wpas_ctrl_cmd_preauth(struct wpa_supplicant *wpa_s, char *params,
+				 char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_preauth(wpa_s, params);
+}
+#endif /* IEEE8021X_EAPOL */
+
+
+#ifdef CONFIG_IEEE80211R
+static int wpas_ctrl_cmd_ft_ds(struct wpa_supplicant *wpa_s, char *params,
+			       char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_ft_ds(wpa_s, params);
+}
+#endif /* CONFIG_IEEE80211R */
+
+
+static int wpas_ctrl_cmd_reconfigure(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_reload_configuration(wpa_s);
+}
+
+
+static int wpas_ctrl_cmd_terminate(struct wpa_supplicant *wpa_s, char *params,
+				   char *reply, int reply_size)
+{
+	wpa_supplicant_terminate_proc(wpa_s->global);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_bssid(struct wpa_supplicant *wpa_s, char *params,
+			       char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_bssid(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_disconnect(struct wpa_supplicant *wpa_s,
+				    char *params, char *reply, int reply_size)
+{
+#ifdef CONFIG_SME
+	wpa_s->sme.prev_bssid_set = 0;
+#endif /* CONFIG_SME */
+	wpa_s->reassociate = 0;
+	wpa_s->disconnected = 1;
+	wpa_supplicant_cancel_sched_scan(wpa_s);
+	wpa_supplicant_cancel_scan(wpa_s);
+	wpa_supplicant_deauthenticate(wpa_s, WLAN_REASON_DEAUTH_LEAVING);
+	eloop_cancel_timeout(wpas_network_reenabled, wpa_s, NULL);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_scan(struct wpa_supplicant *wpa_s, char *params,
+			      char *reply, int reply_size)
+{
+	int reply_len = 3;
+
+	wpas_ctrl_scan(wpa_s, params, reply, reply_size, &reply_len);
+	return reply_len;
+}
+
+
+static int wpas_ctrl_cmd_select_network(struct wpa_supplicant *wpa_s,
+					char *params, char *reply,
+					int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_select_network(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_enable_network(struct wpa_supplicant *wpa_s,
+					char *params, char *reply,
+					int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_enable_network(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_disable_network(struct wpa_supplicant *wpa_s,
+					 char *params, char *reply,
+					 int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_disable_network(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_add_network(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_add_network(wpa_s, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_remove_network(struct wpa_supplicant *wpa_s,
+					char *params, char *reply,
+					int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_remove_network(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_set_network(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_set_network(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_dup_network(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_dup_network(wpa_s, params, wpa_s);
+}
+
+
+static int wpas_ctrl_cmd_list_creds(struct wpa_supplicant *wpa_s,
+				    char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_list_creds(wpa_s, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_add_cred(struct wpa_supplicant *wpa_s, char *params,
+				  char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_add_cred(wpa_s, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_remove_cred(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_remove_cred(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_set_cred(struct wpa_supplicant *wpa_s, char *params,
+				  char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_set_cred(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_get_cred(struct wpa_supplicant *wpa_s, char *params,
+				  char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_get_cred(wpa_s, params, reply,
+						  reply_size);
+}
+
+
+#ifndef CONFIG_NO_CONFIG_WRITE
+static int wpas_ctrl_cmd_save_config(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_save_config(wpa_s);
+}
+#endif /* CONFIG_NO_CONFIG_WRITE */
+
+
+static int wpas_ctrl_cmd_get_capability(struct wpa_supplicant *wpa_s,
+					char *params, char *reply,
+					int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_get_capability(wpa_s, params, reply,
+							reply_size);
+}
+
+
+static int wpas_ctrl_cmd_ap_scan(struct wpa_supplicant *wpa_s, char *params,
+				 char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_ap_scan(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_scan_interval(struct wpa_supplicant *wpa_s,
+				       char *params, char *reply,
+				       int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_scan_interval(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_interface_list(struct wpa_supplicant *wpa_s,
+					char *params, char *reply,
+					int reply_size)
+{
+	return wpa_supplicant_global_iface_list(wpa_s->global, reply,
+						reply_size);
+}
+
+
+#ifdef CONFIG_AP
+static int wpas_ctrl_cmd_deauthenticate(struct wpa_supplicant *wpa_s,
+					char *params, char *reply,
+					int reply_size)
+{
+	return ap_ctrl_iface_sta_deauthenticate(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_disassociate(struct wpa_supplicant *wpa_s,
+				      char *params, char *reply,
+				      int reply_size)
+{
+	return ap_ctrl_iface_sta_disassociate(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_chan_switch(struct wpa_supplicant *wpa_s,
+				     char *params, char *reply, int reply_size)
+{
+	return ap_ctrl_iface_chanswitch(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_stop_ap(struct wpa_supplicant *wpa_s, char *params,
+				 char *reply, int reply_size)
+{
+	return wpas_ap_stop_ap(wpa_s);
+}
+#endif /* CONFIG_AP */
+
+
+static int wpas_ctrl_cmd_suspend(struct wpa_supplicant *wpa_s, char *params,
+				 char *reply, int reply_size)
+{
+	wpas_notify_suspend(wpa_s->global);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_resume(struct wpa_supplicant *wpa_s, char *params,
+				char *reply, int reply_size)
+{
+	wpas_notify_resume(wpa_s->global);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_roam(struct wpa_supplicant *wpa_s, char *params,
+			      char *reply, int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_roam(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_sta_autoconnect(struct wpa_supplicant *wpa_s,
+					 char *params, char *reply,
+					 int reply_size)
+{
+	wpa_s->auto_reconnect_disabled = atoi(params) == 0;
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_bss_expire_age(struct wpa_supplicant *wpa_s,
+					char *params, char *reply,
+					int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_bss_expire_age(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_bss_expire_count(struct wpa_supplicant *wpa_s,
+					  char *params, char *reply,
+					  int reply_size)
+{
+	return wpa_supplicant_ctrl_iface_bss_expire_count(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_bss_flush(struct wpa_supplicant *wpa_s, char *params,
+				   char *reply, int reply_size)
+{
+	wpa_supplicant_ctrl_iface_bss_flush(wpa_s, params);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_wmm_ac_addts(struct wpa_supplicant *wpa_s,
+				      char *params, char *reply,
+				      int reply_size)
+{
+	return wmm_ac_ctrl_addts(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_wmm_ac_delts(struct wpa_supplicant *wpa_s,
+				      char *params, char *reply,
+				      int reply_size)
+{
+	return wmm_ac_ctrl_delts(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_vendor(struct wpa_supplicant *wpa_s, char *params,
+				char *reply, int reply_size)
+{
+	return wpa_supplicant_vendor_cmd(wpa_s, params, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_reauthenticate(struct wpa_supplicant *wpa_s,
+					char *params, char *reply,
+					int reply_size)
+{
+	pmksa_cache_clear_current(wpa_s->wpa);
+	eapol_sm_request_reauth(wpa_s->eapol);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_flush(struct wpa_supplicant *wpa_s, char *params,
+			       char *reply, int reply_size)
+{
+	wpa_supplicant_ctrl_iface_flush(wpa_s);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_radio_work(struct wpa_supplicant *wpa_s,
+				    char *params, char *reply, int reply_size)
+{
+	return wpas_ctrl_radio_work(wpa_s, params, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_vendor_elem_add(struct wpa_supplicant *wpa_s,
+					 char *params, char *reply,
+					 int reply_size)
+{
+	return wpas_ctrl_vendor_elem_add(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_vendor_elem_get(struct wpa_supplicant *wpa_s,
+					 char *params, char *reply,
+					 int reply_size)
+{
+	return wpas_ctrl_vendor_elem_get(wpa_s, params, reply, reply_size);
+}
+
+
+static int wpas_ctrl_cmd_vendor_elem_remove(struct wpa_supplicant *wpa_s,
+					    char *params, char *reply,
+					    int reply_size)
+{
+	return wpas_ctrl_vendor_elem_remove(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_erp_flush(struct wpa_supplicant *wpa_s, char *params,
+				   char *reply, int reply_size)
+{
+	wpas_ctrl_iface_erp_flush(wpa_s);
+	return 0;
+}
+
+
+static int wpas_ctrl_cmd_mac_rand_scan(struct wpa_supplicant *wpa_s,
+				       char *params, char *reply,
+				       int reply_size)
+{
+	return wpas_ctrl_iface_mac_rand_scan(wpa_s, params);
+}
+
+
+static int wpas_ctrl_cmd_get_pref_freq_list(struct wpa_supplicant *wpa_s,
+					    char *params, char *reply,
+					    int reply_size)
+{
+	return wpas_ctrl_iface_get_pref_freq_list(wpa_s, params, reply,
+						  reply_size);
+}
+
+
+static int wpas_ctrl_cmd_cmd_stats(struct wpa_supplicant *wpa_s, char *params,
+				   char *reply, int reply_size);
+
+
+/*
+ * Per-interface commands that are looked up with a binary search. The entries
+ * must be kept sorted by name (strcmp() order); test-ctrl-cmd checks this.
+ * Commands that are parsed by prefix or that belong to optional features
+ * (WPS, P2P, Interworking, TDLS, mesh, testing) are handled by the
+ * comparisons in wpa_supplicant_ctrl_iface_process().
+ */
+static const struct wpas_ctrl_cmd {
+	const char *name;
+	unsigned int flags;
+	int (*handler)(struct wpa_supplicant *wpa_s, char *params, char *reply,
+		       int reply_size);
+} wpas_ctrl_cmds[] = {
+	{ "ADD_CRED", CTRL_CMD_BARE, wpas_ctrl_cmd_add_cred },
+	{ "ADD_NETWORK", CTRL_CMD_BARE, wpas_ctrl_cmd_add_network },
+	{ "AP_SCAN", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, wpas_ctrl_cmd_ap_scan },
+	{ "BSS", CTRL_CMD_PARAMS, wpas_ctrl_cmd_bss },
+	{ "BSSID", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, wpas_ctrl_cmd_bssid },
+	{ "BSS_EXPIRE_AGE", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_bss_expire_age },
+	{ "BSS_EXPIRE_COUNT", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_bss_expire_count },
+	{ "BSS_FLUSH", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_bss_flush },
+#ifdef CONFIG_AP
+	{ "CHAN_SWITCH", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_chan_switch },
+#endif /* CONFIG_AP */
+	{ "CMD_STATS", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  wpas_ctrl_cmd_cmd_stats },
+#ifdef CONFIG_AP
+	{ "DEAUTHENTICATE", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_deauthenticate },
+#endif /* CONFIG_AP */
+	{ "DISABLE_NETWORK", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_disable_network },
+#ifdef CONFIG_AP
+	{ "DISASSOCIATE", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_disassociate },
+#endif /* CONFIG_AP */
+	{ "DISCONNECT", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_disconnect },
+	{ "DUP_NETWORK", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_dup_network },
+	{ "ENABLE_NETWORK", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_enable_network },
+	{ "ERP_FLUSH", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_erp_flush },
+	{ "FLUSH", CTRL_CMD_BARE | CTRL_CMD_STATUS, wpas_ctrl_cmd_flush },
+#ifdef CONFIG_IEEE80211R
+	{ "FT_DS", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, wpas_ctrl_cmd_ft_ds },
+#endif /* CONFIG_IEEE80211R */
+	{ "GET", CTRL_CMD_PARAMS, wpas_ctrl_cmd_get },
+	{ "GET_CAPABILITY", CTRL_CMD_PARAMS, wpas_ctrl_cmd_get_capability },
+	{ "GET_CRED", CTRL_CMD_PARAMS, wpas_ctrl_cmd_get_cred },
+	{ "GET_NETWORK", CTRL_CMD_PARAMS, wpas_ctrl_cmd_get_network },
+	{ "GET_PREF_FREQ_LIST", CTRL_CMD_PARAMS,
+	  wpas_ctrl_cmd_get_pref_freq_list },
+	{ "IFNAME", CTRL_CMD_BARE, wpas_ctrl_cmd_ifname },
+	{ "INTERFACES", CTRL_CMD_BARE, wpas_ctrl_cmd_interfaces },
+	{ "INTERFACE_LIST", CTRL_CMD_BARE, wpas_ctrl_cmd_interface_list },
+	{ "LIST_CREDS", CTRL_CMD_BARE, wpas_ctrl_cmd_list_creds },
+	{ "LIST_NETWORKS", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  wpas_ctrl_cmd_list_networks },
+	{ "LOGOFF", CTRL_CMD_BARE | CTRL_CMD_STATUS, wpas_ctrl_cmd_logoff },
+	{ "LOGON", CTRL_CMD_BARE | CTRL_CMD_STATUS, wpas_ctrl_cmd_logon },
+	{ "MAC_RAND_SCAN", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_mac_rand_scan },
+	{ "MIB", CTRL_CMD_BARE, wpas_ctrl_cmd_mib },
+	{ "NOTE", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, wpas_ctrl_cmd_note },
+	{ "PING", CTRL_CMD_BARE, wpas_ctrl_cmd_ping },
+	{ "PKTCNT_POLL", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  wpas_ctrl_cmd_pktcnt_poll },
+	{ "PMKSA", CTRL_CMD_BARE, wpas_ctrl_cmd_pmksa },
+	{ "PMKSA_FLUSH", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_pmksa_flush },
+#ifdef IEEE8021X_EAPOL
+	{ "PREAUTH", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, wpas_ctrl_cmd_preauth },
+#endif /* IEEE8021X_EAPOL */
+	{ "RADIO_WORK", CTRL_CMD_PARAMS, wpas_ctrl_cmd_radio_work },
+	{ "REASSOCIATE", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_reassociate },
+	{ "REATTACH", CTRL_CMD_BARE | CTRL_CMD_STATUS, wpas_ctrl_cmd_reattach },
+	{ "REAUTHENTICATE", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_reauthenticate },
+	{ "RECONFIGURE", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_reconfigure },
+	{ "RECONNECT", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_reconnect },
+	{ "RELOG", CTRL_CMD_BARE | CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_relog },
+	{ "REMOVE_CRED", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_remove_cred },
+	{ "REMOVE_NETWORK", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_remove_network },
+	{ "RESUME", CTRL_CMD_BARE | CTRL_CMD_STATUS, wpas_ctrl_cmd_resume },
+	{ "ROAM", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, wpas_ctrl_cmd_roam },
+#ifndef CONFIG_NO_CONFIG_WRITE
+	{ "SAVE_CONFIG", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_save_config },
+#endif /* CONFIG_NO_CONFIG_WRITE */
+	{ "SCAN", CTRL_CMD_BARE | CTRL_CMD_PARAMS, wpas_ctrl_cmd_scan },
+	{ "SCAN_INTERVAL", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_scan_interval },
+	{ "SCAN_RESULTS", CTRL_CMD_BARE, wpas_ctrl_cmd_scan_results },
+	{ "SELECT_NETWORK", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_select_network },
+	{ "SET", CTRL_CMD_PARAMS | CTRL_CMD_STATUS, wpas_ctrl_cmd_set },
+	{ "SET_CRED", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_set_cred },
+	{ "SET_NETWORK", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_set_network },
+	{ "SIGNAL_POLL", CTRL_CMD_BARE | CTRL_CMD_PARAMS,
+	  wpas_ctrl_cmd_signal_poll },
+#ifdef CONFIG_AP
+	{ "STA", CTRL_CMD_PARAMS, wpas_ctrl_cmd_sta },
+	{ "STA-DUMP", CTRL_CMD_BARE | CTRL_CMD_PARAMS, wpas_ctrl_cmd_sta_dump },
+	{ "STA-FIRST", CTRL_CMD_BARE, wpas_ctrl_cmd_sta_first },
+	{ "STA-NEXT", CTRL_CMD_PARAMS, wpas_ctrl_cmd_sta_next },
+#endif /* CONFIG_AP */
+	{ "STATUS", CTRL_CMD_BARE, wpas_ctrl_cmd_status },
+	{ "STA_AUTOCONNECT", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_sta_autoconnect },
+#ifdef CONFIG_AP
+	{ "STOP_AP", CTRL_CMD_BARE | CTRL_CMD_STATUS, wpas_ctrl_cmd_stop_ap },
+#endif /* CONFIG_AP */
+	{ "SUSPEND", CTRL_CMD_BARE | CTRL_CMD_STATUS, wpas_ctrl_cmd_suspend },
+	{ "TERMINATE", CTRL_CMD_BARE | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_terminate },
+	{ "VENDOR", CTRL_CMD_PARAMS, wpas_ctrl_cmd_vendor },
+	{ "VENDOR_ELEM_ADD", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_vendor_elem_add },
+	{ "VENDOR_ELEM_GET", CTRL_CMD_PARAMS, wpas_ctrl_cmd_vendor_elem_get },
+	{ "VENDOR_ELEM_REMOVE", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_vendor_elem_remove },
+	{ "WMM_AC_ADDTS", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_wmm_ac_addts },
+	{ "WMM_AC_DELTS", CTRL_CMD_PARAMS | CTRL_CMD_STATUS,
+	  wpas_ctrl_cmd_wmm_ac_delts },
+	{ "WMM_AC_STATUS", CTRL_CMD_BARE, wpas_ctrl_cmd_wmm_ac_status },
+};
+
+/* Statistics for commands that are not in wpas_ctrl_cmds[] */
+#define WPAS_CTRL_OTHER_CMD_STATS 64
+
+/* Index of the unknown command counters in wpa_s->ctrl_cmd_stats */
+#define WPAS_CTRL_UNKNOWN_CMD ARRAY_SIZE(wpas_ctrl_cmds)
+
+
+static int wpas_ctrl_cmd_cmd_stats(struct wpa_supplicant *wpa_s, char *params,
+				   char *reply, int reply_size)
+{
+	char *pos = reply, *end = reply + reply_size;
+	size_t i;
+	int ret;
+
+	if (wpa_s->ctrl_cmd_stats == NULL ||
+	    wpa_s->ctrl_other_cmd_stats == NULL)
+		return -1;
+
+	if (params) {
+		if (os_strcmp(params, "RESET") != 0)
+			return -1;
+		os_memset(wpa_s->ctrl_cmd_stats, 0,
+			  (WPAS_CTRL_UNKNOWN_CMD + 1) *
+			  sizeof(wpa_s->ctrl_cmd_stats[0]));
+		os_memset(wpa_s->ctrl_other_cmd_stats, 0,
+			  WPAS_CTRL_OTHER_CMD_STATS *
+			  sizeof(wpa_s->ctrl_other_cmd_stats[0]));
+		os_memcpy(reply, "OK\n", 3);
+		return 3;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(wpas_ctrl_cmds); i++) {
+		ret = ctrl_cmd_stats_print(wpas_ctrl_cmds[i].name,
+					   &wpa_s->ctrl_cmd_stats[i],
+					   pos, end - pos);
+		if (ret < 0)
+			return pos - reply;
+		pos += ret;
+	}
+	for (i = 0; i < WPAS_CTRL_OTHER_CMD_STATS &&
+		     wpa_s->ctrl_other_cmd_stats[i].name[0]; i++) {
+		struct ctrl_cmd_named_stats *other =
+			&wpa_s->ctrl_other_cmd_stats[i];
+
+		ret = ctrl_cmd_stats_print(other->name, &other->stats,
+					   pos, end - pos);
+		if (ret < 0)
+			return pos - reply;
+		pos += ret;
+	}
+	ret = ctrl_cmd_stats_print("UNKNOWN",
+				   &wpa_s->ctrl_cmd_stats[
+					   WPAS_CTRL_UNKNOWN_CMD],
+				   pos, end - pos);
+	if (ret > 0)
+		pos += ret;
+
+	return pos - reply;
+}
+
+
 char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 					 char *buf, size_t *resp_len)
 {
 	char *reply;
 	const int reply_size = 4096;
 	int reply_len;
+	const struct wpas_ctrl_cmd *cmd;
+	struct ctrl_cmd_stats *stats;
+	struct os_reltime start;
+	char name[CTRL_CMD_NAME_LEN];
+	char *params;
 
 	if (os_strncmp(buf, WPA_CTRL_RSP, os_strlen(WPA_CTRL_RSP)) == 0 ||
 	    os_strncmp(buf, "SET_NETWORK ", 12) == 0) {
@@ -8107,81 +8926,53 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		return NULL;
 	}
 
+	if (wpa_s->ctrl_cmd_stats == NULL)
+		wpa_s->ctrl_cmd_stats = os_calloc(
+			WPAS_CTRL_UNKNOWN_CMD + 1,
+			sizeof(struct ctrl_cmd_stats));
+	if (wpa_s->ctrl_other_cmd_stats == NULL)
+		wpa_s->ctrl_other_cmd_stats = os_calloc(
+			WPAS_CTRL_OTHER_CMD_STATS,
+			sizeof(struct ctrl_cmd_named_stats));
+
+	os_get_reltime(&start);
 	os_memcpy(reply, "OK\n", 3);
 	reply_len = 3;
-
-	if (os_strcmp(buf, "PING") == 0) {
-		os_memcpy(reply, "PONG\n", 5);
-		reply_len = 5;
-	} else if (os_strcmp(buf, "IFNAME") == 0) {
-		reply_len = os_strlen(wpa_s->ifname);
-		os_memcpy(reply, wpa_s->ifname, reply_len);
-	} else if (os_strncmp(buf, "RELOG", 5) == 0) {
-		if (wpa_debug_reopen_file() < 0)
+	stats = NULL;
+
+	cmd = ctrl_cmd_find(wpas_ctrl_cmds, ARRAY_SIZE(wpas_ctrl_cmds),
+			    sizeof(wpas_ctrl_cmds[0]), buf, &params);
+	if (cmd && !ctrl_cmd_accepts(cmd->flags, params))
+		cmd = NULL;
+	if (cmd == NULL) {
+		/* Handlers may modify buf; do not record response values */
+		os_strlcpy(name, os_strncmp(buf, WPA_CTRL_RSP,
+					    os_strlen(WPA_CTRL_RSP)) == 0 ?
+			   WPA_CTRL_RSP : buf, sizeof(name));
+	}
+
+	if (cmd) {
+		int res;
+
+		if (wpa_s->ctrl_cmd_stats)
+			stats = &wpa_s->ctrl_cmd_stats[cmd - wpas_ctrl_cmds];
+		res = cmd->handler(wpa_s, params, reply, reply_size);
+		/* As in the comparisons below, any nonzero status is FAIL */
+		if (!(cmd->flags & CTRL_CMD_STATUS))
+			reply_len = res;
+		else if (res)
 			reply_len = -1;
-	} else if (os_strncmp(buf, "NOTE ", 5) == 0) {
-		wpa_printf(MSG_INFO, "NOTE: %s", buf + 5);
-	} else if (os_strcmp(buf, "MIB") == 0) {
-		reply_len = wpa_sm_get_mib(wpa_s->wpa, reply, reply_size);
-		if (reply_len >= 0) {
-			reply_len += eapol_sm_get_mib(wpa_s->eapol,
-						      reply + reply_len,
-						      reply_size - reply_len);
-		}
 	} else if (os_strncmp(buf, "STATUS", 6) == 0) {
 		reply_len = wpa_supplicant_ctrl_iface_status(
 			wpa_s, buf + 6, reply, reply_size);
-	} else if (os_strcmp(buf, "PMKSA") == 0) {
-		reply_len = wpa_sm_pmksa_cache_list(wpa_s->wpa, reply,
-						    reply_size);
-	} else if (os_strcmp(buf, "PMKSA_FLUSH") == 0) {
-		wpa_sm_pmksa_cache_flush(wpa_s->wpa, NULL);
-	} else if (os_strncmp(buf, "SET ", 4) == 0) {
-		if (wpa_supplicant_ctrl_iface_set(wpa_s, buf + 4))
-			reply_len = -1;
 	} else if (os_strncmp(buf, "DUMP", 4) == 0) {
 		reply_len = wpa_config_dump_values(wpa_s->conf,
 						   reply, reply_size);
-	} else if (os_strncmp(buf, "GET ", 4) == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_get(wpa_s, buf + 4,
-							  reply, reply_size);
-	} else if (os_strcmp(buf, "LOGON") == 0) {
-		eapol_sm_notify_logoff(wpa_s->eapol, FALSE);
-	} else if (os_strcmp(buf, "LOGOFF") == 0) {
-		eapol_sm_notify_logoff(wpa_s->eapol, TRUE);
-	} else if (os_strcmp(buf, "REASSOCIATE") == 0) {
-		if (wpa_s->wpa_state == WPA_INTERFACE_DISABLED)
-			reply_len = -1;
-		else
-			wpas_request_connection(wpa_s);
-	} else if (os_strcmp(buf, "REATTACH") == 0) {
-		if (wpa_s->wpa_state == WPA_INTERFACE_DISABLED ||
-		    !wpa_s->current_ssid)
-			reply_len = -1;
-		else {
-			wpa_s->reattach = 1;
-			wpas_request_connection(wpa_s);
-		}
-	} else if (os_strcmp(buf, "RECONNECT") == 0) {
-		if (wpa_s->wpa_state == WPA_INTERFACE_DISABLED)
-			reply_len = -1;
-		else if (wpa_s->disconnected)
-			wpas_request_connection(wpa_s);
-#ifdef IEEE8021X_EAPOL
-	} else if (os_strncmp(buf, "PREAUTH ", 8) == 0) {
-		if (wpa_supplicant_ctrl_iface_preauth(wpa_s, buf + 8))
-			reply_len = -1;
-#endif /* IEEE8021X_EAPOL */
 #ifdef CONFIG_PEERKEY
 	} else if (os_strncmp(buf, "STKSTART ", 9) == 0) {
 		if (wpa_supplicant_ctrl_iface_stkstart(wpa_s, buf + 9))
 			reply_len = -1;
 #endif /* CONFIG_PEERKEY */
-#ifdef CONFIG_IEEE80211R
-	} else if (os_strncmp(buf, "FT_DS ", 6) == 0) {
-		if (wpa_supplicant_ctrl_iface_ft_ds(wpa_s, buf + 6))
-			reply_len = -1;
-#endif /* CONFIG_IEEE80211R */
 #ifdef CONFIG_WPS
 	} else if (os_strcmp(buf, "WPS_PBC") == 0) {
 		int res = wpa_supplicant_ctrl_iface_wps_pbc(wpa_s, NULL);
@@ -8476,152 +9267,16 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 			eloop_register_timeout(0, 0, wpas_ctrl_eapol_response,
 					       wpa_s, NULL);
 		}
-	} else if (os_strcmp(buf, "RECONFIGURE") == 0) {
-		if (wpa_supplicant_reload_configuration(wpa_s))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "TERMINATE") == 0) {
-		wpa_supplicant_terminate_proc(wpa_s->global);
-	} else if (os_strncmp(buf, "BSSID ", 6) == 0) {
-		if (wpa_supplicant_ctrl_iface_bssid(wpa_s, buf + 6))
-			reply_len = -1;
 	} else if (os_strncmp(buf, "BLACKLIST", 9) == 0) {
 		reply_len = wpa_supplicant_ctrl_iface_blacklist(
 			wpa_s, buf + 9, reply, reply_size);
 	} else if (os_strncmp(buf, "LOG_LEVEL", 9) == 0) {
 		reply_len = wpa_supplicant_ctrl_iface_log_level(
 			wpa_s, buf + 9, reply, reply_size);
-	} else if (os_strncmp(buf, "LIST_NETWORKS ", 14) == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_list_networks(
-			wpa_s, buf + 14, reply, reply_size);
-	} else if (os_strcmp(buf, "LIST_NETWORKS") == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_list_networks(
-			wpa_s, NULL, reply, reply_size);
-	} else if (os_strcmp(buf, "DISCONNECT") == 0) {
-#ifdef CONFIG_SME
-		wpa_s->sme.prev_bssid_set = 0;
-#endif /* CONFIG_SME */
-		wpa_s->reassociate = 0;
-		wpa_s->disconnected = 1;
-		wpa_supplicant_cancel_sched_scan(wpa_s);
-		wpa_supplicant_cancel_scan(wpa_s);
-		wpa_supplicant_deauthenticate(wpa_s,
-					      WLAN_REASON_DEAUTH_LEAVING);
-		eloop_cancel_timeout(wpas_network_reenabled, wpa_s, NULL);
-	} else if (os_strcmp(buf, "SCAN") == 0) {
-		wpas_ctrl_scan(wpa_s, NULL, reply, reply_size, &reply_len);
-	} else if (os_strncmp(buf, "SCAN ", 5) == 0) {
-		wpas_ctrl_scan(wpa_s, buf + 5, reply, reply_size, &reply_len);
-	} else if (os_strcmp(buf, "SCAN_RESULTS") == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_scan_results(
-			wpa_s, reply, reply_size);
-	} else if (os_strncmp(buf, "SELECT_NETWORK ", 15) == 0) {
-		if (wpa_supplicant_ctrl_iface_select_network(wpa_s, buf + 15))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "ENABLE_NETWORK ", 15) == 0) {
-		if (wpa_supplicant_ctrl_iface_enable_network(wpa_s, buf + 15))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "DISABLE_NETWORK ", 16) == 0) {
-		if (wpa_supplicant_ctrl_iface_disable_network(wpa_s, buf + 16))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "ADD_NETWORK") == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_add_network(
-			wpa_s, reply, reply_size);
-	} else if (os_strncmp(buf, "REMOVE_NETWORK ", 15) == 0) {
-		if (wpa_supplicant_ctrl_iface_remove_network(wpa_s, buf + 15))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "SET_NETWORK ", 12) == 0) {
-		if (wpa_supplicant_ctrl_iface_set_network(wpa_s, buf + 12))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "GET_NETWORK ", 12) == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_get_network(
-			wpa_s, buf + 12, reply, reply_size);
-	} else if (os_strncmp(buf, "DUP_NETWORK ", 12) == 0) {
-		if (wpa_supplicant_ctrl_iface_dup_network(wpa_s, buf + 12,
-							  wpa_s))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "LIST_CREDS") == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_list_creds(
-			wpa_s, reply, reply_size);
-	} else if (os_strcmp(buf, "ADD_CRED") == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_add_cred(
-			wpa_s, reply, reply_size);
-	} else if (os_strncmp(buf, "REMOVE_CRED ", 12) == 0) {
-		if (wpa_supplicant_ctrl_iface_remove_cred(wpa_s, buf + 12))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "SET_CRED ", 9) == 0) {
-		if (wpa_supplicant_ctrl_iface_set_cred(wpa_s, buf + 9))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "GET_CRED ", 9) == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_get_cred(wpa_s, buf + 9,
-							       reply,
-							       reply_size);
-#ifndef CONFIG_NO_CONFIG_WRITE
-	} else if (os_strcmp(buf, "SAVE_CONFIG") == 0) {
-		if (wpa_supplicant_ctrl_iface_save_config(wpa_s))
-			reply_len = -1;
-#endif /* CONFIG_NO_CONFIG_WRITE */
-	} else if (os_strncmp(buf, "GET_CAPABILITY ", 15) == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_get_capability(
-			wpa_s, buf + 15, reply, reply_size);
-	} else if (os_strncmp(buf, "AP_SCAN ", 8) == 0) {
-		if (wpa_supplicant_ctrl_iface_ap_scan(wpa_s, buf + 8))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "SCAN_INTERVAL ", 14) == 0) {
-		if (wpa_supplicant_ctrl_iface_scan_interval(wpa_s, buf + 14))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "INTERFACE_LIST") == 0) {
-		reply_len = wpa_supplicant_global_iface_list(
-			wpa_s->global, reply, reply_size);
-	} else if (os_strcmp(buf, "INTERFACES") == 0) {
-		reply_len = wpa_supplicant_global_iface_interfaces(
-			wpa_s->global, reply, reply_size);
-	} else if (os_strncmp(buf, "BSS ", 4) == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_bss(
-			wpa_s, buf + 4, reply, reply_size);
-#ifdef CONFIG_AP
-	} else if (os_strcmp(buf, "STA-FIRST") == 0) {
-		reply_len = ap_ctrl_iface_sta_first(wpa_s, reply, reply_size);
-	} else if (os_strncmp(buf, "STA ", 4) == 0) {
-		reply_len = ap_ctrl_iface_sta(wpa_s, buf + 4, reply,
-					      reply_size);
-	} else if (os_strncmp(buf, "STA-NEXT ", 9) == 0) {
-		reply_len = ap_ctrl_iface_sta_next(wpa_s, buf + 9, reply,
-						   reply_size);
-	} else if (os_strncmp(buf, "DEAUTHENTICATE ", 15) == 0) {
-		if (ap_ctrl_iface_sta_deauthenticate(wpa_s, buf + 15))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "DISASSOCIATE ", 13) == 0) {
-		if (ap_ctrl_iface_sta_disassociate(wpa_s, buf + 13))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "CHAN_SWITCH ", 12) == 0) {
-		if (ap_ctrl_iface_chanswitch(wpa_s, buf + 12))
-			reply_len = -1;
-	} else if (os_strcmp(buf, "STOP_AP") == 0) {
-		if (wpas_ap_stop_ap(wpa_s))
-			reply_len = -1;
-#endif /* CONFIG_AP */
-	} else if (os_strcmp(buf, "SUSPEND") == 0) {
-		wpas_notify_suspend(wpa_s->global);
-	} else if (os_strcmp(buf, "RESUME") == 0) {
-		wpas_notify_resume(wpa_s->global);
 #ifdef CONFIG_TESTING_OPTIONS
 	} else if (os_strcmp(buf, "DROP_SA") == 0) {
 		wpa_supplicant_ctrl_iface_drop_sa(wpa_s);
 #endif /* CONFIG_TESTING_OPTIONS */
-	} else if (os_strncmp(buf, "ROAM ", 5) == 0) {
-		if (wpa_supplicant_ctrl_iface_roam(wpa_s, buf + 5))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "STA_AUTOCONNECT ", 16) == 0) {
-		wpa_s->auto_reconnect_disabled = atoi(buf + 16) == 0;
-	} else if (os_strncmp(buf, "BSS_EXPIRE_AGE ", 15) == 0) {
-		if (wpa_supplicant_ctrl_iface_bss_expire_age(wpa_s, buf + 15))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "BSS_EXPIRE_COUNT ", 17) == 0) {
-		if (wpa_supplicant_ctrl_iface_bss_expire_count(wpa_s,
-							       buf + 17))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "BSS_FLUSH ", 10) == 0) {
-		wpa_supplicant_ctrl_iface_bss_flush(wpa_s, buf + 10);
 #ifdef CONFIG_TDLS
 	} else if (os_strncmp(buf, "TDLS_DISCOVER ", 14) == 0) {
 		if (wpa_supplicant_ctrl_iface_tdls_discover(wpa_s, buf + 14))
@@ -8644,20 +9299,6 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		reply_len = wpa_supplicant_ctrl_iface_tdls_link_status(
 			wpa_s, buf + 17, reply, reply_size);
 #endif /* CONFIG_TDLS */
-	} else if (os_strcmp(buf, "WMM_AC_STATUS") == 0) {
-		reply_len = wpas_wmm_ac_status(wpa_s, reply, reply_size);
-	} else if (os_strncmp(buf, "WMM_AC_ADDTS ", 13) == 0) {
-		if (wmm_ac_ctrl_addts(wpa_s, buf + 13))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "WMM_AC_DELTS ", 13) == 0) {
-		if (wmm_ac_ctrl_delts(wpa_s, buf + 13))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "SIGNAL_POLL", 11) == 0) {
-		reply_len = wpa_supplicant_signal_poll(wpa_s, reply,
-						       reply_size);
-	} else if (os_strncmp(buf, "PKTCNT_POLL", 11) == 0) {
-		reply_len = wpa_supplicant_pktcnt_poll(wpa_s, reply,
-						       reply_size);
 #ifdef CONFIG_AUTOSCAN
 	} else if (os_strncmp(buf, "AUTOSCAN ", 9) == 0) {
 		if (wpa_supplicant_ctrl_iface_autoscan(wpa_s, buf + 9))
@@ -8668,12 +9309,6 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		reply_len = wpa_supplicant_driver_cmd(wpa_s, buf + 7, reply,
 						      reply_size);
 #endif /* ANDROID */
-	} else if (os_strncmp(buf, "VENDOR ", 7) == 0) {
-		reply_len = wpa_supplicant_vendor_cmd(wpa_s, buf + 7, reply,
-						      reply_size);
-	} else if (os_strcmp(buf, "REAUTHENTICATE") == 0) {
-		pmksa_cache_clear_current(wpa_s->wpa);
-		eapol_sm_request_reauth(wpa_s->eapol);
 #ifdef CONFIG_WNM
 	} else if (os_strncmp(buf, "WNM_SLEEP ", 10) == 0) {
 		if (wpas_ctrl_iface_wnm_sleep(wpa_s, buf + 10))
@@ -8682,11 +9317,6 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		if (wpas_ctrl_iface_wnm_bss_query(wpa_s, buf + 14))
 				reply_len = -1;
 #endif /* CONFIG_WNM */
-	} else if (os_strcmp(buf, "FLUSH") == 0) {
-		wpa_supplicant_ctrl_iface_flush(wpa_s);
-	} else if (os_strncmp(buf, "RADIO_WORK ", 11) == 0) {
-		reply_len = wpas_ctrl_radio_work(wpa_s, buf + 11, reply,
-						 reply_size);
 #ifdef CONFIG_TESTING_OPTIONS
 	} else if (os_strncmp(buf, "MGMT_TX ", 8) == 0) {
 		if (wpas_ctrl_iface_mgmt_tx(wpa_s, buf + 8) < 0)
@@ -8719,31 +9349,23 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	} else if (os_strcmp(buf, "GET_FAIL") == 0) {
 		reply_len = wpas_ctrl_get_fail(wpa_s, reply, reply_size);
 #endif /* CONFIG_TESTING_OPTIONS */
-	} else if (os_strncmp(buf, "VENDOR_ELEM_ADD ", 16) == 0) {
-		if (wpas_ctrl_vendor_elem_add(wpa_s, buf + 16) < 0)
-			reply_len = -1;
-	} else if (os_strncmp(buf, "VENDOR_ELEM_GET ", 16) == 0) {
-		reply_len = wpas_ctrl_vendor_elem_get(wpa_s, buf + 16, reply,
-						      reply_size);
-	} else if (os_strncmp(buf, "VENDOR_ELEM_REMOVE ", 19) == 0) {
-		if (wpas_ctrl_vendor_elem_remove(wpa_s, buf + 19) < 0)
-			reply_len = -1;
 	} else if (os_strncmp(buf, "NEIGHBOR_REP_REQUEST", 20) == 0) {
 		if (wpas_ctrl_iface_send_neigbor_rep(wpa_s, buf + 20))
 			reply_len = -1;
-	} else if (os_strcmp(buf, "ERP_FLUSH") == 0) {
-		wpas_ctrl_iface_erp_flush(wpa_s);
-	} else if (os_strncmp(buf, "MAC_RAND_SCAN ", 14) == 0) {
-		if (wpas_ctrl_iface_mac_rand_scan(wpa_s, buf + 14))
-			reply_len = -1;
-	} else if (os_strncmp(buf, "GET_PREF_FREQ_LIST ", 19) == 0) {
-		reply_len = wpas_ctrl_iface_get_pref_freq_list(
-			wpa_s, buf + 19, reply, reply_size);
 	} else {
 		os_memcpy(reply, "UNKNOWN COMMAND\n", 16);
 		reply_len = 16;
+		if (wpa_s->ctrl_cmd_stats)
+			stats = &wpa_s->ctrl_cmd_stats[WPAS_CTRL_UNKNOWN_CMD];
 	}
 
+	if (stats == NULL && cmd == NULL && wpa_s->ctrl_other_cmd_stats)
+		stats = ctrl_cmd_named_stats_get(wpa_s->ctrl_other_cmd_stats,
+						 WPAS_CTRL_OTHER_CMD_STATS,
+						 name);
+	if (stats)
+		ctrl_cmd_stats_update(stats, &start, reply_len < 0);
+
 	if (reply_len < 0) {
 		os_memcpy(reply, "FAIL\n", 5);
 		reply_len = 5;
@@ -7704,6 +7704,7 @@ static void wpas_p2p_remove_client_go(struct wpa_supplicant *wpa_s,
 			psk = psk->next;
 		}
 	}
+	hostapd_wpa_psk_index_free(&hapd->conf->ssid);
 
 	/* Disconnect from group */
 	if (iface_addr)
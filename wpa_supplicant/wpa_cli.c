@@ -532,6 +532,13 @@ static int wpa_cli_cmd_relog(struct wpa_ctrl *ctrl, int argc, char *argv[])
 }
 
 
+static int wpa_cli_cmd_cmd_stats(struct wpa_ctrl *ctrl, int argc,
+				 char *argv[])
+{
+	return wpa_cli_cmd(ctrl, "CMD_STATS", 0, argc, argv);
+}
+
+
 static int wpa_cli_cmd_note(struct wpa_ctrl *ctrl, int argc, char *argv[])
 {
 	return wpa_cli_cmd(ctrl, "NOTE", 1, argc, argv);
@@ -2849,6 +2856,9 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	{ "relog", wpa_cli_cmd_relog, NULL,
 	  cli_cmd_flag_none,
 	  "= re-open log-file (allow rolling logs)" },
+	{ "cmd_stats", wpa_cli_cmd_cmd_stats, NULL,
+	  cli_cmd_flag_none,
+	  "[RESET] = show or reset control interface command statistics" },
 	{ "note", wpa_cli_cmd_note, NULL,
 	  cli_cmd_flag_none,
 	  "<text> = add a note to wpa_supplicant debug log" },
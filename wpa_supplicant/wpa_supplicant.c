@@ -35,6 +35,8 @@
 #include "common/wpa_ctrl.h"
 #include "common/ieee802_11_defs.h"
 #include "common/hw_features_common.h"
+#include "ap/psk_derive.h"
+#include "ap/sae_async.h"
 #include "p2p/p2p.h"
 #include "fst/fst.h"
 #include "blacklist.h"
@@ -4614,6 +4616,10 @@ static void wpa_supplicant_deinit_iface(struct wpa_supplicant *wpa_s,
 		wpa_supplicant_ctrl_iface_deinit(wpa_s->ctrl_iface);
 		wpa_s->ctrl_iface = NULL;
 	}
+	os_free(wpa_s->ctrl_cmd_stats);
+	wpa_s->ctrl_cmd_stats = NULL;
+	os_free(wpa_s->ctrl_other_cmd_stats);
+	wpa_s->ctrl_other_cmd_stats = NULL;
 
 #ifdef CONFIG_MESH
 	if (wpa_s->ifmsh) {
@@ -5059,6 +5065,10 @@ void wpa_supplicant_deinit(struct wpa_global *global)
 	eap_peer_unregister_methods();
 #ifdef CONFIG_AP
 	eap_server_unregister_methods();
+	psk_derive_deinit();
+#ifdef CONFIG_SAE
+	sae_async_deinit();
+#endif /* CONFIG_SAE */
 #endif /* CONFIG_AP */
 
 	for (i = 0; wpa_drivers[i] && global->drv_priv; i++) {
@@ -540,6 +540,9 @@ struct wpa_supplicant {
 	struct eapol_sm *eapol;
 
 	struct ctrl_iface_priv *ctrl_iface;
+	/* Control interface command statistics (CMD_STATS) */
+	struct ctrl_cmd_stats *ctrl_cmd_stats;
+	struct ctrl_cmd_named_stats *ctrl_other_cmd_stats;
 
 	enum wpa_states wpa_state;
 	struct wpa_radio_work *scan_work;